@@ -143,6 +143,8 @@ class CyxChatBindings {
       final result = _native.cyxchat_create(ctxPtr, onion, localId);
       if (result == 0) {
         _chatCtx = ctxPtr.value;
+        // connPoll() already polls the shared onion context
+        _native.cyxchat_set_onion_polling(_chatCtx!, 0);
       }
       return result;
     } finally {
@@ -2101,6 +2103,10 @@ class CyxChatNative {
       Void Function(Pointer<Void>, Pointer<Void>),
       void Function(Pointer<Void>, Pointer<Void>)>('cyxchat_set_file_ctx');
 
+  late final cyxchat_set_onion_polling = _lib.lookupFunction<
+      Void Function(Pointer<Void>, Int32),
+      void Function(Pointer<Void>, int)>('cyxchat_set_onion_polling');
+
   late final cyxchat_file_poll = _lib.lookupFunction<
       Int32 Function(Pointer<Void>, Uint64),
       int Function(Pointer<Void>, int)>('cyxchat_file_poll');
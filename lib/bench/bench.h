@@ -0,0 +1,48 @@
+/**
+ * CyxChat Benchmarks - Shared Harness
+ *
+ * Latency samples are kept whole and sorted at report time, so the
+ * p50/p99/p999 figures are exact rather than bucketed. Every result is
+ * one JSON object in the "results" array printed by bench_main.c.
+ */
+
+#ifndef CYXCHAT_BENCH_H
+#define CYXCHAT_BENCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Operations timed together per sample for sub-microsecond work */
+#define BENCH_BATCH     64
+
+typedef struct {
+    uint64_t *samples;                  /* Nanoseconds per operation */
+    size_t count;
+    size_t cap;
+} bench_hist_t;
+
+/* Monotonic clock in nanoseconds */
+uint64_t bench_now_ns(void);
+
+/* Allocate room for cap samples; returns 0 on success */
+int bench_hist_init(bench_hist_t *h, size_t cap);
+void bench_hist_free(bench_hist_t *h);
+
+/* Record one sample (dropped once the histogram is full) */
+void bench_hist_record(bench_hist_t *h, uint64_t ns);
+
+/*
+ * Print one result: latency percentiles of the samples, plus ops/s and
+ * MB/s over elapsed_ns when those are non-zero.
+ */
+void bench_report(const char *name, bench_hist_t *h, uint64_t ops,
+                  uint64_t bytes, uint64_t elapsed_ns);
+
+/* Print a result that could not be measured */
+void bench_report_error(const char *name, const char *reason);
+
+/* Benchmark groups */
+int bench_micro(void);
+int bench_e2e(void);
+
+#endif /* CYXCHAT_BENCH_H */
@@ -0,0 +1,400 @@
+/**
+ * CyxChat Benchmark - End-to-End Scenarios
+ *
+ * Two full runtimes (connection, onion, chat, file, DNS) exchange
+ * traffic over a perfect loopback network, so the figures are the
+ * library's own cost: serialisation, encryption, fragmentation and
+ * reassembly, chunk tracking and DNS caching, with no link delay.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/runtime.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#include "bench.h"
+
+#define E2E_WARMUP_MS       10000   /* Key exchange deadline */
+#define E2E_WAIT_MS         2000    /* Per-operation deadline */
+#define E2E_TEXT_ROUNDS     1000
+#define E2E_FRAG_ROUNDS     200
+#define E2E_FRAG_LEN        2000    /* Several fragments per message */
+#define E2E_BURST_MSGS      2000
+#define E2E_BURST_WINDOW    32      /* Messages in flight */
+#define E2E_FILE_ROUNDS     5
+#define E2E_FILE_LEN        (64 * 1024)
+#define E2E_DNS_ROUNDS      100
+#define E2E_DNS_NAME        "benchnode"
+
+typedef struct {
+    cyxchat_loopnet_t *net;
+    cyxchat_runtime_t *rt[2];
+    cyxwiz_node_id_t id[2];
+    uint64_t messages[2];           /* MESSAGE events taken per side */
+    int file_done;
+    int dns_registered;
+    int dns_answered;
+} e2e_pair_t;
+
+static volatile uint64_t g_sink;
+
+/* ============================================================
+ * Harness
+ * ============================================================ */
+
+static void make_signing_key(uint8_t key[64])
+{
+#ifdef CYXWIZ_HAS_CRYPTO
+    uint8_t pk[32];
+    crypto_sign_keypair(pk, key);
+#else
+    memset(key, 0x5C, 64);
+#endif
+}
+
+/* One cycle on each node, then drain their events */
+static void pump(e2e_pair_t *p)
+{
+    uint64_t now = cyxchat_timestamp_ms();
+    cyxchat_runtime_event_t ev;
+
+    for (int i = 0; i < 2; i++) {
+        cyxchat_runtime_poll(p->rt[i], now);
+        while (cyxchat_runtime_next_event(p->rt[i], &ev)) {
+            if (ev.type == CYXCHAT_RUNTIME_EVENT_MESSAGE) {
+                p->messages[i]++;
+            }
+        }
+    }
+}
+
+/* Pump until node `side` has taken `target` messages; 0 on success */
+static int wait_messages(e2e_pair_t *p, int side, uint64_t target, uint32_t timeout_ms)
+{
+    uint64_t deadline = cyxchat_timestamp_ms() + timeout_ms;
+
+    while (p->messages[side] < target) {
+        if (cyxchat_timestamp_ms() > deadline) return -1;
+        pump(p);
+    }
+    return 0;
+}
+
+static int wait_flag(e2e_pair_t *p, const int *flag, uint32_t timeout_ms)
+{
+    uint64_t deadline = cyxchat_timestamp_ms() + timeout_ms;
+
+    while (!*flag) {
+        if (cyxchat_timestamp_ms() > deadline) return -1;
+        pump(p);
+    }
+    return 0;
+}
+
+static void pair_destroy(e2e_pair_t *p)
+{
+    cyxchat_runtime_destroy(p->rt[0]);
+    cyxchat_runtime_destroy(p->rt[1]);
+    cyxchat_loopnet_destroy(p->net);
+}
+
+/* Two nodes, connected, with keys exchanged end to end */
+static int pair_create(e2e_pair_t *p)
+{
+    uint8_t key[2][64];
+
+    memset(p, 0, sizeof(*p));
+    if (cyxchat_loopnet_create(&p->net, 1) != CYXCHAT_OK) return -1;
+
+    for (int i = 0; i < 2; i++) {
+        memset(&p->id[i], 0x10 + i, sizeof(p->id[i]));
+        make_signing_key(key[i]);
+        if (cyxchat_runtime_create_loopback(&p->rt[i], p->net, &p->id[i], key[i]) != CYXCHAT_OK) {
+            return -1;
+        }
+    }
+
+    cyxchat_runtime_connect(p->rt[0], &p->id[1], 0);
+    cyxchat_runtime_connect(p->rt[1], &p->id[0], 0);
+
+    /* Resend until one gets through: the first land before the announce does */
+    uint64_t deadline = cyxchat_timestamp_ms() + E2E_WARMUP_MS;
+    while (p->messages[1] == 0) {
+        if (cyxchat_timestamp_ms() > deadline) return -1;
+        cyxchat_runtime_send_text(p->rt[0], &p->id[1], "warmup", 6, NULL, 0);
+        uint64_t next = cyxchat_timestamp_ms() + 100;
+        while (p->messages[1] == 0 && cyxchat_timestamp_ms() < next) {
+            pump(p);
+        }
+    }
+
+    /* Let stragglers arrive so they are not counted later */
+    uint64_t settle = cyxchat_timestamp_ms() + 200;
+    while (cyxchat_timestamp_ms() < settle) {
+        pump(p);
+    }
+    return 0;
+}
+
+/* ============================================================
+ * Chat
+ * ============================================================ */
+
+/* One message in flight at a time: send-to-delivery latency */
+static int run_text_latency(e2e_pair_t *p, const char *name, size_t len, int rounds)
+{
+    char *text = malloc(len);
+    bench_hist_t h;
+    int lost = 0;
+
+    if (!text || bench_hist_init(&h, (size_t)rounds) != 0) {
+        free(text);
+        return 1;
+    }
+    memset(text, 'x', len);
+
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < rounds; r++) {
+        uint64_t target = p->messages[1] + 1;
+
+        uint64_t t0 = bench_now_ns();
+        cyxchat_runtime_send_text(p->rt[0], &p->id[1], text, len, NULL, 0);
+        if (wait_messages(p, 1, target, E2E_WAIT_MS) != 0) {
+            lost++;
+            p->messages[1] = target;
+            continue;
+        }
+        bench_hist_record(&h, bench_now_ns() - t0);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if (lost > rounds / 10) {
+        bench_report_error(name, "messages lost");
+    } else {
+        bench_report(name, &h, h.count, h.count * len, elapsed);
+    }
+
+    bench_hist_free(&h);
+    free(text);
+    return lost > rounds / 10;
+}
+
+/* Pipelined burst: delivered messages per second */
+static int run_text_burst(e2e_pair_t *p)
+{
+    static const char text[] = "burst message with a typical chat length";
+    bench_hist_t h;
+    uint64_t base = p->messages[1];
+    uint64_t sent = 0;
+
+    if (bench_hist_init(&h, E2E_BURST_MSGS / E2E_BURST_WINDOW + 1) != 0) return 1;
+
+    uint64_t start = bench_now_ns();
+    while (sent < E2E_BURST_MSGS) {
+        uint64_t t0 = bench_now_ns();
+        uint64_t window = 0;
+
+        while (window < E2E_BURST_WINDOW && sent < E2E_BURST_MSGS) {
+            if (cyxchat_runtime_send_text(p->rt[0], &p->id[1], text, sizeof(text) - 1,
+                                          NULL, 0) != CYXCHAT_OK) {
+                pump(p);
+                continue;
+            }
+            window++;
+            sent++;
+        }
+        if (wait_messages(p, 1, base + sent, E2E_WAIT_MS) != 0) break;
+
+        /* Per-message cost within the window */
+        bench_hist_record(&h, (bench_now_ns() - t0) / window);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    uint64_t got = p->messages[1] - base;
+
+    if (got < sent) {
+        bench_report_error("e2e.text_burst", "messages lost");
+    } else {
+        bench_report("e2e.text_burst", &h, got, got * (sizeof(text) - 1), elapsed);
+    }
+
+    bench_hist_free(&h);
+    return got < sent;
+}
+
+/* ============================================================
+ * File Transfer
+ * ============================================================ */
+
+static void on_file_request(cyxchat_file_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                            const cyxchat_file_meta_t *meta, void *user_data)
+{
+    (void)from;
+    (void)user_data;
+    cyxchat_file_accept(ctx, &meta->file_id);
+}
+
+static void on_file_complete(cyxchat_file_ctx_t *ctx, const cyxchat_file_id_t *file_id,
+                             const uint8_t *data, size_t data_len, void *user_data)
+{
+    (void)ctx;
+    (void)file_id;
+    (void)data;
+    e2e_pair_t *p = (e2e_pair_t*)user_data;
+    g_sink += data_len;
+    p->file_done = 1;
+}
+
+static int run_file_transfer(e2e_pair_t *p)
+{
+    cyxchat_file_ctx_t *sender = cyxchat_runtime_get_file(p->rt[0]);
+    cyxchat_file_ctx_t *receiver = cyxchat_runtime_get_file(p->rt[1]);
+    uint8_t *data = malloc(E2E_FILE_LEN);
+    bench_hist_t h;
+    int failed = 0;
+
+    if (!data || bench_hist_init(&h, E2E_FILE_ROUNDS) != 0) {
+        free(data);
+        return 1;
+    }
+    for (size_t i = 0; i < E2E_FILE_LEN; i++) {
+        data[i] = (uint8_t)(i * 31);
+    }
+
+    cyxchat_file_set_on_request(receiver, on_file_request, p);
+    cyxchat_file_set_on_complete(receiver, on_file_complete, p);
+
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < E2E_FILE_ROUNDS; r++) {
+        cyxchat_file_id_t file_id;
+        p->file_done = 0;
+
+        uint64_t t0 = bench_now_ns();
+        if (cyxchat_file_send(sender, &p->id[1], "bench.bin", "application/octet-stream",
+                              data, E2E_FILE_LEN, &file_id) != CYXCHAT_OK ||
+            wait_flag(p, &p->file_done, 60000) != 0) {
+            failed = 1;
+            break;
+        }
+        bench_hist_record(&h, bench_now_ns() - t0);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    if (failed) {
+        bench_report_error("e2e.file_transfer", "transfer did not complete");
+    } else {
+        bench_report("e2e.file_transfer", &h, h.count, h.count * E2E_FILE_LEN, elapsed);
+    }
+
+    cyxchat_file_set_on_request(receiver, NULL, NULL);
+    cyxchat_file_set_on_complete(receiver, NULL, NULL);
+    bench_hist_free(&h);
+    free(data);
+    return failed;
+}
+
+/* ============================================================
+ * DNS
+ * ============================================================ */
+
+static void on_dns_registered(void *user_data, const char *name, int success)
+{
+    (void)name;
+    e2e_pair_t *p = (e2e_pair_t*)user_data;
+    p->dns_registered = success ? 1 : -1;
+}
+
+static void on_dns_answer(void *user_data, const char *name,
+                          const cyxchat_dns_record_t *record)
+{
+    (void)name;
+    e2e_pair_t *p = (e2e_pair_t*)user_data;
+    p->dns_answered = record ? 1 : -1;
+}
+
+static int run_dns(e2e_pair_t *p)
+{
+    cyxchat_dns_ctx_t *owner = cyxchat_runtime_get_dns(p->rt[0]);
+    cyxchat_dns_ctx_t *asker = cyxchat_runtime_get_dns(p->rt[1]);
+    cyxchat_dns_record_t record;
+    bench_hist_t h;
+    int failed = 0;
+
+    if (cyxchat_dns_register(owner, E2E_DNS_NAME, on_dns_registered, p) != CYXCHAT_OK ||
+        wait_flag(p, &p->dns_registered, E2E_WAIT_MS * 5) != 0 || p->dns_registered < 0) {
+        bench_report_error("e2e.dns_lookup", "registration failed");
+        bench_report_error("dns.cache_hit", "registration failed");
+        return 1;
+    }
+
+    /* Network lookups: drop the cached record before each */
+    if (bench_hist_init(&h, E2E_DNS_ROUNDS) != 0) return 1;
+    uint64_t start = bench_now_ns();
+    for (int r = 0; r < E2E_DNS_ROUNDS; r++) {
+        cyxchat_dns_invalidate(asker, E2E_DNS_NAME);
+        p->dns_answered = 0;
+
+        uint64_t t0 = bench_now_ns();
+        if (cyxchat_dns_lookup(asker, E2E_DNS_NAME, on_dns_answer, p) != CYXCHAT_OK ||
+            wait_flag(p, &p->dns_answered, E2E_WAIT_MS) != 0 || p->dns_answered < 0) {
+            failed = 1;
+            break;
+        }
+        bench_hist_record(&h, bench_now_ns() - t0);
+    }
+    if (failed) {
+        bench_report_error("e2e.dns_lookup", "lookup not answered");
+    } else {
+        bench_report("e2e.dns_lookup", &h, h.count, 0, bench_now_ns() - start);
+    }
+    bench_hist_free(&h);
+    if (failed) return 1;
+
+    /* The last lookup left the record cached */
+    if (bench_hist_init(&h, 4096) != 0) return 1;
+    start = bench_now_ns();
+    for (size_t s = 0; s < h.cap; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            g_sink += (uint64_t)cyxchat_dns_resolve(asker, E2E_DNS_NAME, &record);
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    bench_report("dns.cache_hit", &h, (uint64_t)h.count * BENCH_BATCH, 0,
+                 bench_now_ns() - start);
+    bench_hist_free(&h);
+    return 0;
+}
+
+/* ============================================================
+ * Group
+ * ============================================================ */
+
+int bench_e2e(void)
+{
+    e2e_pair_t *p = calloc(1, sizeof(e2e_pair_t));
+    int failed = 0;
+
+    if (!p) return 1;
+
+    if (pair_create(p) != 0) {
+        bench_report_error("e2e", "nodes did not exchange keys");
+        pair_destroy(p);
+        free(p);
+        return 1;
+    }
+
+    failed += run_text_latency(p, "e2e.text_latency", 64, E2E_TEXT_ROUNDS);
+    failed += run_text_latency(p, "e2e.text_fragmented", E2E_FRAG_LEN, E2E_FRAG_ROUNDS);
+    failed += run_text_burst(p);
+    failed += run_file_transfer(p);
+    failed += run_dns(p);
+
+    pair_destroy(p);
+    free(p);
+    return failed;
+}
@@ -0,0 +1,171 @@
+/**
+ * CyxChat Benchmark Suite - Main Entry Point
+ *
+ * Prints one JSON document on stdout. Compare two runs result by result
+ * to spot regressions between releases.
+ *
+ * Usage: bench_cyxchat [group]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+
+#include "bench.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Benchmark runner */
+typedef struct {
+    const char *name;
+    int (*func)(void);
+} bench_group_t;
+
+static bench_group_t groups[] = {
+    { "micro", bench_micro },
+    { "e2e",   bench_e2e },
+    { NULL, NULL }
+};
+
+static int g_results;
+
+/* ============================================================
+ * Harness
+ * ============================================================ */
+
+uint64_t bench_now_ns(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    return (uint64_t)((double)now.QuadPart * 1e9 / (double)freq.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+int bench_hist_init(bench_hist_t *h, size_t cap)
+{
+    h->samples = calloc(cap, sizeof(uint64_t));
+    h->count = 0;
+    h->cap = h->samples ? cap : 0;
+    return h->samples ? 0 : -1;
+}
+
+void bench_hist_free(bench_hist_t *h)
+{
+    free(h->samples);
+    memset(h, 0, sizeof(*h));
+}
+
+void bench_hist_record(bench_hist_t *h, uint64_t ns)
+{
+    if (h->count < h->cap) {
+        h->samples[h->count++] = ns;
+    }
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of sorted samples */
+static uint64_t percentile(const bench_hist_t *h, double q)
+{
+    if (h->count == 0) return 0;
+    size_t rank = (size_t)(q * (double)h->count + 0.999999);
+    if (rank == 0) rank = 1;
+    if (rank > h->count) rank = h->count;
+    return h->samples[rank - 1];
+}
+
+static void begin_result(const char *name)
+{
+    printf("%s\n    {\"name\": \"%s\"", g_results++ ? "," : "", name);
+}
+
+void bench_report(const char *name, bench_hist_t *h, uint64_t ops,
+                  uint64_t bytes, uint64_t elapsed_ns)
+{
+    uint64_t sum = 0;
+
+    qsort(h->samples, h->count, sizeof(uint64_t), cmp_u64);
+    for (size_t i = 0; i < h->count; i++) {
+        sum += h->samples[i];
+    }
+
+    begin_result(name);
+    printf(", \"samples\": %zu, \"mean_ns\": %llu", h->count,
+           (unsigned long long)(h->count ? sum / h->count : 0));
+    printf(", \"p50_ns\": %llu, \"p99_ns\": %llu, \"p999_ns\": %llu, \"max_ns\": %llu",
+           (unsigned long long)percentile(h, 0.50),
+           (unsigned long long)percentile(h, 0.99),
+           (unsigned long long)percentile(h, 0.999),
+           (unsigned long long)(h->count ? h->samples[h->count - 1] : 0));
+
+    if (elapsed_ns > 0) {
+        double secs = (double)elapsed_ns / 1e9;
+        if (ops > 0) {
+            printf(", \"ops\": %llu, \"ops_per_sec\": %.1f",
+                   (unsigned long long)ops, (double)ops / secs);
+        }
+        if (bytes > 0) {
+            printf(", \"bytes\": %llu, \"mb_per_sec\": %.3f",
+                   (unsigned long long)bytes, (double)bytes / secs / 1e6);
+        }
+    }
+    printf("}");
+    fflush(stdout);
+}
+
+void bench_report_error(const char *name, const char *reason)
+{
+    begin_result(name);
+    printf(", \"error\": \"%s\"}", reason);
+    fflush(stdout);
+}
+
+/* ============================================================
+ * Main
+ * ============================================================ */
+
+int main(int argc, char **argv)
+{
+    cyxchat_error_t err = cyxchat_init();
+    if (err != CYXCHAT_OK) {
+        fprintf(stderr, "FATAL: Failed to initialize: %s\n", cyxchat_error_string(err));
+        return 1;
+    }
+
+    const char *filter = argc > 1 ? argv[1] : NULL;
+    int failed = 0;
+
+    printf("{\n  \"suite\": \"cyxchat\",\n  \"version\": \"%s\",\n  \"results\": [",
+           cyxchat_version());
+
+    for (bench_group_t *g = groups; g->name; g++) {
+        if (filter && strcmp(filter, g->name) != 0) {
+            continue;
+        }
+        failed += g->func();
+    }
+
+    printf("\n  ]\n}\n");
+
+    cyxchat_shutdown();
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,368 @@
+/**
+ * CyxChat Benchmark - Microbenchmarks
+ *
+ * Single-module hot paths, timed BENCH_BATCH operations per sample so
+ * clock overhead stays out of the figures.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/dedup.h>
+#include <cyxchat/dns.h>
+#include <cyxchat/ice.h>
+#include <cyxchat/label.h>
+#include <cyxchat/mail.h>
+#include <cyxchat/runtime.h>
+#include <cyxchat/timer.h>
+
+#include "bench.h"
+
+#define MICRO_SAMPLES       4096
+#define MICRO_MAILBOX       256     /* Fills the mail store */
+#define MICRO_TIMERS        1024
+#define MICRO_LABEL_PAYLOAD 1024    /* Bytes carried per labelled packet */
+
+/* Keeps results live so the compiler cannot drop the work */
+static volatile uint64_t g_sink;
+
+/* ============================================================
+ * Codecs
+ * ============================================================ */
+
+static int bench_ice_codec(void)
+{
+    cyxchat_ice_candidate_t cands[CYXCHAT_ICE_MAX_CANDIDATES];
+    cyxchat_ice_candidate_t out[CYXCHAT_ICE_MAX_CANDIDATES];
+    uint8_t buf[1 + CYXCHAT_ICE_MAX_CANDIDATES * CYXCHAT_ICE_WIRE_SIZE];
+    bench_hist_t h;
+
+    for (size_t i = 0; i < CYXCHAT_ICE_MAX_CANDIDATES; i++) {
+        cands[i].type = (uint8_t)(i % 3);
+        cands[i].ip = 0x0A000001u + (uint32_t)i;
+        cands[i].port = (uint16_t)(4000 + i);
+    }
+
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) return 1;
+
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            size_t len = cyxchat_ice_encode(cands, CYXCHAT_ICE_MAX_CANDIDATES, buf, sizeof(buf));
+            g_sink += (uint64_t)cyxchat_ice_decode(buf, len, out, CYXCHAT_ICE_MAX_CANDIDATES);
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    uint64_t ops = (uint64_t)MICRO_SAMPLES * BENCH_BATCH;
+    bench_report("codec.ice_roundtrip", &h, ops, ops * sizeof(buf), bench_now_ns() - start);
+
+    bench_hist_free(&h);
+    return 0;
+}
+
+static int bench_msg_id_codec(void)
+{
+    cyxchat_msg_id_t id, back;
+    char hex[CYXCHAT_MSG_ID_SIZE * 2 + 1];
+    bench_hist_t h;
+
+    cyxchat_generate_msg_id(&id);
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) return 1;
+
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            cyxchat_msg_id_to_hex(&id, hex);
+            g_sink += (uint64_t)cyxchat_msg_id_from_hex(hex, &back);
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    uint64_t ops = (uint64_t)MICRO_SAMPLES * BENCH_BATCH;
+    bench_report("codec.msg_id_hex", &h, ops, 0, bench_now_ns() - start);
+
+    bench_hist_free(&h);
+    return 0;
+}
+
+/* ============================================================
+ * Duplicate Suppression
+ * ============================================================ */
+
+static int bench_dedup(void)
+{
+    cyxchat_dedup_ctx_t *dedup = NULL;
+    cyxwiz_node_id_t peers[8];
+    cyxchat_msg_id_t id;
+    bench_hist_t h;
+
+    if (cyxchat_dedup_create(&dedup) != CYXCHAT_OK) return 1;
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) {
+        cyxchat_dedup_destroy(dedup);
+        return 1;
+    }
+
+    for (size_t p = 0; p < 8; p++) {
+        memset(&peers[p], (int)(p + 1), sizeof(peers[p]));
+    }
+    memset(&id, 0, sizeof(id));
+
+    /* Fresh IDs from a handful of peers, each in fragments: the receive path */
+    uint64_t n = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++, n++) {
+            memcpy(id.bytes, &n, sizeof(id.bytes));
+            g_sink += (uint64_t)cyxchat_dedup_check(dedup, &peers[n % 8], &id,
+                                                    (uint8_t)(n & 3));
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    bench_report("dedup.check", &h, n, 0, bench_now_ns() - start);
+
+    bench_hist_free(&h);
+    cyxchat_dedup_destroy(dedup);
+    return 0;
+}
+
+/* ============================================================
+ * Timer Wheel
+ * ============================================================ */
+
+static void on_bench_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    (void)user_data;
+    g_sink += now_ms;
+}
+
+static int bench_timer_wheel(void)
+{
+    cyxchat_timer_wheel_t *wheel = NULL;
+    cyxchat_timer_t *timers = calloc(MICRO_TIMERS, sizeof(cyxchat_timer_t));
+    bench_hist_t h;
+
+    if (!timers || cyxchat_timer_wheel_create(&wheel, 0) != CYXCHAT_OK) {
+        free(timers);
+        return 1;
+    }
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) {
+        cyxchat_timer_wheel_destroy(wheel);
+        free(timers);
+        return 1;
+    }
+
+    /* Schedule then cancel, spread over the near and far levels */
+    uint64_t n = 0;
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++, n++) {
+            cyxchat_timer_t *t = &timers[(n * 7) % MICRO_TIMERS];
+            if (cyxchat_timer_pending(t)) {
+                cyxchat_timer_cancel(wheel, t);
+            } else {
+                cyxchat_timer_schedule(wheel, t, 1 + (n * 2654435761u) % 60000,
+                                       on_bench_timer, NULL);
+            }
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    bench_report("timer.schedule_cancel", &h, n, 0, bench_now_ns() - start);
+
+    bench_hist_free(&h);
+    cyxchat_timer_wheel_destroy(wheel);
+    free(timers);
+    return 0;
+}
+
+/* ============================================================
+ * DNS
+ * ============================================================ */
+
+static int bench_dns_miss(void)
+{
+    cyxchat_dns_ctx_t *dns = NULL;
+    cyxchat_dns_record_t record;
+    cyxwiz_node_id_t local_id;
+    bench_hist_t h;
+
+    memset(&local_id, 0xAB, sizeof(local_id));
+    if (cyxchat_dns_create(&dns, NULL, &local_id, NULL) != CYXCHAT_OK) return 1;
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) {
+        cyxchat_dns_destroy(dns);
+        return 1;
+    }
+
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            g_sink += (uint64_t)cyxchat_dns_resolve(dns, "Nobody.cyx", &record);
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    uint64_t ops = (uint64_t)MICRO_SAMPLES * BENCH_BATCH;
+    bench_report("dns.cache_miss", &h, ops, 0, bench_now_ns() - start);
+
+    bench_hist_free(&h);
+    cyxchat_dns_destroy(dns);
+    return 0;
+}
+
+/* ============================================================
+ * Mail
+ * ============================================================ */
+
+static int fill_mailbox(cyxchat_mail_ctx_t *mail)
+{
+    char subject[64];
+    char body[512];
+
+    for (int i = 0; i < MICRO_MAILBOX; i++) {
+        cyxchat_mail_t *m = NULL;
+        if (cyxchat_mail_create(mail, &m) != CYXCHAT_OK) return -1;
+
+        snprintf(subject, sizeof(subject), "Weekly report %d", i);
+        int n = snprintf(body, sizeof(body),
+                         "Numbers for week %d are in. %s", i,
+                         i % 16 == 0 ? "Invoice attached for review." :
+                                       "Nothing unusual to flag this time around.");
+        cyxchat_mail_set_subject(m, subject);
+        cyxchat_mail_set_body(m, body, (size_t)n);
+
+        if (cyxchat_mail_save_draft(mail, m) != CYXCHAT_OK) {
+            cyxchat_mail_free(m);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int bench_mail_search(void)
+{
+    cyxchat_loopnet_t *net = NULL;
+    cyxchat_runtime_t *rt = NULL;
+    cyxwiz_node_id_t local_id;
+    bench_hist_t h;
+    int rc = 1;
+
+    /* The mail context needs a chat context, which needs a node */
+    memset(&local_id, 0x3C, sizeof(local_id));
+    if (cyxchat_loopnet_create(&net, 1) != CYXCHAT_OK) return 1;
+    if (cyxchat_runtime_create_loopback(&rt, net, &local_id, NULL) != CYXCHAT_OK ||
+        fill_mailbox(cyxchat_runtime_get_mail(rt)) != 0) {
+        bench_report_error("mail.search", "mailbox setup failed");
+        goto out;
+    }
+    if (bench_hist_init(&h, MICRO_SAMPLES / 8) != 0) goto out;
+
+    cyxchat_mail_ctx_t *mail = cyxchat_runtime_get_mail(rt);
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < h.cap; s++) {
+        cyxchat_mail_t **found = NULL;
+        size_t count = 0;
+
+        uint64_t t0 = bench_now_ns();
+        cyxchat_mail_search(mail, "Invoice", &found, &count);
+        bench_hist_record(&h, bench_now_ns() - t0);
+
+        g_sink += count;
+        free(found);
+    }
+    bench_report("mail.search", &h, h.count, 0, bench_now_ns() - start);
+    bench_hist_free(&h);
+    rc = 0;
+
+out:
+    cyxchat_runtime_destroy(rt);
+    cyxchat_loopnet_destroy(net);
+    return rc;
+}
+
+/* ============================================================
+ * Label Switching
+ * ============================================================ */
+
+/* Transit hop on a two-hop path: check the MAC, open our layer, swap */
+static int bench_label_transit(void)
+{
+    cyxchat_label_table_t *up = NULL, *hop = NULL;
+    cyxwiz_node_id_t from;
+    uint8_t payload[MICRO_LABEL_PAYLOAD];
+    uint8_t pkt[MICRO_LABEL_PAYLOAD + CYXCHAT_LABEL_OVERHEAD(2)];
+    bench_hist_t h;
+    int rc = 1;
+
+    memset(&from, 0x4C, sizeof(from));
+    memset(payload, 0x5A, sizeof(payload));
+    if (cyxchat_label_table_create(&up, 2) != CYXCHAT_OK ||
+        cyxchat_label_table_create(&hop, 2) != CYXCHAT_OK) {
+        goto out;
+    }
+
+    cyxchat_label_entry_t *ing = cyxchat_label_alloc(up, 0);
+    cyxchat_label_entry_t *tra = cyxchat_label_alloc(hop, 0);
+    cyxchat_label_circuit_t *c = cyxchat_label_circuit_alloc(up, ing);
+    if (!ing || !tra || !c) goto out;
+
+    /* Keys as two handshakes would leave them; the handshake is not timed */
+    c->hop_count = 2;
+    memset(c->keys[0], 0x11, sizeof(c->keys[0]));
+    memset(c->keys[1], 0x22, sizeof(c->keys[1]));
+    memcpy(tra->key_in, c->keys[0], sizeof(tra->key_in));
+    ing->label_out = tra->label_in;
+    ing->state = CYXCHAT_LABEL_ACTIVE;
+    tra->role = CYXCHAT_LABEL_TRANSIT;
+    tra->state = CYXCHAT_LABEL_ACTIVE;
+    tra->prev_hop = from;
+    tra->label_out = 0x1234;
+
+    if (bench_hist_init(&h, MICRO_SAMPLES) != 0) goto out;
+
+    uint64_t start = bench_now_ns();
+    for (size_t s = 0; s < MICRO_SAMPLES; s++) {
+        uint64_t t0 = bench_now_ns();
+        for (int i = 0; i < BENCH_BATCH; i++) {
+            cyxchat_label_entry_t *e = NULL;
+            size_t len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, payload,
+                                            sizeof(payload), pkt, sizeof(pkt));
+            if (cyxchat_label_open(hop, &from, pkt, len, 0, &e) == CYXCHAT_OK) {
+                cyxchat_label_swap(e, pkt, len);
+            }
+            g_sink += pkt[1];
+        }
+        bench_hist_record(&h, (bench_now_ns() - t0) / BENCH_BATCH);
+    }
+    uint64_t ops = (uint64_t)MICRO_SAMPLES * BENCH_BATCH;
+    bench_report("label.seal_transit", &h, ops, ops * sizeof(payload), bench_now_ns() - start);
+    bench_hist_free(&h);
+    rc = 0;
+
+out:
+    cyxchat_label_table_destroy(up);
+    cyxchat_label_table_destroy(hop);
+    return rc;
+}
+
+/* ============================================================
+ * Group
+ * ============================================================ */
+
+int bench_micro(void)
+{
+    int failed = 0;
+
+    failed += bench_ice_codec();
+    failed += bench_msg_id_codec();
+    failed += bench_dedup();
+    failed += bench_timer_wheel();
+    failed += bench_dns_miss();
+    failed += bench_mail_search();
+    failed += bench_label_transit();
+
+    return failed;
+}
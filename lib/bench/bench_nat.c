@@ -0,0 +1,187 @@
+/**
+ * CyxChat Benchmark - NAT Traversal
+ *
+ * Connects two nodes across every pair of emulated NAT types and reports
+ * how often the hole punch lands, how often the relay has to carry the
+ * session, and how long setup takes. The loopback network's clock is
+ * driven by hand, so results do not depend on host load and a seed
+ * reproduces a run exactly.
+ *
+ * Usage: bench_nat [trials] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/connection.h>
+#include <cyxchat/loopback.h>
+
+#define BENCH_RELAY_ADDR    "198.51.100.7:3479"
+#define BENCH_LATENCY_MS    20                  /* One-way, every link */
+#define BENCH_JITTER_MS     5
+#define BENCH_STEP_MS       1
+#define BENCH_RUN_MS        (CYXCHAT_HOLE_PUNCH_TIMEOUT_MS + 1000)
+
+static const char *nat_names[] = {
+    "none", "full-cone", "restricted", "port-restr", "symmetric"
+};
+
+#define NAT_TYPES (sizeof(nat_names) / sizeof(nat_names[0]))
+
+typedef struct {
+    int done;
+    cyxchat_conn_state_t state;
+    uint64_t at_ms;
+    uint64_t *clock;
+} bench_side_t;
+
+typedef struct {
+    unsigned direct;
+    unsigned relayed;
+    unsigned failed;
+    uint64_t total_ms;
+    uint64_t max_ms;
+} bench_row_t;
+
+static void on_complete(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id,
+                        cyxchat_conn_state_t state, cyxchat_error_t result,
+                        void *user_data)
+{
+    (void)ctx;
+    (void)peer_id;
+    bench_side_t *side = (bench_side_t*)user_data;
+    if (side->done) return;
+
+    side->done = 1;
+    side->state = result == CYXCHAT_OK ? state : CYXCHAT_CONN_DISCONNECTED;
+    side->at_ms = *side->clock;
+}
+
+static void make_id(cyxwiz_node_id_t *id, uint8_t tag)
+{
+    memset(id, 0, sizeof(*id));
+    id->bytes[0] = tag;
+    id->bytes[1] = 0x5A;
+}
+
+/* One connect attempt; returns the final state seen by the initiator */
+static cyxchat_conn_state_t run_trial(cyxchat_loop_nat_type_t nat_a,
+                                      cyxchat_loop_nat_type_t nat_b,
+                                      uint64_t seed, uint64_t *setup_ms)
+{
+    cyxchat_loopnet_t *net = NULL;
+    cyxchat_conn_ctx_t *a = NULL, *b = NULL;
+    cyxwiz_node_id_t id_a, id_b;
+    cyxchat_conn_state_t final = CYXCHAT_CONN_DISCONNECTED;
+
+    *setup_ms = 0;
+    make_id(&id_a, 0xA1);
+    make_id(&id_b, 0xB2);
+
+    if (cyxchat_loopnet_create(&net, seed) != CYXCHAT_OK) {
+        return final;
+    }
+
+    cyxchat_loop_link_t link;
+    memset(&link, 0, sizeof(link));
+    link.latency_ms = BENCH_LATENCY_MS;
+    link.jitter_ms = BENCH_JITTER_MS;
+    cyxchat_loopnet_set_default_link(net, &link);
+
+    if (cyxchat_loopnet_add_relay(net, BENCH_RELAY_ADDR) != CYXCHAT_OK ||
+        cyxchat_conn_create_loopback(&a, net, &id_a) != CYXCHAT_OK ||
+        cyxchat_conn_create_loopback(&b, net, &id_b) != CYXCHAT_OK) {
+        goto out;
+    }
+
+    cyxchat_loop_nat_t nat;
+    memset(&nat, 0, sizeof(nat));
+    nat.type = nat_a;
+    cyxchat_loopnet_set_nat(cyxchat_conn_get_transport(a), &nat);
+    nat.type = nat_b;
+    cyxchat_loopnet_set_nat(cyxchat_conn_get_transport(b), &nat);
+
+    cyxchat_conn_set_poll_timeout(a, 0);
+    cyxchat_conn_set_poll_timeout(b, 0);
+    cyxchat_conn_add_relay(a, BENCH_RELAY_ADDR);
+    cyxchat_conn_add_relay(b, BENCH_RELAY_ADDR);
+
+    /* Take the clock over from where the connection wheels stand */
+    uint64_t now = cyxchat_loopnet_now_ms(net) + 1;
+    cyxchat_loopnet_set_time(net, now);
+    uint64_t start = now;
+
+    bench_side_t side_a = { 0, CYXCHAT_CONN_DISCONNECTED, 0, &now };
+    bench_side_t side_b = { 0, CYXCHAT_CONN_DISCONNECTED, 0, &now };
+
+    /* Both ends connect at once, as after a rendezvous exchange */
+    cyxchat_conn_connect(a, &id_b, on_complete, &side_a);
+    cyxchat_conn_connect(b, &id_a, on_complete, &side_b);
+
+    /* Run past the punch deadline so a late punch can still upgrade */
+    while (now - start < BENCH_RUN_MS) {
+        cyxchat_conn_poll(a, now);
+        cyxchat_conn_poll(b, now);
+        now += BENCH_STEP_MS;
+        cyxchat_loopnet_set_time(net, now);
+    }
+
+    if (side_a.done && side_b.done &&
+        side_a.state != CYXCHAT_CONN_DISCONNECTED &&
+        side_b.state != CYXCHAT_CONN_DISCONNECTED) {
+        final = cyxchat_conn_get_state(a, &id_b);
+        *setup_ms = (side_a.at_ms > side_b.at_ms ? side_a.at_ms : side_b.at_ms) - start;
+    }
+
+out:
+    if (a) cyxchat_conn_destroy(a);
+    if (b) cyxchat_conn_destroy(b);
+    cyxchat_loopnet_destroy(net);
+    return final;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned trials = argc > 1 ? (unsigned)strtoul(argv[1], NULL, 10) : 20;
+    uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 10) : 1;
+    if (trials == 0) trials = 1;
+
+    printf("NAT traversal: %u trials per pair, %u ms one-way, seed %llu\n\n",
+           trials, BENCH_LATENCY_MS, (unsigned long long)seed);
+    printf("%-11s %-11s %7s %7s %8s %7s %9s %8s\n",
+           "nat_a", "nat_b", "trials", "direct", "relayed", "failed", "mean_ms", "max_ms");
+
+    for (size_t i = 0; i < NAT_TYPES; i++) {
+        for (size_t j = 0; j < NAT_TYPES; j++) {
+            bench_row_t row;
+            memset(&row, 0, sizeof(row));
+
+            for (unsigned t = 0; t < trials; t++) {
+                uint64_t setup_ms;
+                cyxchat_conn_state_t st = run_trial((cyxchat_loop_nat_type_t)i,
+                                                    (cyxchat_loop_nat_type_t)j,
+                                                    seed + t, &setup_ms);
+                if (st == CYXCHAT_CONN_CONNECTED) {
+                    row.direct++;
+                } else if (st == CYXCHAT_CONN_RELAYING) {
+                    row.relayed++;
+                } else {
+                    row.failed++;
+                    continue;
+                }
+                row.total_ms += setup_ms;
+                if (setup_ms > row.max_ms) row.max_ms = setup_ms;
+            }
+
+            unsigned ok = row.direct + row.relayed;
+            printf("%-11s %-11s %7u %7u %8u %7u %9.1f %8llu\n",
+                   nat_names[i], nat_names[j], trials,
+                   row.direct, row.relayed, row.failed,
+                   ok ? (double)row.total_ms / ok : 0.0,
+                   (unsigned long long)row.max_ms);
+        }
+    }
+
+    return 0;
+}
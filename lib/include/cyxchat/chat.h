@@ -7,6 +7,7 @@
 #define CYXCHAT_CHAT_H
 
 #include "types.h"
+#include "config.h"
 #include <cyxwiz/onion.h>
 
 #ifdef __cplusplus
@@ -136,6 +137,26 @@ CYXCHAT_API cyxchat_error_t cyxchat_create(
     const cyxwiz_node_id_t *local_id
 );
 
+/**
+ * Create chat context with configured queue sizes
+ *
+ * The receive queue (config->recv_queue_size slots, one kept open) and
+ * config->frag_buffers reassembly buffers share the context's single
+ * allocation.
+ *
+ * @param ctx           Output: created context
+ * @param onion         Onion routing context (from libcyxwiz)
+ * @param local_id      Our node ID
+ * @param config        Capacities (NULL for cyxchat_config_default)
+ * @return              CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_create_with_config(
+    cyxchat_ctx_t **ctx,
+    cyxwiz_onion_ctx_t *onion,
+    const cyxwiz_node_id_t *local_id,
+    const cyxchat_config_t *config
+);
+
 /**
  * Destroy chat context
  */
@@ -182,6 +203,8 @@ CYXCHAT_API const cyxwiz_node_id_t* cyxchat_get_local_id(cyxchat_ctx_t *ctx);
 
 /**
  * Send text message
+ * If no circuit to the recipient can be built and an offline context
+ * is registered, the message goes to the recipient's mailbox instead.
  *
  * @param ctx           Chat context
  * @param to            Recipient node ID
@@ -368,6 +391,29 @@ CYXCHAT_API cyxchat_error_t cyxchat_send_raw(
     size_t data_len
 );
 
+/**
+ * Send raw data in a traffic class
+ *
+ * Control and interactive data is sent at once. Background and bulk
+ * data is queued per peer and released by cyxchat_poll(), after
+ * anything more urgent.
+ *
+ * @param ctx           Chat context
+ * @param to            Recipient node ID
+ * @param data          Data to send (at most 250 bytes when queued)
+ * @param data_len      Data length
+ * @param prio          Traffic class
+ * @return              CYXCHAT_OK on success, CYXCHAT_ERR_FULL if the
+ *                      peer's queue for the class is full (retry later)
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_send_raw_prio(
+    cyxchat_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t data_len,
+    cyxchat_prio_t prio
+);
+
 /* Forward declaration for file context */
 struct cyxchat_file_ctx;
 typedef struct cyxchat_file_ctx cyxchat_file_ctx_t;
@@ -381,11 +427,64 @@ CYXCHAT_API void cyxchat_set_file_ctx(
     cyxchat_file_ctx_t *file_ctx
 );
 
+/* Forward declaration for offline delivery context */
+struct cyxchat_offline_ctx;
+typedef struct cyxchat_offline_ctx cyxchat_offline_ctx_t;
+
+/**
+ * Register offline delivery context
+ * Text that cannot reach its recipient is stored in their mailbox
+ * (needs the offline key lookup), and messages drained from our own
+ * mailbox take the normal receive path. Takes over the offline
+ * context's message callback.
+ */
+CYXCHAT_API void cyxchat_set_offline_ctx(
+    cyxchat_ctx_t *ctx,
+    cyxchat_offline_ctx_t *offline_ctx
+);
+
+/**
+ * Choose whether cyxchat_poll() polls the onion context (default 1)
+ * Disable when the onion comes from a connection context, since
+ * cyxchat_conn_poll() already polls it.
+ */
+CYXCHAT_API void cyxchat_set_onion_polling(
+    cyxchat_ctx_t *ctx,
+    int enabled
+);
+
 /**
  * Get the onion context (for modules that need direct access)
  */
 CYXCHAT_API cyxwiz_onion_ctx_t* cyxchat_get_onion(cyxchat_ctx_t *ctx);
 
+/* Forward declaration for dedup context */
+struct cyxchat_dedup_ctx;
+typedef struct cyxchat_dedup_ctx cyxchat_dedup_ctx_t;
+
+/**
+ * Get the receive-path duplicate filter (for stats or shared use)
+ */
+CYXCHAT_API cyxchat_dedup_ctx_t* cyxchat_get_dedup(cyxchat_ctx_t *ctx);
+
+/* Forward declaration for scheduler context */
+struct cyxchat_sched_ctx;
+typedef struct cyxchat_sched_ctx cyxchat_sched_ctx_t;
+
+/**
+ * Get the outbound scheduler (for stats)
+ */
+CYXCHAT_API cyxchat_sched_ctx_t* cyxchat_get_sched(cyxchat_ctx_t *ctx);
+
+/* Forward declaration for random pool */
+struct cyxchat_rng;
+typedef struct cyxchat_rng cyxchat_rng_t;
+
+/**
+ * Get the context's buffered random pool (shared by modules for IDs)
+ */
+CYXCHAT_API cyxchat_rng_t* cyxchat_get_rng(cyxchat_ctx_t *ctx);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,151 @@
+/**
+ * CyxChat Configuration API
+ * Per-deployment table capacities and single-allocation context layout
+ */
+
+#ifndef CYXCHAT_CONFIG_H
+#define CYXCHAT_CONFIG_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+/* Defaults for capacities without a public macro elsewhere */
+#define CYXCHAT_CONFIG_RECV_QUEUE       32      /* Chat receive queue slots */
+#define CYXCHAT_CONFIG_FRAG_BUFFERS     8       /* Messages reassembled at once */
+#define CYXCHAT_CONFIG_MAIL_STORED      256     /* Stored mails */
+#define CYXCHAT_CONFIG_GROUPS           32      /* Joined groups */
+
+#define CYXCHAT_CONFIG_MAX_ENTRIES      (1u << 20)  /* Upper bound for any table */
+
+#define CYXCHAT_ARENA_ALIGN             16      /* Carve alignment */
+
+/* ============================================================
+ * Types
+ * ============================================================ */
+
+/*
+ * Table capacities, fixed when a context is created. Each context
+ * lays its tables out after its own struct in one allocation, so a
+ * smaller config means a smaller footprint rather than unused slots.
+ */
+typedef struct {
+    uint32_t recv_queue_size;       /* Chat receive queue slots (at least 2) */
+    uint32_t frag_buffers;          /* Chat fragment reassembly buffers */
+    uint32_t max_peers;             /* Connection peer limit (0 = unlimited) */
+    uint32_t dns_cache_size;        /* Cached DNS records */
+    uint32_t mail_max_stored;       /* Stored mails */
+    uint32_t max_contacts;          /* Contact list entries */
+    uint32_t max_groups;            /* Joined groups */
+    uint32_t label_table_size;      /* Label-switched paths (power of two) */
+    uint32_t offline_store_size;    /* Mailbox items held for other nodes */
+} cyxchat_config_t;
+
+/*
+ * Bump allocator over one block. With a NULL base it only measures:
+ * carves return NULL but still advance used, so running a layout twice
+ * (measure, allocate, carve) sizes and fills one allocation.
+ */
+typedef struct {
+    uint8_t *base;                  /* Block (NULL while measuring) */
+    size_t size;                    /* Block size */
+    size_t used;                    /* Bytes carved so far */
+    int overflow;                   /* A carve did not fit */
+} cyxchat_arena_t;
+
+/*
+ * Context layout: carves the struct first, then its tables, and wires
+ * them up when the carves return memory. Returns the struct (NULL
+ * while measuring).
+ */
+typedef void* (*cyxchat_arena_layout_t)(cyxchat_arena_t *arena, const void *arg);
+
+/* ============================================================
+ * Configuration
+ * ============================================================ */
+
+/**
+ * Get the default configuration
+ * Matches the fixed capacities of earlier releases.
+ *
+ * @param config        Output configuration
+ */
+CYXCHAT_API void cyxchat_config_default(cyxchat_config_t *config);
+
+/**
+ * Check a configuration
+ *
+ * @param config        Configuration
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if a capacity is zero or
+ *         above CYXCHAT_CONFIG_MAX_ENTRIES, or the label table size is
+ *         not a power of two up to CYXCHAT_LABEL_TABLE_MAX
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_config_validate(const cyxchat_config_t *config);
+
+/**
+ * Pick the configuration a create call runs with
+ *
+ * @param config        Caller's configuration (NULL for the defaults)
+ * @param defaults      Filled with the defaults when config is NULL
+ * @return config or defaults, NULL if config does not validate
+ */
+CYXCHAT_API const cyxchat_config_t* cyxchat_config_resolve(
+    const cyxchat_config_t *config,
+    cyxchat_config_t *defaults
+);
+
+/* ============================================================
+ * Arena
+ * ============================================================ */
+
+/**
+ * Start an arena
+ *
+ * @param arena         Arena
+ * @param base          Block to carve from (NULL to measure only)
+ * @param size          Block size
+ */
+CYXCHAT_API void cyxchat_arena_init(cyxchat_arena_t *arena, void *base, size_t size);
+
+/**
+ * Carve an aligned array
+ *
+ * @param arena         Arena
+ * @param count         Element count
+ * @param elem_size     Element size
+ * @return Zeroed memory, NULL while measuring or if it does not fit
+ */
+CYXCHAT_API void* cyxchat_arena_carve(cyxchat_arena_t *arena, size_t count, size_t elem_size);
+
+/**
+ * Allocate the block a measuring pass asked for
+ * Restarts the arena over a zeroed block of arena->used bytes; release
+ * it with free().
+ *
+ * @param arena         Arena after a measuring pass
+ * @return Block, NULL on overflow or allocation failure
+ */
+CYXCHAT_API void* cyxchat_arena_alloc(cyxchat_arena_t *arena);
+
+/**
+ * Build a context in one allocation
+ * Runs the layout to measure, allocates, and runs it again to carve.
+ *
+ * @param layout        Layout function
+ * @param arg           Passed to both layout passes
+ * @return Context (release with free()), NULL on overflow or
+ *         allocation failure
+ */
+CYXCHAT_API void* cyxchat_arena_build(cyxchat_arena_layout_t layout, const void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_CONFIG_H */
@@ -0,0 +1,85 @@
+/**
+ * CyxChat Congestion Control API
+ * Delay-based (LEDBAT-style) pacing for background bulk traffic
+ */
+
+#ifndef CYXCHAT_CONGESTION_H
+#define CYXCHAT_CONGESTION_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_CC_TARGET_MS        60      /* Queueing delay bulk may add */
+#define CYXCHAT_CC_INIT_CWND        2       /* Packets per RTT at start */
+#define CYXCHAT_CC_MIN_CWND         1
+#define CYXCHAT_CC_MAX_CWND         1024
+#define CYXCHAT_CC_FILTER           2       /* Delay samples min-filtered */
+#define CYXCHAT_CC_IDLE_INTERVAL_US 500000  /* Pacing without delay samples */
+#define CYXCHAT_CC_MAX_INTERVAL_US  1000000
+
+/* ============================================================
+ * Controller
+ * ============================================================ */
+
+typedef struct {
+    uint32_t cwnd;                      /* Packets per RTT, 1/256 units */
+    uint32_t rtt_ms;                    /* Last round trip (0 = none yet) */
+    uint32_t qdelay_ms;                 /* Filtered queueing delay */
+    uint32_t recent_ms[CYXCHAT_CC_FILTER];
+    uint32_t recent_count;
+    uint64_t last_loss_ms;              /* One halving per RTT */
+    int slow_start;
+} cyxchat_congestion_t;
+
+/**
+ * Reset the controller (slow start, idle pacing)
+ *
+ * @param cc            Controller
+ */
+CYXCHAT_API void cyxchat_congestion_init(cyxchat_congestion_t *cc);
+
+/**
+ * Feed one round-trip sample (about one per RTT)
+ *
+ * Queueing delay is the sample minus the path's base (minimum) RTT.
+ * Below CYXCHAT_CC_TARGET_MS the window grows by up to one packet per
+ * sample; above it the window shrinks in proportion to the excess, by
+ * at most half. Slow start doubles the window until the delay reaches
+ * three quarters of the target.
+ *
+ * @param cc            Controller
+ * @param rtt_ms        Measured round trip
+ * @param base_rtt_ms   Lowest round trip seen on the path
+ */
+CYXCHAT_API void cyxchat_congestion_on_rtt(cyxchat_congestion_t *cc,
+                                           uint32_t rtt_ms, uint32_t base_rtt_ms);
+
+/**
+ * Note packet loss (halves the window, at most once per RTT)
+ *
+ * @param cc            Controller
+ * @param now_ms        Current time
+ */
+CYXCHAT_API void cyxchat_congestion_on_loss(cyxchat_congestion_t *cc, uint64_t now_ms);
+
+/**
+ * Gap between packets to pace the window over one RTT
+ *
+ * @param cc            Controller
+ * @return Microseconds per packet (CYXCHAT_CC_IDLE_INTERVAL_US before
+ *         the first sample)
+ */
+CYXCHAT_API uint32_t cyxchat_congestion_interval_us(const cyxchat_congestion_t *cc);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_CONGESTION_H */
@@ -10,6 +10,15 @@
 #define CYXCHAT_CONNECTION_H
 
 #include "types.h"
+#include "config.h"
+#include "timer.h"
+#include "ice.h"
+#include "linkstats.h"
+#include "dedup.h"
+#include "keepalive.h"
+#include "dispatch.h"
+#include "loopback.h"
+#include "label.h"
 #include <cyxwiz/transport.h>
 #include <cyxwiz/peer.h>
 #include <cyxwiz/onion.h>
@@ -23,13 +32,20 @@ extern "C" {
  * Configuration
  * ============================================================ */
 
-#define CYXCHAT_MAX_PEER_CONNECTIONS    32      /* Max simultaneous connections */
-#define CYXCHAT_HOLE_PUNCH_TIMEOUT_MS   5000    /* Time before relay fallback */
+#define CYXCHAT_MAX_PEER_CONNECTIONS    32      /* Initial peer table capacity */
+#define CYXCHAT_DEFAULT_MAX_PEERS       4096    /* Peer limit (grows up to this) */
+#define CYXCHAT_HOLE_PUNCH_TIMEOUT_MS   5000    /* Punch deadline (relay stays after) */
+#define CYXCHAT_RELAY_STAGGER_MS        250     /* Punch head start before relay races */
 #define CYXCHAT_HOLE_PUNCH_ATTEMPTS     5       /* Punch attempts */
 #define CYXCHAT_HOLE_PUNCH_INTERVAL_MS  50      /* Between attempts */
-#define CYXCHAT_KEEPALIVE_INTERVAL_MS   30000   /* Keepalive interval */
+#define CYXCHAT_KEEPALIVE_INTERVAL_MS   30000   /* Until the NAT lifetime is known */
 #define CYXCHAT_CONNECTION_TIMEOUT_MS   90000   /* Peer timeout */
 #define CYXCHAT_STUN_INTERVAL_MS        60000   /* STUN refresh interval */
+#define CYXCHAT_CONN_BATCH_PACKETS      64      /* Datagrams per send batch */
+#define CYXCHAT_CONN_POLL_TIMEOUT_MS    10      /* Default transport wait per poll */
+#define CYXCHAT_CONN_MULTIPATH_MAX      512     /* Largest datagram sent on both paths */
+#define CYXCHAT_CONN_MULTIPATH_WINDOW   CYXCHAT_DEDUP_SEQ_WINDOW  /* Per peer */
+#define CYXCHAT_CONN_MULTIPATH_HEADER   5       /* Type + sequence number */
 
 /* ============================================================
  * Connection States
@@ -52,8 +68,18 @@ typedef struct {
     cyxchat_conn_state_t state;         /* Current state */
     uint64_t connected_at;              /* Connection timestamp */
     uint64_t last_activity;             /* Last activity timestamp */
-    uint32_t bytes_sent;                /* Bytes sent */
-    uint32_t bytes_received;            /* Bytes received */
+    uint64_t bytes_sent;                /* Bytes sent */
+    uint64_t bytes_received;            /* Bytes received */
+    uint64_t packets_sent;              /* Datagrams sent */
+    uint64_t packets_received;          /* Datagrams received */
+    uint64_t packets_lost;              /* Sequence gaps + unanswered probes */
+    uint32_t srtt_ms;                   /* Smoothed RTT (0 = no sample yet) */
+    uint32_t rttvar_ms;                 /* RTT variation */
+    uint32_t min_rtt_ms;                /* Lowest RTT on the current path */
+    uint32_t rto_ms;                    /* Retransmission timeout */
+    uint32_t loss_ppm;                  /* Loss rate, parts per million */
+    uint64_t tx_rate;                   /* Send rate, bytes/s */
+    uint64_t rx_rate;                   /* Receive rate, bytes/s */
     int8_t rssi;                        /* Signal strength (if available) */
     int is_relayed;                     /* 1 if via relay, 0 if direct */
 } cyxchat_conn_info_t;
@@ -71,8 +97,22 @@ typedef struct {
     int dht_enabled;                    /* DHT is active */
     size_t dht_nodes;                   /* Nodes in DHT routing table */
     size_t dht_active_buckets;          /* Non-empty DHT buckets */
+    /* Network change handling */
+    uint32_t network_changes;           /* Address changes since create */
+    size_t repunching;                  /* Peers re-punching (bridged via relay) */
 } cyxchat_network_status_t;
 
+/* Batched and multipath I/O counters */
+typedef struct {
+    uint64_t rx_packets;                /* Datagrams received */
+    uint64_t tx_packets;                /* Datagrams sent from the queue */
+    uint64_t tx_batches;                /* Send queue flushes (one vectored send each) */
+    uint64_t tx_errors;                 /* Queued sends the transport rejected */
+    uint64_t transport_polls;           /* Transport poll calls */
+    uint64_t multipath_sent;            /* Datagrams sent on relay and direct */
+    uint64_t multipath_dup;             /* Second copies dropped on receive */
+} cyxchat_conn_io_stats_t;
+
 /* ============================================================
  * Context
  * ============================================================ */
@@ -105,6 +145,21 @@ typedef void (*cyxchat_conn_data_callback_t)(
     void *user_data
 );
 
+/**
+ * Public address callback
+ *
+ * Called when STUN first reports our address and after every network
+ * change (new public or local IP). By then the library has already
+ * re-registered with bootstrap and started re-punching active peers;
+ * the application should republish the address (e.g. DNS stun_addr).
+ */
+typedef void (*cyxchat_conn_network_callback_t)(
+    cyxchat_conn_ctx_t *ctx,
+    uint32_t public_ip,                 /* Network byte order */
+    uint16_t public_port,               /* Network byte order */
+    void *user_data
+);
+
 /**
  * Connection complete callback (for async connect)
  */
@@ -134,6 +189,46 @@ CYXCHAT_API cyxchat_error_t cyxchat_conn_create(
     const cyxwiz_node_id_t *local_id
 );
 
+/**
+ * Create connection context with a configured peer limit
+ *
+ * Peer tables still grow on demand; config->max_peers caps them the
+ * way cyxchat_conn_set_max_peers() does. The label table is fixed at
+ * config->label_table_size entries.
+ *
+ * @param ctx           Output: created context
+ * @param bootstrap     Bootstrap server address (IP:port string)
+ * @param local_id      Our node ID
+ * @param config        Capacities (NULL for cyxchat_config_default)
+ * @return              CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_create_with_config(
+    cyxchat_conn_ctx_t **ctx,
+    const char *bootstrap,
+    const cyxwiz_node_id_t *local_id,
+    const cyxchat_config_t *config
+);
+
+/**
+ * Create connection context on a loopback network
+ *
+ * Same as cyxchat_conn_create, but the node sends and receives through
+ * an in-process network instead of a UDP socket, so several contexts
+ * can talk inside one process. STUN and network change detection are
+ * off; the public address is the one the network's rendezvous server
+ * reports, and punches go through the network's NAT emulation.
+ *
+ * @param ctx           Output context
+ * @param net           Network from cyxchat_loopnet_create
+ * @param local_id      Our node ID (the node's address on the network)
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_create_loopback(
+    cyxchat_conn_ctx_t **ctx,
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *local_id
+);
+
 /**
  * Destroy connection context
  */
@@ -148,6 +243,28 @@ CYXCHAT_API void cyxchat_conn_destroy(cyxchat_conn_ctx_t *ctx);
  */
 CYXCHAT_API int cyxchat_conn_poll(cyxchat_conn_ctx_t *ctx, uint64_t now_ms);
 
+/**
+ * Get earliest time cyxchat_conn_poll() has timer work to do
+ * Covers hole punch, idle and relay deadlines, plus DNS/presence
+ * timers attached to this context's wheel. Time base is that of the
+ * now_ms values passed to poll.
+ *
+ * @param ctx           Connection context
+ * @return Absolute time in ms, or CYXCHAT_TIMER_NONE if nothing is scheduled
+ */
+CYXCHAT_API uint64_t cyxchat_conn_next_deadline(cyxchat_conn_ctx_t *ctx);
+
+/**
+ * Get the connection timer wheel
+ * Pass to cyxchat_dns_set_timer_wheel() / cyxchat_presence_set_timer_wheel()
+ * so their deadlines fire from cyxchat_conn_poll(). Detach them before
+ * destroying the connection context.
+ *
+ * @param ctx           Connection context
+ * @return Timer wheel (owned by the context)
+ */
+CYXCHAT_API cyxchat_timer_wheel_t* cyxchat_conn_get_timer_wheel(cyxchat_conn_ctx_t *ctx);
+
 /* ============================================================
  * Connection Management
  * ============================================================ */
@@ -155,8 +272,14 @@ CYXCHAT_API int cyxchat_conn_poll(cyxchat_conn_ctx_t *ctx, uint64_t now_ms);
 /**
  * Initiate connection to peer
  *
- * Attempts direct P2P connection via UDP hole punching.
- * Falls back to relay if direct connection fails.
+ * Races UDP hole punching against the relay: the relay session starts
+ * CYXCHAT_RELAY_STAGGER_MS after the punch (immediately when our NAT is
+ * symmetric or blocked) and the callback fires once, for whichever path
+ * carries traffic first. The relay counts only once it acknowledges the
+ * session or delivers peer data; until then the punch keeps going. If
+ * the relay won, a punch that succeeds before
+ * CYXCHAT_HOLE_PUNCH_TIMEOUT_MS upgrades the peer to direct and closes
+ * the relay session (reported through the state change callback).
  *
  * @param ctx           Connection context
  * @param peer_id       Peer to connect to
@@ -201,6 +324,59 @@ CYXCHAT_API cyxchat_error_t cyxchat_conn_get_info(
     cyxchat_conn_info_t *info_out
 );
 
+/**
+ * Get the link estimator for a peer
+ *
+ * Round trips come from echo probes sent on the current path every
+ * keepalive window (and from path checks on the selected
+ * candidate); loss from gaps in the peer's probe sequence and from
+ * probes left unanswered. Path estimates restart when the path changes.
+ *
+ * @param ctx           Connection context
+ * @param peer_id       Peer node ID
+ * @param stats_out     Output: statistics snapshot
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND if the peer is unknown
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_get_link_stats(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *peer_id,
+    cyxchat_linkstats_t *stats_out
+);
+
+/**
+ * Get the keepalive interval and the NAT binding lifetime search
+ *
+ * All peers are echoed, and relay keepalives sent, in one wake-up per
+ * window. The window is the interval less up to 10% jitter; the
+ * interval starts at CYXCHAT_KEEPALIVE_INTERVAL_MS and then follows
+ * the binding lifetime found by cyxchat_netmon_set_lifetime_probe
+ * (which needs an RFC 5780 STUN server, see cyxchat_conn_set_stun_server).
+ *
+ * @param ctx           Connection context
+ * @param ka_out        Output: search state and interval
+ */
+CYXCHAT_API void cyxchat_conn_get_keepalive(
+    cyxchat_conn_ctx_t *ctx,
+    cyxchat_keepalive_t *ka_out
+);
+
+/**
+ * Probe a peer's path every round trip for a while
+ *
+ * Echo probes normally run at the keepalive interval. A bulk sender
+ * pacing itself by queueing delay calls this on each poll; probes then
+ * follow the smoothed RTT (at least every 50 ms) until two seconds
+ * after the last call.
+ *
+ * @param ctx           Connection context
+ * @param peer_id       Peer node ID
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND if the peer is not connected
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_sample_path(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *peer_id
+);
+
 /**
  * Check if connection is using relay
  */
@@ -209,6 +385,32 @@ CYXCHAT_API int cyxchat_conn_is_relayed(
     const cyxwiz_node_id_t *peer_id
 );
 
+/**
+ * Get the direct path selected for a peer
+ *
+ * Connected and relayed peers exchange candidates (host, server
+ * reflexive, relay) and check each of the peer's candidates in turn:
+ * a punch steers the peer's transport onto it and a check round trip
+ * times it. The fastest working candidate is kept, and the checks re-run
+ * every CYXCHAT_ICE_RECHECK_MS and after a network change, moving to a
+ * better path (e.g. the LAN address once both peers share a network)
+ * when one appears. The selection covers the path the peer uses to
+ * reach us; the peer ranks our candidates for the other direction.
+ *
+ * @param ctx           Connection context
+ * @param peer_id       Peer node ID
+ * @param cand_out      Output: selected candidate (may be NULL)
+ * @param rtt_ms_out    Output: its last measured round trip (may be NULL)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND if the peer is unknown or
+ *         no candidate has answered yet
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_get_path(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *peer_id,
+    cyxchat_ice_candidate_t *cand_out,
+    uint32_t *rtt_ms_out
+);
+
 /* ============================================================
  * Data Transfer
  * ============================================================ */
@@ -216,7 +418,9 @@ CYXCHAT_API int cyxchat_conn_is_relayed(
 /**
  * Send data to peer
  *
- * Automatically uses direct or relay connection based on state.
+ * Automatically uses direct or relay connection based on state. With
+ * multipath enabled, a datagram of up to CYXCHAT_CONN_MULTIPATH_MAX
+ * bytes to a peer still punching goes out on both paths.
  *
  * @param ctx           Connection context
  * @param peer_id       Destination peer
@@ -231,6 +435,82 @@ CYXCHAT_API cyxchat_error_t cyxchat_conn_send(
     size_t len
 );
 
+/**
+ * Enable or disable batched sends
+ *
+ * When enabled, direct cyxchat_conn_send() calls are queued and go out
+ * in one call, before the poll blocks and again at the end of the
+ * cycle. Send errors are then reported in cyxchat_conn_io_stats_t
+ * rather than returned. Disabling flushes the queue.
+ *
+ * Only the loopback transport has a vectored send. The UDP socket and
+ * its framing belong to cyxwiz, whose transport sends and reads one
+ * datagram per call, so there queueing would only add a copy and a
+ * delay and the call is refused.
+ *
+ * @param ctx           Connection context
+ * @param enabled       1 to batch, 0 for immediate sends (default)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID on a UDP transport, or
+ *         CYXCHAT_ERR_MEMORY
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_set_batch_io(
+    cyxchat_conn_ctx_t *ctx,
+    int enabled
+);
+
+/**
+ * Enable or disable multipath sends during path transitions
+ *
+ * While a peer is connecting or re-punching (after the relay won the
+ * race, or after a network change), the path in use may be the one
+ * about to die. With multipath on, small datagrams to such a peer are
+ * wrapped with a sequence number and sent over both the relay and the
+ * direct address; the receiver delivers whichever copy lands first and
+ * drops the other. Once a direct datagram confirms the path, sends go
+ * back to the single direct path. Receiving is always supported.
+ *
+ * @param ctx           Connection context
+ * @param enabled       1 to duplicate during transitions, 0 for one path (default)
+ */
+CYXCHAT_API void cyxchat_conn_set_multipath(
+    cyxchat_conn_ctx_t *ctx,
+    int enabled
+);
+
+/**
+ * Get batched I/O counters
+ *
+ * @param ctx           Connection context
+ * @param stats_out     Output counters
+ */
+CYXCHAT_API void cyxchat_conn_get_io_stats(
+    cyxchat_conn_ctx_t *ctx,
+    cyxchat_conn_io_stats_t *stats_out
+);
+
+/**
+ * Set how long cyxchat_conn_poll() may block waiting for datagrams
+ * A loop that knows its next deadline can sleep in the transport
+ * instead of spinning; 0 makes the poll non-blocking and UINT32_MAX
+ * waits for a datagram or cyxchat_conn_wake() however long it takes.
+ *
+ * @param ctx           Connection context
+ * @param timeout_ms    Wait (default CYXCHAT_CONN_POLL_TIMEOUT_MS)
+ */
+CYXCHAT_API void cyxchat_conn_set_poll_timeout(
+    cyxchat_conn_ctx_t *ctx,
+    uint32_t timeout_ms
+);
+
+/**
+ * Cut a blocking cyxchat_conn_poll() short
+ * Safe from any thread. A wake with no poll blocked makes the next
+ * poll return without waiting.
+ *
+ * @param ctx           Connection context
+ */
+CYXCHAT_API void cyxchat_conn_wake(cyxchat_conn_ctx_t *ctx);
+
 /* ============================================================
  * Network Status
  * ============================================================ */
@@ -289,6 +569,84 @@ CYXCHAT_API void cyxchat_conn_set_on_data(
     void *user_data
 );
 
+/**
+ * Claim a range of received message types
+ *
+ * Messages whose first byte falls in the range go to the handler
+ * instead of the data callback, after the peer bookkeeping. Ranges the
+ * connection layer uses itself (discovery, onion, relay, connection
+ * control) are already taken.
+ *
+ * @param ctx           Connection context
+ * @param first         First type
+ * @param last          Last type (inclusive)
+ * @param handler       Handler
+ * @param user_data     Handler user data
+ * @return CYXCHAT_OK, CYXCHAT_ERR_EXISTS if any type is already claimed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_register_handler(
+    cyxchat_conn_ctx_t *ctx,
+    uint8_t first,
+    uint8_t last,
+    cyxchat_dispatch_fn handler,
+    void *user_data
+);
+
+/**
+ * Release a range claimed with cyxchat_conn_register_handler
+ *
+ * @param ctx           Connection context
+ * @param first         First type
+ * @param last          Last type (inclusive)
+ */
+CYXCHAT_API void cyxchat_conn_unregister_handler(
+    cyxchat_conn_ctx_t *ctx,
+    uint8_t first,
+    uint8_t last
+);
+
+/**
+ * Set public address / network change callback
+ */
+CYXCHAT_API void cyxchat_conn_set_on_network_change(
+    cyxchat_conn_ctx_t *ctx,
+    cyxchat_conn_network_callback_t callback,
+    void *user_data
+);
+
+/* ============================================================
+ * Network Change Detection
+ * ============================================================ */
+
+/**
+ * Set STUN server used for the periodic address refresh
+ *
+ * The address is re-checked every CYXCHAT_STUN_INTERVAL_MS and, on
+ * Linux, shortly after any OS address or route change. When it moves,
+ * direct peers are bridged through the relay while hole punches from
+ * the new address run in parallel; each peer returns to direct as soon
+ * as it answers.
+ *
+ * @param ctx           Connection context
+ * @param stun_server   "host:port"
+ * @return              CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_set_stun_server(
+    cyxchat_conn_ctx_t *ctx,
+    const char *stun_server
+);
+
+/**
+ * Re-check the public address now
+ *
+ * For platforms without route notifications: call from the OS
+ * connectivity callback (e.g. WiFi/cellular switch).
+ *
+ * @param ctx           Connection context
+ * @return              CYXCHAT_OK if a STUN request was sent
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_refresh_network(cyxchat_conn_ctx_t *ctx);
+
 /* ============================================================
  * Relay Management
  * ============================================================ */
@@ -305,11 +663,38 @@ CYXCHAT_API cyxchat_error_t cyxchat_conn_add_relay(
     const char *relay_addr
 );
 
+/**
+ * Set how long hole punching runs alone before the relay joins the race
+ *
+ * @param ctx           Connection context
+ * @param stagger_ms    Head start (0 = start both at once)
+ */
+CYXCHAT_API void cyxchat_conn_set_relay_stagger(cyxchat_conn_ctx_t *ctx, uint32_t stagger_ms);
+
 /**
  * Get number of active relay connections
  */
 CYXCHAT_API size_t cyxchat_conn_relay_count(cyxchat_conn_ctx_t *ctx);
 
+/**
+ * Set the peer table limit
+ * The table grows on demand; once at the limit, the longest-idle
+ * disconnected peer is recycled before CYXCHAT_ERR_FULL is returned.
+ *
+ * @param ctx           Connection context
+ * @param max_peers     Max tracked peers (0 = unlimited)
+ * @return CYXCHAT_OK, or CYXCHAT_ERR_INVALID if below the current count
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_set_max_peers(
+    cyxchat_conn_ctx_t *ctx,
+    size_t max_peers
+);
+
+/**
+ * Get number of tracked peers (any state)
+ */
+CYXCHAT_API size_t cyxchat_conn_peer_count(cyxchat_conn_ctx_t *ctx);
+
 /**
  * Force relay for specific peer (for testing or known symmetric NAT)
  */
@@ -318,6 +703,110 @@ CYXCHAT_API cyxchat_error_t cyxchat_conn_force_relay(
     const cyxwiz_node_id_t *peer_id
 );
 
+/* ============================================================
+ * Label-Switched Paths
+ * ============================================================ */
+
+/**
+ * Label data callback
+ * Payload that arrived at the end of a label-switched path.
+ */
+typedef void (*cyxchat_conn_label_data_callback_t)(
+    cyxchat_conn_ctx_t *ctx,
+    uint16_t label,                     /* Our label for the path */
+    const cyxwiz_node_id_t *prev_hop,   /* Neighbour that delivered it */
+    const uint8_t *data,
+    size_t len,
+    void *user_data
+);
+
+/**
+ * Set up a label-switched path
+ *
+ * The path is built one hop at a time: we agree a key with hops[0],
+ * then ask the end of the path to extend it to the next hop, so each
+ * hop only learns its two neighbours. Each key is bound to the hop's
+ * node ID, so a node in between cannot answer in its place. Data then
+ * carries one layer per hop, CYXCHAT_LABEL_OVERHEAD(hop_count) bytes
+ * in all, and looks different on every link. Hops without a signing
+ * key (cyxchat_conn_set_signing_key) refuse.
+ *
+ * @param ctx           Connection context
+ * @param hops          Route; hops[0] must be a connected peer
+ * @param hop_count     Route length, 1 to CYXCHAT_LABEL_MAX_HOPS
+ * @param callback      Setup result, and an error if the path later breaks
+ * @param user_data     User data
+ * @param handle_out    Output: path handle (valid once callback reports OK)
+ * @return CYXCHAT_OK if the request was sent, CYXCHAT_ERR_NOT_FOUND if
+ *         hops[0] is not connected, CYXCHAT_ERR_FULL if no label or
+ *         path slot is free
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_label_path(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *hops,
+    size_t hop_count,
+    cyxchat_label_path_callback_t callback,
+    void *user_data,
+    uint16_t *handle_out
+);
+
+/**
+ * Send data on a label-switched path
+ *
+ * @param ctx           Connection context
+ * @param handle        Path handle
+ * @param data          Payload
+ * @param len           Payload length
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND if the path is not up,
+ *         CYXCHAT_ERR_INVALID if too long for one datagram
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_label_send(
+    cyxchat_conn_ctx_t *ctx,
+    uint16_t handle,
+    const uint8_t *data,
+    size_t len
+);
+
+/**
+ * Tear down a label-switched path we set up
+ * The callback is not called.
+ *
+ * @param ctx           Connection context
+ * @param handle        Path handle
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND if unknown
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_label_release(
+    cyxchat_conn_ctx_t *ctx,
+    uint16_t handle
+);
+
+/**
+ * Give the connection our signing key, so we can serve as a path hop
+ * Its X25519 twin answers label handshakes and proves our node ID.
+ *
+ * @param ctx           Connection context
+ * @param signing_key   Ed25519 secret key (64 bytes) behind our node ID
+ * @return CYXCHAT_OK, CYXCHAT_ERR_CRYPTO if it cannot be converted
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_conn_set_signing_key(
+    cyxchat_conn_ctx_t *ctx,
+    const uint8_t *signing_key
+);
+
+/**
+ * Set the label data callback (paths that end here)
+ */
+CYXCHAT_API void cyxchat_conn_set_on_label_data(
+    cyxchat_conn_ctx_t *ctx,
+    cyxchat_conn_label_data_callback_t callback,
+    void *user_data
+);
+
+/**
+ * Get number of labels in use (ours, transit and delivered)
+ */
+CYXCHAT_API size_t cyxchat_conn_label_count(cyxchat_conn_ctx_t *ctx);
+
 /* ============================================================
  * Access to Underlying Transport
  * ============================================================ */
@@ -470,6 +959,9 @@ CYXCHAT_API int cyxchat_conn_dht_is_ready(cyxchat_conn_ctx_t *ctx);
  *
  * This allows manually adding a peer when automatic discovery isn't available.
  * The peer will be added to the peer table and a discovery message sent.
+ * Each call adds the address to the peer's candidates, so a peer known
+ * by several addresses (LAN and public) can be given all of them and
+ * the path checks pick the fastest.
  *
  * @param ctx       Connection context
  * @param node_id   Peer's 32-byte node ID
@@ -7,6 +7,7 @@
 #define CYXCHAT_CONTACT_H
 
 #include "types.h"
+#include "config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +42,15 @@ CYXCHAT_API cyxchat_error_t cyxchat_contact_list_create(
     cyxchat_contact_list_t **list
 );
 
+/**
+ * Create contact list holding config->max_contacts entries
+ * NULL config uses cyxchat_config_default().
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_contact_list_create_with_config(
+    cyxchat_contact_list_t **list,
+    const cyxchat_config_t *config
+);
+
 /**
  * Destroy contact list
  */
@@ -15,6 +15,9 @@
 /* Core types and constants */
 #include "types.h"
 
+/* Capacities and context layout */
+#include "config.h"
+
 /* Chat API (direct messaging) */
 #include "chat.h"
 
@@ -36,6 +39,27 @@
 /* Mail (CyxMail) */
 #include "mail.h"
 
+/* Duplicate suppression */
+#include "dedup.h"
+
+/* Buffered random pool */
+#include "rng.h"
+
+/* Log gating and trace ring */
+#include "trace.h"
+
+/* Counters and latency histograms */
+#include "metrics.h"
+
+/* Timer wheel */
+#include "timer.h"
+
+/* Label-switched forwarding */
+#include "label.h"
+
+/* Store-and-forward mailboxes */
+#include "offline.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
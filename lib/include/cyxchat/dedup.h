@@ -0,0 +1,130 @@
+/**
+ * CyxChat Duplicate Suppression API
+ * Per-peer seen-set of recent message IDs for the receive path
+ */
+
+#ifndef CYXCHAT_DEDUP_H
+#define CYXCHAT_DEDUP_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_DEDUP_MAX_PEERS     64      /* Tracked peers (LRU evicted) */
+#define CYXCHAT_DEDUP_WAYS          4       /* Slots probed per peer lookup */
+#define CYXCHAT_DEDUP_GENERATION    64      /* IDs per filter generation */
+#define CYXCHAT_DEDUP_WINDOW        (CYXCHAT_DEDUP_GENERATION * 2)
+#define CYXCHAT_DEDUP_BLOOM_BITS    512     /* Bits per generation filter */
+#define CYXCHAT_DEDUP_SEQ_WINDOW    64      /* Sequence numbers remembered */
+#define CYXCHAT_DEDUP_SEQ_RESYNC    (1u << 20)  /* Fall-back read as a restart */
+
+/* ============================================================
+ * Dedup Context
+ * ============================================================ */
+
+typedef struct cyxchat_dedup_ctx cyxchat_dedup_ctx_t;
+
+/* Statistics */
+typedef struct {
+    uint64_t checked;                   /* IDs checked */
+    uint64_t duplicates;                /* IDs dropped as duplicates */
+    uint64_t false_positives;           /* Filter hits cleared by window */
+    uint64_t peer_evictions;            /* Peer slots recycled */
+} cyxchat_dedup_stats_t;
+
+/**
+ * Create duplicate suppression context
+ *
+ * @param ctx           Output context
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_dedup_create(cyxchat_dedup_ctx_t **ctx);
+
+/**
+ * Destroy duplicate suppression context
+ *
+ * @param ctx           Context to destroy
+ */
+CYXCHAT_API void cyxchat_dedup_destroy(cyxchat_dedup_ctx_t *ctx);
+
+/**
+ * Check a message ID and record it as seen
+ *
+ * Each peer keeps the last CYXCHAT_DEDUP_WINDOW IDs. Two rotating
+ * bloom generations answer "not seen" in O(1); a filter hit is
+ * confirmed against the exact window so false positives never drop
+ * a message.
+ *
+ * @param ctx           Dedup context
+ * @param from          Sending peer
+ * @param msg_id        Message ID from the wire header
+ * @param sub_id        Sub-key (fragment index), 0 for whole messages
+ * @return 1 if duplicate (drop), 0 if new (recorded)
+ */
+CYXCHAT_API int cyxchat_dedup_check(
+    cyxchat_dedup_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const cyxchat_msg_id_t *msg_id,
+    uint8_t sub_id
+);
+
+/**
+ * Forget all IDs seen from a peer
+ *
+ * @param ctx           Dedup context
+ * @param from          Peer to forget
+ */
+CYXCHAT_API void cyxchat_dedup_forget_peer(
+    cyxchat_dedup_ctx_t *ctx,
+    const cyxwiz_node_id_t *from
+);
+
+/**
+ * Get dedup statistics
+ *
+ * @param ctx           Dedup context
+ * @param stats_out     Output statistics
+ */
+CYXCHAT_API void cyxchat_dedup_get_stats(
+    cyxchat_dedup_ctx_t *ctx,
+    cyxchat_dedup_stats_t *stats_out
+);
+
+/* ============================================================
+ * Sequence Window
+ * ============================================================ */
+
+/* Sliding window over one sender's sequence numbers (zero to reset) */
+typedef struct {
+    uint32_t top;                       /* Highest sequence accepted */
+    uint64_t seen;                      /* Bit n: top - n accepted */
+    int started;
+} cyxchat_dedup_seq_t;
+
+/**
+ * Check a sequence number and record it as seen
+ *
+ * The first number starts the window. A number ahead of it slides the
+ * window up (a jump of CYXCHAT_DEDUP_SEQ_WINDOW or more clears it);
+ * one within CYXCHAT_DEDUP_SEQ_WINDOW behind is looked up; one further
+ * behind is taken as a copy delivered long ago. Only a fall-back of
+ * CYXCHAT_DEDUP_SEQ_RESYNC or more, a sender that restarted from a new
+ * random start, restarts the window.
+ *
+ * @param win           Window
+ * @param seq           Sequence number from the wire
+ * @return 1 if duplicate (drop), 0 if new (recorded)
+ */
+CYXCHAT_API int cyxchat_dedup_seq_check(cyxchat_dedup_seq_t *win, uint32_t seq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_DEDUP_H */
@@ -0,0 +1,103 @@
+/**
+ * CyxChat Dispatch API
+ * Message type to handler table for received datagrams
+ */
+
+#ifndef CYXCHAT_DISPATCH_H
+#define CYXCHAT_DISPATCH_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_DISPATCH_TYPES      256     /* One entry per first byte */
+
+/* Registration flags */
+#define CYXCHAT_DISPATCH_LINK       0x01    /* Link frame: not peer traffic */
+
+/* ============================================================
+ * Dispatch Table
+ * ============================================================ */
+
+/**
+ * Message handler
+ *
+ * @param user_data     Registration user data
+ * @param from          Sender (the relay server for relay frames)
+ * @param data          Message, type byte first
+ * @param len           Message length (at least 1)
+ * @param via_relay     1 if it arrived inside a relay session
+ */
+typedef void (*cyxchat_dispatch_fn)(
+    void *user_data,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len,
+    int via_relay
+);
+
+typedef struct {
+    cyxchat_dispatch_fn fn;             /* NULL = unclaimed */
+    void *user_data;
+    uint32_t flags;
+} cyxchat_dispatch_entry_t;
+
+typedef struct {
+    cyxchat_dispatch_entry_t entries[CYXCHAT_DISPATCH_TYPES];
+} cyxchat_dispatch_t;
+
+/**
+ * Clear the table (every type unclaimed)
+ *
+ * @param d             Table
+ */
+CYXCHAT_API void cyxchat_dispatch_init(cyxchat_dispatch_t *d);
+
+/**
+ * Claim a range of message types
+ *
+ * Protocols own disjoint ranges; a range that overlaps one already
+ * claimed is refused whole, so two modules can never both see a type.
+ *
+ * @param d             Table
+ * @param first         First type
+ * @param last          Last type (inclusive)
+ * @param flags         CYXCHAT_DISPATCH_* flags
+ * @param fn            Handler
+ * @param user_data     Handler user data
+ * @return CYXCHAT_OK, CYXCHAT_ERR_EXISTS on overlap,
+ *         CYXCHAT_ERR_INVALID if first > last
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_dispatch_register(
+    cyxchat_dispatch_t *d,
+    uint8_t first,
+    uint8_t last,
+    uint32_t flags,
+    cyxchat_dispatch_fn fn,
+    void *user_data
+);
+
+/**
+ * Release a range of message types
+ *
+ * @param d             Table
+ * @param first         First type
+ * @param last          Last type (inclusive)
+ */
+CYXCHAT_API void cyxchat_dispatch_unregister(
+    cyxchat_dispatch_t *d,
+    uint8_t first,
+    uint8_t last
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_DISPATCH_H */
@@ -12,6 +12,8 @@
 #define CYXCHAT_DNS_H
 
 #include "types.h"
+#include "timer.h"
+#include "config.h"
 #include <cyxwiz/routing.h>
 #include <cyxwiz/transport.h>
 #include <cyxwiz/peer.h>
@@ -26,7 +28,7 @@ extern "C" {
 
 #define CYXCHAT_DNS_MAX_NAME        63      /* Max name length (without .cyx) */
 #define CYXCHAT_DNS_SUFFIX          ".cyx"  /* Name suffix */
-#define CYXCHAT_DNS_CACHE_SIZE      128     /* Max cached records */
+#define CYXCHAT_DNS_CACHE_SIZE      128     /* Default cached records */
 #define CYXCHAT_DNS_DEFAULT_TTL     3600    /* 1 hour in seconds */
 #define CYXCHAT_DNS_REFRESH_INTERVAL 1800   /* 30 min refresh */
 #define CYXCHAT_DNS_GOSSIP_HOPS     3       /* Max re-broadcast depth */
@@ -109,6 +111,24 @@ CYXCHAT_API cyxchat_error_t cyxchat_dns_create(
     const uint8_t *signing_key
 );
 
+/**
+ * Create DNS context with a config->dns_cache_size entry cache
+ *
+ * @param ctx_out      Output: created context
+ * @param router       CyxWiz router for messaging (can be NULL if using transport)
+ * @param local_id     Our node ID
+ * @param signing_key  Our Ed25519 signing key (64 bytes, secret+public)
+ * @param config       Capacities (NULL for cyxchat_config_default)
+ * @return             CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_dns_create_with_config(
+    cyxchat_dns_ctx_t **ctx_out,
+    cyxwiz_router_t *router,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+);
+
 /**
  * Set transport for DNS messaging (alternative to router)
  *
@@ -144,6 +164,29 @@ CYXCHAT_API cyxchat_error_t cyxchat_dns_poll(
     uint64_t now_ms
 );
 
+/**
+ * Schedule DNS timers on a shared wheel
+ * Lookup timeouts, refresh and cache expiry move across with their
+ * remaining delay. While attached, cyxchat_dns_poll() leaves advancing
+ * to the wheel owner. Detach before the wheel is destroyed.
+ *
+ * @param ctx      DNS context
+ * @param wheel    Shared wheel (e.g. cyxchat_conn_get_timer_wheel()),
+ *                 or NULL to return to the private one
+ */
+CYXCHAT_API void cyxchat_dns_set_timer_wheel(
+    cyxchat_dns_ctx_t *ctx,
+    cyxchat_timer_wheel_t *wheel
+);
+
+/**
+ * Get earliest DNS timer deadline
+ *
+ * @param ctx      DNS context
+ * @return         Absolute time in ms, or CYXCHAT_TIMER_NONE
+ */
+CYXCHAT_API uint64_t cyxchat_dns_next_deadline(cyxchat_dns_ctx_t *ctx);
+
 /* ============================================================
  * Name Registration
  * ============================================================ */
@@ -12,8 +12,9 @@
 extern "C" {
 #endif
 
-/* Forward declaration */
+/* Forward declarations */
 typedef struct cyxchat_ctx cyxchat_ctx_t;
+typedef struct cyxchat_conn_ctx cyxchat_conn_ctx_t;
 
 /* ============================================================
  * File Transfer State
@@ -216,6 +217,19 @@ CYXCHAT_API cyxchat_error_t cyxchat_file_ctx_create(
 
 CYXCHAT_API void cyxchat_file_ctx_destroy(cyxchat_file_ctx_t *ctx);
 
+/**
+ * Pace outgoing chunks by the peer's queueing delay
+ *
+ * Without a connection context chunks go out every 500 ms. With one,
+ * each sending transfer runs a delay-based controller (see congestion.h)
+ * fed by the connection layer's echo probes to the recipient, and backs
+ * off when bulk data starts queueing in front of interactive traffic.
+ *
+ * @param ctx           File context
+ * @param conn          Connection context, or NULL to detach
+ */
+CYXCHAT_API void cyxchat_file_set_conn(cyxchat_file_ctx_t *ctx, cyxchat_conn_ctx_t *conn);
+
 CYXCHAT_API int cyxchat_file_poll(cyxchat_file_ctx_t *ctx, uint64_t now_ms);
 
 /* ============================================================
@@ -141,6 +141,13 @@ CYXCHAT_API cyxchat_error_t cyxchat_group_ctx_create(
     cyxchat_ctx_t *chat_ctx
 );
 
+/* Same, holding config->max_groups groups (NULL config for defaults) */
+CYXCHAT_API cyxchat_error_t cyxchat_group_ctx_create_with_config(
+    cyxchat_group_ctx_t **ctx,
+    cyxchat_ctx_t *chat_ctx,
+    const cyxchat_config_t *config
+);
+
 CYXCHAT_API void cyxchat_group_ctx_destroy(cyxchat_group_ctx_t *ctx);
 
 CYXCHAT_API int cyxchat_group_poll(cyxchat_group_ctx_t *ctx, uint64_t now_ms);
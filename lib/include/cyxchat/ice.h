@@ -0,0 +1,171 @@
+/**
+ * CyxChat ICE-lite API
+ * Peer address candidates, connectivity check list and path selection
+ */
+
+#ifndef CYXCHAT_ICE_H
+#define CYXCHAT_ICE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_ICE_MAX_CANDIDATES  8       /* Remote candidates per peer */
+#define CYXCHAT_ICE_CHECK_TIMEOUT_MS 500    /* Wait for a check reply */
+#define CYXCHAT_ICE_RECHECK_MS      30000   /* Background re-check interval */
+#define CYXCHAT_ICE_MIGRATE_MIN_MS  5       /* Smallest RTT gain worth a move */
+#define CYXCHAT_ICE_RTT_NONE        0xFFFFFFFFu
+
+/* Encoded size of one candidate on the wire */
+#define CYXCHAT_ICE_WIRE_SIZE       7
+
+/* ============================================================
+ * Candidates
+ * ============================================================ */
+
+typedef enum {
+    CYXCHAT_ICE_HOST = 0,               /* Local interface address */
+    CYXCHAT_ICE_SRFLX = 1,              /* STUN mapped (server reflexive) */
+    CYXCHAT_ICE_RELAY = 2               /* Relay server (not checked) */
+} cyxchat_ice_type_t;
+
+typedef struct {
+    uint8_t type;                       /* cyxchat_ice_type_t */
+    uint32_t ip;                        /* Network byte order */
+    uint16_t port;                      /* Network byte order */
+} cyxchat_ice_candidate_t;
+
+/*
+ * Check list for one peer. Checks run one candidate at a time; the
+ * caller sends, then reports the measured RTT (or CYXCHAT_ICE_RTT_NONE)
+ * with cyxchat_ice_record.
+ */
+typedef struct {
+    cyxchat_ice_candidate_t cand[CYXCHAT_ICE_MAX_CANDIDATES];
+    uint32_t rtt_ms[CYXCHAT_ICE_MAX_CANDIDATES];    /* Last result */
+    uint8_t count;
+    int8_t selected;                    /* In use, -1 = none */
+    int8_t checking;                    /* Under check, -1 = idle */
+    uint32_t tag;                       /* Outstanding check tag */
+    uint64_t sent_at;                   /* When the check went out */
+} cyxchat_ice_checklist_t;
+
+/**
+ * Candidate priority (host > srflx > relay, RFC 8445 type preferences)
+ *
+ * @param cand          Candidate
+ * @return Priority, higher is preferred
+ */
+CYXCHAT_API uint32_t cyxchat_ice_priority(const cyxchat_ice_candidate_t *cand);
+
+/**
+ * Reset a check list
+ *
+ * @param cl            Check list
+ */
+CYXCHAT_API void cyxchat_ice_init(cyxchat_ice_checklist_t *cl);
+
+/**
+ * Add a remote candidate
+ *
+ * Duplicates keep their results. When full, the lowest-priority
+ * candidate that is neither selected nor under check is replaced if the
+ * new one has higher priority.
+ *
+ * @param cl            Check list
+ * @param cand          Candidate
+ * @return Index, or -1 if not added
+ */
+CYXCHAT_API int cyxchat_ice_add(cyxchat_ice_checklist_t *cl, const cyxchat_ice_candidate_t *cand);
+
+/**
+ * Next candidate to check after index (relay candidates are skipped)
+ *
+ * @param cl            Check list
+ * @param after         Previous index, or -1 to start a round
+ * @return Index, or -1 when the round is done
+ */
+CYXCHAT_API int cyxchat_ice_next_check(const cyxchat_ice_checklist_t *cl, int after);
+
+/**
+ * Record a check result
+ *
+ * @param cl            Check list
+ * @param index         Candidate index
+ * @param rtt_ms        Round trip, or CYXCHAT_ICE_RTT_NONE on failure
+ */
+CYXCHAT_API void cyxchat_ice_record(cyxchat_ice_checklist_t *cl, int index, uint32_t rtt_ms);
+
+/**
+ * Pick the path after a round
+ *
+ * Starting from the selected candidate (if it still answered) or the
+ * first working one in check order, a candidate only takes over when it
+ * is faster by CYXCHAT_ICE_MIGRATE_MIN_MS or an eighth of the RTT,
+ * whichever is larger. Jitter does not flap the path, and a check whose
+ * punch was lost (it measures the previous path) never wins.
+ *
+ * @param cl            Check list
+ * @return Selected index (-1 if nothing works)
+ */
+CYXCHAT_API int cyxchat_ice_select(cyxchat_ice_checklist_t *cl);
+
+/**
+ * Encode candidates for the wire
+ *
+ * @param cands         Candidates
+ * @param count         Number of candidates
+ * @param buf           Output buffer
+ * @param buf_size      Buffer size
+ * @return Bytes written (count byte plus entries), 0 if too small
+ */
+CYXCHAT_API size_t cyxchat_ice_encode(
+    const cyxchat_ice_candidate_t *cands,
+    size_t count,
+    uint8_t *buf,
+    size_t buf_size
+);
+
+/**
+ * Decode candidates from the wire
+ *
+ * @param buf           Encoded candidates (count byte first)
+ * @param len           Length
+ * @param out           Output candidates
+ * @param max           Capacity of out
+ * @return Number decoded, or -1 if malformed
+ */
+CYXCHAT_API int cyxchat_ice_decode(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_ice_candidate_t *out,
+    size_t max
+);
+
+/**
+ * Gather host candidates from local IPv4 interfaces
+ *
+ * Loopback and link-local addresses are skipped.
+ *
+ * @param out           Output candidates
+ * @param max           Capacity of out
+ * @param port          Transport port (network byte order)
+ * @return Number gathered
+ */
+CYXCHAT_API size_t cyxchat_ice_gather_host(
+    cyxchat_ice_candidate_t *out,
+    size_t max,
+    uint16_t port
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_ICE_H */
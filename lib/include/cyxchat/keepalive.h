@@ -0,0 +1,84 @@
+/**
+ * CyxChat Keepalive API
+ * NAT binding lifetime search and the keepalive interval derived from it
+ */
+
+#ifndef CYXCHAT_KEEPALIVE_H
+#define CYXCHAT_KEEPALIVE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_KEEPALIVE_MIN_MS        10000   /* Shortest interval used */
+#define CYXCHAT_KEEPALIVE_MAX_MS        60000   /* Longest (peers time out at 90 s) */
+#define CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS 20000  /* First idle period tested */
+#define CYXCHAT_KEEPALIVE_RESOLUTION_MS 5000    /* Search stops at this gap */
+#define CYXCHAT_KEEPALIVE_MARGIN_PCT    80      /* Interval as share of lifetime */
+#define CYXCHAT_KEEPALIVE_JITTER_PCT    10      /* Window shortened by up to */
+
+/* ============================================================
+ * Binding Lifetime Search
+ * ============================================================ */
+
+typedef struct {
+    uint32_t alive_ms;                  /* Longest idle the binding survived */
+    uint32_t dead_ms;                   /* Shortest idle that lost it (0 = none) */
+    uint32_t trial_ms;                  /* Idle to test next (0 = search over) */
+    uint32_t interval_ms;               /* Keepalive interval in effect */
+    uint32_t trials;
+    int unsupported;                    /* STUN server cannot run the test */
+} cyxchat_keepalive_t;
+
+/**
+ * Reset the search (interval back to CYXCHAT_KEEPALIVE_INTERVAL_MS)
+ *
+ * @param ka            Search state
+ */
+CYXCHAT_API void cyxchat_keepalive_init(cyxchat_keepalive_t *ka);
+
+/**
+ * Record whether the binding survived trial_ms of idle
+ *
+ * The trial doubles while the binding survives, then bisects between
+ * the longest survived and shortest lost idle until they are within
+ * CYXCHAT_KEEPALIVE_RESOLUTION_MS, or until a binding outlives what
+ * CYXCHAT_KEEPALIVE_MAX_MS needs. The interval moves as soon as a
+ * result proves it safe: up to CYXCHAT_KEEPALIVE_MARGIN_PCT of a
+ * survived idle, down to that share of a lost one.
+ *
+ * @param ka            Search state
+ * @param alive         Binding answered after the idle period
+ */
+CYXCHAT_API void cyxchat_keepalive_on_trial(cyxchat_keepalive_t *ka, int alive);
+
+/**
+ * Stop the search and keep the current interval
+ *
+ * @param ka            Search state
+ */
+CYXCHAT_API void cyxchat_keepalive_unsupported(cyxchat_keepalive_t *ka);
+
+/**
+ * Length of the next keepalive window
+ *
+ * The interval less up to CYXCHAT_KEEPALIVE_JITTER_PCT, so clients
+ * behind one NAT do not fall into step.
+ *
+ * @param ka            Search state
+ * @param random        Random value picking the jitter
+ * @return Milliseconds until the next window
+ */
+CYXCHAT_API uint32_t cyxchat_keepalive_window_ms(const cyxchat_keepalive_t *ka, uint32_t random);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_KEEPALIVE_H */
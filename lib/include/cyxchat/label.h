@@ -0,0 +1,562 @@
+/**
+ * CyxChat Label Switching API
+ * Short labels for forwarding over established peer connections
+ *
+ * A label-switched path is built one hop at a time, the way an onion
+ * circuit is: the ingress agrees a key with the first hop, then asks
+ * the end of the path to extend it, so each hop only learns its two
+ * neighbours. Data then travels under 2-byte labels with one sealed
+ * layer per hop; each hop looks the label up, opens its layer and
+ * sends the rest on under the next hop's label. See docs/LABELS.md.
+ */
+
+#ifndef CYXCHAT_LABEL_H
+#define CYXCHAT_LABEL_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_LABEL_TABLE_SIZE    256     /* Default entries per connection context */
+#define CYXCHAT_LABEL_TABLE_MAX     4096    /* Largest table (leaves 4 random label bits) */
+#define CYXCHAT_LABEL_MAX_HOPS      7       /* Hops in a path */
+#define CYXCHAT_LABEL_CIRCUITS      16      /* Paths built from one table at a time */
+
+#define CYXCHAT_LABEL_KEY_SIZE      32
+#define CYXCHAT_LABEL_AUTH_SIZE     16      /* Handshake confirmation */
+#define CYXCHAT_LABEL_MAC_SIZE      8
+#define CYXCHAT_LABEL_SEQ_SIZE      2
+#define CYXCHAT_LABEL_HEADER_SIZE   3       /* Type + label */
+#define CYXCHAT_LABEL_LAYER_SIZE    (CYXCHAT_LABEL_SEQ_SIZE + CYXCHAT_LABEL_MAC_SIZE)
+#define CYXCHAT_LABEL_OVERHEAD(hops) \
+    (CYXCHAT_LABEL_HEADER_SIZE + 1 + (hops) * CYXCHAT_LABEL_LAYER_SIZE)
+#define CYXCHAT_LABEL_WINDOW        64      /* Replay window (sequence numbers) */
+
+/* Command byte in the innermost layer, read by the end of the path */
+#define CYXCHAT_LABEL_CMD_DATA      0x00    /* Payload for the application */
+#define CYXCHAT_LABEL_CMD_EXTEND    0x01    /* Add a hop after us */
+#define CYXCHAT_LABEL_CMD_EXTENDED  0x02    /* New hop's answer, toward the ingress */
+
+#define CYXCHAT_LABEL_SETUP_MS      5000    /* Reserved label waits for its mapping */
+#define CYXCHAT_LABEL_IDLE_MS       60000   /* Active label unused this long is torn down */
+#define CYXCHAT_LABEL_GRACE_MS      5000    /* Expiring label before it is freed */
+#define CYXCHAT_LABEL_REUSE_MS      5000    /* Freed slot rests at least this long */
+#define CYXCHAT_LABEL_REUSE_JITTER  10000   /* Plus up to this much at random */
+#define CYXCHAT_LABEL_SWEEP_MS      1000    /* Lifecycle check interval */
+
+/* Encoded sizes */
+#define CYXCHAT_LABEL_REQUEST_SIZE  37      /* Type + req_id + key */
+#define CYXCHAT_LABEL_MAPPING_SIZE  55      /* Type + req_id + label + key + auth */
+#define CYXCHAT_LABEL_EXTEND_SIZE   69      /* Command + next hop + req_id + key */
+#define CYXCHAT_LABEL_EXTENDED_SIZE 53      /* Command + req_id + key + auth */
+#define CYXCHAT_LABEL_NOTICE_SIZE   3       /* Release/withdraw: type + label */
+
+/* ============================================================
+ * Label Entries
+ * ============================================================ */
+
+typedef enum {
+    CYXCHAT_LABEL_FREE = 0,             /* Unused (may be resting before reuse) */
+    CYXCHAT_LABEL_RESERVED,             /* Waiting for the next hop's answer */
+    CYXCHAT_LABEL_ACTIVE,               /* Forwarding */
+    CYXCHAT_LABEL_EXPIRING              /* Torn down, rejecting data until freed */
+} cyxchat_label_state_t;
+
+typedef enum {
+    CYXCHAT_LABEL_INGRESS = 0,          /* Path we built (label is the handle) */
+    CYXCHAT_LABEL_TRANSIT,              /* Open our layer and forward */
+    CYXCHAT_LABEL_EGRESS                /* End of the path: deliver or extend */
+} cyxchat_label_role_t;
+
+/**
+ * Path result for an ingress label: setup, then a later break
+ *
+ * @param handle        Ingress label
+ * @param result        CYXCHAT_OK when established; otherwise the
+ *                      path was refused, timed out or went down
+ * @param user_data     User data
+ */
+typedef void (*cyxchat_label_path_callback_t)(
+    uint16_t handle,
+    cyxchat_error_t result,
+    void *user_data
+);
+
+/* Ingress side of a path: the route and a key per hop */
+typedef struct cyxchat_label_circuit {
+    uint8_t hop_count;                  /* Hops with a key so far */
+    uint8_t route_len;
+    cyxwiz_node_id_t route[CYXCHAT_LABEL_MAX_HOPS];
+    uint8_t keys[CYXCHAT_LABEL_MAX_HOPS][CYXCHAT_LABEL_KEY_SIZE];
+    uint32_t send_seq[CYXCHAT_LABEL_MAX_HOPS];  /* Random start per hop */
+    uint8_t eph_secret[CYXCHAT_LABEL_KEY_SIZE]; /* Handshake with route[hop_count] */
+    int in_use;
+} cyxchat_label_circuit_t;
+
+typedef struct cyxchat_label_entry {
+    uint16_t label_in;                  /* Ours: the index and random bits */
+    uint16_t label_out;                 /* Next hop's, 0 at the egress */
+    uint8_t state;                      /* cyxchat_label_state_t */
+    uint8_t role;                       /* cyxchat_label_role_t */
+    uint32_t down_req;                  /* Handshake we wait on (ingress, extending) */
+    cyxwiz_node_id_t prev_hop;          /* Sender of our label (not at ingress) */
+    cyxwiz_node_id_t next_hop;          /* Receiver of label_out (not at egress) */
+    uint8_t key_in[CYXCHAT_LABEL_KEY_SIZE];     /* Shared with the ingress */
+    cyxchat_label_circuit_t *circuit;   /* Ingress only */
+    uint32_t send_seq;                  /* Toward the ingress */
+    uint32_t recv_seq;                  /* Highest accepted */
+    uint64_t recv_window;               /* Bit n: recv_seq - n seen */
+    int recv_any;                       /* recv_seq is meaningful */
+    uint64_t last_used;
+    uint64_t deadline;                  /* Setup/grace end, or reuse time when free */
+    cyxchat_label_path_callback_t callback;     /* Ingress only */
+    void *user_data;
+} cyxchat_label_entry_t;
+
+typedef struct cyxchat_label_table cyxchat_label_table_t;
+
+/* ============================================================
+ * Setup Messages
+ * ============================================================ */
+
+/* CYXCHAT_MSG_LABEL_REQUEST: give me a label keyed with the ingress */
+typedef struct {
+    uint32_t req_id;
+    uint8_t eph_public[CYXCHAT_LABEL_KEY_SIZE];     /* The ingress's */
+} cyxchat_label_request_t;
+
+/* CYXCHAT_MSG_LABEL_MAPPING: label to use (0 = refused) and key half */
+typedef struct {
+    uint32_t req_id;
+    uint16_t label;
+    uint8_t eph_public[CYXCHAT_LABEL_KEY_SIZE];
+    uint8_t auth[CYXCHAT_LABEL_AUTH_SIZE];
+} cyxchat_label_mapping_t;
+
+/* CYXCHAT_LABEL_CMD_EXTEND: request next_hop's label for the ingress */
+typedef struct {
+    cyxwiz_node_id_t next_hop;
+    uint32_t req_id;
+    uint8_t eph_public[CYXCHAT_LABEL_KEY_SIZE];
+} cyxchat_label_extend_t;
+
+/* ============================================================
+ * Table
+ * ============================================================ */
+
+/**
+ * Create a label table
+ *
+ * @param table         Output table
+ * @param capacity      Entries, a power of two from 2 to CYXCHAT_LABEL_TABLE_MAX
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad capacity
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_table_create(
+    cyxchat_label_table_t **table,
+    size_t capacity
+);
+
+/**
+ * Destroy a label table (keys are wiped)
+ *
+ * @param table         Table
+ */
+CYXCHAT_API void cyxchat_label_table_destroy(cyxchat_label_table_t *table);
+
+/**
+ * Reserve a label
+ * The label's low bits index the slot and the rest are random, so it
+ * can neither be guessed from earlier labels nor collide with a label
+ * that is still resting.
+ *
+ * @param table         Table
+ * @param now_ms        Current time
+ * @return Zeroed entry in RESERVED state with label_in set, NULL if full
+ */
+CYXCHAT_API cyxchat_label_entry_t* cyxchat_label_alloc(
+    cyxchat_label_table_t *table,
+    uint64_t now_ms
+);
+
+/**
+ * Find the entry holding a label
+ *
+ * @param table         Table
+ * @param label         Label
+ * @return Entry, NULL if free or unknown
+ */
+CYXCHAT_API cyxchat_label_entry_t* cyxchat_label_lookup(
+    cyxchat_label_table_t *table,
+    uint16_t label
+);
+
+/**
+ * Free an entry
+ * Keys are wiped, an ingress's circuit is released, and the slot
+ * rests for CYXCHAT_LABEL_REUSE_MS plus jitter, so stray packets for
+ * the old path cannot reach a new one.
+ *
+ * @param table         Table
+ * @param entry         Entry
+ * @param now_ms        Current time
+ */
+CYXCHAT_API void cyxchat_label_free(
+    cyxchat_label_table_t *table,
+    cyxchat_label_entry_t *entry,
+    uint64_t now_ms
+);
+
+/**
+ * Get the entry in a slot (for sweeps)
+ *
+ * @param table         Table
+ * @param index         Slot, below cyxchat_label_capacity
+ * @return Entry (check its state), NULL if out of range
+ */
+CYXCHAT_API cyxchat_label_entry_t* cyxchat_label_at(cyxchat_label_table_t *table, size_t index);
+
+/**
+ * Get the table size
+ *
+ * @param table         Table
+ * @return Slots
+ */
+CYXCHAT_API size_t cyxchat_label_capacity(const cyxchat_label_table_t *table);
+
+/**
+ * Get the number of labels in use (reserved, active or expiring)
+ *
+ * @param table         Table
+ * @return Count
+ */
+CYXCHAT_API size_t cyxchat_label_count(const cyxchat_label_table_t *table);
+
+/**
+ * Give an ingress entry its circuit
+ * cyxchat_label_free releases it with the entry.
+ *
+ * @param table         Table
+ * @param entry         Entry that will be the ingress of a path
+ * @return Zeroed circuit (also set as entry->circuit), NULL if all in use
+ */
+CYXCHAT_API cyxchat_label_circuit_t* cyxchat_label_circuit_alloc(
+    cyxchat_label_table_t *table,
+    cyxchat_label_entry_t *entry
+);
+
+/* ============================================================
+ * Keys
+ * ============================================================
+ *
+ * Each hop's key comes from a one-sided authenticated handshake: the
+ * ingress's ephemeral key meets both the hop's ephemeral key and its
+ * static X25519 key, the one behind its Ed25519 node ID. The hop
+ * proves it holds the static key with the confirmation it returns,
+ * so a node in between cannot substitute its own key half. The
+ * ingress stays anonymous to the hop.
+ */
+
+/**
+ * Make an ephemeral key pair for one handshake
+ *
+ * @param public_out    X25519 public key (32 bytes)
+ * @param secret_out    X25519 secret key (32 bytes)
+ */
+CYXCHAT_API void cyxchat_label_keypair(uint8_t *public_out, uint8_t *secret_out);
+
+/**
+ * Derive our static handshake key from our signing key
+ *
+ * @param secret_out    X25519 secret key (32 bytes)
+ * @param signing_key   Ed25519 secret key (64 bytes) of our node ID
+ * @return CYXCHAT_OK, CYXCHAT_ERR_CRYPTO if it cannot be converted
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_identity(
+    uint8_t *secret_out,
+    const uint8_t *signing_key
+);
+
+/**
+ * Answer a handshake (the hop's side)
+ *
+ * @param key_out       Key shared with the ingress (32 bytes)
+ * @param eph_public_out Our key half for the mapping (32 bytes)
+ * @param auth_out      Confirmation for the mapping (CYXCHAT_LABEL_AUTH_SIZE)
+ * @param static_secret Our static key from cyxchat_label_identity
+ * @param local_id      Our node ID
+ * @param peer_public   The ingress's ephemeral key from the request
+ * @param req_id        Setup request ID
+ * @return CYXCHAT_OK, CYXCHAT_ERR_CRYPTO for a degenerate public key
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_accept(
+    uint8_t *key_out,
+    uint8_t *eph_public_out,
+    uint8_t *auth_out,
+    const uint8_t *static_secret,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *peer_public,
+    uint32_t req_id
+);
+
+/**
+ * Finish a handshake (the ingress's side)
+ *
+ * @param key_out       Key shared with the hop (32 bytes)
+ * @param eph_secret    Our ephemeral secret from the request
+ * @param hop           Node ID we meant to reach
+ * @param hop_public    Hop's key half from the mapping
+ * @param auth          Hop's confirmation
+ * @param req_id        Setup request ID
+ * @return CYXCHAT_OK, CYXCHAT_ERR_CRYPTO if the confirmation does not
+ *         prove the hop holds the static key behind its node ID
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_complete(
+    uint8_t *key_out,
+    const uint8_t *eph_secret,
+    const cyxwiz_node_id_t *hop,
+    const uint8_t *hop_public,
+    const uint8_t *auth,
+    uint32_t req_id
+);
+
+/* ============================================================
+ * Data Path
+ * ============================================================
+ *
+ * CYXCHAT_MSG_LABEL_DATA: type, label (2), then one layer per hop,
+ * outermost first. A layer is a sequence number (2), a body encrypted
+ * with the hop's key and a MAC (8) over both. The body of a layer is
+ * the next hop's layer; the innermost body is a command byte and its
+ * payload. The MAC covers the full 32-bit sequence number, of which
+ * the wire carries the low half. Integers are little-endian.
+ *
+ * CYXCHAT_MSG_LABEL_BACK runs the other way, from a hop to the
+ * ingress: the originating hop seals one layer and every hop on the
+ * way adds its own, so the ingress peels them in path order.
+ */
+
+/**
+ * Build a data packet on an ingress entry
+ *
+ * @param entry         Ingress entry with circuit->hop_count keys
+ * @param cmd           CYXCHAT_LABEL_CMD_DATA or CYXCHAT_LABEL_CMD_EXTEND
+ * @param payload       Payload
+ * @param len           Payload length
+ * @param pkt           Output packet
+ * @param pkt_size      Output buffer size
+ * @return Packet length, 0 if the buffer is too small
+ */
+CYXCHAT_API size_t cyxchat_label_seal(
+    cyxchat_label_entry_t *entry,
+    uint8_t cmd,
+    const uint8_t *payload,
+    size_t len,
+    uint8_t *pkt,
+    size_t pkt_size
+);
+
+/**
+ * Accept a data packet and open our layer
+ * Checks the label, sender, replay window and MAC, records the
+ * sequence number and decrypts our layer in place. Its body starts at
+ * pkt + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE and is
+ * len - CYXCHAT_LABEL_HEADER_SIZE - CYXCHAT_LABEL_LAYER_SIZE bytes.
+ *
+ * @param table         Table
+ * @param from          Neighbour it came from
+ * @param pkt           Packet (our layer is decrypted in place)
+ * @param len           Packet length
+ * @param now_ms        Current time
+ * @param entry_out     Output: matching entry
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND for an unknown or
+ *         inactive label or wrong sender, CYXCHAT_ERR_CRYPTO for a bad
+ *         MAC or replay, CYXCHAT_ERR_INVALID for a short packet
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_open(
+    cyxchat_label_table_t *table,
+    const cyxwiz_node_id_t *from,
+    uint8_t *pkt,
+    size_t len,
+    uint64_t now_ms,
+    cyxchat_label_entry_t **entry_out
+);
+
+/**
+ * Rewrite an opened packet for the next hop
+ * Drops our layer and puts label_out in front of the next one.
+ *
+ * @param entry         Transit entry from cyxchat_label_open
+ * @param pkt           Packet (modified in place)
+ * @param len           Packet length
+ * @return New length, 0 if too short
+ */
+CYXCHAT_API size_t cyxchat_label_swap(cyxchat_label_entry_t *entry, uint8_t *pkt, size_t len);
+
+/**
+ * Wrap data for the ingress in our layer
+ * The originating hop passes its command and payload, a hop passing
+ * a packet on passes everything after the header.
+ *
+ * @param entry         Transit or egress entry
+ * @param inner         Data to wrap
+ * @param len           Data length
+ * @param pkt           Output CYXCHAT_MSG_LABEL_BACK packet
+ * @param pkt_size      Output buffer size
+ * @return Packet length, 0 if the buffer is too small
+ */
+CYXCHAT_API size_t cyxchat_label_seal_back(
+    cyxchat_label_entry_t *entry,
+    const uint8_t *inner,
+    size_t len,
+    uint8_t *pkt,
+    size_t pkt_size
+);
+
+/**
+ * Peel a packet that came back to the ingress
+ * Opens one layer per hop with a key, in path order, in place.
+ *
+ * @param entry         Ingress entry
+ * @param pkt           CYXCHAT_MSG_LABEL_BACK packet
+ * @param len           Packet length
+ * @param inner_out     Output: command and payload of the last hop
+ * @param inner_len_out Output: their length
+ * @return CYXCHAT_OK, CYXCHAT_ERR_CRYPTO if a layer fails its MAC,
+ *         CYXCHAT_ERR_INVALID if too short for the path
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_open_back(
+    const cyxchat_label_entry_t *entry,
+    uint8_t *pkt,
+    size_t len,
+    const uint8_t **inner_out,
+    size_t *inner_len_out
+);
+
+/* ============================================================
+ * Setup Encoding
+ * ============================================================ */
+
+/**
+ * Encode a label request
+ *
+ * @param req           Request
+ * @param buf           Output buffer (CYXCHAT_LABEL_REQUEST_SIZE bytes)
+ * @param buf_size      Buffer size
+ * @return Length, 0 if too small
+ */
+CYXCHAT_API size_t cyxchat_label_encode_request(
+    const cyxchat_label_request_t *req,
+    uint8_t *buf,
+    size_t buf_size
+);
+
+/**
+ * Decode a label request
+ *
+ * @param buf           Message (starting with its type byte)
+ * @param len           Message length
+ * @param req_out       Output request
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if malformed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_decode_request(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_label_request_t *req_out
+);
+
+/**
+ * Encode a label mapping
+ *
+ * @param map           Mapping
+ * @param buf           Output buffer (CYXCHAT_LABEL_MAPPING_SIZE bytes)
+ * @param buf_size      Buffer size
+ * @return Length, 0 if too small
+ */
+CYXCHAT_API size_t cyxchat_label_encode_mapping(
+    const cyxchat_label_mapping_t *map,
+    uint8_t *buf,
+    size_t buf_size
+);
+
+/**
+ * Decode a label mapping
+ *
+ * @param buf           Message (starting with its type byte)
+ * @param len           Message length
+ * @param map_out       Output mapping
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if malformed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_decode_mapping(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_label_mapping_t *map_out
+);
+
+/**
+ * Encode an extend command (innermost layer, command byte first)
+ *
+ * @param ext           Extend request
+ * @param buf           Output buffer (CYXCHAT_LABEL_EXTEND_SIZE bytes)
+ * @param buf_size      Buffer size
+ * @return Length, 0 if too small
+ */
+CYXCHAT_API size_t cyxchat_label_encode_extend(
+    const cyxchat_label_extend_t *ext,
+    uint8_t *buf,
+    size_t buf_size
+);
+
+/**
+ * Decode an extend command
+ *
+ * @param buf           Command byte and body
+ * @param len           Length
+ * @param ext_out       Output extend request
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if malformed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_decode_extend(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_label_extend_t *ext_out
+);
+
+/**
+ * Encode an extended answer: the new hop's mapping minus its label,
+ * which stays with the hop that extended
+ *
+ * @param map           New hop's mapping
+ * @param buf           Output buffer (CYXCHAT_LABEL_EXTENDED_SIZE bytes)
+ * @param buf_size      Buffer size
+ * @return Length, 0 if too small
+ */
+CYXCHAT_API size_t cyxchat_label_encode_extended(
+    const cyxchat_label_mapping_t *map,
+    uint8_t *buf,
+    size_t buf_size
+);
+
+/**
+ * Decode an extended answer (label is left 0)
+ *
+ * @param buf           Command byte and body
+ * @param len           Length
+ * @param map_out       Output mapping
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if malformed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_label_decode_extended(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_label_mapping_t *map_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_LABEL_H */
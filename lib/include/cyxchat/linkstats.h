@@ -0,0 +1,146 @@
+/**
+ * CyxChat Link Statistics API
+ * Per-peer path quality: round trip, loss and delivery rate
+ */
+
+#ifndef CYXCHAT_LINKSTATS_H
+#define CYXCHAT_LINKSTATS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_LINK_RTO_INITIAL_MS 1000    /* Before the first sample */
+#define CYXCHAT_LINK_RTO_MIN_MS     200
+#define CYXCHAT_LINK_RTO_MAX_MS     60000
+#define CYXCHAT_LINK_RATE_WINDOW_MS 1000    /* Rate sampling window */
+#define CYXCHAT_LINK_SEQ_WINDOW     64      /* Reorder window for gap counting */
+
+/* ============================================================
+ * Link Statistics
+ * ============================================================ */
+
+typedef struct {
+    /* Totals */
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+    uint64_t packets_sent;
+    uint64_t packets_received;
+    uint64_t packets_lost;              /* Sequence gaps + unanswered probes */
+
+    /* Round trip (RFC 6298 smoothing) */
+    uint32_t srtt_ms;                   /* 0 until the first sample */
+    uint32_t rttvar_ms;
+    uint32_t rto_ms;
+    uint32_t min_rtt_ms;                /* Lowest sample on this path */
+    uint32_t latest_rtt_ms;
+    uint32_t rtt_samples;
+
+    /* Loss (EWMA over packets, parts per million) */
+    uint32_t loss_ppm;
+    uint32_t probes_missed;             /* Consecutive unanswered probes */
+
+    /* Delivery rate (bytes per second, smoothed per window) */
+    uint64_t tx_rate;
+    uint64_t rx_rate;
+
+    /* Internal: sequence tracking */
+    uint32_t seq_highest;
+    uint64_t seq_seen;                  /* Bit n = seq_highest - n arrived */
+    int seq_started;
+
+    /* Internal: rate windows */
+    uint64_t tx_window_start;
+    uint64_t tx_window_bytes;
+    uint64_t rx_window_start;
+    uint64_t rx_window_bytes;
+} cyxchat_linkstats_t;
+
+/**
+ * Reset all statistics
+ *
+ * @param ls            Statistics
+ */
+CYXCHAT_API void cyxchat_linkstats_init(cyxchat_linkstats_t *ls);
+
+/**
+ * Forget path estimates after the path changed (counters are kept)
+ *
+ * Round trip, loss and sequence state start over; totals and rates stay.
+ *
+ * @param ls            Statistics
+ */
+CYXCHAT_API void cyxchat_linkstats_reset_path(cyxchat_linkstats_t *ls);
+
+/**
+ * Count a datagram sent
+ *
+ * @param ls            Statistics
+ * @param bytes         Payload size
+ * @param now_ms        Current time
+ */
+CYXCHAT_API void cyxchat_linkstats_on_send(cyxchat_linkstats_t *ls, size_t bytes, uint64_t now_ms);
+
+/**
+ * Count a datagram received
+ *
+ * @param ls            Statistics
+ * @param bytes         Payload size
+ * @param now_ms        Current time
+ */
+CYXCHAT_API void cyxchat_linkstats_on_recv(cyxchat_linkstats_t *ls, size_t bytes, uint64_t now_ms);
+
+/**
+ * Add a round-trip sample (echo reply or ACK)
+ *
+ * @param ls            Statistics
+ * @param rtt_ms        Measured round trip
+ */
+CYXCHAT_API void cyxchat_linkstats_on_rtt(cyxchat_linkstats_t *ls, uint32_t rtt_ms);
+
+/**
+ * Note a received sequence number (wrapping 32-bit, one per packet)
+ *
+ * Jumps count the skipped numbers as lost; a late arrival inside the
+ * reorder window takes its loss back.
+ *
+ * @param ls            Statistics
+ * @param seq           Sender's sequence number
+ */
+CYXCHAT_API void cyxchat_linkstats_on_seq(cyxchat_linkstats_t *ls, uint32_t seq);
+
+/**
+ * Note the outcome of a probe we sent
+ *
+ * @param ls            Statistics
+ * @param answered      1 if the reply arrived, 0 if it timed out
+ */
+CYXCHAT_API void cyxchat_linkstats_on_probe(cyxchat_linkstats_t *ls, int answered);
+
+/**
+ * Close rate windows that have ended
+ *
+ * @param ls            Statistics
+ * @param now_ms        Current time
+ */
+CYXCHAT_API void cyxchat_linkstats_update(cyxchat_linkstats_t *ls, uint64_t now_ms);
+
+/**
+ * Queueing delay estimate (smoothed RTT above the path minimum)
+ *
+ * @param ls            Statistics
+ * @return Delay in ms (0 without samples)
+ */
+CYXCHAT_API uint32_t cyxchat_linkstats_queue_delay(const cyxchat_linkstats_t *ls);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_LINKSTATS_H */
@@ -0,0 +1,303 @@
+/**
+ * CyxChat Loopback Network API
+ * In-process transport with emulated links for multi-node tests
+ */
+
+#ifndef CYXCHAT_LOOPBACK_H
+#define CYXCHAT_LOOPBACK_H
+
+#include "types.h"
+#include <cyxwiz/transport.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_LOOP_MTU            1400    /* Largest datagram a node may send */
+#define CYXCHAT_LOOP_NAT_TIMEOUT_MS 30000   /* Default NAT binding lifetime */
+
+/* ============================================================
+ * Loopback Network
+ * ============================================================ */
+
+typedef struct cyxchat_loopnet cyxchat_loopnet_t;
+
+/*
+ * One direction of a link. Packets are serialised at bandwidth_bps
+ * behind a buffer of queue_bytes (drop-tail), then held latency_ms plus
+ * up to jitter_ms; jitter alone never reorders. A reordered packet skips
+ * the delay and overtakes whatever is in flight, as netem does.
+ */
+typedef struct {
+    uint32_t latency_ms;                /* One-way delay */
+    uint32_t jitter_ms;                 /* Uniform extra delay, 0..jitter */
+    uint32_t loss_ppm;                  /* Drop probability, parts per million */
+    uint32_t reorder_ppm;               /* Overtake probability, parts per million */
+    uint64_t bandwidth_bps;             /* Bits per second (0 = unlimited) */
+    uint32_t queue_bytes;               /* Bottleneck buffer (0 = unlimited) */
+} cyxchat_loop_link_t;
+
+/* NAT in front of a node (RFC 4787 mapping and filtering behaviour) */
+typedef enum {
+    CYXCHAT_LOOP_NAT_NONE = 0,          /* Public address */
+    CYXCHAT_LOOP_NAT_FULL_CONE,         /* One mapping, any sender let in */
+    CYXCHAT_LOOP_NAT_RESTRICTED,        /* One mapping, senders we sent to by address */
+    CYXCHAT_LOOP_NAT_PORT_RESTRICTED,   /* One mapping, senders we sent to by address:port */
+    CYXCHAT_LOOP_NAT_SYMMETRIC          /* Mapping per destination, filtered by address:port */
+} cyxchat_loop_nat_type_t;
+
+typedef struct {
+    cyxchat_loop_nat_type_t type;
+    uint32_t binding_timeout_ms;        /* Idle lifetime (0 = CYXCHAT_LOOP_NAT_TIMEOUT_MS) */
+} cyxchat_loop_nat_t;
+
+/* Statistics */
+typedef struct {
+    uint64_t sent;                      /* Datagrams handed to the network */
+    uint64_t send_calls;                /* Send calls (a vectored send is one) */
+    uint64_t delivered;                 /* Datagrams received by a node */
+    uint64_t bytes_delivered;           /* Payload bytes received */
+    uint64_t lost;                      /* Dropped by loss_ppm */
+    uint64_t queue_drops;               /* Dropped by a full buffer */
+    uint64_t reordered;                 /* Sent ahead of earlier packets */
+    uint64_t unroutable;                /* No node with the destination ID */
+    uint64_t nat_drops;                 /* Refused by the receiver's NAT */
+    uint64_t punches;                   /* Punches let through a NAT */
+    uint64_t relayed;                   /* Forwarded by an emulated relay */
+} cyxchat_loop_stats_t;
+
+/**
+ * Create loopback network
+ *
+ * Links start perfect (no delay, loss or rate limit) until configured.
+ * Every random decision comes from a generator seeded here, so a run
+ * that sends the same packets in the same order is reproduced exactly.
+ * The clock is the monotonic system clock until cyxchat_loopnet_set_time
+ * takes it over.
+ *
+ * @param net           Output network
+ * @param seed          Loss, jitter and reorder seed
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_create(
+    cyxchat_loopnet_t **net,
+    uint64_t seed
+);
+
+/**
+ * Destroy loopback network
+ * Transports created on it must be destroyed first.
+ *
+ * @param net           Network to destroy
+ */
+CYXCHAT_API void cyxchat_loopnet_destroy(cyxchat_loopnet_t *net);
+
+/**
+ * Set the link used between nodes with no link of their own
+ * Applies to node pairs that have not exchanged traffic yet.
+ *
+ * @param net           Network
+ * @param link          Link parameters
+ */
+CYXCHAT_API void cyxchat_loopnet_set_default_link(
+    cyxchat_loopnet_t *net,
+    const cyxchat_loop_link_t *link
+);
+
+/**
+ * Set the link from one node to another (one direction)
+ * The nodes need not exist yet. Packets already in flight keep the
+ * delay they were given.
+ *
+ * @param net           Network
+ * @param from          Sending node
+ * @param to            Receiving node
+ * @param link          Link parameters
+ * @return CYXCHAT_OK, CYXCHAT_ERR_MEMORY
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_set_link(
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *from,
+    const cyxwiz_node_id_t *to,
+    const cyxchat_loop_link_t *link
+);
+
+/**
+ * Add an emulated relay server
+ *
+ * The relay sits on a public address and speaks the client side of
+ * relay.h: it acknowledges CONNECT and forwards DATA and DISCONNECT to
+ * the destination's last known address. Point a connection at it with
+ * cyxchat_conn_add_relay() and the same address.
+ *
+ * @param net           Network
+ * @param addr          "a.b.c.d:port"
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID, CYXCHAT_ERR_EXISTS
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_add_relay(cyxchat_loopnet_t *net, const char *addr);
+
+/**
+ * Drive the network clock by hand
+ * From the first call on, time only moves when this is called, which
+ * makes delivery times independent of host load.
+ *
+ * @param net           Network
+ * @param now_ms        Current time (never decreases)
+ */
+CYXCHAT_API void cyxchat_loopnet_set_time(cyxchat_loopnet_t *net, uint64_t now_ms);
+
+/**
+ * Get the network clock
+ *
+ * @param net           Network
+ * @return Current time in milliseconds
+ */
+CYXCHAT_API uint64_t cyxchat_loopnet_now_ms(cyxchat_loopnet_t *net);
+
+/**
+ * Get the earliest pending delivery to any node
+ *
+ * @param net           Network
+ * @return Delivery time in milliseconds, UINT64_MAX if nothing in flight
+ */
+CYXCHAT_API uint64_t cyxchat_loopnet_next_delivery(cyxchat_loopnet_t *net);
+
+/**
+ * Get network statistics
+ *
+ * @param net           Network
+ * @param stats_out     Output statistics
+ */
+CYXCHAT_API void cyxchat_loopnet_get_stats(
+    cyxchat_loopnet_t *net,
+    cyxchat_loop_stats_t *stats_out
+);
+
+/* ============================================================
+ * Transport
+ * ============================================================ */
+
+/**
+ * Create a transport attached to the network
+ *
+ * Behaves like the UDP transport to its user: send addresses a node ID,
+ * poll delivers what is due, discover reports every other node. The
+ * node is addressed by the ID later given to
+ * cyxwiz_transport_set_local_id().
+ *
+ * @param net           Network
+ * @param transport     Output transport
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_transport_create(
+    cyxchat_loopnet_t *net,
+    cyxwiz_transport_t **transport
+);
+
+/**
+ * Destroy a loopback transport
+ * Packets still addressed to it are dropped.
+ *
+ * @param transport     Transport from cyxchat_loopnet_transport_create
+ */
+CYXCHAT_API void cyxchat_loopnet_transport_destroy(cyxwiz_transport_t *transport);
+
+/**
+ * Put a node behind a NAT
+ * Set before the node sends anything; existing bindings are dropped.
+ * A node that has already run discover registers again through the
+ * new NAT, so its mapped address changes.
+ *
+ * @param transport     Loopback transport
+ * @param nat           NAT behaviour
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if not a loopback transport
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_set_nat(
+    cyxwiz_transport_t *transport,
+    const cyxchat_loop_nat_t *nat
+);
+
+/**
+ * Get the node's address as the rendezvous server saw it
+ * Available after discover; this is what peers send to until a packet
+ * from the node shows them a better address. The rendezvous binding is
+ * refreshed on every poll, like the UDP transport's bootstrap keepalive.
+ *
+ * @param transport     Loopback transport
+ * @param ip_out        Mapped address (network byte order)
+ * @param port_out      Mapped port (network byte order)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NOT_FOUND before discover
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_get_mapped(
+    cyxwiz_transport_t *transport,
+    uint32_t *ip_out,
+    uint16_t *port_out
+);
+
+/**
+ * Send several datagrams in one call
+ * The emulated counterpart of sendmmsg(): each datagram goes through
+ * the same links as a send, but send_calls counts the batch once.
+ *
+ * @param transport     Loopback transport
+ * @param dgrams        Datagrams, sent in order
+ * @param count         Number of datagrams
+ * @return Datagrams accepted (the first failure stops the batch)
+ */
+CYXCHAT_API size_t cyxchat_loopnet_send_batch(
+    cyxwiz_transport_t *transport,
+    const cyxchat_datagram_t *dgrams,
+    size_t count
+);
+
+/**
+ * Send a hole punch to an address
+ *
+ * The emulated counterpart of the UDP transport's punch packet: it
+ * opens a binding in the sender's NAT, and if the receiver's NAT lets
+ * it in, the receiver sends to the punch's source address from then on.
+ * The receiver's callbacks never see it.
+ *
+ * @param transport     Loopback transport
+ * @param ip            Destination (network byte order)
+ * @param port          Destination port (network byte order)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_NETWORK if nothing has that address
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_loopnet_punch(
+    cyxwiz_transport_t *transport,
+    uint32_t ip,
+    uint16_t port
+);
+
+/**
+ * Check whether a transport is a loopback transport
+ *
+ * @param transport     Transport
+ * @return 1 if created by cyxchat_loopnet_transport_create
+ */
+CYXCHAT_API int cyxchat_loopnet_is_loopback(const cyxwiz_transport_t *transport);
+
+/**
+ * Get how long a poll of this transport would sleep
+ * A loopback transport has no socket to wait on: its poll sleeps until
+ * the next arrival, and not at all once the clock is driven by hand.
+ * Lets a caller do that wait itself, on something it can interrupt.
+ *
+ * @param transport     Loopback transport
+ * @param timeout_ms    Longest wait
+ * @return Wait in milliseconds (timeout_ms for other transports)
+ */
+CYXCHAT_API uint32_t cyxchat_loopnet_poll_wait(
+    cyxwiz_transport_t *transport,
+    uint32_t timeout_ms
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_LOOPBACK_H */
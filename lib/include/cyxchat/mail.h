@@ -7,6 +7,7 @@
 #define CYXCHAT_MAIL_H
 
 #include "types.h"
+#include "config.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -264,6 +265,20 @@ CYXCHAT_API cyxchat_error_t cyxchat_mail_ctx_create(
     cyxchat_ctx_t *chat_ctx
 );
 
+/**
+ * Create mail context with config->mail_max_stored slots
+ *
+ * @param ctx           Output: new mail context
+ * @param chat_ctx      Parent chat context
+ * @param config        Capacities (NULL for cyxchat_config_default)
+ * @return              CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_mail_ctx_create_with_config(
+    cyxchat_mail_ctx_t **ctx,
+    cyxchat_ctx_t *chat_ctx,
+    const cyxchat_config_t *config
+);
+
 /**
  * Destroy mail context
  */
@@ -0,0 +1,243 @@
+/**
+ * CyxChat Metrics API
+ * Library-wide counters, gauges and latency histograms
+ */
+
+#ifndef CYXCHAT_METRICS_H
+#define CYXCHAT_METRICS_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+/*
+ * Log-linear buckets: values below 8 get a bucket each, then every
+ * power of two is split into 8 equal buckets, so any recorded value is
+ * within 12.5% of its bucket's bounds. 240 buckets cover 0..2^32-1 us
+ * (about 71 minutes); larger values land in the last bucket.
+ */
+#define CYXCHAT_METRICS_SUB_BITS    3
+#define CYXCHAT_METRICS_BUCKETS     240
+
+#define CYXCHAT_METRICS_MAGIC       "CXM"   /* Binary snapshot prefix */
+#define CYXCHAT_METRICS_VERSION     1
+
+/* ============================================================
+ * Metric IDs
+ * ============================================================ */
+
+/* Monotonic counters */
+typedef enum {
+    CYXCHAT_METRIC_MSG_SENT = 0,            /* Chat messages sent (whole or first fragment) */
+    CYXCHAT_METRIC_MSG_RECV,                /* Chat messages accepted */
+    CYXCHAT_METRIC_MSG_DUP,                 /* Deliveries dropped as duplicate */
+    CYXCHAT_METRIC_MSG_SEND_FAIL,           /* Onion send errors */
+    CYXCHAT_METRIC_FRAG_SENT,               /* Fragments sent */
+    CYXCHAT_METRIC_FRAG_RECV,               /* Fragments received */
+    CYXCHAT_METRIC_BYTES_SENT,              /* Chat wire bytes sent */
+    CYXCHAT_METRIC_BYTES_RECV,              /* Chat wire bytes received */
+    CYXCHAT_METRIC_CONN_DIRECT,             /* Connects completed by hole punch */
+    CYXCHAT_METRIC_CONN_RELAYED,            /* Connects completed through a relay */
+    CYXCHAT_METRIC_CONN_FAILED,             /* Connects that timed out */
+    CYXCHAT_METRIC_DNS_CACHE_HIT,           /* Lookups answered from cache */
+    CYXCHAT_METRIC_DNS_CACHE_MISS,          /* Lookups sent to the network */
+    CYXCHAT_METRIC_DNS_TIMEOUT,             /* Network lookups never answered */
+    CYXCHAT_METRIC_FILE_CHUNK_SENT,         /* File chunks sent */
+    CYXCHAT_METRIC_FILE_CHUNK_RECV,         /* File chunks received */
+    CYXCHAT_METRIC_FILE_DONE,               /* Transfers completed (either side) */
+    CYXCHAT_METRIC_FILE_FAILED,             /* Transfers failed or cancelled */
+    CYXCHAT_METRIC_SCHED_DROP,              /* Frames refused by the scheduler */
+    CYXCHAT_METRIC_LABEL_FWD,               /* Label packets swapped and sent on */
+    CYXCHAT_METRIC_LABEL_DELIVERED,         /* Label packets that ended here */
+    CYXCHAT_METRIC_LABEL_DROP,              /* Label packets refused or unsendable */
+    CYXCHAT_METRIC_OFFLINE_STORED,          /* Mailbox items a storage node ACKed */
+    CYXCHAT_METRIC_OFFLINE_FAILED,          /* Mailbox items never ACKed */
+    CYXCHAT_METRIC_OFFLINE_DELIVERED,       /* Mailbox items drained and opened */
+    CYXCHAT_METRIC_MULTIPATH_SENT,          /* Datagrams sent on relay and direct */
+    CYXCHAT_METRIC_MULTIPATH_DUP,           /* Second copies dropped on receive */
+    CYXCHAT_METRIC_COUNTER_COUNT
+} cyxchat_metric_counter_t;
+
+/* Levels that rise and fall (summed over every context) */
+typedef enum {
+    CYXCHAT_METRIC_SCHED_QUEUED = 0,        /* Frames waiting in schedulers */
+    CYXCHAT_METRIC_PEERS_UP,                /* Peers connected or relaying */
+    CYXCHAT_METRIC_GAUGE_COUNT
+} cyxchat_metric_gauge_t;
+
+/* Latency histograms (microseconds) */
+typedef enum {
+    CYXCHAT_METRIC_SEND_ACK = 0,            /* Chat send to delivery ACK */
+    CYXCHAT_METRIC_DNS_LOOKUP,              /* Network lookup to answer */
+    CYXCHAT_METRIC_HOLE_PUNCH,              /* Connect to direct path */
+    CYXCHAT_METRIC_RELAY_SETUP,             /* Connect to relayed path */
+    CYXCHAT_METRIC_FILE_TRANSFER,           /* Offer to last chunk */
+    CYXCHAT_METRIC_TIMING_COUNT
+} cyxchat_metric_timing_t;
+
+/* Metric kinds (for cyxchat_metrics_name) */
+typedef enum {
+    CYXCHAT_METRIC_KIND_COUNTER = 0,
+    CYXCHAT_METRIC_KIND_GAUGE,
+    CYXCHAT_METRIC_KIND_TIMING
+} cyxchat_metric_kind_t;
+
+/* Histogram copy */
+typedef struct {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t buckets[CYXCHAT_METRICS_BUCKETS];
+} cyxchat_metrics_hist_t;
+
+/* Snapshot encodings */
+typedef enum {
+    CYXCHAT_METRICS_BINARY = 0,
+    CYXCHAT_METRICS_PROMETHEUS
+} cyxchat_metrics_format_t;
+
+/* ============================================================
+ * Recording
+ * ============================================================ */
+
+/* Compile the recording points out with -DCYXCHAT_METRICS_DISABLED */
+#ifdef CYXCHAT_METRICS_DISABLED
+#define CYXCHAT_COUNT(id, n)        ((void)0)
+#define CYXCHAT_GAUGE_ADD(id, d)    ((void)0)
+#define CYXCHAT_OBSERVE(id, us)     ((void)0)
+#else
+#define CYXCHAT_COUNT(id, n)        cyxchat_metrics_count((id), (uint64_t)(n))
+#define CYXCHAT_GAUGE_ADD(id, d)    cyxchat_metrics_gauge_add((id), (int64_t)(d))
+#define CYXCHAT_OBSERVE(id, us)     cyxchat_metrics_observe((id), (uint64_t)(us))
+#endif
+
+/**
+ * Add to a counter
+ * Lock-free; safe to call from any thread.
+ *
+ * @param id            cyxchat_metric_counter_t
+ * @param n             Amount
+ */
+CYXCHAT_API void cyxchat_metrics_count(int id, uint64_t n);
+
+/**
+ * Move a gauge up or down
+ *
+ * @param id            cyxchat_metric_gauge_t
+ * @param delta         Change (negative to lower)
+ */
+CYXCHAT_API void cyxchat_metrics_gauge_add(int id, int64_t delta);
+
+/**
+ * Record a duration
+ *
+ * @param id            cyxchat_metric_timing_t
+ * @param us            Duration in microseconds
+ */
+CYXCHAT_API void cyxchat_metrics_observe(int id, uint64_t us);
+
+/**
+ * Monotonic clock for timing observations
+ *
+ * @return Microseconds since an arbitrary start
+ */
+CYXCHAT_API uint64_t cyxchat_metrics_now_us(void);
+
+/* ============================================================
+ * Reading
+ * ============================================================ */
+
+/**
+ * Get a counter
+ *
+ * @param id            cyxchat_metric_counter_t
+ * @return Value, 0 for an unknown ID
+ */
+CYXCHAT_API uint64_t cyxchat_metrics_counter(int id);
+
+/**
+ * Get a gauge
+ *
+ * @param id            cyxchat_metric_gauge_t
+ * @return Value, 0 for an unknown ID
+ */
+CYXCHAT_API int64_t cyxchat_metrics_gauge(int id);
+
+/**
+ * Copy a histogram
+ * Buckets are read one by one while writers run, so count may trail
+ * the bucket total by the observations made during the copy.
+ *
+ * @param id            cyxchat_metric_timing_t
+ * @param hist_out      Output histogram
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID for an unknown ID
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_metrics_get_hist(int id, cyxchat_metrics_hist_t *hist_out);
+
+/**
+ * Estimate a percentile from a histogram copy
+ *
+ * @param hist          Histogram
+ * @param q             Quantile, 0.0 to 1.0
+ * @return Upper bound of the bucket holding the quantile (us), 0 if empty
+ */
+CYXCHAT_API uint64_t cyxchat_metrics_percentile(const cyxchat_metrics_hist_t *hist, double q);
+
+/**
+ * Get the largest value a bucket holds
+ *
+ * @param index         Bucket index
+ * @return Inclusive upper bound (us)
+ */
+CYXCHAT_API uint64_t cyxchat_metrics_bucket_upper(unsigned index);
+
+/**
+ * Export every metric in one call
+ *
+ * PROMETHEUS writes the text exposition format (durations in seconds,
+ * only non-empty histogram buckets listed). BINARY writes:
+ *
+ *   "CXM", then one byte each for version, counter, gauge and
+ *   histogram counts; then each counter as a varint, each gauge as a zigzag varint, and
+ *   per histogram: count, sum_us, number of non-empty buckets, then
+ *   (index delta, count) pairs; every integer an unsigned LEB128 varint
+ *
+ * The buffer is NUL-terminated in PROMETHEUS form.
+ *
+ * @param format        Encoding
+ * @param buf           Output buffer
+ * @param buf_size      Buffer size
+ * @param len_out       Bytes written (without the NUL)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_FULL if buf is too small
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_metrics_snapshot(
+    cyxchat_metrics_format_t format,
+    uint8_t *buf,
+    size_t buf_size,
+    size_t *len_out
+);
+
+/**
+ * Zero every metric except the gauges, which track live state
+ */
+CYXCHAT_API void cyxchat_metrics_reset(void);
+
+/**
+ * Get a metric's exported name
+ *
+ * @param kind          Metric kind
+ * @param id            ID within that kind
+ * @return Static string, "unknown" if out of range
+ */
+CYXCHAT_API const char* cyxchat_metrics_name(cyxchat_metric_kind_t kind, int id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_METRICS_H */
@@ -0,0 +1,203 @@
+/**
+ * CyxChat Network Monitor API
+ * Periodic STUN refresh and OS route change detection
+ */
+
+#ifndef CYXCHAT_NETMON_H
+#define CYXCHAT_NETMON_H
+
+#include "types.h"
+#include "timer.h"
+#include "keepalive.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_NETMON_DEFAULT_STUN     "stun.l.google.com:19302"
+#define CYXCHAT_NETMON_RTO_MS           500     /* First STUN retransmit */
+#define CYXCHAT_NETMON_MAX_TRIES        4       /* Requests per probe */
+#define CYXCHAT_NETMON_CHECK_MS         20      /* Response check while waiting */
+#define CYXCHAT_NETMON_SETTLE_MS        250     /* Route events coalesce window */
+#define CYXCHAT_NETMON_ROUTE_CHECK_MS   100     /* Min gap between route reads */
+
+/* ============================================================
+ * Network Monitor
+ * ============================================================ */
+
+typedef struct cyxchat_netmon cyxchat_netmon_t;
+
+/* Observed addresses (network byte order) */
+typedef struct {
+    uint32_t public_ip;                 /* STUN mapped address */
+    uint16_t public_port;               /* STUN mapped port (probe socket) */
+    uint32_t local_ip;                  /* Source address of the default route */
+} cyxchat_netmon_addr_t;
+
+/* Statistics */
+typedef struct {
+    uint64_t probes;                    /* Probes started */
+    uint64_t requests_sent;             /* Binding requests incl. retransmits */
+    uint64_t responses;                 /* Valid binding responses */
+    uint64_t timeouts;                  /* Probes that got no response */
+    uint64_t route_events;              /* OS address/route notifications */
+    uint64_t changes;                   /* Address changes reported */
+    uint64_t lifetime_trials;           /* Binding lifetime trials finished */
+} cyxchat_netmon_stats_t;
+
+/**
+ * Address callback
+ *
+ * Called on the first successful probe (old_addr NULL) and whenever the
+ * public or local address differs from the last one seen.
+ */
+typedef void (*cyxchat_netmon_change_cb_t)(
+    cyxchat_netmon_t *nm,
+    const cyxchat_netmon_addr_t *old_addr,
+    const cyxchat_netmon_addr_t *new_addr,
+    void *user_data
+);
+
+/**
+ * Create network monitor
+ *
+ * Schedules the first probe immediately on the given wheel and one
+ * every CYXCHAT_STUN_INTERVAL_MS after that. On Linux a netlink socket
+ * also watches for address and route changes, which trigger a probe
+ * after CYXCHAT_NETMON_SETTLE_MS; elsewhere the periodic probe (or
+ * cyxchat_netmon_refresh from the OS connectivity callback) is the
+ * only trigger.
+ *
+ * @param nm            Output monitor
+ * @param wheel         Timer wheel that drives probes
+ * @param stun_server   "host:port", or NULL for the default
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_netmon_create(
+    cyxchat_netmon_t **nm,
+    cyxchat_timer_wheel_t *wheel,
+    const char *stun_server
+);
+
+/**
+ * Destroy network monitor
+ *
+ * @param nm            Monitor to destroy
+ */
+CYXCHAT_API void cyxchat_netmon_destroy(cyxchat_netmon_t *nm);
+
+/**
+ * Read pending STUN responses and route notifications (non-blocking)
+ *
+ * @param nm            Monitor
+ * @return Number of address changes reported
+ */
+CYXCHAT_API int cyxchat_netmon_poll(cyxchat_netmon_t *nm);
+
+/**
+ * Start a probe now
+ *
+ * A server given by name is looked up on a worker thread first; the
+ * request goes out from the probe timer once the address is known.
+ *
+ * @param nm            Monitor
+ * @return CYXCHAT_OK if a request was sent or the lookup is under way
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_netmon_refresh(cyxchat_netmon_t *nm);
+
+/**
+ * Set STUN server
+ *
+ * @param nm            Monitor
+ * @param stun_server   "host:port" (looked up, off the caller's thread, on the next probe)
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_netmon_set_server(
+    cyxchat_netmon_t *nm,
+    const char *stun_server
+);
+
+/**
+ * Set periodic probe interval
+ *
+ * @param nm            Monitor
+ * @param interval_ms   Interval (0 = CYXCHAT_STUN_INTERVAL_MS)
+ */
+CYXCHAT_API void cyxchat_netmon_set_interval(cyxchat_netmon_t *nm, uint32_t interval_ms);
+
+/**
+ * Set address callback
+ *
+ * @param nm            Monitor
+ * @param callback      Callback function
+ * @param user_data     User data
+ */
+CYXCHAT_API void cyxchat_netmon_set_on_change(
+    cyxchat_netmon_t *nm,
+    cyxchat_netmon_change_cb_t callback,
+    void *user_data
+);
+
+/**
+ * Search for the NAT binding lifetime
+ *
+ * Once enabled, every new address restarts a search (see
+ * cyxchat_keepalive_on_trial): a second socket asks the STUN server to
+ * answer on the port of an idle binding (RFC 5780 RESPONSE-PORT). Each
+ * trial costs a few packets after sitting idle for the trial period. A
+ * server without RFC 5780 support ends the search and the interval
+ * stays at CYXCHAT_KEEPALIVE_INTERVAL_MS.
+ *
+ * @param nm            Monitor
+ * @param enabled       1 to search, 0 to stop
+ */
+CYXCHAT_API void cyxchat_netmon_set_lifetime_probe(cyxchat_netmon_t *nm, int enabled);
+
+/**
+ * Get the binding lifetime search state and keepalive interval
+ *
+ * @param nm            Monitor
+ * @param ka_out        Output state (defaults if nm is NULL)
+ */
+CYXCHAT_API void cyxchat_netmon_get_keepalive(cyxchat_netmon_t *nm, cyxchat_keepalive_t *ka_out);
+
+/**
+ * Get last observed addresses
+ *
+ * @param nm            Monitor
+ * @param addr_out      Output addresses
+ * @return CYXCHAT_OK, or CYXCHAT_ERR_NETWORK before the first response
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_netmon_get_addr(
+    cyxchat_netmon_t *nm,
+    cyxchat_netmon_addr_t *addr_out
+);
+
+/**
+ * Check whether OS route notifications are available
+ *
+ * @param nm            Monitor
+ * @return 1 if watching route changes, 0 if periodic probes only
+ */
+CYXCHAT_API int cyxchat_netmon_watches_routes(cyxchat_netmon_t *nm);
+
+/**
+ * Get monitor statistics
+ *
+ * @param nm            Monitor
+ * @param stats_out     Output statistics
+ */
+CYXCHAT_API void cyxchat_netmon_get_stats(
+    cyxchat_netmon_t *nm,
+    cyxchat_netmon_stats_t *stats_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_NETMON_H */
@@ -0,0 +1,351 @@
+/**
+ * CyxChat Offline Delivery API
+ * Store-and-forward through DHT mailboxes
+ *
+ * A message for a peer that cannot be reached is sealed to the
+ * recipient's X25519 key, with the sender's signature inside, and PUT
+ * on the nodes closest to one of the recipient's mailbox keys:
+ *
+ *   key = BLAKE2b(recipient || "CYXCHAT_MAILBOX" || slot)
+ *
+ * The sender's outbox batches items per key, resends until a storage
+ * node ACKs and then forgets them. The recipient drains every slot from
+ * every replica with parallel GETs when it comes online, and deletes
+ * what it read with a token only the sender and recipient know.
+ */
+
+#ifndef CYXCHAT_OFFLINE_H
+#define CYXCHAT_OFFLINE_H
+
+#include "types.h"
+#include "config.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_OFFLINE_SLOTS           4       /* Mailbox keys per recipient */
+#define CYXCHAT_OFFLINE_REPLICAS        3       /* Storage nodes per key */
+#define CYXCHAT_OFFLINE_STORE_SIZE      256     /* Default items held for others */
+#define CYXCHAT_OFFLINE_OUTBOX_SIZE     32      /* Items waiting for a storage ACK */
+#define CYXCHAT_OFFLINE_PER_KEY         64      /* Items one key may hold on a node */
+#define CYXCHAT_OFFLINE_SEEN            64      /* Drained items remembered */
+
+#define CYXCHAT_OFFLINE_MAX_PAYLOAD     250     /* Largest message (one chat frame) */
+#define CYXCHAT_OFFLINE_TOKEN_SIZE      16      /* Delete token and its hash */
+#define CYXCHAT_OFFLINE_SIG_SIZE        64      /* Sender's Ed25519 signature */
+#define CYXCHAT_OFFLINE_SEAL_OVERHEAD   48      /* crypto_box_SEALBYTES */
+#define CYXCHAT_OFFLINE_BLOB_MAX        (CYXCHAT_OFFLINE_SEAL_OVERHEAD + 32 + \
+                                         CYXCHAT_OFFLINE_TOKEN_SIZE + \
+                                         CYXCHAT_OFFLINE_SIG_SIZE + \
+                                         CYXCHAT_OFFLINE_MAX_PAYLOAD)
+#define CYXCHAT_OFFLINE_FRAME_MAX       1200    /* Largest PUT or ITEMS frame */
+#define CYXCHAT_OFFLINE_TTL_SECONDS     CYXCHAT_DHT_TTL_SECONDS
+
+#define CYXCHAT_OFFLINE_BATCH_MS        200     /* Outbox waits this long to fill a PUT */
+#define CYXCHAT_OFFLINE_RETRY_MS        5000    /* Unacknowledged PUT is resent */
+#define CYXCHAT_OFFLINE_ATTEMPTS        3       /* PUTs before an item fails */
+#define CYXCHAT_OFFLINE_GET_TIMEOUT_MS  5000    /* Replica silent this long is skipped */
+#define CYXCHAT_OFFLINE_DRAIN_MS        300000  /* Mailbox re-checked this often */
+#define CYXCHAT_OFFLINE_IDLE_RETRY_MS   2000    /* Drain retry while no replica is up */
+
+/* ============================================================
+ * Types
+ * ============================================================ */
+
+typedef struct cyxchat_offline_ctx cyxchat_offline_ctx_t;
+
+/**
+ * Send a frame to a connected peer
+ *
+ * @param user_data     Transport user data
+ * @param to            Storage node or recipient
+ * @param data          Frame
+ * @param len           Frame length
+ * @return CYXCHAT_OK if sent
+ */
+typedef cyxchat_error_t (*cyxchat_offline_send_fn)(
+    void *user_data,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len
+);
+
+/**
+ * Find reachable storage nodes for a mailbox key
+ *
+ * @param user_data     Transport user data
+ * @param key           Mailbox key (as a DHT target)
+ * @param out_nodes     Output nodes, closest first
+ * @param max_nodes     Room in out_nodes
+ * @return Nodes written
+ */
+typedef size_t (*cyxchat_offline_closest_fn)(
+    void *user_data,
+    const cyxwiz_node_id_t *key,
+    cyxwiz_node_id_t *out_nodes,
+    size_t max_nodes
+);
+
+/**
+ * Look up a peer's X25519 public key (usually from the contact list)
+ *
+ * @param user_data     Lookup user data
+ * @param peer          Peer
+ * @param public_out    Output key (32 bytes)
+ * @return 1 if known, 0 otherwise
+ */
+typedef int (*cyxchat_offline_key_fn)(
+    void *user_data,
+    const cyxwiz_node_id_t *peer,
+    uint8_t *public_out
+);
+
+/**
+ * Message drained from our mailbox
+ * The sender ID travels inside the sealed blob with the sender's
+ * signature over it, the recipient and the message; items whose
+ * signature does not verify against that ID are dropped, not delivered.
+ */
+typedef void (*cyxchat_offline_message_callback_t)(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len,
+    void *user_data
+);
+
+/**
+ * Outcome of an offline send
+ *
+ * @param result        CYXCHAT_OK once a storage node holds the item,
+ *                      CYXCHAT_ERR_TIMEOUT after CYXCHAT_OFFLINE_ATTEMPTS
+ */
+typedef void (*cyxchat_offline_stored_callback_t)(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    uint64_t item_id,
+    cyxchat_error_t result,
+    void *user_data
+);
+
+/* Statistics */
+typedef struct {
+    uint32_t outbox;                    /* Items waiting for an ACK */
+    uint32_t held;                      /* Items stored for other nodes */
+    uint32_t gets_pending;              /* Drain requests in flight */
+    uint64_t puts_sent;                 /* PUT frames sent */
+    uint64_t items_stored;              /* Own items acknowledged */
+    uint64_t items_failed;              /* Own items given up on */
+    uint64_t items_delivered;           /* Items drained and decrypted */
+    uint64_t items_rejected;            /* Drained items with a bad signature */
+    uint64_t items_refused;             /* PUT items a full store turned away */
+} cyxchat_offline_stats_t;
+
+/* ============================================================
+ * Lifecycle
+ * ============================================================ */
+
+/**
+ * Create an offline delivery context
+ * Our mailbox key pair is the X25519 form of signing_key, so a peer
+ * holding our Ed25519 public key can convert it to seal for us; with no
+ * signing key a random pair is made and the context can only receive.
+ * Senders sign with signing_key, so local_id must be its public key.
+ *
+ * @param ctx_out       Output context
+ * @param local_id      Our node ID
+ * @param signing_key   Our Ed25519 signing key (64 bytes, may be NULL)
+ * @param config        Capacities, offline_store_size items held for
+ *                      others (NULL for cyxchat_config_default)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_offline_create(
+    cyxchat_offline_ctx_t **ctx_out,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+);
+
+/**
+ * Destroy an offline context (keys and stored items are wiped)
+ *
+ * @param ctx           Context
+ */
+CYXCHAT_API void cyxchat_offline_destroy(cyxchat_offline_ctx_t *ctx);
+
+/**
+ * Set the transport
+ *
+ * @param ctx           Context
+ * @param send          Frame sender
+ * @param closest       Storage node lookup
+ * @param user_data     Passed to both
+ */
+CYXCHAT_API void cyxchat_offline_set_transport(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_send_fn send,
+    cyxchat_offline_closest_fn closest,
+    void *user_data
+);
+
+/**
+ * Set the recipient key lookup used by cyxchat_offline_send_to
+ *
+ * @param ctx           Context
+ * @param lookup        Lookup
+ * @param user_data     Passed to lookup
+ */
+CYXCHAT_API void cyxchat_offline_set_key_lookup(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_key_fn lookup,
+    void *user_data
+);
+
+/**
+ * Get our mailbox public key
+ *
+ * @param ctx           Context
+ * @param public_out    Output X25519 public key (32 bytes)
+ */
+CYXCHAT_API void cyxchat_offline_get_public_key(
+    cyxchat_offline_ctx_t *ctx,
+    uint8_t *public_out
+);
+
+/**
+ * Run batching, retries, drain timeouts and expiry
+ *
+ * @param ctx           Context
+ * @param now_ms        Current time
+ * @return Frames sent
+ */
+CYXCHAT_API int cyxchat_offline_poll(cyxchat_offline_ctx_t *ctx, uint64_t now_ms);
+
+/* ============================================================
+ * Sending
+ * ============================================================ */
+
+/**
+ * Store a message in a peer's mailbox
+ * The item waits up to CYXCHAT_OFFLINE_BATCH_MS for others to the
+ * same mailbox, then goes out in one PUT per replica.
+ *
+ * @param ctx           Context
+ * @param to            Recipient
+ * @param to_public     Recipient's X25519 public key
+ * @param data          Message
+ * @param len           Length, up to CYXCHAT_OFFLINE_MAX_PAYLOAD
+ * @param item_id_out   Output item ID (may be NULL)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_FULL if the outbox is full,
+ *         CYXCHAT_ERR_CRYPTO without crypto support or a signing key
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_offline_send(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *to_public,
+    const uint8_t *data,
+    size_t len,
+    uint64_t *item_id_out
+);
+
+/**
+ * Store a message using the key lookup for the recipient's key
+ *
+ * @return As cyxchat_offline_send, or CYXCHAT_ERR_NOT_FOUND if the
+ *         recipient's key is unknown
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_offline_send_to(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t *item_id_out
+);
+
+/* ============================================================
+ * Receiving
+ * ============================================================ */
+
+/**
+ * Fetch our mailbox now
+ * Sends a GET for every slot to every replica at once; pages follow
+ * as answers arrive. Poll also drains every CYXCHAT_OFFLINE_DRAIN_MS,
+ * and retries soon after a drain that found no replica.
+ *
+ * @param ctx           Context
+ * @return GETs sent
+ */
+CYXCHAT_API int cyxchat_offline_drain(cyxchat_offline_ctx_t *ctx);
+
+/**
+ * Handle an offline frame (CYXCHAT_MSG_OFFLINE_PUT..DELETE)
+ *
+ * @param ctx           Context
+ * @param from          Sending node
+ * @param data          Frame
+ * @param len           Frame length
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID if malformed
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_offline_handle_message(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len
+);
+
+/* ============================================================
+ * Callbacks and Accessors
+ * ============================================================ */
+
+/**
+ * Set drained message callback
+ */
+CYXCHAT_API void cyxchat_offline_set_on_message(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_message_callback_t callback,
+    void *user_data
+);
+
+/**
+ * Set send outcome callback
+ */
+CYXCHAT_API void cyxchat_offline_set_on_stored(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_stored_callback_t callback,
+    void *user_data
+);
+
+/**
+ * Derive a mailbox key
+ *
+ * @param recipient     Mailbox owner
+ * @param slot          Slot, below CYXCHAT_OFFLINE_SLOTS
+ * @param key_out       Output key (32 bytes)
+ */
+CYXCHAT_API void cyxchat_offline_mailbox_key(
+    const cyxwiz_node_id_t *recipient,
+    uint8_t slot,
+    uint8_t *key_out
+);
+
+/**
+ * Get statistics
+ *
+ * @param ctx           Context
+ * @param stats_out     Output statistics
+ */
+CYXCHAT_API void cyxchat_offline_get_stats(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_stats_t *stats_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_OFFLINE_H */
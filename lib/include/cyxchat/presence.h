@@ -7,6 +7,7 @@
 #define CYXCHAT_PRESENCE_H
 
 #include "types.h"
+#include "timer.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -82,6 +83,27 @@ CYXCHAT_API void cyxchat_presence_ctx_destroy(cyxchat_presence_ctx_t *ctx);
 
 CYXCHAT_API int cyxchat_presence_poll(cyxchat_presence_ctx_t *ctx, uint64_t now_ms);
 
+/**
+ * Schedule presence timers on a shared wheel
+ * While attached, cyxchat_presence_poll() leaves advancing to the wheel
+ * owner. Detach (NULL) before the wheel is destroyed.
+ *
+ * @param ctx           Presence context
+ * @param wheel         Shared wheel, or NULL to return to the private one
+ */
+CYXCHAT_API void cyxchat_presence_set_timer_wheel(
+    cyxchat_presence_ctx_t *ctx,
+    cyxchat_timer_wheel_t *wheel
+);
+
+/**
+ * Get earliest auto-away or stale-entry deadline
+ *
+ * @param ctx           Presence context
+ * @return Absolute time in ms, or CYXCHAT_TIMER_NONE
+ */
+CYXCHAT_API uint64_t cyxchat_presence_next_deadline(cyxchat_presence_ctx_t *ctx);
+
 /* ============================================================
  * Status Management
  * ============================================================ */
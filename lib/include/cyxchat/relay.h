@@ -10,6 +10,7 @@
 #define CYXCHAT_RELAY_H
 
 #include "types.h"
+#include "timer.h"
 #include <cyxwiz/transport.h>
 
 #ifdef __cplusplus
@@ -23,18 +24,20 @@ extern "C" {
 #define CYXCHAT_MAX_RELAY_SERVERS       4       /* Max relay servers */
 #define CYXCHAT_MAX_RELAY_CONNECTIONS   16      /* Max relayed connections */
 #define CYXCHAT_RELAY_TIMEOUT_MS        10000   /* Relay connection timeout */
-#define CYXCHAT_RELAY_KEEPALIVE_MS      30000   /* Keepalive interval */
+#define CYXCHAT_RELAY_KEEPALIVE_MS      30000   /* Default keepalive interval */
 
 /* ============================================================
  * Relay Protocol Message Types
+ *
+ * 0xB0-0xBF: clear of CyxMail (0xE0-0xEF), which shares the wire.
  * ============================================================ */
 
-#define CYXCHAT_RELAY_CONNECT           0xE0    /* Connect via relay */
-#define CYXCHAT_RELAY_CONNECT_ACK       0xE1    /* Connection acknowledged */
-#define CYXCHAT_RELAY_DISCONNECT        0xE2    /* Disconnect */
-#define CYXCHAT_RELAY_DATA              0xE3    /* Relayed data */
-#define CYXCHAT_RELAY_KEEPALIVE         0xE4    /* Keepalive */
-#define CYXCHAT_RELAY_ERROR             0xE5    /* Error response */
+#define CYXCHAT_RELAY_CONNECT           0xB0    /* Connect via relay */
+#define CYXCHAT_RELAY_CONNECT_ACK       0xB1    /* Connection acknowledged */
+#define CYXCHAT_RELAY_DISCONNECT        0xB2    /* Disconnect */
+#define CYXCHAT_RELAY_DATA              0xB3    /* Relayed data */
+#define CYXCHAT_RELAY_KEEPALIVE         0xB4    /* Keepalive */
+#define CYXCHAT_RELAY_ERROR             0xB5    /* Error response */
 
 /* ============================================================
  * Context
@@ -50,8 +53,8 @@ typedef struct {
     cyxwiz_node_id_t peer_id;           /* Remote peer ID */
     uint64_t connected_at;              /* Connection timestamp */
     uint64_t last_activity;             /* Last activity timestamp */
-    uint32_t bytes_sent;                /* Bytes sent via relay */
-    uint32_t bytes_received;            /* Bytes received via relay */
+    uint64_t bytes_sent;                /* Bytes sent via relay */
+    uint64_t bytes_received;            /* Bytes received via relay */
     int active;                         /* Connection active */
 } cyxchat_relay_conn_t;
 
@@ -72,6 +75,9 @@ typedef void (*cyxchat_relay_data_callback_t)(
 
 /**
  * Relay connection state callback
+ * connected is 1 once the relay acknowledges the session or the peer's
+ * traffic arrives through it, not when the request is sent; 0 when the
+ * session ends or is refused.
  */
 typedef void (*cyxchat_relay_state_callback_t)(
     cyxchat_relay_ctx_t *ctx,
@@ -112,6 +118,49 @@ CYXCHAT_API void cyxchat_relay_destroy(cyxchat_relay_ctx_t *ctx);
  */
 CYXCHAT_API int cyxchat_relay_poll(cyxchat_relay_ctx_t *ctx, uint64_t now_ms);
 
+/**
+ * Schedule relay timers on a shared wheel
+ * Pending timers move across with their remaining delay. While
+ * attached, cyxchat_relay_poll() leaves advancing to the wheel owner.
+ *
+ * @param ctx           Relay context
+ * @param wheel         Shared wheel, or NULL to return to the private one
+ */
+CYXCHAT_API void cyxchat_relay_set_timer_wheel(
+    cyxchat_relay_ctx_t *ctx,
+    cyxchat_timer_wheel_t *wheel
+);
+
+/**
+ * Get earliest relay timeout or keepalive deadline
+ *
+ * @param ctx           Relay context
+ * @return Absolute time in ms, or CYXCHAT_TIMER_NONE
+ */
+CYXCHAT_API uint64_t cyxchat_relay_next_deadline(cyxchat_relay_ctx_t *ctx);
+
+/**
+ * Set keepalive interval
+ * Each connection sends a keepalive once it has gone this long without.
+ *
+ * @param ctx           Relay context
+ * @param interval_ms   Interval (0 = CYXCHAT_RELAY_KEEPALIVE_MS)
+ */
+CYXCHAT_API void cyxchat_relay_set_keepalive_interval(
+    cyxchat_relay_ctx_t *ctx,
+    uint32_t interval_ms
+);
+
+/**
+ * Send keepalives on all connections now
+ * Lets the owner fold relay keepalives into its own wake-ups; each
+ * connection's interval restarts from here.
+ *
+ * @param ctx           Relay context
+ * @return Keepalives sent
+ */
+CYXCHAT_API int cyxchat_relay_keepalive_now(cyxchat_relay_ctx_t *ctx);
+
 /* ============================================================
  * Relay Server Management
  * ============================================================ */
@@ -139,6 +188,8 @@ CYXCHAT_API size_t cyxchat_relay_server_count(cyxchat_relay_ctx_t *ctx);
 
 /**
  * Connect to peer via relay
+ * Sends the request only; the state callback reports the session once
+ * the relay answers.
  *
  * @param ctx           Relay context
  * @param peer_id       Peer to connect to
@@ -227,7 +278,7 @@ CYXCHAT_API void cyxchat_relay_set_on_state(
  * Handle incoming relay message
  *
  * Call this when a message is received that may be a relay protocol
- * message (types 0xE0-0xE5).
+ * message (types 0xB0-0xB5).
  *
  * @param ctx           Relay context
  * @param data          Message data
@@ -0,0 +1,70 @@
+/**
+ * CyxChat Random ID Pool API
+ * Buffered CSPRNG for message, file and mail IDs
+ */
+
+#ifndef CYXCHAT_RNG_H
+#define CYXCHAT_RNG_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_RNG_BLOCK_SIZE      4096    /* Keystream bytes per refill */
+#define CYXCHAT_RNG_RESEED_BLOCKS   256     /* Refills between system reseeds */
+
+/* ============================================================
+ * RNG Pool
+ * ============================================================ */
+
+typedef struct cyxchat_rng cyxchat_rng_t;
+
+/**
+ * Create a random pool
+ *
+ * The pool is a ChaCha20 keystream seeded from the system CSPRNG and
+ * refilled in CYXCHAT_RNG_BLOCK_SIZE blocks. Each refill rekeys from its
+ * own output and wipes consumed bytes, so earlier IDs cannot be
+ * recovered from pool state. A pool is not thread-safe; use one per
+ * context or thread.
+ *
+ * @param rng           Output pool
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_rng_create(cyxchat_rng_t **rng);
+
+/**
+ * Destroy a random pool
+ *
+ * @param rng           Pool to destroy
+ */
+CYXCHAT_API void cyxchat_rng_destroy(cyxchat_rng_t *rng);
+
+/**
+ * Fill buffer with random bytes from the pool
+ *
+ * @param rng           Pool (NULL falls back to the system CSPRNG)
+ * @param out           Output buffer
+ * @param len           Number of bytes
+ */
+CYXCHAT_API void cyxchat_rng_bytes(cyxchat_rng_t *rng, uint8_t *out, size_t len);
+
+/**
+ * Get the calling thread's default pool
+ * Used by ID generators that are not tied to a context.
+ *
+ * @return Thread-local pool (never NULL)
+ */
+CYXCHAT_API cyxchat_rng_t* cyxchat_rng_default(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_RNG_H */
@@ -0,0 +1,427 @@
+/**
+ * CyxChat Runtime API
+ * Owns every module context and drives them from one deadline-driven
+ * loop, inline or on a dedicated network thread
+ */
+
+#ifndef CYXCHAT_RUNTIME_H
+#define CYXCHAT_RUNTIME_H
+
+#include "types.h"
+#include "chat.h"
+#include "connection.h"
+#include "file.h"
+#include "dns.h"
+#include "mail.h"
+#include "presence.h"
+#include "group.h"
+#include "offline.h"
+#include "contact.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_RUNTIME_CMD_SLOTS       64      /* Command queue capacity (power of 2) */
+#define CYXCHAT_RUNTIME_EVENT_SLOTS     128     /* Event ring capacity (power of 2) */
+#define CYXCHAT_RUNTIME_MAX_PAYLOAD     4096    /* Largest command or event payload */
+#define CYXCHAT_RUNTIME_TICK_MS         50      /* File, mail, group and offline poll interval */
+
+/* ============================================================
+ * Runtime Types
+ * ============================================================ */
+
+typedef struct cyxchat_runtime cyxchat_runtime_t;
+
+/* Event types delivered to the owner thread */
+typedef enum {
+    CYXCHAT_RUNTIME_EVENT_NONE = 0,
+    CYXCHAT_RUNTIME_EVENT_MESSAGE,          /* Chat message (as cyxchat_recv_next) */
+    CYXCHAT_RUNTIME_EVENT_CONN_STATE,       /* Peer connection state changed */
+    CYXCHAT_RUNTIME_EVENT_COMPLETE          /* Tagged command finished */
+} cyxchat_runtime_event_type_t;
+
+/* Runtime event */
+typedef struct {
+    uint8_t type;                           /* cyxchat_runtime_event_type_t */
+    uint8_t msg_type;                       /* MESSAGE: CYXCHAT_MSG_* */
+    uint8_t old_state;                      /* CONN_STATE: cyxchat_conn_state_t */
+    uint8_t new_state;                      /* CONN_STATE: cyxchat_conn_state_t */
+    int32_t result;                         /* COMPLETE: cyxchat_error_t */
+    uint64_t tag;                           /* COMPLETE: tag given at submit */
+    cyxwiz_node_id_t peer;                  /* Sender / peer / recipient */
+    uint32_t data_len;
+    uint8_t data[CYXCHAT_RUNTIME_MAX_PAYLOAD]; /* COMPLETE of send_text: msg ID */
+} cyxchat_runtime_event_t;
+
+/* Runtime counters */
+typedef struct {
+    uint64_t commands;                      /* Commands executed */
+    uint64_t commands_rejected;             /* Submits refused (queue full) */
+    uint64_t events;                        /* Events published */
+    uint64_t events_dropped;                /* Events lost (ring full) */
+    uint64_t loops;                         /* Poll cycles run */
+} cyxchat_runtime_stats_t;
+
+/**
+ * Function run on the network thread by cyxchat_runtime_call()
+ * Any module API may be used here, through the runtime accessors.
+ *
+ * @return cyxchat_error_t reported in the COMPLETE event
+ */
+typedef cyxchat_error_t (*cyxchat_runtime_fn_t)(
+    cyxchat_runtime_t *rt,
+    void *user_data
+);
+
+/* ============================================================
+ * Lifecycle
+ * ============================================================ */
+
+/**
+ * Create a runtime and every module context
+ *
+ * Creates the connection, chat, file, DNS, mail, presence, group and
+ * offline contexts and wires them together: file messages are routed
+ * by the chat context, DNS and mail frames from the connection layer
+ * go to their handlers, DNS and presence timers share the connection
+ * timer wheel, undeliverable chat goes to mailboxes sealed with keys
+ * from the contact list, and the onion context is polled once per
+ * cycle. The runtime takes over the connection state and data
+ * callbacks. Mailbox items are signed with signing_key, so local_id
+ * should be its public key.
+ *
+ * With local_id NULL no contexts are created and the runtime only
+ * runs commands.
+ *
+ * @param rt            Output runtime
+ * @param bootstrap     Bootstrap server "IP:port" (may be NULL)
+ * @param local_id      Our node ID (may be NULL, see above)
+ * @param signing_key   DNS and mailbox Ed25519 key, 64 bytes (may be NULL)
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_create(
+    cyxchat_runtime_t **rt,
+    const char *bootstrap,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key
+);
+
+/**
+ * Create a runtime with configured capacities
+ *
+ * Same as cyxchat_runtime_create, but the connection, chat, DNS, mail
+ * and group contexts size their tables from config, each in a single
+ * allocation, so the footprint can be tuned per deployment.
+ *
+ * @param rt            Output runtime
+ * @param bootstrap     Bootstrap server "IP:port" (may be NULL)
+ * @param local_id      Our node ID (may be NULL)
+ * @param signing_key   DNS and mailbox Ed25519 key, 64 bytes (may be NULL)
+ * @param config        Capacities (NULL for cyxchat_config_default)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_INVALID for a bad config
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_create_with_config(
+    cyxchat_runtime_t **rt,
+    const char *bootstrap,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+);
+
+/**
+ * Create a runtime on a loopback network
+ *
+ * Same as cyxchat_runtime_create, but the connection context comes from
+ * cyxchat_conn_create_loopback(), so several runtimes can exchange
+ * chat, file, DNS and mail traffic inside one process.
+ *
+ * @param rt            Output runtime
+ * @param net           Network from cyxchat_loopnet_create
+ * @param local_id      Our node ID
+ * @param signing_key   DNS and mailbox Ed25519 key, 64 bytes (may be NULL)
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_create_loopback(
+    cyxchat_runtime_t **rt,
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key
+);
+
+/**
+ * Destroy runtime and every context it owns
+ * Stops the network thread first.
+ *
+ * @param rt            Runtime
+ */
+CYXCHAT_API void cyxchat_runtime_destroy(cyxchat_runtime_t *rt);
+
+/**
+ * Run one non-blocking cycle on the calling thread
+ * Executes queued commands, polls the contexts and publishes events.
+ * Does nothing while the network thread is running.
+ *
+ * @param rt            Runtime
+ * @param now_ms        Current timestamp in milliseconds
+ * @return Number of commands and events handled
+ */
+CYXCHAT_API int cyxchat_runtime_poll(cyxchat_runtime_t *rt, uint64_t now_ms);
+
+/**
+ * Run one cycle, first waiting for work
+ * Blocks in the transport until a datagram arrives, the earliest
+ * deadline is reached or max_wait_ms passes; a command queued before
+ * or during the wait, from any thread, cuts it short. Does nothing
+ * while the network thread is running.
+ *
+ * @param rt            Runtime
+ * @param max_wait_ms   Longest wait
+ * @return Number of commands and events handled
+ */
+CYXCHAT_API int cyxchat_runtime_wait(cyxchat_runtime_t *rt, uint32_t max_wait_ms);
+
+/**
+ * Get the earliest time the runtime needs a cycle
+ * Covers connection, relay, DNS and presence timers and the module
+ * tick. Hosts driving cyxchat_runtime_poll() can sleep until then.
+ *
+ * @param rt            Runtime
+ * @return Absolute time in ms (cyxchat_timestamp_ms clock), 0 if
+ *         commands are waiting, CYXCHAT_TIMER_NONE if idle
+ */
+CYXCHAT_API uint64_t cyxchat_runtime_next_deadline(cyxchat_runtime_t *rt);
+
+/* ============================================================
+ * Network Thread
+ * ============================================================ */
+
+/**
+ * Start the network thread
+ *
+ * From this point the thread owns every module context: other
+ * threads must not call their APIs directly, only submit commands
+ * (cyxchat_runtime_call for anything without a dedicated command).
+ *
+ * @param rt            Runtime
+ * @return CYXCHAT_OK, CYXCHAT_ERR_EXISTS if running, CYXCHAT_ERR_MEMORY
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_start_thread(cyxchat_runtime_t *rt);
+
+/**
+ * Stop and join the network thread
+ * Commands still queued run on the next cyxchat_runtime_poll().
+ *
+ * @param rt            Runtime
+ */
+CYXCHAT_API void cyxchat_runtime_stop_thread(cyxchat_runtime_t *rt);
+
+/**
+ * Check if the network thread is running
+ *
+ * @param rt            Runtime
+ * @return 1 if running, 0 otherwise
+ */
+CYXCHAT_API int cyxchat_runtime_is_threaded(cyxchat_runtime_t *rt);
+
+/* ============================================================
+ * Commands (safe from any thread)
+ * ============================================================ */
+
+/*
+ * Each submit copies its arguments into the command queue and returns
+ * at once. CYXCHAT_ERR_FULL means the queue is full and nothing was
+ * queued. A non-zero tag requests a COMPLETE event with the result.
+ */
+
+/**
+ * Queue cyxchat_send_text()
+ * The COMPLETE event carries the generated message ID in data.
+ *
+ * @param rt            Runtime
+ * @param to            Recipient
+ * @param text          Message text (UTF-8)
+ * @param text_len      Text length (max CYXCHAT_RUNTIME_MAX_PAYLOAD)
+ * @param reply_to      Message replied to (may be NULL)
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_send_text(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const char *text,
+    size_t text_len,
+    const cyxchat_msg_id_t *reply_to,
+    uint64_t tag
+);
+
+/**
+ * Queue cyxchat_send_raw()
+ *
+ * @param rt            Runtime
+ * @param to            Recipient
+ * @param data          Pre-encoded message
+ * @param len           Data length (max CYXCHAT_RUNTIME_MAX_PAYLOAD)
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_send_raw(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t tag
+);
+
+/**
+ * Queue cyxchat_conn_send()
+ *
+ * @param rt            Runtime
+ * @param to            Destination peer
+ * @param data          Data
+ * @param len           Data length (max CYXCHAT_RUNTIME_MAX_PAYLOAD)
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_conn_send(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t tag
+);
+
+/**
+ * Queue cyxchat_conn_connect()
+ *
+ * @param rt            Runtime
+ * @param peer_id       Peer to connect to
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_connect(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *peer_id,
+    uint64_t tag
+);
+
+/**
+ * Queue cyxchat_conn_disconnect()
+ *
+ * @param rt            Runtime
+ * @param peer_id       Peer to disconnect
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_disconnect(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *peer_id,
+    uint64_t tag
+);
+
+/**
+ * Queue a function to run on the network thread
+ *
+ * @param rt            Runtime
+ * @param fn            Function
+ * @param user_data     Function argument (must stay valid until it runs)
+ * @param tag           Completion tag (0 = no event)
+ * @return CYXCHAT_OK if queued
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_runtime_call(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_fn_t fn,
+    void *user_data,
+    uint64_t tag
+);
+
+/* ============================================================
+ * Events (single consumer)
+ * ============================================================ */
+
+/**
+ * Take the next event
+ * Call from one thread only. Chat messages stay in the chat receive
+ * queue while the ring is full, so they are delayed, not lost.
+ *
+ * @param rt            Runtime
+ * @param event_out     Output event
+ * @return 1 if an event was returned, 0 if none
+ */
+CYXCHAT_API int cyxchat_runtime_next_event(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_event_t *event_out
+);
+
+/* ============================================================
+ * Accessors
+ * ============================================================ */
+
+/**
+ * Get runtime counters (approximate while the thread runs)
+ *
+ * @param rt            Runtime
+ * @param stats_out     Output counters
+ */
+CYXCHAT_API void cyxchat_runtime_get_stats(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_stats_t *stats_out
+);
+
+/**
+ * Get connection context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_conn_ctx_t* cyxchat_runtime_get_conn(cyxchat_runtime_t *rt);
+
+/**
+ * Get chat context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_ctx_t* cyxchat_runtime_get_chat(cyxchat_runtime_t *rt);
+
+/**
+ * Get file transfer context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_file_ctx_t* cyxchat_runtime_get_file(cyxchat_runtime_t *rt);
+
+/**
+ * Get DNS context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_dns_ctx_t* cyxchat_runtime_get_dns(cyxchat_runtime_t *rt);
+
+/**
+ * Get mail context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_mail_ctx_t* cyxchat_runtime_get_mail(cyxchat_runtime_t *rt);
+
+/**
+ * Get presence context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_presence_ctx_t* cyxchat_runtime_get_presence(cyxchat_runtime_t *rt);
+
+/**
+ * Get group context (only touch it from the network thread)
+ */
+CYXCHAT_API cyxchat_group_ctx_t* cyxchat_runtime_get_group(cyxchat_runtime_t *rt);
+
+/**
+ * Get offline delivery context (only touch it from the network thread)
+ * Chat falls back to the mailboxes of recipients in the contact list.
+ */
+CYXCHAT_API cyxchat_offline_ctx_t* cyxchat_runtime_get_offline(cyxchat_runtime_t *rt);
+
+/**
+ * Get contact list (only touch it from the network thread)
+ * Offline sends seal to the public key stored with the recipient;
+ * blocked contacts get none.
+ */
+CYXCHAT_API cyxchat_contact_list_t* cyxchat_runtime_get_contacts(cyxchat_runtime_t *rt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_RUNTIME_H */
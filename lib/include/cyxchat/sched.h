@@ -0,0 +1,160 @@
+/**
+ * CyxChat Outbound Scheduler API
+ * Per-peer strict-priority queues for outgoing frames
+ */
+
+#ifndef CYXCHAT_SCHED_H
+#define CYXCHAT_SCHED_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_SCHED_MAX_PEERS     32      /* Peers with frames queued */
+#define CYXCHAT_SCHED_SLOTS         256     /* Queued frames, all peers */
+#define CYXCHAT_SCHED_RESERVED      64      /* Slots only control/interactive may take */
+#define CYXCHAT_SCHED_FRAME_MAX     250     /* Largest frame (one onion payload) */
+#define CYXCHAT_SCHED_POLL_BUDGET   4096    /* Bytes released per flush */
+
+/* Bytes one peer may have queued per class */
+#define CYXCHAT_SCHED_CAP_CONTROL       2048
+#define CYXCHAT_SCHED_CAP_INTERACTIVE   8192
+#define CYXCHAT_SCHED_CAP_BACKGROUND    2048
+#define CYXCHAT_SCHED_CAP_BULK          4096
+
+/* ============================================================
+ * Scheduler Context
+ * ============================================================ */
+
+typedef struct cyxchat_sched_ctx cyxchat_sched_ctx_t;
+
+/* Statistics (indexed by cyxchat_prio_t) */
+typedef struct {
+    uint64_t queued[CYXCHAT_PRIO_COUNT];        /* Frames accepted */
+    uint64_t sent[CYXCHAT_PRIO_COUNT];          /* Frames handed to send */
+    uint64_t failed[CYXCHAT_PRIO_COUNT];        /* Send returned an error */
+    uint64_t rejected[CYXCHAT_PRIO_COUNT];      /* Over cap or out of slots */
+} cyxchat_sched_stats_t;
+
+/**
+ * Send callback for flushed frames
+ *
+ * @param user_data     Flush user data
+ * @param to            Destination peer
+ * @param data          Frame
+ * @param len           Frame length
+ * @return CYXCHAT_OK, or an error (frame is dropped and counted failed)
+ */
+typedef cyxchat_error_t (*cyxchat_sched_send_fn)(
+    void *user_data,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len
+);
+
+/**
+ * Create outbound scheduler
+ *
+ * @param ctx           Output context
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_sched_create(cyxchat_sched_ctx_t **ctx);
+
+/**
+ * Destroy outbound scheduler (queued frames are discarded)
+ *
+ * @param ctx           Context to destroy
+ */
+CYXCHAT_API void cyxchat_sched_destroy(cyxchat_sched_ctx_t *ctx);
+
+/**
+ * Queue a frame for a peer
+ *
+ * Each peer has one FIFO per class, bounded by the class cap in bytes.
+ * Background and bulk frames cannot take the last
+ * CYXCHAT_SCHED_RESERVED slots, so a full transfer never keeps a chat
+ * message out of the queue.
+ *
+ * @param ctx           Scheduler
+ * @param to            Destination peer
+ * @param prio          Traffic class
+ * @param data          Frame (copied)
+ * @param len           Frame length (1..CYXCHAT_SCHED_FRAME_MAX)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_FULL if over cap (retry later),
+ *         CYXCHAT_ERR_INVALID for a bad class or length
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_sched_enqueue(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    cyxchat_prio_t prio,
+    const uint8_t *data,
+    size_t len
+);
+
+/**
+ * Send queued frames in priority order
+ *
+ * Classes drain strictly in order (control first, bulk last); within a
+ * class, peers take turns one frame at a time. Stops once budget_bytes
+ * have been sent (the frame that crosses it still goes).
+ *
+ * @param ctx           Scheduler
+ * @param send          Send callback
+ * @param user_data     Callback user data
+ * @param budget_bytes  Bytes to release (0 = everything)
+ * @return Frames sent
+ */
+CYXCHAT_API size_t cyxchat_sched_flush(
+    cyxchat_sched_ctx_t *ctx,
+    cyxchat_sched_send_fn send,
+    void *user_data,
+    size_t budget_bytes
+);
+
+/**
+ * Bytes queued for a peer in one class
+ *
+ * @param ctx           Scheduler
+ * @param to            Peer
+ * @param prio          Traffic class
+ * @return Queued bytes (0 if none)
+ */
+CYXCHAT_API size_t cyxchat_sched_queued_bytes(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    cyxchat_prio_t prio
+);
+
+/**
+ * Discard everything queued for a peer
+ *
+ * @param ctx           Scheduler
+ * @param to            Peer
+ */
+CYXCHAT_API void cyxchat_sched_drop_peer(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to
+);
+
+/**
+ * Get scheduler statistics
+ *
+ * @param ctx           Scheduler
+ * @param stats_out     Output statistics
+ */
+CYXCHAT_API void cyxchat_sched_get_stats(
+    cyxchat_sched_ctx_t *ctx,
+    cyxchat_sched_stats_t *stats_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_SCHED_H */
@@ -0,0 +1,188 @@
+/**
+ * CyxChat Timer Wheel API
+ * Hierarchical timing wheel for connection, relay, DNS and presence deadlines
+ */
+
+#ifndef CYXCHAT_TIMER_H
+#define CYXCHAT_TIMER_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define CYXCHAT_TIMER_LEVELS        5       /* Wheel levels */
+#define CYXCHAT_TIMER_SLOT_BITS     6
+#define CYXCHAT_TIMER_SLOTS         (1 << CYXCHAT_TIMER_SLOT_BITS)
+
+/* Longest delay placed directly (~12.4 days at 1 ms); longer timers re-cascade */
+#define CYXCHAT_TIMER_MAX_DELAY \
+    ((1ULL << (CYXCHAT_TIMER_SLOT_BITS * CYXCHAT_TIMER_LEVELS)) - 1)
+
+/* Returned by next_deadline when nothing is scheduled */
+#define CYXCHAT_TIMER_NONE          UINT64_MAX
+
+/* ============================================================
+ * Timer Types
+ * ============================================================ */
+
+typedef struct cyxchat_timer_wheel cyxchat_timer_wheel_t;
+typedef struct cyxchat_timer cyxchat_timer_t;
+
+/**
+ * Timer expiry callback
+ * The timer is already unscheduled when this runs; the callback may
+ * schedule it again or schedule/cancel any other timer.
+ */
+typedef void (*cyxchat_timer_cb_t)(
+    cyxchat_timer_t *timer,
+    void *user_data,
+    uint64_t now_ms
+);
+
+/*
+ * Intrusive timer, embedded in the owning record. Zero-initialised
+ * means not scheduled. The record must not move or be freed while
+ * the timer is scheduled.
+ */
+struct cyxchat_timer {
+    cyxchat_timer_t *next;
+    cyxchat_timer_t **pprev;                /* NULL when not scheduled */
+    uint64_t expires;                       /* Absolute wheel time (ms) */
+    cyxchat_timer_cb_t callback;
+    void *user_data;
+    uint8_t level;
+    uint8_t slot;
+};
+
+/* ============================================================
+ * Wheel Lifecycle
+ * ============================================================ */
+
+/**
+ * Create a timer wheel
+ *
+ * @param wheel         Output wheel
+ * @param now_ms        Initial wheel time
+ * @return CYXCHAT_OK on success
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_timer_wheel_create(
+    cyxchat_timer_wheel_t **wheel,
+    uint64_t now_ms
+);
+
+/**
+ * Destroy a timer wheel
+ * Timers still scheduled are dropped without firing. Every context
+ * attached to a shared wheel must be detached or destroyed first.
+ *
+ * @param wheel         Wheel to destroy
+ */
+CYXCHAT_API void cyxchat_timer_wheel_destroy(cyxchat_timer_wheel_t *wheel);
+
+/* ============================================================
+ * Scheduling
+ * ============================================================ */
+
+/**
+ * Schedule (or re-schedule) a timer
+ * A deadline at or before the current wheel time fires on the next
+ * advance.
+ *
+ * @param wheel         Wheel
+ * @param timer         Timer (rescheduled if already pending)
+ * @param expires_ms    Absolute wheel time
+ * @param callback      Expiry callback
+ * @param user_data     Callback user data
+ */
+CYXCHAT_API void cyxchat_timer_schedule(
+    cyxchat_timer_wheel_t *wheel,
+    cyxchat_timer_t *timer,
+    uint64_t expires_ms,
+    cyxchat_timer_cb_t callback,
+    void *user_data
+);
+
+/**
+ * Cancel a timer (no-op if not scheduled)
+ *
+ * @param wheel         Wheel the timer was scheduled on
+ * @param timer         Timer
+ */
+CYXCHAT_API void cyxchat_timer_cancel(
+    cyxchat_timer_wheel_t *wheel,
+    cyxchat_timer_t *timer
+);
+
+/**
+ * Move a scheduled timer to another wheel, keeping its remaining delay
+ *
+ * @param from          Wheel the timer is scheduled on
+ * @param to            Destination wheel
+ * @param timer         Timer (no-op if not scheduled)
+ */
+CYXCHAT_API void cyxchat_timer_move(
+    cyxchat_timer_wheel_t *from,
+    cyxchat_timer_wheel_t *to,
+    cyxchat_timer_t *timer
+);
+
+/**
+ * Check if timer is scheduled
+ *
+ * @param timer         Timer
+ * @return 1 if scheduled, 0 otherwise
+ */
+CYXCHAT_API int cyxchat_timer_pending(const cyxchat_timer_t *timer);
+
+/* ============================================================
+ * Advancing
+ * ============================================================ */
+
+/**
+ * Advance wheel time and fire expired timers
+ * Only slots whose time range has passed are visited. Time never moves
+ * backwards; an earlier now_ms just fires already-expired timers.
+ *
+ * @param wheel         Wheel
+ * @param now_ms        Current time
+ * @return Number of timers fired
+ */
+CYXCHAT_API int cyxchat_timer_advance(cyxchat_timer_wheel_t *wheel, uint64_t now_ms);
+
+/**
+ * Get earliest time the wheel needs to be advanced
+ * Exact for deadlines under 64 ms away, otherwise the start of the
+ * slot holding the next deadline (never later than the deadline).
+ *
+ * @param wheel         Wheel
+ * @return Absolute wheel time, or CYXCHAT_TIMER_NONE if empty
+ */
+CYXCHAT_API uint64_t cyxchat_timer_next_deadline(cyxchat_timer_wheel_t *wheel);
+
+/**
+ * Get current wheel time
+ *
+ * @param wheel         Wheel
+ * @return Time of last advance (or creation)
+ */
+CYXCHAT_API uint64_t cyxchat_timer_now(cyxchat_timer_wheel_t *wheel);
+
+/**
+ * Get number of scheduled timers
+ *
+ * @param wheel         Wheel
+ * @return Timer count
+ */
+CYXCHAT_API size_t cyxchat_timer_count(cyxchat_timer_wheel_t *wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_TIMER_H */
@@ -0,0 +1,292 @@
+/**
+ * CyxChat Trace API
+ * Log level gating and binary event trace ring
+ */
+
+#ifndef CYXCHAT_TRACE_H
+#define CYXCHAT_TRACE_H
+
+#include "types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ============================================================
+ * Log Levels
+ * ============================================================ */
+
+#define CYXCHAT_LOG_LEVEL_DEBUG     0
+#define CYXCHAT_LOG_LEVEL_INFO      1
+#define CYXCHAT_LOG_LEVEL_WARN      2
+#define CYXCHAT_LOG_LEVEL_ERROR     3
+#define CYXCHAT_LOG_LEVEL_NONE      4
+
+/* Minimum level compiled in (set by CMake, see CYXCHAT_LOG_LEVEL) */
+#ifndef CYXCHAT_LOG_LEVEL
+#define CYXCHAT_LOG_LEVEL           CYXCHAT_LOG_LEVEL_INFO
+#endif
+
+/*
+ * True if a statement at `lvl` would be emitted. The compile-time half
+ * is constant, so gated blocks below CYXCHAT_LOG_LEVEL are removed.
+ */
+#define CYXCHAT_LOG_ENABLED(lvl) \
+    ((lvl) >= CYXCHAT_LOG_LEVEL && (lvl) >= cyxchat_log_get_level())
+
+/*
+ * Gated wrappers for library sources (require <cyxwiz/log.h>).
+ * Arguments are not evaluated when the level is disabled.
+ */
+#define CYXCHAT_LOG_DEBUG(...) do { \
+    if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_DEBUG)) CYXWIZ_DEBUG(__VA_ARGS__); \
+} while (0)
+#define CYXCHAT_LOG_INFO(...) do { \
+    if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_INFO)) CYXWIZ_INFO(__VA_ARGS__); \
+} while (0)
+#define CYXCHAT_LOG_WARN(...) do { \
+    if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_WARN)) CYXWIZ_WARN(__VA_ARGS__); \
+} while (0)
+
+/**
+ * Set runtime log level (statements below it are skipped)
+ *
+ * @param level         CYXCHAT_LOG_LEVEL_*
+ */
+CYXCHAT_API void cyxchat_log_set_level(int level);
+
+/**
+ * Get runtime log level
+ *
+ * @return CYXCHAT_LOG_LEVEL_*
+ */
+CYXCHAT_API int cyxchat_log_get_level(void);
+
+/**
+ * Format the first 8 bytes of a node ID as 16 hex chars
+ *
+ * @param id            Node ID
+ * @param hex_out       Output buffer (17 bytes)
+ */
+CYXCHAT_API void cyxchat_log_peer_prefix(const cyxwiz_node_id_t *id, char *hex_out);
+
+/* ============================================================
+ * Trace Events
+ * ============================================================ */
+
+#define CYXCHAT_TRACE_RING_SIZE     1024    /* Events kept (power of 2) */
+#define CYXCHAT_TRACE_PEER_PREFIX   4       /* Node ID bytes recorded */
+
+typedef enum {
+    CYXCHAT_TRACE_NONE = 0,
+    CYXCHAT_TRACE_MSG_RECV,                 /* Onion delivery accepted */
+    CYXCHAT_TRACE_MSG_DUP,                  /* Onion delivery dropped as duplicate */
+    CYXCHAT_TRACE_FRAG_RECV,                /* Fragment received */
+    CYXCHAT_TRACE_FRAG_DONE,                /* Fragmented message reassembled */
+    CYXCHAT_TRACE_MSG_SEND,                 /* Message sent */
+    CYXCHAT_TRACE_FRAG_SEND,                /* Fragment sent */
+    CYXCHAT_TRACE_SEND_FAIL,                /* Send failed */
+    CYXCHAT_TRACE_ANNOUNCE_SENT,            /* Key exchange announce sent */
+    CYXCHAT_TRACE_ANNOUNCE_FAIL,            /* Key exchange announce failed */
+    CYXCHAT_TRACE_KEY_EXCHANGE,             /* Peer key accepted */
+    CYXCHAT_TRACE_SEND_BEGIN,               /* cyxchat_send_text entered */
+    CYXCHAT_TRACE_ONION_TX,                 /* Handed to the onion layer */
+    CYXCHAT_TRACE_TRANSPORT_TX,             /* Wrapped datagram reached the transport */
+    CYXCHAT_TRACE_RELAY_TX,                 /* Wrapped datagram sent through a relay */
+    CYXCHAT_TRACE_TRANSPORT_RX,             /* Datagram taken from the transport */
+    CYXCHAT_TRACE_RELAY_RX,                 /* Datagram taken from a relay session */
+    CYXCHAT_TRACE_RECV_QUEUED,              /* Placed in the receive queue */
+    CYXCHAT_TRACE_RECV_POLLED,              /* Taken from the receive queue by the app */
+    CYXCHAT_TRACE_CALLBACK,                 /* Message callback returned */
+    CYXCHAT_TRACE_EVENT_COUNT
+} cyxchat_trace_event_id_t;
+
+/* Trace record (fixed size, binary) */
+typedef struct {
+    uint64_t timestamp_us;                  /* Monotonic microseconds */
+    uint32_t seq;                           /* Global sequence number */
+    uint16_t event;                         /* cyxchat_trace_event_id_t */
+    uint8_t peer[CYXCHAT_TRACE_PEER_PREFIX];/* Node ID prefix (zero if none) */
+    uint32_t size;                          /* Payload bytes (event specific) */
+    uint32_t trace_id;                      /* Sampled message, 0 if none */
+} cyxchat_trace_event_t;
+
+/*
+ * Message tracing: a sampled message's ID yields a nonzero trace ID and
+ * every layer it crosses records a stage event carrying that ID. The ID
+ * comes from the message ID itself, so both ends sample the same
+ * messages without anything extra on the wire.
+ */
+
+/* Compile the trace points out with -DCYXCHAT_TRACE_DISABLED */
+#ifdef CYXCHAT_TRACE_DISABLED
+#define CYXCHAT_TRACE(event, peer, size) ((void)0)
+#define CYXCHAT_TRACE_MSG(event, trace_id, peer, size) ((void)0)
+#define CYXCHAT_TRACE_ID(msg_id) ((uint32_t)0)
+#define CYXCHAT_TRACE_CURRENT(event, peer, size) ((void)0)
+#define CYXCHAT_TRACE_MARK_RX(event, size) ((void)0)
+#define CYXCHAT_TRACE_CLAIM_RX(trace_id, peer) ((void)0)
+#else
+#define CYXCHAT_TRACE(event, peer, size) \
+    cyxchat_trace_record((uint16_t)(event), (peer), (uint32_t)(size))
+#define CYXCHAT_TRACE_MSG(event, trace_id, peer, size) \
+    cyxchat_trace_record_msg((uint16_t)(event), (trace_id), (peer), (uint32_t)(size))
+#define CYXCHAT_TRACE_ID(msg_id) cyxchat_trace_sample(msg_id)
+#define CYXCHAT_TRACE_CURRENT(event, peer, size) \
+    cyxchat_trace_record_current((uint16_t)(event), (peer), (uint32_t)(size))
+#define CYXCHAT_TRACE_MARK_RX(event, size) \
+    cyxchat_trace_mark_rx((uint16_t)(event), (uint32_t)(size))
+#define CYXCHAT_TRACE_CLAIM_RX(trace_id, peer) cyxchat_trace_claim_rx((trace_id), (peer))
+#endif
+
+/**
+ * Enable or disable trace recording at runtime (enabled by default)
+ *
+ * @param enabled       1 to record, 0 to skip
+ */
+CYXCHAT_API void cyxchat_trace_set_enabled(int enabled);
+
+/**
+ * Record an event into the ring
+ * Lock-free; safe to call from any thread. Oldest events are overwritten.
+ *
+ * @param event         cyxchat_trace_event_id_t
+ * @param peer          Peer node ID (may be NULL)
+ * @param size          Payload size or event-specific value
+ */
+CYXCHAT_API void cyxchat_trace_record(
+    uint16_t event,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+);
+
+/**
+ * Record an event for a traced message
+ * Untraced messages (trace_id 0) still record, like cyxchat_trace_record.
+ *
+ * @param event         cyxchat_trace_event_id_t
+ * @param trace_id      From cyxchat_trace_sample
+ * @param peer          Peer node ID (may be NULL)
+ * @param size          Payload size or event-specific value
+ */
+CYXCHAT_API void cyxchat_trace_record_msg(
+    uint16_t event,
+    uint32_t trace_id,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+);
+
+/**
+ * Trace one message in every `one_in` (0 disables, the default)
+ *
+ * @param one_in        Sampling interval
+ */
+CYXCHAT_API void cyxchat_trace_set_sample_rate(uint32_t one_in);
+
+/**
+ * Get a message's trace ID if it is sampled
+ *
+ * @param msg_id        Message ID
+ * @return Trace ID, 0 if not sampled or tracing is off
+ */
+CYXCHAT_API uint32_t cyxchat_trace_sample(const cyxchat_msg_id_t *msg_id);
+
+/**
+ * Set the message being sent on this thread
+ * Transports and relays below the onion layer only see ciphertext;
+ * they stamp TRANSPORT_TX / RELAY_TX with this ID instead.
+ *
+ * @param trace_id      Trace ID, 0 when the send returns
+ */
+CYXCHAT_API void cyxchat_trace_set_current(uint32_t trace_id);
+
+/**
+ * Get the message being sent on this thread
+ *
+ * @return Trace ID, 0 if none
+ */
+CYXCHAT_API uint32_t cyxchat_trace_current(void);
+
+/**
+ * Record a stage for the message being sent on this thread
+ * Does nothing when no traced send is in progress.
+ *
+ * @param event         cyxchat_trace_event_id_t
+ * @param peer          Next hop (may be NULL)
+ * @param size          Datagram size
+ */
+CYXCHAT_API void cyxchat_trace_record_current(
+    uint16_t event,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+);
+
+/**
+ * Note that a datagram arrived on this thread
+ * The time is kept until the chat layer decrypts the message it carries
+ * and claims it with cyxchat_trace_claim_rx. Only done while sampling.
+ *
+ * @param event         CYXCHAT_TRACE_TRANSPORT_RX or CYXCHAT_TRACE_RELAY_RX
+ * @param size          Datagram size
+ */
+CYXCHAT_API void cyxchat_trace_mark_rx(uint16_t event, uint32_t size);
+
+/**
+ * Record the pending arrival for a traced message
+ *
+ * @param trace_id      Trace ID (nothing is recorded for 0)
+ * @param peer          Sending peer
+ */
+CYXCHAT_API void cyxchat_trace_claim_rx(uint32_t trace_id, const cyxwiz_node_id_t *peer);
+
+/**
+ * Copy recorded events, oldest first
+ * Slots being overwritten during the copy are skipped.
+ *
+ * @param events_out    Output array
+ * @param max_events    Array capacity
+ * @return Number of events copied
+ */
+CYXCHAT_API size_t cyxchat_trace_dump(
+    cyxchat_trace_event_t *events_out,
+    size_t max_events
+);
+
+/**
+ * Export the ring in Chrome trace event format
+ *
+ * Writes {"traceEvents": [...]} for chrome://tracing or Perfetto. Each
+ * traced message gets its own row: a stage becomes a span from the
+ * previous stage of the same message, named after the stage it ends in.
+ * Untraced events appear as instants on row 0. Timestamps are monotonic
+ * microseconds. The output is NUL-terminated.
+ *
+ * @param buf           Output buffer
+ * @param buf_size      Buffer size
+ * @param len_out       Bytes written (without the NUL)
+ * @return CYXCHAT_OK, CYXCHAT_ERR_FULL if buf is too small
+ */
+CYXCHAT_API cyxchat_error_t cyxchat_trace_export_chrome(
+    char *buf,
+    size_t buf_size,
+    size_t *len_out
+);
+
+/**
+ * Discard all recorded events
+ */
+CYXCHAT_API void cyxchat_trace_clear(void);
+
+/**
+ * Get event name
+ *
+ * @param event         cyxchat_trace_event_id_t
+ * @return Static string
+ */
+CYXCHAT_API const char* cyxchat_trace_event_name(uint16_t event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CYXCHAT_TRACE_H */
@@ -48,7 +48,7 @@ extern "C" {
 #define CYXCHAT_CHUNK_SIZE          100
 #define CYXCHAT_MAX_GROUP_MEMBERS   50      /* Max group size */
 #define CYXCHAT_MAX_GROUP_ADMINS    5       /* Max admins per group */
-#define CYXCHAT_MAX_CONTACTS        256     /* Max contacts */
+#define CYXCHAT_MAX_CONTACTS        256     /* Default contact list size */
 
 /* DHT-based file transfer constants
  * DHT max value is 160 bytes, minus 40 bytes crypto overhead = 120 bytes effective */
@@ -59,9 +59,25 @@ extern "C" {
 #define CYXCHAT_FILE_OFFER_TIMEOUT_MS 30000 /* 30 second offer timeout */
 
 /* ============================================================
- * Message Types (0x10-0x3F range)
+ * Message Types
+ *
+ * The first byte of a datagram selects its handler (see dispatch.h),
+ * so every protocol owns a disjoint range:
+ *   0x01-0x0F  cyxwiz discovery     0xB0-0xBF  relay (relay.h)
+ *   0x10-0x4F  chat, groups, files  0xC0-0xCF  connection control
+ *   0x50-0x5F  header-framed        0xD0-0xDF  DNS
+ *   0xF0-0xFF  offline mailboxes
+ *
+ * Header-framed messages (cyxchat_msg_header_t: CyxMail, group and
+ * presence) start with the version byte, CYXCHAT_MSG_FRAMED | version,
+ * and carry their type second; the connection layer leaves them to its
+ * data callback, which routes by data[1] (CyxMail is 0xE0-0xEF there).
  * ============================================================ */
 
+/* Header-framed messages (0x50-0x5F) - first byte is the version */
+#define CYXCHAT_MSG_FRAMED          0x50    /* Version byte base */
+#define CYXCHAT_MSG_FRAMED_LAST     0x5F
+
 /* Direct messaging (0x10-0x1F) */
 #define CYXCHAT_MSG_TEXT            0x10    /* Text message */
 #define CYXCHAT_MSG_ACK             0x11    /* Delivery ACK */
@@ -96,6 +112,18 @@ extern "C" {
 #define CYXCHAT_MSG_FILE_CANCEL     0x44    /* Cancel in-progress transfer */
 #define CYXCHAT_MSG_FILE_DHT_READY  0x45    /* DHT chunks stored notification */
 
+/* Connection control (0xC0-0xCF) - consumed by the connection layer */
+#define CYXCHAT_MSG_CONN_CANDIDATES   0xC0  /* ICE candidate list */
+#define CYXCHAT_MSG_CONN_CHECK        0xC1  /* Connectivity check */
+#define CYXCHAT_MSG_CONN_CHECK_ACK    0xC2  /* Connectivity check reply */
+#define CYXCHAT_MSG_LABEL_REQUEST     0xC3  /* Ask the next hop for a label */
+#define CYXCHAT_MSG_LABEL_MAPPING     0xC4  /* Label granted (or refused) */
+#define CYXCHAT_MSG_LABEL_RELEASE     0xC5  /* Path torn down from upstream */
+#define CYXCHAT_MSG_LABEL_WITHDRAW    0xC6  /* Path broken downstream */
+#define CYXCHAT_MSG_LABEL_DATA        0xC7  /* Label-switched datagram */
+#define CYXCHAT_MSG_CONN_MULTIPATH    0xC8  /* Datagram sent on both paths */
+#define CYXCHAT_MSG_LABEL_BACK        0xC9  /* Label-switched, toward the ingress */
+
 /* DNS Messages (0xD0-0xD9) - CyxChat internal DNS */
 #define CYXCHAT_MSG_DNS_REGISTER      0xD0  /* Register name with signature */
 #define CYXCHAT_MSG_DNS_REGISTER_ACK  0xD1  /* Registration confirmed */
@@ -105,7 +133,7 @@ extern "C" {
 #define CYXCHAT_MSG_DNS_UPDATE_ACK    0xD5  /* Update confirmed */
 #define CYXCHAT_MSG_DNS_ANNOUNCE      0xD6  /* Gossip announcement */
 
-/* CyxMail Messages (0xE0-0xEF) - Email protocol */
+/* CyxMail Messages (0xE0-0xEF) - Email protocol, header type (data[1]) */
 #define CYXCHAT_MSG_MAIL_SEND         0xE0  /* Send email to mailbox */
 #define CYXCHAT_MSG_MAIL_ACK          0xE1  /* Delivery ACK */
 #define CYXCHAT_MSG_MAIL_LIST         0xE2  /* List mailbox contents */
@@ -118,6 +146,13 @@ extern "C" {
 #define CYXCHAT_MSG_MAIL_READ_RECEIPT 0xE9  /* Read receipt */
 #define CYXCHAT_MSG_MAIL_BOUNCE       0xEA  /* Delivery failed */
 
+/* Offline delivery (0xF0-0xF4) - DHT mailboxes (offline.h) */
+#define CYXCHAT_MSG_OFFLINE_PUT       0xF0  /* Store items under a mailbox key */
+#define CYXCHAT_MSG_OFFLINE_PUT_ACK   0xF1  /* Items stored */
+#define CYXCHAT_MSG_OFFLINE_GET       0xF2  /* Page through a mailbox key */
+#define CYXCHAT_MSG_OFFLINE_ITEMS     0xF3  /* One page of items */
+#define CYXCHAT_MSG_OFFLINE_DELETE    0xF4  /* Drop items (with their tokens) */
+
 /* ============================================================
  * Mail Constants
  * ============================================================ */
@@ -175,6 +210,13 @@ typedef struct {
     uint8_t bytes[CYXCHAT_FILE_ID_SIZE];
 } cyxchat_file_id_t;
 
+/* One datagram of a vectored send */
+typedef struct {
+    const cyxwiz_node_id_t *to;
+    const uint8_t *data;
+    size_t len;
+} cyxchat_datagram_t;
+
 /* ============================================================
  * Message Status
  * ============================================================ */
@@ -219,6 +261,20 @@ typedef enum {
     CYXCHAT_FILE_REJECT_BLOCKED   = 3     /* Sender is blocked */
 } cyxchat_file_reject_reason_t;
 
+/* ============================================================
+ * Traffic Classes
+ * ============================================================ */
+
+/* Outbound priority (lower value goes first) */
+typedef enum {
+    CYXCHAT_PRIO_CONTROL     = 0,       /* ACKs, transfer control */
+    CYXCHAT_PRIO_INTERACTIVE = 1,       /* Text, edits, reactions */
+    CYXCHAT_PRIO_BACKGROUND  = 2,       /* Typing, presence, gossip */
+    CYXCHAT_PRIO_BULK        = 3        /* File chunks */
+} cyxchat_prio_t;
+
+#define CYXCHAT_PRIO_COUNT  4
+
 /* ============================================================
  * Error Codes
  * ============================================================ */
@@ -265,7 +321,9 @@ typedef struct {
  * Protocol Version
  * ============================================================ */
 
-#define CYXCHAT_PROTOCOL_VERSION   1
+/* Also the first wire byte of header-framed messages, so it stays in
+ * 0x50-0x5F (CYXCHAT_MSG_FRAMED | version) clear of discovery's types */
+#define CYXCHAT_PROTOCOL_VERSION   (CYXCHAT_MSG_FRAMED | 1)
 
 #ifdef __cplusplus
 }
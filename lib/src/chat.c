@@ -5,6 +5,12 @@
 
 #include <cyxchat/chat.h>
 #include <cyxchat/file.h>
+#include <cyxchat/offline.h>
+#include <cyxchat/dedup.h>
+#include <cyxchat/rng.h>
+#include <cyxchat/sched.h>
+#include <cyxchat/trace.h>
+#include <cyxchat/metrics.h>
 #include <cyxwiz/onion.h>
 #include <cyxwiz/crypto.h>
 #include <cyxwiz/memory.h>
@@ -42,7 +48,6 @@
  * Ring buffer for storing received messages for FFI polling
  */
 
-#define RECV_QUEUE_SIZE      32
 #define RECV_MSG_MAX_DATA    4096
 
 typedef struct {
@@ -50,6 +55,7 @@ typedef struct {
     uint8_t type;
     uint8_t data[RECV_MSG_MAX_DATA];
     size_t data_len;
+    uint32_t trace_id;      /* Sampled message, 0 if none */
     int valid;
 } cyxchat_recv_msg_t;
 
@@ -59,7 +65,6 @@ typedef struct {
  * Holds incomplete fragmented messages until all parts arrive
  */
 
-#define FRAG_BUFFER_SIZE     8
 #define FRAG_MAX_CHUNKS      32
 #define FRAG_MAX_TEXT        4096  /* Max reassembled message size */
 #define FRAG_TIMEOUT_MS      30000 /* Discard after 30 seconds */
@@ -77,6 +82,20 @@ typedef struct {
     int valid;
 } cyxchat_frag_entry_t;
 
+/* ============================================================
+ * Send Times
+ * ============================================================
+ * Recent sends by message ID, so the matching ACK can be timed. Oldest
+ * entries are overwritten; an ACK that arrives later goes unrecorded.
+ */
+
+#define ACK_TRACK_SIZE       32
+
+typedef struct {
+    cyxchat_msg_id_t msg_id;
+    uint64_t sent_us;           /* 0 = free */
+} cyxchat_ack_track_t;
+
 /* ============================================================
  * Internal Structures
  * ============================================================ */
@@ -85,17 +104,40 @@ struct cyxchat_ctx {
     cyxwiz_onion_ctx_t *onion;
     cyxwiz_node_id_t local_id;
 
-    /* Receive queue (ring buffer) */
-    cyxchat_recv_msg_t recv_queue[RECV_QUEUE_SIZE];
+    /* Receive queue (ring buffer, carved after the struct) */
+    cyxchat_recv_msg_t *recv_queue;
+    size_t recv_size;   /* Slots (one stays open) */
     size_t recv_head;   /* Next write position */
     size_t recv_tail;   /* Next read position */
 
-    /* Fragment reassembly buffer */
-    cyxchat_frag_entry_t frag_buffer[FRAG_BUFFER_SIZE];
+    /* Fragment reassembly buffer (carved after the queue) */
+    cyxchat_frag_entry_t *frag_buffer;
+    size_t frag_count;
+
+    size_t footprint;   /* Context plus queue and fragment buffers */
+
+    /* Duplicate suppression (retransmits, multipath echoes) */
+    cyxchat_dedup_ctx_t *dedup;
+
+    /* Buffered random pool for message IDs */
+    cyxchat_rng_t *rng;
+
+    /* Background and bulk frames waiting behind interactive traffic */
+    cyxchat_sched_ctx_t *sched;
 
     /* File module context (for message routing) */
     cyxchat_file_ctx_t *file_ctx;
 
+    /* Mailbox for recipients we cannot reach (and our own drain) */
+    cyxchat_offline_ctx_t *offline;
+
+    /* Send times awaiting an ACK (send-to-ACK latency) */
+    cyxchat_ack_track_t ack_track[ACK_TRACK_SIZE];
+    size_t ack_track_next;
+
+    /* Poll the onion context in cyxchat_poll (off when conn_poll does) */
+    int poll_onion;
+
     /* Callbacks */
     cyxchat_on_message_t on_message;
     void *on_message_data;
@@ -323,7 +365,7 @@ static cyxchat_frag_entry_t* frag_find_or_create(
     uint64_t now_ms
 ) {
     /* First, try to find existing entry */
-    for (int i = 0; i < FRAG_BUFFER_SIZE; i++) {
+    for (size_t i = 0; i < ctx->frag_count; i++) {
         cyxchat_frag_entry_t *e = &ctx->frag_buffer[i];
         if (e->valid &&
             memcmp(&e->from, from, sizeof(cyxwiz_node_id_t)) == 0 &&
@@ -336,7 +378,7 @@ static cyxchat_frag_entry_t* frag_find_or_create(
     cyxchat_frag_entry_t *oldest = NULL;
     uint64_t oldest_time = UINT64_MAX;
 
-    for (int i = 0; i < FRAG_BUFFER_SIZE; i++) {
+    for (size_t i = 0; i < ctx->frag_count; i++) {
         cyxchat_frag_entry_t *e = &ctx->frag_buffer[i];
         if (!e->valid) {
             /* Empty slot found */
@@ -432,7 +474,7 @@ static void frag_reassemble(cyxchat_frag_entry_t *entry, uint8_t *out, size_t *o
 }
 
 static void frag_expire_old(cyxchat_ctx_t *ctx, uint64_t now_ms) {
-    for (int i = 0; i < FRAG_BUFFER_SIZE; i++) {
+    for (size_t i = 0; i < ctx->frag_count; i++) {
         cyxchat_frag_entry_t *e = &ctx->frag_buffer[i];
         if (e->valid && now_ms - e->start_time_ms > FRAG_TIMEOUT_MS) {
             e->valid = 0;
@@ -445,7 +487,7 @@ static void frag_expire_old(cyxchat_ctx_t *ctx, uint64_t now_ms) {
  * ============================================================ */
 
 static int queue_is_full(cyxchat_ctx_t *ctx) {
-    return ((ctx->recv_head + 1) % RECV_QUEUE_SIZE) == ctx->recv_tail;
+    return ((ctx->recv_head + 1) % ctx->recv_size) == ctx->recv_tail;
 }
 
 static int queue_is_empty(cyxchat_ctx_t *ctx) {
@@ -457,11 +499,12 @@ static int queue_push(
     const cyxwiz_node_id_t *from,
     uint8_t type,
     const uint8_t *data,
-    size_t data_len
+    size_t data_len,
+    uint32_t trace_id
 ) {
     if (queue_is_full(ctx)) {
         /* Drop oldest message */
-        ctx->recv_tail = (ctx->recv_tail + 1) % RECV_QUEUE_SIZE;
+        ctx->recv_tail = (ctx->recv_tail + 1) % ctx->recv_size;
     }
 
     cyxchat_recv_msg_t *msg = &ctx->recv_queue[ctx->recv_head];
@@ -469,9 +512,14 @@ static int queue_push(
     msg->type = type;
     msg->data_len = (data_len > RECV_MSG_MAX_DATA) ? RECV_MSG_MAX_DATA : data_len;
     memcpy(msg->data, data, msg->data_len);
+    msg->trace_id = trace_id;
     msg->valid = 1;
 
-    ctx->recv_head = (ctx->recv_head + 1) % RECV_QUEUE_SIZE;
+    if (trace_id) {
+        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_RECV_QUEUED, trace_id, from, msg->data_len);
+    }
+
+    ctx->recv_head = (ctx->recv_head + 1) % ctx->recv_size;
     return 1;
 }
 
@@ -497,15 +545,72 @@ static int queue_pop(
         *data_len = msg->data_len;
     }
 
+    if (msg->trace_id) {
+        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_RECV_POLLED, msg->trace_id, &msg->from, msg->data_len);
+    }
+
     msg->valid = 0;
-    ctx->recv_tail = (ctx->recv_tail + 1) % RECV_QUEUE_SIZE;
+    ctx->recv_tail = (ctx->recv_tail + 1) % ctx->recv_size;
     return 1;
 }
 
+/* ============================================================
+ * Send-to-ACK Timing
+ * ============================================================ */
+
+static void ack_track_sent(cyxchat_ctx_t *ctx, const cyxchat_msg_id_t *msg_id)
+{
+#ifndef CYXCHAT_METRICS_DISABLED
+    cyxchat_ack_track_t *t = &ctx->ack_track[ctx->ack_track_next];
+    ctx->ack_track_next = (ctx->ack_track_next + 1) % ACK_TRACK_SIZE;
+    memcpy(&t->msg_id, msg_id, sizeof(t->msg_id));
+    t->sent_us = cyxchat_metrics_now_us();
+#else
+    (void)ctx;
+    (void)msg_id;
+#endif
+}
+
+static void ack_track_acked(cyxchat_ctx_t *ctx, const cyxchat_msg_id_t *msg_id)
+{
+#ifndef CYXCHAT_METRICS_DISABLED
+    for (size_t i = 0; i < ACK_TRACK_SIZE; i++) {
+        cyxchat_ack_track_t *t = &ctx->ack_track[i];
+        if (t->sent_us != 0 && cyxchat_msg_id_cmp(&t->msg_id, msg_id) == 0) {
+            CYXCHAT_OBSERVE(CYXCHAT_METRIC_SEND_ACK, cyxchat_metrics_now_us() - t->sent_us);
+            t->sent_us = 0;  /* Time the first ACK only */
+            return;
+        }
+    }
+#else
+    (void)ctx;
+    (void)msg_id;
+#endif
+}
+
 /* ============================================================
  * Onion Delivery Callback
  * ============================================================ */
 
+/*
+ * Message types that carry the compact wire header (and so a msg_id).
+ * File transfer messages use their own framing after the type byte.
+ */
+static int has_wire_header(uint8_t type) {
+    switch (type) {
+        case CYXCHAT_MSG_TEXT:
+        case CYXCHAT_MSG_ACK:
+        case CYXCHAT_MSG_READ:
+        case CYXCHAT_MSG_TYPING:
+        case CYXCHAT_MSG_REACTION:
+        case CYXCHAT_MSG_DELETE:
+        case CYXCHAT_MSG_EDIT:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
 /*
  * Handle incoming messages from onion routing layer
  */
@@ -520,14 +625,6 @@ static void on_onion_delivery(
         return;
     }
 
-    /* Log received message */
-    char hex_id[17];
-    for (int i = 0; i < 8; i++) {
-        snprintf(hex_id + i*2, 3, "%02x", from->bytes[i]);
-    }
-    CYXWIZ_INFO("Received message from peer %.16s... (%zu bytes, type=0x%02x)",
-                hex_id, len, data[0]);
-
     /* Parse wire header */
     uint8_t type;
     uint16_t flags;
@@ -536,8 +633,38 @@ static void on_onion_delivery(
     size_t offset = deserialize_wire_header(data, len, &type, &flags, &msg_id);
     if (offset == 0) return;
 
+    /* Drop duplicates before any copy or callback. Fragments are keyed
+     * by index so each one is suppressed individually. */
+    int is_fragment = (type == CYXCHAT_MSG_TEXT && (flags & CYXCHAT_FLAG_FRAGMENTED));
+    uint32_t trace_id = has_wire_header(type) ? CYXCHAT_TRACE_ID(&msg_id) : 0;
+    CYXCHAT_TRACE_CLAIM_RX(trace_id, from);
+    if (has_wire_header(type)) {
+        uint8_t sub_id = 0;
+        if (is_fragment) {
+            if (len < offset + 1) return;
+            sub_id = (uint8_t)(data[offset] + 1);
+        }
+        if (cyxchat_dedup_check(ctx->dedup, from, &msg_id, sub_id)) {
+            CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_MSG_DUP, trace_id, from, len);
+            CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_DUP, 1);
+            return;
+        }
+    }
+
+    CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_MSG_RECV, trace_id, from, len);
+    CYXCHAT_COUNT(CYXCHAT_METRIC_BYTES_RECV, len);
+    if (!is_fragment) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_RECV, 1);
+    }
+    if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_DEBUG)) {
+        char hex_id[17];
+        cyxchat_log_peer_prefix(from, hex_id);
+        CYXWIZ_DEBUG("Received message from peer %.16s... (%zu bytes, type=0x%02x)",
+                     hex_id, len, type);
+    }
+
     /* Handle fragmented TEXT messages */
-    if (type == CYXCHAT_MSG_TEXT && (flags & CYXCHAT_FLAG_FRAGMENTED)) {
+    if (is_fragment) {
         /* Parse fragment header: frag_idx(1) + total_frags(1) + text_len(1) + text(N) */
         if (len < offset + 3) return;  /* Need at least frag info + text_len */
 
@@ -547,8 +674,10 @@ static void on_onion_delivery(
 
         if (len < offset + text_len) return;  /* Truncated */
 
-        CYXWIZ_INFO("Received fragment %u/%u from %.16s... (%u bytes)",
-                    frag_idx + 1, total_frags, hex_id, text_len);
+        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_FRAG_RECV, trace_id, from, text_len);
+        CYXCHAT_COUNT(CYXCHAT_METRIC_FRAG_RECV, 1);
+        CYXCHAT_LOG_DEBUG("Received fragment %u/%u (%u bytes)",
+                          frag_idx + 1, total_frags, text_len);
 
         /* Get current timestamp */
         uint64_t now_ms = cyxchat_timestamp_ms();
@@ -569,7 +698,7 @@ static void on_onion_delivery(
 
         /* Check if complete */
         if (frag_is_complete(entry)) {
-            CYXWIZ_INFO("All %u fragments received, reassembling message", total_frags);
+            CYXCHAT_LOG_DEBUG("All %u fragments received, reassembling message", total_frags);
 
             /* Reassemble message */
             uint8_t reassembled[FRAG_MAX_TEXT + 1];
@@ -586,8 +715,9 @@ static void on_onion_delivery(
             queued_data[1] = (uint8_t)((total_len >> 8) & 0xFF);
             memcpy(queued_data + 2, reassembled, total_len);
             
-            CYXWIZ_INFO("Queuing reassembled message: %zu bytes", total_len);
-            queue_push(ctx, from, type, queued_data, 2 + total_len);
+            CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_FRAG_DONE, trace_id, from, total_len);
+            CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_RECV, 1);
+            queue_push(ctx, from, type, queued_data, 2 + total_len, trace_id);
 
             /* Mark entry as used */
             entry->valid = 0;
@@ -604,10 +734,10 @@ static void on_onion_delivery(
             converted[0] = wire_text_len;
             converted[1] = 0;
             memcpy(converted + 2, data + offset + 1, wire_text_len);
-            queue_push(ctx, from, type, converted, 2 + wire_text_len);
+            queue_push(ctx, from, type, converted, 2 + wire_text_len, trace_id);
         }
     } else {
-        queue_push(ctx, from, type, data + offset, len - offset);
+        queue_push(ctx, from, type, data + offset, len - offset, trace_id);
     }
 
     /* Also fire callbacks if registered */
@@ -631,17 +761,23 @@ static void on_onion_delivery(
                     }
 
                     ctx->on_message(ctx, from, &text_msg, ctx->on_message_data);
+                    if (trace_id) {
+                        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_CALLBACK, trace_id, from, text_len);
+                    }
                 }
             }
             break;
 
         case CYXCHAT_MSG_ACK:
-            if (ctx->on_ack && offset + CYXCHAT_MSG_ID_SIZE + 1 <= len) {
+            if (offset + CYXCHAT_MSG_ID_SIZE + 1 <= len) {
                 cyxchat_msg_id_t ack_id;
                 memcpy(&ack_id, data + offset, CYXCHAT_MSG_ID_SIZE);
                 offset += CYXCHAT_MSG_ID_SIZE;
                 uint8_t status = data[offset];
-                ctx->on_ack(ctx, from, &ack_id, (cyxchat_msg_status_t)status, ctx->on_ack_data);
+                ack_track_acked(ctx, &ack_id);
+                if (ctx->on_ack) {
+                    ctx->on_ack(ctx, from, &ack_id, (cyxchat_msg_status_t)status, ctx->on_ack_data);
+                }
             }
             break;
 
@@ -693,7 +829,7 @@ static void on_onion_delivery(
         case CYXCHAT_MSG_FILE_ACK:
             /* Route to file module if registered */
             if (ctx->file_ctx) {
-                CYXWIZ_INFO("Routing file message (type=0x%02x) to file module", type);
+                CYXCHAT_LOG_DEBUG("Routing file message (type=0x%02x) to file module", type);
                 /* Pass data after the type byte (offset already points past header) */
                 cyxchat_file_handle_message(ctx->file_ctx, from, type, data + 1, len - 1);
             } else {
@@ -711,23 +847,79 @@ static void on_onion_delivery(
  * Initialization
  * ============================================================ */
 
+/* Context, receive queue and fragment buffers */
+static void* chat_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_ctx_t *c = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_ctx_t));
+    cyxchat_recv_msg_t *queue = cyxchat_arena_carve(arena, cfg->recv_queue_size,
+                                                    sizeof(cyxchat_recv_msg_t));
+    cyxchat_frag_entry_t *frags = cyxchat_arena_carve(arena, cfg->frag_buffers,
+                                                      sizeof(cyxchat_frag_entry_t));
+    if (c) {
+        c->recv_queue = queue;
+        c->recv_size = cfg->recv_queue_size;
+        c->frag_buffer = frags;
+        c->frag_count = cfg->frag_buffers;
+        c->footprint = arena->size;
+    }
+    return c;
+}
+
 cyxchat_error_t cyxchat_create(
     cyxchat_ctx_t **ctx,
     cyxwiz_onion_ctx_t *onion,
     const cyxwiz_node_id_t *local_id
+) {
+    return cyxchat_create_with_config(ctx, onion, local_id, NULL);
+}
+
+cyxchat_error_t cyxchat_create_with_config(
+    cyxchat_ctx_t **ctx,
+    cyxwiz_onion_ctx_t *onion,
+    const cyxwiz_node_id_t *local_id,
+    const cyxchat_config_t *config
 ) {
     if (!ctx || !onion || !local_id) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_ctx_t *c = calloc(1, sizeof(cyxchat_ctx_t));
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_ctx_t *c = cyxchat_arena_build(chat_layout, config);
     if (!c) {
         return CYXCHAT_ERR_MEMORY;
     }
 
     c->onion = onion;
+    c->poll_onion = 1;
     memcpy(&c->local_id, local_id, sizeof(cyxwiz_node_id_t));
 
+    cyxchat_error_t err = cyxchat_dedup_create(&c->dedup);
+    if (err != CYXCHAT_OK) {
+        free(c);
+        return err;
+    }
+
+    err = cyxchat_rng_create(&c->rng);
+    if (err != CYXCHAT_OK) {
+        cyxchat_dedup_destroy(c->dedup);
+        free(c);
+        return err;
+    }
+
+    err = cyxchat_sched_create(&c->sched);
+    if (err != CYXCHAT_OK) {
+        cyxchat_rng_destroy(c->rng);
+        cyxchat_dedup_destroy(c->dedup);
+        free(c);
+        return err;
+    }
+
     /* Initialize receive queue */
     c->recv_head = 0;
     c->recv_tail = 0;
@@ -745,19 +937,70 @@ void cyxchat_destroy(cyxchat_ctx_t *ctx) {
         if (ctx->onion) {
             cyxwiz_onion_set_callback(ctx->onion, NULL, NULL);
         }
-        cyxwiz_secure_zero(ctx, sizeof(cyxchat_ctx_t));
+        cyxchat_dedup_destroy(ctx->dedup);
+        cyxchat_rng_destroy(ctx->rng);
+        cyxchat_sched_destroy(ctx->sched);
+        cyxwiz_secure_zero(ctx, ctx->footprint);
         free(ctx);
     }
 }
 
+/* ============================================================
+ * Outbound Scheduling
+ * ============================================================
+ * Control and interactive frames (ACKs, text, edits, reactions) go to
+ * the onion layer at once, ahead of anything queued. Background and
+ * bulk frames (typing, file chunks) wait in the scheduler and are
+ * released by cyxchat_poll() a budget at a time, so a transfer can
+ * never sit in front of a chat message.
+ */
+
+static cyxchat_error_t sched_send(
+    void *user_data,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len
+) {
+    cyxchat_ctx_t *ctx = (cyxchat_ctx_t*)user_data;
+    cyxwiz_error_t err = cyxwiz_onion_send_to(ctx->onion, to, data, len);
+    return (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+}
+
+static cyxchat_error_t chat_send(
+    cyxchat_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    cyxchat_prio_t prio
+) {
+    if (prio <= CYXCHAT_PRIO_INTERACTIVE) {
+        return sched_send(ctx, to, data, len);
+    }
+    return cyxchat_sched_enqueue(ctx->sched, to, prio, data, len);
+}
+
+/* Park a frame in the recipient's mailbox; 1 if an item was queued */
+static int store_offline(
+    cyxchat_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len
+) {
+    return ctx->offline &&
+           cyxchat_offline_send_to(ctx->offline, to, data, len, NULL) == CYXCHAT_OK;
+}
+
 int cyxchat_poll(cyxchat_ctx_t *ctx, uint64_t now_ms) {
     if (!ctx) return 0;
 
     /* Poll onion layer for incoming messages */
-    if (ctx->onion) {
+    if (ctx->onion && ctx->poll_onion) {
         cyxwiz_onion_poll(ctx->onion, now_ms);
     }
 
+    /* Release queued background/bulk frames (chat sends never wait) */
+    cyxchat_sched_flush(ctx->sched, sched_send, ctx, CYXCHAT_SCHED_POLL_BUDGET);
+
     /* Expire old incomplete fragments */
     frag_expire_old(ctx, now_ms);
 
@@ -765,7 +1008,7 @@ int cyxchat_poll(cyxchat_ctx_t *ctx, uint64_t now_ms) {
     if (ctx->recv_head >= ctx->recv_tail) {
         return (int)(ctx->recv_head - ctx->recv_tail);
     } else {
-        return (int)(RECV_QUEUE_SIZE - ctx->recv_tail + ctx->recv_head);
+        return (int)(ctx->recv_size - ctx->recv_tail + ctx->recv_head);
     }
 }
 
@@ -813,11 +1056,11 @@ cyxchat_error_t cyxchat_send_text(
 
     /* Generate message ID */
     cyxchat_msg_id_t msg_id;
-    cyxchat_generate_msg_id(&msg_id);
+    cyxchat_rng_bytes(ctx->rng, msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
-    char hex_id[17];
-    for (int i = 0; i < 8; i++) {
-        snprintf(hex_id + i*2, 3, "%02x", to->bytes[i]);
+    uint32_t trace_id = CYXCHAT_TRACE_ID(&msg_id);
+    if (trace_id) {
+        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_SEND_BEGIN, trace_id, to, text_len);
     }
 
     /* Check if message needs fragmentation */
@@ -844,15 +1087,22 @@ cyxchat_error_t cyxchat_send_text(
             return CYXCHAT_ERR_INVALID;
         }
 
-        CYXWIZ_INFO("Sending text message to peer %.16s... (%zu bytes)", hex_id, wire_len);
-
+        if (trace_id) {
+            CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_ONION_TX, trace_id, to, wire_len);
+            cyxchat_trace_set_current(trace_id);
+        }
         cyxwiz_error_t err = cyxwiz_onion_send_to(ctx->onion, to, wire_buf, wire_len);
-        if (err != CYXWIZ_OK) {
+        if (trace_id) cyxchat_trace_set_current(0);
+        if (err != CYXWIZ_OK && !store_offline(ctx, to, wire_buf, wire_len)) {
+            CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_SEND_FAIL, trace_id, to, wire_len);
+            CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_SEND_FAIL, 1);
             CYXWIZ_ERROR("Failed to send message: error %d", err);
             return CYXCHAT_ERR_NETWORK;
         }
 
-        CYXWIZ_INFO("Message sent successfully via onion routing");
+        CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_MSG_SEND, trace_id, to, wire_len);
+        CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_SENT, 1);
+        CYXCHAT_COUNT(CYXCHAT_METRIC_BYTES_SENT, wire_len);
     } else {
         /* Long message - fragment it */
         size_t total_chunks = (text_len + CYXCHAT_MAX_CHUNK_TEXT - 1) / CYXCHAT_MAX_CHUNK_TEXT;
@@ -860,9 +1110,15 @@ cyxchat_error_t cyxchat_send_text(
             return CYXCHAT_ERR_INVALID;  /* Too long even for fragmentation */
         }
 
-        CYXWIZ_INFO("Fragmenting message into %zu chunks for peer %.16s...", total_chunks, hex_id);
+        if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_DEBUG)) {
+            char hex_id[17];
+            cyxchat_log_peer_prefix(to, hex_id);
+            CYXWIZ_DEBUG("Fragmenting message into %zu chunks for peer %.16s...",
+                         total_chunks, hex_id);
+        }
 
         size_t offset = 0;
+        int via_mailbox = 0;    /* Once one fragment is stored, store the rest */
         for (size_t i = 0; i < total_chunks; i++) {
             size_t chunk_len = text_len - offset;
             if (chunk_len > CYXCHAT_MAX_CHUNK_TEXT) {
@@ -888,18 +1144,40 @@ cyxchat_error_t cyxchat_send_text(
             memcpy(wire_buf + wire_len, text + offset, chunk_len);
             wire_len += chunk_len;
 
-            cyxwiz_error_t err = cyxwiz_onion_send_to(ctx->onion, to, wire_buf, wire_len);
-            if (err != CYXWIZ_OK) {
-                CYXWIZ_ERROR("Failed to send fragment %zu/%zu: error %d", i + 1, total_chunks, err);
-                return CYXCHAT_ERR_NETWORK;
+            if (trace_id) {
+                CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_ONION_TX, trace_id, to, wire_len);
+                cyxchat_trace_set_current(trace_id);
+            }
+            cyxwiz_error_t err = CYXWIZ_OK;
+            if (!via_mailbox) {
+                err = cyxwiz_onion_send_to(ctx->onion, to, wire_buf, wire_len);
+            }
+            if (trace_id) cyxchat_trace_set_current(0);
+            if (via_mailbox || err != CYXWIZ_OK) {
+                via_mailbox = store_offline(ctx, to, wire_buf, wire_len);
+                if (!via_mailbox) {
+                    CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_SEND_FAIL, trace_id, to, wire_len);
+                    CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_SEND_FAIL, 1);
+                    CYXWIZ_ERROR("Failed to send fragment %zu/%zu: error %d",
+                                 i + 1, total_chunks, err);
+                    return CYXCHAT_ERR_NETWORK;
+                }
+            }
+            CYXCHAT_TRACE_MSG(CYXCHAT_TRACE_FRAG_SEND, trace_id, to, wire_len);
+            CYXCHAT_COUNT(CYXCHAT_METRIC_FRAG_SENT, 1);
+            CYXCHAT_COUNT(CYXCHAT_METRIC_BYTES_SENT, wire_len);
+            if (i == 0) {
+                CYXCHAT_COUNT(CYXCHAT_METRIC_MSG_SENT, 1);
             }
 
             offset += chunk_len;
         }
 
-        CYXWIZ_INFO("All %zu fragments sent successfully", total_chunks);
+        CYXCHAT_LOG_DEBUG("All %zu fragments sent successfully", total_chunks);
     }
 
+    ack_track_sent(ctx, &msg_id);
+
     if (msg_id_out) {
         memcpy(msg_id_out, &msg_id, sizeof(cyxchat_msg_id_t));
     }
@@ -918,7 +1196,7 @@ cyxchat_error_t cyxchat_send_ack(
     }
 
     cyxchat_msg_id_t our_msg_id;
-    cyxchat_generate_msg_id(&our_msg_id);
+    cyxchat_rng_bytes(ctx->rng, our_msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
     uint8_t wire_buf[WIRE_MAX_PAYLOAD];
     size_t wire_len = serialize_ack_msg(
@@ -944,7 +1222,7 @@ cyxchat_error_t cyxchat_send_typing(
     }
 
     cyxchat_msg_id_t msg_id;
-    cyxchat_generate_msg_id(&msg_id);
+    cyxchat_rng_bytes(ctx->rng, msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
     uint8_t wire_buf[WIRE_MAX_PAYLOAD];
     size_t wire_len = serialize_typing_msg(
@@ -956,8 +1234,7 @@ cyxchat_error_t cyxchat_send_typing(
         return CYXCHAT_ERR_INVALID;
     }
 
-    cyxwiz_error_t err = cyxwiz_onion_send_to(ctx->onion, to, wire_buf, wire_len);
-    return (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+    return chat_send(ctx, to, wire_buf, wire_len, CYXCHAT_PRIO_BACKGROUND);
 }
 
 cyxchat_error_t cyxchat_send_reaction(
@@ -977,7 +1254,7 @@ cyxchat_error_t cyxchat_send_reaction(
     }
 
     cyxchat_msg_id_t our_msg_id;
-    cyxchat_generate_msg_id(&our_msg_id);
+    cyxchat_rng_bytes(ctx->rng, our_msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
     uint8_t wire_buf[WIRE_MAX_PAYLOAD];
     size_t wire_len = serialize_reaction_msg(
@@ -1003,7 +1280,7 @@ cyxchat_error_t cyxchat_send_delete(
     }
 
     cyxchat_msg_id_t our_msg_id;
-    cyxchat_generate_msg_id(&our_msg_id);
+    cyxchat_rng_bytes(ctx->rng, our_msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
     uint8_t wire_buf[WIRE_MAX_PAYLOAD];
     size_t wire_len = serialize_delete_msg(
@@ -1035,7 +1312,7 @@ cyxchat_error_t cyxchat_send_edit(
     }
 
     cyxchat_msg_id_t our_msg_id;
-    cyxchat_generate_msg_id(&our_msg_id);
+    cyxchat_rng_bytes(ctx->rng, our_msg_id.bytes, CYXCHAT_MSG_ID_SIZE);
 
     uint8_t wire_buf[WIRE_MAX_PAYLOAD];
     size_t wire_len = serialize_edit_msg(
@@ -1127,7 +1404,7 @@ void cyxchat_set_on_edit(
 
 void cyxchat_generate_msg_id(cyxchat_msg_id_t *msg_id) {
     if (msg_id) {
-        cyxwiz_crypto_random(msg_id->bytes, CYXCHAT_MSG_ID_SIZE);
+        cyxchat_rng_bytes(cyxchat_rng_default(), msg_id->bytes, CYXCHAT_MSG_ID_SIZE);
     }
 }
 
@@ -1250,21 +1527,72 @@ cyxchat_error_t cyxchat_send_raw(
     const cyxwiz_node_id_t *to,
     const uint8_t *data,
     size_t data_len
+) {
+    return cyxchat_send_raw_prio(ctx, to, data, data_len, CYXCHAT_PRIO_INTERACTIVE);
+}
+
+cyxchat_error_t cyxchat_send_raw_prio(
+    cyxchat_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t data_len,
+    cyxchat_prio_t prio
 ) {
     if (!ctx || !to || !data || data_len == 0) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxwiz_error_t err = cyxwiz_onion_send_to(ctx->onion, to, data, data_len);
-    return (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+    return chat_send(ctx, to, data, data_len, prio);
 }
 
 cyxwiz_onion_ctx_t* cyxchat_get_onion(cyxchat_ctx_t *ctx) {
     return ctx ? ctx->onion : NULL;
 }
 
+cyxchat_dedup_ctx_t* cyxchat_get_dedup(cyxchat_ctx_t *ctx) {
+    return ctx ? ctx->dedup : NULL;
+}
+
+cyxchat_sched_ctx_t* cyxchat_get_sched(cyxchat_ctx_t *ctx) {
+    return ctx ? ctx->sched : NULL;
+}
+
+cyxchat_rng_t* cyxchat_get_rng(cyxchat_ctx_t *ctx) {
+    return ctx ? ctx->rng : NULL;
+}
+
 void cyxchat_set_file_ctx(cyxchat_ctx_t *ctx, cyxchat_file_ctx_t *file_ctx) {
     if (ctx) {
         ctx->file_ctx = file_ctx;
     }
 }
+
+/* Drained mailbox items are chat frames: same path as onion delivery */
+static void on_offline_message(
+    cyxchat_offline_ctx_t *offline,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len,
+    void *user_data
+) {
+    (void)offline;
+    on_onion_delivery(from, data, len, user_data);
+}
+
+void cyxchat_set_offline_ctx(cyxchat_ctx_t *ctx, cyxchat_offline_ctx_t *offline_ctx) {
+    if (!ctx) return;
+
+    if (ctx->offline) {
+        cyxchat_offline_set_on_message(ctx->offline, NULL, NULL);
+    }
+    ctx->offline = offline_ctx;
+    if (offline_ctx) {
+        cyxchat_offline_set_on_message(offline_ctx, on_offline_message, ctx);
+    }
+}
+
+void cyxchat_set_onion_polling(cyxchat_ctx_t *ctx, int enabled) {
+    if (ctx) {
+        ctx->poll_onion = enabled ? 1 : 0;
+    }
+}
@@ -0,0 +1,148 @@
+/**
+ * CyxChat Configuration Implementation
+ *
+ * Contexts describe their layout once as a function over an arena and
+ * run it twice: a measuring pass with no block totals the bytes, then
+ * the same pass over one calloc'd block hands out the tables. The
+ * context struct is carved first, so freeing it frees everything.
+ */
+
+#include <cyxchat/config.h>
+#include <cyxchat/connection.h>
+#include <cyxchat/dns.h>
+#include <cyxchat/label.h>
+#include <cyxchat/offline.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* ============================================================
+ * Configuration
+ * ============================================================ */
+
+void cyxchat_config_default(cyxchat_config_t *config)
+{
+    if (!config) return;
+
+    config->recv_queue_size = CYXCHAT_CONFIG_RECV_QUEUE;
+    config->frag_buffers = CYXCHAT_CONFIG_FRAG_BUFFERS;
+    config->max_peers = CYXCHAT_DEFAULT_MAX_PEERS;
+    config->dns_cache_size = CYXCHAT_DNS_CACHE_SIZE;
+    config->mail_max_stored = CYXCHAT_CONFIG_MAIL_STORED;
+    config->max_contacts = CYXCHAT_MAX_CONTACTS;
+    config->max_groups = CYXCHAT_CONFIG_GROUPS;
+    config->label_table_size = CYXCHAT_LABEL_TABLE_SIZE;
+    config->offline_store_size = CYXCHAT_OFFLINE_STORE_SIZE;
+}
+
+static int capacity_ok(uint32_t n)
+{
+    return n > 0 && n <= CYXCHAT_CONFIG_MAX_ENTRIES;
+}
+
+cyxchat_error_t cyxchat_config_validate(const cyxchat_config_t *config)
+{
+    if (!config) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    /* The receive queue keeps one slot open to tell full from empty */
+    if (config->recv_queue_size < 2 || !capacity_ok(config->recv_queue_size) ||
+        !capacity_ok(config->frag_buffers) ||
+        !capacity_ok(config->dns_cache_size) ||
+        !capacity_ok(config->mail_max_stored) ||
+        !capacity_ok(config->max_contacts) ||
+        !capacity_ok(config->max_groups) ||
+        !capacity_ok(config->offline_store_size)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    /* Labels index their slot with their low bits */
+    uint32_t labels = config->label_table_size;
+    if (labels < 2 || labels > CYXCHAT_LABEL_TABLE_MAX || (labels & (labels - 1))) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    /* Peer tables grow on demand; 0 leaves them unbounded */
+    if (config->max_peers > UINT32_MAX - 1) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    return CYXCHAT_OK;
+}
+
+const cyxchat_config_t* cyxchat_config_resolve(
+    const cyxchat_config_t *config,
+    cyxchat_config_t *defaults
+) {
+    if (!config) {
+        cyxchat_config_default(defaults);
+        return defaults;
+    }
+    return cyxchat_config_validate(config) == CYXCHAT_OK ? config : NULL;
+}
+
+/* ============================================================
+ * Arena
+ * ============================================================ */
+
+void cyxchat_arena_init(cyxchat_arena_t *arena, void *base, size_t size)
+{
+    if (!arena) return;
+
+    arena->base = (uint8_t*)base;
+    arena->size = base ? size : 0;
+    arena->used = 0;
+    arena->overflow = 0;
+}
+
+void* cyxchat_arena_carve(cyxchat_arena_t *arena, size_t count, size_t elem_size)
+{
+    if (!arena) return NULL;
+
+    size_t start = (arena->used + CYXCHAT_ARENA_ALIGN - 1) &
+                   ~(size_t)(CYXCHAT_ARENA_ALIGN - 1);
+    if (start < arena->used ||
+        (elem_size > 0 && count > (SIZE_MAX - start) / elem_size)) {
+        arena->overflow = 1;
+        return NULL;
+    }
+
+    size_t end = start + count * elem_size;
+    if (arena->base && end > arena->size) {
+        arena->overflow = 1;
+        return NULL;
+    }
+
+    arena->used = end;
+    return arena->base ? arena->base + start : NULL;
+}
+
+void* cyxchat_arena_alloc(cyxchat_arena_t *arena)
+{
+    if (!arena || arena->overflow || arena->used == 0) {
+        return NULL;
+    }
+
+    size_t size = arena->used;
+    void *block = calloc(1, size);
+    if (!block) {
+        return NULL;
+    }
+
+    cyxchat_arena_init(arena, block, size);
+    return block;
+}
+
+void* cyxchat_arena_build(cyxchat_arena_layout_t layout, const void *arg)
+{
+    if (!layout) return NULL;
+
+    cyxchat_arena_t arena;
+    cyxchat_arena_init(&arena, NULL, 0);
+    layout(&arena, arg);
+    if (!cyxchat_arena_alloc(&arena)) {
+        return NULL;
+    }
+
+    return layout(&arena, arg);
+}
@@ -0,0 +1,95 @@
+/**
+ * CyxChat Congestion Control Implementation
+ *
+ * LEDBAT (RFC 6817) steers a window by one-way queueing delay so that
+ * background traffic yields to everything else on the uplink. Here the
+ * delay signal is the round trip above the path minimum, the window is
+ * paced out over one RTT rather than clocked by ACKs, and the decrease
+ * is proportional to the excess delay as in LEDBAT++, so a flow that
+ * starts late cannot starve the ones already running.
+ */
+
+#include <cyxchat/congestion.h>
+
+#include <string.h>
+
+#define CC_ONE  256                     /* One packet in window units */
+
+/* ============================================================
+ * Controller
+ * ============================================================ */
+
+static void clamp_cwnd(cyxchat_congestion_t *cc)
+{
+    if (cc->cwnd < CYXCHAT_CC_MIN_CWND * CC_ONE) cc->cwnd = CYXCHAT_CC_MIN_CWND * CC_ONE;
+    if (cc->cwnd > CYXCHAT_CC_MAX_CWND * CC_ONE) cc->cwnd = CYXCHAT_CC_MAX_CWND * CC_ONE;
+}
+
+void cyxchat_congestion_init(cyxchat_congestion_t *cc)
+{
+    if (!cc) return;
+    memset(cc, 0, sizeof(*cc));
+    cc->cwnd = CYXCHAT_CC_INIT_CWND * CC_ONE;
+    cc->slow_start = 1;
+}
+
+void cyxchat_congestion_on_rtt(cyxchat_congestion_t *cc, uint32_t rtt_ms, uint32_t base_rtt_ms)
+{
+    if (!cc) return;
+
+    cc->rtt_ms = rtt_ms ? rtt_ms : 1;   /* Sub-millisecond LAN */
+    uint32_t sample = rtt_ms > base_rtt_ms ? rtt_ms - base_rtt_ms : 0;
+
+    /* Min over the last few samples: one delayed reply is not a queue */
+    memmove(cc->recent_ms + 1, cc->recent_ms, (CYXCHAT_CC_FILTER - 1) * sizeof(uint32_t));
+    cc->recent_ms[0] = sample;
+    if (cc->recent_count < CYXCHAT_CC_FILTER) cc->recent_count++;
+
+    uint32_t qdelay = sample;
+    for (uint32_t i = 1; i < cc->recent_count; i++) {
+        if (cc->recent_ms[i] < qdelay) qdelay = cc->recent_ms[i];
+    }
+    cc->qdelay_ms = qdelay;
+
+    if (cc->slow_start) {
+        if (qdelay * 4 < CYXCHAT_CC_TARGET_MS * 3) {
+            cc->cwnd *= 2;
+            clamp_cwnd(cc);
+            return;
+        }
+        cc->slow_start = 0;
+    }
+
+    if (qdelay <= CYXCHAT_CC_TARGET_MS) {
+        cc->cwnd += CC_ONE * (CYXCHAT_CC_TARGET_MS - qdelay) / CYXCHAT_CC_TARGET_MS;
+    } else {
+        uint64_t cut = (uint64_t)cc->cwnd * (qdelay - CYXCHAT_CC_TARGET_MS) /
+                       CYXCHAT_CC_TARGET_MS;
+        if (cut > cc->cwnd / 2) cut = cc->cwnd / 2;
+        cc->cwnd -= (uint32_t)cut;
+    }
+    clamp_cwnd(cc);
+}
+
+void cyxchat_congestion_on_loss(cyxchat_congestion_t *cc, uint64_t now_ms)
+{
+    if (!cc) return;
+
+    /* Losses within one RTT are the same congestion event */
+    if (cc->last_loss_ms && now_ms - cc->last_loss_ms < cc->rtt_ms) return;
+
+    cc->cwnd /= 2;
+    clamp_cwnd(cc);
+    cc->slow_start = 0;
+    cc->last_loss_ms = now_ms;
+}
+
+uint32_t cyxchat_congestion_interval_us(const cyxchat_congestion_t *cc)
+{
+    if (!cc || cc->rtt_ms == 0) return CYXCHAT_CC_IDLE_INTERVAL_US;
+
+    uint64_t us = (uint64_t)cc->rtt_ms * 1000 * CC_ONE / cc->cwnd;
+    if (us < 1) us = 1;
+    if (us > CYXCHAT_CC_MAX_INTERVAL_US) us = CYXCHAT_CC_MAX_INTERVAL_US;
+    return (uint32_t)us;
+}
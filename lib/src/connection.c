@@ -8,6 +8,16 @@
 
 #include "cyxchat/connection.h"
 #include "cyxchat/relay.h"
+#include "cyxchat/timer.h"
+#include "cyxchat/netmon.h"
+#include "cyxchat/keepalive.h"
+#include "cyxchat/rng.h"
+#include "cyxchat/ice.h"
+#include "cyxchat/dispatch.h"
+#include "cyxchat/loopback.h"
+#include "cyxchat/trace.h"
+#include "cyxchat/metrics.h"
+#include "cyxchat/label.h"
 #include <cyxwiz/memory.h>
 #include <cyxwiz/log.h>
 #include <cyxwiz/routing.h>
@@ -18,6 +28,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -30,6 +41,13 @@
 #include <sys/time.h>
 #include <time.h>
 #include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
 #endif
 
 /* ============================================================
@@ -44,6 +62,9 @@ typedef struct {
     uint64_t start_time;
     uint8_t punch_attempts;
     int active;
+    int notified;                   /* Callback already told of first path */
+    cyxchat_timer_t timeout_timer;  /* Hole punch deadline */
+    cyxchat_timer_t relay_timer;    /* Staggered relay start */
 } cyxchat_pending_conn_t;
 
 /* Throttle interval for sending ANNOUNCEs to same peer (60 seconds) */
@@ -58,13 +79,80 @@ typedef struct {
     uint64_t last_keepalive;
     uint64_t last_announce_sent;    /* When we last sent ANNOUNCE to this peer */
     uint64_t last_key_exchange;     /* When we last processed key from this peer */
-    uint32_t bytes_sent;
-    uint32_t bytes_received;
+    cyxchat_linkstats_t stats;      /* Counters and path quality */
     int8_t rssi;
     int is_relayed;
+    int relay_forced;               /* cyxchat_conn_force_relay: no upgrade */
     int active;
+    cyxchat_timer_t idle_timer;     /* Armed while connected or relaying */
+
+    /* Re-punch after a local network change (relay bridges meanwhile) */
+    int repunching;
+    uint8_t punches_left;
+    uint64_t repunch_started;
+    cyxchat_timer_t punch_timer;
+
+    /* ICE-lite: peer's candidates and the check/re-check cycle */
+    cyxchat_ice_checklist_t ice;
+    cyxchat_timer_t ice_timer;      /* Check reply deadline, then re-check */
+    int candidates_sent;            /* Ours delivered since last change */
+
+    /* Echo probe on the current path: keepalive and RTT/loss samples */
+    cyxchat_timer_t probe_timer;    /* Reply deadline, or next sample */
+    uint32_t probe_tag;             /* Outstanding echo (0 = none) */
+    uint64_t probe_sent_at;
+    uint32_t tx_seq;                /* Check/echo tags (peer counts gaps) */
+    int answers_checks;             /* Peer speaks connection control */
+    uint64_t sample_until;          /* Probe every RTT until (bulk sender) */
+
+    /* Multipath: our wrapper sequence, and the peer's we have delivered */
+    uint32_t mp_tx_seq;             /* Random start, so a restart resyncs */
+    cyxchat_dedup_seq_t mp_rx;
 } cyxchat_peer_conn_t;
 
+/* Recover the entry that embeds a timer */
+#define CONN_TIMER_OWNER(timer, type, member) \
+    ((type*)((uint8_t*)(timer) - offsetof(type, member)))
+
+/*
+ * Node ID table: entries live in fixed-size chunks that never move, so
+ * pointers handed out stay valid while the table grows. The index is a
+ * power-of-two open-addressing array of entry numbers with a parallel
+ * array of 32-bit ID hashes; a probe only does the full 32-byte compare
+ * when the hash matches. Entry structs must start with the node ID.
+ */
+#define CONN_TABLE_CHUNK        64
+#define CONN_TABLE_MAX_LOAD     70      /* Percent before index doubles */
+
+typedef struct {
+    size_t elem_size;
+    uint8_t **chunks;
+    size_t chunk_count;
+    size_t used;                /* Entry numbers handed out so far */
+    uint32_t *free_list;        /* Recycled entry numbers */
+    size_t free_count;
+    uint32_t *index;            /* Entry number + 1, 0 = empty */
+    uint32_t *hashes;           /* ID hash of indexed entry */
+    size_t index_size;          /* Power of two */
+    size_t count;               /* Indexed entries */
+    size_t max_entries;         /* Hard limit (0 = unlimited) */
+} conn_table_t;
+
+/*
+ * Send queue: fixed slots allocated once when batched I/O is enabled,
+ * filled during a poll cycle and flushed before it blocks or returns.
+ */
+#define CONN_BATCH_DEFAULT_MTU  1500    /* If the transport reports none */
+
+typedef struct {
+    cyxwiz_node_id_t *peers;
+    uint16_t *lens;
+    uint8_t *data;              /* cap slots of mtu bytes */
+    size_t mtu;
+    size_t cap;
+    size_t count;
+} conn_pkt_batch_t;
+
 /* DHT find callback wrapper */
 typedef struct {
     cyxchat_conn_ctx_t *ctx;
@@ -77,6 +165,7 @@ typedef struct {
 struct cyxchat_conn_ctx {
     /* CyxWiz components */
     cyxwiz_transport_t *transport;
+    cyxchat_loopnet_t *loopnet;         /* In-process network, NULL for UDP */
     cyxwiz_peer_table_t *peer_table;
     cyxwiz_router_t *router;
     cyxwiz_onion_ctx_t *onion;
@@ -93,22 +182,72 @@ struct cyxchat_conn_ctx {
     int stun_complete;
     int bootstrap_connected;
 
-    /* Peer connections */
-    cyxchat_peer_conn_t peers[CYXCHAT_MAX_PEER_CONNECTIONS];
+    /* Peer connections (hash-indexed by node ID) */
+    conn_table_t peers;
     size_t peer_count;
 
-    /* Pending connection requests */
-    cyxchat_pending_conn_t pending[CYXCHAT_MAX_PEER_CONNECTIONS];
+    /* Pending connection requests (hash-indexed by node ID) */
+    conn_table_t pending;
     size_t pending_count;
 
     /* Relay context */
     cyxchat_relay_ctx_t *relay;
 
+    /* Timer wheel (shared with relay, optionally DNS and presence) */
+    cyxchat_timer_wheel_t *timers;
+
+    /* STUN refresh and route change detection */
+    cyxchat_netmon_t *netmon;
+    uint32_t network_changes;
+
+    /* One wake-up sends every peer's keepalive echo */
+    cyxchat_timer_t keepalive_timer;
+
+    /* Delay before racing the relay against the hole punch */
+    uint32_t relay_stagger_ms;
+
+    /* Label-switched paths through and from us */
+    cyxchat_label_table_t *labels;
+    cyxchat_timer_t label_timer;        /* Setup, idle and grace sweep */
+    uint8_t label_secret[CYXCHAT_LABEL_KEY_SIZE];   /* Static handshake key */
+    int label_keyed;                    /* Without it we refuse to be a hop */
+
+    /* ICE-lite: relay candidates we advertise */
+    cyxchat_ice_candidate_t relay_cands[CYXCHAT_MAX_RELAY_SERVERS];
+    size_t relay_cand_count;
+
+    /* Longest block in the transport poll per cycle */
+    uint32_t poll_timeout_ms;
+
+    /* Cuts a blocking poll short from another thread */
+#ifdef _WIN32
+    WSAEVENT wake_event;
+    WSAEVENT sock_event;                /* Socket readiness, bound on first wait */
+    SOCKET sock_evented;
+#else
+    int wake_fd[2];                     /* Read end, write end (one eventfd on Linux) */
+#endif
+
+    /* Receive routing by message type */
+    cyxchat_dispatch_t rx_table;
+
+    /* Duplicate small sends over relay and direct while punching */
+    int multipath;
+
+    /* Batched sends (loopback only: cyxwiz has no vectored send) */
+    int batch_io;
+    conn_pkt_batch_t tx;
+    cyxchat_conn_io_stats_t io_stats;
+
     /* Callbacks */
     cyxchat_conn_state_callback_t on_state_change;
     void *state_change_user_data;
     cyxchat_conn_data_callback_t on_data;
     void *data_user_data;
+    cyxchat_conn_network_callback_t on_network_change;
+    void *network_change_user_data;
+    cyxchat_conn_label_data_callback_t on_label_data;
+    void *label_data_user_data;
 
     /* DHT callbacks */
     cyxchat_dht_node_callback_t on_dht_node;
@@ -127,6 +266,32 @@ struct cyxchat_conn_ctx {
 static void send_announce_to_peer(cyxchat_conn_ctx_t *ctx,
                                    const cyxwiz_node_id_t *peer_id);
 
+/* Forward declaration for batched I/O */
+static void flush_tx(cyxchat_conn_ctx_t *ctx);
+
+/* Forward declarations for path selection (defined with ICE-lite) */
+static void on_ice_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+static void on_probe_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+static void arm_keepalive(cyxchat_conn_ctx_t *ctx);
+static void handle_conn_control(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
+                                const cyxwiz_node_id_t *from,
+                                const uint8_t *data, size_t len, int via_relay);
+
+/* Forward declarations for label switching (defined with label paths) */
+static void labels_peer_down(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id);
+static void rx_label(void *user_data, const cyxwiz_node_id_t *from,
+                     const uint8_t *data, size_t len, int via_relay);
+
+/* Forward declaration for multipath (defined with data transfer) */
+static void rx_multipath(void *user_data, const cyxwiz_node_id_t *from,
+                         const uint8_t *data, size_t len, int via_relay);
+
+/* Forward declaration for on_netmon_change (defined with network change) */
+static void on_netmon_change(cyxchat_netmon_t *nm,
+                             const cyxchat_netmon_addr_t *old_addr,
+                             const cyxchat_netmon_addr_t *new_addr,
+                             void *user_data);
+
 static uint64_t get_time_ms(void)
 {
 #ifdef _WIN32
@@ -138,62 +303,324 @@ static uint64_t get_time_ms(void)
 #endif
 }
 
-static cyxchat_peer_conn_t* find_peer_conn(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+/* ============================================================
+ * Node ID Table
+ * ============================================================ */
+
+static uint32_t node_id_hash(const cyxwiz_node_id_t *id)
 {
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (ctx->peers[i].active &&
-            memcmp(&ctx->peers[i].peer_id, peer_id, sizeof(cyxwiz_node_id_t)) == 0) {
-            return &ctx->peers[i];
+    /* IDs are hash outputs, except relay pseudo-IDs, so mix both ends */
+    uint32_t a, b;
+    memcpy(&a, id->bytes, sizeof(a));
+    memcpy(&b, id->bytes + CYXWIZ_NODE_ID_LEN - sizeof(b), sizeof(b));
+    uint32_t h = a ^ (b * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h;
+}
+
+static void* table_entry(const conn_table_t *t, size_t n)
+{
+    return t->chunks[n / CONN_TABLE_CHUNK] + (n % CONN_TABLE_CHUNK) * t->elem_size;
+}
+
+static int table_init(conn_table_t *t, size_t elem_size, size_t initial, size_t max_entries)
+{
+    memset(t, 0, sizeof(conn_table_t));
+    t->elem_size = elem_size;
+    t->max_entries = max_entries;
+
+    size_t size = 16;
+    while (size * CONN_TABLE_MAX_LOAD < initial * 100) {
+        size *= 2;
+    }
+
+    t->index = calloc(size, sizeof(uint32_t));
+    t->hashes = calloc(size, sizeof(uint32_t));
+    if (!t->index || !t->hashes) {
+        free(t->index);
+        free(t->hashes);
+        return 0;
+    }
+    t->index_size = size;
+    return 1;
+}
+
+static void table_free(conn_table_t *t)
+{
+    for (size_t i = 0; i < t->chunk_count; i++) {
+        free(t->chunks[i]);
+    }
+    free(t->chunks);
+    free(t->free_list);
+    free(t->index);
+    free(t->hashes);
+    memset(t, 0, sizeof(conn_table_t));
+}
+
+/* Returns index slot holding id, or index_size if absent */
+static size_t table_probe(const conn_table_t *t, const cyxwiz_node_id_t *id, uint32_t h)
+{
+    size_t mask = t->index_size - 1;
+    for (size_t i = h & mask; t->index[i] != 0; i = (i + 1) & mask) {
+        if (t->hashes[i] == h &&
+            memcmp(table_entry(t, t->index[i] - 1), id, sizeof(cyxwiz_node_id_t)) == 0) {
+            return i;
         }
     }
-    return NULL;
+    return t->index_size;
+}
+
+static void* table_find(const conn_table_t *t, const cyxwiz_node_id_t *id)
+{
+    size_t slot = table_probe(t, id, node_id_hash(id));
+    if (slot == t->index_size) return NULL;
+    return table_entry(t, t->index[slot] - 1);
+}
+
+static void table_index_put(uint32_t *index, uint32_t *hashes, size_t size,
+                            uint32_t entry, uint32_t h)
+{
+    size_t mask = size - 1;
+    size_t i = h & mask;
+    while (index[i] != 0) {
+        i = (i + 1) & mask;
+    }
+    index[i] = entry;
+    hashes[i] = h;
 }
 
-static cyxchat_peer_conn_t* alloc_peer_conn(cyxchat_conn_ctx_t *ctx)
+static int table_grow_index(conn_table_t *t)
 {
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (!ctx->peers[i].active) {
-            memset(&ctx->peers[i], 0, sizeof(cyxchat_peer_conn_t));
-            ctx->peers[i].active = 1;
-            ctx->peer_count++;
-            return &ctx->peers[i];
+    size_t size = t->index_size * 2;
+    uint32_t *index = calloc(size, sizeof(uint32_t));
+    uint32_t *hashes = calloc(size, sizeof(uint32_t));
+    if (!index || !hashes) {
+        free(index);
+        free(hashes);
+        return 0;
+    }
+
+    for (size_t i = 0; i < t->index_size; i++) {
+        if (t->index[i] != 0) {
+            table_index_put(index, hashes, size, t->index[i], t->hashes[i]);
         }
     }
-    return NULL;
+
+    free(t->index);
+    free(t->hashes);
+    t->index = index;
+    t->hashes = hashes;
+    t->index_size = size;
+    return 1;
 }
 
-static cyxchat_pending_conn_t* find_pending(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+/* Insert a zeroed entry for id; NULL if at max_entries or out of memory */
+static void* table_insert(conn_table_t *t, const cyxwiz_node_id_t *id)
+{
+    if (t->max_entries && t->count >= t->max_entries) {
+        return NULL;
+    }
+
+    if ((t->count + 1) * 100 > t->index_size * CONN_TABLE_MAX_LOAD) {
+        if (!table_grow_index(t)) return NULL;
+    }
+
+    size_t n;
+    if (t->free_count > 0) {
+        n = t->free_list[--t->free_count];
+    } else {
+        if (t->used == t->chunk_count * CONN_TABLE_CHUNK) {
+            uint8_t **chunks = realloc(t->chunks, (t->chunk_count + 1) * sizeof(uint8_t*));
+            if (!chunks) return NULL;
+            t->chunks = chunks;
+
+            uint32_t *free_list = realloc(t->free_list,
+                (t->chunk_count + 1) * CONN_TABLE_CHUNK * sizeof(uint32_t));
+            if (!free_list) return NULL;
+            t->free_list = free_list;
+
+            t->chunks[t->chunk_count] = calloc(CONN_TABLE_CHUNK, t->elem_size);
+            if (!t->chunks[t->chunk_count]) return NULL;
+            t->chunk_count++;
+        }
+        n = t->used++;
+    }
+
+    void *e = table_entry(t, n);
+    memset(e, 0, t->elem_size);
+    memcpy(e, id, sizeof(cyxwiz_node_id_t));
+
+    table_index_put(t->index, t->hashes, t->index_size, (uint32_t)(n + 1), node_id_hash(id));
+    t->count++;
+    return e;
+}
+
+/* Remove id from the index (backward-shift deletion) and recycle its entry */
+static void table_remove(conn_table_t *t, const cyxwiz_node_id_t *id)
 {
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (ctx->pending[i].active &&
-            memcmp(&ctx->pending[i].peer_id, peer_id, sizeof(cyxwiz_node_id_t)) == 0) {
-            return &ctx->pending[i];
+    size_t i = table_probe(t, id, node_id_hash(id));
+    if (i == t->index_size) return;
+
+    t->free_list[t->free_count++] = t->index[i] - 1;
+
+    size_t mask = t->index_size - 1;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (t->index[j] == 0) break;
+
+        /* Entry at j may fill the hole at i only if its home is not in (i, j] */
+        size_t home = t->hashes[j] & mask;
+        int stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!stays) {
+            t->index[i] = t->index[j];
+            t->hashes[i] = t->hashes[j];
+            i = j;
         }
     }
-    return NULL;
+    t->index[i] = 0;
+    t->count--;
+}
+
+/* ============================================================
+ * Datagram Batches
+ * ============================================================ */
+
+static int batch_init(conn_pkt_batch_t *b, size_t cap, size_t mtu)
+{
+    memset(b, 0, sizeof(*b));
+    b->peers = (cyxwiz_node_id_t*)malloc(cap * sizeof(cyxwiz_node_id_t));
+    b->lens = (uint16_t*)malloc(cap * sizeof(uint16_t));
+    b->data = (uint8_t*)malloc(cap * mtu);
+    if (!b->peers || !b->lens || !b->data) {
+        free(b->peers);
+        free(b->lens);
+        free(b->data);
+        memset(b, 0, sizeof(*b));
+        return 0;
+    }
+    b->cap = cap;
+    b->mtu = mtu;
+    return 1;
+}
+
+static void batch_free(conn_pkt_batch_t *b)
+{
+    if (b->data) {
+        cyxwiz_secure_zero(b->data, b->cap * b->mtu);
+    }
+    free(b->peers);
+    free(b->lens);
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+/* Caller ensures count < cap and len <= mtu */
+static void batch_push(conn_pkt_batch_t *b, const cyxwiz_node_id_t *peer,
+                       const uint8_t *data, size_t len)
+{
+    memcpy(&b->peers[b->count], peer, sizeof(cyxwiz_node_id_t));
+    b->lens[b->count] = (uint16_t)len;
+    memcpy(b->data + b->count * b->mtu, data, len);
+    b->count++;
+}
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static cyxchat_peer_conn_t* find_peer_conn(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+{
+    return (cyxchat_peer_conn_t*)table_find(&ctx->peers, peer_id);
+}
+
+static cyxchat_peer_conn_t* peer_conn_at(cyxchat_conn_ctx_t *ctx, size_t n)
+{
+    return (cyxchat_peer_conn_t*)table_entry(&ctx->peers, n);
 }
 
-static cyxchat_pending_conn_t* alloc_pending(cyxchat_conn_ctx_t *ctx)
+static cyxchat_peer_conn_t* alloc_peer_conn(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
 {
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (!ctx->pending[i].active) {
-            memset(&ctx->pending[i], 0, sizeof(cyxchat_pending_conn_t));
-            ctx->pending[i].active = 1;
-            ctx->pending_count++;
-            return &ctx->pending[i];
+    cyxchat_peer_conn_t *peer = (cyxchat_peer_conn_t*)table_insert(&ctx->peers, peer_id);
+
+    if (!peer) {
+        /* At capacity: recycle the longest-idle disconnected peer */
+        cyxchat_peer_conn_t *victim = NULL;
+        for (size_t n = 0; n < ctx->peers.used; n++) {
+            cyxchat_peer_conn_t *p = peer_conn_at(ctx, n);
+            if (p->active && p->state == CYXCHAT_CONN_DISCONNECTED &&
+                !table_find(&ctx->pending, &p->peer_id) &&
+                (!victim || p->last_activity < victim->last_activity)) {
+                victim = p;
+            }
         }
+        if (!victim) return NULL;
+
+        cyxchat_timer_cancel(ctx->timers, &victim->idle_timer);
+        cyxchat_timer_cancel(ctx->timers, &victim->ice_timer);
+        cyxchat_timer_cancel(ctx->timers, &victim->probe_timer);
+        table_remove(&ctx->peers, &victim->peer_id);
+        ctx->peer_count--;
+        peer = (cyxchat_peer_conn_t*)table_insert(&ctx->peers, peer_id);
+        if (!peer) return NULL;
+    }
+
+    peer->active = 1;
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&peer->mp_tx_seq, sizeof(peer->mp_tx_seq));
+    cyxchat_ice_init(&peer->ice);
+    cyxchat_linkstats_init(&peer->stats);
+    ctx->peer_count++;
+    return peer;
+}
+
+static cyxchat_pending_conn_t* find_pending(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+{
+    return (cyxchat_pending_conn_t*)table_find(&ctx->pending, peer_id);
+}
+
+static cyxchat_pending_conn_t* alloc_pending(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+{
+    cyxchat_pending_conn_t *pending = (cyxchat_pending_conn_t*)table_insert(&ctx->pending, peer_id);
+    if (pending) {
+        pending->active = 1;
+        ctx->pending_count++;
     }
-    return NULL;
+    return pending;
 }
 
 static void free_pending(cyxchat_conn_ctx_t *ctx, cyxchat_pending_conn_t *pending)
 {
+    cyxchat_timer_cancel(ctx->timers, &pending->timeout_timer);
+    cyxchat_timer_cancel(ctx->timers, &pending->relay_timer);
     pending->active = 0;
+    table_remove(&ctx->pending, &pending->peer_id);
     if (ctx->pending_count > 0) {
         ctx->pending_count--;
     }
 }
 
+static void on_peer_idle_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Arm idle timer for whatever is left of the timeout since last activity */
+static void arm_idle_timer(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    uint64_t elapsed = get_time_ms() - peer->last_activity;
+    uint64_t remaining = elapsed >= CYXCHAT_CONNECTION_TIMEOUT_MS ?
+                         0 : CYXCHAT_CONNECTION_TIMEOUT_MS - elapsed;
+
+    cyxchat_timer_schedule(ctx->timers, &peer->idle_timer,
+                           cyxchat_timer_now(ctx->timers) + remaining,
+                           on_peer_idle_timer, ctx);
+}
+
+static void stop_repunch(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    peer->repunching = 0;
+    cyxchat_timer_cancel(ctx->timers, &peer->punch_timer);
+}
+
 static void set_peer_state(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
                            cyxchat_conn_state_t new_state)
 {
@@ -202,8 +629,39 @@ static void set_peer_state(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
 
     peer->state = new_state;
 
-    if (new_state == CYXCHAT_CONN_CONNECTED || new_state == CYXCHAT_CONN_RELAYING) {
+    int was_up = (old_state == CYXCHAT_CONN_CONNECTED || old_state == CYXCHAT_CONN_RELAYING);
+    int is_up = (new_state == CYXCHAT_CONN_CONNECTED || new_state == CYXCHAT_CONN_RELAYING);
+    if (is_up != was_up) {
+        CYXCHAT_GAUGE_ADD(CYXCHAT_METRIC_PEERS_UP, is_up ? 1 : -1);
+    }
+
+    if (is_up) {
         peer->connected_at = get_time_ms();
+        if (!was_up) {
+            /* A relay session can come up before the peer says anything */
+            peer->last_activity = peer->connected_at;
+        }
+        if (!cyxchat_timer_pending(&peer->idle_timer)) {
+            arm_idle_timer(ctx, peer);
+        }
+        if (old_state != CYXCHAT_CONN_CONNECTED && old_state != CYXCHAT_CONN_RELAYING) {
+            /* Swap candidates and start checking on the next wheel advance */
+            uint64_t now = cyxchat_timer_now(ctx->timers);
+            peer->candidates_sent = 0;
+            cyxchat_timer_schedule(ctx->timers, &peer->ice_timer, now, on_ice_timer, ctx);
+            arm_keepalive(ctx);
+        }
+    } else {
+        cyxchat_timer_cancel(ctx->timers, &peer->idle_timer);
+        cyxchat_timer_cancel(ctx->timers, &peer->ice_timer);
+        cyxchat_timer_cancel(ctx->timers, &peer->probe_timer);
+        peer->ice.checking = -1;
+        peer->probe_tag = 0;
+        peer->relay_forced = 0;
+        stop_repunch(ctx, peer);
+        if (was_up) {
+            labels_peer_down(ctx, &peer->peer_id);
+        }
     }
 
     if (ctx->on_state_change) {
@@ -212,6 +670,83 @@ static void set_peer_state(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
     }
 }
 
+/* Report the first working path (or failure) to the connect caller once */
+static void notify_pending(cyxchat_conn_ctx_t *ctx, cyxchat_pending_conn_t *pending,
+                           cyxchat_conn_state_t state, cyxchat_error_t result)
+{
+    if (pending->notified) return;
+    pending->notified = 1;
+
+    uint64_t elapsed_us = (get_time_ms() - pending->start_time) * 1000;
+    if (state == CYXCHAT_CONN_CONNECTED) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_CONN_DIRECT, 1);
+        CYXCHAT_OBSERVE(CYXCHAT_METRIC_HOLE_PUNCH, elapsed_us);
+    } else if (state == CYXCHAT_CONN_RELAYING) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_CONN_RELAYED, 1);
+        CYXCHAT_OBSERVE(CYXCHAT_METRIC_RELAY_SETUP, elapsed_us);
+    } else {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_CONN_FAILED, 1);
+    }
+    (void)elapsed_us;
+
+    if (pending->callback) {
+        pending->callback(ctx, &pending->peer_id, state, result, pending->user_data);
+    }
+}
+
+/* Symmetric or blocked NAT on our side: a punch will not open a path */
+static int punch_hopeless(cyxchat_conn_ctx_t *ctx)
+{
+    return ctx->nat_type == CYXWIZ_NAT_SYMMETRIC || ctx->nat_type == CYXWIZ_NAT_BLOCKED;
+}
+
+/*
+ * Open a relay session; returns 1 if it was requested. A peer that is
+ * up moves onto it at once, a connecting one only once the relay has
+ * delivered (relay_won).
+ */
+static int start_relay(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    if (!ctx->relay || cyxchat_relay_connect(ctx->relay, &peer->peer_id) != CYXCHAT_OK) {
+        return 0;
+    }
+    peer->is_relayed = 1;
+    if (peer->state != CYXCHAT_CONN_CONNECTING) {
+        set_peer_state(ctx, peer, CYXCHAT_CONN_RELAYING);
+    }
+    return 1;
+}
+
+/* The relay delivered before the punch did: report it, the punch keeps going */
+static void relay_won(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    if (peer->state != CYXCHAT_CONN_CONNECTING) return;
+
+    cyxchat_pending_conn_t *pending = find_pending(ctx, &peer->peer_id);
+    peer->is_relayed = 1;
+    set_peer_state(ctx, peer, CYXCHAT_CONN_RELAYING);
+    if (pending) {
+        peer->repunching = 1;
+        cyxchat_timer_cancel(ctx->timers, &pending->relay_timer);
+        notify_pending(ctx, pending, CYXCHAT_CONN_RELAYING, CYXCHAT_OK);
+    }
+}
+
+/* A direct datagram got through: drop the relay session */
+static void upgrade_to_direct(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    stop_repunch(ctx, peer);
+    cyxchat_pending_conn_t *pending = find_pending(ctx, &peer->peer_id);
+    if (pending) {
+        free_pending(ctx, pending);
+    }
+    if (ctx->relay) {
+        cyxchat_relay_disconnect(ctx->relay, &peer->peer_id);
+    }
+    peer->is_relayed = 0;
+    set_peer_state(ctx, peer, CYXCHAT_CONN_CONNECTED);
+}
+
 /* Relay data callback - forwards relay data to application */
 static void on_relay_data(cyxchat_relay_ctx_t *relay_ctx,
                           const cyxwiz_node_id_t *from,
@@ -221,11 +756,23 @@ static void on_relay_data(cyxchat_relay_ctx_t *relay_ctx,
     (void)relay_ctx;
     cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
 
+    CYXCHAT_TRACE_MARK_RX(CYXCHAT_TRACE_RELAY_RX, len);
+
     /* Update peer connection state */
     cyxchat_peer_conn_t *peer = find_peer_conn(ctx, from);
     if (peer) {
         peer->last_activity = get_time_ms();
-        peer->bytes_received += (uint32_t)len;
+        cyxchat_linkstats_on_recv(&peer->stats, len, peer->last_activity);
+
+        /* Peer's relay session won the race */
+        relay_won(ctx, peer);
+    }
+
+    /* Session payload; link frames inside one are just data */
+    const cyxchat_dispatch_entry_t *h = len > 0 ? &ctx->rx_table.entries[data[0]] : NULL;
+    if (h && h->fn && !(h->flags & CYXCHAT_DISPATCH_LINK)) {
+        h->fn(h->user_data, from, data, len, 1);
+        return;
     }
 
     /* Forward to application callback */
@@ -234,87 +781,167 @@ static void on_relay_data(cyxchat_relay_ctx_t *relay_ctx,
     }
 }
 
+/* Relay session answered (or ended) */
+static void on_relay_state(cyxchat_relay_ctx_t *relay_ctx,
+                           const cyxwiz_node_id_t *peer_id,
+                           int connected,
+                           void *user_data)
+{
+    (void)relay_ctx;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer) return;
+
+    if (connected) {
+        relay_won(ctx, peer);
+    } else if (peer->state == CYXCHAT_CONN_CONNECTING) {
+        /* Refused or timed out before it delivered: only the punch is left */
+        peer->is_relayed = 0;
+    }
+}
+
 /* Discovery message types (0x01-0x05) */
 #define CYXCHAT_DISC_ANNOUNCE     0x01
-#define CYXCHAT_DISC_ANNOUNCE_ACK 0x02
-#define CYXCHAT_DISC_PING         0x03
-#define CYXCHAT_DISC_PONG         0x04
 #define CYXCHAT_DISC_GOODBYE      0x05
 
-/* Check if message is a discovery protocol message */
-static int is_discovery_message(uint8_t type)
+/* Receive handlers claimed at create (user_data is the context) */
+static void rx_relay(void *user_data, const cyxwiz_node_id_t *from,
+                     const uint8_t *data, size_t len, int via_relay)
 {
-    return type >= CYXCHAT_DISC_ANNOUNCE && type <= CYXCHAT_DISC_GOODBYE;
+    (void)from;
+    (void)via_relay;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_relay_handle_message(ctx->relay, data, len);
 }
 
-/* Transport callbacks */
-static void on_transport_recv(cyxwiz_transport_t *transport,
-                              const cyxwiz_node_id_t *from,
-                              const uint8_t *data, size_t len,
-                              void *user_data)
+static void rx_onion(void *user_data, const cyxwiz_node_id_t *from,
+                     const uint8_t *data, size_t len, int via_relay)
 {
-    (void)transport;  /* Unused - we use the transport from context */
+    (void)via_relay;
     cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
-
-    /* Check for relay messages and handle them */
-    if (len > 0 && ctx->relay && cyxchat_relay_is_relay_message(data[0])) {
-        cyxchat_relay_handle_message(ctx->relay, data, len);
-        return;  /* Relay handler forwards data via callback */
+    cyxwiz_error_t err = cyxwiz_onion_handle_message(ctx->onion, from, data, len);
+    if (err != CYXWIZ_OK && err != CYXWIZ_ERR_RATE_LIMITED) {
+        CYXWIZ_DEBUG("Onion message handling failed: %d", err);
     }
+}
 
-    /* Route discovery messages to discovery handler for key exchange */
-    if (len > 0 && ctx->discovery && is_discovery_message(data[0])) {
-        /* Debug: log announce message details (pubkey at offset 37) */
-        if (data[0] == CYXCHAT_DISC_ANNOUNCE && len >= 69) {
-            const uint8_t *pk = data + 37;  /* pubkey offset */
-            int has_pk = 0;
-            for (int i = 0; i < 32; i++) {
-                if (pk[i] != 0) { has_pk = 1; break; }
-            }
-            (void)has_pk;  /* Used for debugging */
-        }
-        cyxwiz_discovery_handle_message(ctx->discovery, from, data, len);
-        /* Don't return - also process below for connection state updates */
+static void rx_discovery(void *user_data, const cyxwiz_node_id_t *from,
+                         const uint8_t *data, size_t len, int via_relay)
+{
+    (void)via_relay;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxwiz_discovery_handle_message(ctx->discovery, from, data, len);
+}
+
+static void rx_conn_control(void *user_data, const cyxwiz_node_id_t *from,
+                            const uint8_t *data, size_t len, int via_relay)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    handle_conn_control(ctx, find_peer_conn(ctx, from), from, data, len, via_relay);
+}
+
+/* Claim our own protocol ranges; anything left is the application's */
+static void register_rx_handlers(cyxchat_conn_ctx_t *ctx)
+{
+    cyxchat_dispatch_t *d = &ctx->rx_table;
+
+    cyxchat_dispatch_init(d);
+    cyxchat_dispatch_register(d, CYXCHAT_MSG_CONN_CANDIDATES, CYXCHAT_MSG_CONN_CHECK_ACK, 0,
+                              rx_conn_control, ctx);
+    cyxchat_dispatch_register(d, CYXCHAT_MSG_LABEL_REQUEST, CYXCHAT_MSG_LABEL_DATA, 0,
+                              rx_label, ctx);
+    cyxchat_dispatch_register(d, CYXCHAT_MSG_CONN_MULTIPATH, CYXCHAT_MSG_CONN_MULTIPATH, 0,
+                              rx_multipath, ctx);
+    cyxchat_dispatch_register(d, CYXCHAT_MSG_LABEL_BACK, CYXCHAT_MSG_LABEL_BACK, 0,
+                              rx_label, ctx);
+    if (ctx->relay) {
+        cyxchat_dispatch_register(d, CYXCHAT_RELAY_CONNECT, CYXCHAT_RELAY_ERROR,
+                                  CYXCHAT_DISPATCH_LINK, rx_relay, ctx);
     }
+    if (ctx->discovery) {
+        cyxchat_dispatch_register(d, CYXCHAT_DISC_ANNOUNCE, CYXCHAT_DISC_GOODBYE, 0,
+                                  rx_discovery, ctx);
+    }
+    if (ctx->onion &&
+        cyxchat_dispatch_register(d, CYXWIZ_MSG_ONION_DATA, CYXWIZ_MSG_ONION_DATA,
+                                  CYXCHAT_DISPATCH_LINK, rx_onion, ctx) != CYXCHAT_OK) {
+        CYXWIZ_WARN("Onion message type 0x%02x already claimed", CYXWIZ_MSG_ONION_DATA);
+    }
+}
 
-    /* Route onion data messages to onion handler */
-    if (len > 0 && ctx->onion && data[0] == CYXWIZ_MSG_ONION_DATA) {
-        cyxwiz_error_t err = cyxwiz_onion_handle_message(ctx->onion, from, data, len);
-        if (err != CYXWIZ_OK && err != CYXWIZ_ERR_RATE_LIMITED) {
-            CYXWIZ_DEBUG("Onion message handling failed: %d", err);
-        }
-        return;  /* Onion messages are fully handled by onion layer */
+/* Dispatch one received datagram */
+static void handle_datagram(cyxchat_conn_ctx_t *ctx,
+                            const cyxwiz_node_id_t *from,
+                            const uint8_t *data, size_t len,
+                            uint64_t now)
+{
+    const cyxchat_dispatch_entry_t *h = len > 0 ? &ctx->rx_table.entries[data[0]] : NULL;
+
+    /* Claimed by the chat layer if this datagram delivers a traced message */
+    CYXCHAT_TRACE_MARK_RX(CYXCHAT_TRACE_TRANSPORT_RX, len);
+
+    /* Relay and onion frames are not traffic from the peer they come from */
+    if (h && (h->flags & CYXCHAT_DISPATCH_LINK)) {
+        h->fn(h->user_data, from, data, len, 0);
+        return;
     }
 
     /* Update peer connection state */
     cyxchat_peer_conn_t *peer = find_peer_conn(ctx, from);
     if (peer) {
-        peer->last_activity = get_time_ms();
-        peer->bytes_received += (uint32_t)len;
+        peer->last_activity = now;
+        cyxchat_linkstats_on_recv(&peer->stats, len, now);
 
         /* If we were connecting and got data, we're connected */
         if (peer->state == CYXCHAT_CONN_CONNECTING) {
             set_peer_state(ctx, peer, CYXCHAT_CONN_CONNECTED);
+            if (peer->is_relayed && ctx->relay) {
+                /* The relay lost the race before it delivered */
+                cyxchat_relay_disconnect(ctx->relay, &peer->peer_id);
+            }
             peer->is_relayed = 0;
+            stop_repunch(ctx, peer);
 
             /* Complete pending connection */
             cyxchat_pending_conn_t *pending = find_pending(ctx, from);
-            if (pending && pending->callback) {
-                pending->callback(ctx, from, CYXCHAT_CONN_CONNECTED, CYXCHAT_OK,
-                                 pending->user_data);
-            }
             if (pending) {
-                free_pending(ctx, pending);
+                notify_pending(ctx, pending, CYXCHAT_CONN_CONNECTED, CYXCHAT_OK);
+                if (pending->active) {
+                    free_pending(ctx, pending);
+                }
             }
+        } else if (peer->state == CYXCHAT_CONN_RELAYING && peer->repunching) {
+            /* Punch came through after the relay won (or after a network
+             * change): upgrade to direct and drop the relay session */
+            upgrade_to_direct(ctx, peer);
         }
     }
 
-    /* Forward to application callback (skip discovery messages) */
-    if (ctx->on_data && !(len > 0 && is_discovery_message(data[0]))) {
+    /* Claimed types stop at their handler; the rest go to the application */
+    if (h && h->fn) {
+        h->fn(h->user_data, from, data, len, 0);
+        return;
+    }
+
+    if (ctx->on_data) {
         ctx->on_data(ctx, from, data, len, ctx->data_user_data);
     }
 }
 
+/* Transport callbacks */
+static void on_transport_recv(cyxwiz_transport_t *transport,
+                              const cyxwiz_node_id_t *from,
+                              const uint8_t *data, size_t len,
+                              void *user_data)
+{
+    (void)transport;  /* Unused - we use the transport from context */
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+
+    ctx->io_stats.rx_packets++;
+    handle_datagram(ctx, from, data, len, get_time_ms());
+}
+
 static void on_peer_discovered(cyxwiz_transport_t *transport,
                                const cyxwiz_peer_info_t *peer,
                                void *user_data)
@@ -339,9 +966,8 @@ static void on_peer_discovered(cyxwiz_transport_t *transport,
     uint64_t now = get_time_ms();
 
     if (!conn) {
-        conn = alloc_peer_conn(ctx);
+        conn = alloc_peer_conn(ctx, &peer->id);
         if (conn) {
-            conn->peer_id = peer->id;
             conn->state = CYXCHAT_CONN_DISCONNECTED;
             conn->rssi = peer->rssi;
             conn->last_announce_sent = 0;  /* Never sent */
@@ -380,9 +1006,8 @@ static void on_dht_node_discovered(const cyxwiz_node_id_t *node_id, void *user_d
     /* Update or create peer connection record */
     cyxchat_peer_conn_t *conn = find_peer_conn(ctx, node_id);
     if (!conn) {
-        conn = alloc_peer_conn(ctx);
+        conn = alloc_peer_conn(ctx, node_id);
         if (conn) {
-            conn->peer_id = *node_id;
             conn->state = CYXCHAT_CONN_DISCONNECTED;
             conn->rssi = 0;
         }
@@ -410,9 +1035,8 @@ static void on_peer_key_received(const cyxwiz_node_id_t *peer_id,
 
     if (!conn) {
         /* Create peer connection for new peer */
-        conn = alloc_peer_conn(ctx);
+        conn = alloc_peer_conn(ctx, peer_id);
         if (conn) {
-            conn->peer_id = *peer_id;
             conn->state = CYXCHAT_CONN_DISCONNECTED;
             conn->last_key_exchange = 0;
         }
@@ -434,11 +1058,12 @@ static void on_peer_key_received(const cyxwiz_node_id_t *peer_id,
     /* Add peer's public key to onion context for shared secret computation */
     cyxwiz_error_t err = cyxwiz_onion_add_peer_key(ctx->onion, peer_id, peer_pubkey);
     if (err == CYXWIZ_OK) {
-        char hex_id[17];
-        for (int i = 0; i < 8; i++) {
-            snprintf(hex_id + i*2, 3, "%02x", peer_id->bytes[i]);
+        CYXCHAT_TRACE(CYXCHAT_TRACE_KEY_EXCHANGE, peer_id, 0);
+        if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_INFO)) {
+            char hex_id[17];
+            cyxchat_log_peer_prefix(peer_id, hex_id);
+            CYXWIZ_INFO("Key exchange complete with peer %.16s...", hex_id);
         }
-        CYXWIZ_INFO("Key exchange complete with peer %.16s...", hex_id);
 
         /* WORKAROUND: Explicitly set peer to CONNECTED state after successful key exchange. */
         if (ctx->peer_table) {
@@ -460,31 +1085,171 @@ typedef struct {
     /* Rest not needed */
 } cyxchat_udp_state_view_t;
 
-/* Discovery announce message - matches cyxwiz_disc_announce_t */
+/* The transport's socket state, NULL for loopback or before init */
+static cyxchat_udp_state_view_t* udp_view(cyxchat_conn_ctx_t *ctx)
+{
+    cyxchat_udp_state_view_t *udp_state = ctx->transport && !ctx->loopnet ?
+        (cyxchat_udp_state_view_t*)ctx->transport->driver_data : NULL;
+    return udp_state && udp_state->initialized ? udp_state : NULL;
+}
+
+/* Internal UDP punch packet type */
+#define CYXWIZ_UDP_PUNCH 0xF4
+
+/* Socket error code macro */
+#ifdef _WIN32
+#define CONN_SOCKET_ERROR WSAGetLastError()
+#else
+#define CONN_SOCKET_ERROR errno
+#endif
+
+/* UDP punch packet structure (matches udp.c - packed for network) */
 #ifdef _MSC_VER
 #pragma pack(push, 1)
 #endif
 typedef struct {
-    uint8_t type;           /* 0x01 = ANNOUNCE */
-    uint8_t version;        /* 1 */
-    cyxwiz_node_id_t node_id;
-    uint8_t capabilities;
-    uint16_t port;
-    uint8_t pubkey[32];
+    uint8_t type;
+    cyxwiz_node_id_t sender_id;
+    uint32_t punch_id;
 }
 #ifdef __GNUC__
 __attribute__((packed))
 #endif
-cyxchat_announce_t;
+cyxchat_punch_packet_t;
 #ifdef _MSC_VER
 #pragma pack(pop)
 #endif
 
-/* Send discovery ANNOUNCE to a specific peer to initiate key exchange */
-static void send_announce_to_peer(cyxchat_conn_ctx_t *ctx,
-                                   const cyxwiz_node_id_t *peer_id)
+/* Parse "ip:port" (or "host:port") into a socket address */
+static cyxchat_error_t parse_addr(const char *addr, struct sockaddr_in *out)
 {
-    if (!ctx || !ctx->transport || !ctx->onion || !peer_id) return;
+    char ip_str[64];
+    int port = 0;
+
+    const char *colon = strchr(addr, ':');
+    if (!colon) {
+        CYXWIZ_WARN("Invalid address format (missing port): %s", addr);
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    size_t ip_len = (size_t)(colon - addr);
+    if (ip_len >= sizeof(ip_str)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    memcpy(ip_str, addr, ip_len);
+    ip_str[ip_len] = '\0';
+    port = atoi(colon + 1);
+
+    if (port <= 0 || port > 65535) {
+        CYXWIZ_WARN("Invalid port: %d", port);
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    memset(out, 0, sizeof(*out));
+    out->sin_family = AF_INET;
+    out->sin_port = htons((uint16_t)port);
+
+    if (inet_pton(AF_INET, ip_str, &out->sin_addr) != 1) {
+        /* Try resolving as hostname */
+        struct addrinfo hints, *result;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        if (getaddrinfo(ip_str, NULL, &hints, &result) != 0) {
+            CYXWIZ_WARN("Failed to resolve address: %s", ip_str);
+            return CYXCHAT_ERR_NETWORK;
+        }
+
+        struct sockaddr_in *sin = (struct sockaddr_in *)result->ai_addr;
+        out->sin_addr = sin->sin_addr;
+        freeaddrinfo(result);
+    }
+
+    return CYXCHAT_OK;
+}
+
+/*
+ * Send a raw punch from the transport socket. The peer's transport maps
+ * our node ID to the address the punch arrives from, so this also picks
+ * the path its replies take back to us.
+ */
+static cyxchat_error_t send_punch(cyxchat_conn_ctx_t *ctx, uint32_t ip, uint16_t port,
+                                  uint32_t punch_id)
+{
+    /* The loopback network punches through its emulated NATs */
+    if (ctx->loopnet) {
+        (void)punch_id;
+        return cyxchat_loopnet_punch(ctx->transport, ip, port);
+    }
+
+    /* Get the transport's socket from driver_data */
+    cyxchat_udp_state_view_t *udp_state = udp_view(ctx);
+    if (!udp_state) {
+        return CYXCHAT_ERR_NETWORK;  /* Transport not initialized */
+    }
+
+#ifdef _WIN32
+    SOCKET sock = udp_state->socket_fd;
+    if (sock == INVALID_SOCKET) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+#else
+    int sock = udp_state->socket_fd;
+    if (sock < 0) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+#endif
+
+    struct sockaddr_in dest_addr;
+    memset(&dest_addr, 0, sizeof(dest_addr));
+    dest_addr.sin_family = AF_INET;
+    dest_addr.sin_addr.s_addr = ip;
+    dest_addr.sin_port = port;
+
+    /* Build punch packet */
+    cyxchat_punch_packet_t punch;
+    memset(&punch, 0, sizeof(punch));
+    punch.type = CYXWIZ_UDP_PUNCH;
+    memcpy(&punch.sender_id, &ctx->local_id, sizeof(cyxwiz_node_id_t));
+    punch.punch_id = punch_id;
+
+    int sent = sendto(sock, (const char *)&punch, sizeof(punch), 0,
+                      (struct sockaddr *)&dest_addr, sizeof(dest_addr));
+    if (sent < 0) {
+        CYXWIZ_WARN("Failed to send punch packet: %d", CONN_SOCKET_ERROR);
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    return CYXCHAT_OK;
+}
+
+/* Discovery announce message - matches cyxwiz_disc_announce_t */
+#ifdef _MSC_VER
+#pragma pack(push, 1)
+#endif
+typedef struct {
+    uint8_t type;           /* 0x01 = ANNOUNCE */
+    uint8_t version;        /* 1 */
+    cyxwiz_node_id_t node_id;
+    uint8_t capabilities;
+    uint16_t port;
+    uint8_t pubkey[32];
+}
+#ifdef __GNUC__
+__attribute__((packed))
+#endif
+cyxchat_announce_t;
+#ifdef _MSC_VER
+#pragma pack(pop)
+#endif
+
+/* Send discovery ANNOUNCE to a specific peer to initiate key exchange */
+static void send_announce_to_peer(cyxchat_conn_ctx_t *ctx,
+                                   const cyxwiz_node_id_t *peer_id)
+{
+    if (!ctx || !ctx->transport || !ctx->onion || !peer_id) return;
 
     /* Get our X25519 public key */
     uint8_t our_pubkey[32];
@@ -508,34 +1273,180 @@ static void send_announce_to_peer(cyxchat_conn_ctx_t *ctx,
                                                     (uint8_t*)&announce, sizeof(announce));
 
     if (err == CYXWIZ_OK) {
-        char hex_id[17];
-        for (int i = 0; i < 8; i++) {
-            snprintf(hex_id + i*2, 3, "%02x", peer_id->bytes[i]);
+        CYXCHAT_TRACE(CYXCHAT_TRACE_ANNOUNCE_SENT, peer_id, sizeof(announce));
+        if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_DEBUG)) {
+            char hex_id[17];
+            cyxchat_log_peer_prefix(peer_id, hex_id);
+            CYXWIZ_DEBUG("Sent key exchange announce to peer %.16s...", hex_id);
         }
-        CYXWIZ_INFO("Sent key exchange announce to peer %.16s...", hex_id);
     } else {
-        char hex_id[17];
-        for (int i = 0; i < 8; i++) {
-            snprintf(hex_id + i*2, 3, "%02x", peer_id->bytes[i]);
+        CYXCHAT_TRACE(CYXCHAT_TRACE_ANNOUNCE_FAIL, peer_id, (uint32_t)err);
+        if (CYXCHAT_LOG_ENABLED(CYXCHAT_LOG_LEVEL_DEBUG)) {
+            char hex_id[17];
+            cyxchat_log_peer_prefix(peer_id, hex_id);
+            CYXWIZ_DEBUG("Failed to send announce to %.16s... (err=%d)", hex_id, err);
+        }
+    }
+}
+
+/* ============================================================
+ * Poll Wake
+ * ============================================================ */
+
+/*
+ * A blocking poll waits on the transport socket and a wake handle
+ * together, so cyxchat_conn_wake() can cut it short from any thread.
+ * The cyxwiz poll only knows its own socket, so it then runs without
+ * blocking and reads whatever the wait found.
+ */
+
+static int wake_open(cyxchat_conn_ctx_t *ctx)
+{
+#ifdef _WIN32
+    ctx->sock_evented = INVALID_SOCKET;
+    ctx->wake_event = WSACreateEvent();
+    ctx->sock_event = WSACreateEvent();
+    return ctx->wake_event != WSA_INVALID_EVENT && ctx->sock_event != WSA_INVALID_EVENT;
+#elif defined(__linux__)
+    ctx->wake_fd[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ctx->wake_fd[1] = ctx->wake_fd[0];
+    return ctx->wake_fd[0] >= 0;
+#else
+    if (pipe(ctx->wake_fd) != 0) {
+        ctx->wake_fd[0] = ctx->wake_fd[1] = -1;
+        return 0;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(ctx->wake_fd[i], F_SETFL, fcntl(ctx->wake_fd[i], F_GETFL) | O_NONBLOCK);
+        fcntl(ctx->wake_fd[i], F_SETFD, FD_CLOEXEC);
+    }
+    return 1;
+#endif
+}
+
+static void wake_close(cyxchat_conn_ctx_t *ctx)
+{
+#ifdef _WIN32
+    if (ctx->wake_event != WSA_INVALID_EVENT) WSACloseEvent(ctx->wake_event);
+    if (ctx->sock_event != WSA_INVALID_EVENT) WSACloseEvent(ctx->sock_event);
+#else
+    if (ctx->wake_fd[1] >= 0 && ctx->wake_fd[1] != ctx->wake_fd[0]) close(ctx->wake_fd[1]);
+    if (ctx->wake_fd[0] >= 0) close(ctx->wake_fd[0]);
+#endif
+}
+
+/* Block until the socket is readable, a wake arrives or timeout_ms passes */
+static void wake_wait(cyxchat_conn_ctx_t *ctx, uint32_t timeout_ms)
+{
+    cyxchat_udp_state_view_t *udp_state = udp_view(ctx);
+
+#ifdef _WIN32
+    WSAEVENT events[2];
+    DWORD count = 0;
+    events[count++] = ctx->wake_event;
+    if (udp_state && udp_state->socket_fd != INVALID_SOCKET) {
+        /* Binding the event is sticky, so it is only redone for a new socket */
+        if (ctx->sock_evented != udp_state->socket_fd &&
+            WSAEventSelect(udp_state->socket_fd, ctx->sock_event, FD_READ) == 0) {
+            ctx->sock_evented = udp_state->socket_fd;
+        }
+        if (ctx->sock_evented == udp_state->socket_fd) {
+            events[count++] = ctx->sock_event;
+        }
+    }
+
+    WSAWaitForMultipleEvents(count, events, FALSE,
+                             timeout_ms == UINT32_MAX ? WSA_INFINITE : timeout_ms, FALSE);
+    WSAResetEvent(ctx->wake_event);
+    if (count > 1) WSAResetEvent(ctx->sock_event);
+#else
+    struct pollfd fds[2];
+    nfds_t count = 0;
+    fds[count].fd = ctx->wake_fd[0];
+    fds[count++].events = POLLIN;
+    if (udp_state && udp_state->socket_fd >= 0) {
+        fds[count].fd = udp_state->socket_fd;
+        fds[count++].events = POLLIN;
+    }
+
+    int timeout = timeout_ms == UINT32_MAX ? -1 :
+                  timeout_ms > INT_MAX ? INT_MAX : (int)timeout_ms;
+    if (poll(fds, count, timeout) > 0 && (fds[0].revents & POLLIN)) {
+        uint64_t drain;
+        while (read(ctx->wake_fd[0], &drain, sizeof(drain)) > 0) {
         }
-        CYXWIZ_DEBUG("Failed to send announce to %.16s... (err=%d)", hex_id, err);
     }
+#endif
+}
+
+/*
+ * Poll the transport, blocking for up to the poll timeout first.
+ * Loopback nodes have no socket: the wait runs until their next
+ * arrival instead. Returns the milliseconds spent waiting.
+ */
+static uint64_t transport_poll(cyxchat_conn_ctx_t *ctx)
+{
+    uint64_t waited = 0;
+    uint32_t timeout_ms = ctx->poll_timeout_ms;
+    if (ctx->loopnet) {
+        timeout_ms = cyxchat_loopnet_poll_wait(ctx->transport, timeout_ms);
+    }
+    if (timeout_ms > 0) {
+        uint64_t start = get_time_ms();
+        wake_wait(ctx, timeout_ms);
+        waited = get_time_ms() - start;
+    }
+    ctx->transport->ops->poll(ctx->transport, 0);
+    return waited;
+}
+
+void cyxchat_conn_wake(cyxchat_conn_ctx_t *ctx)
+{
+    if (!ctx) return;
+
+#ifdef _WIN32
+    WSASetEvent(ctx->wake_event);
+#else
+    uint64_t one = 1;
+    ssize_t n = write(ctx->wake_fd[1], &one, ctx->wake_fd[1] == ctx->wake_fd[0] ? sizeof(one) : 1);
+    (void)n;    /* A full pipe already holds a wake */
+#endif
 }
 
 /* ============================================================
  * Lifecycle
  * ============================================================ */
 
-cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
-                                     const char *bootstrap,
-                                     const cyxwiz_node_id_t *local_id)
+static void close_transport(cyxchat_conn_ctx_t *ctx)
+{
+    ctx->transport->ops->shutdown(ctx->transport);
+    if (ctx->loopnet) {
+        cyxchat_loopnet_transport_destroy(ctx->transport);
+    } else {
+        cyxwiz_transport_destroy(ctx->transport);
+    }
+}
+
+static cyxchat_error_t conn_create(cyxchat_conn_ctx_t **ctx,
+                                   const char *bootstrap,
+                                   cyxchat_loopnet_t *loopnet,
+                                   const cyxwiz_node_id_t *local_id,
+                                   const cyxchat_config_t *config)
 {
     if (!ctx || !local_id) {
         return CYXCHAT_ERR_NULL;
     }
 
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
     /* Set bootstrap environment if provided */
-    if (bootstrap && strlen(bootstrap) > 0) {
+    if (loopnet) {
+        CYXWIZ_INFO("Using loopback network");
+    } else if (bootstrap && strlen(bootstrap) > 0) {
         CYXWIZ_INFO("Setting bootstrap server: %s", bootstrap);
 #ifdef _WIN32
         _putenv_s("CYXWIZ_BOOTSTRAP", bootstrap);
@@ -553,10 +1464,57 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     }
 
     c->local_id = *local_id;
+    c->loopnet = loopnet;
+    c->poll_timeout_ms = CYXCHAT_CONN_POLL_TIMEOUT_MS;
+#ifdef _WIN32
+    c->wake_event = c->sock_event = WSA_INVALID_EVENT;
+#else
+    c->wake_fd[0] = c->wake_fd[1] = -1;
+#endif
+    c->relay_stagger_ms = CYXCHAT_RELAY_STAGGER_MS;
 
-    /* Create UDP transport */
-    cyxwiz_error_t err = cyxwiz_transport_create(CYXWIZ_TRANSPORT_UDP, &c->transport);
-    if (err != CYXWIZ_OK) {
+    /* Peer and pending tables grow on demand up to the peer limit */
+    size_t initial = CYXCHAT_MAX_PEER_CONNECTIONS;
+    if (config->max_peers > 0 && config->max_peers < initial) {
+        initial = config->max_peers;
+    }
+    if (!table_init(&c->peers, sizeof(cyxchat_peer_conn_t), initial, config->max_peers) ||
+        !table_init(&c->pending, sizeof(cyxchat_pending_conn_t), initial, config->max_peers)) {
+        table_free(&c->peers);
+        table_free(&c->pending);
+        free(c);
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    if (cyxchat_label_table_create(&c->labels, config->label_table_size) != CYXCHAT_OK) {
+        table_free(&c->peers);
+        table_free(&c->pending);
+        free(c);
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    if (cyxchat_timer_wheel_create(&c->timers, get_time_ms()) != CYXCHAT_OK) {
+        cyxchat_label_table_destroy(c->labels);
+        table_free(&c->peers);
+        table_free(&c->pending);
+        free(c);
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    /* Create UDP transport (or attach to the loopback network) */
+    cyxwiz_error_t err = CYXWIZ_OK;
+    if (loopnet) {
+        if (cyxchat_loopnet_transport_create(loopnet, &c->transport) != CYXCHAT_OK) {
+            c->transport = NULL;
+        }
+    } else {
+        err = cyxwiz_transport_create(CYXWIZ_TRANSPORT_UDP, &c->transport);
+    }
+    if (err != CYXWIZ_OK || !c->transport) {
+        table_free(&c->peers);
+        table_free(&c->pending);
+        cyxchat_label_table_destroy(c->labels);
+        cyxchat_timer_wheel_destroy(c->timers);
         free(c);
         return CYXCHAT_ERR_NETWORK;
     }
@@ -573,8 +1531,11 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     /* Create peer table */
     err = cyxwiz_peer_table_create(&c->peer_table);
     if (err != CYXWIZ_OK) {
-        c->transport->ops->shutdown(c->transport);
-        cyxwiz_transport_destroy(c->transport);
+        close_transport(c);
+        table_free(&c->peers);
+        table_free(&c->pending);
+        cyxchat_label_table_destroy(c->labels);
+        cyxchat_timer_wheel_destroy(c->timers);
         free(c);
         return CYXCHAT_ERR_MEMORY;
     }
@@ -583,8 +1544,11 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     err = cyxwiz_router_create(&c->router, c->peer_table, c->transport, local_id);
     if (err != CYXWIZ_OK) {
         cyxwiz_peer_table_destroy(c->peer_table);
-        c->transport->ops->shutdown(c->transport);
-        cyxwiz_transport_destroy(c->transport);
+        close_transport(c);
+        table_free(&c->peers);
+        table_free(&c->pending);
+        cyxchat_label_table_destroy(c->labels);
+        cyxchat_timer_wheel_destroy(c->timers);
         free(c);
         return CYXCHAT_ERR_MEMORY;
     }
@@ -594,8 +1558,11 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     if (err != CYXWIZ_OK) {
         cyxwiz_router_destroy(c->router);
         cyxwiz_peer_table_destroy(c->peer_table);
-        c->transport->ops->shutdown(c->transport);
-        cyxwiz_transport_destroy(c->transport);
+        close_transport(c);
+        table_free(&c->peers);
+        table_free(&c->pending);
+        cyxchat_label_table_destroy(c->labels);
+        cyxchat_timer_wheel_destroy(c->timers);
         free(c);
         return CYXCHAT_ERR_NETWORK;
     }
@@ -605,8 +1572,11 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     if (err != CYXWIZ_OK) {
         cyxwiz_router_destroy(c->router);
         cyxwiz_peer_table_destroy(c->peer_table);
-        c->transport->ops->shutdown(c->transport);
-        cyxwiz_transport_destroy(c->transport);
+        close_transport(c);
+        table_free(&c->peers);
+        table_free(&c->pending);
+        cyxchat_label_table_destroy(c->labels);
+        cyxchat_timer_wheel_destroy(c->timers);
         free(c);
         return CYXCHAT_ERR_MEMORY;
     }
@@ -667,6 +1637,26 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     /* Set relay callbacks */
     if (c->relay) {
         cyxchat_relay_set_on_data(c->relay, on_relay_data, c);
+        cyxchat_relay_set_on_state(c->relay, on_relay_state, c);
+        cyxchat_relay_set_timer_wheel(c->relay, c->timers);
+    }
+
+    /* Periodic STUN refresh and route change detection (optional) */
+    if (loopnet) {
+        c->netmon = NULL;           /* No NAT or route changes in-process */
+    } else if (cyxchat_netmon_create(&c->netmon, c->timers, NULL) == CYXCHAT_OK) {
+        cyxchat_netmon_set_on_change(c->netmon, on_netmon_change, c);
+        cyxchat_netmon_set_lifetime_probe(c->netmon, 1);
+    } else {
+        CYXWIZ_WARN("Network change detection unavailable");
+        c->netmon = NULL;
+    }
+
+    register_rx_handlers(c);
+
+    if (!wake_open(c)) {
+        cyxchat_conn_destroy(c);
+        return CYXCHAT_ERR_MEMORY;
     }
 
     /* Start discovery */
@@ -676,14 +1666,50 @@ cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
     c->stun_complete = 0;
     c->bootstrap_connected = 0;
 
+    /* No STUN in-process: the rendezvous mapping is our public address */
+    if (loopnet &&
+        cyxchat_loopnet_get_mapped(c->transport, &c->public_ip, &c->public_port) == CYXCHAT_OK) {
+        c->stun_complete = 1;
+    }
+
     *ctx = c;
     return CYXCHAT_OK;
 }
 
+cyxchat_error_t cyxchat_conn_create(cyxchat_conn_ctx_t **ctx,
+                                     const char *bootstrap,
+                                     const cyxwiz_node_id_t *local_id)
+{
+    return conn_create(ctx, bootstrap, NULL, local_id, NULL);
+}
+
+cyxchat_error_t cyxchat_conn_create_with_config(cyxchat_conn_ctx_t **ctx,
+                                                 const char *bootstrap,
+                                                 const cyxwiz_node_id_t *local_id,
+                                                 const cyxchat_config_t *config)
+{
+    return conn_create(ctx, bootstrap, NULL, local_id, config);
+}
+
+cyxchat_error_t cyxchat_conn_create_loopback(cyxchat_conn_ctx_t **ctx,
+                                              cyxchat_loopnet_t *net,
+                                              const cyxwiz_node_id_t *local_id)
+{
+    if (!net) {
+        return CYXCHAT_ERR_NULL;
+    }
+    return conn_create(ctx, NULL, net, local_id, NULL);
+}
+
 void cyxchat_conn_destroy(cyxchat_conn_ctx_t *ctx)
 {
     if (!ctx) return;
 
+    /* Send anything still queued while the transport is up */
+    if (ctx->batch_io) {
+        flush_tx(ctx);
+    }
+
     /* Stop and destroy discovery */
     if (ctx->discovery) {
         cyxwiz_discovery_stop(ctx->discovery);
@@ -711,6 +1737,9 @@ void cyxchat_conn_destroy(cyxchat_conn_ctx_t *ctx)
         cyxchat_relay_destroy(ctx->relay);
     }
 
+    /* Destroy network monitor */
+    cyxchat_netmon_destroy(ctx->netmon);
+
     /* Destroy peer table */
     if (ctx->peer_table) {
         cyxwiz_peer_table_destroy(ctx->peer_table);
@@ -719,449 +1748,2089 @@ void cyxchat_conn_destroy(cyxchat_conn_ctx_t *ctx)
     /* Shutdown transport */
     if (ctx->transport) {
         ctx->transport->ops->stop_discover(ctx->transport);
-        ctx->transport->ops->shutdown(ctx->transport);
-        cyxwiz_transport_destroy(ctx->transport);
+        close_transport(ctx);
+    }
+
+    /* Peers still up leave the live gauge with their context */
+    for (size_t n = 0; n < ctx->peers.used; n++) {
+        cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+        if (peer->active && (peer->state == CYXCHAT_CONN_CONNECTED ||
+                             peer->state == CYXCHAT_CONN_RELAYING)) {
+            CYXCHAT_GAUGE_ADD(CYXCHAT_METRIC_PEERS_UP, -1);
+        }
     }
 
+    table_free(&ctx->peers);
+    table_free(&ctx->pending);
+    batch_free(&ctx->tx);
+    cyxchat_label_table_destroy(ctx->labels);
+    cyxwiz_secure_zero(ctx->label_secret, sizeof(ctx->label_secret));
+
+    /* Relay has already released its timers */
+    cyxchat_timer_wheel_destroy(ctx->timers);
+    wake_close(ctx);
+
     free(ctx);
 }
 
-int cyxchat_conn_poll(cyxchat_conn_ctx_t *ctx, uint64_t now_ms)
-{
-    if (!ctx) return 0;
+/* ============================================================
+ * Batched I/O
+ * ============================================================ */
 
-    int events = 0;
+/* The whole queue in one vectored send through the emulated network */
+static void flush_tx(cyxchat_conn_ctx_t *ctx)
+{
+    if (ctx->tx.count == 0) return;
 
-    /* Poll transport */
-    if (ctx->transport) {
-        ctx->transport->ops->poll(ctx->transport, 10);
-        events++;
+    cyxchat_datagram_t dgrams[CYXCHAT_CONN_BATCH_PACKETS];
+    for (size_t i = 0; i < ctx->tx.count; i++) {
+        dgrams[i].to = &ctx->tx.peers[i];
+        dgrams[i].data = ctx->tx.data + i * ctx->tx.mtu;
+        dgrams[i].len = ctx->tx.lens[i];
     }
 
-    /* Poll relay */
-    if (ctx->relay) {
-        events += cyxchat_relay_poll(ctx->relay, now_ms);
-    }
+    size_t sent = cyxchat_loopnet_send_batch(ctx->transport, dgrams, ctx->tx.count);
+    if (sent > ctx->tx.count) sent = ctx->tx.count;
+    ctx->io_stats.tx_packets += sent;
+    ctx->io_stats.tx_errors += ctx->tx.count - sent;
 
-    /* Poll router */
-    if (ctx->router) {
-        cyxwiz_router_poll(ctx->router, now_ms);
-    }
+    ctx->tx.count = 0;
+    ctx->io_stats.tx_batches++;
+}
 
-    /* Poll onion */
-    if (ctx->onion) {
-        cyxwiz_onion_poll(ctx->onion, now_ms);
+cyxchat_error_t cyxchat_conn_set_batch_io(cyxchat_conn_ctx_t *ctx, int enabled)
+{
+    if (!ctx) {
+        return CYXCHAT_ERR_NULL;
     }
 
-    /* Poll DHT */
-    if (ctx->dht) {
-        cyxwiz_dht_poll(ctx->dht, now_ms);
+    /* Only the loopback transport can take a batch in one call */
+    if (!ctx->loopnet) {
+        return CYXCHAT_ERR_INVALID;
     }
 
-    /* Poll discovery for announcements and key exchange */
-    if (ctx->discovery) {
-        cyxwiz_discovery_poll(ctx->discovery, now_ms);
+    enabled = enabled ? 1 : 0;
+    if (enabled == ctx->batch_io) {
+        return CYXCHAT_OK;
     }
 
-    /* Update NAT info from transport */
-    if (!ctx->stun_complete) {
-        ctx->nat_type = cyxwiz_transport_get_nat_type(ctx->transport);
-        if (ctx->nat_type != CYXWIZ_NAT_UNKNOWN) {
-            ctx->stun_complete = 1;
+    if (enabled) {
+        size_t mtu = ctx->transport->ops->max_packet_size(ctx->transport);
+        if (mtu == 0) mtu = CONN_BATCH_DEFAULT_MTU;
+        if (mtu > UINT16_MAX) mtu = UINT16_MAX;
+
+        if (!batch_init(&ctx->tx, CYXCHAT_CONN_BATCH_PACKETS, mtu)) {
+            return CYXCHAT_ERR_MEMORY;
         }
+    } else {
+        flush_tx(ctx);
+        batch_free(&ctx->tx);
     }
 
-    /* Check pending connections for timeout */
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        cyxchat_pending_conn_t *pending = &ctx->pending[i];
-        if (!pending->active) continue;
+    ctx->batch_io = enabled;
+    return CYXCHAT_OK;
+}
 
-        uint64_t elapsed = now_ms - pending->start_time;
+void cyxchat_conn_get_io_stats(cyxchat_conn_ctx_t *ctx, cyxchat_conn_io_stats_t *stats_out)
+{
+    if (!ctx || !stats_out) return;
+    *stats_out = ctx->io_stats;
+}
 
-        if (elapsed >= CYXCHAT_HOLE_PUNCH_TIMEOUT_MS) {
-            /* Hole punch timed out, try relay */
-            cyxchat_peer_conn_t *peer = find_peer_conn(ctx, &pending->peer_id);
+void cyxchat_conn_set_multipath(cyxchat_conn_ctx_t *ctx, int enabled)
+{
+    if (ctx) {
+        ctx->multipath = enabled ? 1 : 0;
+    }
+}
+
+void cyxchat_conn_set_poll_timeout(cyxchat_conn_ctx_t *ctx, uint32_t timeout_ms)
+{
+    if (ctx) {
+        ctx->poll_timeout_ms = timeout_ms;
+    }
+}
+
+/* ============================================================
+ * Connection Timers
+ * ============================================================ */
+
+/* Peer idle timer: activity only stamps last_activity, so re-arm lazily */
+static void on_peer_idle_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)now_ms;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_peer_conn_t *peer = CONN_TIMER_OWNER(timer, cyxchat_peer_conn_t, idle_timer);
+
+    if (!peer->active) return;
+    if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+        return;
+    }
+
+    if (get_time_ms() - peer->last_activity >= CYXCHAT_CONNECTION_TIMEOUT_MS) {
+        /* Peer timed out */
+        set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
+    } else {
+        arm_idle_timer(ctx, peer);
+    }
+}
+
+/* Relay stagger timer: the punch had its head start, race the relay */
+static void on_relay_stagger(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)now_ms;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_pending_conn_t *pending =
+        CONN_TIMER_OWNER(timer, cyxchat_pending_conn_t, relay_timer);
+
+    if (!pending->active) return;
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, &pending->peer_id);
+    if (!peer || peer->state != CYXCHAT_CONN_CONNECTING) return;
+
+    /*
+     * The punch keeps going; the relay is only reported once it delivers
+     * (relay_won). On failure the punch deadline retries it once more.
+     */
+    start_relay(ctx, peer);
+}
+
+/* Pending connection timer: hole punch deadline */
+static void on_pending_timeout(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_pending_conn_t *pending =
+        CONN_TIMER_OWNER(timer, cyxchat_pending_conn_t, timeout_timer);
+
+    if (!pending->active) return;
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, &pending->peer_id);
+    if (peer && peer->state == CYXCHAT_CONN_RELAYING) {
+        /* Relay won and the punch never landed: stay relayed */
+        stop_repunch(ctx, peer);
+    } else if (peer) {
+        /* Neither path delivered: a relay not asked yet gets a window of its own */
+        if (!peer->is_relayed && start_relay(ctx, peer)) {
+            cyxchat_timer_schedule(ctx->timers, &pending->timeout_timer,
+                                   now_ms + CYXCHAT_HOLE_PUNCH_TIMEOUT_MS,
+                                   on_pending_timeout, ctx);
+            return;
+        }
+        if (peer->is_relayed && ctx->relay) {
+            cyxchat_relay_disconnect(ctx->relay, &peer->peer_id);
+        }
+        peer->is_relayed = 0;
+        set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
+        notify_pending(ctx, pending, CYXCHAT_CONN_DISCONNECTED, CYXCHAT_ERR_TIMEOUT);
+    }
+
+    /* Callback may already have cancelled the request */
+    if (pending->active) {
+        free_pending(ctx, pending);
+    }
+}
+
+/* ============================================================
+ * Network Change
+ * ============================================================ */
+
+/* Re-punch timer: announce bursts reopen the hole from our new address */
+static void on_punch_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_peer_conn_t *peer = CONN_TIMER_OWNER(timer, cyxchat_peer_conn_t, punch_timer);
+
+    if (!peer->active || !peer->repunching) return;
+
+    if (peer->punches_left == 0) {
+        /* No direct reply in time; the relay bridge stays up */
+        peer->repunching = 0;
+        return;
+    }
+
+    send_announce_to_peer(ctx, &peer->peer_id);
+    peer->punches_left--;
+
+    uint64_t next = peer->punches_left > 0 ?
+                    now_ms + CYXCHAT_HOLE_PUNCH_INTERVAL_MS :
+                    peer->repunch_started + CYXCHAT_HOLE_PUNCH_TIMEOUT_MS;
+    cyxchat_timer_schedule(ctx->timers, &peer->punch_timer, next, on_punch_timer, ctx);
+}
+
+/* Bridge a direct peer through the relay and start re-punching it */
+static void start_repunch(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    if (!peer->is_relayed) {
+        start_relay(ctx, peer);
+    }
+
+    peer->repunching = 1;
+    peer->punches_left = CYXCHAT_HOLE_PUNCH_ATTEMPTS;
+    peer->repunch_started = now;
+
+    /* Every peer's burst starts on the same advance */
+    cyxchat_timer_schedule(ctx->timers, &peer->punch_timer, now, on_punch_timer, ctx);
+}
+
+/* Local port of the transport socket (NAT assumed port-preserving) */
+static uint16_t transport_port(cyxchat_conn_ctx_t *ctx)
+{
+    cyxchat_udp_state_view_t *udp_state = udp_view(ctx);
+    if (!udp_state) return 0;
+
+    struct sockaddr_in local;
+    socklen_t local_len = sizeof(local);
+    memset(&local, 0, sizeof(local));
+    if (getsockname(udp_state->socket_fd, (struct sockaddr*)&local, &local_len) != 0) {
+        return 0;
+    }
+    return local.sin_port;
+}
+
+static void on_netmon_change(cyxchat_netmon_t *nm,
+                             const cyxchat_netmon_addr_t *old_addr,
+                             const cyxchat_netmon_addr_t *new_addr,
+                             void *user_data)
+{
+    (void)nm;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+
+    uint16_t port = transport_port(ctx);
+    ctx->public_ip = new_addr->public_ip;
+    ctx->public_port = port ? port : new_addr->public_port;
+    ctx->stun_complete = 1;
+
+    if (old_addr) {
+        ctx->network_changes++;
+        CYXWIZ_INFO("Network changed, re-punching %zu peers", ctx->peer_count);
+
+        /* NAT type may differ on the new network */
+        ctx->nat_type = CYXWIZ_NAT_UNKNOWN;
+
+        /* Re-register with bootstrap so peers learn the new address */
+        if (ctx->transport) {
+            ctx->transport->ops->discover(ctx->transport);
+        }
+
+        uint64_t now = cyxchat_timer_now(ctx->timers);
+        for (size_t n = 0; n < ctx->peers.used; n++) {
+            cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+            if (!peer->active) continue;
+
+            /* Relayed peers may have a direct path on the new network too */
+            if (peer->state == CYXCHAT_CONN_CONNECTED ||
+                peer->state == CYXCHAT_CONN_RELAYING) {
+                start_repunch(ctx, peer, now);
+            }
+        }
+    }
+
+    /* Our candidates moved: re-advertise them and re-rank every path */
+    for (size_t n = 0; n < ctx->peers.used; n++) {
+        cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+        if (!peer->active) continue;
+        if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+            continue;
+        }
+
+        peer->candidates_sent = 0;
+        peer->ice.checking = -1;
+        peer->ice.selected = -1;
+        cyxchat_linkstats_reset_path(&peer->stats);
+        cyxchat_timer_schedule(ctx->timers, &peer->ice_timer,
+                               cyxchat_timer_now(ctx->timers), on_ice_timer, ctx);
+    }
+
+    if (ctx->on_network_change) {
+        ctx->on_network_change(ctx, ctx->public_ip, ctx->public_port,
+                               ctx->network_change_user_data);
+    }
+}
+
+/* ============================================================
+ * Path Selection (ICE-lite)
+ * ============================================================ */
+
+/*
+ * cyxwiz hides source addresses, so a check cannot watch which path a
+ * reply took. Instead it steers: a raw punch to candidate i makes the
+ * peer's transport send to us from then on via the address that punch
+ * arrived from, and the CHECK/CHECK_ACK round trip that follows measures
+ * that return path. Rounds run one candidate at a time per peer (peers
+ * run in parallel), then the winner is punched once more so the peer's
+ * transport stays on it. Each side ranks the path it receives on.
+ */
+
+#define CONN_CHECK_LEN      5           /* Type + 32-bit tag */
+#define CONN_PROBE_MISSES   3           /* Unanswered echoes before bridging */
+#define CONN_SAMPLE_HOLD_MS 2000        /* Per-RTT probing after a request */
+#define CONN_SAMPLE_MIN_MS  50          /* Fastest probe rate */
+
+static void put_tag(uint8_t *buf, uint32_t tag)
+{
+    buf[0] = (uint8_t)(tag & 0xFF);
+    buf[1] = (uint8_t)((tag >> 8) & 0xFF);
+    buf[2] = (uint8_t)((tag >> 16) & 0xFF);
+    buf[3] = (uint8_t)((tag >> 24) & 0xFF);
+}
+
+static uint32_t get_tag(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/* Our host, server reflexive and relay candidates */
+static size_t gather_candidates(cyxchat_conn_ctx_t *ctx, cyxchat_ice_candidate_t *out,
+                                size_t max)
+{
+    uint16_t port = transport_port(ctx);
+    size_t n = port ? cyxchat_ice_gather_host(out, max, port) : 0;
+
+    /* Mapped address; skipped when we are not behind NAT (same as a host) */
+    if (ctx->stun_complete && ctx->public_ip && ctx->public_port && n < max) {
+        size_t i;
+        for (i = 0; i < n && out[i].ip != ctx->public_ip; i++) {}
+        if (i == n) {
+            out[n].type = CYXCHAT_ICE_SRFLX;
+            out[n].ip = ctx->public_ip;
+            out[n].port = ctx->public_port;
+            n++;
+        }
+    }
+
+    for (size_t i = 0; i < ctx->relay_cand_count && n < max; i++) {
+        out[n++] = ctx->relay_cands[i];
+    }
+    return n;
+}
+
+/* Control message on the peer's current path (relay while relayed) */
+static cyxchat_error_t send_control(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
+                                    const uint8_t *msg, size_t len, int direct)
+{
+    cyxchat_error_t result;
+
+    if (!direct && peer->is_relayed && ctx->relay) {
+        result = cyxchat_relay_send(ctx->relay, &peer->peer_id, msg, len);
+    } else if (ctx->transport) {
+        cyxwiz_error_t err = ctx->transport->ops->send(ctx->transport, &peer->peer_id,
+                                                       msg, len);
+        result = (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+    } else {
+        result = CYXCHAT_ERR_NETWORK;
+    }
+
+    /* Counted, but not activity: only replies keep a peer alive */
+    if (result == CYXCHAT_OK) {
+        cyxchat_linkstats_on_send(&peer->stats, len, get_time_ms());
+    }
+    return result;
+}
+
+static cyxchat_error_t send_candidates(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    cyxchat_ice_candidate_t cands[CYXCHAT_ICE_MAX_CANDIDATES];
+    size_t count = gather_candidates(ctx, cands, CYXCHAT_ICE_MAX_CANDIDATES);
+    if (count == 0) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    uint8_t msg[2 + CYXCHAT_ICE_MAX_CANDIDATES * CYXCHAT_ICE_WIRE_SIZE];
+    msg[0] = CYXCHAT_MSG_CONN_CANDIDATES;
+    size_t len = cyxchat_ice_encode(cands, count, msg + 1, sizeof(msg) - 1);
+
+    return send_control(ctx, peer, msg, 1 + len, 0);
+}
+
+static void finish_checks(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    cyxchat_ice_checklist_t *cl = &peer->ice;
+    int prev = cl->selected;
+    int best = cyxchat_ice_select(cl);
+
+    if (best >= 0) {
+        /* Last punch wins: leave the peer sending to us on the best path */
+        send_punch(ctx, cl->cand[best].ip, cl->cand[best].port, cl->tag);
+        if (best != prev) {
+            CYXWIZ_DEBUG("Path %d selected (rtt %u ms)", best, cl->rtt_ms[best]);
+            cyxchat_linkstats_reset_path(&peer->stats);
+        }
+    }
+
+    cyxchat_timer_schedule(ctx->timers, &peer->ice_timer, now + CYXCHAT_ICE_RECHECK_MS,
+                           on_ice_timer, ctx);
+}
+
+/* Steer the peer onto the candidate under check and time a round trip */
+static void run_check(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    cyxchat_ice_checklist_t *cl = &peer->ice;
+
+    while (cl->checking >= 0) {
+        const cyxchat_ice_candidate_t *cand = &cl->cand[cl->checking];
+
+        cl->tag = ++peer->tx_seq;
+        uint8_t msg[CONN_CHECK_LEN];
+        msg[0] = CYXCHAT_MSG_CONN_CHECK;
+        put_tag(msg + 1, cl->tag);
+
+        /* Direct even while relayed: a reply is what proves the path */
+        if (send_punch(ctx, cand->ip, cand->port, cl->tag) == CYXCHAT_OK &&
+            send_control(ctx, peer, msg, sizeof(msg), 1) == CYXCHAT_OK) {
+            cl->sent_at = get_time_ms();
+            cyxchat_timer_schedule(ctx->timers, &peer->ice_timer,
+                                   now + CYXCHAT_ICE_CHECK_TIMEOUT_MS, on_ice_timer, ctx);
+            return;
+        }
+
+        cyxchat_ice_record(cl, cl->checking, CYXCHAT_ICE_RTT_NONE);
+        cl->checking = (int8_t)cyxchat_ice_next_check(cl, cl->checking);
+    }
+
+    finish_checks(ctx, peer, now);
+}
+
+static void start_checks(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    cyxchat_ice_checklist_t *cl = &peer->ice;
+
+    /* Open NAT bindings towards every candidate at once */
+    for (int i = cyxchat_ice_next_check(cl, -1); i >= 0; i = cyxchat_ice_next_check(cl, i)) {
+        send_punch(ctx, cl->cand[i].ip, cl->cand[i].port, peer->tx_seq);
+    }
+
+    cl->checking = (int8_t)cyxchat_ice_next_check(cl, -1);
+    run_check(ctx, peer, now);
+}
+
+/* Check reply deadline while a round runs, otherwise the next round */
+static void on_ice_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_peer_conn_t *peer = CONN_TIMER_OWNER(timer, cyxchat_peer_conn_t, ice_timer);
+
+    if (!peer->active) return;
+    if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+        return;
+    }
+
+    cyxchat_ice_checklist_t *cl = &peer->ice;
+    if (cl->checking >= 0) {
+        if (cl->checking == cl->selected) {
+            cyxchat_linkstats_on_probe(&peer->stats, 0);
+        }
+        cyxchat_ice_record(cl, cl->checking, CYXCHAT_ICE_RTT_NONE);
+        cl->checking = (int8_t)cyxchat_ice_next_check(cl, cl->checking);
+        run_check(ctx, peer, now_ms);
+        return;
+    }
+
+    if (!peer->candidates_sent) {
+        peer->candidates_sent = send_candidates(ctx, peer) == CYXCHAT_OK;
+    }
+
+    start_checks(ctx, peer, now_ms);
+}
+
+/* New remote candidates: check them now unless a round is running */
+static void ice_candidates_changed(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer)
+{
+    if (peer->ice.checking >= 0) return;
+    if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+        return;
+    }
+
+    cyxchat_timer_schedule(ctx->timers, &peer->ice_timer, cyxchat_timer_now(ctx->timers),
+                           on_ice_timer, ctx);
+}
+
+/*
+ * Echo probe: a CHECK on the current path (relay while relayed). The
+ * reply is an RTT sample; a missing one is retried at the RTO with
+ * backoff. A direct path that stops answering altogether is bridged
+ * through the relay and re-punched. Idle peers are probed together from
+ * the keepalive window; the per-peer timer only carries reply deadlines
+ * and the per-RTT samples a bulk sender asks for.
+ */
+static int sampling(const cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    return peer->sample_until > now;
+}
+
+/* Gap between samples while a bulk sender wants them */
+static uint64_t sample_spacing(const cyxchat_peer_conn_t *peer)
+{
+    if (peer->stats.rtt_samples == 0) return CYXCHAT_LINK_RTO_MIN_MS;
+    return peer->stats.srtt_ms > CONN_SAMPLE_MIN_MS ? peer->stats.srtt_ms : CONN_SAMPLE_MIN_MS;
+}
+
+/* After a reply or a give-up: next sample, or wait for the window */
+static void probe_done(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    if (sampling(peer, now)) {
+        cyxchat_timer_schedule(ctx->timers, &peer->probe_timer,
+                               now + sample_spacing(peer), on_probe_timer, ctx);
+    } else {
+        cyxchat_timer_cancel(ctx->timers, &peer->probe_timer);
+    }
+}
+
+static void send_probe(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer, uint64_t now)
+{
+    /* A check round is steering the path; sample after it */
+    if (peer->ice.checking >= 0) {
+        cyxchat_timer_schedule(ctx->timers, &peer->probe_timer,
+                               now + CYXCHAT_ICE_CHECK_TIMEOUT_MS, on_probe_timer, ctx);
+        return;
+    }
+
+    uint8_t msg[CONN_CHECK_LEN];
+    uint32_t tag = ++peer->tx_seq;
+    msg[0] = CYXCHAT_MSG_CONN_CHECK;
+    put_tag(msg + 1, tag);
+
+    if (send_control(ctx, peer, msg, sizeof(msg), 0) != CYXCHAT_OK) {
+        probe_done(ctx, peer, now);
+        return;
+    }
+
+    peer->probe_tag = tag;
+    peer->probe_sent_at = get_time_ms();
+    uint64_t wait = (uint64_t)peer->stats.rto_ms << peer->stats.probes_missed;
+    if (wait > CYXCHAT_LINK_RTO_MAX_MS) wait = CYXCHAT_LINK_RTO_MAX_MS;
+
+    cyxchat_timer_schedule(ctx->timers, &peer->probe_timer, now + wait,
+                           on_probe_timer, ctx);
+}
+
+static void on_probe_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    cyxchat_peer_conn_t *peer = CONN_TIMER_OWNER(timer, cyxchat_peer_conn_t, probe_timer);
+
+    if (!peer->active) return;
+    if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+        return;
+    }
+
+    if (peer->probe_tag) {
+        /* Reply deadline passed; peers that never answered are not judged */
+        peer->probe_tag = 0;
+        if (peer->answers_checks) {
+            cyxchat_linkstats_on_probe(&peer->stats, 0);
+        }
+
+        if (peer->stats.probes_missed >= CONN_PROBE_MISSES) {
+            if (!peer->is_relayed && !peer->repunching) {
+                CYXWIZ_INFO("Direct path silent, bridging through relay");
+                start_repunch(ctx, peer, now_ms);
+            }
+            peer->stats.probes_missed = 0;
+            probe_done(ctx, peer, now_ms);
+            return;
+        }
+    }
+
+    send_probe(ctx, peer, now_ms);
+}
+
+/*
+ * Keepalive window: one wake-up echoes every connected peer that is
+ * not already mid-probe and sends the relay's keepalives. Its period
+ * follows the NAT binding lifetime netmon measured, less jitter; the
+ * relay's own interval is set to match, so its timers only fire if
+ * this one stops.
+ */
+static void on_keepalive_window(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    int busy = 0;
+
+    for (size_t n = 0; n < ctx->peers.used; n++) {
+        cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+        if (!peer->active) continue;
+        if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+            continue;
+        }
+
+        busy = 1;
+        if (!cyxchat_timer_pending(&peer->probe_timer)) {
+            send_probe(ctx, peer, now_ms);
+        }
+    }
+
+    if (ctx->relay && cyxchat_relay_keepalive_now(ctx->relay) > 0) {
+        busy = 1;
+    }
+
+    /* Nothing left to keep alive: the next connection re-arms */
+    if (busy) {
+        arm_keepalive(ctx);
+    }
+}
+
+static void arm_keepalive(cyxchat_conn_ctx_t *ctx)
+{
+    if (cyxchat_timer_pending(&ctx->keepalive_timer)) return;
+
+    cyxchat_keepalive_t ka;
+    uint32_t random;
+    cyxchat_netmon_get_keepalive(ctx->netmon, &ka);
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&random, sizeof(random));
+
+    if (ctx->relay) {
+        cyxchat_relay_set_keepalive_interval(ctx->relay, ka.interval_ms);
+    }
+    cyxchat_timer_schedule(ctx->timers, &ctx->keepalive_timer,
+                           cyxchat_timer_now(ctx->timers) +
+                           cyxchat_keepalive_window_ms(&ka, random),
+                           on_keepalive_window, ctx);
+}
+
+static void handle_conn_control(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
+                                const cyxwiz_node_id_t *from,
+                                const uint8_t *data, size_t len, int via_relay)
+{
+    switch (data[0]) {
+        case CYXCHAT_MSG_CONN_CANDIDATES: {
+            if (!peer) break;
+
+            cyxchat_ice_candidate_t cands[CYXCHAT_ICE_MAX_CANDIDATES];
+            int n = cyxchat_ice_decode(data + 1, len - 1, cands, CYXCHAT_ICE_MAX_CANDIDATES);
+            for (int i = 0; i < n; i++) {
+                cyxchat_ice_add(&peer->ice, &cands[i]);
+            }
+            if (n > 0) {
+                ice_candidates_changed(ctx, peer);
+            }
+            break;
+        }
+
+        case CYXCHAT_MSG_CONN_CHECK: {
+            if (len < CONN_CHECK_LEN) break;
+
+            /* Tags run in sequence per sender: gaps are packets lost */
             if (peer) {
-                /* Switch to relay */
-                cyxchat_error_t relay_err = cyxchat_relay_connect(
-                    ctx->relay, &pending->peer_id
-                );
-
-                if (relay_err == CYXCHAT_OK) {
-                    set_peer_state(ctx, peer, CYXCHAT_CONN_RELAYING);
-                    peer->is_relayed = 1;
-
-                    if (pending->callback) {
-                        pending->callback(ctx, &pending->peer_id, CYXCHAT_CONN_RELAYING,
-                                         CYXCHAT_OK, pending->user_data);
-                    }
-                } else {
-                    set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
-
-                    if (pending->callback) {
-                        pending->callback(ctx, &pending->peer_id, CYXCHAT_CONN_DISCONNECTED,
-                                         CYXCHAT_ERR_TIMEOUT, pending->user_data);
-                    }
+                peer->answers_checks = 1;
+                cyxchat_linkstats_on_seq(&peer->stats, get_tag(data + 1));
+            }
+
+            /* Reply the way it came (a check steered us onto that path) */
+            uint8_t ack[CONN_CHECK_LEN];
+            ack[0] = CYXCHAT_MSG_CONN_CHECK_ACK;
+            memcpy(ack + 1, data + 1, 4);
+            if (via_relay && ctx->relay) {
+                cyxchat_relay_send(ctx->relay, from, ack, sizeof(ack));
+            } else if (ctx->transport) {
+                ctx->transport->ops->send(ctx->transport, from, ack, sizeof(ack));
+            }
+            break;
+        }
+
+        case CYXCHAT_MSG_CONN_CHECK_ACK: {
+            if (!peer || len < CONN_CHECK_LEN) break;
+
+            uint32_t tag = get_tag(data + 1);
+            peer->answers_checks = 1;
+
+            if (peer->probe_tag && tag == peer->probe_tag) {
+                peer->probe_tag = 0;
+                cyxchat_linkstats_on_rtt(&peer->stats,
+                                         (uint32_t)(get_time_ms() - peer->probe_sent_at));
+                cyxchat_linkstats_on_probe(&peer->stats, 1);
+                probe_done(ctx, peer, cyxchat_timer_now(ctx->timers));
+                break;
+            }
+
+            cyxchat_ice_checklist_t *cl = &peer->ice;
+            if (cl->checking < 0 || tag != cl->tag) break;
+
+            uint64_t rtt = get_time_ms() - cl->sent_at;
+            cyxchat_ice_record(cl, cl->checking, (uint32_t)rtt);
+
+            /* Only the path in use feeds the estimator */
+            if (cl->checking == cl->selected) {
+                cyxchat_linkstats_on_rtt(&peer->stats, (uint32_t)rtt);
+                cyxchat_linkstats_on_probe(&peer->stats, 1);
+            }
+
+            /* A relayed peer just answered directly */
+            if (!via_relay && peer->state == CYXCHAT_CONN_RELAYING && !peer->relay_forced) {
+                upgrade_to_direct(ctx, peer);
+            }
+
+            cl->checking = (int8_t)cyxchat_ice_next_check(cl, cl->checking);
+            run_check(ctx, peer, cyxchat_timer_now(ctx->timers));
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+int cyxchat_conn_poll(cyxchat_conn_ctx_t *ctx, uint64_t now_ms)
+{
+    if (!ctx) return 0;
+
+    int events = 0;
+
+    /* Poll transport (timers below run at the time the wait ended) */
+    if (ctx->transport) {
+        /* Sends made since the last cycle must not wait out the blocking poll */
+        if (ctx->batch_io) {
+            flush_tx(ctx);
+        }
+        now_ms += transport_poll(ctx);
+        ctx->io_stats.transport_polls++;
+        events++;
+    }
+
+    /* Poll relay */
+    if (ctx->relay) {
+        events += cyxchat_relay_poll(ctx->relay, now_ms);
+    }
+
+    /* Poll router */
+    if (ctx->router) {
+        cyxwiz_router_poll(ctx->router, now_ms);
+    }
+
+    /* Poll onion */
+    if (ctx->onion) {
+        cyxwiz_onion_poll(ctx->onion, now_ms);
+    }
+
+    /* Poll DHT */
+    if (ctx->dht) {
+        cyxwiz_dht_poll(ctx->dht, now_ms);
+    }
+
+    /* Poll discovery for announcements and key exchange */
+    if (ctx->discovery) {
+        cyxwiz_discovery_poll(ctx->discovery, now_ms);
+    }
+
+    /* STUN responses and route changes (probes run off the wheel) */
+    if (ctx->netmon) {
+        events += cyxchat_netmon_poll(ctx->netmon);
+    }
+
+    /* Loopback nodes learn their address from the emulated rendezvous */
+    if (ctx->loopnet) {
+        cyxchat_loopnet_get_mapped(ctx->transport, &ctx->public_ip, &ctx->public_port);
+    }
+
+    /* Update NAT info from transport (cleared on network change) */
+    if (ctx->nat_type == CYXWIZ_NAT_UNKNOWN) {
+        ctx->nat_type = cyxwiz_transport_get_nat_type(ctx->transport);
+        if (ctx->nat_type != CYXWIZ_NAT_UNKNOWN) {
+            ctx->stun_complete = 1;
+        }
+    }
+
+    /* Hole punch and idle deadlines (relay timers share this wheel) */
+    events += cyxchat_timer_advance(ctx->timers, now_ms);
+
+    /* Everything queued during this cycle goes out together */
+    if (ctx->batch_io) {
+        flush_tx(ctx);
+    }
+
+    ctx->last_poll_time = now_ms;
+    return events;
+}
+
+uint64_t cyxchat_conn_next_deadline(cyxchat_conn_ctx_t *ctx)
+{
+    return ctx ? cyxchat_timer_next_deadline(ctx->timers) : CYXCHAT_TIMER_NONE;
+}
+
+cyxchat_timer_wheel_t* cyxchat_conn_get_timer_wheel(cyxchat_conn_ctx_t *ctx)
+{
+    return ctx ? ctx->timers : NULL;
+}
+
+/* ============================================================
+ * Connection Management
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_conn_connect(cyxchat_conn_ctx_t *ctx,
+                                      const cyxwiz_node_id_t *peer_id,
+                                      cyxchat_conn_complete_callback_t callback,
+                                      void *user_data)
+{
+    if (!ctx || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    /* Check if already connected */
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (peer && (peer->state == CYXCHAT_CONN_CONNECTED || peer->state == CYXCHAT_CONN_RELAYING)) {
+        if (callback) {
+            callback(ctx, peer_id, peer->state, CYXCHAT_OK, user_data);
+        }
+        return CYXCHAT_OK;
+    }
+
+    /* Check if already connecting */
+    if (find_pending(ctx, peer_id)) {
+        return CYXCHAT_ERR_EXISTS;
+    }
+
+    /* Allocate peer connection if needed */
+    if (!peer) {
+        peer = alloc_peer_conn(ctx, peer_id);
+        if (!peer) {
+            return CYXCHAT_ERR_FULL;
+        }
+    }
+
+    /* Create pending connection request */
+    cyxchat_pending_conn_t *pending = alloc_pending(ctx, peer_id);
+    if (!pending) {
+        return CYXCHAT_ERR_FULL;
+    }
+
+    pending->callback = callback;
+    pending->user_data = user_data;
+    pending->start_time = get_time_ms();
+    pending->punch_attempts = 0;
+
+    /*
+     * Race both paths: the transport punches now, the relay starts after
+     * a short stagger (at once if our NAT makes punching hopeless), and
+     * whichever delivers first completes the connect. A punch that lands
+     * before the deadline still upgrades a relayed peer to direct.
+     */
+    uint64_t now = cyxchat_timer_now(ctx->timers);
+    cyxchat_timer_schedule(ctx->timers, &pending->timeout_timer,
+                           now + CYXCHAT_HOLE_PUNCH_TIMEOUT_MS,
+                           on_pending_timeout, ctx);
+    if (ctx->relay) {
+        uint64_t stagger = punch_hopeless(ctx) ? 0 : ctx->relay_stagger_ms;
+        cyxchat_timer_schedule(ctx->timers, &pending->relay_timer, now + stagger,
+                               on_relay_stagger, ctx);
+    }
+
+    /* Set state to connecting */
+    set_peer_state(ctx, peer, CYXCHAT_CONN_CONNECTING);
+
+    /* Announce bursts keep our binding open until the peer's punch meets it */
+    peer->repunching = 1;
+    peer->punches_left = CYXCHAT_HOLE_PUNCH_ATTEMPTS;
+    peer->repunch_started = now;
+    cyxchat_timer_schedule(ctx->timers, &peer->punch_timer, now, on_punch_timer, ctx);
+
+    /* When we receive data from this peer directly, the punch succeeded */
+
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_conn_disconnect(cyxchat_conn_ctx_t *ctx,
+                                         const cyxwiz_node_id_t *peer_id)
+{
+    if (!ctx || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    /* Cancel any pending connection */
+    cyxchat_pending_conn_t *pending = find_pending(ctx, peer_id);
+    if (pending) {
+        free_pending(ctx, pending);
+    }
+
+    /* Disconnect peer */
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (peer) {
+        if (peer->is_relayed && ctx->relay) {
+            cyxchat_relay_disconnect(ctx->relay, peer_id);
+        }
+        set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
+        return CYXCHAT_OK;
+    }
+
+    return CYXCHAT_ERR_NOT_FOUND;
+}
+
+cyxchat_conn_state_t cyxchat_conn_get_state(cyxchat_conn_ctx_t *ctx,
+                                             const cyxwiz_node_id_t *peer_id)
+{
+    if (!ctx || !peer_id) {
+        return CYXCHAT_CONN_DISCONNECTED;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (peer) {
+        return peer->state;
+    }
+
+    return CYXCHAT_CONN_DISCONNECTED;
+}
+
+cyxchat_error_t cyxchat_conn_get_info(cyxchat_conn_ctx_t *ctx,
+                                       const cyxwiz_node_id_t *peer_id,
+                                       cyxchat_conn_info_t *info_out)
+{
+    if (!ctx || !peer_id || !info_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    info_out->peer_id = peer->peer_id;
+    info_out->state = peer->state;
+    info_out->connected_at = peer->connected_at;
+    info_out->last_activity = peer->last_activity;
+    info_out->rssi = peer->rssi;
+    info_out->is_relayed = peer->is_relayed;
+
+    cyxchat_linkstats_t *ls = &peer->stats;
+    cyxchat_linkstats_update(ls, get_time_ms());
+    info_out->bytes_sent = ls->bytes_sent;
+    info_out->bytes_received = ls->bytes_received;
+    info_out->packets_sent = ls->packets_sent;
+    info_out->packets_received = ls->packets_received;
+    info_out->packets_lost = ls->packets_lost;
+    info_out->srtt_ms = ls->srtt_ms;
+    info_out->rttvar_ms = ls->rttvar_ms;
+    info_out->min_rtt_ms = ls->min_rtt_ms;
+    info_out->rto_ms = ls->rto_ms;
+    info_out->loss_ppm = ls->loss_ppm;
+    info_out->tx_rate = ls->tx_rate;
+    info_out->rx_rate = ls->rx_rate;
+
+    return CYXCHAT_OK;
+}
+
+int cyxchat_conn_is_relayed(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+{
+    if (!ctx || !peer_id) return 0;
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    return peer ? peer->is_relayed : 0;
+}
+
+cyxchat_error_t cyxchat_conn_get_link_stats(cyxchat_conn_ctx_t *ctx,
+                                             const cyxwiz_node_id_t *peer_id,
+                                             cyxchat_linkstats_t *stats_out)
+{
+    if (!ctx || !peer_id || !stats_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    cyxchat_linkstats_update(&peer->stats, get_time_ms());
+    *stats_out = peer->stats;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_conn_get_keepalive(cyxchat_conn_ctx_t *ctx, cyxchat_keepalive_t *ka_out)
+{
+    if (!ka_out) return;
+    cyxchat_netmon_get_keepalive(ctx ? ctx->netmon : NULL, ka_out);
+}
+
+cyxchat_error_t cyxchat_conn_sample_path(cyxchat_conn_ctx_t *ctx,
+                                          const cyxwiz_node_id_t *peer_id)
+{
+    if (!ctx || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+    if (peer->state != CYXCHAT_CONN_CONNECTED && peer->state != CYXCHAT_CONN_RELAYING) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    uint64_t now = cyxchat_timer_now(ctx->timers);
+    int idle = !sampling(peer, now);
+    peer->sample_until = now + CONN_SAMPLE_HOLD_MS;
+
+    /* Start sampling now; an outstanding echo keeps its deadline */
+    if (idle && !peer->probe_tag) {
+        cyxchat_timer_schedule(ctx->timers, &peer->probe_timer, now,
+                               on_probe_timer, ctx);
+    }
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_conn_get_path(cyxchat_conn_ctx_t *ctx,
+                                       const cyxwiz_node_id_t *peer_id,
+                                       cyxchat_ice_candidate_t *cand_out,
+                                       uint32_t *rtt_ms_out)
+{
+    if (!ctx || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer || peer->ice.selected < 0) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    if (cand_out) {
+        *cand_out = peer->ice.cand[peer->ice.selected];
+    }
+    if (rtt_ms_out) {
+        *rtt_ms_out = peer->ice.rtt_ms[peer->ice.selected];
+    }
+    return CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Data Transfer
+ * ============================================================ */
+
+/* Direct path: queued for the end-of-poll flush when batching */
+static cyxchat_error_t send_direct(cyxchat_conn_ctx_t *ctx,
+                                   const cyxwiz_node_id_t *peer_id,
+                                   const uint8_t *data, size_t len)
+{
+    if (ctx->batch_io && len <= ctx->tx.mtu) {
+        if (ctx->tx.count == ctx->tx.cap) {
+            flush_tx(ctx);
+        }
+        batch_push(&ctx->tx, peer_id, data, len);
+        return CYXCHAT_OK;
+    }
+
+    /* Oversized sends must not overtake queued ones */
+    if (ctx->batch_io) {
+        flush_tx(ctx);
+    }
+
+    cyxwiz_error_t err = ctx->transport->ops->send(ctx->transport, peer_id, data, len);
+    return (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+}
+
+/*
+ * Multipath: while a peer is between paths, the one we would pick may
+ * be the one going away (the punch fails, or the address it was punched
+ * from is gone). Small datagrams then carry a sequence number
+ *
+ *   type(1) seq(4)  frame
+ *
+ * and go out on the relay and the direct address; the receiver keeps
+ * the first copy. A direct datagram from the peer ends the transition
+ * (upgrade_to_direct, or the punch completing a connect), and with it
+ * the duplication.
+ */
+static int multipath_wanted(cyxchat_conn_ctx_t *ctx, const cyxchat_peer_conn_t *peer,
+                            size_t len)
+{
+    if (!ctx->multipath || !ctx->relay || len > CYXCHAT_CONN_MULTIPATH_MAX) return 0;
+    if (peer->relay_forced) return 0;
+    if (peer->state != CYXCHAT_CONN_CONNECTING && !peer->repunching) return 0;
+    return cyxchat_relay_is_connected(ctx->relay, &peer->peer_id);
+}
+
+static cyxchat_error_t send_multipath(cyxchat_conn_ctx_t *ctx, cyxchat_peer_conn_t *peer,
+                                      const uint8_t *data, size_t len)
+{
+    uint8_t frame[CYXCHAT_CONN_MULTIPATH_HEADER + CYXCHAT_CONN_MULTIPATH_MAX];
+    uint32_t seq = ++peer->mp_tx_seq;
+
+    frame[0] = CYXCHAT_MSG_CONN_MULTIPATH;
+    for (int i = 0; i < 4; i++) {
+        frame[1 + i] = (uint8_t)(seq >> (8 * i));
+    }
+    memcpy(frame + CYXCHAT_CONN_MULTIPATH_HEADER, data, len);
+    len += CYXCHAT_CONN_MULTIPATH_HEADER;
+
+    cyxchat_error_t relayed = cyxchat_relay_send(ctx->relay, &peer->peer_id, frame, len);
+    cyxchat_error_t direct = send_direct(ctx, &peer->peer_id, frame, len);
+
+    ctx->io_stats.multipath_sent++;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_MULTIPATH_SENT, 1);
+
+    /* One path getting it out is enough */
+    return relayed == CYXCHAT_OK ? CYXCHAT_OK : direct;
+}
+
+static void rx_multipath(void *user_data, const cyxwiz_node_id_t *from,
+                         const uint8_t *data, size_t len, int via_relay)
+{
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    if (len <= CYXCHAT_CONN_MULTIPATH_HEADER) return;
+
+    uint32_t seq = (uint32_t)data[1] | ((uint32_t)data[2] << 8) |
+                   ((uint32_t)data[3] << 16) | ((uint32_t)data[4] << 24);
+
+    /*
+     * The window only has to span the skew between the two paths; a
+     * number far behind it means the peer forgot us and started over.
+     * Peers we have no entry for get both copies; the chat layer dedups.
+     */
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, from);
+    if (peer && cyxchat_dedup_seq_check(&peer->mp_rx, seq)) {
+        ctx->io_stats.multipath_dup++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_MULTIPATH_DUP, 1);
+        return;
+    }
+
+    /* The frame inside goes where it would have gone unwrapped */
+    data += CYXCHAT_CONN_MULTIPATH_HEADER;
+    len -= CYXCHAT_CONN_MULTIPATH_HEADER;
+
+    const cyxchat_dispatch_entry_t *h = &ctx->rx_table.entries[data[0]];
+    if ((h->flags & CYXCHAT_DISPATCH_LINK) || data[0] == CYXCHAT_MSG_CONN_MULTIPATH) {
+        return;
+    }
+    if (h->fn) {
+        h->fn(h->user_data, from, data, len, via_relay);
+        return;
+    }
+
+    if (ctx->on_data) {
+        ctx->on_data(ctx, from, data, len, ctx->data_user_data);
+    }
+}
+
+cyxchat_error_t cyxchat_conn_send(cyxchat_conn_ctx_t *ctx,
+                                   const cyxwiz_node_id_t *peer_id,
+                                   const uint8_t *data,
+                                   size_t len)
+{
+    if (!ctx || !peer_id || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
+    if (!peer) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    cyxchat_error_t result;
+
+    if (multipath_wanted(ctx, peer, len)) {
+        /* Between paths: both, receiver keeps the first */
+        result = send_multipath(ctx, peer, data, len);
+    } else if (peer->is_relayed && ctx->relay) {
+        /* Send via relay */
+        result = cyxchat_relay_send(ctx->relay, peer_id, data, len);
+    } else {
+        /* Send directly via transport */
+        result = send_direct(ctx, peer_id, data, len);
+    }
+
+    if (result == CYXCHAT_OK) {
+        peer->last_activity = get_time_ms();
+        cyxchat_linkstats_on_send(&peer->stats, len, peer->last_activity);
+    }
+
+    return result;
+}
+
+/* ============================================================
+ * Network Status
+ * ============================================================ */
+
+void cyxchat_conn_get_status(cyxchat_conn_ctx_t *ctx, cyxchat_network_status_t *status_out)
+{
+    if (!ctx || !status_out) return;
+
+    status_out->public_ip = ctx->public_ip;
+    status_out->public_port = ctx->public_port;
+    status_out->nat_type = ctx->nat_type;
+    status_out->stun_complete = ctx->stun_complete;
+    status_out->bootstrap_connected = ctx->bootstrap_connected;
+
+    /* Count active and relay connections */
+    status_out->active_connections = 0;
+    status_out->relay_connections = 0;
+    status_out->repunching = 0;
+    status_out->network_changes = ctx->network_changes;
+
+    for (size_t n = 0; n < ctx->peers.used; n++) {
+        cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+        if (peer->active) {
+            if (peer->state == CYXCHAT_CONN_CONNECTED ||
+                peer->state == CYXCHAT_CONN_RELAYING) {
+                status_out->active_connections++;
+                if (peer->is_relayed) {
+                    status_out->relay_connections++;
+                }
+                if (peer->repunching) {
+                    status_out->repunching++;
                 }
             }
+        }
+    }
+
+    /* DHT status */
+    status_out->dht_enabled = (ctx->dht != NULL);
+    status_out->dht_nodes = 0;
+    status_out->dht_active_buckets = 0;
+
+    if (ctx->dht) {
+        cyxwiz_dht_stats_t stats;
+        cyxwiz_dht_get_stats(ctx->dht, &stats);
+        status_out->dht_nodes = stats.total_nodes;
+        status_out->dht_active_buckets = stats.active_buckets;
+    }
+}
+
+cyxchat_error_t cyxchat_conn_get_public_addr(cyxchat_conn_ctx_t *ctx,
+                                              char *buf, size_t buf_size)
+{
+    if (!ctx || !buf || buf_size < 22) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    if (!ctx->stun_complete || ctx->public_ip == 0) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    struct in_addr addr;
+    addr.s_addr = ctx->public_ip;
+
+    snprintf(buf, buf_size, "%s:%u",
+             inet_ntoa(addr),
+             ntohs(ctx->public_port));
+
+    return CYXCHAT_OK;
+}
+
+const char* cyxchat_conn_nat_type_name(cyxwiz_nat_type_t nat_type)
+{
+    switch (nat_type) {
+        case CYXWIZ_NAT_UNKNOWN:   return "Unknown";
+        case CYXWIZ_NAT_OPEN:      return "Open/Public";
+        case CYXWIZ_NAT_CONE:      return "Cone NAT";
+        case CYXWIZ_NAT_SYMMETRIC: return "Symmetric NAT";
+        case CYXWIZ_NAT_BLOCKED:   return "Blocked";
+        default:                   return "Unknown";
+    }
+}
+
+const char* cyxchat_conn_state_name(cyxchat_conn_state_t state)
+{
+    switch (state) {
+        case CYXCHAT_CONN_DISCONNECTED: return "Disconnected";
+        case CYXCHAT_CONN_DISCOVERING:  return "Discovering";
+        case CYXCHAT_CONN_CONNECTING:   return "Connecting";
+        case CYXCHAT_CONN_RELAYING:     return "Relaying";
+        case CYXCHAT_CONN_CONNECTED:    return "Connected";
+        default:                        return "Unknown";
+    }
+}
+
+/* ============================================================
+ * Callbacks
+ * ============================================================ */
+
+void cyxchat_conn_set_on_state_change(cyxchat_conn_ctx_t *ctx,
+                                       cyxchat_conn_state_callback_t callback,
+                                       void *user_data)
+{
+    if (!ctx) return;
+    ctx->on_state_change = callback;
+    ctx->state_change_user_data = user_data;
+}
+
+void cyxchat_conn_set_on_data(cyxchat_conn_ctx_t *ctx,
+                               cyxchat_conn_data_callback_t callback,
+                               void *user_data)
+{
+    if (!ctx) return;
+    ctx->on_data = callback;
+    ctx->data_user_data = user_data;
+}
+
+cyxchat_error_t cyxchat_conn_register_handler(cyxchat_conn_ctx_t *ctx,
+                                              uint8_t first, uint8_t last,
+                                              cyxchat_dispatch_fn handler,
+                                              void *user_data)
+{
+    if (!ctx || !handler) {
+        return CYXCHAT_ERR_NULL;
+    }
+    return cyxchat_dispatch_register(&ctx->rx_table, first, last, 0, handler, user_data);
+}
+
+void cyxchat_conn_unregister_handler(cyxchat_conn_ctx_t *ctx, uint8_t first, uint8_t last)
+{
+    if (!ctx) return;
+
+    /* Only what was registered through here: our own ranges stay */
+    for (unsigned t = first; t <= last; t++) {
+        cyxchat_dispatch_fn fn = ctx->rx_table.entries[t].fn;
+        if (fn != rx_relay && fn != rx_onion && fn != rx_discovery &&
+            fn != rx_conn_control && fn != rx_label && fn != rx_multipath) {
+            cyxchat_dispatch_unregister(&ctx->rx_table, (uint8_t)t, (uint8_t)t);
+        }
+    }
+}
+
+void cyxchat_conn_set_on_network_change(cyxchat_conn_ctx_t *ctx,
+                                         cyxchat_conn_network_callback_t callback,
+                                         void *user_data)
+{
+    if (!ctx) return;
+    ctx->on_network_change = callback;
+    ctx->network_change_user_data = user_data;
+}
+
+/* ============================================================
+ * Network Change Detection
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_conn_set_stun_server(cyxchat_conn_ctx_t *ctx, const char *stun_server)
+{
+    if (!ctx || !stun_server) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (!ctx->netmon) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+    return cyxchat_netmon_set_server(ctx->netmon, stun_server);
+}
+
+cyxchat_error_t cyxchat_conn_refresh_network(cyxchat_conn_ctx_t *ctx)
+{
+    if (!ctx) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (!ctx->netmon) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+    return cyxchat_netmon_refresh(ctx->netmon);
+}
 
-            free_pending(ctx, pending);
-            events++;
-        }
+/* ============================================================
+ * Relay Management
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_conn_add_relay(cyxchat_conn_ctx_t *ctx, const char *relay_addr)
+{
+    if (!ctx || !relay_addr) {
+        return CYXCHAT_ERR_NULL;
     }
 
-    /* Check for peer timeouts */
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        cyxchat_peer_conn_t *peer = &ctx->peers[i];
-        if (!peer->active) continue;
+    if (!ctx->relay) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_error_t err = cyxchat_relay_add_server(ctx->relay, relay_addr);
+    if (err != CYXCHAT_OK) {
+        return err;
+    }
 
-        if (peer->state == CYXCHAT_CONN_CONNECTED || peer->state == CYXCHAT_CONN_RELAYING) {
-            uint64_t elapsed = now_ms - peer->last_activity;
+    /* Advertised to peers as a relay candidate */
+    struct sockaddr_in sa;
+    if (ctx->relay_cand_count < CYXCHAT_MAX_RELAY_SERVERS &&
+        parse_addr(relay_addr, &sa) == CYXCHAT_OK) {
+        cyxchat_ice_candidate_t *cand = &ctx->relay_cands[ctx->relay_cand_count++];
+        cand->type = CYXCHAT_ICE_RELAY;
+        cand->ip = sa.sin_addr.s_addr;
+        cand->port = sa.sin_port;
+    }
 
-            if (elapsed >= CYXCHAT_CONNECTION_TIMEOUT_MS) {
-                /* Peer timed out */
-                set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
-                events++;
-            }
+    return CYXCHAT_OK;
+}
+
+void cyxchat_conn_set_relay_stagger(cyxchat_conn_ctx_t *ctx, uint32_t stagger_ms)
+{
+    if (!ctx) return;
+    ctx->relay_stagger_ms = stagger_ms;
+}
+
+size_t cyxchat_conn_relay_count(cyxchat_conn_ctx_t *ctx)
+{
+    if (!ctx) return 0;
+
+    size_t count = 0;
+    for (size_t n = 0; n < ctx->peers.used; n++) {
+        cyxchat_peer_conn_t *peer = peer_conn_at(ctx, n);
+        if (peer->active && peer->is_relayed) {
+            count++;
         }
     }
+    return count;
+}
 
-    ctx->last_poll_time = now_ms;
-    return events;
+cyxchat_error_t cyxchat_conn_set_max_peers(cyxchat_conn_ctx_t *ctx, size_t max_peers)
+{
+    if (!ctx) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    if (max_peers > 0 && (max_peers < ctx->peers.count || max_peers > UINT32_MAX - 1)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    ctx->peers.max_entries = max_peers;
+    ctx->pending.max_entries = max_peers;
+    return CYXCHAT_OK;
 }
 
-/* ============================================================
- * Connection Management
- * ============================================================ */
+size_t cyxchat_conn_peer_count(cyxchat_conn_ctx_t *ctx)
+{
+    return ctx ? ctx->peer_count : 0;
+}
 
-cyxchat_error_t cyxchat_conn_connect(cyxchat_conn_ctx_t *ctx,
-                                      const cyxwiz_node_id_t *peer_id,
-                                      cyxchat_conn_complete_callback_t callback,
-                                      void *user_data)
+cyxchat_error_t cyxchat_conn_force_relay(cyxchat_conn_ctx_t *ctx,
+                                          const cyxwiz_node_id_t *peer_id)
 {
     if (!ctx || !peer_id) {
         return CYXCHAT_ERR_NULL;
     }
 
-    /* Check if already connected */
     cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (peer && (peer->state == CYXCHAT_CONN_CONNECTED || peer->state == CYXCHAT_CONN_RELAYING)) {
-        if (callback) {
-            callback(ctx, peer_id, peer->state, CYXCHAT_OK, user_data);
+    if (!peer) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    /* Force relay connection */
+    if (ctx->relay) {
+        cyxchat_error_t err = cyxchat_relay_connect(ctx->relay, peer_id);
+        if (err == CYXCHAT_OK) {
+            set_peer_state(ctx, peer, CYXCHAT_CONN_RELAYING);
+            peer->is_relayed = 1;
+            peer->relay_forced = 1;
+            return CYXCHAT_OK;
         }
-        return CYXCHAT_OK;
+        return err;
     }
 
-    /* Check if already connecting */
-    if (find_pending(ctx, peer_id)) {
-        return CYXCHAT_ERR_EXISTS;
+    return CYXCHAT_ERR_NETWORK;
+}
+
+/* ============================================================
+ * Label-Switched Paths
+ * ============================================================ */
+
+#define CONN_LABEL_MAX_PACKET   CONN_BATCH_DEFAULT_MTU  /* Largest labelled datagram */
+
+static void on_label_sweep(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Labels are only exchanged with peers that are up */
+static cyxchat_peer_conn_t* label_neighbour(cyxchat_conn_ctx_t *ctx,
+                                            const cyxwiz_node_id_t *id)
+{
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, id);
+    if (!peer || (peer->state != CYXCHAT_CONN_CONNECTED &&
+                  peer->state != CYXCHAT_CONN_RELAYING)) {
+        return NULL;
     }
+    return peer;
+}
 
-    /* Allocate peer connection if needed */
-    if (!peer) {
-        peer = alloc_peer_conn(ctx);
-        if (!peer) {
-            return CYXCHAT_ERR_FULL;
+static int same_node(const cyxwiz_node_id_t *a, const cyxwiz_node_id_t *b)
+{
+    return memcmp(a, b, sizeof(cyxwiz_node_id_t)) == 0;
+}
+
+static cyxchat_error_t send_label_control(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                                          const uint8_t *msg, size_t len)
+{
+    cyxchat_peer_conn_t *peer = label_neighbour(ctx, to);
+    if (!peer || len == 0) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+    return send_control(ctx, peer, msg, len, 0);
+}
+
+/* Answer a request: our label, key half and confirmation, or label 0 to refuse */
+static void send_mapping(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                         const cyxchat_label_mapping_t *map)
+{
+    uint8_t msg[CYXCHAT_LABEL_MAPPING_SIZE];
+    send_label_control(ctx, to, msg, cyxchat_label_encode_mapping(map, msg, sizeof(msg)));
+}
+
+static void send_refusal(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *to, uint32_t req_id)
+{
+    cyxchat_label_mapping_t map;
+    memset(&map, 0, sizeof(map));
+    map.req_id = req_id;
+    send_mapping(ctx, to, &map);
+}
+
+/* Release (downstream) or withdraw (upstream) one label */
+static void send_notice(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                        uint8_t type, uint16_t label)
+{
+    uint8_t msg[CYXCHAT_LABEL_NOTICE_SIZE];
+    msg[0] = type;
+    msg[1] = (uint8_t)(label & 0xFF);
+    msg[2] = (uint8_t)(label >> 8);
+    send_label_control(ctx, to, msg, sizeof(msg));
+}
+
+/* Ask a neighbour for a label keyed with the ingress's key half */
+static cyxchat_error_t send_label_request(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                                          uint32_t req_id, const uint8_t *eph_public)
+{
+    cyxchat_label_request_t req;
+    uint8_t msg[CYXCHAT_LABEL_REQUEST_SIZE];
+
+    req.req_id = req_id;
+    memcpy(req.eph_public, eph_public, CYXCHAT_LABEL_KEY_SIZE);
+    return send_label_control(ctx, to, msg, cyxchat_label_encode_request(&req, msg, sizeof(msg)));
+}
+
+/* One wake-up per interval checks every label while any is in use */
+static void arm_label_sweep(cyxchat_conn_ctx_t *ctx)
+{
+    if (cyxchat_timer_pending(&ctx->label_timer)) return;
+
+    cyxchat_timer_schedule(ctx->timers, &ctx->label_timer,
+                           cyxchat_timer_now(ctx->timers) + CYXCHAT_LABEL_SWEEP_MS,
+                           on_label_sweep, ctx);
+}
+
+/*
+ * Take a label out of service, telling the neighbours that still use
+ * it: a release goes downstream, a withdraw goes upstream. Ingress
+ * labels are freed and reported; the others expire first so packets
+ * already in flight drop quietly.
+ */
+static void label_teardown(cyxchat_conn_ctx_t *ctx, cyxchat_label_entry_t *e,
+                           int notify_down, int notify_up,
+                           cyxchat_error_t result, uint64_t now)
+{
+    if (notify_down && e->role != CYXCHAT_LABEL_EGRESS && e->label_out != 0) {
+        send_notice(ctx, &e->next_hop, CYXCHAT_MSG_LABEL_RELEASE, e->label_out);
+    }
+
+    if (e->role == CYXCHAT_LABEL_INGRESS) {
+        cyxchat_label_path_callback_t callback = e->callback;
+        void *user_data = e->user_data;
+        uint16_t handle = e->label_in;
+
+        cyxchat_label_free(ctx->labels, e, now);
+        if (callback) {
+            callback(handle, result, user_data);
         }
-        peer->peer_id = *peer_id;
+        return;
     }
 
-    /* Create pending connection request */
-    cyxchat_pending_conn_t *pending = alloc_pending(ctx);
-    if (!pending) {
-        return CYXCHAT_ERR_FULL;
+    /* Every hop mapped its label when asked, so upstream always holds it */
+    if (notify_up) {
+        send_notice(ctx, &e->prev_hop, CYXCHAT_MSG_LABEL_WITHDRAW, e->label_in);
     }
 
-    pending->peer_id = *peer_id;
-    pending->callback = callback;
-    pending->user_data = user_data;
-    pending->start_time = get_time_ms();
-    pending->punch_attempts = 0;
+    e->state = CYXCHAT_LABEL_EXPIRING;
+    e->deadline = now + CYXCHAT_LABEL_GRACE_MS;
+}
 
-    /* Set state to connecting */
-    set_peer_state(ctx, peer, CYXCHAT_CONN_CONNECTING);
+/* A neighbour went down: every path through it is broken */
+static void labels_peer_down(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+{
+    if (cyxchat_label_count(ctx->labels) == 0) return;
 
-    /* The transport layer's discovery and hole punching handles the rest */
-    /* When we receive data from this peer, we know hole punch succeeded */
+    uint64_t now = get_time_ms();
+    size_t capacity = cyxchat_label_capacity(ctx->labels);
+    for (size_t i = 0; i < capacity; i++) {
+        cyxchat_label_entry_t *e = cyxchat_label_at(ctx->labels, i);
+        if (e->state != CYXCHAT_LABEL_RESERVED && e->state != CYXCHAT_LABEL_ACTIVE) {
+            continue;
+        }
 
-    return CYXCHAT_OK;
+        if (e->role != CYXCHAT_LABEL_INGRESS && same_node(&e->prev_hop, peer_id)) {
+            label_teardown(ctx, e, 1, 0, CYXCHAT_ERR_NETWORK, now);
+        } else if (e->role != CYXCHAT_LABEL_EGRESS && same_node(&e->next_hop, peer_id)) {
+            label_teardown(ctx, e, 0, 1, CYXCHAT_ERR_NETWORK, now);
+        }
+    }
 }
 
-cyxchat_error_t cyxchat_conn_disconnect(cyxchat_conn_ctx_t *ctx,
-                                         const cyxwiz_node_id_t *peer_id)
+static void on_label_sweep(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
 {
-    if (!ctx || !peer_id) {
-        return CYXCHAT_ERR_NULL;
+    (void)timer;
+    (void)now_ms;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+
+    /* Entries are stamped with the monotonic clock, not the wheel's */
+    uint64_t now = get_time_ms();
+    size_t capacity = cyxchat_label_capacity(ctx->labels);
+    for (size_t i = 0; i < capacity; i++) {
+        cyxchat_label_entry_t *e = cyxchat_label_at(ctx->labels, i);
+        switch (e->state) {
+            case CYXCHAT_LABEL_RESERVED:
+                if (now >= e->deadline) {
+                    label_teardown(ctx, e, 1, 1, CYXCHAT_ERR_TIMEOUT, now);
+                }
+                break;
+            case CYXCHAT_LABEL_ACTIVE:
+                if (now - e->last_used >= CYXCHAT_LABEL_IDLE_MS) {
+                    label_teardown(ctx, e, 1, 1, CYXCHAT_ERR_TIMEOUT, now);
+                }
+                break;
+            case CYXCHAT_LABEL_EXPIRING:
+                if (now >= e->deadline) {
+                    cyxchat_label_free(ctx->labels, e, now);
+                }
+                break;
+            default:
+                break;
+        }
     }
 
-    /* Cancel any pending connection */
-    cyxchat_pending_conn_t *pending = find_pending(ctx, peer_id);
-    if (pending) {
-        free_pending(ctx, pending);
+    /* Nothing left to watch: the next label re-arms */
+    if (cyxchat_label_count(ctx->labels) > 0) {
+        arm_label_sweep(ctx);
     }
+}
 
-    /* Disconnect peer */
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (peer) {
-        if (peer->is_relayed && ctx->relay) {
-            cyxchat_relay_disconnect(ctx->relay, peer_id);
+/* Entry a neighbour knows by `label`; setup and withdraws are rare, so a scan */
+static cyxchat_label_entry_t* label_by_out(cyxchat_conn_ctx_t *ctx,
+                                           const cyxwiz_node_id_t *next_hop, uint16_t label)
+{
+    if (label == 0) return NULL;
+
+    size_t capacity = cyxchat_label_capacity(ctx->labels);
+    for (size_t i = 0; i < capacity; i++) {
+        cyxchat_label_entry_t *e = cyxchat_label_at(ctx->labels, i);
+        if ((e->state == CYXCHAT_LABEL_RESERVED || e->state == CYXCHAT_LABEL_ACTIVE) &&
+            e->role != CYXCHAT_LABEL_EGRESS && e->label_out == label &&
+            same_node(&e->next_hop, next_hop)) {
+            return e;
         }
-        set_peer_state(ctx, peer, CYXCHAT_CONN_DISCONNECTED);
-        return CYXCHAT_OK;
     }
+    return NULL;
+}
 
-    return CYXCHAT_ERR_NOT_FOUND;
+/* Wrap in our layer and pass toward the ingress */
+static cyxchat_error_t label_send_back(cyxchat_conn_ctx_t *ctx, cyxchat_label_entry_t *e,
+                                       const uint8_t *inner, size_t len)
+{
+    uint8_t pkt[CONN_LABEL_MAX_PACKET];
+    size_t pkt_len = cyxchat_label_seal_back(e, inner, len, pkt, sizeof(pkt));
+    if (pkt_len == 0) {
+        return CYXCHAT_ERR_INVALID;
+    }
+    return cyxchat_conn_send(ctx, &e->prev_hop, pkt, pkt_len);
 }
 
-cyxchat_conn_state_t cyxchat_conn_get_state(cyxchat_conn_ctx_t *ctx,
-                                             const cyxwiz_node_id_t *peer_id)
+/* Ask the end of our path to add route[hop_count] */
+static void label_extend(cyxchat_conn_ctx_t *ctx, cyxchat_label_entry_t *e, uint64_t now)
 {
-    if (!ctx || !peer_id) {
-        return CYXCHAT_CONN_DISCONNECTED;
+    cyxchat_label_circuit_t *c = e->circuit;
+    cyxchat_label_extend_t ext;
+    uint8_t body[CYXCHAT_LABEL_EXTEND_SIZE];
+    uint8_t pkt[CONN_LABEL_MAX_PACKET];
+
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&e->down_req, sizeof(e->down_req));
+    ext.next_hop = c->route[c->hop_count];
+    ext.req_id = e->down_req;
+    cyxchat_label_keypair(ext.eph_public, c->eph_secret);
+    cyxchat_label_encode_extend(&ext, body, sizeof(body));
+
+    e->deadline = now + CYXCHAT_LABEL_SETUP_MS;
+    size_t len = cyxchat_label_seal(e, body[0], body + 1, sizeof(body) - 1, pkt, sizeof(pkt));
+    if (len == 0 || cyxchat_conn_send(ctx, &e->next_hop, pkt, len) != CYXCHAT_OK) {
+        label_teardown(ctx, e, 1, 0, CYXCHAT_ERR_NETWORK, now);
     }
+}
 
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (peer) {
-        return peer->state;
+/* A hop answered our handshake: check it is who we asked, then go on */
+static void label_add_hop(cyxchat_conn_ctx_t *ctx, cyxchat_label_entry_t *e,
+                          const cyxchat_label_mapping_t *map, uint64_t now)
+{
+    cyxchat_label_circuit_t *c = e->circuit;
+    uint8_t hop = c->hop_count;
+
+    cyxchat_error_t err = cyxchat_label_complete(c->keys[hop], c->eph_secret, &c->route[hop],
+                                                 map->eph_public, map->auth, e->down_req);
+    cyxwiz_secure_zero(c->eph_secret, sizeof(c->eph_secret));
+    if (err != CYXCHAT_OK) {
+        label_teardown(ctx, e, 1, 0, CYXCHAT_ERR_CRYPTO, now);
+        return;
     }
 
-    return CYXCHAT_CONN_DISCONNECTED;
+    /* Random start, so hops cannot line their layers up by sequence number */
+    uint16_t start;
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&start, sizeof(start));
+    c->send_seq[hop] = start;
+    c->hop_count++;
+
+    if (c->hop_count < c->route_len) {
+        label_extend(ctx, e, now);
+        return;
+    }
+
+    e->state = CYXCHAT_LABEL_ACTIVE;
+    e->last_used = now;
+    if (e->callback) {
+        e->callback(e->label_in, CYXCHAT_OK, e->user_data);
+    }
 }
 
-cyxchat_error_t cyxchat_conn_get_info(cyxchat_conn_ctx_t *ctx,
-                                       const cyxwiz_node_id_t *peer_id,
-                                       cyxchat_conn_info_t *info_out)
+/* The ingress wants the path to go on past us: ask next_hop on its behalf */
+static void label_on_extend(cyxchat_conn_ctx_t *ctx, cyxchat_label_entry_t *e,
+                            const uint8_t *inner, size_t len, uint64_t now)
 {
-    if (!ctx || !peer_id || !info_out) {
-        return CYXCHAT_ERR_NULL;
+    cyxchat_label_extend_t ext;
+    if (cyxchat_label_decode_extend(inner, len, &ext) != CYXCHAT_OK) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DROP, 1);
+        return;
     }
 
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (!peer) {
-        return CYXCHAT_ERR_NOT_FOUND;
+    if (!label_neighbour(ctx, &ext.next_hop) || same_node(&ext.next_hop, &e->prev_hop)) {
+        label_teardown(ctx, e, 0, 1, CYXCHAT_ERR_NOT_FOUND, now);
+        return;
     }
 
-    info_out->peer_id = peer->peer_id;
-    info_out->state = peer->state;
-    info_out->connected_at = peer->connected_at;
-    info_out->last_activity = peer->last_activity;
-    info_out->bytes_sent = peer->bytes_sent;
-    info_out->bytes_received = peer->bytes_received;
-    info_out->rssi = peer->rssi;
-    info_out->is_relayed = peer->is_relayed;
+    /* Transit from here on, once next_hop maps */
+    e->role = CYXCHAT_LABEL_TRANSIT;
+    e->state = CYXCHAT_LABEL_RESERVED;
+    e->next_hop = ext.next_hop;
+    e->down_req = ext.req_id;
+    e->deadline = now + CYXCHAT_LABEL_SETUP_MS;
+    if (send_label_request(ctx, &e->next_hop, ext.req_id, ext.eph_public) != CYXCHAT_OK) {
+        label_teardown(ctx, e, 0, 1, CYXCHAT_ERR_NETWORK, now);
+    }
+}
 
-    return CYXCHAT_OK;
+/* Fast path: one lookup, one MAC check and one layer, then swap and send on */
+static void label_forward(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                          const uint8_t *data, size_t len, uint64_t now)
+{
+    uint8_t pkt[CONN_LABEL_MAX_PACKET];
+    if (len > sizeof(pkt)) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DROP, 1);
+        return;
+    }
+    memcpy(pkt, data, len);
+
+    cyxchat_label_entry_t *e;
+    if (cyxchat_label_open(ctx->labels, from, pkt, len, now, &e) != CYXCHAT_OK) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DROP, 1);
+        return;
+    }
+
+    if (e->role == CYXCHAT_LABEL_EGRESS) {
+        const uint8_t *inner = pkt + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE;
+        size_t inner_len = len - CYXCHAT_LABEL_HEADER_SIZE - CYXCHAT_LABEL_LAYER_SIZE;
+
+        if (inner[0] == CYXCHAT_LABEL_CMD_EXTEND) {
+            label_on_extend(ctx, e, inner, inner_len, now);
+        } else if (inner[0] == CYXCHAT_LABEL_CMD_DATA) {
+            CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DELIVERED, 1);
+            if (ctx->on_label_data) {
+                ctx->on_label_data(ctx, e->label_in, from, inner + 1, inner_len - 1,
+                                   ctx->label_data_user_data);
+            }
+        } else {
+            CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DROP, 1);
+        }
+        return;
+    }
+
+    len = cyxchat_label_swap(e, pkt, len);
+    if (cyxchat_conn_send(ctx, &e->next_hop, pkt, len) == CYXCHAT_OK) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_FWD, 1);
+    } else {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_LABEL_DROP, 1);
+    }
 }
 
-int cyxchat_conn_is_relayed(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id)
+/* Toward the ingress: add our layer, or peel them all if we are it */
+static void label_on_back(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                          const uint8_t *data, size_t len, uint64_t now)
 {
-    if (!ctx || !peer_id) return 0;
+    if (len < CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_LAYER_SIZE) return;
 
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    return peer ? peer->is_relayed : 0;
+    cyxchat_label_entry_t *e = label_by_out(ctx, from, (uint16_t)(data[1] | (data[2] << 8)));
+    if (!e) return;
+
+    if (e->role == CYXCHAT_LABEL_TRANSIT) {
+        if (e->state == CYXCHAT_LABEL_ACTIVE) {
+            label_send_back(ctx, e, data + CYXCHAT_LABEL_HEADER_SIZE,
+                            len - CYXCHAT_LABEL_HEADER_SIZE);
+        }
+        return;
+    }
+
+    /* Only a path being built expects an answer */
+    if (e->state != CYXCHAT_LABEL_RESERVED) return;
+
+    uint8_t pkt[CONN_LABEL_MAX_PACKET];
+    const uint8_t *inner;
+    size_t inner_len;
+    cyxchat_label_mapping_t map;
+    if (len > sizeof(pkt)) return;
+    memcpy(pkt, data, len);
+
+    if (cyxchat_label_open_back(e, pkt, len, &inner, &inner_len) != CYXCHAT_OK ||
+        cyxchat_label_decode_extended(inner, inner_len, &map) != CYXCHAT_OK ||
+        map.req_id != e->down_req) {
+        return;
+    }
+    label_add_hop(ctx, e, &map, now);
 }
 
-/* ============================================================
- * Data Transfer
- * ============================================================ */
+/* Upstream neighbour wants a label keyed with its ingress */
+static void label_on_request(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                             const uint8_t *data, size_t len, uint64_t now)
+{
+    cyxchat_label_request_t req;
+    if (cyxchat_label_decode_request(data, len, &req) != CYXCHAT_OK ||
+        !label_neighbour(ctx, from)) {
+        return;
+    }
 
-cyxchat_error_t cyxchat_conn_send(cyxchat_conn_ctx_t *ctx,
-                                   const cyxwiz_node_id_t *peer_id,
-                                   const uint8_t *data,
-                                   size_t len)
+    /* Without our static key we could not prove who answered */
+    cyxchat_label_entry_t *e = ctx->label_keyed ? cyxchat_label_alloc(ctx->labels, now) : NULL;
+    if (!e) {
+        send_refusal(ctx, from, req.req_id);
+        return;
+    }
+    arm_label_sweep(ctx);
+
+    cyxchat_label_mapping_t map;
+    map.req_id = req.req_id;
+    map.label = e->label_in;
+    if (cyxchat_label_accept(e->key_in, map.eph_public, map.auth, ctx->label_secret,
+                             &ctx->local_id, req.eph_public, req.req_id) != CYXCHAT_OK) {
+        cyxchat_label_free(ctx->labels, e, now);
+        send_refusal(ctx, from, req.req_id);
+        return;
+    }
+
+    /* End of the path until the ingress asks us to extend it */
+    e->role = CYXCHAT_LABEL_EGRESS;
+    e->state = CYXCHAT_LABEL_ACTIVE;
+    e->prev_hop = *from;
+    e->last_used = now;
+    send_mapping(ctx, from, &map);
+}
+
+/* Downstream neighbour answered a request: ours, or one we sent for the ingress */
+static void label_on_mapping(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                             const uint8_t *data, size_t len, uint64_t now)
 {
-    if (!ctx || !peer_id || !data) {
-        return CYXCHAT_ERR_NULL;
+    cyxchat_label_mapping_t map;
+    if (cyxchat_label_decode_mapping(data, len, &map) != CYXCHAT_OK) {
+        return;
     }
 
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (!peer) {
-        return CYXCHAT_ERR_NOT_FOUND;
+    /* Setup is rare next to data, so a scan beats a second index */
+    cyxchat_label_entry_t *e = NULL;
+    size_t capacity = cyxchat_label_capacity(ctx->labels);
+    for (size_t i = 0; i < capacity; i++) {
+        cyxchat_label_entry_t *c = cyxchat_label_at(ctx->labels, i);
+        if (c->state == CYXCHAT_LABEL_RESERVED && c->role != CYXCHAT_LABEL_EGRESS &&
+            c->label_out == 0 && c->down_req == map.req_id && same_node(&c->next_hop, from)) {
+            e = c;
+            break;
+        }
     }
 
-    cyxchat_error_t result;
+    /* Too late (timed out or released): let the neighbour free it */
+    if (!e) {
+        if (map.label != 0) {
+            send_notice(ctx, from, CYXCHAT_MSG_LABEL_RELEASE, map.label);
+        }
+        return;
+    }
 
-    if (peer->is_relayed && ctx->relay) {
-        /* Send via relay */
-        result = cyxchat_relay_send(ctx->relay, peer_id, data, len);
-    } else {
-        /* Send directly via transport */
-        cyxwiz_error_t err = ctx->transport->ops->send(ctx->transport, peer_id, data, len);
-        result = (err == CYXWIZ_OK) ? CYXCHAT_OK : CYXCHAT_ERR_NETWORK;
+    if (map.label == 0) {
+        label_teardown(ctx, e, 0, 1, CYXCHAT_ERR_NETWORK, now);
+        return;
     }
+    e->label_out = map.label;
 
-    if (result == CYXCHAT_OK) {
-        peer->bytes_sent += (uint32_t)len;
-        peer->last_activity = get_time_ms();
+    if (e->role == CYXCHAT_LABEL_INGRESS) {
+        label_add_hop(ctx, e, &map, now);
+        return;
     }
 
-    return result;
+    /* We extended the path: the ingress checks the new hop's answer, not us */
+    uint8_t inner[CYXCHAT_LABEL_EXTENDED_SIZE];
+    e->state = CYXCHAT_LABEL_ACTIVE;
+    e->last_used = now;
+    if (label_send_back(ctx, e, inner,
+                        cyxchat_label_encode_extended(&map, inner, sizeof(inner))) != CYXCHAT_OK) {
+        label_teardown(ctx, e, 1, 1, CYXCHAT_ERR_NETWORK, now);
+    }
 }
 
-/* ============================================================
- * Network Status
- * ============================================================ */
-
-void cyxchat_conn_get_status(cyxchat_conn_ctx_t *ctx, cyxchat_network_status_t *status_out)
+/* Upstream is done with our label, or downstream dropped its own */
+static void label_on_notice(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                            const uint8_t *data, size_t len, uint64_t now)
 {
-    if (!ctx || !status_out) return;
-
-    status_out->public_ip = ctx->public_ip;
-    status_out->public_port = ctx->public_port;
-    status_out->nat_type = ctx->nat_type;
-    status_out->stun_complete = ctx->stun_complete;
-    status_out->bootstrap_connected = ctx->bootstrap_connected;
+    if (len != CYXCHAT_LABEL_NOTICE_SIZE) return;
 
-    /* Count active and relay connections */
-    status_out->active_connections = 0;
-    status_out->relay_connections = 0;
+    uint16_t label = (uint16_t)(data[1] | (data[2] << 8));
 
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (ctx->peers[i].active) {
-            if (ctx->peers[i].state == CYXCHAT_CONN_CONNECTED ||
-                ctx->peers[i].state == CYXCHAT_CONN_RELAYING) {
-                status_out->active_connections++;
-                if (ctx->peers[i].is_relayed) {
-                    status_out->relay_connections++;
-                }
-            }
+    if (data[0] == CYXCHAT_MSG_LABEL_RELEASE) {
+        cyxchat_label_entry_t *e = cyxchat_label_lookup(ctx->labels, label);
+        if (e && e->role != CYXCHAT_LABEL_INGRESS && same_node(&e->prev_hop, from) &&
+            (e->state == CYXCHAT_LABEL_RESERVED || e->state == CYXCHAT_LABEL_ACTIVE)) {
+            label_teardown(ctx, e, 1, 0, CYXCHAT_OK, now);
         }
+        return;
     }
 
-    /* DHT status */
-    status_out->dht_enabled = (ctx->dht != NULL);
-    status_out->dht_nodes = 0;
-    status_out->dht_active_buckets = 0;
+    cyxchat_label_entry_t *e = label_by_out(ctx, from, label);
+    if (e) {
+        label_teardown(ctx, e, 0, 1, CYXCHAT_ERR_NETWORK, now);
+    }
+}
 
-    if (ctx->dht) {
-        cyxwiz_dht_stats_t stats;
-        cyxwiz_dht_get_stats(ctx->dht, &stats);
-        status_out->dht_nodes = stats.total_nodes;
-        status_out->dht_active_buckets = stats.active_buckets;
+static void rx_label(void *user_data, const cyxwiz_node_id_t *from,
+                     const uint8_t *data, size_t len, int via_relay)
+{
+    (void)via_relay;
+    cyxchat_conn_ctx_t *ctx = (cyxchat_conn_ctx_t*)user_data;
+    uint64_t now = get_time_ms();
+
+    switch (data[0]) {
+        case CYXCHAT_MSG_LABEL_DATA:
+            label_forward(ctx, from, data, len, now);
+            break;
+        case CYXCHAT_MSG_LABEL_REQUEST:
+            label_on_request(ctx, from, data, len, now);
+            break;
+        case CYXCHAT_MSG_LABEL_MAPPING:
+            label_on_mapping(ctx, from, data, len, now);
+            break;
+        case CYXCHAT_MSG_LABEL_BACK:
+            label_on_back(ctx, from, data, len, now);
+            break;
+        default:
+            label_on_notice(ctx, from, data, len, now);
+            break;
     }
 }
 
-cyxchat_error_t cyxchat_conn_get_public_addr(cyxchat_conn_ctx_t *ctx,
-                                              char *buf, size_t buf_size)
+cyxchat_error_t cyxchat_conn_label_path(cyxchat_conn_ctx_t *ctx,
+                                         const cyxwiz_node_id_t *hops,
+                                         size_t hop_count,
+                                         cyxchat_label_path_callback_t callback,
+                                         void *user_data,
+                                         uint16_t *handle_out)
 {
-    if (!ctx || !buf || buf_size < 22) {
+    if (!ctx || !hops) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (hop_count == 0 || hop_count > CYXCHAT_LABEL_MAX_HOPS) {
         return CYXCHAT_ERR_INVALID;
     }
+    if (!label_neighbour(ctx, &hops[0])) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
 
-    if (!ctx->stun_complete || ctx->public_ip == 0) {
-        return CYXCHAT_ERR_NETWORK;
+    uint64_t now = get_time_ms();
+    cyxchat_label_entry_t *e = cyxchat_label_alloc(ctx->labels, now);
+    if (!e) {
+        return CYXCHAT_ERR_FULL;
     }
 
-    struct in_addr addr;
-    addr.s_addr = ctx->public_ip;
+    cyxchat_label_circuit_t *c = cyxchat_label_circuit_alloc(ctx->labels, e);
+    if (!c) {
+        cyxchat_label_free(ctx->labels, e, now);
+        return CYXCHAT_ERR_FULL;
+    }
 
-    snprintf(buf, buf_size, "%s:%u",
-             inet_ntoa(addr),
-             ntohs(ctx->public_port));
+    e->role = CYXCHAT_LABEL_INGRESS;
+    e->next_hop = hops[0];
+    e->callback = callback;
+    e->user_data = user_data;
+    memcpy(c->route, hops, hop_count * sizeof(cyxwiz_node_id_t));
+    c->route_len = (uint8_t)hop_count;
 
-    return CYXCHAT_OK;
-}
+    /* First hop only; the rest are added through the path as it answers */
+    uint8_t eph_public[CYXCHAT_LABEL_KEY_SIZE];
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&e->down_req, sizeof(e->down_req));
+    cyxchat_label_keypair(eph_public, c->eph_secret);
 
-const char* cyxchat_conn_nat_type_name(cyxwiz_nat_type_t nat_type)
-{
-    switch (nat_type) {
-        case CYXWIZ_NAT_UNKNOWN:   return "Unknown";
-        case CYXWIZ_NAT_OPEN:      return "Open/Public";
-        case CYXWIZ_NAT_CONE:      return "Cone NAT";
-        case CYXWIZ_NAT_SYMMETRIC: return "Symmetric NAT";
-        case CYXWIZ_NAT_BLOCKED:   return "Blocked";
-        default:                   return "Unknown";
+    cyxchat_error_t err = send_label_request(ctx, &hops[0], e->down_req, eph_public);
+    if (err != CYXCHAT_OK) {
+        cyxchat_label_free(ctx->labels, e, now);
+        return err;
+    }
+
+    arm_label_sweep(ctx);
+    if (handle_out) {
+        *handle_out = e->label_in;
     }
+    return CYXCHAT_OK;
 }
 
-const char* cyxchat_conn_state_name(cyxchat_conn_state_t state)
+cyxchat_error_t cyxchat_conn_label_send(cyxchat_conn_ctx_t *ctx,
+                                         uint16_t handle,
+                                         const uint8_t *data,
+                                         size_t len)
 {
-    switch (state) {
-        case CYXCHAT_CONN_DISCONNECTED: return "Disconnected";
-        case CYXCHAT_CONN_DISCOVERING:  return "Discovering";
-        case CYXCHAT_CONN_CONNECTING:   return "Connecting";
-        case CYXCHAT_CONN_RELAYING:     return "Relaying";
-        case CYXCHAT_CONN_CONNECTED:    return "Connected";
-        default:                        return "Unknown";
+    if (!ctx || (!data && len > 0)) {
+        return CYXCHAT_ERR_NULL;
     }
-}
 
-/* ============================================================
- * Callbacks
- * ============================================================ */
+    cyxchat_label_entry_t *e = cyxchat_label_lookup(ctx->labels, handle);
+    if (!e || e->role != CYXCHAT_LABEL_INGRESS || e->state != CYXCHAT_LABEL_ACTIVE) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
 
-void cyxchat_conn_set_on_state_change(cyxchat_conn_ctx_t *ctx,
-                                       cyxchat_conn_state_callback_t callback,
-                                       void *user_data)
-{
-    if (!ctx) return;
-    ctx->on_state_change = callback;
-    ctx->state_change_user_data = user_data;
-}
+    uint8_t pkt[CONN_LABEL_MAX_PACKET];
+    size_t pkt_len = cyxchat_label_seal(e, CYXCHAT_LABEL_CMD_DATA, data, len, pkt, sizeof(pkt));
+    if (pkt_len == 0) {
+        return CYXCHAT_ERR_INVALID;
+    }
 
-void cyxchat_conn_set_on_data(cyxchat_conn_ctx_t *ctx,
-                               cyxchat_conn_data_callback_t callback,
-                               void *user_data)
-{
-    if (!ctx) return;
-    ctx->on_data = callback;
-    ctx->data_user_data = user_data;
+    e->last_used = get_time_ms();
+    return cyxchat_conn_send(ctx, &e->next_hop, pkt, pkt_len);
 }
 
-/* ============================================================
- * Relay Management
- * ============================================================ */
-
-cyxchat_error_t cyxchat_conn_add_relay(cyxchat_conn_ctx_t *ctx, const char *relay_addr)
+cyxchat_error_t cyxchat_conn_label_release(cyxchat_conn_ctx_t *ctx, uint16_t handle)
 {
-    if (!ctx || !relay_addr) {
+    if (!ctx) {
         return CYXCHAT_ERR_NULL;
     }
 
-    if (ctx->relay) {
-        return cyxchat_relay_add_server(ctx->relay, relay_addr);
+    cyxchat_label_entry_t *e = cyxchat_label_lookup(ctx->labels, handle);
+    if (!e || e->role != CYXCHAT_LABEL_INGRESS) {
+        return CYXCHAT_ERR_NOT_FOUND;
     }
 
-    return CYXCHAT_ERR_INVALID;
-}
-
-size_t cyxchat_conn_relay_count(cyxchat_conn_ctx_t *ctx)
-{
-    if (!ctx) return 0;
-
-    size_t count = 0;
-    for (size_t i = 0; i < CYXCHAT_MAX_PEER_CONNECTIONS; i++) {
-        if (ctx->peers[i].active && ctx->peers[i].is_relayed) {
-            count++;
-        }
+    /* A mapping still on its way is released when it arrives */
+    if (e->label_out != 0) {
+        send_notice(ctx, &e->next_hop, CYXCHAT_MSG_LABEL_RELEASE, e->label_out);
     }
-    return count;
+    cyxchat_label_free(ctx->labels, e, get_time_ms());
+    return CYXCHAT_OK;
 }
 
-cyxchat_error_t cyxchat_conn_force_relay(cyxchat_conn_ctx_t *ctx,
-                                          const cyxwiz_node_id_t *peer_id)
+cyxchat_error_t cyxchat_conn_set_signing_key(cyxchat_conn_ctx_t *ctx,
+                                            const uint8_t *signing_key)
 {
-    if (!ctx || !peer_id) {
+    if (!ctx || !signing_key) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, peer_id);
-    if (!peer) {
-        return CYXCHAT_ERR_NOT_FOUND;
-    }
+    cyxchat_error_t err = cyxchat_label_identity(ctx->label_secret, signing_key);
+    ctx->label_keyed = err == CYXCHAT_OK;
+    return err;
+}
 
-    /* Force relay connection */
-    if (ctx->relay) {
-        cyxchat_error_t err = cyxchat_relay_connect(ctx->relay, peer_id);
-        if (err == CYXCHAT_OK) {
-            set_peer_state(ctx, peer, CYXCHAT_CONN_RELAYING);
-            peer->is_relayed = 1;
-            return CYXCHAT_OK;
-        }
-        return err;
-    }
+void cyxchat_conn_set_on_label_data(cyxchat_conn_ctx_t *ctx,
+                                    cyxchat_conn_label_data_callback_t callback,
+                                    void *user_data)
+{
+    if (!ctx) return;
+    ctx->on_label_data = callback;
+    ctx->label_data_user_data = user_data;
+}
 
-    return CYXCHAT_ERR_NETWORK;
+size_t cyxchat_conn_label_count(cyxchat_conn_ctx_t *ctx)
+{
+    return ctx ? cyxchat_label_count(ctx->labels) : 0;
 }
 
 /* ============================================================
@@ -1334,35 +4003,6 @@ int cyxchat_conn_dht_is_ready(cyxchat_conn_ctx_t *ctx)
  * Manual Peer Addition
  * ============================================================ */
 
-/* Internal UDP punch packet type */
-#define CYXWIZ_UDP_PUNCH 0xF4
-
-/* Socket error code macro */
-#ifdef _WIN32
-#define CONN_SOCKET_ERROR WSAGetLastError()
-#else
-#define CONN_SOCKET_ERROR errno
-#endif
-
-/* UDP punch packet structure (matches udp.c - packed for network) */
-#ifdef _MSC_VER
-#pragma pack(push, 1)
-#endif
-typedef struct {
-    uint8_t type;
-    cyxwiz_node_id_t sender_id;
-    uint32_t punch_id;
-}
-#ifdef __GNUC__
-__attribute__((packed))
-#endif
-cyxchat_punch_packet_t;
-#ifdef _MSC_VER
-#pragma pack(pop)
-#endif
-
-/* Note: cyxchat_udp_state_view_t is defined earlier in this file */
-
 cyxchat_error_t cyxchat_conn_add_peer_addr(cyxchat_conn_ctx_t *ctx,
                                             const cyxwiz_node_id_t *node_id,
                                             const char *addr)
@@ -1375,92 +4015,42 @@ cyxchat_error_t cyxchat_conn_add_peer_addr(cyxchat_conn_ctx_t *ctx,
         return CYXCHAT_ERR_NETWORK;
     }
 
-    /* Parse IP:port string */
-    char ip_str[64];
-    int port = 0;
-
-    const char *colon = strchr(addr, ':');
-    if (!colon) {
-        CYXWIZ_WARN("Invalid address format (missing port): %s", addr);
-        return CYXCHAT_ERR_INVALID;
-    }
-
-    size_t ip_len = (size_t)(colon - addr);
-    if (ip_len >= sizeof(ip_str)) {
-        return CYXCHAT_ERR_INVALID;
-    }
-
-    memcpy(ip_str, addr, ip_len);
-    ip_str[ip_len] = '\0';
-    port = atoi(colon + 1);
-
-    if (port <= 0 || port > 65535) {
-        CYXWIZ_WARN("Invalid port: %d", port);
-        return CYXCHAT_ERR_INVALID;
-    }
-
-    /* Resolve IP address */
     struct sockaddr_in dest_addr;
-    memset(&dest_addr, 0, sizeof(dest_addr));
-    dest_addr.sin_family = AF_INET;
-    dest_addr.sin_port = htons((uint16_t)port);
-
-    if (inet_pton(AF_INET, ip_str, &dest_addr.sin_addr) != 1) {
-        /* Try resolving as hostname */
-        struct addrinfo hints, *result;
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = AF_INET;
-        hints.ai_socktype = SOCK_DGRAM;
-
-        if (getaddrinfo(ip_str, NULL, &hints, &result) != 0) {
-            CYXWIZ_WARN("Failed to resolve address: %s", ip_str);
-            return CYXCHAT_ERR_NETWORK;
-        }
-
-        struct sockaddr_in *sin = (struct sockaddr_in *)result->ai_addr;
-        dest_addr.sin_addr = sin->sin_addr;
-        freeaddrinfo(result);
+    cyxchat_error_t err = parse_addr(addr, &dest_addr);
+    if (err != CYXCHAT_OK) {
+        return err;
     }
 
     /* Add peer to peer table (ignore if already exists) */
     cyxwiz_peer_table_add(ctx->peer_table, node_id, CYXWIZ_TRANSPORT_UDP, 0);
 
-    /* Get the transport's socket from driver_data */
-    cyxchat_udp_state_view_t *udp_state =
-        (cyxchat_udp_state_view_t *)ctx->transport->driver_data;
-    if (!udp_state || !udp_state->initialized) {
-        return CYXCHAT_ERR_NETWORK;  /* Transport not initialized */
-    }
-
-#ifdef _WIN32
-    SOCKET sock = udp_state->socket_fd;
-    if (sock == INVALID_SOCKET) {
-        return CYXCHAT_ERR_NETWORK;
+    /* Every address given for a peer becomes one of its candidates */
+    cyxchat_peer_conn_t *peer = find_peer_conn(ctx, node_id);
+    if (!peer) {
+        peer = alloc_peer_conn(ctx, node_id);
+        if (peer) {
+            peer->state = CYXCHAT_CONN_DISCONNECTED;
+        }
     }
-#else
-    int sock = udp_state->socket_fd;
-    if (sock < 0) {
-        return CYXCHAT_ERR_NETWORK;
+    if (peer) {
+        /* Origin unknown: rank below host candidates the peer advertises */
+        cyxchat_ice_candidate_t cand;
+        cand.type = CYXCHAT_ICE_SRFLX;
+        cand.ip = dest_addr.sin_addr.s_addr;
+        cand.port = dest_addr.sin_port;
+        if (cyxchat_ice_add(&peer->ice, &cand) >= 0) {
+            ice_candidates_changed(ctx, peer);
+        }
     }
-#endif
-
-    /* Build punch packet */
-    cyxchat_punch_packet_t punch;
-    memset(&punch, 0, sizeof(punch));
-    punch.type = CYXWIZ_UDP_PUNCH;
-    memcpy(&punch.sender_id, &ctx->local_id, sizeof(cyxwiz_node_id_t));
-    punch.punch_id = (uint32_t)(get_time_ms() & 0xFFFFFFFF);
 
     /* Send punch to peer */
-    int sent = sendto(sock, (const char *)&punch, sizeof(punch), 0,
-                      (struct sockaddr *)&dest_addr, sizeof(dest_addr));
-
-    if (sent < 0) {
-        CYXWIZ_WARN("Failed to send punch packet: %d", CONN_SOCKET_ERROR);
-        return CYXCHAT_ERR_NETWORK;
+    err = send_punch(ctx, dest_addr.sin_addr.s_addr, dest_addr.sin_port,
+                     (uint32_t)(get_time_ms() & 0xFFFFFFFF));
+    if (err != CYXCHAT_OK) {
+        return err;
     }
 
-    CYXWIZ_INFO("Sent punch to %s:%d for peer discovery", ip_str, port);
+    CYXWIZ_INFO("Sent punch to %s for peer discovery", addr);
 
     return CYXCHAT_OK;
 }
@@ -4,6 +4,7 @@
 
 #include <cyxchat/contact.h>
 #include <cyxchat/chat.h>
+#include <cyxchat/config.h>
 #include <cyxwiz/crypto.h>
 #include <cyxwiz/memory.h>
 #include <string.h>
@@ -15,31 +16,59 @@
  * ============================================================ */
 
 struct cyxchat_contact_list {
-    cyxchat_contact_t contacts[CYXCHAT_MAX_CONTACTS];
+    cyxchat_contact_t *contacts;        /* Carved after the struct */
+    size_t capacity;
     size_t count;
+    size_t footprint;
 };
 
+/* List and its contact table */
+static void* contact_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_contact_list_t *l = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_contact_list_t));
+    cyxchat_contact_t *contacts = cyxchat_arena_carve(arena, cfg->max_contacts,
+                                                      sizeof(cyxchat_contact_t));
+    if (l) {
+        l->contacts = contacts;
+        l->capacity = cfg->max_contacts;
+        l->footprint = arena->size;
+    }
+    return l;
+}
+
 /* ============================================================
  * Contact List Management
  * ============================================================ */
 
 cyxchat_error_t cyxchat_contact_list_create(cyxchat_contact_list_t **list) {
+    return cyxchat_contact_list_create_with_config(list, NULL);
+}
+
+cyxchat_error_t cyxchat_contact_list_create_with_config(
+    cyxchat_contact_list_t **list,
+    const cyxchat_config_t *config
+) {
     if (!list) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_contact_list_t *l = calloc(1, sizeof(cyxchat_contact_list_t));
-    if (!l) {
-        return CYXCHAT_ERR_MEMORY;
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
     }
 
-    *list = l;
+    *list = cyxchat_arena_build(contact_layout, config);
+    if (!*list) {
+        return CYXCHAT_ERR_MEMORY;
+    }
     return CYXCHAT_OK;
 }
 
 void cyxchat_contact_list_destroy(cyxchat_contact_list_t *list) {
     if (list) {
-        cyxwiz_secure_zero(list, sizeof(cyxchat_contact_list_t));
+        cyxwiz_secure_zero(list, list->footprint);
         free(list);
     }
 }
@@ -59,7 +88,7 @@ cyxchat_error_t cyxchat_contact_add(
         return CYXCHAT_ERR_EXISTS;
     }
 
-    if (list->count >= CYXCHAT_MAX_CONTACTS) {
+    if (list->count >= list->capacity) {
         return CYXCHAT_ERR_FULL;
     }
 
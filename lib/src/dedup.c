@@ -0,0 +1,274 @@
+/**
+ * CyxChat Duplicate Suppression Implementation
+ *
+ * Peers live in a small set-associative table: the node ID prefix picks
+ * a set of CYXCHAT_DEDUP_WAYS slots and the least recently used slot in
+ * the set is recycled on a miss, so lookup is O(1) with bounded memory.
+ *
+ * Each peer slot holds two bloom generations plus an exact ring of the
+ * last CYXCHAT_DEDUP_WINDOW IDs. New IDs go into the current generation;
+ * after CYXCHAT_DEDUP_GENERATION inserts the current generation becomes
+ * the previous one and a fresh one starts. Everything in either
+ * generation is still in the ring, so a bloom hit can be confirmed
+ * exactly and the common "not seen" case never scans.
+ */
+
+#include <cyxchat/dedup.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+#define DEDUP_BLOOM_WORDS   (CYXCHAT_DEDUP_BLOOM_BITS / 64)
+#define DEDUP_BLOOM_MASK    (CYXCHAT_DEDUP_BLOOM_BITS - 1)
+#define DEDUP_SETS          (CYXCHAT_DEDUP_MAX_PEERS / CYXCHAT_DEDUP_WAYS)
+
+typedef struct {
+    cyxwiz_node_id_t peer_id;
+    uint64_t last_used;                 /* LRU tick */
+    uint64_t bloom[2][DEDUP_BLOOM_WORDS];
+    uint64_t window[CYXCHAT_DEDUP_WINDOW];
+    uint8_t current;                    /* Active bloom generation */
+    uint8_t gen_count;                  /* Inserts into current generation */
+    uint8_t window_pos;                 /* Next ring write position */
+    uint8_t window_count;               /* Valid ring entries */
+    int active;
+} cyxchat_dedup_peer_t;
+
+struct cyxchat_dedup_ctx {
+    cyxchat_dedup_peer_t peers[CYXCHAT_DEDUP_MAX_PEERS];
+    uint64_t tick;
+    cyxchat_dedup_stats_t stats;
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static uint64_t load_u64(const uint8_t *p)
+{
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+/* splitmix64 finalizer - IDs are chosen by the sender, so mix them */
+static uint64_t mix_key(uint64_t k)
+{
+    k ^= k >> 30;
+    k *= 0xBF58476D1CE4E5B9ULL;
+    k ^= k >> 27;
+    k *= 0x94D049BB133111EBULL;
+    k ^= k >> 31;
+    return k;
+}
+
+static uint64_t make_key(const cyxchat_msg_id_t *msg_id, uint8_t sub_id)
+{
+    return mix_key(load_u64(msg_id->bytes) ^
+                   ((uint64_t)sub_id * 0x9E3779B97F4A7C15ULL));
+}
+
+static int bloom_test(const uint64_t *bloom, uint64_t key)
+{
+    for (int i = 0; i < 3; i++) {
+        uint32_t bit = (uint32_t)(key >> (i * 16)) & DEDUP_BLOOM_MASK;
+        if (!(bloom[bit >> 6] & (1ULL << (bit & 63)))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void bloom_set(uint64_t *bloom, uint64_t key)
+{
+    for (int i = 0; i < 3; i++) {
+        uint32_t bit = (uint32_t)(key >> (i * 16)) & DEDUP_BLOOM_MASK;
+        bloom[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+static int window_contains(const cyxchat_dedup_peer_t *peer, uint64_t key)
+{
+    for (uint8_t i = 0; i < peer->window_count; i++) {
+        if (peer->window[i] == key) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static cyxchat_dedup_peer_t* find_peer(
+    cyxchat_dedup_ctx_t *ctx,
+    const cyxwiz_node_id_t *peer_id,
+    int create
+) {
+    uint64_t prefix = load_u64(peer_id->bytes);
+    size_t set = (size_t)(prefix % DEDUP_SETS) * CYXCHAT_DEDUP_WAYS;
+    cyxchat_dedup_peer_t *victim = NULL;
+
+    for (size_t i = set; i < set + CYXCHAT_DEDUP_WAYS; i++) {
+        cyxchat_dedup_peer_t *p = &ctx->peers[i];
+        if (p->active &&
+            load_u64(p->peer_id.bytes) == prefix &&
+            memcmp(p->peer_id.bytes, peer_id->bytes, CYXWIZ_NODE_ID_LEN) == 0) {
+            return p;
+        }
+        /* Prefer a free slot, otherwise the least recently used one */
+        if (!p->active) {
+            if (!victim || victim->active) {
+                victim = p;
+            }
+        } else if (!victim ||
+                   (victim->active && p->last_used < victim->last_used)) {
+            victim = p;
+        }
+    }
+
+    if (!create) {
+        return NULL;
+    }
+
+    if (victim->active) {
+        ctx->stats.peer_evictions++;
+    }
+    memset(victim, 0, sizeof(cyxchat_dedup_peer_t));
+    memcpy(&victim->peer_id, peer_id, sizeof(cyxwiz_node_id_t));
+    victim->active = 1;
+    return victim;
+}
+
+/* ============================================================
+ * Dedup API
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_dedup_create(cyxchat_dedup_ctx_t **ctx)
+{
+    if (!ctx) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_dedup_ctx_t *c = calloc(1, sizeof(cyxchat_dedup_ctx_t));
+    if (!c) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    *ctx = c;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_dedup_destroy(cyxchat_dedup_ctx_t *ctx)
+{
+    if (ctx) {
+        cyxwiz_secure_zero(ctx, sizeof(cyxchat_dedup_ctx_t));
+        free(ctx);
+    }
+}
+
+int cyxchat_dedup_check(
+    cyxchat_dedup_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const cyxchat_msg_id_t *msg_id,
+    uint8_t sub_id
+) {
+    if (!ctx || !from || !msg_id) {
+        return 0;
+    }
+
+    ctx->stats.checked++;
+
+    cyxchat_dedup_peer_t *peer = find_peer(ctx, from, 1);
+    peer->last_used = ++ctx->tick;
+
+    uint64_t key = make_key(msg_id, sub_id);
+
+    /* Fast path: neither generation has seen it */
+    if (bloom_test(peer->bloom[0], key) || bloom_test(peer->bloom[1], key)) {
+        if (window_contains(peer, key)) {
+            ctx->stats.duplicates++;
+            return 1;
+        }
+        ctx->stats.false_positives++;
+    }
+
+    /* Rotate generations once the current one is full */
+    if (peer->gen_count >= CYXCHAT_DEDUP_GENERATION) {
+        peer->current ^= 1;
+        memset(peer->bloom[peer->current], 0, sizeof(peer->bloom[0]));
+        peer->gen_count = 0;
+    }
+
+    bloom_set(peer->bloom[peer->current], key);
+    peer->gen_count++;
+
+    peer->window[peer->window_pos] = key;
+    peer->window_pos = (uint8_t)((peer->window_pos + 1) % CYXCHAT_DEDUP_WINDOW);
+    if (peer->window_count < CYXCHAT_DEDUP_WINDOW) {
+        peer->window_count++;
+    }
+
+    return 0;
+}
+
+void cyxchat_dedup_forget_peer(
+    cyxchat_dedup_ctx_t *ctx,
+    const cyxwiz_node_id_t *from
+) {
+    if (!ctx || !from) return;
+
+    cyxchat_dedup_peer_t *peer = find_peer(ctx, from, 0);
+    if (peer) {
+        memset(peer, 0, sizeof(cyxchat_dedup_peer_t));
+    }
+}
+
+void cyxchat_dedup_get_stats(
+    cyxchat_dedup_ctx_t *ctx,
+    cyxchat_dedup_stats_t *stats_out
+) {
+    if (!stats_out) return;
+
+    if (!ctx) {
+        memset(stats_out, 0, sizeof(cyxchat_dedup_stats_t));
+        return;
+    }
+
+    *stats_out = ctx->stats;
+}
+
+/* ============================================================
+ * Sequence Window
+ * ============================================================ */
+
+int cyxchat_dedup_seq_check(cyxchat_dedup_seq_t *win, uint32_t seq)
+{
+    if (!win) return 0;
+
+    int32_t d = (int32_t)(seq - win->top);
+
+    if (!win->started || d <= -(int32_t)CYXCHAT_DEDUP_SEQ_RESYNC) {
+        win->started = 1;
+        win->top = seq;
+        win->seen = 1;
+        return 0;
+    }
+
+    if (d > 0) {
+        win->seen = d >= CYXCHAT_DEDUP_SEQ_WINDOW ? 1 : (win->seen << d) | 1;
+        win->top = seq;
+        return 0;
+    }
+
+    /* Behind the window: its twin was delivered long ago */
+    if (d <= -CYXCHAT_DEDUP_SEQ_WINDOW) return 1;
+
+    uint64_t bit = 1ULL << (unsigned)(-d);
+    if (win->seen & bit) return 1;
+    win->seen |= bit;
+    return 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * CyxChat Dispatch Implementation
+ *
+ * The first byte of every datagram indexes a 256-entry table, so routing
+ * is one load whatever the number of protocols. Ranges are claimed at
+ * create time and checked for overlap there, not per packet.
+ */
+
+#include <cyxchat/dispatch.h>
+
+#include <string.h>
+
+/* ============================================================
+ * Dispatch Table
+ * ============================================================ */
+
+void cyxchat_dispatch_init(cyxchat_dispatch_t *d)
+{
+    if (!d) return;
+    memset(d, 0, sizeof(*d));
+}
+
+cyxchat_error_t cyxchat_dispatch_register(
+    cyxchat_dispatch_t *d,
+    uint8_t first,
+    uint8_t last,
+    uint32_t flags,
+    cyxchat_dispatch_fn fn,
+    void *user_data
+) {
+    if (!d || !fn) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (first > last) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    for (unsigned t = first; t <= last; t++) {
+        if (d->entries[t].fn) {
+            return CYXCHAT_ERR_EXISTS;
+        }
+    }
+
+    for (unsigned t = first; t <= last; t++) {
+        d->entries[t].fn = fn;
+        d->entries[t].user_data = user_data;
+        d->entries[t].flags = flags;
+    }
+    return CYXCHAT_OK;
+}
+
+void cyxchat_dispatch_unregister(
+    cyxchat_dispatch_t *d,
+    uint8_t first,
+    uint8_t last
+) {
+    if (!d) return;
+
+    for (unsigned t = first; t <= last; t++) {
+        memset(&d->entries[t], 0, sizeof(cyxchat_dispatch_entry_t));
+    }
+}
@@ -10,6 +10,8 @@
 #endif
 
 #include "cyxchat/dns.h"
+#include "cyxchat/timer.h"
+#include "cyxchat/metrics.h"
 #include <cyxwiz/memory.h>
 #include <cyxwiz/log.h>
 #include <cyxwiz/types.h>
@@ -18,6 +20,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 #include <ctype.h>
 
 #ifdef CYXWIZ_HAS_CRYPTO
@@ -95,6 +98,7 @@ typedef struct {
     uint64_t cached_at;
     uint8_t hops;           /* Gossip hop count when received */
     int valid;
+    cyxchat_timer_t expiry_timer;
 } dns_cache_entry_t;
 
 /* Pending lookup */
@@ -105,6 +109,7 @@ typedef struct {
     cyxchat_dns_lookup_cb callback;
     void *user_data;
     int active;
+    cyxchat_timer_t timeout_timer;
 } dns_pending_lookup_t;
 
 /* Pending registration */
@@ -133,9 +138,11 @@ struct cyxchat_dns_ctx {
     cyxchat_dns_record_t my_record;
     int is_registered;
     uint64_t last_refresh;
+    cyxchat_timer_t refresh_timer;
 
-    /* DNS cache */
-    dns_cache_entry_t cache[CYXCHAT_DNS_CACHE_SIZE];
+    /* DNS cache (carved after the struct) */
+    dns_cache_entry_t *cache;
+    size_t cache_capacity;
     size_t cache_count;
 
     /* Petnames */
@@ -151,6 +158,10 @@ struct cyxchat_dns_ctx {
 
     /* Statistics */
     cyxchat_dns_stats_t stats;
+
+    /* Timer wheel (own_timers unless attached to a shared wheel) */
+    cyxchat_timer_wheel_t *own_timers;
+    cyxchat_timer_wheel_t *timers;
 };
 
 /* Broadcast to all connected peers (auto-selects method) */
@@ -222,7 +233,7 @@ static void base32_encode(const uint8_t *data, size_t len, char *out, size_t out
 /* Find cache entry by name */
 static dns_cache_entry_t* find_cache_entry(cyxchat_dns_ctx_t *ctx, const char *name)
 {
-    for (size_t i = 0; i < CYXCHAT_DNS_CACHE_SIZE; i++) {
+    for (size_t i = 0; i < ctx->cache_capacity; i++) {
         if (ctx->cache[i].valid &&
             strcmp(ctx->cache[i].record.name, name) == 0) {
             return &ctx->cache[i];
@@ -239,7 +250,7 @@ static dns_cache_entry_t* alloc_cache_entry(cyxchat_dns_ctx_t *ctx)
     uint64_t oldest_time = UINT64_MAX;
 
     /* Find empty slot or oldest entry */
-    for (size_t i = 0; i < CYXCHAT_DNS_CACHE_SIZE; i++) {
+    for (size_t i = 0; i < ctx->cache_capacity; i++) {
         if (!ctx->cache[i].valid) {
             ctx->cache_count++;
             ctx->cache[i].valid = 1;
@@ -306,6 +317,100 @@ static dns_pending_lookup_t* alloc_pending_lookup(cyxchat_dns_ctx_t *ctx)
     return NULL;
 }
 
+/* ============================================================
+ * Timers
+ * ============================================================ */
+
+#define DNS_TIMER_OWNER(timer, type, member) \
+    ((type*)((uint8_t*)(timer) - offsetof(type, member)))
+
+static void free_pending_lookup(cyxchat_dns_ctx_t *ctx, dns_pending_lookup_t *pending)
+{
+    cyxchat_timer_cancel(ctx->timers, &pending->timeout_timer);
+    pending->active = 0;
+}
+
+static void drop_cache_entry(cyxchat_dns_ctx_t *ctx, dns_cache_entry_t *entry)
+{
+    cyxchat_timer_cancel(ctx->timers, &entry->expiry_timer);
+    entry->valid = 0;
+    if (ctx->cache_count > 0) ctx->cache_count--;
+}
+
+/* Lookup timed out - call callback with NULL */
+static void on_lookup_timeout(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)user_data;
+    (void)now_ms;
+    dns_pending_lookup_t *pending = DNS_TIMER_OWNER(timer, dns_pending_lookup_t, timeout_timer);
+
+    if (!pending->active) return;
+
+    pending->active = 0;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_TIMEOUT, 1);
+    if (pending->callback) {
+        pending->callback(pending->user_data, pending->name, NULL);
+    }
+}
+
+static void on_cache_expiry(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Arm expiry for whatever is left of the entry's TTL */
+static void arm_cache_timer(cyxchat_dns_ctx_t *ctx, dns_cache_entry_t *entry)
+{
+    uint64_t age_ms = get_time_ms() - entry->cached_at;
+    uint64_t ttl_ms = (uint64_t)entry->record.ttl * 1000;
+    uint64_t remaining = age_ms >= ttl_ms ? 0 : ttl_ms - age_ms;
+
+    cyxchat_timer_schedule(ctx->timers, &entry->expiry_timer,
+                           cyxchat_timer_now(ctx->timers) + remaining,
+                           on_cache_expiry, ctx);
+}
+
+static void on_cache_expiry(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)now_ms;
+    cyxchat_dns_ctx_t *ctx = (cyxchat_dns_ctx_t*)user_data;
+    dns_cache_entry_t *entry = DNS_TIMER_OWNER(timer, dns_cache_entry_t, expiry_timer);
+
+    if (!entry->valid) return;
+
+    if (is_cache_expired(entry, get_time_ms())) {
+        drop_cache_entry(ctx, entry);
+    } else {
+        arm_cache_timer(ctx, entry);
+    }
+}
+
+static void on_refresh_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Arm refresh for whatever is left of the interval since last refresh */
+static void arm_refresh_timer(cyxchat_dns_ctx_t *ctx)
+{
+    uint64_t interval_ms = (uint64_t)CYXCHAT_DNS_REFRESH_INTERVAL * 1000;
+    uint64_t elapsed = get_time_ms() - ctx->last_refresh;
+    uint64_t remaining = elapsed >= interval_ms ? 0 : interval_ms - elapsed;
+
+    cyxchat_timer_schedule(ctx->timers, &ctx->refresh_timer,
+                           cyxchat_timer_now(ctx->timers) + remaining,
+                           on_refresh_timer, ctx);
+}
+
+static void on_refresh_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    (void)now_ms;
+    cyxchat_dns_ctx_t *ctx = (cyxchat_dns_ctx_t*)user_data;
+
+    if (!ctx->is_registered) return;
+
+    if (get_time_ms() - ctx->last_refresh >= (uint64_t)CYXCHAT_DNS_REFRESH_INTERVAL * 1000) {
+        cyxchat_dns_refresh(ctx);
+    } else {
+        arm_refresh_timer(ctx);
+    }
+}
+
 /* Find petname entry */
 static cyxchat_petname_t* find_petname_by_id(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *node_id)
 {
@@ -599,6 +704,7 @@ static void handle_register(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from
         entry->record = record;
         entry->cached_at = get_time_ms();
         entry->hops = hops;
+        arm_cache_timer(ctx, entry);
     }
 
     ctx->stats.registrations++;
@@ -666,6 +772,8 @@ static void handle_response(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from
     dns_pending_lookup_t *pending = find_pending_lookup_by_id(ctx, query_id);
     if (!pending) return;
 
+    CYXCHAT_OBSERVE(CYXCHAT_METRIC_DNS_LOOKUP, (get_time_ms() - pending->start_time) * 1000);
+
     cyxchat_dns_record_t record;
     const cyxchat_dns_record_t *result = NULL;
 
@@ -706,6 +814,7 @@ static void handle_response(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from
                     entry->record = record;
                     entry->cached_at = get_time_ms();
                     entry->hops = 1;
+                    arm_cache_timer(ctx, entry);
                 }
 
                 result = &record;
@@ -719,7 +828,7 @@ static void handle_response(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from
         pending->callback(pending->user_data, pending->name, result);
     }
 
-    pending->active = 0;
+    free_pending_lookup(ctx, pending);
 }
 
 static void handle_announce(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from,
@@ -733,16 +842,45 @@ static void handle_announce(cyxchat_dns_ctx_t *ctx, const cyxwiz_node_id_t *from
  * Public API Implementation
  * ============================================================ */
 
+/* Context and its record cache */
+static void* dns_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_dns_ctx_t *ctx = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_dns_ctx_t));
+    dns_cache_entry_t *cache = cyxchat_arena_carve(arena, cfg->dns_cache_size,
+                                                   sizeof(dns_cache_entry_t));
+    if (ctx) {
+        ctx->cache = cache;
+        ctx->cache_capacity = cfg->dns_cache_size;
+    }
+    return ctx;
+}
+
 cyxchat_error_t cyxchat_dns_create(cyxchat_dns_ctx_t **ctx_out,
                                     cyxwiz_router_t *router,
                                     const cyxwiz_node_id_t *local_id,
                                     const uint8_t *signing_key)
+{
+    return cyxchat_dns_create_with_config(ctx_out, router, local_id, signing_key, NULL);
+}
+
+cyxchat_error_t cyxchat_dns_create_with_config(cyxchat_dns_ctx_t **ctx_out,
+                                                cyxwiz_router_t *router,
+                                                const cyxwiz_node_id_t *local_id,
+                                                const uint8_t *signing_key,
+                                                const cyxchat_config_t *config)
 {
     if (!ctx_out || !local_id) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_dns_ctx_t *ctx = (cyxchat_dns_ctx_t*)calloc(1, sizeof(cyxchat_dns_ctx_t));
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_dns_ctx_t *ctx = cyxchat_arena_build(dns_layout, config);
     if (!ctx) {
         return CYXCHAT_ERR_MEMORY;
     }
@@ -759,6 +897,12 @@ cyxchat_error_t cyxchat_dns_create(cyxchat_dns_ctx_t **ctx_out,
     ctx->is_registered = 0;
     ctx->next_query_id = 1;
 
+    if (cyxchat_timer_wheel_create(&ctx->own_timers, get_time_ms()) != CYXCHAT_OK) {
+        free(ctx);
+        return CYXCHAT_ERR_MEMORY;
+    }
+    ctx->timers = ctx->own_timers;
+
     *ctx_out = ctx;
     return CYXCHAT_OK;
 }
@@ -781,6 +925,10 @@ void cyxchat_dns_destroy(cyxchat_dns_ctx_t *ctx)
 {
     if (!ctx) return;
 
+    /* Release timers held on a shared wheel */
+    cyxchat_dns_set_timer_wheel(ctx, NULL);
+    cyxchat_timer_wheel_destroy(ctx->own_timers);
+
     /* Securely clear signing key */
     cyxwiz_secure_zero(ctx->signing_key, sizeof(ctx->signing_key));
 
@@ -791,36 +939,35 @@ cyxchat_error_t cyxchat_dns_poll(cyxchat_dns_ctx_t *ctx, uint64_t now_ms)
 {
     if (!ctx) return CYXCHAT_ERR_NULL;
 
-    /* Check pending lookup timeouts */
-    for (size_t i = 0; i < 16; i++) {
-        dns_pending_lookup_t *pending = &ctx->pending_lookups[i];
-        if (!pending->active) continue;
-
-        if (now_ms - pending->start_time >= CYXCHAT_DNS_LOOKUP_TIMEOUT) {
-            /* Timeout - call callback with NULL */
-            if (pending->callback) {
-                pending->callback(pending->user_data, pending->name, NULL);
-            }
-            pending->active = 0;
-        }
+    /* Lookup timeouts, registration refresh and cache expiry are timers;
+     * a shared wheel is advanced by its owner */
+    if (ctx->timers == ctx->own_timers) {
+        cyxchat_timer_advance(ctx->timers, now_ms);
     }
 
-    /* Check registration refresh */
-    if (ctx->is_registered) {
-        if (now_ms - ctx->last_refresh >= CYXCHAT_DNS_REFRESH_INTERVAL * 1000) {
-            cyxchat_dns_refresh(ctx);
-        }
-    }
+    return CYXCHAT_OK;
+}
 
-    /* Expire old cache entries */
-    for (size_t i = 0; i < CYXCHAT_DNS_CACHE_SIZE; i++) {
-        if (ctx->cache[i].valid && is_cache_expired(&ctx->cache[i], now_ms)) {
-            ctx->cache[i].valid = 0;
-            if (ctx->cache_count > 0) ctx->cache_count--;
-        }
+void cyxchat_dns_set_timer_wheel(cyxchat_dns_ctx_t *ctx, cyxchat_timer_wheel_t *wheel)
+{
+    if (!ctx) return;
+
+    cyxchat_timer_wheel_t *target = wheel ? wheel : ctx->own_timers;
+    if (target == ctx->timers) return;
+
+    cyxchat_timer_move(ctx->timers, target, &ctx->refresh_timer);
+    for (size_t i = 0; i < 16; i++) {
+        cyxchat_timer_move(ctx->timers, target, &ctx->pending_lookups[i].timeout_timer);
+    }
+    for (size_t i = 0; i < ctx->cache_capacity; i++) {
+        cyxchat_timer_move(ctx->timers, target, &ctx->cache[i].expiry_timer);
     }
+    ctx->timers = target;
+}
 
-    return CYXCHAT_OK;
+uint64_t cyxchat_dns_next_deadline(cyxchat_dns_ctx_t *ctx)
+{
+    return ctx ? cyxchat_timer_next_deadline(ctx->timers) : CYXCHAT_TIMER_NONE;
 }
 
 /* ============================================================
@@ -859,6 +1006,7 @@ cyxchat_error_t cyxchat_dns_register(cyxchat_dns_ctx_t *ctx,
 
     ctx->is_registered = 1;
     ctx->last_refresh = get_time_ms();
+    arm_refresh_timer(ctx);
 
     /* Store pending registration callback */
     ctx->pending_register.callback = callback;
@@ -896,6 +1044,7 @@ cyxchat_error_t cyxchat_dns_refresh(cyxchat_dns_ctx_t *ctx)
     sign_record(ctx, &ctx->my_record);
 
     ctx->last_refresh = get_time_ms();
+    arm_refresh_timer(ctx);
 
     /* Broadcast update */
     uint8_t msg[210];
@@ -927,6 +1076,7 @@ cyxchat_error_t cyxchat_dns_unregister(cyxchat_dns_ctx_t *ctx)
     }
 
     ctx->is_registered = 0;
+    cyxchat_timer_cancel(ctx->timers, &ctx->refresh_timer);
     memset(&ctx->my_record, 0, sizeof(cyxchat_dns_record_t));
 
     return CYXCHAT_OK;
@@ -987,6 +1137,7 @@ cyxchat_error_t cyxchat_dns_lookup(cyxchat_dns_ctx_t *ctx,
     dns_cache_entry_t *entry = find_cache_entry(ctx, normalized);
     if (entry && !is_cache_expired(entry, get_time_ms())) {
         ctx->stats.cache_hits++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_CACHE_HIT, 1);
         if (callback) {
             callback(user_data, normalized, &entry->record);
         }
@@ -994,6 +1145,7 @@ cyxchat_error_t cyxchat_dns_lookup(cyxchat_dns_ctx_t *ctx,
     }
 
     ctx->stats.cache_misses++;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_CACHE_MISS, 1);
 
     /* Check if lookup already pending */
     if (find_pending_lookup(ctx, normalized)) {
@@ -1011,6 +1163,10 @@ cyxchat_error_t cyxchat_dns_lookup(cyxchat_dns_ctx_t *ctx,
     pending->user_data = user_data;
     pending->start_time = get_time_ms();
 
+    cyxchat_timer_schedule(ctx->timers, &pending->timeout_timer,
+                           cyxchat_timer_now(ctx->timers) + CYXCHAT_DNS_LOOKUP_TIMEOUT,
+                           on_lookup_timeout, ctx);
+
     /* Broadcast lookup query */
     uint8_t msg[100];
     size_t msg_len = serialize_lookup(normalized, pending->query_id, msg, sizeof(msg));
@@ -1040,6 +1196,7 @@ cyxchat_error_t cyxchat_dns_resolve(cyxchat_dns_ctx_t *ctx,
     if (ctx->is_registered && strcmp(normalized, ctx->my_record.name) == 0) {
         *record_out = ctx->my_record;
         ctx->stats.cache_hits++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_CACHE_HIT, 1);
         return CYXCHAT_OK;
     }
 
@@ -1048,10 +1205,12 @@ cyxchat_error_t cyxchat_dns_resolve(cyxchat_dns_ctx_t *ctx,
     if (entry && !is_cache_expired(entry, get_time_ms())) {
         *record_out = entry->record;
         ctx->stats.cache_hits++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_CACHE_HIT, 1);
         return CYXCHAT_OK;
     }
 
     ctx->stats.cache_misses++;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_DNS_CACHE_MISS, 1);
     return CYXCHAT_ERR_NOT_FOUND;
 }
 
@@ -1080,8 +1239,7 @@ void cyxchat_dns_invalidate(cyxchat_dns_ctx_t *ctx, const char *name)
 
     dns_cache_entry_t *entry = find_cache_entry(ctx, normalized);
     if (entry) {
-        entry->valid = 0;
-        if (ctx->cache_count > 0) ctx->cache_count--;
+        drop_cache_entry(ctx, entry);
     }
 }
 
@@ -4,25 +4,22 @@
 
 #include <cyxchat/file.h>
 #include <cyxchat/chat.h>
+#include <cyxchat/congestion.h>
+#include <cyxchat/connection.h>
+#include <cyxchat/rng.h>
+#include <cyxchat/metrics.h>
 #include <cyxwiz/crypto.h>
 #include <cyxwiz/memory.h>
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#define CHUNK_DELAY_MS(ms) Sleep(ms)
-#else
-#include <unistd.h>
-#define CHUNK_DELAY_MS(ms) usleep((ms) * 1000)
-#endif
-
 /* ============================================================
  * Constants
  * ============================================================ */
 
 #define CYXCHAT_MAX_TRANSFERS 16
+#define FILE_CHUNK_BURST      8         /* Paced chunks one late poll may catch up */
 
 /* ============================================================
  * Internal Structures
@@ -36,11 +33,18 @@ typedef struct {
     size_t bitmap_size;                     /* Size of bitmap in bytes */
     uint64_t offer_sent_at;                 /* Timestamp when offer was sent */
     int active;
-    uint64_t last_chunk_sent_ms;            /* Timestamp of last chunk sent */
+
+    /* Outgoing chunk pacing */
+    cyxchat_congestion_t cc;
+    uint64_t next_chunk_us;                 /* Earliest send of the next chunk */
+    uint32_t cc_samples;                    /* Link RTT samples already fed */
+    uint64_t cc_lost;                       /* Link losses already fed */
+    int cc_linked;                          /* Baselines taken from the link */
 } file_transfer_slot_t;
 
 struct cyxchat_file_ctx {
     cyxchat_ctx_t *chat_ctx;
+    cyxchat_conn_ctx_t *conn;               /* Delay samples (optional) */
 
     /* Transfers */
     file_transfer_slot_t transfers[CYXCHAT_MAX_TRANSFERS];
@@ -83,6 +87,7 @@ static file_transfer_slot_t* alloc_transfer(cyxchat_file_ctx_t *ctx) {
         if (!ctx->transfers[i].active) {
             memset(&ctx->transfers[i], 0, sizeof(file_transfer_slot_t));
             ctx->transfers[i].active = 1;
+            cyxchat_congestion_init(&ctx->transfers[i].cc);
             ctx->transfer_count++;
             return &ctx->transfers[i];
         }
@@ -104,6 +109,25 @@ static void free_transfer(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot) {
     ctx->transfer_count--;
 }
 
+/* Enter a final state, recording the outcome once per transfer */
+static void finish_transfer(file_transfer_slot_t *slot, cyxchat_file_state_t state) {
+    cyxchat_file_state_t old = slot->transfer.state;
+    slot->transfer.state = state;
+
+    if (old == CYXCHAT_FILE_COMPLETED || old == CYXCHAT_FILE_FAILED ||
+        old == CYXCHAT_FILE_CANCELLED) {
+        return;
+    }
+
+    if (state == CYXCHAT_FILE_COMPLETED) {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_FILE_DONE, 1);
+        CYXCHAT_OBSERVE(CYXCHAT_METRIC_FILE_TRANSFER,
+                        (cyxchat_timestamp_ms() - slot->transfer.started_at) * 1000);
+    } else {
+        CYXCHAT_COUNT(CYXCHAT_METRIC_FILE_FAILED, 1);
+    }
+}
+
 /* ============================================================
  * Chunk Bitmap Helpers
  * ============================================================ */
@@ -309,6 +333,12 @@ cyxchat_error_t cyxchat_file_ctx_create(
     return CYXCHAT_OK;
 }
 
+void cyxchat_file_set_conn(cyxchat_file_ctx_t *ctx, cyxchat_conn_ctx_t *conn) {
+    if (ctx) {
+        ctx->conn = conn;
+    }
+}
+
 void cyxchat_file_ctx_destroy(cyxchat_file_ctx_t *ctx) {
     if (ctx) {
         /* Free all transfers */
@@ -322,9 +352,9 @@ void cyxchat_file_ctx_destroy(cyxchat_file_ctx_t *ctx) {
 }
 
 /* Helper to send next chunk for a transfer */
-static void send_next_chunk(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot) {
+static cyxchat_error_t send_next_chunk(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot) {
     if (!slot->data || slot->transfer.chunks_done >= slot->transfer.meta.chunk_count) {
-        return;
+        return CYXCHAT_ERR_INVALID;
     }
 
     uint16_t chunk_idx = slot->transfer.chunks_done;
@@ -352,10 +382,73 @@ static void send_next_chunk(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot)
     memcpy(chunk_buf + chunk_wire_len, slot->data + offset, chunk_len);
     chunk_wire_len += chunk_len;
 
-    cyxchat_send_raw(ctx->chat_ctx, &slot->transfer.peer, chunk_buf, chunk_wire_len);
+    /* Bulk class: queued behind chat traffic; a full queue means try later */
+    cyxchat_error_t err = cyxchat_send_raw_prio(ctx->chat_ctx, &slot->transfer.peer,
+                                                chunk_buf, chunk_wire_len, CYXCHAT_PRIO_BULK);
+    if (err != CYXCHAT_OK) {
+        return err;
+    }
+
     slot->transfer.chunks_done++;
     slot->transfer.updated_at = cyxchat_timestamp_ms();
-    slot->last_chunk_sent_ms = slot->transfer.updated_at;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_FILE_CHUNK_SENT, 1);
+    return CYXCHAT_OK;
+}
+
+/* Feed new link samples for the transfer's peer to its controller */
+static void update_pacing(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot, uint64_t now_ms) {
+    if (!ctx->conn) return;
+
+    /* Chunks travel the shared uplink; the peer's echoes time its queue */
+    cyxchat_conn_sample_path(ctx->conn, &slot->transfer.peer);
+
+    cyxchat_linkstats_t ls;
+    if (cyxchat_conn_get_link_stats(ctx->conn, &slot->transfer.peer, &ls) != CYXCHAT_OK) {
+        return;
+    }
+
+    /* Losses from before the transfer started are not ours */
+    if (!slot->cc_linked) {
+        slot->cc_linked = 1;
+        slot->cc_lost = ls.packets_lost;
+    }
+
+    /* Path changed under us: the old window means nothing there */
+    if (ls.rtt_samples < slot->cc_samples) {
+        cyxchat_congestion_init(&slot->cc);
+        slot->cc_samples = 0;
+    }
+
+    if (ls.rtt_samples > slot->cc_samples) {
+        cyxchat_congestion_on_rtt(&slot->cc, ls.latest_rtt_ms, ls.min_rtt_ms);
+        slot->cc_samples = ls.rtt_samples;
+    }
+
+    if (ls.packets_lost > slot->cc_lost) {
+        cyxchat_congestion_on_loss(&slot->cc, now_ms);
+        slot->cc_lost = ls.packets_lost;
+    }
+}
+
+/* Send the chunks the pacing interval allows up to now */
+static int send_paced_chunks(cyxchat_file_ctx_t *ctx, file_transfer_slot_t *slot, uint64_t now_ms) {
+    uint64_t now_us = now_ms * 1000;
+    uint64_t interval = cyxchat_congestion_interval_us(&slot->cc);
+
+    /* A late poll catches up a short burst, not the whole gap */
+    uint64_t span = interval * FILE_CHUNK_BURST;
+    if (now_us > span && slot->next_chunk_us < now_us - span) {
+        slot->next_chunk_us = now_us - span;
+    }
+
+    int sent = 0;
+    while (slot->transfer.chunks_done < slot->transfer.meta.chunk_count &&
+           slot->next_chunk_us <= now_us) {
+        if (send_next_chunk(ctx, slot) != CYXCHAT_OK) break;
+        slot->next_chunk_us += interval;
+        sent++;
+    }
+    return sent;
 }
 
 int cyxchat_file_poll(cyxchat_file_ctx_t *ctx, uint64_t now_ms) {
@@ -368,18 +461,14 @@ int cyxchat_file_poll(cyxchat_file_ctx_t *ctx, uint64_t now_ms) {
         file_transfer_slot_t *slot = &ctx->transfers[i];
         if (!slot->active) continue;
 
-        /* For outgoing transfers, send chunks with delay */
+        /* For outgoing transfers, send chunks paced by queueing delay */
         if (slot->transfer.is_outgoing && slot->transfer.state == CYXCHAT_FILE_SENDING) {
-            /* Send one chunk per poll if enough time has passed */
             if (slot->transfer.chunks_done < slot->transfer.meta.chunk_count) {
-                uint64_t delay_ms = (slot->transfer.chunks_done == 0) ? 0 : 500;  /* 500ms between chunks */
-                if (now_ms - slot->last_chunk_sent_ms >= delay_ms) {
-                    send_next_chunk(ctx, slot);
-                    events++;
-                }
+                update_pacing(ctx, slot, now_ms);
+                events += send_paced_chunks(ctx, slot, now_ms);
             } else {
                 /* All chunks sent, mark as completed */
-                slot->transfer.state = CYXCHAT_FILE_COMPLETED;
+                finish_transfer(slot, CYXCHAT_FILE_COMPLETED);
                 if (ctx->on_complete) {
                     ctx->on_complete(ctx, &slot->transfer.meta.file_id,
                                     slot->data, slot->transfer.meta.size,
@@ -393,7 +482,7 @@ int cyxchat_file_poll(cyxchat_file_ctx_t *ctx, uint64_t now_ms) {
         if (slot->transfer.state == CYXCHAT_FILE_SENDING ||
             slot->transfer.state == CYXCHAT_FILE_RECEIVING) {
             if (now_ms - slot->transfer.updated_at > 60000) {
-                slot->transfer.state = CYXCHAT_FILE_FAILED;
+                finish_transfer(slot, CYXCHAT_FILE_FAILED);
 
                 if (ctx->on_error) {
                     ctx->on_error(ctx, &slot->transfer.meta.file_id,
@@ -434,7 +523,8 @@ cyxchat_error_t cyxchat_file_send(
     }
 
     /* Generate file ID and key */
-    cyxwiz_crypto_random(slot->transfer.meta.file_id.bytes, CYXCHAT_FILE_ID_SIZE);
+    cyxchat_rng_bytes(cyxchat_get_rng(ctx->chat_ctx),
+                      slot->transfer.meta.file_id.bytes, CYXCHAT_FILE_ID_SIZE);
     cyxwiz_crypto_random(slot->transfer.meta.file_key, 32);
 
     /* Set metadata */
@@ -541,47 +631,10 @@ cyxchat_error_t cyxchat_file_send(
 
             cyxchat_send_raw(ctx->chat_ctx, to, chunk_buf, chunk_wire_len);
             slot->transfer.chunks_done = 1;
-        }
-    } else {
-        /* Multi-chunk: send all chunks */
-        for (uint16_t i = 0; i < chunk_count; i++) {
-            uint8_t chunk_buf[250];
-            size_t chunk_wire_len = 0;
-
-            chunk_buf[chunk_wire_len++] = CYXCHAT_MSG_FILE_CHUNK;
-            memcpy(chunk_buf + chunk_wire_len, slot->transfer.meta.file_id.bytes, CYXCHAT_FILE_ID_SIZE);
-            chunk_wire_len += CYXCHAT_FILE_ID_SIZE;
-
-            /* Chunk index (2 bytes little-endian) */
-            chunk_buf[chunk_wire_len++] = (uint8_t)(i & 0xFF);
-            chunk_buf[chunk_wire_len++] = (uint8_t)((i >> 8) & 0xFF);
-
-            /* Calculate chunk data offset and length */
-            size_t offset = (size_t)i * CYXCHAT_CHUNK_SIZE;
-            size_t remaining = data_len - offset;
-            uint16_t chunk_len = (remaining > CYXCHAT_CHUNK_SIZE) ? CYXCHAT_CHUNK_SIZE : (uint16_t)remaining;
-
-            /* Chunk length (2 bytes) */
-            chunk_buf[chunk_wire_len++] = (uint8_t)(chunk_len & 0xFF);
-            chunk_buf[chunk_wire_len++] = (uint8_t)((chunk_len >> 8) & 0xFF);
-
-            /* Chunk data - limit to fit in wire buffer */
-            if (chunk_wire_len + chunk_len > sizeof(chunk_buf)) {
-                chunk_len = (uint16_t)(sizeof(chunk_buf) - chunk_wire_len);
-            }
-            memcpy(chunk_buf + chunk_wire_len, data + offset, chunk_len);
-            chunk_wire_len += chunk_len;
-
-            cyxchat_send_raw(ctx->chat_ctx, to, chunk_buf, chunk_wire_len);
-            slot->transfer.chunks_done = i + 1;
-            slot->transfer.updated_at = cyxchat_timestamp_ms();
-
-            /* Small delay between chunks to avoid rate limiting */
-            if (i < chunk_count - 1) {
-                CHUNK_DELAY_MS(100);  /* 100ms delay between chunks */
-            }
+            CYXCHAT_COUNT(CYXCHAT_METRIC_FILE_CHUNK_SENT, 1);
         }
     }
+    /* Multi-chunk files are paced out by cyxchat_file_poll() */
 
     if (file_id_out) {
         memcpy(file_id_out, &slot->transfer.meta.file_id, sizeof(cyxchat_file_id_t));
@@ -726,7 +779,7 @@ cyxchat_error_t cyxchat_file_cancel(
         return CYXCHAT_ERR_NOT_FOUND;
     }
 
-    slot->transfer.state = CYXCHAT_FILE_CANCELLED;
+    finish_transfer(slot, CYXCHAT_FILE_CANCELLED);
 
     /* TODO: Send cancel message to peer */
 
@@ -1152,6 +1205,7 @@ static cyxchat_error_t handle_file_chunk(
         memcpy(slot->data + data_offset, data + offset, chunk_len);
         slot->transfer.chunks_done++;
         slot->transfer.updated_at = cyxchat_timestamp_ms();
+        CYXCHAT_COUNT(CYXCHAT_METRIC_FILE_CHUNK_RECV, 1);
 
         /* Notify progress */
         if (ctx->on_progress) {
@@ -1163,7 +1217,7 @@ static cyxchat_error_t handle_file_chunk(
 
         /* Check if complete */
         if (slot->transfer.chunks_done >= slot->transfer.meta.chunk_count) {
-            slot->transfer.state = CYXCHAT_FILE_COMPLETED;
+            finish_transfer(slot, CYXCHAT_FILE_COMPLETED);
 
             /* Notify completion */
             if (ctx->on_complete) {
@@ -1381,7 +1435,7 @@ static cyxchat_error_t handle_file_reject(
     }
 
     /* Clean up */
-    slot->transfer.state = CYXCHAT_FILE_FAILED;
+    finish_transfer(slot, CYXCHAT_FILE_FAILED);
     free_transfer(ctx, slot);
 
     return CYXCHAT_OK;
@@ -1439,14 +1493,14 @@ static cyxchat_error_t handle_file_complete(
 
     if (status == 0) {
         /* Success */
-        slot->transfer.state = CYXCHAT_FILE_COMPLETED;
+        finish_transfer(slot, CYXCHAT_FILE_COMPLETED);
         if (ctx->on_complete) {
             ctx->on_complete(ctx, &file_id, slot->data,
                             slot->transfer.meta.size, ctx->on_complete_data);
         }
     } else {
         /* Failure */
-        slot->transfer.state = CYXCHAT_FILE_FAILED;
+        finish_transfer(slot, CYXCHAT_FILE_FAILED);
         if (ctx->on_error) {
             ctx->on_error(ctx, &file_id, CYXCHAT_ERR_TRANSFER, ctx->on_error_data);
         }
@@ -1489,7 +1543,7 @@ static cyxchat_error_t handle_file_cancel(
     }
 
     /* Clean up */
-    slot->transfer.state = CYXCHAT_FILE_CANCELLED;
+    finish_transfer(slot, CYXCHAT_FILE_CANCELLED);
     free_transfer(ctx, slot);
 
     return CYXCHAT_OK;
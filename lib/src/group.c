@@ -9,12 +9,6 @@
 #include <string.h>
 #include <stdlib.h>
 
-/* ============================================================
- * Constants
- * ============================================================ */
-
-#define CYXCHAT_MAX_GROUPS 32
-
 /* ============================================================
  * Internal Structures
  * ============================================================ */
@@ -23,9 +17,11 @@ struct cyxchat_group_ctx {
     cyxchat_ctx_t *chat_ctx;
     cyxwiz_node_id_t local_id;
 
-    /* Groups */
-    cyxchat_group_t groups[CYXCHAT_MAX_GROUPS];
+    /* Groups (carved after the struct) */
+    cyxchat_group_t *groups;
+    size_t group_capacity;
     size_t group_count;
+    size_t footprint;               /* Context plus group table */
 
     /* Callbacks */
     cyxchat_on_group_message_t on_message;
@@ -92,15 +88,43 @@ static cyxchat_group_role_t get_role(
  * Initialization
  * ============================================================ */
 
+/* Context and its group table */
+static void* group_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_group_ctx_t *c = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_group_ctx_t));
+    cyxchat_group_t *groups = cyxchat_arena_carve(arena, cfg->max_groups, sizeof(cyxchat_group_t));
+    if (c) {
+        c->groups = groups;
+        c->group_capacity = cfg->max_groups;
+        c->footprint = arena->size;
+    }
+    return c;
+}
+
 cyxchat_error_t cyxchat_group_ctx_create(
     cyxchat_group_ctx_t **ctx,
     cyxchat_ctx_t *chat_ctx
+) {
+    return cyxchat_group_ctx_create_with_config(ctx, chat_ctx, NULL);
+}
+
+cyxchat_error_t cyxchat_group_ctx_create_with_config(
+    cyxchat_group_ctx_t **ctx,
+    cyxchat_ctx_t *chat_ctx,
+    const cyxchat_config_t *config
 ) {
     if (!ctx || !chat_ctx) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_group_ctx_t *c = calloc(1, sizeof(cyxchat_group_ctx_t));
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_group_ctx_t *c = cyxchat_arena_build(group_layout, config);
     if (!c) {
         return CYXCHAT_ERR_MEMORY;
     }
@@ -122,7 +146,7 @@ void cyxchat_group_ctx_destroy(cyxchat_group_ctx_t *ctx) {
         for (size_t i = 0; i < ctx->group_count; i++) {
             cyxwiz_secure_zero(ctx->groups[i].group_key, 32);
         }
-        cyxwiz_secure_zero(ctx, sizeof(cyxchat_group_ctx_t));
+        cyxwiz_secure_zero(ctx, ctx->footprint);
         free(ctx);
     }
 }
@@ -147,7 +171,7 @@ cyxchat_error_t cyxchat_group_create(
         return CYXCHAT_ERR_NULL;
     }
 
-    if (ctx->group_count >= CYXCHAT_MAX_GROUPS) {
+    if (ctx->group_count >= ctx->group_capacity) {
         return CYXCHAT_ERR_FULL;
     }
 
@@ -299,7 +323,7 @@ cyxchat_error_t cyxchat_group_accept_invite(
         return CYXCHAT_ERR_NULL;
     }
 
-    if (ctx->group_count >= CYXCHAT_MAX_GROUPS) {
+    if (ctx->group_count >= ctx->group_capacity) {
         return CYXCHAT_ERR_FULL;
     }
 
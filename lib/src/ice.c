@@ -0,0 +1,266 @@
+/**
+ * CyxChat ICE-lite Implementation
+ *
+ * Candidate bookkeeping, wire encoding and path selection for the
+ * connection layer's connectivity checks. Nothing here touches the
+ * transport; connection.c sends the punches and check pings and feeds
+ * the measured round trips back in.
+ *
+ * A check steers the peer's return path onto one candidate with a punch
+ * and then times a round trip. If the punch is lost the round trip still
+ * completes over whatever path was steered before, so an unreachable
+ * candidate measures its predecessor's RTT. Selection therefore walks
+ * the list in check order and only lets a candidate win by a clear
+ * margin; a lost punch can never beat the path it inherited.
+ */
+
+#include <cyxchat/ice.h>
+
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#endif
+
+/* RFC 8445 type preferences */
+#define ICE_PREF_HOST   126
+#define ICE_PREF_SRFLX  100
+#define ICE_PREF_RELAY  0
+
+/* ============================================================
+ * Check List
+ * ============================================================ */
+
+uint32_t cyxchat_ice_priority(const cyxchat_ice_candidate_t *cand) {
+    if (!cand) return 0;
+
+    uint32_t pref;
+    switch (cand->type) {
+        case CYXCHAT_ICE_HOST:  pref = ICE_PREF_HOST; break;
+        case CYXCHAT_ICE_SRFLX: pref = ICE_PREF_SRFLX; break;
+        default:                pref = ICE_PREF_RELAY; break;
+    }
+
+    /* Private addresses first among hosts: they are the LAN shortcut */
+    uint32_t ip = ntohl(cand->ip);
+    uint32_t local = 0;
+    if ((ip >> 24) == 10 || (ip >> 20) == 0xAC1 || (ip >> 16) == 0xC0A8) {
+        local = 1;
+    }
+
+    return (pref << 24) | (local << 8) | 255;
+}
+
+void cyxchat_ice_init(cyxchat_ice_checklist_t *cl) {
+    if (!cl) return;
+    memset(cl, 0, sizeof(*cl));
+    cl->selected = -1;
+    cl->checking = -1;
+    for (int i = 0; i < CYXCHAT_ICE_MAX_CANDIDATES; i++) {
+        cl->rtt_ms[i] = CYXCHAT_ICE_RTT_NONE;
+    }
+}
+
+int cyxchat_ice_add(cyxchat_ice_checklist_t *cl, const cyxchat_ice_candidate_t *cand) {
+    if (!cl || !cand || cand->ip == 0 || cand->port == 0) return -1;
+
+    for (int i = 0; i < cl->count; i++) {
+        if (cl->cand[i].ip == cand->ip && cl->cand[i].port == cand->port) {
+            /* Same address learned as a better type keeps its results */
+            if (cyxchat_ice_priority(cand) > cyxchat_ice_priority(&cl->cand[i])) {
+                cl->cand[i].type = cand->type;
+            }
+            return i;
+        }
+    }
+
+    if (cl->count < CYXCHAT_ICE_MAX_CANDIDATES) {
+        int idx = cl->count++;
+        cl->cand[idx] = *cand;
+        cl->rtt_ms[idx] = CYXCHAT_ICE_RTT_NONE;
+        return idx;
+    }
+
+    /* Full: evict the weakest idle candidate if this one beats it */
+    int victim = -1;
+    for (int i = 0; i < cl->count; i++) {
+        if (i == cl->selected || i == cl->checking) continue;
+        if (victim < 0 ||
+            cyxchat_ice_priority(&cl->cand[i]) < cyxchat_ice_priority(&cl->cand[victim])) {
+            victim = i;
+        }
+    }
+    if (victim < 0 ||
+        cyxchat_ice_priority(cand) <= cyxchat_ice_priority(&cl->cand[victim])) {
+        return -1;
+    }
+
+    cl->cand[victim] = *cand;
+    cl->rtt_ms[victim] = CYXCHAT_ICE_RTT_NONE;
+    return victim;
+}
+
+int cyxchat_ice_next_check(const cyxchat_ice_checklist_t *cl, int after) {
+    if (!cl) return -1;
+
+    for (int i = after + 1; i < cl->count; i++) {
+        if (cl->cand[i].type != CYXCHAT_ICE_RELAY) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void cyxchat_ice_record(cyxchat_ice_checklist_t *cl, int index, uint32_t rtt_ms) {
+    if (!cl || index < 0 || index >= cl->count) return;
+    cl->rtt_ms[index] = rtt_ms;
+}
+
+/* RTT gain a candidate needs over the current best to replace it */
+static uint32_t migrate_margin(uint32_t rtt_ms) {
+    uint32_t margin = rtt_ms / 8;
+    return margin < CYXCHAT_ICE_MIGRATE_MIN_MS ? CYXCHAT_ICE_MIGRATE_MIN_MS : margin;
+}
+
+int cyxchat_ice_select(cyxchat_ice_checklist_t *cl) {
+    if (!cl) return -1;
+
+    /* The path in use is the incumbent while it still answers */
+    int best = -1;
+    if (cl->selected >= 0 && cl->selected < cl->count &&
+        cl->rtt_ms[cl->selected] != CYXCHAT_ICE_RTT_NONE) {
+        best = cl->selected;
+    }
+
+    for (int i = 0; i < cl->count; i++) {
+        if (i == best || cl->rtt_ms[i] == CYXCHAT_ICE_RTT_NONE) continue;
+        if (best < 0 ||
+            (uint64_t)cl->rtt_ms[i] + migrate_margin(cl->rtt_ms[best]) <= cl->rtt_ms[best]) {
+            best = i;
+        }
+    }
+
+    cl->selected = (int8_t)best;
+    return best;
+}
+
+/* ============================================================
+ * Wire Format
+ * ============================================================ */
+
+size_t cyxchat_ice_encode(
+    const cyxchat_ice_candidate_t *cands,
+    size_t count,
+    uint8_t *buf,
+    size_t buf_size
+) {
+    if (!buf || (count > 0 && !cands) || count > 255) return 0;
+    if (buf_size < 1 + count * CYXCHAT_ICE_WIRE_SIZE) return 0;
+
+    uint8_t *p = buf;
+    *p++ = (uint8_t)count;
+    for (size_t i = 0; i < count; i++) {
+        *p++ = cands[i].type;
+        memcpy(p, &cands[i].ip, 4);             /* Already network order */
+        p += 4;
+        memcpy(p, &cands[i].port, 2);
+        p += 2;
+    }
+    return (size_t)(p - buf);
+}
+
+int cyxchat_ice_decode(
+    const uint8_t *buf,
+    size_t len,
+    cyxchat_ice_candidate_t *out,
+    size_t max
+) {
+    if (!buf || !out || len < 1) return -1;
+
+    size_t count = buf[0];
+    if (len < 1 + count * CYXCHAT_ICE_WIRE_SIZE) return -1;
+
+    const uint8_t *p = buf + 1;
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++, p += CYXCHAT_ICE_WIRE_SIZE) {
+        if (p[0] > CYXCHAT_ICE_RELAY || n >= max) continue;
+        out[n].type = p[0];
+        memcpy(&out[n].ip, p + 1, 4);
+        memcpy(&out[n].port, p + 5, 2);
+        n++;
+    }
+    return (int)n;
+}
+
+/* ============================================================
+ * Host Candidates
+ * ============================================================ */
+
+/* Loopback, link-local and unspecified addresses never reach a peer */
+static int usable_host_ip(uint32_t ip_net) {
+    uint32_t ip = ntohl(ip_net);
+    if (ip == 0) return 0;
+    if ((ip >> 24) == 127) return 0;
+    if ((ip >> 16) == 0xA9FE) return 0;
+    return 1;
+}
+
+static size_t add_host(cyxchat_ice_candidate_t *out, size_t n, size_t max,
+                       uint32_t ip, uint16_t port) {
+    if (n >= max || !usable_host_ip(ip)) return n;
+    for (size_t i = 0; i < n; i++) {
+        if (out[i].ip == ip) return n;
+    }
+    out[n].type = CYXCHAT_ICE_HOST;
+    out[n].ip = ip;
+    out[n].port = port;
+    return n + 1;
+}
+
+size_t cyxchat_ice_gather_host(
+    cyxchat_ice_candidate_t *out,
+    size_t max,
+    uint16_t port
+) {
+    if (!out || max == 0 || port == 0) return 0;
+
+    size_t n = 0;
+
+#ifdef _WIN32
+    char name[256];
+    if (gethostname(name, sizeof(name)) != 0) return 0;
+
+    struct addrinfo hints, *result = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    if (getaddrinfo(name, NULL, &hints, &result) != 0) return 0;
+
+    for (struct addrinfo *ai = result; ai; ai = ai->ai_next) {
+        struct sockaddr_in *sin = (struct sockaddr_in*)ai->ai_addr;
+        n = add_host(out, n, max, sin->sin_addr.s_addr, port);
+    }
+    freeaddrinfo(result);
+#else
+    struct ifaddrs *ifs = NULL;
+    if (getifaddrs(&ifs) != 0) return 0;
+
+    for (struct ifaddrs *ifa = ifs; ifa; ifa = ifa->ifa_next) {
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != AF_INET) continue;
+        if (!(ifa->ifa_flags & IFF_UP) || (ifa->ifa_flags & IFF_LOOPBACK)) continue;
+        struct sockaddr_in *sin = (struct sockaddr_in*)ifa->ifa_addr;
+        n = add_host(out, n, max, sin->sin_addr.s_addr, port);
+    }
+    freeifaddrs(ifs);
+#endif
+
+    return n;
+}
@@ -0,0 +1,88 @@
+/**
+ * CyxChat Keepalive Implementation
+ *
+ * RFC 4787 asks NATs to hold UDP bindings for two minutes, but many
+ * drop them after 30 s or less and some keep them for hours, so a fixed
+ * interval is either too slow or burns radio wake-ups. The lifetime is
+ * searched the way RFC 5780 section 4.6 describes: leave a binding idle
+ * for a trial period, then ask for a reply on it from another port.
+ * Only the search lives here; netmon runs the STUN exchanges.
+ */
+
+#include <cyxchat/keepalive.h>
+#include <cyxchat/connection.h>
+
+#include <string.h>
+
+/* Lifetime that already earns the longest interval */
+#define KEEPALIVE_ENOUGH_MS \
+    (CYXCHAT_KEEPALIVE_MAX_MS * 100 / CYXCHAT_KEEPALIVE_MARGIN_PCT)
+
+/* ============================================================
+ * Search
+ * ============================================================ */
+
+static uint32_t interval_for(uint32_t lifetime_ms)
+{
+    uint32_t ms = (uint32_t)((uint64_t)lifetime_ms * CYXCHAT_KEEPALIVE_MARGIN_PCT / 100);
+    if (ms < CYXCHAT_KEEPALIVE_MIN_MS) ms = CYXCHAT_KEEPALIVE_MIN_MS;
+    if (ms > CYXCHAT_KEEPALIVE_MAX_MS) ms = CYXCHAT_KEEPALIVE_MAX_MS;
+    return ms;
+}
+
+void cyxchat_keepalive_init(cyxchat_keepalive_t *ka)
+{
+    if (!ka) return;
+    memset(ka, 0, sizeof(*ka));
+    ka->trial_ms = CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS;
+    ka->interval_ms = CYXCHAT_KEEPALIVE_INTERVAL_MS;
+}
+
+void cyxchat_keepalive_on_trial(cyxchat_keepalive_t *ka, int alive)
+{
+    if (!ka || ka->trial_ms == 0) return;
+
+    ka->trials++;
+    if (alive) {
+        ka->alive_ms = ka->trial_ms;
+        if (interval_for(ka->alive_ms) > ka->interval_ms) {
+            ka->interval_ms = interval_for(ka->alive_ms);
+        }
+    } else {
+        ka->dead_ms = ka->trial_ms;
+        if (interval_for(ka->dead_ms) < ka->interval_ms) {
+            ka->interval_ms = interval_for(ka->dead_ms);
+        }
+    }
+
+    if (ka->dead_ms == 0) {
+        if (ka->alive_ms >= KEEPALIVE_ENOUGH_MS) {
+            ka->trial_ms = 0;
+            return;
+        }
+        ka->trial_ms = ka->alive_ms * 2;
+        if (ka->trial_ms > KEEPALIVE_ENOUGH_MS) ka->trial_ms = KEEPALIVE_ENOUGH_MS;
+        return;
+    }
+
+    if (ka->dead_ms - ka->alive_ms <= CYXCHAT_KEEPALIVE_RESOLUTION_MS) {
+        ka->trial_ms = 0;
+        ka->interval_ms = interval_for(ka->alive_ms);
+        return;
+    }
+    ka->trial_ms = ka->alive_ms + (ka->dead_ms - ka->alive_ms) / 2;
+}
+
+void cyxchat_keepalive_unsupported(cyxchat_keepalive_t *ka)
+{
+    if (!ka) return;
+    ka->unsupported = 1;
+    ka->trial_ms = 0;
+}
+
+uint32_t cyxchat_keepalive_window_ms(const cyxchat_keepalive_t *ka, uint32_t random)
+{
+    uint32_t interval = ka ? ka->interval_ms : CYXCHAT_KEEPALIVE_INTERVAL_MS;
+    uint32_t jitter = interval * CYXCHAT_KEEPALIVE_JITTER_PCT / 100;
+    return interval - random % (jitter + 1);
+}
@@ -0,0 +1,737 @@
+/**
+ * CyxChat Label Switching Implementation
+ *
+ * The table is one allocation: the struct, a power-of-two array of
+ * entries, then the circuits of the paths we build. A label's low bits
+ * are its slot, so a lookup is a mask and one compare; the high bits
+ * are drawn at random on every allocation. Freed slots rest before
+ * reuse so that late packets for an old path are dropped instead of
+ * landing on a new one.
+ *
+ * A layer is sealed ChaCha20-Poly1305 style: the first keystream block
+ * for its nonce keys a BLAKE2b MAC, the rest encrypts the body, so a
+ * hop key is never used directly by two primitives.
+ */
+
+#include <cyxchat/label.h>
+#include <cyxchat/config.h>
+#include <cyxchat/rng.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+struct cyxchat_label_table {
+    cyxchat_label_entry_t *entries;     /* Carved after the struct */
+    cyxchat_label_circuit_t *circuits;  /* Carved after the entries */
+    size_t circuit_count;
+    size_t capacity;
+    uint16_t mask;                      /* capacity - 1 */
+    uint8_t slot_bits;
+    size_t count;                       /* Entries not FREE */
+    size_t cursor;                      /* Next slot alloc tries */
+    size_t footprint;
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static void put_u16(uint8_t *buf, uint16_t v)
+{
+    buf[0] = (uint8_t)(v & 0xFF);
+    buf[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static void put_u32(uint8_t *buf, uint32_t v)
+{
+    buf[0] = (uint8_t)(v & 0xFF);
+    buf[1] = (uint8_t)((v >> 8) & 0xFF);
+    buf[2] = (uint8_t)((v >> 16) & 0xFF);
+    buf[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+/* Nonce: direction, then the full sequence number */
+#define LABEL_DIR_FWD   0
+#define LABEL_DIR_BACK  1
+#define LABEL_NONCE_SIZE 12
+
+static void layer_nonce(uint8_t *nonce, uint8_t dir, uint32_t seq)
+{
+    memset(nonce, 0, LABEL_NONCE_SIZE);
+    nonce[0] = dir;
+    put_u32(nonce + 1, seq);
+}
+
+/* MAC over the wire sequence number and the ciphertext */
+static void layer_mac(const uint8_t *key, uint8_t dir, uint32_t seq,
+                      const uint8_t *layer, size_t len, uint8_t *mac_out)
+{
+#ifdef CYXWIZ_HAS_CRYPTO
+    uint8_t nonce[LABEL_NONCE_SIZE];
+    uint8_t mac_key[CYXCHAT_LABEL_KEY_SIZE];
+
+    layer_nonce(nonce, dir, seq);
+    crypto_stream_chacha20_ietf(mac_key, sizeof(mac_key), nonce, key);
+    crypto_generichash(mac_out, CYXCHAT_LABEL_MAC_SIZE, layer, len, mac_key, sizeof(mac_key));
+    cyxwiz_secure_zero(mac_key, sizeof(mac_key));
+#else
+    (void)key;
+    (void)dir;
+    (void)seq;
+    (void)layer;
+    (void)len;
+    memset(mac_out, 0, CYXCHAT_LABEL_MAC_SIZE);
+#endif
+}
+
+/* Body keystream starts at block 1; block 0 keyed the MAC */
+static void layer_xor(const uint8_t *key, uint8_t dir, uint32_t seq, uint8_t *body, size_t len)
+{
+#ifdef CYXWIZ_HAS_CRYPTO
+    uint8_t nonce[LABEL_NONCE_SIZE];
+
+    layer_nonce(nonce, dir, seq);
+    crypto_stream_chacha20_ietf_xor_ic(body, body, len, nonce, 1, key);
+#else
+    (void)key;
+    (void)dir;
+    (void)seq;
+    (void)body;
+    (void)len;
+#endif
+}
+
+/* Layer at `layer`: sequence, body of body_len, MAC */
+static void layer_seal(const uint8_t *key, uint8_t dir, uint32_t seq,
+                       uint8_t *layer, size_t body_len)
+{
+    put_u16(layer, (uint16_t)seq);
+    layer_xor(key, dir, seq, layer + CYXCHAT_LABEL_SEQ_SIZE, body_len);
+    layer_mac(key, dir, seq, layer, CYXCHAT_LABEL_SEQ_SIZE + body_len,
+              layer + CYXCHAT_LABEL_SEQ_SIZE + body_len);
+}
+
+/* Constant-time compare: a forger learns nothing from timing */
+static int mac_equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= (uint8_t)(a[i] ^ b[i]);
+    }
+    return diff == 0;
+}
+
+/* Check the MAC, then decrypt the body; nothing changes on a forgery */
+static int layer_open(const uint8_t *key, uint8_t dir, uint32_t seq,
+                      uint8_t *layer, size_t body_len)
+{
+    uint8_t mac[CYXCHAT_LABEL_MAC_SIZE];
+    layer_mac(key, dir, seq, layer, CYXCHAT_LABEL_SEQ_SIZE + body_len, mac);
+    if (!mac_equal(mac, layer + CYXCHAT_LABEL_SEQ_SIZE + body_len, sizeof(mac))) {
+        return 0;
+    }
+    layer_xor(key, dir, seq, layer + CYXCHAT_LABEL_SEQ_SIZE, body_len);
+    return 1;
+}
+
+/* Full sequence number nearest the highest one accepted */
+static uint32_t expand_seq(const cyxchat_label_entry_t *e, uint16_t seq16)
+{
+    if (!e->recv_any) {
+        return seq16;
+    }
+
+    uint32_t seq = (e->recv_seq & 0xFFFF0000u) | seq16;
+    int32_t diff = (int32_t)(seq - e->recv_seq);
+    if (diff > 0x8000) {
+        seq -= 0x10000;
+    } else if (diff < -0x8000) {
+        seq += 0x10000;
+    }
+    return seq;
+}
+
+/* ============================================================
+ * Table
+ * ============================================================ */
+
+/* Table, its entries and circuits; arg is the capacity */
+static void* table_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    size_t capacity = *(const size_t*)arg;
+    cyxchat_label_table_t *t = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_label_table_t));
+    cyxchat_label_entry_t *entries = cyxchat_arena_carve(arena, capacity,
+                                                         sizeof(cyxchat_label_entry_t));
+    size_t circuit_count = capacity < CYXCHAT_LABEL_CIRCUITS ? capacity : CYXCHAT_LABEL_CIRCUITS;
+    cyxchat_label_circuit_t *circuits = cyxchat_arena_carve(arena, circuit_count,
+                                                            sizeof(cyxchat_label_circuit_t));
+    if (t) {
+        t->entries = entries;
+        t->circuits = circuits;
+        t->circuit_count = circuit_count;
+        t->capacity = capacity;
+        t->mask = (uint16_t)(capacity - 1);
+        while (((size_t)1 << t->slot_bits) < capacity) {
+            t->slot_bits++;
+        }
+        t->footprint = arena->size;
+    }
+    return t;
+}
+
+cyxchat_error_t cyxchat_label_table_create(cyxchat_label_table_t **table, size_t capacity)
+{
+    if (!table) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (capacity < 2 || capacity > CYXCHAT_LABEL_TABLE_MAX || (capacity & (capacity - 1))) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    *table = cyxchat_arena_build(table_layout, &capacity);
+    if (!*table) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    return CYXCHAT_OK;
+}
+
+void cyxchat_label_table_destroy(cyxchat_label_table_t *table)
+{
+    if (!table) return;
+
+    cyxwiz_secure_zero(table, table->footprint);
+    free(table);
+}
+
+cyxchat_label_entry_t* cyxchat_label_alloc(cyxchat_label_table_t *table, uint64_t now_ms)
+{
+    if (!table) return NULL;
+
+    for (size_t i = 0; i < table->capacity; i++) {
+        size_t slot = (table->cursor + i) & table->mask;
+        cyxchat_label_entry_t *e = &table->entries[slot];
+        if (e->state != CYXCHAT_LABEL_FREE || e->deadline > now_ms) {
+            continue;
+        }
+
+        /* Random high bits, never zero and never the slot's last label */
+        uint16_t high_max = (uint16_t)((1u << (16 - table->slot_bits)) - 1);
+        uint16_t label;
+        do {
+            uint16_t r;
+            cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&r, sizeof(r));
+            uint16_t high = (uint16_t)(1 + r % high_max);
+            label = (uint16_t)((high << table->slot_bits) | slot);
+        } while (label == e->label_in && high_max > 1);
+
+        memset(e, 0, sizeof(cyxchat_label_entry_t));
+        e->label_in = label;
+        e->state = CYXCHAT_LABEL_RESERVED;
+        e->last_used = now_ms;
+        e->deadline = now_ms + CYXCHAT_LABEL_SETUP_MS;
+
+        table->cursor = slot + 1;
+        table->count++;
+        return e;
+    }
+
+    return NULL;
+}
+
+cyxchat_label_entry_t* cyxchat_label_lookup(cyxchat_label_table_t *table, uint16_t label)
+{
+    if (!table || label == 0) return NULL;
+
+    cyxchat_label_entry_t *e = &table->entries[label & table->mask];
+    if (e->state == CYXCHAT_LABEL_FREE || e->label_in != label) {
+        return NULL;
+    }
+    return e;
+}
+
+void cyxchat_label_free(cyxchat_label_table_t *table, cyxchat_label_entry_t *entry,
+                        uint64_t now_ms)
+{
+    if (!table || !entry || entry->state == CYXCHAT_LABEL_FREE) return;
+
+    if (entry->circuit) {
+        cyxwiz_secure_zero(entry->circuit, sizeof(cyxchat_label_circuit_t));
+    }
+
+    /* Keep the label so the next allocation of this slot differs */
+    uint16_t label = entry->label_in;
+    cyxwiz_secure_zero(entry, sizeof(cyxchat_label_entry_t));
+    entry->label_in = label;
+
+    uint16_t r;
+    cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&r, sizeof(r));
+    entry->deadline = now_ms + CYXCHAT_LABEL_REUSE_MS + r % CYXCHAT_LABEL_REUSE_JITTER;
+
+    table->count--;
+}
+
+cyxchat_label_entry_t* cyxchat_label_at(cyxchat_label_table_t *table, size_t index)
+{
+    if (!table || index >= table->capacity) return NULL;
+    return &table->entries[index];
+}
+
+size_t cyxchat_label_capacity(const cyxchat_label_table_t *table)
+{
+    return table ? table->capacity : 0;
+}
+
+size_t cyxchat_label_count(const cyxchat_label_table_t *table)
+{
+    return table ? table->count : 0;
+}
+
+cyxchat_label_circuit_t* cyxchat_label_circuit_alloc(cyxchat_label_table_t *table,
+                                                     cyxchat_label_entry_t *entry)
+{
+    if (!table || !entry) return NULL;
+
+    for (size_t i = 0; i < table->circuit_count; i++) {
+        cyxchat_label_circuit_t *c = &table->circuits[i];
+        if (!c->in_use) {
+            memset(c, 0, sizeof(cyxchat_label_circuit_t));
+            c->in_use = 1;
+            entry->circuit = c;
+            return c;
+        }
+    }
+    return NULL;
+}
+
+/* ============================================================
+ * Keys
+ * ============================================================ */
+
+void cyxchat_label_keypair(uint8_t *public_out, uint8_t *secret_out)
+{
+    if (!public_out || !secret_out) return;
+
+    cyxchat_rng_bytes(cyxchat_rng_default(), secret_out, CYXCHAT_LABEL_KEY_SIZE);
+#ifdef CYXWIZ_HAS_CRYPTO
+    crypto_scalarmult_base(public_out, secret_out);
+#else
+    memset(public_out, 0, CYXCHAT_LABEL_KEY_SIZE);
+#endif
+}
+
+cyxchat_error_t cyxchat_label_identity(uint8_t *secret_out, const uint8_t *signing_key)
+{
+    if (!secret_out || !signing_key) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    if (crypto_sign_ed25519_sk_to_curve25519(secret_out, signing_key) != 0) {
+        return CYXCHAT_ERR_CRYPTO;
+    }
+#else
+    memset(secret_out, 0, CYXCHAT_LABEL_KEY_SIZE);
+#endif
+    return CYXCHAT_OK;
+}
+
+#ifdef CYXWIZ_HAS_CRYPTO
+/*
+ * Key and confirmation from both exchanges and the whole transcript:
+ * the static one proves who answered, the ephemeral one makes the key
+ * forgettable once the path is gone.
+ */
+static void handshake_keys(uint8_t *key_out, uint8_t *auth_out,
+                           const uint8_t *dh_static, const uint8_t *dh_eph,
+                           const cyxwiz_node_id_t *hop, const uint8_t *init_public,
+                           const uint8_t *hop_public, uint32_t req_id)
+{
+    uint8_t req_le[4];
+    uint8_t out[CYXCHAT_LABEL_KEY_SIZE * 2];
+    crypto_generichash_state st;
+
+    put_u32(req_le, req_id);
+    crypto_generichash_init(&st, NULL, 0, sizeof(out));
+    crypto_generichash_update(&st, dh_static, CYXCHAT_LABEL_KEY_SIZE);
+    crypto_generichash_update(&st, dh_eph, CYXCHAT_LABEL_KEY_SIZE);
+    crypto_generichash_update(&st, hop->bytes, sizeof(hop->bytes));
+    crypto_generichash_update(&st, init_public, CYXCHAT_LABEL_KEY_SIZE);
+    crypto_generichash_update(&st, hop_public, CYXCHAT_LABEL_KEY_SIZE);
+    crypto_generichash_update(&st, req_le, sizeof(req_le));
+    crypto_generichash_final(&st, out, sizeof(out));
+
+    memcpy(key_out, out, CYXCHAT_LABEL_KEY_SIZE);
+    memcpy(auth_out, out + CYXCHAT_LABEL_KEY_SIZE, CYXCHAT_LABEL_AUTH_SIZE);
+    cyxwiz_secure_zero(out, sizeof(out));
+}
+#endif
+
+cyxchat_error_t cyxchat_label_accept(uint8_t *key_out, uint8_t *eph_public_out,
+                                     uint8_t *auth_out, const uint8_t *static_secret,
+                                     const cyxwiz_node_id_t *local_id,
+                                     const uint8_t *peer_public, uint32_t req_id)
+{
+    if (!key_out || !eph_public_out || !auth_out || !static_secret || !local_id ||
+        !peer_public) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    uint8_t eph_secret[CYXCHAT_LABEL_KEY_SIZE];
+    uint8_t dh_static[CYXCHAT_LABEL_KEY_SIZE], dh_eph[CYXCHAT_LABEL_KEY_SIZE];
+    cyxchat_error_t err = CYXCHAT_OK;
+
+    cyxchat_label_keypair(eph_public_out, eph_secret);
+    if (crypto_scalarmult(dh_static, static_secret, peer_public) != 0 ||
+        crypto_scalarmult(dh_eph, eph_secret, peer_public) != 0) {
+        err = CYXCHAT_ERR_CRYPTO;
+    } else {
+        handshake_keys(key_out, auth_out, dh_static, dh_eph, local_id, peer_public,
+                       eph_public_out, req_id);
+    }
+    cyxwiz_secure_zero(eph_secret, sizeof(eph_secret));
+    cyxwiz_secure_zero(dh_static, sizeof(dh_static));
+    cyxwiz_secure_zero(dh_eph, sizeof(dh_eph));
+    return err;
+#else
+    (void)static_secret;
+    (void)local_id;
+    (void)peer_public;
+    (void)req_id;
+    memset(key_out, 0, CYXCHAT_LABEL_KEY_SIZE);
+    memset(eph_public_out, 0, CYXCHAT_LABEL_KEY_SIZE);
+    memset(auth_out, 0, CYXCHAT_LABEL_AUTH_SIZE);
+    return CYXCHAT_OK;
+#endif
+}
+
+cyxchat_error_t cyxchat_label_complete(uint8_t *key_out, const uint8_t *eph_secret,
+                                       const cyxwiz_node_id_t *hop, const uint8_t *hop_public,
+                                       const uint8_t *auth, uint32_t req_id)
+{
+    if (!key_out || !eph_secret || !hop || !hop_public || !auth) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    uint8_t static_public[CYXCHAT_LABEL_KEY_SIZE], eph_public[CYXCHAT_LABEL_KEY_SIZE];
+    uint8_t dh_static[CYXCHAT_LABEL_KEY_SIZE], dh_eph[CYXCHAT_LABEL_KEY_SIZE];
+    uint8_t expect[CYXCHAT_LABEL_AUTH_SIZE];
+    cyxchat_error_t err = CYXCHAT_ERR_CRYPTO;
+
+    /* The node ID is the hop's Ed25519 key; its X25519 twin is the static key */
+    if (crypto_sign_ed25519_pk_to_curve25519(static_public, hop->bytes) == 0 &&
+        crypto_scalarmult_base(eph_public, eph_secret) == 0 &&
+        crypto_scalarmult(dh_static, eph_secret, static_public) == 0 &&
+        crypto_scalarmult(dh_eph, eph_secret, hop_public) == 0) {
+        handshake_keys(key_out, expect, dh_static, dh_eph, hop, eph_public, hop_public,
+                       req_id);
+        if (mac_equal(expect, auth, sizeof(expect))) {
+            err = CYXCHAT_OK;
+        } else {
+            cyxwiz_secure_zero(key_out, CYXCHAT_LABEL_KEY_SIZE);
+        }
+    }
+    cyxwiz_secure_zero(dh_static, sizeof(dh_static));
+    cyxwiz_secure_zero(dh_eph, sizeof(dh_eph));
+    return err;
+#else
+    (void)eph_secret;
+    (void)hop;
+    (void)hop_public;
+    (void)auth;
+    (void)req_id;
+    memset(key_out, 0, CYXCHAT_LABEL_KEY_SIZE);
+    return CYXCHAT_OK;
+#endif
+}
+
+/* ============================================================
+ * Data Path
+ * ============================================================ */
+
+size_t cyxchat_label_seal(cyxchat_label_entry_t *entry, uint8_t cmd,
+                          const uint8_t *payload, size_t len, uint8_t *pkt, size_t pkt_size)
+{
+    if (!entry || !entry->circuit || !pkt || (!payload && len > 0)) {
+        return 0;
+    }
+
+    cyxchat_label_circuit_t *c = entry->circuit;
+    size_t hops = c->hop_count;
+    size_t total = CYXCHAT_LABEL_OVERHEAD(hops) + len;
+    if (hops == 0 || pkt_size < CYXCHAT_LABEL_OVERHEAD(hops) ||
+        len > pkt_size - CYXCHAT_LABEL_OVERHEAD(hops)) {
+        return 0;
+    }
+
+    pkt[0] = CYXCHAT_MSG_LABEL_DATA;
+    put_u16(pkt + 1, entry->label_out);
+
+    /* Innermost first: the last hop's layer sits deepest */
+    size_t inner = CYXCHAT_LABEL_HEADER_SIZE + hops * CYXCHAT_LABEL_SEQ_SIZE;
+    pkt[inner] = cmd;
+    if (len > 0) {
+        memcpy(pkt + inner + 1, payload, len);
+    }
+
+    for (size_t i = hops; i-- > 0; ) {
+        size_t start = CYXCHAT_LABEL_HEADER_SIZE + i * CYXCHAT_LABEL_SEQ_SIZE;
+        size_t end = total - i * CYXCHAT_LABEL_MAC_SIZE - CYXCHAT_LABEL_MAC_SIZE;
+        layer_seal(c->keys[i], LABEL_DIR_FWD, c->send_seq[i]++, pkt + start,
+                   end - start - CYXCHAT_LABEL_SEQ_SIZE);
+    }
+    return total;
+}
+
+cyxchat_error_t cyxchat_label_open(cyxchat_label_table_t *table, const cyxwiz_node_id_t *from,
+                                   uint8_t *pkt, size_t len, uint64_t now_ms,
+                                   cyxchat_label_entry_t **entry_out)
+{
+    if (!table || !from || !pkt || !entry_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len < CYXCHAT_LABEL_OVERHEAD(1)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    /* Unknown labels, strangers and torn-down paths all drop the same way */
+    cyxchat_label_entry_t *e = cyxchat_label_lookup(table, get_u16(pkt + 1));
+    if (!e || e->state != CYXCHAT_LABEL_ACTIVE || e->role == CYXCHAT_LABEL_INGRESS ||
+        memcmp(&e->prev_hop, from, sizeof(cyxwiz_node_id_t)) != 0) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    /* Replay window, then MAC, then record: a forgery moves nothing */
+    uint8_t *layer = pkt + CYXCHAT_LABEL_HEADER_SIZE;
+    uint32_t seq = expand_seq(e, get_u16(layer));
+    int32_t age = (int32_t)(e->recv_seq - seq);
+    if (e->recv_any && age >= 0 &&
+        (age >= CYXCHAT_LABEL_WINDOW || (e->recv_window & ((uint64_t)1 << age)))) {
+        return CYXCHAT_ERR_CRYPTO;
+    }
+
+    if (!layer_open(e->key_in, LABEL_DIR_FWD, seq, layer,
+                    len - CYXCHAT_LABEL_HEADER_SIZE - CYXCHAT_LABEL_LAYER_SIZE)) {
+        return CYXCHAT_ERR_CRYPTO;
+    }
+
+    if (!e->recv_any) {
+        e->recv_seq = seq;
+        e->recv_window = 1;
+        e->recv_any = 1;
+    } else if (age < 0) {
+        uint32_t shift = (uint32_t)(-age);
+        e->recv_window = shift >= CYXCHAT_LABEL_WINDOW ? 0 : e->recv_window << shift;
+        e->recv_window |= 1;
+        e->recv_seq = seq;
+    } else {
+        e->recv_window |= (uint64_t)1 << age;
+    }
+    e->last_used = now_ms;
+
+    *entry_out = e;
+    return CYXCHAT_OK;
+}
+
+size_t cyxchat_label_swap(cyxchat_label_entry_t *entry, uint8_t *pkt, size_t len)
+{
+    if (!entry || !pkt || len < CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_LAYER_SIZE) {
+        return 0;
+    }
+
+    /* Our sequence number and MAC go; the next layer follows the header */
+    size_t body = len - CYXCHAT_LABEL_HEADER_SIZE - CYXCHAT_LABEL_LAYER_SIZE;
+    memmove(pkt + CYXCHAT_LABEL_HEADER_SIZE,
+            pkt + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE, body);
+    put_u16(pkt + 1, entry->label_out);
+    return CYXCHAT_LABEL_HEADER_SIZE + body;
+}
+
+size_t cyxchat_label_seal_back(cyxchat_label_entry_t *entry, const uint8_t *inner, size_t len,
+                               uint8_t *pkt, size_t pkt_size)
+{
+    if (!entry || !pkt || (!inner && len > 0) ||
+        pkt_size < CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_LAYER_SIZE ||
+        len > pkt_size - CYXCHAT_LABEL_HEADER_SIZE - CYXCHAT_LABEL_LAYER_SIZE) {
+        return 0;
+    }
+
+    pkt[0] = CYXCHAT_MSG_LABEL_BACK;
+    put_u16(pkt + 1, entry->label_in);
+    if (len > 0) {
+        memmove(pkt + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE, inner, len);
+    }
+
+    /* A path sends back a handful of answers, so the wire sequence is the nonce */
+    uint16_t seq = (uint16_t)entry->send_seq++;
+    layer_seal(entry->key_in, LABEL_DIR_BACK, seq, pkt + CYXCHAT_LABEL_HEADER_SIZE, len);
+    return CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_LAYER_SIZE + len;
+}
+
+cyxchat_error_t cyxchat_label_open_back(const cyxchat_label_entry_t *entry,
+                                        uint8_t *pkt, size_t len,
+                                        const uint8_t **inner_out, size_t *inner_len_out)
+{
+    if (!entry || !entry->circuit || !pkt || !inner_out || !inner_len_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    const cyxchat_label_circuit_t *c = entry->circuit;
+    size_t hops = c->hop_count;
+    if (hops == 0 || len < CYXCHAT_LABEL_HEADER_SIZE + hops * CYXCHAT_LABEL_LAYER_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    /* The nearest hop's layer is outermost */
+    size_t start = CYXCHAT_LABEL_HEADER_SIZE;
+    size_t end = len;
+    for (size_t i = 0; i < hops; i++) {
+        size_t body = end - start - CYXCHAT_LABEL_LAYER_SIZE;
+        if (!layer_open(c->keys[i], LABEL_DIR_BACK, get_u16(pkt + start), pkt + start, body)) {
+            return CYXCHAT_ERR_CRYPTO;
+        }
+        start += CYXCHAT_LABEL_SEQ_SIZE;
+        end -= CYXCHAT_LABEL_MAC_SIZE;
+    }
+
+    *inner_out = pkt + start;
+    *inner_len_out = end - start;
+    return CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Setup Encoding
+ * ============================================================ */
+
+size_t cyxchat_label_encode_request(const cyxchat_label_request_t *req,
+                                    uint8_t *buf, size_t buf_size)
+{
+    if (!req || !buf || buf_size < CYXCHAT_LABEL_REQUEST_SIZE) return 0;
+
+    buf[0] = CYXCHAT_MSG_LABEL_REQUEST;
+    put_u32(buf + 1, req->req_id);
+    memcpy(buf + 5, req->eph_public, CYXCHAT_LABEL_KEY_SIZE);
+    return CYXCHAT_LABEL_REQUEST_SIZE;
+}
+
+cyxchat_error_t cyxchat_label_decode_request(const uint8_t *buf, size_t len,
+                                             cyxchat_label_request_t *req_out)
+{
+    if (!buf || !req_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len != CYXCHAT_LABEL_REQUEST_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    req_out->req_id = get_u32(buf + 1);
+    memcpy(req_out->eph_public, buf + 5, CYXCHAT_LABEL_KEY_SIZE);
+    return CYXCHAT_OK;
+}
+
+size_t cyxchat_label_encode_mapping(const cyxchat_label_mapping_t *map,
+                                    uint8_t *buf, size_t buf_size)
+{
+    if (!map || !buf || buf_size < CYXCHAT_LABEL_MAPPING_SIZE) return 0;
+
+    buf[0] = CYXCHAT_MSG_LABEL_MAPPING;
+    put_u32(buf + 1, map->req_id);
+    put_u16(buf + 5, map->label);
+    memcpy(buf + 7, map->eph_public, CYXCHAT_LABEL_KEY_SIZE);
+    memcpy(buf + 39, map->auth, CYXCHAT_LABEL_AUTH_SIZE);
+    return CYXCHAT_LABEL_MAPPING_SIZE;
+}
+
+cyxchat_error_t cyxchat_label_decode_mapping(const uint8_t *buf, size_t len,
+                                             cyxchat_label_mapping_t *map_out)
+{
+    if (!buf || !map_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len != CYXCHAT_LABEL_MAPPING_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    map_out->req_id = get_u32(buf + 1);
+    map_out->label = get_u16(buf + 5);
+    memcpy(map_out->eph_public, buf + 7, CYXCHAT_LABEL_KEY_SIZE);
+    memcpy(map_out->auth, buf + 39, CYXCHAT_LABEL_AUTH_SIZE);
+    return CYXCHAT_OK;
+}
+
+size_t cyxchat_label_encode_extend(const cyxchat_label_extend_t *ext,
+                                   uint8_t *buf, size_t buf_size)
+{
+    if (!ext || !buf || buf_size < CYXCHAT_LABEL_EXTEND_SIZE) return 0;
+
+    buf[0] = CYXCHAT_LABEL_CMD_EXTEND;
+    memcpy(buf + 1, ext->next_hop.bytes, sizeof(ext->next_hop.bytes));
+    put_u32(buf + 33, ext->req_id);
+    memcpy(buf + 37, ext->eph_public, CYXCHAT_LABEL_KEY_SIZE);
+    return CYXCHAT_LABEL_EXTEND_SIZE;
+}
+
+cyxchat_error_t cyxchat_label_decode_extend(const uint8_t *buf, size_t len,
+                                            cyxchat_label_extend_t *ext_out)
+{
+    if (!buf || !ext_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len != CYXCHAT_LABEL_EXTEND_SIZE || buf[0] != CYXCHAT_LABEL_CMD_EXTEND) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    memcpy(ext_out->next_hop.bytes, buf + 1, sizeof(ext_out->next_hop.bytes));
+    ext_out->req_id = get_u32(buf + 33);
+    memcpy(ext_out->eph_public, buf + 37, CYXCHAT_LABEL_KEY_SIZE);
+    return CYXCHAT_OK;
+}
+
+size_t cyxchat_label_encode_extended(const cyxchat_label_mapping_t *map,
+                                     uint8_t *buf, size_t buf_size)
+{
+    if (!map || !buf || buf_size < CYXCHAT_LABEL_EXTENDED_SIZE) return 0;
+
+    buf[0] = CYXCHAT_LABEL_CMD_EXTENDED;
+    put_u32(buf + 1, map->req_id);
+    memcpy(buf + 5, map->eph_public, CYXCHAT_LABEL_KEY_SIZE);
+    memcpy(buf + 37, map->auth, CYXCHAT_LABEL_AUTH_SIZE);
+    return CYXCHAT_LABEL_EXTENDED_SIZE;
+}
+
+cyxchat_error_t cyxchat_label_decode_extended(const uint8_t *buf, size_t len,
+                                              cyxchat_label_mapping_t *map_out)
+{
+    if (!buf || !map_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len != CYXCHAT_LABEL_EXTENDED_SIZE || buf[0] != CYXCHAT_LABEL_CMD_EXTENDED) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    map_out->req_id = get_u32(buf + 1);
+    map_out->label = 0;
+    memcpy(map_out->eph_public, buf + 5, CYXCHAT_LABEL_KEY_SIZE);
+    memcpy(map_out->auth, buf + 37, CYXCHAT_LABEL_AUTH_SIZE);
+    return CYXCHAT_OK;
+}
@@ -0,0 +1,189 @@
+/**
+ * CyxChat Link Statistics Implementation
+ *
+ * Round trip smoothing follows RFC 6298 (alpha 1/8, beta 1/4, RTO =
+ * SRTT + 4 * RTTVAR clamped to [RTO_MIN, RTO_MAX]). Loss is an EWMA
+ * (gain 1/16) over per-packet outcomes, fed from receive sequence gaps
+ * and from probes that never got a reply. Rates are bytes per closed
+ * window, smoothed with gain 1/8.
+ */
+
+#include <cyxchat/linkstats.h>
+
+#include <string.h>
+
+#define LINK_LOSS_ONE       1000000u    /* One packet lost, in ppm */
+#define LINK_LOSS_SHIFT     4           /* EWMA gain 1/16 */
+#define LINK_RATE_RESET     8           /* Windows idle before rate restarts */
+
+/* ============================================================
+ * Helpers
+ * ============================================================ */
+
+static void loss_sample(cyxchat_linkstats_t *ls, uint32_t sample_ppm)
+{
+    int64_t diff = (int64_t)sample_ppm - (int64_t)ls->loss_ppm;
+    ls->loss_ppm = (uint32_t)((int64_t)ls->loss_ppm + diff / (1 << LINK_LOSS_SHIFT));
+}
+
+/* Close a rate window once it has run its length */
+static void rate_window(uint64_t *rate, uint64_t *start, uint64_t *bytes, uint64_t now_ms)
+{
+    if (*start == 0) {
+        *start = now_ms;
+        return;
+    }
+
+    uint64_t elapsed = now_ms - *start;
+    if (elapsed < CYXCHAT_LINK_RATE_WINDOW_MS) return;
+
+    uint64_t sample = *bytes * 1000 / elapsed;
+    if (*rate == 0 || elapsed >= LINK_RATE_RESET * CYXCHAT_LINK_RATE_WINDOW_MS) {
+        *rate = sample;
+    } else {
+        *rate = (*rate * 7 + sample) / 8;
+    }
+
+    *start = now_ms;
+    *bytes = 0;
+}
+
+/* ============================================================
+ * Link Statistics
+ * ============================================================ */
+
+void cyxchat_linkstats_init(cyxchat_linkstats_t *ls)
+{
+    if (!ls) return;
+    memset(ls, 0, sizeof(*ls));
+    ls->rto_ms = CYXCHAT_LINK_RTO_INITIAL_MS;
+}
+
+void cyxchat_linkstats_reset_path(cyxchat_linkstats_t *ls)
+{
+    if (!ls) return;
+
+    ls->srtt_ms = 0;
+    ls->rttvar_ms = 0;
+    ls->rto_ms = CYXCHAT_LINK_RTO_INITIAL_MS;
+    ls->min_rtt_ms = 0;
+    ls->latest_rtt_ms = 0;
+    ls->rtt_samples = 0;
+    ls->loss_ppm = 0;
+    ls->probes_missed = 0;
+    ls->seq_started = 0;
+    ls->seq_seen = 0;
+}
+
+void cyxchat_linkstats_on_send(cyxchat_linkstats_t *ls, size_t bytes, uint64_t now_ms)
+{
+    if (!ls) return;
+    rate_window(&ls->tx_rate, &ls->tx_window_start, &ls->tx_window_bytes, now_ms);
+    ls->bytes_sent += bytes;
+    ls->packets_sent++;
+    ls->tx_window_bytes += bytes;
+}
+
+void cyxchat_linkstats_on_recv(cyxchat_linkstats_t *ls, size_t bytes, uint64_t now_ms)
+{
+    if (!ls) return;
+    rate_window(&ls->rx_rate, &ls->rx_window_start, &ls->rx_window_bytes, now_ms);
+    ls->bytes_received += bytes;
+    ls->packets_received++;
+    ls->rx_window_bytes += bytes;
+}
+
+void cyxchat_linkstats_on_rtt(cyxchat_linkstats_t *ls, uint32_t rtt_ms)
+{
+    if (!ls) return;
+
+    if (ls->rtt_samples == 0) {
+        ls->srtt_ms = rtt_ms;
+        ls->rttvar_ms = rtt_ms / 2;
+    } else {
+        uint32_t err = ls->srtt_ms > rtt_ms ? ls->srtt_ms - rtt_ms : rtt_ms - ls->srtt_ms;
+        ls->rttvar_ms = (uint32_t)(((uint64_t)ls->rttvar_ms * 3 + err) / 4);
+        ls->srtt_ms = (uint32_t)(((uint64_t)ls->srtt_ms * 7 + rtt_ms) / 8);
+    }
+
+    uint64_t rto = (uint64_t)ls->srtt_ms + 4 * (uint64_t)ls->rttvar_ms;
+    if (rto < CYXCHAT_LINK_RTO_MIN_MS) rto = CYXCHAT_LINK_RTO_MIN_MS;
+    if (rto > CYXCHAT_LINK_RTO_MAX_MS) rto = CYXCHAT_LINK_RTO_MAX_MS;
+    ls->rto_ms = (uint32_t)rto;
+
+    if (ls->rtt_samples == 0 || rtt_ms < ls->min_rtt_ms) {
+        ls->min_rtt_ms = rtt_ms;
+    }
+    ls->latest_rtt_ms = rtt_ms;
+    ls->rtt_samples++;
+}
+
+void cyxchat_linkstats_on_seq(cyxchat_linkstats_t *ls, uint32_t seq)
+{
+    if (!ls) return;
+
+    if (!ls->seq_started) {
+        ls->seq_started = 1;
+        ls->seq_highest = seq;
+        ls->seq_seen = 1;
+        loss_sample(ls, 0);
+        return;
+    }
+
+    int32_t ahead = (int32_t)(seq - ls->seq_highest);
+    if (ahead > 0) {
+        /* Jump: everything skipped is lost until it shows up late */
+        uint32_t gap = (uint32_t)ahead - 1;
+        ls->packets_lost += gap;
+        uint32_t samples = gap < CYXCHAT_LINK_SEQ_WINDOW ? gap : CYXCHAT_LINK_SEQ_WINDOW;
+        for (uint32_t i = 0; i < samples; i++) {
+            loss_sample(ls, LINK_LOSS_ONE);
+        }
+
+        ls->seq_seen = (uint32_t)ahead < CYXCHAT_LINK_SEQ_WINDOW ?
+                       (ls->seq_seen << ahead) | 1 : 1;
+        ls->seq_highest = seq;
+        loss_sample(ls, 0);
+        return;
+    }
+
+    /* Late arrival inside the window takes back its loss; else duplicate */
+    uint32_t behind = ls->seq_highest - seq;
+    if (behind >= CYXCHAT_LINK_SEQ_WINDOW) return;
+
+    uint64_t bit = (uint64_t)1 << behind;
+    if (ls->seq_seen & bit) return;
+
+    ls->seq_seen |= bit;
+    if (ls->packets_lost > 0) {
+        ls->packets_lost--;
+    }
+    loss_sample(ls, 0);
+}
+
+void cyxchat_linkstats_on_probe(cyxchat_linkstats_t *ls, int answered)
+{
+    if (!ls) return;
+
+    if (answered) {
+        ls->probes_missed = 0;
+        loss_sample(ls, 0);
+    } else {
+        ls->probes_missed++;
+        ls->packets_lost++;
+        loss_sample(ls, LINK_LOSS_ONE);
+    }
+}
+
+void cyxchat_linkstats_update(cyxchat_linkstats_t *ls, uint64_t now_ms)
+{
+    if (!ls) return;
+    rate_window(&ls->tx_rate, &ls->tx_window_start, &ls->tx_window_bytes, now_ms);
+    rate_window(&ls->rx_rate, &ls->rx_window_start, &ls->rx_window_bytes, now_ms);
+}
+
+uint32_t cyxchat_linkstats_queue_delay(const cyxchat_linkstats_t *ls)
+{
+    if (!ls || ls->rtt_samples == 0 || ls->srtt_ms < ls->min_rtt_ms) return 0;
+    return ls->srtt_ms - ls->min_rtt_ms;
+}
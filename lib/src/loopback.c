@@ -0,0 +1,1102 @@
+/**
+ * CyxChat Loopback Network Implementation
+ *
+ * Every node is a transport whose datagrams go into the receiving node's
+ * min-heap, keyed by delivery time and then send order, instead of a
+ * socket. poll pops what is due and calls the receive callback, so N
+ * connection contexts can run in one process and one thread. Link state
+ * (bottleneck and FIFO floor) is kept per direction in the sending node.
+ *
+ * Nodes have emulated addresses so NATs can be modelled the way RFC 4787
+ * describes them: a send opens (or refreshes) a binding from the node's
+ * public address to the destination, and a packet arriving at a NAT is
+ * only let in if a live binding's filter admits its source. A node sends
+ * to a peer at the address the rendezvous server saw for it until a
+ * packet from that peer shows another one, which is what the UDP
+ * transport does with bootstrap addresses and punches. Relays are nodes
+ * without a transport that answer the relay protocol themselves.
+ */
+
+#include <cyxchat/loopback.h>
+#include <cyxchat/relay.h>
+#include <cyxchat/trace.h>
+#include <cyxwiz/log.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Relay messages this emulation reads (header layout of relay.c) */
+#define LOOP_RELAY_CONNECT_LEN  (1 + 2 * CYXWIZ_NODE_ID_LEN)
+#define LOOP_RELAY_ACK_LEN      (1 + CYXWIZ_NODE_ID_LEN + 1)
+#define LOOP_RELAY_TO_OFFSET    (1 + CYXWIZ_NODE_ID_LEN)
+
+/* Emulated addressing */
+#define LOOP_OPEN_PORT          4000    /* Port of nodes without NAT */
+#define LOOP_FIRST_NAT_PORT     20000   /* NATs allocate upwards from here */
+
+/* ============================================================
+ * Internal Types
+ * ============================================================ */
+
+/* Address and port in network byte order, as the UDP transport has them */
+typedef struct {
+    uint32_t ip;
+    uint16_t port;
+} loop_ep_t;
+
+typedef struct {
+    uint64_t deliver_us;
+    uint64_t seq;                       /* Send order breaks ties */
+    cyxwiz_node_id_t from;
+    loop_ep_t src;                      /* Source as seen on the wire */
+    uint16_t dst_port;                  /* Port it was sent to */
+    int punch;                          /* Consumed by the transport */
+    size_t len;
+    uint8_t data[];
+} loop_packet_t;
+
+typedef struct {
+    cyxwiz_node_id_t to;
+    cyxchat_loop_link_t cfg;
+    uint64_t busy_until_us;             /* Bottleneck idle again */
+    uint64_t last_deliver_us;           /* FIFO floor for delayed packets */
+    loop_ep_t remote;                   /* Learned from the peer's packets */
+    int learned;
+} loop_link_state_t;
+
+typedef struct {
+    loop_ep_t dst;                      /* Where the node sent */
+    uint16_t ext_port;                  /* Public port used for it */
+    uint64_t expires_us;
+} loop_binding_t;
+
+typedef struct {
+    cyxwiz_node_id_t from;
+    cyxwiz_node_id_t to;
+    cyxchat_loop_link_t cfg;
+} loop_override_t;
+
+typedef struct {
+    cyxwiz_transport_t transport;       /* First: the transport is the node */
+    cyxchat_loopnet_t *net;
+    int discovering;
+    int relay;                          /* Emulated relay server, no transport */
+
+    loop_packet_t **heap;               /* Inbound, earliest first */
+    size_t heap_len;
+    size_t heap_cap;
+
+    loop_link_state_t *links;           /* Outbound, one per destination */
+    size_t link_count;
+    size_t link_cap;
+
+    /* Addressing */
+    uint32_t ip;                        /* Public address */
+    loop_ep_t mapped;                   /* As the rendezvous server saw it */
+    int has_mapped;
+
+    /* NAT */
+    cyxchat_loop_nat_t nat;
+    loop_binding_t *bindings;
+    size_t binding_count;
+    size_t binding_cap;
+    uint16_t cone_port;                 /* Shared mapping (not symmetric) */
+    uint16_t next_port;
+} loop_node_t;
+
+struct cyxchat_loopnet {
+    loop_node_t **nodes;                /* In attach order, relays included */
+    size_t node_count;
+    size_t node_cap;
+    size_t transports;
+    uint32_t next_host;
+
+    loop_override_t *overrides;
+    size_t override_count;
+    size_t override_cap;
+    cyxchat_loop_link_t default_link;
+
+    uint64_t rng;
+    uint64_t seq;
+    int manual_clock;
+    uint64_t now_us;
+
+    cyxchat_loop_stats_t stats;
+};
+
+static const cyxwiz_transport_ops_t loop_ops;
+
+/* ============================================================
+ * Helpers
+ * ============================================================ */
+
+static int grow(void **arr, size_t *cap, size_t need, size_t elem)
+{
+    if (need <= *cap) return 1;
+
+    size_t new_cap = *cap ? *cap * 2 : 8;
+    while (new_cap < need) new_cap *= 2;
+
+    void *p = realloc(*arr, new_cap * elem);
+    if (!p) return 0;
+    *arr = p;
+    *cap = new_cap;
+    return 1;
+}
+
+/* splitmix64: cheap, and the same sequence on every platform */
+static uint64_t next_random(cyxchat_loopnet_t *net)
+{
+    uint64_t z = (net->rng += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int chance_ppm(cyxchat_loopnet_t *net, uint32_t ppm)
+{
+    if (ppm == 0) return 0;
+    return next_random(net) % 1000000 < ppm;
+}
+
+static uint64_t clock_us(void)
+{
+#ifdef _WIN32
+    return GetTickCount64() * 1000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+static void sleep_us(uint64_t us)
+{
+#ifdef _WIN32
+    Sleep((DWORD)((us + 999) / 1000));
+#else
+    struct timespec ts;
+    ts.tv_sec = (time_t)(us / 1000000);
+    ts.tv_nsec = (long)(us % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+static uint64_t now_us(cyxchat_loopnet_t *net)
+{
+    if (!net->manual_clock) {
+        net->now_us = clock_us();
+    }
+    return net->now_us;
+}
+
+/* Build network byte order values without the socket headers */
+static uint32_t ip_from_octets(uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+    uint8_t bytes[4] = { a, b, c, d };
+    uint32_t ip;
+    memcpy(&ip, bytes, sizeof(ip));
+    return ip;
+}
+
+static uint16_t port_to_net(uint16_t port)
+{
+    uint8_t bytes[2] = { (uint8_t)(port >> 8), (uint8_t)(port & 0xFF) };
+    uint16_t out;
+    memcpy(&out, bytes, sizeof(out));
+    return out;
+}
+
+static int ep_equal(loop_ep_t a, loop_ep_t b)
+{
+    return a.ip == b.ip && a.port == b.port;
+}
+
+/* Where every node registers; only its bindings matter */
+static loop_ep_t rendezvous_ep(void)
+{
+    loop_ep_t ep;
+    ep.ip = ip_from_octets(192, 0, 2, 1);
+    ep.port = port_to_net(3478);
+    return ep;
+}
+
+static loop_node_t* find_node(cyxchat_loopnet_t *net, const cyxwiz_node_id_t *id)
+{
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (memcmp(&net->nodes[i]->transport.local_id, id, sizeof(*id)) == 0) {
+            return net->nodes[i];
+        }
+    }
+    return NULL;
+}
+
+static loop_node_t* node_by_ip(cyxchat_loopnet_t *net, uint32_t ip)
+{
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (net->nodes[i]->ip == ip) {
+            return net->nodes[i];
+        }
+    }
+    return NULL;
+}
+
+/* Outbound state for one destination, created on first use */
+static loop_link_state_t* link_state(loop_node_t *node, const cyxwiz_node_id_t *to)
+{
+    for (size_t i = 0; i < node->link_count; i++) {
+        if (memcmp(&node->links[i].to, to, sizeof(*to)) == 0) {
+            return &node->links[i];
+        }
+    }
+
+    if (!grow((void**)&node->links, &node->link_cap, node->link_count + 1,
+              sizeof(loop_link_state_t))) {
+        return NULL;
+    }
+
+    cyxchat_loopnet_t *net = node->net;
+    loop_link_state_t *link = &node->links[node->link_count++];
+    memset(link, 0, sizeof(*link));
+    memcpy(&link->to, to, sizeof(*to));
+    link->cfg = net->default_link;
+
+    for (size_t i = 0; i < net->override_count; i++) {
+        loop_override_t *o = &net->overrides[i];
+        if (memcmp(&o->from, &node->transport.local_id, sizeof(o->from)) == 0 &&
+            memcmp(&o->to, to, sizeof(*to)) == 0) {
+            link->cfg = o->cfg;
+            break;
+        }
+    }
+    return link;
+}
+
+/* ============================================================
+ * NAT
+ * ============================================================ */
+
+static int behind_nat(const loop_node_t *node)
+{
+    return !node->relay && node->nat.type != CYXCHAT_LOOP_NAT_NONE;
+}
+
+static int binding_live(const loop_binding_t *b, uint64_t now)
+{
+    return b->expires_us > now;
+}
+
+/* Source address for a packet to dst; opens or refreshes the binding */
+static loop_ep_t nat_out(loop_node_t *node, loop_ep_t dst, uint64_t now)
+{
+    if (!behind_nat(node)) {
+        return node->mapped;
+    }
+
+    loop_ep_t src;
+    src.ip = node->ip;
+
+    uint32_t timeout_ms = node->nat.binding_timeout_ms ?
+                          node->nat.binding_timeout_ms : CYXCHAT_LOOP_NAT_TIMEOUT_MS;
+    uint64_t expires = now + (uint64_t)timeout_ms * 1000;
+    loop_binding_t *slot = NULL;
+    int cone_live = 0;
+
+    for (size_t i = 0; i < node->binding_count; i++) {
+        loop_binding_t *b = &node->bindings[i];
+        if (!binding_live(b, now)) {
+            if (!slot) slot = b;
+            continue;
+        }
+        if (ep_equal(b->dst, dst)) {
+            b->expires_us = expires;
+            src.port = b->ext_port;
+            return src;
+        }
+        if (b->ext_port == node->cone_port) {
+            cone_live = 1;
+        }
+    }
+
+    /* Cone NATs reuse one mapping while any binding keeps it alive */
+    uint16_t port;
+    if (node->nat.type != CYXCHAT_LOOP_NAT_SYMMETRIC && cone_live) {
+        port = node->cone_port;
+    } else {
+        port = port_to_net(node->next_port++);
+        if (node->nat.type != CYXCHAT_LOOP_NAT_SYMMETRIC) {
+            node->cone_port = port;
+        }
+    }
+
+    if (!slot) {
+        if (!grow((void**)&node->bindings, &node->binding_cap, node->binding_count + 1,
+                  sizeof(loop_binding_t))) {
+            src.port = port;
+            return src;             /* Sent, but the reply will be filtered */
+        }
+        slot = &node->bindings[node->binding_count++];
+    }
+    slot->dst = dst;
+    slot->ext_port = port;
+    slot->expires_us = expires;
+
+    src.port = port;
+    return src;
+}
+
+/* Whether the node's NAT lets a packet from src to dst_port in */
+static int nat_in(const loop_node_t *node, loop_ep_t src, uint16_t dst_port, uint64_t now)
+{
+    if (!behind_nat(node)) {
+        return dst_port == node->mapped.port;
+    }
+
+    for (size_t i = 0; i < node->binding_count; i++) {
+        const loop_binding_t *b = &node->bindings[i];
+        if (!binding_live(b, now) || b->ext_port != dst_port) continue;
+
+        switch (node->nat.type) {
+            case CYXCHAT_LOOP_NAT_FULL_CONE:
+                return 1;
+            case CYXCHAT_LOOP_NAT_RESTRICTED:
+                if (b->dst.ip == src.ip) return 1;
+                break;
+            default:
+                if (ep_equal(b->dst, src)) return 1;
+                break;
+        }
+    }
+    return 0;
+}
+
+/* ============================================================
+ * Delivery Heap
+ * ============================================================ */
+
+static int packet_before(const loop_packet_t *a, const loop_packet_t *b)
+{
+    if (a->deliver_us != b->deliver_us) return a->deliver_us < b->deliver_us;
+    return a->seq < b->seq;
+}
+
+static int heap_push(loop_node_t *node, loop_packet_t *pkt)
+{
+    if (!grow((void**)&node->heap, &node->heap_cap, node->heap_len + 1,
+              sizeof(loop_packet_t*))) {
+        return 0;
+    }
+
+    size_t i = node->heap_len++;
+    while (i > 0) {
+        size_t parent = (i - 1) / 2;
+        if (!packet_before(pkt, node->heap[parent])) break;
+        node->heap[i] = node->heap[parent];
+        i = parent;
+    }
+    node->heap[i] = pkt;
+    return 1;
+}
+
+static loop_packet_t* heap_pop(loop_node_t *node)
+{
+    loop_packet_t *top = node->heap[0];
+    loop_packet_t *last = node->heap[--node->heap_len];
+    size_t n = node->heap_len;
+    size_t i = 0;
+
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= n) break;
+        if (child + 1 < n && packet_before(node->heap[child + 1], node->heap[child])) {
+            child++;
+        }
+        if (!packet_before(node->heap[child], last)) break;
+        node->heap[i] = node->heap[child];
+        i = child;
+    }
+    if (n > 0) {
+        node->heap[i] = last;
+    }
+    return top;
+}
+
+/* ============================================================
+ * Sending
+ * ============================================================ */
+
+/*
+ * Put one datagram on the wire from node to dst: NAT binding, then the
+ * link's loss, bottleneck and delay, then the receiver's heap. The NAT
+ * at the far end filters on arrival, so bindings opened in the meantime
+ * count, as they do for a real punch.
+ */
+static cyxwiz_error_t emit(loop_node_t *node, loop_link_state_t *link, loop_node_t *dst,
+                           loop_ep_t dst_ep, const uint8_t *data, size_t len, int punch)
+{
+    cyxchat_loopnet_t *net = node->net;
+    const cyxchat_loop_link_t *cfg = &link->cfg;
+    uint64_t now = now_us(net);
+    loop_ep_t src = nat_out(node, dst_ep, now);
+
+    if (chance_ppm(net, cfg->loss_ppm)) {
+        net->stats.lost++;
+        return CYXWIZ_OK;
+    }
+
+    uint64_t depart = now;
+    if (cfg->bandwidth_bps > 0) {
+        uint64_t start = link->busy_until_us > now ? link->busy_until_us : now;
+        uint64_t backlog = (start - now) * cfg->bandwidth_bps / 8000000;
+        if (cfg->queue_bytes > 0 && backlog + len > cfg->queue_bytes) {
+            net->stats.queue_drops++;
+            return CYXWIZ_OK;
+        }
+        link->busy_until_us = start + (uint64_t)len * 8000000 / cfg->bandwidth_bps;
+        depart = link->busy_until_us;
+    }
+
+    uint64_t deliver;
+    if (chance_ppm(net, cfg->reorder_ppm)) {
+        deliver = depart;
+        net->stats.reordered++;
+    } else {
+        deliver = depart + (uint64_t)cfg->latency_ms * 1000;
+        if (cfg->jitter_ms > 0) {
+            deliver += next_random(net) % ((uint64_t)cfg->jitter_ms * 1000 + 1);
+        }
+        if (deliver < link->last_deliver_us) {
+            deliver = link->last_deliver_us;
+        }
+        link->last_deliver_us = deliver;
+    }
+
+    loop_packet_t *pkt = (loop_packet_t*)malloc(sizeof(loop_packet_t) + len);
+    if (!pkt) {
+        return CYXWIZ_ERR_NOMEM;
+    }
+    pkt->deliver_us = deliver;
+    pkt->seq = net->seq++;
+    memcpy(&pkt->from, &node->transport.local_id, sizeof(pkt->from));
+    pkt->src = src;
+    pkt->dst_port = dst_ep.port;
+    pkt->punch = punch;
+    pkt->len = len;
+    if (len > 0) {
+        memcpy(pkt->data, data, len);
+    }
+
+    if (!heap_push(dst, pkt)) {
+        free(pkt);
+        return CYXWIZ_ERR_NOMEM;
+    }
+    return CYXWIZ_OK;
+}
+
+/* Send by node ID: learned address first, then the rendezvous one */
+static cyxwiz_error_t send_to_id(loop_node_t *node, const cyxwiz_node_id_t *to,
+                                 const uint8_t *data, size_t len)
+{
+    cyxchat_loopnet_t *net = node->net;
+
+    /* Like UDP, a datagram to nobody simply vanishes */
+    loop_node_t *peer = find_node(net, to);
+    if (!peer) {
+        net->stats.unroutable++;
+        return CYXWIZ_OK;
+    }
+
+    loop_link_state_t *link = link_state(node, to);
+    if (!link) {
+        return CYXWIZ_ERR_NOMEM;
+    }
+
+    loop_ep_t dst_ep;
+    if (link->learned) {
+        dst_ep = link->remote;
+    } else if (peer->has_mapped) {
+        dst_ep = peer->mapped;
+    } else {
+        net->stats.unroutable++;
+        return CYXWIZ_OK;
+    }
+
+    loop_node_t *dst = node_by_ip(net, dst_ep.ip);
+    if (!dst) {
+        net->stats.unroutable++;
+        return CYXWIZ_OK;
+    }
+    return emit(node, link, dst, dst_ep, data, len, 0);
+}
+
+/* ============================================================
+ * Relay Emulation
+ * ============================================================ */
+
+static void relay_receive(loop_node_t *relay, const loop_packet_t *pkt)
+{
+    cyxchat_loopnet_t *net = relay->net;
+    if (pkt->len < 1) return;
+
+    switch (pkt->data[0]) {
+        case CYXCHAT_RELAY_CONNECT: {
+            if (pkt->len < LOOP_RELAY_CONNECT_LEN) return;
+            uint8_t ack[LOOP_RELAY_ACK_LEN];
+            ack[0] = CYXCHAT_RELAY_CONNECT_ACK;
+            memcpy(ack + 1, pkt->data + LOOP_RELAY_TO_OFFSET, CYXWIZ_NODE_ID_LEN);
+            ack[LOOP_RELAY_ACK_LEN - 1] = 1;
+            send_to_id(relay, &pkt->from, ack, sizeof(ack));
+            break;
+        }
+
+        case CYXCHAT_RELAY_DATA:
+        case CYXCHAT_RELAY_DISCONNECT: {
+            if (pkt->len < LOOP_RELAY_CONNECT_LEN) return;
+            cyxwiz_node_id_t to;
+            memcpy(&to, pkt->data + LOOP_RELAY_TO_OFFSET, sizeof(to));
+
+            /* Only to nodes that have talked to us: their NAT has a binding */
+            loop_link_state_t *link = link_state(relay, &to);
+            if (!link || !link->learned) return;
+
+            loop_node_t *dst = node_by_ip(net, link->remote.ip);
+            if (dst && emit(relay, link, dst, link->remote, pkt->data, pkt->len, 0) == CYXWIZ_OK) {
+                net->stats.relayed++;
+            }
+            break;
+        }
+
+        default:
+            break;                  /* Keepalives only refresh the address */
+    }
+}
+
+/* Deliver what is due to one node; relays answer instead of calling back */
+static void deliver_due(loop_node_t *node, uint64_t now)
+{
+    cyxchat_loopnet_t *net = node->net;
+    cyxwiz_transport_t *transport = &node->transport;
+
+    while (node->heap_len > 0 && node->heap[0]->deliver_us <= now) {
+        loop_packet_t *pkt = heap_pop(node);
+
+        if (!nat_in(node, pkt->src, pkt->dst_port, now)) {
+            net->stats.nat_drops++;
+            free(pkt);
+            continue;
+        }
+
+        /* Reply to where it came from, as the UDP transport does */
+        loop_link_state_t *link = link_state(node, &pkt->from);
+        if (link) {
+            link->remote = pkt->src;
+            link->learned = 1;
+        }
+
+        if (pkt->punch) {
+            net->stats.punches++;
+        } else if (node->relay) {
+            relay_receive(node, pkt);
+        } else {
+            net->stats.delivered++;
+            net->stats.bytes_delivered += pkt->len;
+            if (transport->on_recv) {
+                transport->on_recv(transport, &pkt->from, pkt->data, pkt->len,
+                                   transport->recv_user_data);
+            }
+        }
+        free(pkt);
+    }
+}
+
+static void run_relays(cyxchat_loopnet_t *net, uint64_t now)
+{
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (net->nodes[i]->relay) {
+            deliver_due(net->nodes[i], now);
+        }
+    }
+}
+
+/* ============================================================
+ * Transport Operations
+ * ============================================================ */
+
+static cyxwiz_error_t loop_init(cyxwiz_transport_t *transport)
+{
+    (void)transport;
+    return CYXWIZ_OK;
+}
+
+static cyxwiz_error_t loop_shutdown(cyxwiz_transport_t *transport)
+{
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    node->discovering = 0;
+    return CYXWIZ_OK;
+}
+
+static cyxwiz_error_t loop_send(cyxwiz_transport_t *transport, const cyxwiz_node_id_t *to,
+                                const uint8_t *data, size_t len)
+{
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+
+    if (!to || (!data && len > 0)) {
+        return CYXWIZ_ERR_INVALID;
+    }
+    if (len > CYXCHAT_LOOP_MTU) {
+        return CYXWIZ_ERR_PACKET_TOO_LARGE;
+    }
+
+    node->net->stats.sent++;
+    node->net->stats.send_calls++;
+    CYXCHAT_TRACE_CURRENT(CYXCHAT_TRACE_TRANSPORT_TX, to, len);
+    return send_to_id(node, to, data, len);
+}
+
+/*
+ * Register with the rendezvous server, which records the mapped address
+ * peers will use, and exchange IDs with every other node like a LAN
+ * broadcast.
+ */
+static cyxwiz_error_t loop_discover(cyxwiz_transport_t *transport)
+{
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    cyxchat_loopnet_t *net = node->net;
+
+    node->mapped = nat_out(node, rendezvous_ep(), now_us(net));
+    node->has_mapped = 1;
+    node->discovering = 1;
+
+    for (size_t i = 0; i < net->node_count; i++) {
+        loop_node_t *other = net->nodes[i];
+        if (other == node || other->relay) continue;
+
+        if (transport->on_peer) {
+            cyxwiz_peer_info_t info;
+            memset(&info, 0, sizeof(info));
+            memcpy(&info.id, &other->transport.local_id, sizeof(info.id));
+            transport->on_peer(transport, &info, transport->peer_user_data);
+        }
+        if (other->discovering && other->transport.on_peer) {
+            cyxwiz_peer_info_t info;
+            memset(&info, 0, sizeof(info));
+            memcpy(&info.id, &transport->local_id, sizeof(info.id));
+            other->transport.on_peer(&other->transport, &info, other->transport.peer_user_data);
+        }
+    }
+    return CYXWIZ_OK;
+}
+
+static cyxwiz_error_t loop_stop_discover(cyxwiz_transport_t *transport)
+{
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    node->discovering = 0;
+    return CYXWIZ_OK;
+}
+
+static size_t loop_max_packet_size(cyxwiz_transport_t *transport)
+{
+    (void)transport;
+    return CYXCHAT_LOOP_MTU;
+}
+
+/* Block like a socket would, but only until the next arrival (never on a manual clock) */
+static uint64_t idle_us(loop_node_t *node, uint64_t now, uint64_t limit_us)
+{
+    if (node->net->manual_clock) return 0;
+    if (node->heap_len == 0) return limit_us;
+    if (node->heap[0]->deliver_us <= now) return 0;
+
+    uint64_t until = node->heap[0]->deliver_us - now;
+    return until < limit_us ? until : limit_us;
+}
+
+static cyxwiz_error_t loop_poll(cyxwiz_transport_t *transport, uint32_t timeout_ms)
+{
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    cyxchat_loopnet_t *net = node->net;
+    uint64_t now = now_us(net);
+
+    uint64_t wait = idle_us(node, now, (uint64_t)timeout_ms * 1000);
+    if (wait > 0) {
+        sleep_us(wait);
+        now = now_us(net);
+    }
+
+    /* Bootstrap keepalive holds the rendezvous mapping */
+    if (node->has_mapped && behind_nat(node)) {
+        node->mapped = nat_out(node, rendezvous_ep(), now);
+    }
+
+    run_relays(net, now);
+    deliver_due(node, now);
+    return CYXWIZ_OK;
+}
+
+static const cyxwiz_transport_ops_t loop_ops = {
+    .init = loop_init,
+    .shutdown = loop_shutdown,
+    .send = loop_send,
+    .discover = loop_discover,
+    .stop_discover = loop_stop_discover,
+    .max_packet_size = loop_max_packet_size,
+    .poll = loop_poll,
+};
+
+/* ============================================================
+ * Network
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_loopnet_create(cyxchat_loopnet_t **net, uint64_t seed)
+{
+    if (!net) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_loopnet_t *n = (cyxchat_loopnet_t*)calloc(1, sizeof(cyxchat_loopnet_t));
+    if (!n) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    n->rng = seed;
+
+    *net = n;
+    return CYXCHAT_OK;
+}
+
+static void free_node(loop_node_t *node)
+{
+    for (size_t i = 0; i < node->heap_len; i++) {
+        free(node->heap[i]);
+    }
+    free(node->heap);
+    free(node->links);
+    free(node->bindings);
+    free(node);
+}
+
+void cyxchat_loopnet_destroy(cyxchat_loopnet_t *net)
+{
+    if (!net) return;
+
+    if (net->transports > 0) {
+        CYXWIZ_WARN("Loopback network destroyed with %zu transports attached",
+                    net->transports);
+    }
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (net->nodes[i]->relay) {
+            free_node(net->nodes[i]);
+        }
+    }
+    free(net->nodes);
+    free(net->overrides);
+    free(net);
+}
+
+void cyxchat_loopnet_set_default_link(cyxchat_loopnet_t *net, const cyxchat_loop_link_t *link)
+{
+    if (!net || !link) return;
+    net->default_link = *link;
+}
+
+cyxchat_error_t cyxchat_loopnet_set_link(
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *from,
+    const cyxwiz_node_id_t *to,
+    const cyxchat_loop_link_t *link
+) {
+    if (!net || !from || !to || !link) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    /* A link already in use takes the new parameters at once */
+    loop_node_t *node = find_node(net, from);
+    if (node) {
+        for (size_t i = 0; i < node->link_count; i++) {
+            if (memcmp(&node->links[i].to, to, sizeof(*to)) == 0) {
+                node->links[i].cfg = *link;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < net->override_count; i++) {
+        loop_override_t *o = &net->overrides[i];
+        if (memcmp(&o->from, from, sizeof(*from)) == 0 &&
+            memcmp(&o->to, to, sizeof(*to)) == 0) {
+            o->cfg = *link;
+            return CYXCHAT_OK;
+        }
+    }
+
+    if (!grow((void**)&net->overrides, &net->override_cap, net->override_count + 1,
+              sizeof(loop_override_t))) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    loop_override_t *o = &net->overrides[net->override_count++];
+    memcpy(&o->from, from, sizeof(*from));
+    memcpy(&o->to, to, sizeof(*to));
+    o->cfg = *link;
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_loopnet_add_relay(cyxchat_loopnet_t *net, const char *addr)
+{
+    if (!net || !addr) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    unsigned a, b, c, d, port;
+    char extra;
+    if (sscanf(addr, "%u.%u.%u.%u:%u%c", &a, &b, &c, &d, &port, &extra) != 5 ||
+        a > 255 || b > 255 || c > 255 || d > 255 || port == 0 || port > 65535) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    uint32_t ip = ip_from_octets((uint8_t)a, (uint8_t)b, (uint8_t)c, (uint8_t)d);
+    if (node_by_ip(net, ip)) {
+        return CYXCHAT_ERR_EXISTS;
+    }
+
+    if (!grow((void**)&net->nodes, &net->node_cap, net->node_count + 1,
+              sizeof(loop_node_t*))) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    loop_node_t *node = (loop_node_t*)calloc(1, sizeof(loop_node_t));
+    if (!node) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    node->net = net;
+    node->relay = 1;
+    node->ip = ip;
+    node->mapped.ip = ip;
+    node->mapped.port = port_to_net((uint16_t)port);
+    node->has_mapped = 1;
+
+    /* The pseudo-ID relay.c sends to: address, port, then a marker */
+    memcpy(node->transport.local_id.bytes, &node->mapped.ip, 4);
+    memcpy(node->transport.local_id.bytes + 4, &node->mapped.port, 2);
+    node->transport.local_id.bytes[6] = 0xFF;
+
+    net->nodes[net->node_count++] = node;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_loopnet_set_time(cyxchat_loopnet_t *net, uint64_t now_ms)
+{
+    if (!net) return;
+
+    if (!net->manual_clock) {
+        net->manual_clock = 1;
+        net->now_us = 0;
+    }
+    if (now_ms * 1000 > net->now_us) {
+        net->now_us = now_ms * 1000;
+    }
+}
+
+uint64_t cyxchat_loopnet_now_ms(cyxchat_loopnet_t *net)
+{
+    if (!net) return 0;
+    return now_us(net) / 1000;
+}
+
+uint64_t cyxchat_loopnet_next_delivery(cyxchat_loopnet_t *net)
+{
+    uint64_t next = UINT64_MAX;
+    if (!net) return next;
+
+    for (size_t i = 0; i < net->node_count; i++) {
+        loop_node_t *node = net->nodes[i];
+        if (node->heap_len > 0 && node->heap[0]->deliver_us < next) {
+            next = node->heap[0]->deliver_us;
+        }
+    }
+
+    /* Round up so advancing the clock to it delivers */
+    return next == UINT64_MAX ? next : (next + 999) / 1000;
+}
+
+void cyxchat_loopnet_get_stats(cyxchat_loopnet_t *net, cyxchat_loop_stats_t *stats_out)
+{
+    if (!stats_out) return;
+
+    if (!net) {
+        memset(stats_out, 0, sizeof(*stats_out));
+        return;
+    }
+    *stats_out = net->stats;
+}
+
+/* ============================================================
+ * Transport
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_loopnet_transport_create(cyxchat_loopnet_t *net,
+                                                 cyxwiz_transport_t **transport)
+{
+    if (!net || !transport) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    if (!grow((void**)&net->nodes, &net->node_cap, net->node_count + 1,
+              sizeof(loop_node_t*))) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    loop_node_t *node = (loop_node_t*)calloc(1, sizeof(loop_node_t));
+    if (!node) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    node->net = net;
+    node->transport.type = CYXWIZ_TRANSPORT_UDP;
+    node->transport.ops = &loop_ops;
+    node->transport.driver_data = node;
+
+    /* 100.64.0.0/10, one public address per node */
+    net->next_host++;
+    node->ip = ip_from_octets(100, 64, (uint8_t)(net->next_host >> 8),
+                              (uint8_t)(net->next_host & 0xFF));
+    node->mapped.ip = node->ip;
+    node->mapped.port = port_to_net(LOOP_OPEN_PORT);
+    node->has_mapped = 1;
+    node->next_port = LOOP_FIRST_NAT_PORT;
+
+    net->nodes[net->node_count++] = node;
+    net->transports++;
+
+    *transport = &node->transport;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_loopnet_transport_destroy(cyxwiz_transport_t *transport)
+{
+    if (!cyxchat_loopnet_is_loopback(transport)) return;
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    cyxchat_loopnet_t *net = node->net;
+
+    /* Keep attach order: discovery callbacks follow it */
+    for (size_t i = 0; i < net->node_count; i++) {
+        if (net->nodes[i] == node) {
+            memmove(&net->nodes[i], &net->nodes[i + 1],
+                    (net->node_count - i - 1) * sizeof(loop_node_t*));
+            net->node_count--;
+            break;
+        }
+    }
+    net->transports--;
+    free_node(node);
+}
+
+cyxchat_error_t cyxchat_loopnet_set_nat(cyxwiz_transport_t *transport,
+                                        const cyxchat_loop_nat_t *nat)
+{
+    if (!transport || !nat) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (!cyxchat_loopnet_is_loopback(transport)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    node->nat = *nat;
+    node->binding_count = 0;
+    node->has_mapped = nat->type == CYXCHAT_LOOP_NAT_NONE;
+    node->mapped.ip = node->ip;
+    node->mapped.port = port_to_net(LOOP_OPEN_PORT);
+
+    /* Already registered: register again through the new NAT */
+    if (node->discovering) {
+        node->mapped = nat_out(node, rendezvous_ep(), now_us(node->net));
+        node->has_mapped = 1;
+    }
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_loopnet_get_mapped(cyxwiz_transport_t *transport,
+                                           uint32_t *ip_out, uint16_t *port_out)
+{
+    if (!transport || !ip_out || !port_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (!cyxchat_loopnet_is_loopback(transport)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    if (!node->has_mapped) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+    *ip_out = node->mapped.ip;
+    *port_out = node->mapped.port;
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_loopnet_punch(cyxwiz_transport_t *transport, uint32_t ip, uint16_t port)
+{
+    if (!cyxchat_loopnet_is_loopback(transport)) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    loop_node_t *dst = node_by_ip(node->net, ip);
+    if (!dst) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    loop_link_state_t *link = link_state(node, &dst->transport.local_id);
+    if (!link) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    loop_ep_t dst_ep;
+    dst_ep.ip = ip;
+    dst_ep.port = port;
+    return emit(node, link, dst, dst_ep, NULL, 0, 1) == CYXWIZ_OK ?
+           CYXCHAT_OK : CYXCHAT_ERR_MEMORY;
+}
+
+size_t cyxchat_loopnet_send_batch(cyxwiz_transport_t *transport,
+                                  const cyxchat_datagram_t *dgrams,
+                                  size_t count)
+{
+    if (!cyxchat_loopnet_is_loopback(transport) || !dgrams || count == 0) {
+        return 0;
+    }
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    node->net->stats.send_calls++;
+
+    size_t sent = 0;
+    for (; sent < count; sent++) {
+        const cyxchat_datagram_t *d = &dgrams[sent];
+        if (!d->to || (!d->data && d->len > 0) || d->len > CYXCHAT_LOOP_MTU) break;
+
+        node->net->stats.sent++;
+        CYXCHAT_TRACE_CURRENT(CYXCHAT_TRACE_TRANSPORT_TX, d->to, d->len);
+        if (send_to_id(node, d->to, d->data, d->len) != CYXWIZ_OK) break;
+    }
+    return sent;
+}
+
+int cyxchat_loopnet_is_loopback(const cyxwiz_transport_t *transport)
+{
+    return transport && transport->ops == &loop_ops;
+}
+
+uint32_t cyxchat_loopnet_poll_wait(cyxwiz_transport_t *transport, uint32_t timeout_ms)
+{
+    if (!cyxchat_loopnet_is_loopback(transport)) return timeout_ms;
+
+    loop_node_t *node = (loop_node_t*)transport->driver_data;
+    uint64_t wait = idle_us(node, now_us(node->net), (uint64_t)timeout_ms * 1000);
+    return (uint32_t)((wait + 999) / 1000);
+}
@@ -9,6 +9,7 @@
 
 #include <cyxchat/mail.h>
 #include <cyxchat/chat.h>
+#include <cyxchat/rng.h>
 #include <cyxwiz/memory.h>
 #include <cyxwiz/log.h>
 #include <cyxwiz/types.h>
@@ -32,7 +33,6 @@
  * Internal Constants
  * ============================================================ */
 
-#define MAIL_MAX_STORED         256     /* Max stored emails */
 #define MAIL_MAX_PENDING        16      /* Max pending sends */
 #define MAIL_RETRY_INTERVAL_MS  30000   /* Retry interval */
 #define MAIL_RETRY_MAX          3       /* Max retries */
@@ -56,9 +56,11 @@ struct cyxchat_mail_ctx {
     cyxwiz_node_id_t local_id;
     uint8_t signing_key[64];        /* Ed25519 secret + public */
 
-    /* Stored mail */
-    cyxchat_mail_t *stored[MAIL_MAX_STORED];
+    /* Stored mail (slots carved after the struct) */
+    cyxchat_mail_t **stored;
+    size_t stored_capacity;
     size_t stored_count;
+    size_t footprint;               /* Context plus stored-mail slots */
 
     /* Pending sends */
     mail_pending_send_t pending[MAIL_MAX_PENDING];
@@ -121,19 +123,19 @@ static cyxchat_mail_t* find_mail(cyxchat_mail_ctx_t *ctx, const cyxchat_mail_id_
 /* Find free storage slot */
 static size_t find_free_slot(cyxchat_mail_ctx_t *ctx)
 {
-    for (size_t i = 0; i < MAIL_MAX_STORED; i++) {
+    for (size_t i = 0; i < ctx->stored_capacity; i++) {
         if (!ctx->stored[i]) {
             return i;
         }
     }
-    return MAIL_MAX_STORED; /* No free slot */
+    return ctx->stored_capacity; /* No free slot */
 }
 
 /* Store mail internally */
 static cyxchat_error_t store_mail(cyxchat_mail_ctx_t *ctx, cyxchat_mail_t *mail)
 {
     size_t slot = find_free_slot(ctx);
-    if (slot >= MAIL_MAX_STORED) {
+    if (slot >= ctx->stored_capacity) {
         return CYXCHAT_ERR_FULL;
     }
 
@@ -237,15 +239,44 @@ static int verify_mail_signature(const cyxchat_mail_t *mail)
  * Initialization
  * ============================================================ */
 
+/* Context and its stored-mail slots */
+static void* mail_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_mail_ctx_t *c = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_mail_ctx_t));
+    cyxchat_mail_t **stored = cyxchat_arena_carve(arena, cfg->mail_max_stored,
+                                                  sizeof(cyxchat_mail_t*));
+    if (c) {
+        c->stored = stored;
+        c->stored_capacity = cfg->mail_max_stored;
+        c->footprint = arena->size;
+    }
+    return c;
+}
+
 cyxchat_error_t cyxchat_mail_ctx_create(
     cyxchat_mail_ctx_t **ctx,
     cyxchat_ctx_t *chat_ctx
+) {
+    return cyxchat_mail_ctx_create_with_config(ctx, chat_ctx, NULL);
+}
+
+cyxchat_error_t cyxchat_mail_ctx_create_with_config(
+    cyxchat_mail_ctx_t **ctx,
+    cyxchat_ctx_t *chat_ctx,
+    const cyxchat_config_t *config
 ) {
     if (!ctx || !chat_ctx) {
         return CYXCHAT_ERR_NULL;
     }
 
-    cyxchat_mail_ctx_t *c = calloc(1, sizeof(cyxchat_mail_ctx_t));
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_mail_ctx_t *c = cyxchat_arena_build(mail_layout, config);
     if (!c) {
         return CYXCHAT_ERR_MEMORY;
     }
@@ -286,7 +317,7 @@ void cyxchat_mail_ctx_destroy(cyxchat_mail_ctx_t *ctx)
     }
 
     /* Secure zero and free */
-    cyxwiz_secure_zero(ctx, sizeof(cyxchat_mail_ctx_t));
+    cyxwiz_secure_zero(ctx, ctx->footprint);
     free(ctx);
 }
 
@@ -354,7 +385,8 @@ cyxchat_error_t cyxchat_mail_create(
     }
 
     /* Generate mail ID */
-    cyxchat_mail_generate_id(&mail->mail_id);
+    cyxchat_rng_bytes(cyxchat_get_rng(ctx->chat_ctx),
+                      mail->mail_id.bytes, CYXCHAT_MAIL_ID_SIZE);
 
     /* Set from address */
     memcpy(&mail->from.node_id, &ctx->local_id, sizeof(cyxwiz_node_id_t));
@@ -536,13 +568,7 @@ cyxchat_error_t cyxchat_mail_add_attachment(
     cyxchat_mail_attachment_t *attach = &mail->attachments[mail->attachment_count];
 
     /* Generate file ID */
-#ifdef CYXWIZ_HAS_CRYPTO
-    randombytes_buf(attach->file_id.bytes, CYXCHAT_FILE_ID_SIZE);
-#else
-    for (int i = 0; i < CYXCHAT_FILE_ID_SIZE; i++) {
-        attach->file_id.bytes[i] = (uint8_t)(rand() & 0xFF);
-    }
-#endif
+    cyxchat_rng_bytes(cyxchat_rng_default(), attach->file_id.bytes, CYXCHAT_FILE_ID_SIZE);
 
     strncpy(attach->filename, filename, CYXCHAT_MAX_FILENAME - 1);
     attach->filename[CYXCHAT_MAX_FILENAME - 1] = '\0';
@@ -1245,13 +1271,7 @@ void cyxchat_mail_generate_id(cyxchat_mail_id_t *id)
 {
     if (!id) return;
 
-#ifdef CYXWIZ_HAS_CRYPTO
-    randombytes_buf(id->bytes, CYXCHAT_MAIL_ID_SIZE);
-#else
-    for (int i = 0; i < CYXCHAT_MAIL_ID_SIZE; i++) {
-        id->bytes[i] = (uint8_t)(rand() & 0xFF);
-    }
-#endif
+    cyxchat_rng_bytes(cyxchat_rng_default(), id->bytes, CYXCHAT_MAIL_ID_SIZE);
 }
 
 void cyxchat_mail_id_to_hex(const cyxchat_mail_id_t *id, char *hex_out)
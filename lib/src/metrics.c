@@ -0,0 +1,436 @@
+/**
+ * CyxChat Metrics Implementation
+ *
+ * Every metric is a fixed slot in static arrays, updated with relaxed
+ * atomic adds, so recording never locks or allocates and costs about
+ * as much as the trace ring. A histogram is a count, a sum and 240
+ * log-linear bucket counters; the bucket index comes from the position
+ * of the value's top bit plus the next three bits below it.
+ */
+
+#include <cyxchat/metrics.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define METRICS_ADD(p, v) \
+    ((void)_InterlockedExchangeAdd64((volatile long long *)(p), (long long)(v)))
+#define METRICS_LOAD(p)     ((uint64_t)*(volatile long long *)(p))
+#define METRICS_STORE(p, v) (*(volatile long long *)(p) = (long long)(v))
+#else
+#define METRICS_ADD(p, v)   ((void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED))
+#define METRICS_LOAD(p)     __atomic_load_n((p), __ATOMIC_RELAXED)
+#define METRICS_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#endif
+
+#define SUB_COUNT       (1u << CYXCHAT_METRICS_SUB_BITS)
+
+/* ============================================================
+ * State
+ * ============================================================ */
+
+typedef struct {
+    uint64_t count;
+    uint64_t sum_us;
+    uint64_t buckets[CYXCHAT_METRICS_BUCKETS];
+} metrics_hist_t;
+
+static uint64_t g_counters[CYXCHAT_METRIC_COUNTER_COUNT];
+static uint64_t g_gauges[CYXCHAT_METRIC_GAUGE_COUNT];  /* Two's complement */
+static metrics_hist_t g_hists[CYXCHAT_METRIC_TIMING_COUNT];
+
+static const char *counter_names[] = {
+    "msg_sent",
+    "msg_recv",
+    "msg_dup",
+    "msg_send_fail",
+    "frag_sent",
+    "frag_recv",
+    "bytes_sent",
+    "bytes_recv",
+    "conn_direct",
+    "conn_relayed",
+    "conn_failed",
+    "dns_cache_hit",
+    "dns_cache_miss",
+    "dns_timeout",
+    "file_chunk_sent",
+    "file_chunk_recv",
+    "file_done",
+    "file_failed",
+    "sched_drop",
+    "label_fwd",
+    "label_delivered",
+    "label_drop",
+    "offline_stored",
+    "offline_failed",
+    "offline_delivered",
+    "multipath_sent",
+    "multipath_dup"
+};
+
+static const char *gauge_names[] = {
+    "sched_queued",
+    "peers_up"
+};
+
+static const char *timing_names[] = {
+    "send_ack",
+    "dns_lookup",
+    "hole_punch",
+    "relay_setup",
+    "file_transfer"
+};
+
+/* A name per enum slot: a missed entry would send the snapshots past the end */
+#define NAMES_MATCH(names, count) (sizeof(names) / sizeof((names)[0]) == (count))
+_Static_assert(NAMES_MATCH(counter_names, CYXCHAT_METRIC_COUNTER_COUNT),
+               "counter_names must match the counter enum");
+_Static_assert(NAMES_MATCH(gauge_names, CYXCHAT_METRIC_GAUGE_COUNT),
+               "gauge_names must match the gauge enum");
+_Static_assert(NAMES_MATCH(timing_names, CYXCHAT_METRIC_TIMING_COUNT),
+               "timing_names must match the timing enum");
+
+/* ============================================================
+ * Buckets
+ * ============================================================ */
+
+static unsigned top_bit(uint32_t v)
+{
+#if defined(__GNUC__)
+    return 31u - (unsigned)__builtin_clz(v);
+#elif defined(_MSC_VER)
+    unsigned long idx;
+    _BitScanReverse(&idx, v);
+    return (unsigned)idx;
+#else
+    unsigned b = 0;
+    while (v >>= 1) b++;
+    return b;
+#endif
+}
+
+static unsigned bucket_index(uint64_t v)
+{
+    if (v < SUB_COUNT) return (unsigned)v;
+    if (v > UINT32_MAX) return CYXCHAT_METRICS_BUCKETS - 1;
+
+    unsigned shift = top_bit((uint32_t)v) - CYXCHAT_METRICS_SUB_BITS;
+    unsigned sub = (unsigned)(v >> shift) & (SUB_COUNT - 1);
+    return SUB_COUNT + shift * SUB_COUNT + sub;
+}
+
+uint64_t cyxchat_metrics_bucket_upper(unsigned index)
+{
+    if (index >= CYXCHAT_METRICS_BUCKETS) index = CYXCHAT_METRICS_BUCKETS - 1;
+    if (index < SUB_COUNT) return index;
+
+    unsigned shift = (index - SUB_COUNT) / SUB_COUNT;
+    uint64_t sub = (index - SUB_COUNT) % SUB_COUNT;
+    return ((SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+/* ============================================================
+ * Recording
+ * ============================================================ */
+
+uint64_t cyxchat_metrics_now_us(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    uint64_t sec = (uint64_t)(now.QuadPart / freq.QuadPart);
+    uint64_t rem = (uint64_t)(now.QuadPart % freq.QuadPart);
+    return sec * 1000000 + rem * 1000000 / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+void cyxchat_metrics_count(int id, uint64_t n)
+{
+    if (id < 0 || id >= CYXCHAT_METRIC_COUNTER_COUNT) return;
+    METRICS_ADD(&g_counters[id], n);
+}
+
+void cyxchat_metrics_gauge_add(int id, int64_t delta)
+{
+    if (id < 0 || id >= CYXCHAT_METRIC_GAUGE_COUNT) return;
+    METRICS_ADD(&g_gauges[id], (uint64_t)delta);
+}
+
+void cyxchat_metrics_observe(int id, uint64_t us)
+{
+    if (id < 0 || id >= CYXCHAT_METRIC_TIMING_COUNT) return;
+
+    metrics_hist_t *h = &g_hists[id];
+    METRICS_ADD(&h->buckets[bucket_index(us)], 1);
+    METRICS_ADD(&h->sum_us, us);
+    METRICS_ADD(&h->count, 1);
+}
+
+/* ============================================================
+ * Reading
+ * ============================================================ */
+
+uint64_t cyxchat_metrics_counter(int id)
+{
+    if (id < 0 || id >= CYXCHAT_METRIC_COUNTER_COUNT) return 0;
+    return METRICS_LOAD(&g_counters[id]);
+}
+
+int64_t cyxchat_metrics_gauge(int id)
+{
+    if (id < 0 || id >= CYXCHAT_METRIC_GAUGE_COUNT) return 0;
+    return (int64_t)METRICS_LOAD(&g_gauges[id]);
+}
+
+cyxchat_error_t cyxchat_metrics_get_hist(int id, cyxchat_metrics_hist_t *hist_out)
+{
+    if (!hist_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (id < 0 || id >= CYXCHAT_METRIC_TIMING_COUNT) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    metrics_hist_t *h = &g_hists[id];
+
+    /* Count first: buckets can only have grown by the time we read them */
+    hist_out->count = METRICS_LOAD(&h->count);
+    hist_out->sum_us = METRICS_LOAD(&h->sum_us);
+    for (unsigned i = 0; i < CYXCHAT_METRICS_BUCKETS; i++) {
+        hist_out->buckets[i] = METRICS_LOAD(&h->buckets[i]);
+    }
+    return CYXCHAT_OK;
+}
+
+uint64_t cyxchat_metrics_percentile(const cyxchat_metrics_hist_t *hist, double q)
+{
+    if (!hist) return 0;
+
+    uint64_t total = 0;
+    for (unsigned i = 0; i < CYXCHAT_METRICS_BUCKETS; i++) {
+        total += hist->buckets[i];
+    }
+    if (total == 0) return 0;
+
+    if (q < 0.0) q = 0.0;
+    if (q > 1.0) q = 1.0;
+    uint64_t rank = (uint64_t)(q * (double)total + 0.999999);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < CYXCHAT_METRICS_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            return cyxchat_metrics_bucket_upper(i);
+        }
+    }
+    return cyxchat_metrics_bucket_upper(CYXCHAT_METRICS_BUCKETS - 1);
+}
+
+const char* cyxchat_metrics_name(cyxchat_metric_kind_t kind, int id)
+{
+    if (id < 0) return "unknown";
+
+    switch (kind) {
+        case CYXCHAT_METRIC_KIND_COUNTER:
+            return id < CYXCHAT_METRIC_COUNTER_COUNT ? counter_names[id] : "unknown";
+        case CYXCHAT_METRIC_KIND_GAUGE:
+            return id < CYXCHAT_METRIC_GAUGE_COUNT ? gauge_names[id] : "unknown";
+        case CYXCHAT_METRIC_KIND_TIMING:
+            return id < CYXCHAT_METRIC_TIMING_COUNT ? timing_names[id] : "unknown";
+    }
+    return "unknown";
+}
+
+void cyxchat_metrics_reset(void)
+{
+    for (int i = 0; i < CYXCHAT_METRIC_COUNTER_COUNT; i++) {
+        METRICS_STORE(&g_counters[i], 0);
+    }
+    for (int i = 0; i < CYXCHAT_METRIC_TIMING_COUNT; i++) {
+        METRICS_STORE(&g_hists[i].count, 0);
+        METRICS_STORE(&g_hists[i].sum_us, 0);
+        for (unsigned b = 0; b < CYXCHAT_METRICS_BUCKETS; b++) {
+            METRICS_STORE(&g_hists[i].buckets[b], 0);
+        }
+    }
+}
+
+/* ============================================================
+ * Snapshot
+ * ============================================================ */
+
+typedef struct {
+    uint8_t *buf;
+    size_t size;
+    size_t len;
+    int full;
+} snap_writer_t;
+
+static void put_byte(snap_writer_t *w, uint8_t b)
+{
+    if (w->len < w->size) {
+        w->buf[w->len++] = b;
+    } else {
+        w->full = 1;
+    }
+}
+
+static void put_varint(snap_writer_t *w, uint64_t v)
+{
+    while (v >= 0x80) {
+        put_byte(w, (uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    put_byte(w, (uint8_t)v);
+}
+
+/* Append formatted text, keeping room for the terminating NUL */
+static void put_text(snap_writer_t *w, const char *fmt, ...)
+{
+    if (w->full) return;
+
+    size_t room = w->size - w->len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf((char*)w->buf + w->len, room, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t)n >= room) {
+        w->full = 1;
+        return;
+    }
+    w->len += (size_t)n;
+}
+
+static void snapshot_binary(snap_writer_t *w)
+{
+    cyxchat_metrics_hist_t hist;
+
+    for (const char *m = CYXCHAT_METRICS_MAGIC; *m; m++) {
+        put_byte(w, (uint8_t)*m);
+    }
+    put_byte(w, CYXCHAT_METRICS_VERSION);
+    put_byte(w, CYXCHAT_METRIC_COUNTER_COUNT);
+    put_byte(w, CYXCHAT_METRIC_GAUGE_COUNT);
+    put_byte(w, CYXCHAT_METRIC_TIMING_COUNT);
+
+    for (int i = 0; i < CYXCHAT_METRIC_COUNTER_COUNT; i++) {
+        put_varint(w, cyxchat_metrics_counter(i));
+    }
+    for (int i = 0; i < CYXCHAT_METRIC_GAUGE_COUNT; i++) {
+        int64_t g = cyxchat_metrics_gauge(i);
+        put_varint(w, ((uint64_t)g << 1) ^ (uint64_t)(g >> 63));
+    }
+
+    for (int i = 0; i < CYXCHAT_METRIC_TIMING_COUNT; i++) {
+        cyxchat_metrics_get_hist(i, &hist);
+
+        unsigned used = 0;
+        for (unsigned b = 0; b < CYXCHAT_METRICS_BUCKETS; b++) {
+            if (hist.buckets[b]) used++;
+        }
+
+        put_varint(w, hist.count);
+        put_varint(w, hist.sum_us);
+        put_varint(w, used);
+
+        unsigned prev = 0;
+        for (unsigned b = 0; b < CYXCHAT_METRICS_BUCKETS; b++) {
+            if (!hist.buckets[b]) continue;
+            put_varint(w, b - prev);
+            put_varint(w, hist.buckets[b]);
+            prev = b;
+        }
+    }
+}
+
+static void snapshot_prometheus(snap_writer_t *w)
+{
+    cyxchat_metrics_hist_t hist;
+
+    for (int i = 0; i < CYXCHAT_METRIC_COUNTER_COUNT; i++) {
+        put_text(w, "# TYPE cyxchat_%s_total counter\ncyxchat_%s_total %llu\n",
+                 counter_names[i], counter_names[i],
+                 (unsigned long long)cyxchat_metrics_counter(i));
+    }
+    for (int i = 0; i < CYXCHAT_METRIC_GAUGE_COUNT; i++) {
+        put_text(w, "# TYPE cyxchat_%s gauge\ncyxchat_%s %lld\n",
+                 gauge_names[i], gauge_names[i], (long long)cyxchat_metrics_gauge(i));
+    }
+
+    for (int i = 0; i < CYXCHAT_METRIC_TIMING_COUNT; i++) {
+        const char *name = timing_names[i];
+        cyxchat_metrics_get_hist(i, &hist);
+
+        put_text(w, "# TYPE cyxchat_%s_seconds histogram\n", name);
+
+        /*
+         * Cumulative over the buckets read, so +Inf always equals _count.
+         * Only the last bucket of each octave is a bound, so every scrape
+         * has the same series at 2^n - 1 us.
+         */
+        uint64_t cumulative = 0;
+        for (unsigned b = 0; b < CYXCHAT_METRICS_BUCKETS; b++) {
+            cumulative += hist.buckets[b];
+            if (b % SUB_COUNT != SUB_COUNT - 1) continue;
+            put_text(w, "cyxchat_%s_seconds_bucket{le=\"%.6f\"} %llu\n", name,
+                     (double)cyxchat_metrics_bucket_upper(b) / 1e6,
+                     (unsigned long long)cumulative);
+        }
+        put_text(w, "cyxchat_%s_seconds_bucket{le=\"+Inf\"} %llu\n"
+                    "cyxchat_%s_seconds_sum %.6f\n"
+                    "cyxchat_%s_seconds_count %llu\n",
+                 name, (unsigned long long)cumulative,
+                 name, (double)hist.sum_us / 1e6,
+                 name, (unsigned long long)cumulative);
+    }
+}
+
+cyxchat_error_t cyxchat_metrics_snapshot(
+    cyxchat_metrics_format_t format,
+    uint8_t *buf,
+    size_t buf_size,
+    size_t *len_out
+) {
+    if (!buf || !len_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    snap_writer_t w = { buf, buf_size, 0, 0 };
+
+    switch (format) {
+        case CYXCHAT_METRICS_BINARY:
+            snapshot_binary(&w);
+            break;
+        case CYXCHAT_METRICS_PROMETHEUS:
+            if (buf_size == 0) return CYXCHAT_ERR_FULL;
+            snapshot_prometheus(&w);
+            buf[w.len] = '\0';
+            break;
+        default:
+            return CYXCHAT_ERR_INVALID;
+    }
+
+    *len_out = w.len;
+    return w.full ? CYXCHAT_ERR_FULL : CYXCHAT_OK;
+}
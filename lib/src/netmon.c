@@ -0,0 +1,970 @@
+/**
+ * CyxChat Network Monitor Implementation
+ *
+ * A probe opens a fresh UDP socket, connects it to the STUN server (which
+ * makes the OS pick the current default-route source address) and sends
+ * an RFC 5389 Binding Request, retransmitting with doubling RTO. The
+ * mapped address in the response and the socket's local address are
+ * compared with the last probe; either one moving means the network
+ * changed. The probe socket is separate from the transport's, so its
+ * mapped port is only a hint - the public IP and local IP are what count.
+ *
+ * A STUN server given by name is looked up on a short-lived worker
+ * thread so getaddrinfo never blocks the poll; the probe timer checks
+ * back until the answer is in. A failed lookup is not retried until the
+ * routes change (or on the backoff schedule when routes are not watched).
+ *
+ * On Linux a non-blocking NETLINK_ROUTE socket subscribed to IPv4
+ * address/route and IPv6 address groups is read from poll; any event
+ * (re)starts a probe after a short settle window so a burst of DHCP
+ * and route updates produces one probe.
+ *
+ * When enabled, each new address also starts a binding lifetime search
+ * (RFC 5780 section 4.6): one socket takes a binding and goes quiet for
+ * the trial period, then a second socket sends a request carrying
+ * RESPONSE-PORT set to the first one's mapped port. A reply on the first
+ * socket means the binding survived; silence means the NAT dropped it;
+ * a reply on the second means the server ignored the attribute, and the
+ * default interval stays.
+ */
+
+#include <cyxchat/netmon.h>
+#include <cyxchat/connection.h>
+#include <cyxchat/keepalive.h>
+#include <cyxchat/rng.h>
+#include <cyxwiz/memory.h>
+#include <cyxwiz/log.h>
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+typedef SOCKET netmon_sock_t;
+#define NETMON_INVALID_SOCK INVALID_SOCKET
+#define netmon_close_sock   closesocket
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+typedef int netmon_sock_t;
+#define NETMON_INVALID_SOCK (-1)
+#define netmon_close_sock   close
+#endif
+
+#ifdef _MSC_VER
+#define NM_LOAD(p)          (*(volatile uint32_t *)(p))
+#define NM_STORE(p, v)      (*(volatile uint32_t *)(p) = (v))
+#define NM_UNREF(p)         ((uint32_t)_InterlockedDecrement((volatile long *)(p)))
+#else
+#define NM_LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define NM_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define NM_UNREF(p)         __atomic_sub_fetch((p), 1, __ATOMIC_ACQ_REL)
+#endif
+
+#if defined(__linux__)
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define NETMON_HAVE_NETLINK 1
+#endif
+
+/* STUN (RFC 5389) */
+#define STUN_HEADER_LEN         20
+#define STUN_BINDING_REQUEST    0x0001
+#define STUN_BINDING_SUCCESS    0x0101
+#define STUN_MAGIC_COOKIE       0x2112A442u
+#define STUN_ATTR_MAPPED        0x0001
+#define STUN_ATTR_XOR_MAPPED    0x0020
+#define STUN_ATTR_RESPONSE_PORT 0x0027  /* RFC 5780 */
+#define STUN_FAMILY_IPV4        0x01
+#define STUN_TXID_LEN           12
+
+/* Retry after a failed probe, doubling up to the probe interval */
+#define NETMON_RETRY_MS         5000
+
+/* Server name lookup */
+#define NETMON_LOOKUP_PENDING   0
+#define NETMON_LOOKUP_DONE      1
+#define NETMON_LOOKUP_FAILED    2
+
+/* Binding lifetime search */
+typedef enum {
+    NETMON_LIFE_OFF = 0,
+    NETMON_LIFE_BIND,                   /* Taking a binding on life_sock */
+    NETMON_LIFE_IDLE,                   /* Letting it sit for the trial */
+    NETMON_LIFE_TEST                    /* Asking for a reply on it */
+} netmon_life_phase_t;
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+/* Name lookup on a worker thread; freed by whichever side lets go last */
+typedef struct {
+    char host[64];
+    struct in_addr addr;                /* Valid once state is DONE */
+    uint32_t state;                     /* NETMON_LOOKUP_* */
+    uint32_t refs;                      /* Monitor and worker */
+} netmon_lookup_t;
+
+struct cyxchat_netmon {
+    cyxchat_timer_wheel_t *wheel;
+    cyxchat_timer_t probe_timer;        /* Next probe, or next check while waiting */
+
+    /* STUN server */
+    char host[64];
+    uint16_t port;                      /* Host byte order */
+    struct sockaddr_in server;
+    int resolved;
+    netmon_lookup_t *lookup;            /* Name lookup in flight */
+    int lookup_failed;                  /* Hold off until the routes change */
+
+    /* Outstanding probe */
+    netmon_sock_t sock;
+    uint8_t txid[STUN_TXID_LEN];
+    int waiting;
+    uint8_t tries;
+    uint64_t retransmit_at;
+    uint32_t probe_local_ip;
+    uint32_t retry_ms;
+
+    /* Route notifications */
+    netmon_sock_t route_sock;
+    uint64_t last_route_check;
+
+    uint32_t interval_ms;
+    int have_addr;
+    cyxchat_netmon_addr_t addr;
+
+    /* Binding lifetime search */
+    int life_enabled;
+    netmon_life_phase_t life_phase;
+    cyxchat_keepalive_t keepalive;
+    cyxchat_timer_t life_timer;
+    netmon_sock_t life_sock;            /* Holds the binding under test */
+    netmon_sock_t life_echo;            /* Asks for the reply on its port */
+    uint8_t life_txid[STUN_TXID_LEN];
+    uint16_t life_port;                 /* life_sock's mapped port (network order) */
+    uint8_t life_tries;
+    uint64_t life_retransmit_at;
+
+    cyxchat_netmon_change_cb_t on_change;
+    void *on_change_data;
+
+    cyxchat_netmon_stats_t stats;
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static void on_probe_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+static void life_start(cyxchat_netmon_t *nm);
+
+static void schedule_probe(cyxchat_netmon_t *nm, uint64_t at)
+{
+    cyxchat_timer_schedule(nm->wheel, &nm->probe_timer, at, on_probe_timer, nm);
+}
+
+static int set_nonblocking(netmon_sock_t s)
+{
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+static void close_probe(cyxchat_netmon_t *nm)
+{
+    if (nm->sock != NETMON_INVALID_SOCK) {
+        netmon_close_sock(nm->sock);
+        nm->sock = NETMON_INVALID_SOCK;
+    }
+    nm->waiting = 0;
+}
+
+static void lookup_unref(netmon_lookup_t *lk)
+{
+    if (NM_UNREF(&lk->refs) == 0) {
+        free(lk);
+    }
+}
+
+#ifdef _WIN32
+static DWORD WINAPI lookup_main(LPVOID arg)
+#else
+static void *lookup_main(void *arg)
+#endif
+{
+    netmon_lookup_t *lk = (netmon_lookup_t*)arg;
+    struct addrinfo hints, *result;
+    uint32_t state = NETMON_LOOKUP_FAILED;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (getaddrinfo(lk->host, NULL, &hints, &result) == 0) {
+        lk->addr = ((struct sockaddr_in*)result->ai_addr)->sin_addr;
+        freeaddrinfo(result);
+        state = NETMON_LOOKUP_DONE;
+    }
+
+    NM_STORE(&lk->state, state);
+    lookup_unref(lk);
+    return 0;
+}
+
+/* Hand the host name to a detached worker; returns 0 if none started */
+static int lookup_start(cyxchat_netmon_t *nm)
+{
+    netmon_lookup_t *lk = calloc(1, sizeof(netmon_lookup_t));
+    if (!lk) return 0;
+
+    memcpy(lk->host, nm->host, sizeof(lk->host));
+    lk->state = NETMON_LOOKUP_PENDING;
+    lk->refs = 2;
+
+#ifdef _WIN32
+    HANDLE thread = CreateThread(NULL, 0, lookup_main, lk, 0, NULL);
+    if (!thread) {
+        free(lk);
+        return 0;
+    }
+    CloseHandle(thread);
+#else
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, lookup_main, lk) != 0) {
+        free(lk);
+        return 0;
+    }
+    pthread_detach(thread);
+#endif
+
+    nm->lookup = lk;
+    return 1;
+}
+
+static void lookup_drop(cyxchat_netmon_t *nm)
+{
+    if (nm->lookup) {
+        lookup_unref(nm->lookup);
+        nm->lookup = NULL;
+    }
+}
+
+/* 1 when the server address is known, 0 while looking it up, -1 on failure */
+static int resolve_server(cyxchat_netmon_t *nm)
+{
+    if (nm->resolved) return 1;
+    if (nm->lookup_failed) return -1;
+
+    memset(&nm->server, 0, sizeof(nm->server));
+    nm->server.sin_family = AF_INET;
+    nm->server.sin_port = htons(nm->port);
+
+    if (inet_pton(AF_INET, nm->host, &nm->server.sin_addr) == 1) {
+        nm->resolved = 1;
+        return 1;
+    }
+
+    if (!nm->lookup) {
+        return lookup_start(nm) ? 0 : -1;
+    }
+
+    uint32_t state = NM_LOAD(&nm->lookup->state);
+    if (state == NETMON_LOOKUP_PENDING) return 0;
+
+    if (state == NETMON_LOOKUP_DONE) {
+        nm->server.sin_addr = nm->lookup->addr;
+        nm->resolved = 1;
+    } else {
+        CYXWIZ_DEBUG("STUN server %s did not resolve", nm->host);
+        /* Asking again only helps once the network is different */
+        nm->lookup_failed = nm->route_sock != NETMON_INVALID_SOCK;
+    }
+    lookup_drop(nm);
+    return nm->resolved ? 1 : -1;
+}
+
+/* Non-blocking UDP socket connected to the STUN server */
+static netmon_sock_t open_server_sock(const cyxchat_netmon_t *nm)
+{
+    netmon_sock_t s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == NETMON_INVALID_SOCK) return s;
+
+    if (!set_nonblocking(s) ||
+        connect(s, (const struct sockaddr*)&nm->server, sizeof(nm->server)) != 0) {
+        netmon_close_sock(s);
+        return NETMON_INVALID_SOCK;
+    }
+    return s;
+}
+
+/* Binding Request; RESPONSE-PORT (network order) is added when non-zero */
+static int stun_send(netmon_sock_t s, const uint8_t *txid, uint16_t response_port)
+{
+    uint8_t msg[STUN_HEADER_LEN + 8];
+    size_t len = STUN_HEADER_LEN;
+    uint32_t cookie = htonl(STUN_MAGIC_COOKIE);
+
+    if (response_port) {
+        msg[len++] = (uint8_t)(STUN_ATTR_RESPONSE_PORT >> 8);
+        msg[len++] = (uint8_t)(STUN_ATTR_RESPONSE_PORT & 0xFF);
+        msg[len++] = 0;
+        msg[len++] = 4;
+        memcpy(msg + len, &response_port, 2);
+        msg[len + 2] = 0;                   /* Padding */
+        msg[len + 3] = 0;
+        len += 4;
+    }
+
+    msg[0] = (uint8_t)(STUN_BINDING_REQUEST >> 8);
+    msg[1] = (uint8_t)(STUN_BINDING_REQUEST & 0xFF);
+    msg[2] = (uint8_t)((len - STUN_HEADER_LEN) >> 8);
+    msg[3] = (uint8_t)((len - STUN_HEADER_LEN) & 0xFF);
+    memcpy(msg + 4, &cookie, 4);
+    memcpy(msg + 8, txid, STUN_TXID_LEN);
+
+    return send(s, (const char*)msg, (int)len, 0) == (int)len;
+}
+
+static int send_request(cyxchat_netmon_t *nm)
+{
+    nm->stats.requests_sent++;
+    return stun_send(nm->sock, nm->txid, 0);
+}
+
+/* Any response (success or error) to our transaction */
+static int stun_is_reply(const uint8_t *txid, const uint8_t *buf, size_t len)
+{
+    uint32_t cookie;
+    if (len < STUN_HEADER_LEN) return 0;
+    memcpy(&cookie, buf + 4, 4);
+    return (buf[0] & 0xC0) == 0 && ntohl(cookie) == STUN_MAGIC_COOKIE &&
+           memcmp(buf + 8, txid, STUN_TXID_LEN) == 0;
+}
+
+/* Extract the mapped IPv4 address from a Binding Success response */
+static int parse_response(const uint8_t *txid, const uint8_t *buf, size_t len,
+                          uint32_t *ip_out, uint16_t *port_out)
+{
+    if (!stun_is_reply(txid, buf, len)) return 0;
+
+    uint16_t type = (uint16_t)((buf[0] << 8) | buf[1]);
+    size_t body = (size_t)((buf[2] << 8) | buf[3]);
+    uint32_t cookie;
+    memcpy(&cookie, buf + 4, 4);
+
+    if (type != STUN_BINDING_SUCCESS || STUN_HEADER_LEN + body > len) {
+        return 0;
+    }
+
+    int found = 0;
+    size_t off = STUN_HEADER_LEN;
+    size_t end = STUN_HEADER_LEN + body;
+
+    while (off + 4 <= end) {
+        uint16_t attr = (uint16_t)((buf[off] << 8) | buf[off + 1]);
+        size_t alen = (size_t)((buf[off + 2] << 8) | buf[off + 3]);
+        const uint8_t *v = buf + off + 4;
+
+        if (off + 4 + alen > end) break;
+
+        if ((attr == STUN_ATTR_XOR_MAPPED || (attr == STUN_ATTR_MAPPED && !found)) &&
+            alen >= 8 && v[1] == STUN_FAMILY_IPV4) {
+            uint16_t port;
+            uint32_t ip;
+            memcpy(&port, v + 2, 2);
+            memcpy(&ip, v + 4, 4);
+            if (attr == STUN_ATTR_XOR_MAPPED) {
+                port ^= htons((uint16_t)(STUN_MAGIC_COOKIE >> 16));
+                ip ^= cookie;
+            }
+            *ip_out = ip;
+            *port_out = port;
+            found = 1;
+            if (attr == STUN_ATTR_XOR_MAPPED) break;
+        }
+
+        off += 4 + ((alen + 3) & ~(size_t)3);
+    }
+
+    return found;
+}
+
+/* Open a probe socket and send the first request; 0 while the server
+ * name is still being looked up, -1 on failure */
+static int start_probe(cyxchat_netmon_t *nm, uint64_t now)
+{
+    if (nm->waiting) return 1;
+
+    int resolved = resolve_server(nm);
+    if (resolved <= 0) {
+        if (resolved < 0) nm->stats.probes++;
+        return resolved;
+    }
+
+    nm->stats.probes++;
+
+    nm->sock = open_server_sock(nm);
+    if (nm->sock == NETMON_INVALID_SOCK) return -1;
+
+    /* Connected socket carries the source address the OS routes with */
+    struct sockaddr_in local;
+    socklen_t local_len = sizeof(local);
+    memset(&local, 0, sizeof(local));
+    getsockname(nm->sock, (struct sockaddr*)&local, &local_len);
+    nm->probe_local_ip = local.sin_addr.s_addr;
+
+    cyxchat_rng_bytes(cyxchat_rng_default(), nm->txid, STUN_TXID_LEN);
+    nm->waiting = 1;
+    nm->tries = 1;
+    nm->retransmit_at = now + CYXCHAT_NETMON_RTO_MS;
+
+    if (!send_request(nm)) {
+        /* No route yet; retransmits keep trying */
+        CYXWIZ_DEBUG("STUN request send failed");
+    }
+    return 1;
+}
+
+/* Probe failed; back off towards the regular interval */
+static void probe_failed(cyxchat_netmon_t *nm, uint64_t now)
+{
+    close_probe(nm);
+    nm->stats.timeouts++;
+
+    uint32_t delay = nm->retry_ms ? nm->retry_ms : NETMON_RETRY_MS;
+    if (delay > nm->interval_ms) delay = nm->interval_ms;
+    nm->retry_ms = delay * 2;
+
+    schedule_probe(nm, now + delay);
+}
+
+/* Drain the probe socket; returns 1 if the address changed */
+static int read_response(cyxchat_netmon_t *nm)
+{
+    uint8_t buf[548];
+
+    while (nm->waiting) {
+        int n = (int)recv(nm->sock, (char*)buf, sizeof(buf), 0);
+        if (n <= 0) return 0;
+
+        cyxchat_netmon_addr_t now_addr;
+        if (!parse_response(nm->txid, buf, (size_t)n, &now_addr.public_ip,
+                            &now_addr.public_port)) {
+            continue;
+        }
+        now_addr.local_ip = nm->probe_local_ip;
+
+        close_probe(nm);
+        nm->stats.responses++;
+        nm->retry_ms = 0;
+        schedule_probe(nm, cyxchat_timer_now(nm->wheel) + nm->interval_ms);
+
+        int changed = !nm->have_addr ||
+                      now_addr.public_ip != nm->addr.public_ip ||
+                      now_addr.local_ip != nm->addr.local_ip;
+
+        cyxchat_netmon_addr_t old_addr = nm->addr;
+        int had_addr = nm->have_addr;
+        nm->addr = now_addr;
+        nm->have_addr = 1;
+
+        if (!changed) return 0;
+
+        nm->stats.changes++;
+        if (nm->life_enabled) {
+            /* A different network means a different NAT */
+            life_start(nm);
+        }
+        if (nm->on_change) {
+            nm->on_change(nm, had_addr ? &old_addr : NULL, &now_addr, nm->on_change_data);
+        }
+        return 1;
+    }
+
+    return 0;
+}
+
+/* Drain route notifications; returns number of relevant events */
+static int read_routes(cyxchat_netmon_t *nm)
+{
+#ifdef NETMON_HAVE_NETLINK
+    uint8_t buf[4096];
+    int events = 0;
+
+    for (;;) {
+        ssize_t n = recv(nm->route_sock, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) break;
+
+        size_t left = (size_t)n;
+        for (struct nlmsghdr *h = (struct nlmsghdr*)buf; NLMSG_OK(h, left);
+             h = NLMSG_NEXT(h, left)) {
+            switch (h->nlmsg_type) {
+                case RTM_NEWADDR:
+                case RTM_DELADDR:
+                case RTM_NEWROUTE:
+                case RTM_DELROUTE:
+                    events++;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    return events;
+#else
+    (void)nm;
+    return 0;
+#endif
+}
+
+static void open_route_socket(cyxchat_netmon_t *nm)
+{
+#ifdef NETMON_HAVE_NETLINK
+    int s = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (s < 0) return;
+
+    struct sockaddr_nl sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.nl_family = AF_NETLINK;
+    sa.nl_groups = RTMGRP_IPV4_IFADDR | RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_IFADDR;
+
+    /* Sandboxed apps (e.g. recent Android) may not bind; fall back to periodic */
+    if (bind(s, (struct sockaddr*)&sa, sizeof(sa)) != 0) {
+        close(s);
+        CYXWIZ_DEBUG("Route notifications unavailable, using periodic STUN only");
+        return;
+    }
+    nm->route_sock = s;
+#else
+    (void)nm;
+#endif
+}
+
+/* Probe timer: start a probe, or check / retransmit the outstanding one */
+static void on_probe_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    cyxchat_netmon_t *nm = (cyxchat_netmon_t*)user_data;
+
+    if (!nm->waiting) {
+        int started = start_probe(nm, now_ms);
+        if (started < 0) {
+            probe_failed(nm, now_ms);
+            return;
+        }
+        if (!started) {
+            schedule_probe(nm, now_ms + CYXCHAT_NETMON_CHECK_MS);
+            return;
+        }
+    } else {
+        if (read_response(nm) || !nm->waiting) return;
+
+        if (now_ms >= nm->retransmit_at) {
+            if (nm->tries >= CYXCHAT_NETMON_MAX_TRIES) {
+                probe_failed(nm, now_ms);
+                return;
+            }
+            send_request(nm);
+            nm->retransmit_at = now_ms + ((uint64_t)CYXCHAT_NETMON_RTO_MS << nm->tries);
+            nm->tries++;
+        }
+    }
+
+    uint64_t next = now_ms + CYXCHAT_NETMON_CHECK_MS;
+    schedule_probe(nm, next < nm->retransmit_at ? next : nm->retransmit_at);
+}
+
+/* ============================================================
+ * Binding Lifetime
+ * ============================================================ */
+
+static void on_life_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+static void schedule_life(cyxchat_netmon_t *nm, uint64_t at)
+{
+    cyxchat_timer_schedule(nm->wheel, &nm->life_timer, at, on_life_timer, nm);
+}
+
+static void close_life_echo(cyxchat_netmon_t *nm)
+{
+    if (nm->life_echo != NETMON_INVALID_SOCK) {
+        netmon_close_sock(nm->life_echo);
+        nm->life_echo = NETMON_INVALID_SOCK;
+    }
+}
+
+static void life_stop(cyxchat_netmon_t *nm)
+{
+    cyxchat_timer_cancel(nm->wheel, &nm->life_timer);
+    close_life_echo(nm);
+    if (nm->life_sock != NETMON_INVALID_SOCK) {
+        netmon_close_sock(nm->life_sock);
+        nm->life_sock = NETMON_INVALID_SOCK;
+    }
+    nm->life_phase = NETMON_LIFE_OFF;
+}
+
+/* Nothing to test on; start over at the next refresh */
+static void life_retry(cyxchat_netmon_t *nm, uint64_t now)
+{
+    life_stop(nm);
+    schedule_life(nm, now + nm->interval_ms);
+}
+
+/* Open (or refresh) the binding under test */
+static void life_bind(cyxchat_netmon_t *nm, uint64_t now)
+{
+    if (nm->life_sock == NETMON_INVALID_SOCK) {
+        if (resolve_server(nm) <= 0) {
+            life_retry(nm, now);
+            return;
+        }
+        nm->life_sock = open_server_sock(nm);
+        if (nm->life_sock == NETMON_INVALID_SOCK) {
+            life_retry(nm, now);
+            return;
+        }
+    }
+
+    cyxchat_rng_bytes(cyxchat_rng_default(), nm->life_txid, STUN_TXID_LEN);
+    stun_send(nm->life_sock, nm->life_txid, 0);
+    nm->life_phase = NETMON_LIFE_BIND;
+    nm->life_tries = 1;
+    nm->life_retransmit_at = now + CYXCHAT_NETMON_RTO_MS;
+    schedule_life(nm, now + CYXCHAT_NETMON_CHECK_MS);
+}
+
+/* Idle period over: ask for a reply on the bound port from another one */
+static void life_test(cyxchat_netmon_t *nm, uint64_t now)
+{
+    nm->life_echo = open_server_sock(nm);
+    if (nm->life_echo == NETMON_INVALID_SOCK) {
+        life_retry(nm, now);
+        return;
+    }
+
+    cyxchat_rng_bytes(cyxchat_rng_default(), nm->life_txid, STUN_TXID_LEN);
+    stun_send(nm->life_echo, nm->life_txid, nm->life_port);
+    nm->life_phase = NETMON_LIFE_TEST;
+    nm->life_tries = 1;
+    nm->life_retransmit_at = now + CYXCHAT_NETMON_RTO_MS;
+    schedule_life(nm, now + CYXCHAT_NETMON_CHECK_MS);
+}
+
+static void life_start(cyxchat_netmon_t *nm)
+{
+    life_stop(nm);
+    cyxchat_keepalive_init(&nm->keepalive);
+    life_bind(nm, cyxchat_timer_now(nm->wheel));
+}
+
+/* Trial over: record it and bind for the next one, if any */
+static void life_result(cyxchat_netmon_t *nm, uint64_t now, int alive)
+{
+    close_life_echo(nm);
+    nm->stats.lifetime_trials++;
+    cyxchat_keepalive_on_trial(&nm->keepalive, alive);
+
+    if (nm->keepalive.trial_ms) {
+        life_bind(nm, now);
+        return;
+    }
+
+    CYXWIZ_INFO("NAT binding lives %u ms, keepalive every %u ms",
+                nm->keepalive.alive_ms, nm->keepalive.interval_ms);
+    life_stop(nm);
+}
+
+/* Drain the lifetime sockets; returns 1 if the phase moved on */
+static int life_read(cyxchat_netmon_t *nm, uint64_t now)
+{
+    uint8_t buf[548];
+    int n;
+
+    if (nm->life_phase == NETMON_LIFE_BIND) {
+        while ((n = (int)recv(nm->life_sock, (char*)buf, sizeof(buf), 0)) > 0) {
+            uint32_t ip;
+            uint16_t port;
+            if (!parse_response(nm->life_txid, buf, (size_t)n, &ip, &port)) continue;
+
+            nm->life_port = port;
+            nm->life_phase = NETMON_LIFE_IDLE;
+            schedule_life(nm, now + nm->keepalive.trial_ms);
+            return 1;
+        }
+    } else if (nm->life_phase == NETMON_LIFE_TEST) {
+        while ((n = (int)recv(nm->life_echo, (char*)buf, sizeof(buf), 0)) > 0) {
+            if (!stun_is_reply(nm->life_txid, buf, (size_t)n)) continue;
+
+            /* Answered (or refused) on the asking port: no RESPONSE-PORT */
+            CYXWIZ_DEBUG("STUN server %s cannot test binding lifetime", nm->host);
+            cyxchat_keepalive_unsupported(&nm->keepalive);
+            life_stop(nm);
+            return 1;
+        }
+        while ((n = (int)recv(nm->life_sock, (char*)buf, sizeof(buf), 0)) > 0) {
+            if (!stun_is_reply(nm->life_txid, buf, (size_t)n)) continue;
+
+            life_result(nm, now, 1);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/* Lifetime timer: bind, wait, test, and retransmit while waiting on a reply */
+static void on_life_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    cyxchat_netmon_t *nm = (cyxchat_netmon_t*)user_data;
+
+    switch (nm->life_phase) {
+        case NETMON_LIFE_OFF:
+            life_bind(nm, now_ms);
+            return;
+        case NETMON_LIFE_IDLE:
+            life_test(nm, now_ms);
+            return;
+        default:
+            break;
+    }
+
+    if (life_read(nm, now_ms)) return;
+
+    if (now_ms >= nm->life_retransmit_at) {
+        int testing = nm->life_phase == NETMON_LIFE_TEST;
+        if (nm->life_tries >= CYXCHAT_NETMON_MAX_TRIES) {
+            if (testing) {
+                /* The NAT dropped the binding */
+                life_result(nm, now_ms, 0);
+            } else {
+                life_retry(nm, now_ms);
+            }
+            return;
+        }
+        stun_send(testing ? nm->life_echo : nm->life_sock, nm->life_txid,
+                  testing ? nm->life_port : 0);
+        nm->life_retransmit_at = now_ms + ((uint64_t)CYXCHAT_NETMON_RTO_MS << nm->life_tries);
+        nm->life_tries++;
+    }
+
+    uint64_t next = now_ms + CYXCHAT_NETMON_CHECK_MS;
+    schedule_life(nm, next < nm->life_retransmit_at ? next : nm->life_retransmit_at);
+}
+
+/* ============================================================
+ * Lifecycle
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_netmon_create(
+    cyxchat_netmon_t **nm,
+    cyxchat_timer_wheel_t *wheel,
+    const char *stun_server
+) {
+    if (!nm || !wheel) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_netmon_t *m = calloc(1, sizeof(cyxchat_netmon_t));
+    if (!m) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    m->wheel = wheel;
+    m->sock = NETMON_INVALID_SOCK;
+    m->route_sock = NETMON_INVALID_SOCK;
+    m->life_sock = NETMON_INVALID_SOCK;
+    m->life_echo = NETMON_INVALID_SOCK;
+    m->interval_ms = CYXCHAT_STUN_INTERVAL_MS;
+    cyxchat_keepalive_init(&m->keepalive);
+
+    cyxchat_error_t err = cyxchat_netmon_set_server(
+        m, stun_server ? stun_server : CYXCHAT_NETMON_DEFAULT_STUN);
+    if (err != CYXCHAT_OK) {
+        free(m);
+        return err;
+    }
+
+    open_route_socket(m);
+
+    /* First probe on the next advance */
+    schedule_probe(m, cyxchat_timer_now(wheel));
+
+    *nm = m;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_netmon_destroy(cyxchat_netmon_t *nm)
+{
+    if (!nm) return;
+
+    cyxchat_timer_cancel(nm->wheel, &nm->probe_timer);
+    close_probe(nm);
+    life_stop(nm);
+    lookup_drop(nm);
+    if (nm->route_sock != NETMON_INVALID_SOCK) {
+        netmon_close_sock(nm->route_sock);
+    }
+
+    cyxwiz_secure_zero(nm, sizeof(cyxchat_netmon_t));
+    free(nm);
+}
+
+/* ============================================================
+ * Probing
+ * ============================================================ */
+
+int cyxchat_netmon_poll(cyxchat_netmon_t *nm)
+{
+    if (!nm) return 0;
+
+    int changes = 0;
+    uint64_t now = cyxchat_timer_now(nm->wheel);
+
+    if (nm->waiting) {
+        changes += read_response(nm);
+    }
+
+    if (nm->life_phase == NETMON_LIFE_BIND || nm->life_phase == NETMON_LIFE_TEST) {
+        life_read(nm, now);
+    }
+
+    if (nm->route_sock != NETMON_INVALID_SOCK &&
+        now - nm->last_route_check >= CYXCHAT_NETMON_ROUTE_CHECK_MS) {
+        nm->last_route_check = now;
+
+        int events = read_routes(nm);
+        if (events > 0) {
+            nm->stats.route_events += (uint64_t)events;
+            nm->retry_ms = 0;
+            nm->lookup_failed = 0;
+
+            /* A probe sent before the change may report the old path */
+            close_probe(nm);
+            uint64_t at = now + CYXCHAT_NETMON_SETTLE_MS;
+            if (!cyxchat_timer_pending(&nm->probe_timer) || nm->probe_timer.expires > at) {
+                schedule_probe(nm, at);
+            }
+        }
+    }
+
+    return changes;
+}
+
+cyxchat_error_t cyxchat_netmon_refresh(cyxchat_netmon_t *nm)
+{
+    if (!nm) return CYXCHAT_ERR_NULL;
+
+    uint64_t now = cyxchat_timer_now(nm->wheel);
+
+    close_probe(nm);
+    nm->retry_ms = 0;
+    nm->lookup_failed = 0;
+    if (start_probe(nm, now) < 0) {
+        probe_failed(nm, now);
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    schedule_probe(nm, now + CYXCHAT_NETMON_CHECK_MS);
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_netmon_set_server(cyxchat_netmon_t *nm, const char *stun_server)
+{
+    if (!nm || !stun_server) return CYXCHAT_ERR_NULL;
+
+    const char *colon = strrchr(stun_server, ':');
+    if (!colon) return CYXCHAT_ERR_INVALID;
+
+    size_t host_len = (size_t)(colon - stun_server);
+    int port = atoi(colon + 1);
+    if (host_len == 0 || host_len >= sizeof(nm->host) || port <= 0 || port > 65535) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    memcpy(nm->host, stun_server, host_len);
+    nm->host[host_len] = '\0';
+    nm->port = (uint16_t)port;
+    nm->resolved = 0;
+    nm->lookup_failed = 0;
+    lookup_drop(nm);
+
+    return CYXCHAT_OK;
+}
+
+void cyxchat_netmon_set_interval(cyxchat_netmon_t *nm, uint32_t interval_ms)
+{
+    if (!nm) return;
+    nm->interval_ms = interval_ms ? interval_ms : CYXCHAT_STUN_INTERVAL_MS;
+}
+
+void cyxchat_netmon_set_on_change(
+    cyxchat_netmon_t *nm,
+    cyxchat_netmon_change_cb_t callback,
+    void *user_data
+) {
+    if (!nm) return;
+    nm->on_change = callback;
+    nm->on_change_data = user_data;
+}
+
+void cyxchat_netmon_set_lifetime_probe(cyxchat_netmon_t *nm, int enabled)
+{
+    if (!nm || !enabled == !nm->life_enabled) return;
+
+    nm->life_enabled = enabled ? 1 : 0;
+    if (!enabled) {
+        life_stop(nm);
+    } else if (nm->have_addr) {
+        life_start(nm);
+    }
+}
+
+void cyxchat_netmon_get_keepalive(cyxchat_netmon_t *nm, cyxchat_keepalive_t *ka_out)
+{
+    if (!ka_out) return;
+
+    if (!nm) {
+        cyxchat_keepalive_init(ka_out);
+        return;
+    }
+    *ka_out = nm->keepalive;
+}
+
+cyxchat_error_t cyxchat_netmon_get_addr(cyxchat_netmon_t *nm, cyxchat_netmon_addr_t *addr_out)
+{
+    if (!nm || !addr_out) return CYXCHAT_ERR_NULL;
+    if (!nm->have_addr) return CYXCHAT_ERR_NETWORK;
+
+    *addr_out = nm->addr;
+    return CYXCHAT_OK;
+}
+
+int cyxchat_netmon_watches_routes(cyxchat_netmon_t *nm)
+{
+    return nm && nm->route_sock != NETMON_INVALID_SOCK;
+}
+
+void cyxchat_netmon_get_stats(cyxchat_netmon_t *nm, cyxchat_netmon_stats_t *stats_out)
+{
+    if (!nm || !stats_out) return;
+    *stats_out = nm->stats;
+}
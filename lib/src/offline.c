@@ -0,0 +1,1061 @@
+/**
+ * CyxChat Offline Delivery Implementation
+ *
+ * One context plays all three parts. As a sender it keeps an outbox of
+ * sealed items, flushed one PUT per mailbox key and replica, and
+ * forgets an item at its first ACK. As a storage node it holds other
+ * nodes' items in a fixed table, carved after the struct, until they
+ * expire or their recipient deletes them. As a recipient it pages
+ * through its own keys on every replica at once, decrypts, and deletes
+ * what it delivered.
+ *
+ * Storage nodes only see the mailbox key, the item ID, the hash of the
+ * delete token and the sealed blob; sender, recipient and content stay
+ * inside the seal. The seal itself is anonymous, so the sender signs
+ * what it seals: node IDs are Ed25519 public keys, and the recipient
+ * verifies against the ID the item claims before handing it up.
+ */
+
+#include <cyxchat/offline.h>
+#include <cyxchat/rng.h>
+#include <cyxchat/metrics.h>
+#include <cyxwiz/crypto.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+/* ============================================================
+ * Constants
+ * ============================================================ */
+
+#define OFFLINE_KEY_SIZE        32
+#define OFFLINE_GETS            (CYXCHAT_OFFLINE_SLOTS * CYXCHAT_OFFLINE_REPLICAS)
+
+/* Encoded sizes */
+#define PUT_HEADER_SIZE         38      /* Type + key + TTL + count */
+#define PUT_ITEM_HEADER         26      /* Item ID + drop hash + length */
+#define ACK_HEADER_SIZE         34      /* Type + key + count */
+#define GET_SIZE                41      /* Type + req_id + key + after */
+#define ITEMS_HEADER_SIZE       7       /* Type + req_id + more + count */
+#define ITEMS_ITEM_HEADER       14      /* Serial + item ID + length */
+#define DELETE_HEADER_SIZE      34      /* Type + key + count */
+#define DELETE_ITEM_SIZE        (8 + CYXCHAT_OFFLINE_TOKEN_SIZE)
+
+/* Sealed plaintext: sender, delete token, signature, message */
+#define PLAIN_SIG_OFFSET        (32 + CYXCHAT_OFFLINE_TOKEN_SIZE)
+#define PLAIN_HEADER_SIZE       (PLAIN_SIG_OFFSET + CYXCHAT_OFFLINE_SIG_SIZE)
+
+/* Signed: recipient, sender, delete token, message */
+#define SIGNED_HEADER_SIZE      (32 + PLAIN_SIG_OFFSET)
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+/* Own item waiting for a storage ACK */
+typedef struct {
+    uint8_t in_use;
+    uint8_t attempts;                   /* PUTs sent so far */
+    uint16_t blob_len;
+    uint64_t item_id;
+    uint64_t due_ms;                    /* Next PUT */
+    cyxwiz_node_id_t to;
+    uint8_t key[OFFLINE_KEY_SIZE];
+    uint8_t drop_hash[CYXCHAT_OFFLINE_TOKEN_SIZE];
+    uint8_t blob[CYXCHAT_OFFLINE_BLOB_MAX];
+} offline_outbox_t;
+
+/* Item held for another node */
+typedef struct {
+    uint8_t in_use;
+    uint16_t blob_len;
+    uint32_t serial;                    /* Arrival order, the GET cursor */
+    uint64_t item_id;
+    uint64_t expires_ms;
+    uint8_t key[OFFLINE_KEY_SIZE];
+    uint8_t drop_hash[CYXCHAT_OFFLINE_TOKEN_SIZE];
+    uint8_t blob[CYXCHAT_OFFLINE_BLOB_MAX];
+} offline_item_t;
+
+/* GET in flight to one replica of one of our keys */
+typedef struct {
+    uint8_t in_use;
+    uint8_t slot;
+    uint32_t req_id;
+    uint32_t after;                     /* Highest serial seen */
+    uint64_t deadline_ms;
+    cyxwiz_node_id_t node;
+} offline_get_t;
+
+/* Drained item, kept to delete its copies on the other replicas */
+typedef struct {
+    uint64_t item_id;
+    uint8_t token[CYXCHAT_OFFLINE_TOKEN_SIZE];
+} offline_seen_t;
+
+struct cyxchat_offline_ctx {
+    cyxwiz_node_id_t local_id;
+    uint8_t public_key[32];
+    uint8_t secret_key[32];
+    uint8_t signing_key[64];
+    uint8_t can_sign;
+    uint8_t own_keys[CYXCHAT_OFFLINE_SLOTS][OFFLINE_KEY_SIZE];
+
+    /* Storage (carved) */
+    offline_item_t *store;
+    size_t store_size;
+    uint32_t next_serial;
+
+    offline_outbox_t outbox[CYXCHAT_OFFLINE_OUTBOX_SIZE];
+    offline_get_t gets[OFFLINE_GETS];
+    offline_seen_t seen[CYXCHAT_OFFLINE_SEEN];
+    size_t seen_next;
+    uint32_t next_req_id;
+
+    uint64_t now_ms;                    /* Time of the last poll */
+    uint64_t next_drain_ms;
+
+    /* Transport */
+    cyxchat_offline_send_fn send;
+    cyxchat_offline_closest_fn closest;
+    void *transport_data;
+    cyxchat_offline_key_fn key_lookup;
+    void *key_data;
+
+    /* Callbacks */
+    cyxchat_offline_message_callback_t on_message;
+    void *on_message_data;
+    cyxchat_offline_stored_callback_t on_stored;
+    void *on_stored_data;
+
+    cyxchat_offline_stats_t stats;
+    size_t footprint;
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static void put_u16(uint8_t *buf, uint16_t v)
+{
+    buf[0] = (uint8_t)(v & 0xFF);
+    buf[1] = (uint8_t)(v >> 8);
+}
+
+static uint16_t get_u16(const uint8_t *buf)
+{
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+static void put_u32(uint8_t *buf, uint32_t v)
+{
+    buf[0] = (uint8_t)(v & 0xFF);
+    buf[1] = (uint8_t)((v >> 8) & 0xFF);
+    buf[2] = (uint8_t)((v >> 16) & 0xFF);
+    buf[3] = (uint8_t)((v >> 24) & 0xFF);
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) |
+           ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+static void put_u64(uint8_t *buf, uint64_t v)
+{
+    put_u32(buf, (uint32_t)v);
+    put_u32(buf + 4, (uint32_t)(v >> 32));
+}
+
+static uint64_t get_u64(const uint8_t *buf)
+{
+    return (uint64_t)get_u32(buf) | ((uint64_t)get_u32(buf + 4) << 32);
+}
+
+static void token_hash(const uint8_t *token, uint8_t *hash_out)
+{
+    cyxwiz_crypto_hash(token, CYXCHAT_OFFLINE_TOKEN_SIZE, hash_out, CYXCHAT_OFFLINE_TOKEN_SIZE);
+}
+
+/* What the sender signs: the recipient, then the plaintext bar the signature */
+static size_t signed_data(const cyxwiz_node_id_t *to, const uint8_t *plain, size_t plain_len,
+                          uint8_t *out)
+{
+    memcpy(out, to->bytes, 32);
+    memcpy(out + 32, plain, PLAIN_SIG_OFFSET);
+    memcpy(out + SIGNED_HEADER_SIZE, plain + PLAIN_HEADER_SIZE, plain_len - PLAIN_HEADER_SIZE);
+    return SIGNED_HEADER_SIZE + plain_len - PLAIN_HEADER_SIZE;
+}
+
+static size_t find_replicas(cyxchat_offline_ctx_t *ctx, const uint8_t *key,
+                            cyxwiz_node_id_t *nodes)
+{
+    if (!ctx->send || !ctx->closest) return 0;
+
+    cyxwiz_node_id_t target;
+    memcpy(target.bytes, key, OFFLINE_KEY_SIZE);
+    size_t n = ctx->closest(ctx->transport_data, &target, nodes, CYXCHAT_OFFLINE_REPLICAS);
+    return n < CYXCHAT_OFFLINE_REPLICAS ? n : CYXCHAT_OFFLINE_REPLICAS;
+}
+
+static int send_frame(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                      const uint8_t *frame, size_t len)
+{
+    if (!ctx->send) return 0;
+    return ctx->send(ctx->transport_data, to, frame, len) == CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Storage Node
+ * ============================================================ */
+
+static offline_item_t* store_find(cyxchat_offline_ctx_t *ctx, const uint8_t *key,
+                                  uint64_t item_id)
+{
+    for (size_t i = 0; i < ctx->store_size; i++) {
+        offline_item_t *it = &ctx->store[i];
+        if (it->in_use && it->item_id == item_id &&
+            memcmp(it->key, key, OFFLINE_KEY_SIZE) == 0) {
+            return it;
+        }
+    }
+    return NULL;
+}
+
+static void store_free(cyxchat_offline_ctx_t *ctx, offline_item_t *it)
+{
+    cyxwiz_secure_zero(it, sizeof(*it));
+    ctx->stats.held--;
+}
+
+static void store_expire(cyxchat_offline_ctx_t *ctx)
+{
+    for (size_t i = 0; i < ctx->store_size; i++) {
+        offline_item_t *it = &ctx->store[i];
+        if (it->in_use && it->expires_ms <= ctx->now_ms) {
+            store_free(ctx, it);
+        }
+    }
+}
+
+/* Store one PUT item; 1 if it is held (now or already) */
+static int store_put(cyxchat_offline_ctx_t *ctx, const uint8_t *key, uint64_t item_id,
+                     const uint8_t *drop_hash, const uint8_t *blob, uint16_t blob_len,
+                     uint64_t expires_ms)
+{
+    if (store_find(ctx, key, item_id)) {
+        return 1;   /* Resent after a lost ACK */
+    }
+
+    offline_item_t *slot = NULL;
+    size_t per_key = 0;
+    for (size_t i = 0; i < ctx->store_size; i++) {
+        offline_item_t *it = &ctx->store[i];
+        if (!it->in_use) {
+            if (!slot) slot = it;
+        } else if (memcmp(it->key, key, OFFLINE_KEY_SIZE) == 0) {
+            per_key++;
+        }
+    }
+    if (!slot || per_key >= CYXCHAT_OFFLINE_PER_KEY) {
+        ctx->stats.items_refused++;
+        return 0;
+    }
+
+    slot->in_use = 1;
+    slot->serial = ++ctx->next_serial;
+    slot->item_id = item_id;
+    slot->expires_ms = expires_ms;
+    slot->blob_len = blob_len;
+    memcpy(slot->key, key, OFFLINE_KEY_SIZE);
+    memcpy(slot->drop_hash, drop_hash, CYXCHAT_OFFLINE_TOKEN_SIZE);
+    memcpy(slot->blob, blob, blob_len);
+    ctx->stats.held++;
+    return 1;
+}
+
+static cyxchat_error_t handle_put(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                                  const uint8_t *data, size_t len)
+{
+    if (len < PUT_HEADER_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    const uint8_t *key = data + 1;
+    uint32_t ttl = get_u32(data + 33);
+    uint8_t count = data[37];
+    if (ttl > CYXCHAT_OFFLINE_TTL_SECONDS) {
+        ttl = CYXCHAT_OFFLINE_TTL_SECONDS;
+    }
+    uint64_t expires_ms = ctx->now_ms + (uint64_t)ttl * 1000;
+
+    uint8_t ack[ACK_HEADER_SIZE + 8 * 255];
+    uint8_t acked = 0;
+    size_t offset = PUT_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (offset + PUT_ITEM_HEADER > len) {
+            return CYXCHAT_ERR_INVALID;
+        }
+        uint64_t item_id = get_u64(data + offset);
+        const uint8_t *drop_hash = data + offset + 8;
+        uint16_t blob_len = get_u16(data + offset + 24);
+        offset += PUT_ITEM_HEADER;
+        if (blob_len == 0 || blob_len > CYXCHAT_OFFLINE_BLOB_MAX || offset + blob_len > len) {
+            return CYXCHAT_ERR_INVALID;
+        }
+
+        if (store_put(ctx, key, item_id, drop_hash, data + offset, blob_len, expires_ms)) {
+            put_u64(ack + ACK_HEADER_SIZE + 8 * acked, item_id);
+            acked++;
+        }
+        offset += blob_len;
+    }
+
+    if (acked > 0) {
+        ack[0] = CYXCHAT_MSG_OFFLINE_PUT_ACK;
+        memcpy(ack + 1, key, OFFLINE_KEY_SIZE);
+        ack[33] = acked;
+        send_frame(ctx, from, ack, ACK_HEADER_SIZE + 8 * (size_t)acked);
+    }
+    return CYXCHAT_OK;
+}
+
+/* Answer with the items after the cursor, oldest first, one frame's worth */
+static cyxchat_error_t handle_get(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                                  const uint8_t *data, size_t len)
+{
+    if (len < GET_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    uint32_t req_id = get_u32(data + 1);
+    const uint8_t *key = data + 5;
+    uint32_t cursor = get_u32(data + 37);
+
+    uint8_t frame[CYXCHAT_OFFLINE_FRAME_MAX];
+    size_t offset = ITEMS_HEADER_SIZE;
+    uint8_t count = 0;
+    uint8_t more = 0;
+
+    for (;;) {
+        offline_item_t *next = NULL;
+        for (size_t i = 0; i < ctx->store_size; i++) {
+            offline_item_t *it = &ctx->store[i];
+            if (it->in_use && it->serial > cursor && it->expires_ms > ctx->now_ms &&
+                (!next || it->serial < next->serial) &&
+                memcmp(it->key, key, OFFLINE_KEY_SIZE) == 0) {
+                next = it;
+            }
+        }
+        if (!next) break;
+        if (offset + ITEMS_ITEM_HEADER + next->blob_len > sizeof(frame) || count == 255) {
+            more = 1;
+            break;
+        }
+
+        put_u32(frame + offset, next->serial);
+        put_u64(frame + offset + 4, next->item_id);
+        put_u16(frame + offset + 12, next->blob_len);
+        memcpy(frame + offset + ITEMS_ITEM_HEADER, next->blob, next->blob_len);
+        offset += ITEMS_ITEM_HEADER + next->blob_len;
+        count++;
+        cursor = next->serial;
+    }
+
+    frame[0] = CYXCHAT_MSG_OFFLINE_ITEMS;
+    put_u32(frame + 1, req_id);
+    frame[5] = more;
+    frame[6] = count;
+    send_frame(ctx, from, frame, offset);
+    return CYXCHAT_OK;
+}
+
+static cyxchat_error_t handle_delete(cyxchat_offline_ctx_t *ctx,
+                                     const uint8_t *data, size_t len)
+{
+    if (len < DELETE_HEADER_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    const uint8_t *key = data + 1;
+    uint8_t count = data[33];
+    if (len < DELETE_HEADER_SIZE + (size_t)count * DELETE_ITEM_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *entry = data + DELETE_HEADER_SIZE + (size_t)i * DELETE_ITEM_SIZE;
+        offline_item_t *it = store_find(ctx, key, get_u64(entry));
+        if (!it) continue;
+
+        /* Only the holder of the token (sender or recipient) may delete */
+        uint8_t hash[CYXCHAT_OFFLINE_TOKEN_SIZE];
+        token_hash(entry + 8, hash);
+        if (memcmp(hash, it->drop_hash, sizeof(hash)) == 0) {
+            store_free(ctx, it);
+        }
+    }
+    return CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Sender Outbox
+ * ============================================================ */
+
+static void outbox_finish(cyxchat_offline_ctx_t *ctx, offline_outbox_t *ob,
+                          cyxchat_error_t result)
+{
+    cyxwiz_node_id_t to = ob->to;
+    uint64_t item_id = ob->item_id;
+
+    if (result == CYXCHAT_OK) {
+        ctx->stats.items_stored++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_OFFLINE_STORED, 1);
+    } else {
+        ctx->stats.items_failed++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_OFFLINE_FAILED, 1);
+    }
+    cyxwiz_secure_zero(ob, sizeof(*ob));
+    ctx->stats.outbox--;
+
+    if (ctx->on_stored) {
+        ctx->on_stored(ctx, &to, item_id, result, ctx->on_stored_data);
+    }
+}
+
+static int send_put(cyxchat_offline_ctx_t *ctx, const uint8_t *key, uint8_t *frame,
+                    size_t len, uint8_t count, const cyxwiz_node_id_t *nodes, size_t n)
+{
+    int frames = 0;
+
+    frame[0] = CYXCHAT_MSG_OFFLINE_PUT;
+    memcpy(frame + 1, key, OFFLINE_KEY_SIZE);
+    put_u32(frame + 33, CYXCHAT_OFFLINE_TTL_SECONDS);
+    frame[37] = count;
+    for (size_t r = 0; r < n; r++) {
+        if (send_frame(ctx, &nodes[r], frame, len)) {
+            ctx->stats.puts_sent++;
+            frames++;
+        }
+    }
+    return frames;
+}
+
+/* Send every waiting item for one key to its replicas, a frame at a time */
+static int outbox_flush_key(cyxchat_offline_ctx_t *ctx, const uint8_t *key)
+{
+    cyxwiz_node_id_t nodes[CYXCHAT_OFFLINE_REPLICAS];
+    size_t n = find_replicas(ctx, key, nodes);
+    int frames = 0;
+
+    uint8_t frame[CYXCHAT_OFFLINE_FRAME_MAX];
+    size_t offset = PUT_HEADER_SIZE;
+    uint8_t count = 0;
+
+    for (size_t i = 0; i < CYXCHAT_OFFLINE_OUTBOX_SIZE; i++) {
+        offline_outbox_t *ob = &ctx->outbox[i];
+        if (!ob->in_use || ob->attempts >= CYXCHAT_OFFLINE_ATTEMPTS ||
+            memcmp(ob->key, key, OFFLINE_KEY_SIZE) != 0) {
+            continue;
+        }
+
+        if (offset + PUT_ITEM_HEADER + ob->blob_len > sizeof(frame)) {
+            frames += send_put(ctx, key, frame, offset, count, nodes, n);
+            offset = PUT_HEADER_SIZE;
+            count = 0;
+        }
+
+        put_u64(frame + offset, ob->item_id);
+        memcpy(frame + offset + 8, ob->drop_hash, CYXCHAT_OFFLINE_TOKEN_SIZE);
+        put_u16(frame + offset + 24, ob->blob_len);
+        memcpy(frame + offset + PUT_ITEM_HEADER, ob->blob, ob->blob_len);
+        offset += PUT_ITEM_HEADER + ob->blob_len;
+        count++;
+
+        /* With no replica reachable this still counts, so items fail in time */
+        ob->attempts++;
+        ob->due_ms = ctx->now_ms + CYXCHAT_OFFLINE_RETRY_MS;
+    }
+
+    if (count > 0) {
+        frames += send_put(ctx, key, frame, offset, count, nodes, n);
+    }
+    return frames;
+}
+
+static int outbox_poll(cyxchat_offline_ctx_t *ctx)
+{
+    int frames = 0;
+
+    for (size_t i = 0; i < CYXCHAT_OFFLINE_OUTBOX_SIZE; i++) {
+        offline_outbox_t *ob = &ctx->outbox[i];
+        if (!ob->in_use || ob->due_ms > ctx->now_ms) continue;
+
+        if (ob->attempts >= CYXCHAT_OFFLINE_ATTEMPTS) {
+            outbox_finish(ctx, ob, CYXCHAT_ERR_TIMEOUT);
+            continue;
+        }
+
+        /* Items still batching for the same key ride along */
+        uint8_t key[OFFLINE_KEY_SIZE];
+        memcpy(key, ob->key, sizeof(key));
+        frames += outbox_flush_key(ctx, key);
+    }
+
+    return frames;
+}
+
+static cyxchat_error_t handle_put_ack(cyxchat_offline_ctx_t *ctx,
+                                      const uint8_t *data, size_t len)
+{
+    if (len < ACK_HEADER_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    const uint8_t *key = data + 1;
+    uint8_t count = data[33];
+    if (len < ACK_HEADER_SIZE + 8 * (size_t)count) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        uint64_t item_id = get_u64(data + ACK_HEADER_SIZE + 8 * (size_t)i);
+        for (size_t j = 0; j < CYXCHAT_OFFLINE_OUTBOX_SIZE; j++) {
+            offline_outbox_t *ob = &ctx->outbox[j];
+            if (ob->in_use && ob->item_id == item_id &&
+                memcmp(ob->key, key, OFFLINE_KEY_SIZE) == 0) {
+                outbox_finish(ctx, ob, CYXCHAT_OK);
+                break;
+            }
+        }
+    }
+    return CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Recipient Drain
+ * ============================================================ */
+
+static int send_get(cyxchat_offline_ctx_t *ctx, offline_get_t *g)
+{
+    uint8_t frame[GET_SIZE];
+
+    g->req_id = ctx->next_req_id++;
+    g->deadline_ms = ctx->now_ms + CYXCHAT_OFFLINE_GET_TIMEOUT_MS;
+
+    frame[0] = CYXCHAT_MSG_OFFLINE_GET;
+    put_u32(frame + 1, g->req_id);
+    memcpy(frame + 5, ctx->own_keys[g->slot], OFFLINE_KEY_SIZE);
+    put_u32(frame + 37, g->after);
+    return send_frame(ctx, &g->node, frame, sizeof(frame));
+}
+
+static offline_seen_t* seen_find(cyxchat_offline_ctx_t *ctx, uint64_t item_id)
+{
+    for (size_t i = 0; i < CYXCHAT_OFFLINE_SEEN; i++) {
+        if (ctx->seen[i].item_id == item_id && item_id != 0) {
+            return &ctx->seen[i];
+        }
+    }
+    return NULL;
+}
+
+/* Decrypt one item and hand it up if its signature holds; 1 with the
+ * token filled if it was ours */
+static int open_item(cyxchat_offline_ctx_t *ctx, uint64_t item_id,
+                     const uint8_t *blob, size_t blob_len, uint8_t *token_out)
+{
+#ifdef CYXWIZ_HAS_CRYPTO
+    if (blob_len < crypto_box_SEALBYTES + PLAIN_HEADER_SIZE ||
+        blob_len > CYXCHAT_OFFLINE_BLOB_MAX) {
+        return 0;
+    }
+
+    uint8_t plain[CYXCHAT_OFFLINE_BLOB_MAX];
+    size_t plain_len = blob_len - crypto_box_SEALBYTES;
+    if (crypto_box_seal_open(plain, blob, blob_len, ctx->public_key, ctx->secret_key) != 0) {
+        return 0;
+    }
+
+    cyxwiz_node_id_t from;
+    memcpy(from.bytes, plain, 32);
+    memcpy(token_out, plain + 32, CYXCHAT_OFFLINE_TOKEN_SIZE);
+
+    uint8_t msg[SIGNED_HEADER_SIZE + CYXCHAT_OFFLINE_MAX_PAYLOAD];
+    size_t msg_len = signed_data(&ctx->local_id, plain, plain_len, msg);
+    int valid = crypto_sign_verify_detached(plain + PLAIN_SIG_OFFSET, msg, msg_len,
+                                            from.bytes) == 0;
+
+    /* Sealed to us either way, so a forgery is still ours to delete */
+    offline_seen_t *s = &ctx->seen[ctx->seen_next];
+    ctx->seen_next = (ctx->seen_next + 1) % CYXCHAT_OFFLINE_SEEN;
+    s->item_id = item_id;
+    memcpy(s->token, token_out, CYXCHAT_OFFLINE_TOKEN_SIZE);
+
+    if (!valid) {
+        ctx->stats.items_rejected++;
+        cyxwiz_secure_zero(plain, sizeof(plain));
+        return 1;
+    }
+
+    ctx->stats.items_delivered++;
+    CYXCHAT_COUNT(CYXCHAT_METRIC_OFFLINE_DELIVERED, 1);
+    if (ctx->on_message) {
+        ctx->on_message(ctx, &from, plain + PLAIN_HEADER_SIZE,
+                        plain_len - PLAIN_HEADER_SIZE, ctx->on_message_data);
+    }
+    cyxwiz_secure_zero(plain, sizeof(plain));
+    return 1;
+#else
+    (void)ctx;
+    (void)item_id;
+    (void)blob;
+    (void)blob_len;
+    (void)token_out;
+    return 0;
+#endif
+}
+
+static cyxchat_error_t handle_items(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                                    const uint8_t *data, size_t len)
+{
+    if (len < ITEMS_HEADER_SIZE) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    uint32_t req_id = get_u32(data + 1);
+    offline_get_t *g = NULL;
+    for (size_t i = 0; i < OFFLINE_GETS; i++) {
+        if (ctx->gets[i].in_use && ctx->gets[i].req_id == req_id &&
+            memcmp(&ctx->gets[i].node, from, sizeof(cyxwiz_node_id_t)) == 0) {
+            g = &ctx->gets[i];
+            break;
+        }
+    }
+    if (!g) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+
+    uint8_t more = data[5];
+    uint8_t count = data[6];
+    uint8_t del[DELETE_HEADER_SIZE + 255 * DELETE_ITEM_SIZE];
+    uint8_t deletes = 0;
+    size_t offset = ITEMS_HEADER_SIZE;
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (offset + ITEMS_ITEM_HEADER > len) {
+            return CYXCHAT_ERR_INVALID;
+        }
+        uint32_t serial = get_u32(data + offset);
+        uint64_t item_id = get_u64(data + offset + 4);
+        uint16_t blob_len = get_u16(data + offset + 12);
+        offset += ITEMS_ITEM_HEADER;
+        if (offset + blob_len > len) {
+            return CYXCHAT_ERR_INVALID;
+        }
+
+        /* Copies on other replicas were delivered already: only delete */
+        uint8_t *entry = del + DELETE_HEADER_SIZE + (size_t)deletes * DELETE_ITEM_SIZE;
+        offline_seen_t *s = seen_find(ctx, item_id);
+        if (s) {
+            memcpy(entry + 8, s->token, CYXCHAT_OFFLINE_TOKEN_SIZE);
+            put_u64(entry, item_id);
+            deletes++;
+        } else if (open_item(ctx, item_id, data + offset, blob_len, entry + 8)) {
+            put_u64(entry, item_id);
+            deletes++;
+        }
+
+        if (serial > g->after) {
+            g->after = serial;
+        }
+        offset += blob_len;
+    }
+
+    if (deletes > 0) {
+        del[0] = CYXCHAT_MSG_OFFLINE_DELETE;
+        memcpy(del + 1, ctx->own_keys[g->slot], OFFLINE_KEY_SIZE);
+        del[33] = deletes;
+        send_frame(ctx, from, del, DELETE_HEADER_SIZE + (size_t)deletes * DELETE_ITEM_SIZE);
+    }
+
+    /* The callback may have restarted the drain */
+    if (g->in_use && g->req_id == req_id) {
+        if (more && count > 0) {
+            send_get(ctx, g);
+        } else {
+            g->in_use = 0;
+            ctx->stats.gets_pending--;
+        }
+    }
+    return CYXCHAT_OK;
+}
+
+static void gets_expire(cyxchat_offline_ctx_t *ctx)
+{
+    for (size_t i = 0; i < OFFLINE_GETS; i++) {
+        if (ctx->gets[i].in_use && ctx->gets[i].deadline_ms <= ctx->now_ms) {
+            ctx->gets[i].in_use = 0;
+            ctx->stats.gets_pending--;
+        }
+    }
+}
+
+/* ============================================================
+ * Lifecycle
+ * ============================================================ */
+
+/* Context and the items it holds for other nodes */
+static void* offline_layout(cyxchat_arena_t *arena, const void *arg)
+{
+    const cyxchat_config_t *cfg = (const cyxchat_config_t*)arg;
+    cyxchat_offline_ctx_t *c = cyxchat_arena_carve(arena, 1, sizeof(cyxchat_offline_ctx_t));
+    offline_item_t *store = cyxchat_arena_carve(arena, cfg->offline_store_size,
+                                                sizeof(offline_item_t));
+    if (c) {
+        c->store = store;
+        c->store_size = cfg->offline_store_size;
+        c->footprint = arena->size;
+    }
+    return c;
+}
+
+cyxchat_error_t cyxchat_offline_create(
+    cyxchat_offline_ctx_t **ctx_out,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+) {
+    if (!ctx_out || !local_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_config_t defaults;
+    config = cyxchat_config_resolve(config, &defaults);
+    if (!config) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    cyxchat_offline_ctx_t *ctx = cyxchat_arena_build(offline_layout, config);
+    if (!ctx) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    ctx->local_id = *local_id;
+    ctx->next_req_id = 1;
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    if (!signing_key ||
+        crypto_sign_ed25519_sk_to_curve25519(ctx->secret_key, signing_key) != 0) {
+        crypto_box_keypair(ctx->public_key, ctx->secret_key);
+    } else {
+        crypto_scalarmult_base(ctx->public_key, ctx->secret_key);
+        memcpy(ctx->signing_key, signing_key, sizeof(ctx->signing_key));
+        ctx->can_sign = 1;
+    }
+#else
+    (void)signing_key;
+#endif
+
+    for (uint8_t s = 0; s < CYXCHAT_OFFLINE_SLOTS; s++) {
+        cyxchat_offline_mailbox_key(local_id, s, ctx->own_keys[s]);
+    }
+
+    *ctx_out = ctx;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_offline_destroy(cyxchat_offline_ctx_t *ctx)
+{
+    if (!ctx) return;
+
+    cyxwiz_secure_zero(ctx, ctx->footprint);
+    free(ctx);
+}
+
+void cyxchat_offline_set_transport(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_send_fn send,
+    cyxchat_offline_closest_fn closest,
+    void *user_data
+) {
+    if (!ctx) return;
+
+    ctx->send = send;
+    ctx->closest = closest;
+    ctx->transport_data = user_data;
+}
+
+void cyxchat_offline_set_key_lookup(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_key_fn lookup,
+    void *user_data
+) {
+    if (!ctx) return;
+
+    ctx->key_lookup = lookup;
+    ctx->key_data = user_data;
+}
+
+void cyxchat_offline_get_public_key(cyxchat_offline_ctx_t *ctx, uint8_t *public_out)
+{
+    if (!ctx || !public_out) return;
+
+    memcpy(public_out, ctx->public_key, 32);
+}
+
+int cyxchat_offline_poll(cyxchat_offline_ctx_t *ctx, uint64_t now_ms)
+{
+    if (!ctx) return 0;
+
+    ctx->now_ms = now_ms;
+    store_expire(ctx);
+    gets_expire(ctx);
+
+    int frames = outbox_poll(ctx);
+    if (now_ms >= ctx->next_drain_ms && ctx->stats.gets_pending == 0) {
+        frames += cyxchat_offline_drain(ctx);
+    }
+    return frames;
+}
+
+/* ============================================================
+ * Sending
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_offline_send(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *to_public,
+    const uint8_t *data,
+    size_t len,
+    uint64_t *item_id_out
+) {
+    if (!ctx || !to || !to_public || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len == 0 || len > CYXCHAT_OFFLINE_MAX_PAYLOAD) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    if (!ctx->can_sign) {
+        return CYXCHAT_ERR_CRYPTO;
+    }
+
+    offline_outbox_t *ob = NULL;
+    for (size_t i = 0; i < CYXCHAT_OFFLINE_OUTBOX_SIZE; i++) {
+        if (!ctx->outbox[i].in_use) {
+            ob = &ctx->outbox[i];
+            break;
+        }
+    }
+    if (!ob) {
+        return CYXCHAT_ERR_FULL;
+    }
+
+    uint8_t plain[PLAIN_HEADER_SIZE + CYXCHAT_OFFLINE_MAX_PAYLOAD];
+    memcpy(plain, ctx->local_id.bytes, 32);
+    cyxchat_rng_bytes(cyxchat_rng_default(), plain + 32, CYXCHAT_OFFLINE_TOKEN_SIZE);
+    memcpy(plain + PLAIN_HEADER_SIZE, data, len);
+
+    uint8_t msg[SIGNED_HEADER_SIZE + CYXCHAT_OFFLINE_MAX_PAYLOAD];
+    size_t msg_len = signed_data(to, plain, PLAIN_HEADER_SIZE + len, msg);
+    crypto_sign_detached(plain + PLAIN_SIG_OFFSET, NULL, msg, msg_len, ctx->signing_key);
+    cyxwiz_secure_zero(msg, sizeof(msg));
+
+    if (crypto_box_seal(ob->blob, plain, PLAIN_HEADER_SIZE + len, to_public) != 0) {
+        cyxwiz_secure_zero(plain, sizeof(plain));
+        return CYXCHAT_ERR_CRYPTO;
+    }
+    token_hash(plain + 32, ob->drop_hash);
+    cyxwiz_secure_zero(plain, sizeof(plain));
+
+    /* Item IDs only need to be unique per mailbox key; 0 is never used */
+    do {
+        cyxchat_rng_bytes(cyxchat_rng_default(), (uint8_t*)&ob->item_id, sizeof(ob->item_id));
+    } while (ob->item_id == 0);
+
+    /* All of our items for one recipient share a slot, so they batch */
+    cyxchat_offline_mailbox_key(to, (uint8_t)(ctx->local_id.bytes[0] % CYXCHAT_OFFLINE_SLOTS),
+                                ob->key);
+    ob->in_use = 1;
+    ob->attempts = 0;
+    ob->to = *to;
+    ob->blob_len = (uint16_t)(crypto_box_SEALBYTES + PLAIN_HEADER_SIZE + len);
+    ob->due_ms = ctx->now_ms + CYXCHAT_OFFLINE_BATCH_MS;
+    ctx->stats.outbox++;
+
+    /* A frame's worth waiting: send with the next poll */
+    size_t pending = 0;
+    for (size_t i = 0; i < CYXCHAT_OFFLINE_OUTBOX_SIZE; i++) {
+        offline_outbox_t *o = &ctx->outbox[i];
+        if (o->in_use && o->attempts == 0 && memcmp(o->key, ob->key, OFFLINE_KEY_SIZE) == 0) {
+            pending += PUT_ITEM_HEADER + o->blob_len;
+        }
+    }
+    if (PUT_HEADER_SIZE + pending + PUT_ITEM_HEADER + CYXCHAT_OFFLINE_BLOB_MAX >
+        CYXCHAT_OFFLINE_FRAME_MAX) {
+        ob->due_ms = ctx->now_ms;
+    }
+
+    if (item_id_out) {
+        *item_id_out = ob->item_id;
+    }
+    return CYXCHAT_OK;
+#else
+    (void)item_id_out;
+    return CYXCHAT_ERR_CRYPTO;
+#endif
+}
+
+cyxchat_error_t cyxchat_offline_send_to(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t *item_id_out
+) {
+    if (!ctx || !to || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    uint8_t to_public[32];
+    if (!ctx->key_lookup || !ctx->key_lookup(ctx->key_data, to, to_public)) {
+        return CYXCHAT_ERR_NOT_FOUND;
+    }
+    return cyxchat_offline_send(ctx, to, to_public, data, len, item_id_out);
+}
+
+/* ============================================================
+ * Receiving
+ * ============================================================ */
+
+int cyxchat_offline_drain(cyxchat_offline_ctx_t *ctx)
+{
+    if (!ctx) return 0;
+
+    int sent = 0;
+    for (uint8_t s = 0; s < CYXCHAT_OFFLINE_SLOTS; s++) {
+        cyxwiz_node_id_t nodes[CYXCHAT_OFFLINE_REPLICAS];
+        size_t n = find_replicas(ctx, ctx->own_keys[s], nodes);
+
+        for (size_t r = 0; r < n; r++) {
+            /* One GET per slot and replica: restart a running one */
+            offline_get_t *g = NULL;
+            for (size_t i = 0; i < OFFLINE_GETS; i++) {
+                offline_get_t *e = &ctx->gets[i];
+                if (e->in_use && e->slot == s &&
+                    memcmp(&e->node, &nodes[r], sizeof(cyxwiz_node_id_t)) == 0) {
+                    g = e;
+                    break;
+                }
+                if (!e->in_use && !g) {
+                    g = e;
+                }
+            }
+            if (!g) break;
+
+            if (!g->in_use) {
+                g->in_use = 1;
+                ctx->stats.gets_pending++;
+            }
+            g->slot = s;
+            g->after = 0;
+            g->node = nodes[r];
+            if (send_get(ctx, g)) {
+                sent++;
+            }
+        }
+    }
+
+    ctx->next_drain_ms = ctx->now_ms +
+        (sent > 0 ? CYXCHAT_OFFLINE_DRAIN_MS : CYXCHAT_OFFLINE_IDLE_RETRY_MS);
+    return sent;
+}
+
+cyxchat_error_t cyxchat_offline_handle_message(
+    cyxchat_offline_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len
+) {
+    if (!ctx || !from || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (len == 0) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    switch (data[0]) {
+        case CYXCHAT_MSG_OFFLINE_PUT:
+            return handle_put(ctx, from, data, len);
+        case CYXCHAT_MSG_OFFLINE_PUT_ACK:
+            return handle_put_ack(ctx, data, len);
+        case CYXCHAT_MSG_OFFLINE_GET:
+            return handle_get(ctx, from, data, len);
+        case CYXCHAT_MSG_OFFLINE_ITEMS:
+            return handle_items(ctx, from, data, len);
+        case CYXCHAT_MSG_OFFLINE_DELETE:
+            return handle_delete(ctx, data, len);
+        default:
+            return CYXCHAT_ERR_INVALID;
+    }
+}
+
+/* ============================================================
+ * Callbacks and Accessors
+ * ============================================================ */
+
+void cyxchat_offline_set_on_message(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_message_callback_t callback,
+    void *user_data
+) {
+    if (!ctx) return;
+
+    ctx->on_message = callback;
+    ctx->on_message_data = user_data;
+}
+
+void cyxchat_offline_set_on_stored(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_stored_callback_t callback,
+    void *user_data
+) {
+    if (!ctx) return;
+
+    ctx->on_stored = callback;
+    ctx->on_stored_data = user_data;
+}
+
+/*
+ * Key = BLAKE2b(recipient || "CYXCHAT_MAILBOX" || slot), the same
+ * construction as the file offer keys
+ */
+void cyxchat_offline_mailbox_key(
+    const cyxwiz_node_id_t *recipient,
+    uint8_t slot,
+    uint8_t *key_out
+) {
+    if (!recipient || !key_out) return;
+
+    uint8_t data[32 + 15 + 1];  /* node_id + "CYXCHAT_MAILBOX" + slot */
+    memcpy(data, recipient->bytes, 32);
+    memcpy(data + 32, "CYXCHAT_MAILBOX", 15);
+    data[47] = slot;
+    cyxwiz_crypto_hash(data, sizeof(data), key_out, OFFLINE_KEY_SIZE);
+}
+
+void cyxchat_offline_get_stats(
+    cyxchat_offline_ctx_t *ctx,
+    cyxchat_offline_stats_t *stats_out
+) {
+    if (!ctx || !stats_out) return;
+
+    *stats_out = ctx->stats;
+}
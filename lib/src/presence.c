@@ -4,6 +4,7 @@
 
 #include <cyxchat/presence.h>
 #include <cyxchat/chat.h>
+#include <cyxchat/timer.h>
 #include <cyxwiz/memory.h>
 #include <string.h>
 #include <stdlib.h>
@@ -35,8 +36,14 @@ struct cyxchat_presence_ctx {
 
     /* Cached presence */
     cyxchat_presence_info_t cache[CYXCHAT_MAX_PRESENCE_CACHE];
+    cyxchat_timer_t stale_timers[CYXCHAT_MAX_PRESENCE_CACHE];
     size_t cache_count;
 
+    /* Timers (own_timers unless attached to a shared wheel) */
+    cyxchat_timer_t auto_away_timer;
+    cyxchat_timer_wheel_t *own_timers;
+    cyxchat_timer_wheel_t *timers;
+
     /* Callbacks */
     cyxchat_on_presence_update_t on_update;
     void *on_update_data;
@@ -61,6 +68,81 @@ static cyxchat_presence_info_t* find_presence(
     return NULL;
 }
 
+/* Time left until `timeout` has been exceeded since `since` */
+static uint64_t time_until_exceeded(uint64_t since, uint64_t timeout)
+{
+    uint64_t elapsed = cyxchat_timestamp_ms() - since;
+    return elapsed > timeout ? 0 : timeout - elapsed + 1;
+}
+
+static void on_stale_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)now_ms;
+    cyxchat_presence_ctx_t *ctx = (cyxchat_presence_ctx_t*)user_data;
+    cyxchat_presence_info_t *info = &ctx->cache[timer - ctx->stale_timers];
+
+    if (info->status == CYXCHAT_PRESENCE_OFFLINE) return;
+
+    uint64_t remaining = time_until_exceeded(info->updated_at, CYXCHAT_PRESENCE_STALE_MS);
+    if (remaining == 0) {
+        info->status = CYXCHAT_PRESENCE_OFFLINE;
+        info->last_seen = info->updated_at;
+    } else {
+        cyxchat_timer_schedule(ctx->timers, timer,
+                               cyxchat_timer_now(ctx->timers) + remaining,
+                               on_stale_timer, ctx);
+    }
+}
+
+static void arm_stale_timer(cyxchat_presence_ctx_t *ctx, cyxchat_presence_info_t *info)
+{
+    cyxchat_timer_t *timer = &ctx->stale_timers[info - ctx->cache];
+    if (cyxchat_timer_pending(timer)) return;
+
+    cyxchat_timer_schedule(ctx->timers, timer,
+                           cyxchat_timer_now(ctx->timers) +
+                           time_until_exceeded(info->updated_at, CYXCHAT_PRESENCE_STALE_MS),
+                           on_stale_timer, ctx);
+}
+
+static void on_auto_away_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Arm auto-away for whatever is left of the timeout since last activity */
+static void arm_auto_away(cyxchat_presence_ctx_t *ctx)
+{
+    if (ctx->auto_away_timeout == 0 || ctx->auto_away_active) {
+        cyxchat_timer_cancel(ctx->timers, &ctx->auto_away_timer);
+        return;
+    }
+
+    cyxchat_timer_schedule(ctx->timers, &ctx->auto_away_timer,
+                           cyxchat_timer_now(ctx->timers) +
+                           time_until_exceeded(ctx->last_activity, ctx->auto_away_timeout),
+                           on_auto_away_timer, ctx);
+}
+
+static void on_auto_away_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)timer;
+    (void)now_ms;
+    cyxchat_presence_ctx_t *ctx = (cyxchat_presence_ctx_t*)user_data;
+
+    if (ctx->auto_away_timeout == 0 || ctx->auto_away_active) return;
+
+    /* Activity only stamps last_activity, so re-arm lazily */
+    if (time_until_exceeded(ctx->last_activity, ctx->auto_away_timeout) > 0) {
+        arm_auto_away(ctx);
+        return;
+    }
+
+    ctx->status_before_away = ctx->our_status;
+    ctx->our_status = CYXCHAT_PRESENCE_AWAY;
+    ctx->auto_away_active = 1;
+
+    /* Broadcast away status */
+    cyxchat_presence_broadcast(ctx);
+}
+
 CYXWIZ_MAYBE_UNUSED
 static cyxchat_presence_info_t* add_presence(
     cyxchat_presence_ctx_t *ctx,
@@ -68,7 +150,10 @@ static cyxchat_presence_info_t* add_presence(
 ) {
     /* Check if already exists */
     cyxchat_presence_info_t *existing = find_presence(ctx, node_id);
-    if (existing) return existing;
+    if (existing) {
+        arm_stale_timer(ctx, existing);
+        return existing;
+    }
 
     /* Find slot */
     if (ctx->cache_count < CYXCHAT_MAX_PRESENCE_CACHE) {
@@ -76,6 +161,7 @@ static cyxchat_presence_info_t* add_presence(
         memset(info, 0, sizeof(cyxchat_presence_info_t));
         memcpy(&info->node_id, node_id, sizeof(cyxwiz_node_id_t));
         ctx->cache_count++;
+        arm_stale_timer(ctx, info);
         return info;
     }
 
@@ -92,6 +178,7 @@ static cyxchat_presence_info_t* add_presence(
     cyxchat_presence_info_t *info = &ctx->cache[oldest_idx];
     memset(info, 0, sizeof(cyxchat_presence_info_t));
     memcpy(&info->node_id, node_id, sizeof(cyxwiz_node_id_t));
+    arm_stale_timer(ctx, info);
     return info;
 }
 
@@ -116,12 +203,21 @@ cyxchat_error_t cyxchat_presence_ctx_create(
     c->our_status = CYXCHAT_PRESENCE_ONLINE;
     c->last_activity = cyxchat_timestamp_ms();
 
+    if (cyxchat_timer_wheel_create(&c->own_timers, c->last_activity) != CYXCHAT_OK) {
+        free(c);
+        return CYXCHAT_ERR_MEMORY;
+    }
+    c->timers = c->own_timers;
+
     *ctx = c;
     return CYXCHAT_OK;
 }
 
 void cyxchat_presence_ctx_destroy(cyxchat_presence_ctx_t *ctx) {
     if (ctx) {
+        /* Release timers held on a shared wheel */
+        cyxchat_presence_set_timer_wheel(ctx, NULL);
+        cyxchat_timer_wheel_destroy(ctx->own_timers);
         free(ctx);
     }
 }
@@ -129,33 +225,31 @@ void cyxchat_presence_ctx_destroy(cyxchat_presence_ctx_t *ctx) {
 int cyxchat_presence_poll(cyxchat_presence_ctx_t *ctx, uint64_t now_ms) {
     if (!ctx) return 0;
 
-    int events = 0;
+    /* Auto-away and stale entries are timers; a shared wheel is
+     * advanced by its owner */
+    if (ctx->timers != ctx->own_timers) return 0;
 
-    /* Check auto-away */
-    if (ctx->auto_away_timeout > 0 && !ctx->auto_away_active) {
-        if (now_ms - ctx->last_activity > ctx->auto_away_timeout) {
-            ctx->status_before_away = ctx->our_status;
-            ctx->our_status = CYXCHAT_PRESENCE_AWAY;
-            ctx->auto_away_active = 1;
+    return cyxchat_timer_advance(ctx->timers, now_ms);
+}
 
-            /* Broadcast away status */
-            cyxchat_presence_broadcast(ctx);
-            events++;
-        }
-    }
+void cyxchat_presence_set_timer_wheel(
+    cyxchat_presence_ctx_t *ctx,
+    cyxchat_timer_wheel_t *wheel
+) {
+    if (!ctx) return;
 
-    /* Expire stale presence entries */
-    for (size_t i = 0; i < ctx->cache_count; i++) {
-        if (ctx->cache[i].status != CYXCHAT_PRESENCE_OFFLINE) {
-            if (now_ms - ctx->cache[i].updated_at > CYXCHAT_PRESENCE_STALE_MS) {
-                ctx->cache[i].status = CYXCHAT_PRESENCE_OFFLINE;
-                ctx->cache[i].last_seen = ctx->cache[i].updated_at;
-                events++;
-            }
-        }
+    cyxchat_timer_wheel_t *target = wheel ? wheel : ctx->own_timers;
+    if (target == ctx->timers) return;
+
+    cyxchat_timer_move(ctx->timers, target, &ctx->auto_away_timer);
+    for (size_t i = 0; i < CYXCHAT_MAX_PRESENCE_CACHE; i++) {
+        cyxchat_timer_move(ctx->timers, target, &ctx->stale_timers[i]);
     }
+    ctx->timers = target;
+}
 
-    return events;
+uint64_t cyxchat_presence_next_deadline(cyxchat_presence_ctx_t *ctx) {
+    return ctx ? cyxchat_timer_next_deadline(ctx->timers) : CYXCHAT_TIMER_NONE;
 }
 
 /* ============================================================
@@ -173,6 +267,7 @@ cyxchat_error_t cyxchat_presence_set_status(
 
     ctx->our_status = status;
     ctx->auto_away_active = 0;
+    arm_auto_away(ctx);
 
     memset(ctx->our_status_text, 0, CYXCHAT_MAX_STATUS_LEN);
     if (status_text) {
@@ -324,6 +419,7 @@ void cyxchat_presence_set_auto_away(
         ctx->auto_away_timeout = timeout_ms;
         ctx->last_activity = cyxchat_timestamp_ms();
         ctx->auto_away_active = 0;
+        arm_auto_away(ctx);
     }
 }
 
@@ -335,6 +431,7 @@ void cyxchat_presence_activity(cyxchat_presence_ctx_t *ctx) {
         if (ctx->auto_away_active) {
             ctx->auto_away_active = 0;
             ctx->our_status = ctx->status_before_away;
+            arm_auto_away(ctx);
             cyxchat_presence_broadcast(ctx);
         }
     }
@@ -10,12 +10,15 @@
 #endif
 
 #include "cyxchat/relay.h"
+#include "cyxchat/timer.h"
+#include "cyxchat/trace.h"
 #include <cyxwiz/memory.h>
 #include <cyxwiz/log.h>
 
 #include <string.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <stddef.h>
 
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -43,10 +46,12 @@ typedef struct {
     uint64_t connected_at;
     uint64_t last_activity;
     uint64_t last_keepalive;
-    uint32_t bytes_sent;
-    uint32_t bytes_received;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
     int server_index;       /* Which relay server */
     int active;
+    int confirmed;          /* Relay acknowledged, or the peer got through */
+    cyxchat_timer_t timer;  /* Next timeout or keepalive check */
 } cyxchat_relay_conn_internal_t;
 
 /* Relay context */
@@ -65,6 +70,11 @@ struct cyxchat_relay_ctx {
     cyxchat_relay_conn_internal_t connections[CYXCHAT_MAX_RELAY_CONNECTIONS];
     size_t connection_count;
 
+    /* Timer wheel (own_timers unless attached to a shared wheel) */
+    cyxchat_timer_wheel_t *own_timers;
+    cyxchat_timer_wheel_t *timers;
+    uint32_t keepalive_ms;
+
     /* Callbacks */
     cyxchat_relay_data_callback_t on_data;
     void *data_user_data;
@@ -95,7 +105,11 @@ typedef struct {
     cyxwiz_node_id_t to;
     uint16_t data_len;
     uint8_t data[1];        /* Flexible array */
-} cyxchat_relay_data_msg_t;
+}
+#ifdef __GNUC__
+__attribute__((packed))     /* Wire header is 67 bytes; no pad before data_len */
+#endif
+cyxchat_relay_data_msg_t;
 
 #define CYXCHAT_RELAY_DATA_HDR_SIZE (1 + 32 + 32 + 2)
 
@@ -148,10 +162,23 @@ static cyxchat_relay_conn_internal_t* alloc_connection(cyxchat_relay_ctx_t *ctx)
     return NULL;
 }
 
+/* The relay path has carried something back: report it up, once */
+static void confirm_connection(cyxchat_relay_ctx_t *ctx, cyxchat_relay_conn_internal_t *conn)
+{
+    if (conn->confirmed) return;
+    conn->confirmed = 1;
+
+    if (ctx->on_state) {
+        ctx->on_state(ctx, &conn->peer_id, 1, ctx->state_user_data);
+    }
+}
+
 static void free_connection(cyxchat_relay_ctx_t *ctx, cyxchat_relay_conn_internal_t *conn)
 {
     if (!conn) return;
 
+    cyxchat_timer_cancel(ctx->timers, &conn->timer);
+
     if (ctx->on_state) {
         ctx->on_state(ctx, &conn->peer_id, 0, ctx->state_user_data);
     }
@@ -162,6 +189,30 @@ static void free_connection(cyxchat_relay_ctx_t *ctx, cyxchat_relay_conn_interna
     }
 }
 
+static void on_conn_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms);
+
+/* Time left until `interval` has been exceeded since `since` */
+static uint64_t time_until_exceeded(uint64_t now, uint64_t since, uint64_t interval)
+{
+    uint64_t elapsed = now - since;
+    return elapsed > interval ? 0 : interval - elapsed + 1;
+}
+
+/* Arm connection timer for its next timeout or keepalive */
+static void arm_conn_timer(cyxchat_relay_ctx_t *ctx, cyxchat_relay_conn_internal_t *conn)
+{
+    uint64_t now = get_time_ms();
+    uint64_t delay = time_until_exceeded(now, conn->last_activity, CYXCHAT_RELAY_TIMEOUT_MS);
+    uint64_t keepalive = time_until_exceeded(now, conn->last_keepalive, ctx->keepalive_ms);
+    if (keepalive < delay) {
+        delay = keepalive;
+    }
+
+    cyxchat_timer_schedule(ctx->timers, &conn->timer,
+                           cyxchat_timer_now(ctx->timers) + delay,
+                           on_conn_timer, ctx);
+}
+
 static int parse_address(const char *addr, uint32_t *ip_out, uint16_t *port_out)
 {
     char host[256];
@@ -229,6 +280,13 @@ cyxchat_error_t cyxchat_relay_create(cyxchat_relay_ctx_t **ctx,
     r->transport = transport;
     r->local_id = *local_id;
 
+    if (cyxchat_timer_wheel_create(&r->own_timers, get_time_ms()) != CYXCHAT_OK) {
+        free(r);
+        return CYXCHAT_ERR_MEMORY;
+    }
+    r->timers = r->own_timers;
+    r->keepalive_ms = CYXCHAT_RELAY_KEEPALIVE_MS;
+
     /* Check for relay servers in environment */
     const char *env = getenv("CYXCHAT_RELAY");
     if (env && strlen(env) > 0) {
@@ -263,40 +321,102 @@ void cyxchat_relay_destroy(cyxchat_relay_ctx_t *ctx)
         }
     }
 
+    cyxchat_timer_wheel_destroy(ctx->own_timers);
     free(ctx);
 }
 
+static void send_keepalive(cyxchat_relay_ctx_t *ctx, cyxchat_relay_conn_internal_t *conn,
+                           uint64_t now)
+{
+    cyxchat_relay_keepalive_msg_t msg;
+    msg.type = CYXCHAT_RELAY_KEEPALIVE;
+    msg.from = ctx->local_id;
+
+    send_to_relay(ctx, conn->server_index, (uint8_t*)&msg, sizeof(msg));
+    conn->last_keepalive = now;
+}
+
+/* Connection timer: activity only stamps last_activity, so re-arm lazily */
+static void on_conn_timer(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms)
+{
+    (void)now_ms;
+    cyxchat_relay_ctx_t *ctx = (cyxchat_relay_ctx_t*)user_data;
+    cyxchat_relay_conn_internal_t *conn = (cyxchat_relay_conn_internal_t*)
+        ((uint8_t*)timer - offsetof(cyxchat_relay_conn_internal_t, timer));
+
+    if (!conn->active) return;
+
+    uint64_t now = get_time_ms();
+
+    /* Check for timeout */
+    if (now - conn->last_activity > CYXCHAT_RELAY_TIMEOUT_MS) {
+        free_connection(ctx, conn);
+        return;
+    }
+
+    /* Send keepalive if needed */
+    if (now - conn->last_keepalive > ctx->keepalive_ms) {
+        send_keepalive(ctx, conn, now);
+    }
+
+    arm_conn_timer(ctx, conn);
+}
+
 int cyxchat_relay_poll(cyxchat_relay_ctx_t *ctx, uint64_t now_ms)
 {
     if (!ctx) return 0;
 
-    int events = 0;
+    /* A shared wheel is advanced by its owner */
+    if (ctx->timers != ctx->own_timers) return 0;
+
+    return cyxchat_timer_advance(ctx->timers, now_ms);
+}
+
+void cyxchat_relay_set_timer_wheel(cyxchat_relay_ctx_t *ctx, cyxchat_timer_wheel_t *wheel)
+{
+    if (!ctx) return;
+
+    cyxchat_timer_wheel_t *target = wheel ? wheel : ctx->own_timers;
+    if (target == ctx->timers) return;
 
-    /* Send keepalives and check timeouts */
     for (size_t i = 0; i < CYXCHAT_MAX_RELAY_CONNECTIONS; i++) {
-        cyxchat_relay_conn_internal_t *conn = &ctx->connections[i];
-        if (!conn->active) continue;
+        cyxchat_timer_move(ctx->timers, target, &ctx->connections[i].timer);
+    }
+    ctx->timers = target;
+}
 
-        /* Check for timeout */
-        if (now_ms - conn->last_activity > CYXCHAT_RELAY_TIMEOUT_MS) {
-            free_connection(ctx, conn);
-            events++;
-            continue;
-        }
+uint64_t cyxchat_relay_next_deadline(cyxchat_relay_ctx_t *ctx)
+{
+    return ctx ? cyxchat_timer_next_deadline(ctx->timers) : CYXCHAT_TIMER_NONE;
+}
 
-        /* Send keepalive if needed */
-        if (now_ms - conn->last_keepalive > CYXCHAT_RELAY_KEEPALIVE_MS) {
-            cyxchat_relay_keepalive_msg_t msg;
-            msg.type = CYXCHAT_RELAY_KEEPALIVE;
-            msg.from = ctx->local_id;
+void cyxchat_relay_set_keepalive_interval(cyxchat_relay_ctx_t *ctx, uint32_t interval_ms)
+{
+    if (!ctx) return;
 
-            send_to_relay(ctx, conn->server_index, (uint8_t*)&msg, sizeof(msg));
-            conn->last_keepalive = now_ms;
-            events++;
+    ctx->keepalive_ms = interval_ms ? interval_ms : CYXCHAT_RELAY_KEEPALIVE_MS;
+    for (int i = 0; i < CYXCHAT_MAX_RELAY_CONNECTIONS; i++) {
+        if (ctx->connections[i].active) {
+            arm_conn_timer(ctx, &ctx->connections[i]);
         }
     }
+}
+
+int cyxchat_relay_keepalive_now(cyxchat_relay_ctx_t *ctx)
+{
+    if (!ctx) return 0;
 
-    return events;
+    int sent = 0;
+    uint64_t now = get_time_ms();
+    for (int i = 0; i < CYXCHAT_MAX_RELAY_CONNECTIONS; i++) {
+        cyxchat_relay_conn_internal_t *conn = &ctx->connections[i];
+        if (!conn->active) continue;
+
+        send_keepalive(ctx, conn, now);
+        arm_conn_timer(ctx, conn);
+        sent++;
+    }
+    return sent;
 }
 
 /* ============================================================
@@ -364,6 +484,7 @@ cyxchat_error_t cyxchat_relay_connect(cyxchat_relay_ctx_t *ctx,
     conn->last_activity = conn->connected_at;
     conn->last_keepalive = conn->connected_at;
     conn->server_index = 0;  /* Use first relay server */
+    arm_conn_timer(ctx, conn);
 
     /* Send connect request to relay */
     cyxchat_relay_connect_msg_t msg;
@@ -377,11 +498,7 @@ cyxchat_error_t cyxchat_relay_connect(cyxchat_relay_ctx_t *ctx,
         return err;
     }
 
-    /* Notify state change */
-    if (ctx->on_state) {
-        ctx->on_state(ctx, peer_id, 1, ctx->state_user_data);
-    }
-
+    /* Reported connected once the relay answers (confirm_connection) */
     return CYXCHAT_OK;
 }
 
@@ -456,6 +573,8 @@ cyxchat_error_t cyxchat_relay_send(cyxchat_relay_ctx_t *ctx,
         return CYXCHAT_ERR_NOT_FOUND;
     }
 
+    CYXCHAT_TRACE_CURRENT(CYXCHAT_TRACE_RELAY_TX, peer_id, len);
+
     /* Build relay data message */
     size_t msg_len = CYXCHAT_RELAY_DATA_HDR_SIZE + len;
     uint8_t *msg_buf = (uint8_t*)malloc(msg_len);
@@ -473,7 +592,7 @@ cyxchat_error_t cyxchat_relay_send(cyxchat_relay_ctx_t *ctx,
     cyxchat_error_t err = send_to_relay(ctx, conn->server_index, msg_buf, msg_len);
 
     if (err == CYXCHAT_OK) {
-        conn->bytes_sent += (uint32_t)len;
+        conn->bytes_sent += len;
         conn->last_activity = get_time_ms();
     }
 
@@ -542,6 +661,8 @@ cyxchat_error_t cyxchat_relay_handle_message(cyxchat_relay_ctx_t *ctx,
                 if (!msg->success) {
                     /* Connection rejected */
                     free_connection(ctx, conn);
+                } else {
+                    confirm_connection(ctx, conn);
                 }
             }
             break;
@@ -565,6 +686,7 @@ cyxchat_error_t cyxchat_relay_handle_message(cyxchat_relay_ctx_t *ctx,
             if (conn) {
                 conn->last_activity = get_time_ms();
                 conn->bytes_received += data_len;
+                confirm_connection(ctx, conn);
             } else {
                 /* Auto-create connection for incoming relay data */
                 conn = alloc_connection(ctx);
@@ -574,11 +696,9 @@ cyxchat_error_t cyxchat_relay_handle_message(cyxchat_relay_ctx_t *ctx,
                     conn->last_activity = conn->connected_at;
                     conn->last_keepalive = conn->connected_at;
                     conn->server_index = 0;
+                    arm_conn_timer(ctx, conn);
                     conn->bytes_received = data_len;
-
-                    if (ctx->on_state) {
-                        ctx->on_state(ctx, &msg->from, 1, ctx->state_user_data);
-                    }
+                    confirm_connection(ctx, conn);
                 }
             }
 
@@ -638,7 +758,7 @@ cyxchat_error_t cyxchat_relay_handle_message(cyxchat_relay_ctx_t *ctx,
                 return CYXCHAT_OK;  /* Not for us */
             }
 
-            /* Auto-accept connection */
+            /* Auto-accept connection (a crossing request confirms ours) */
             cyxchat_relay_conn_internal_t *conn = find_connection(ctx, &msg->from);
             if (!conn) {
                 conn = alloc_connection(ctx);
@@ -648,12 +768,12 @@ cyxchat_error_t cyxchat_relay_handle_message(cyxchat_relay_ctx_t *ctx,
                     conn->last_activity = conn->connected_at;
                     conn->last_keepalive = conn->connected_at;
                     conn->server_index = 0;
-
-                    if (ctx->on_state) {
-                        ctx->on_state(ctx, &msg->from, 1, ctx->state_user_data);
-                    }
+                    arm_conn_timer(ctx, conn);
                 }
             }
+            if (conn) {
+                confirm_connection(ctx, conn);
+            }
             break;
         }
 
@@ -0,0 +1,127 @@
+/**
+ * CyxChat Random ID Pool Implementation
+ *
+ * Fast-key-erasure ChaCha20 pool: each refill expands the current key
+ * into a block, takes the first 32 bytes as the next key and hands out
+ * the rest. The key is reseeded from the system CSPRNG every
+ * CYXCHAT_RNG_RESEED_BLOCKS refills.
+ */
+
+#include <cyxchat/rng.h>
+#include <cyxwiz/crypto.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#ifdef _MSC_VER
+#define RNG_THREAD_LOCAL __declspec(thread)
+#else
+#define RNG_THREAD_LOCAL _Thread_local
+#endif
+
+#define RNG_KEY_SIZE 32
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+struct cyxchat_rng {
+    uint8_t key[RNG_KEY_SIZE];
+    uint8_t block[CYXCHAT_RNG_BLOCK_SIZE];
+    size_t pos;                         /* Next unused byte in block */
+    uint32_t refills;
+    int seeded;
+};
+
+static RNG_THREAD_LOCAL struct cyxchat_rng tls_rng;
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static void rng_refill(cyxchat_rng_t *rng)
+{
+    if (!rng->seeded || rng->refills >= CYXCHAT_RNG_RESEED_BLOCKS) {
+        cyxwiz_crypto_random(rng->key, RNG_KEY_SIZE);
+        rng->refills = 0;
+        rng->seeded = 1;
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    static const uint8_t nonce[12] = {0};
+    crypto_stream_chacha20_ietf(rng->block, sizeof(rng->block), nonce, rng->key);
+#else
+    cyxwiz_crypto_random(rng->block, sizeof(rng->block));
+#endif
+
+    /* Rekey from our own output and never hand those bytes out */
+    memcpy(rng->key, rng->block, RNG_KEY_SIZE);
+    cyxwiz_secure_zero(rng->block, RNG_KEY_SIZE);
+    rng->pos = RNG_KEY_SIZE;
+    rng->refills++;
+}
+
+/* ============================================================
+ * RNG API
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_rng_create(cyxchat_rng_t **rng)
+{
+    if (!rng) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_rng_t *r = calloc(1, sizeof(cyxchat_rng_t));
+    if (!r) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    /* Seed lazily on first use */
+    r->pos = CYXCHAT_RNG_BLOCK_SIZE;
+
+    *rng = r;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_rng_destroy(cyxchat_rng_t *rng)
+{
+    if (rng) {
+        cyxwiz_secure_zero(rng, sizeof(cyxchat_rng_t));
+        free(rng);
+    }
+}
+
+void cyxchat_rng_bytes(cyxchat_rng_t *rng, uint8_t *out, size_t len)
+{
+    if (!out || len == 0) return;
+
+    if (!rng) {
+        cyxwiz_crypto_random(out, len);
+        return;
+    }
+
+    while (len > 0) {
+        if (!rng->seeded || rng->pos >= CYXCHAT_RNG_BLOCK_SIZE) {
+            rng_refill(rng);
+        }
+
+        size_t n = CYXCHAT_RNG_BLOCK_SIZE - rng->pos;
+        if (n > len) n = len;
+
+        memcpy(out, rng->block + rng->pos, n);
+        cyxwiz_secure_zero(rng->block + rng->pos, n);
+
+        rng->pos += n;
+        out += n;
+        len -= n;
+    }
+}
+
+cyxchat_rng_t* cyxchat_rng_default(void)
+{
+    return &tls_rng;
+}
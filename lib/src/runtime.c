@@ -0,0 +1,1130 @@
+/**
+ * CyxChat Runtime Implementation
+ *
+ * Commands enter through a bounded MPSC queue: each cell carries a
+ * sequence word, producers claim a position with a CAS on the head and
+ * publish the cell by bumping its sequence, and the single consumer (the
+ * network thread, or the caller of cyxchat_runtime_poll) releases it by
+ * advancing the sequence one lap. Events go back through an SPSC ring
+ * with one head written by the network thread and one tail written by
+ * the reader. Neither side takes a lock.
+ *
+ * Each cycle blocks at most once, inside the transport poll, for as
+ * long as the shared timer wheel (connection, relay, DNS, presence) and
+ * the module tick allow. A submit that finds the consumer blocked wakes
+ * the transport wait; without a connection the consumer parks on the
+ * mutex below instead. The onion context is polled by the connection
+ * layer only.
+ */
+
+#include <cyxchat/runtime.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RT_LOAD(p)          (*(volatile uint32_t *)(p))
+#define RT_STORE(p, v)      (*(volatile uint32_t *)(p) = (v))
+#define RT_FETCH_ADD(p, v) \
+    ((uint32_t)_InterlockedExchangeAdd((volatile long *)(p), (long)(v)))
+#define RT_FENCE()          MemoryBarrier()
+#define RT_LOAD64(p)        ((uint64_t)InterlockedCompareExchange64((volatile LONG64 *)(p), 0, 0))
+#define RT_STORE64(p, v)    ((void)InterlockedExchange64((volatile LONG64 *)(p), (LONG64)(v)))
+#else
+#define RT_LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define RT_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define RT_FETCH_ADD(p, v)  __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define RT_FENCE()          __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define RT_LOAD64(p)        RT_LOAD(p)
+#define RT_STORE64(p, v)    RT_STORE(p, v)
+#endif
+
+#define RT_CMD_MASK     (CYXCHAT_RUNTIME_CMD_SLOTS - 1)
+#define RT_EVENT_MASK   (CYXCHAT_RUNTIME_EVENT_SLOTS - 1)
+#define RT_WAIT_FOREVER UINT32_MAX      /* No deadline: sleep until woken */
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+typedef enum {
+    RT_CMD_SEND_TEXT = 1,
+    RT_CMD_SEND_RAW,
+    RT_CMD_CONN_SEND,
+    RT_CMD_CONNECT,
+    RT_CMD_DISCONNECT,
+    RT_CMD_CALL
+} rt_cmd_op_t;
+
+typedef struct {
+    uint32_t seq;                       /* pos: free, pos + 1: ready */
+    uint8_t op;                         /* rt_cmd_op_t */
+    uint8_t has_reply;
+    cyxwiz_node_id_t peer;
+    cyxchat_msg_id_t reply_to;
+    cyxchat_runtime_fn_t fn;
+    void *user_data;
+    uint64_t tag;
+    uint32_t len;
+    uint8_t data[CYXCHAT_RUNTIME_MAX_PAYLOAD];
+} rt_cmd_t;
+
+struct cyxchat_runtime {
+    /* Module contexts (all owned) */
+    cyxchat_conn_ctx_t *conn;
+    cyxchat_ctx_t *chat;
+    cyxchat_file_ctx_t *file;
+    cyxchat_dns_ctx_t *dns;
+    cyxchat_mail_ctx_t *mail;
+    cyxchat_presence_ctx_t *presence;
+    cyxchat_group_ctx_t *group;
+    cyxchat_offline_ctx_t *offline;
+    cyxchat_contact_list_t *contacts;   /* Mailbox keys for offline sends */
+    uint64_t next_tick;                 /* Next file/mail/group/offline poll */
+
+    /* Command queue (many producers, one consumer) */
+    rt_cmd_t cmds[CYXCHAT_RUNTIME_CMD_SLOTS];
+    uint32_t cmd_head;                  /* Next position to claim */
+    uint32_t cmd_tail;                  /* Consumer only */
+    uint32_t cmds_rejected;
+
+    /* Event ring (network thread -> reader) */
+    cyxchat_runtime_event_t events[CYXCHAT_RUNTIME_EVENT_SLOTS];
+    uint32_t ev_head;                   /* Written by producer */
+    uint32_t ev_tail;                   /* Written by reader */
+
+    /* Network thread */
+    int threaded;
+    uint32_t running;
+    uint32_t stopping;                  /* Set while stop_thread joins */
+    uint32_t sleeping;
+#ifdef _WIN32
+    HANDLE thread;
+    HANDLE wake_event;
+#else
+    pthread_t thread;
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake_cond;
+#endif
+
+    cyxchat_runtime_stats_t stats;      /* Consumer writes; commands_rejected kept above */
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static int rt_cas(uint32_t *p, uint32_t *expected, uint32_t desired)
+{
+#ifdef _MSC_VER
+    uint32_t prev = (uint32_t)_InterlockedCompareExchange(
+        (volatile long *)p, (long)desired, (long)*expected);
+    if (prev == *expected) {
+        return 1;
+    }
+    *expected = prev;
+    return 0;
+#else
+    return __atomic_compare_exchange_n(p, expected, desired, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+#endif
+}
+
+/* Counters have one writer but are read from any thread */
+static void stat_inc(uint64_t *counter)
+{
+    RT_STORE64(counter, *counter + 1);
+}
+
+/* ============================================================
+ * Command Queue
+ * ============================================================ */
+
+/* Claim a free cell; NULL if the queue is full */
+static rt_cmd_t* cmd_claim(cyxchat_runtime_t *rt, uint32_t *pos_out)
+{
+    uint32_t pos = RT_LOAD(&rt->cmd_head);
+
+    for (;;) {
+        rt_cmd_t *cmd = &rt->cmds[pos & RT_CMD_MASK];
+        int32_t diff = (int32_t)(RT_LOAD(&cmd->seq) - pos);
+
+        if (diff == 0) {
+            if (rt_cas(&rt->cmd_head, &pos, pos + 1)) {
+                *pos_out = pos;
+                return cmd;
+            }
+        } else if (diff < 0) {
+            RT_FETCH_ADD(&rt->cmds_rejected, 1);
+            return NULL;
+        } else {
+            pos = RT_LOAD(&rt->cmd_head);
+        }
+    }
+}
+
+/* Interrupt the consumer's wait: the transport poll, or the park without one */
+static void runtime_signal(cyxchat_runtime_t *rt)
+{
+    if (rt->conn) {
+        cyxchat_conn_wake(rt->conn);
+        return;
+    }
+
+#ifdef _WIN32
+    SetEvent(rt->wake_event);
+#else
+    pthread_mutex_lock(&rt->wake_lock);
+    pthread_cond_signal(&rt->wake_cond);
+    pthread_mutex_unlock(&rt->wake_lock);
+#endif
+}
+
+static void runtime_wake(cyxchat_runtime_t *rt)
+{
+    /* Pairs with the fence before each wait: either it sees the command or we see it asleep */
+    RT_FENCE();
+    if (RT_LOAD(&rt->sleeping)) {
+        runtime_signal(rt);
+    }
+}
+
+static void cmd_publish(cyxchat_runtime_t *rt, rt_cmd_t *cmd, uint32_t pos)
+{
+    RT_STORE(&cmd->seq, pos + 1);
+    runtime_wake(rt);
+}
+
+/* Next ready cell for the consumer, or NULL */
+static rt_cmd_t* cmd_peek(cyxchat_runtime_t *rt)
+{
+    rt_cmd_t *cmd = &rt->cmds[rt->cmd_tail & RT_CMD_MASK];
+    if (RT_LOAD(&cmd->seq) != rt->cmd_tail + 1) {
+        return NULL;
+    }
+    return cmd;
+}
+
+static void cmd_release(cyxchat_runtime_t *rt, rt_cmd_t *cmd)
+{
+    RT_STORE(&cmd->seq, rt->cmd_tail + CYXCHAT_RUNTIME_CMD_SLOTS);
+    rt->cmd_tail++;
+}
+
+static cyxchat_error_t submit(
+    cyxchat_runtime_t *rt,
+    uint8_t op,
+    const cyxwiz_node_id_t *peer,
+    const uint8_t *data,
+    size_t len,
+    const cyxchat_msg_id_t *reply_to,
+    cyxchat_runtime_fn_t fn,
+    void *user_data,
+    uint64_t tag
+) {
+    if (len > CYXCHAT_RUNTIME_MAX_PAYLOAD) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    uint32_t pos;
+    rt_cmd_t *cmd = cmd_claim(rt, &pos);
+    if (!cmd) {
+        return CYXCHAT_ERR_FULL;
+    }
+
+    cmd->op = op;
+    if (peer) {
+        memcpy(&cmd->peer, peer, sizeof(cyxwiz_node_id_t));
+    } else {
+        memset(&cmd->peer, 0, sizeof(cyxwiz_node_id_t));
+    }
+    cmd->has_reply = reply_to ? 1 : 0;
+    if (reply_to) {
+        memcpy(&cmd->reply_to, reply_to, sizeof(cyxchat_msg_id_t));
+    }
+    cmd->fn = fn;
+    cmd->user_data = user_data;
+    cmd->tag = tag;
+    cmd->len = (uint32_t)len;
+    if (len > 0) {
+        memcpy(cmd->data, data, len);
+    }
+
+    cmd_publish(rt, cmd, pos);
+    return CYXCHAT_OK;
+}
+
+/* ============================================================
+ * Event Ring
+ * ============================================================ */
+
+/* Free slot for the producer, or NULL if the ring is full */
+static cyxchat_runtime_event_t* event_slot(cyxchat_runtime_t *rt)
+{
+    uint32_t head = rt->ev_head;
+    if (head - RT_LOAD(&rt->ev_tail) >= CYXCHAT_RUNTIME_EVENT_SLOTS) {
+        return NULL;
+    }
+    return &rt->events[head & RT_EVENT_MASK];
+}
+
+static void event_commit(cyxchat_runtime_t *rt)
+{
+    RT_STORE(&rt->ev_head, rt->ev_head + 1);
+    stat_inc(&rt->stats.events);
+}
+
+static void on_conn_state(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *peer_id,
+    cyxchat_conn_state_t old_state,
+    cyxchat_conn_state_t new_state,
+    void *user_data
+) {
+    (void)ctx;
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+
+    cyxchat_runtime_event_t *ev = event_slot(rt);
+    if (!ev) {
+        stat_inc(&rt->stats.events_dropped);
+        return;
+    }
+
+    ev->type = CYXCHAT_RUNTIME_EVENT_CONN_STATE;
+    ev->msg_type = 0;
+    ev->old_state = (uint8_t)old_state;
+    ev->new_state = (uint8_t)new_state;
+    ev->result = CYXCHAT_OK;
+    ev->tag = 0;
+    memcpy(&ev->peer, peer_id, sizeof(cyxwiz_node_id_t));
+    ev->data_len = 0;
+    event_commit(rt);
+}
+
+/* DNS and mail frames arrive on the connection layer, not the onion;
+ * header-framed ones are routed by the type after the version byte */
+static void on_conn_data(
+    cyxchat_conn_ctx_t *ctx,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len,
+    void *user_data
+) {
+    (void)ctx;
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+    if (len == 0) return;
+
+    if (rt->dns && data[0] >= CYXCHAT_MSG_DNS_REGISTER && data[0] <= CYXCHAT_MSG_DNS_ANNOUNCE) {
+        cyxchat_dns_handle_message(rt->dns, from, data, len);
+        return;
+    }
+
+    if (rt->mail && len >= sizeof(cyxchat_msg_header_t) &&
+        data[0] == CYXCHAT_PROTOCOL_VERSION &&
+        data[1] >= CYXCHAT_MSG_MAIL_SEND && data[1] <= CYXCHAT_MSG_MAIL_BOUNCE) {
+        cyxchat_mail_handle_message(rt->mail, from, data, len);
+    }
+}
+
+/* Mailbox frames are claimed by type on the connection's dispatch table */
+static void on_offline_frame(
+    void *user_data,
+    const cyxwiz_node_id_t *from,
+    const uint8_t *data,
+    size_t len,
+    int via_relay
+) {
+    (void)via_relay;
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+    cyxchat_offline_handle_message(rt->offline, from, data, len);
+}
+
+static cyxchat_error_t offline_send(
+    void *user_data,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len
+) {
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+    return cyxchat_conn_send(rt->conn, to, data, len);
+}
+
+/* Seal for a recipient with the X25519 key stored with its contact */
+static int offline_key(
+    void *user_data,
+    const cyxwiz_node_id_t *peer,
+    uint8_t *public_out
+) {
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+    cyxchat_contact_t *contact = cyxchat_contact_find(rt->contacts, peer);
+    if (!contact || contact->blocked) {
+        return 0;
+    }
+    memcpy(public_out, contact->public_key, sizeof(contact->public_key));
+    return 1;
+}
+
+/* Closest DHT nodes to a mailbox key that we can send to right now */
+static size_t offline_closest(
+    void *user_data,
+    const cyxwiz_node_id_t *key,
+    cyxwiz_node_id_t *out_nodes,
+    size_t max_nodes
+) {
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+    cyxwiz_node_id_t nodes[CYXCHAT_OFFLINE_REPLICAS * 4];
+    size_t n = cyxchat_conn_dht_get_closest(rt->conn, key, nodes,
+                                            sizeof(nodes) / sizeof(nodes[0]));
+    size_t count = 0;
+
+    for (size_t i = 0; i < n && count < max_nodes; i++) {
+        cyxchat_conn_state_t state = cyxchat_conn_get_state(rt->conn, &nodes[i]);
+        if (state == CYXCHAT_CONN_CONNECTED || state == CYXCHAT_CONN_RELAYING) {
+            out_nodes[count++] = nodes[i];
+        }
+    }
+    return count;
+}
+
+/* Republish our hole-punching hint when the public address moves */
+static void on_conn_network(
+    cyxchat_conn_ctx_t *ctx,
+    uint32_t public_ip,
+    uint16_t public_port,
+    void *user_data
+) {
+    (void)public_ip;
+    (void)public_port;
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)user_data;
+
+    char addr[32];
+    if (cyxchat_conn_get_public_addr(ctx, addr, sizeof(addr)) != CYXCHAT_OK) return;
+
+    /* Only a registered name carries a record to update */
+    if (cyxchat_dns_set_stun_addr(rt->dns, addr) == CYXCHAT_OK) {
+        cyxchat_dns_refresh(rt->dns);
+    }
+}
+
+/* Move chat messages into the ring while it has room */
+static int publish_messages(cyxchat_runtime_t *rt)
+{
+    int count = 0;
+    cyxchat_runtime_event_t *ev;
+
+    while ((ev = event_slot(rt)) != NULL) {
+        size_t len = CYXCHAT_RUNTIME_MAX_PAYLOAD;
+        if (!cyxchat_recv_next(rt->chat, &ev->peer, &ev->msg_type, ev->data, &len)) {
+            break;
+        }
+
+        ev->type = CYXCHAT_RUNTIME_EVENT_MESSAGE;
+        ev->old_state = 0;
+        ev->new_state = 0;
+        ev->result = CYXCHAT_OK;
+        ev->tag = 0;
+        ev->data_len = (uint32_t)(len < CYXCHAT_RUNTIME_MAX_PAYLOAD ?
+                                  len : CYXCHAT_RUNTIME_MAX_PAYLOAD);
+        event_commit(rt);
+        count++;
+    }
+
+    return count;
+}
+
+/* ============================================================
+ * Command Execution
+ * ============================================================ */
+
+static cyxchat_error_t execute(cyxchat_runtime_t *rt, rt_cmd_t *cmd,
+                               cyxchat_msg_id_t *msg_id_out)
+{
+    switch (cmd->op) {
+        case RT_CMD_SEND_TEXT:
+            if (!rt->chat) return CYXCHAT_ERR_NULL;
+            return cyxchat_send_text(rt->chat, &cmd->peer, (const char*)cmd->data,
+                                     cmd->len, cmd->has_reply ? &cmd->reply_to : NULL,
+                                     msg_id_out);
+
+        case RT_CMD_SEND_RAW:
+            if (!rt->chat) return CYXCHAT_ERR_NULL;
+            return cyxchat_send_raw(rt->chat, &cmd->peer, cmd->data, cmd->len);
+
+        case RT_CMD_CONN_SEND:
+            if (!rt->conn) return CYXCHAT_ERR_NULL;
+            return cyxchat_conn_send(rt->conn, &cmd->peer, cmd->data, cmd->len);
+
+        case RT_CMD_CONNECT:
+            if (!rt->conn) return CYXCHAT_ERR_NULL;
+            return cyxchat_conn_connect(rt->conn, &cmd->peer, NULL, NULL);
+
+        case RT_CMD_DISCONNECT:
+            if (!rt->conn) return CYXCHAT_ERR_NULL;
+            return cyxchat_conn_disconnect(rt->conn, &cmd->peer);
+
+        case RT_CMD_CALL:
+            return cmd->fn(rt, cmd->user_data);
+
+        default:
+            return CYXCHAT_ERR_INVALID;
+    }
+}
+
+static int run_commands(cyxchat_runtime_t *rt)
+{
+    int count = 0;
+    rt_cmd_t *cmd;
+
+    while ((cmd = cmd_peek(rt)) != NULL) {
+        /* Keep tagged commands queued until their completion fits */
+        if (cmd->tag && !event_slot(rt)) break;
+
+        cyxchat_msg_id_t msg_id;
+        memset(&msg_id, 0, sizeof(msg_id));
+        cyxchat_error_t err = execute(rt, cmd, &msg_id);
+
+        if (cmd->tag) {
+            /* Re-fetched: callbacks run by the command may have filled the ring */
+            cyxchat_runtime_event_t *ev = event_slot(rt);
+            if (ev) {
+                ev->type = CYXCHAT_RUNTIME_EVENT_COMPLETE;
+                ev->msg_type = 0;
+                ev->old_state = 0;
+                ev->new_state = 0;
+                ev->result = (int32_t)err;
+                ev->tag = cmd->tag;
+                memcpy(&ev->peer, &cmd->peer, sizeof(cyxwiz_node_id_t));
+                if (cmd->op == RT_CMD_SEND_TEXT && err == CYXCHAT_OK) {
+                    memcpy(ev->data, &msg_id, sizeof(msg_id));
+                    ev->data_len = sizeof(msg_id);
+                } else {
+                    ev->data_len = 0;
+                }
+                event_commit(rt);
+            } else {
+                stat_inc(&rt->stats.events_dropped);
+            }
+        }
+
+        cmd_release(rt, cmd);
+        stat_inc(&rt->stats.commands);
+        count++;
+    }
+
+    return count;
+}
+
+/* ============================================================
+ * Poll Cycle
+ * ============================================================ */
+
+static uint64_t next_deadline(cyxchat_runtime_t *rt)
+{
+    if (cmd_peek(rt)) return 0;
+
+    uint64_t deadline = CYXCHAT_TIMER_NONE;
+    if (rt->conn) {
+        deadline = cyxchat_conn_next_deadline(rt->conn);
+    }
+    if (rt->chat && rt->next_tick < deadline) {
+        deadline = rt->next_tick;
+    }
+    return deadline;
+}
+
+/* Milliseconds until the next deadline, capped at max_wait_ms */
+static uint32_t time_until_deadline(cyxchat_runtime_t *rt, uint64_t now_ms,
+                                    uint32_t max_wait_ms)
+{
+    uint64_t deadline = next_deadline(rt);
+    if (deadline <= now_ms) return 0;
+    if (deadline - now_ms < max_wait_ms) return (uint32_t)(deadline - now_ms);
+    return max_wait_ms;
+}
+
+/*
+ * One pass over every module. The connection poll runs the transport,
+ * relay, router, onion, DHT and discovery layers and the shared wheel;
+ * it may block up to wait_ms for a datagram, a deadline or a submit.
+ */
+static int runtime_cycle(cyxchat_runtime_t *rt, uint64_t now_ms, uint32_t wait_ms)
+{
+    int count = run_commands(rt);
+
+    if (rt->conn) {
+        uint32_t timeout_ms = 0;
+        if (wait_ms > 0) {
+            RT_STORE(&rt->sleeping, 1);
+            RT_FENCE();
+            if (!RT_LOAD(&rt->stopping)) {
+                timeout_ms = time_until_deadline(rt, now_ms, wait_ms);
+            }
+        }
+        cyxchat_conn_set_poll_timeout(rt->conn, timeout_ms);
+        cyxchat_conn_poll(rt->conn, now_ms);
+        RT_STORE(&rt->sleeping, 0);
+
+        /* The tick the wait ran up to is due now, not next cycle */
+        if (timeout_ms > 0) {
+            now_ms = cyxchat_timestamp_ms();
+        }
+    }
+
+    if (rt->chat) {
+        cyxchat_poll(rt->chat, now_ms);
+
+        if (now_ms >= rt->next_tick) {
+            cyxchat_file_poll(rt->file, now_ms);
+            cyxchat_mail_poll(rt->mail, now_ms);
+            cyxchat_group_poll(rt->group, now_ms);
+            cyxchat_offline_poll(rt->offline, now_ms);
+            rt->next_tick = now_ms + CYXCHAT_RUNTIME_TICK_MS;
+        }
+
+        count += publish_messages(rt);
+    }
+
+    stat_inc(&rt->stats.loops);
+    return count;
+}
+
+/* Park the thread until a command arrives or timeout_ms passes */
+static void runtime_idle(cyxchat_runtime_t *rt, uint32_t timeout_ms)
+{
+#ifdef _WIN32
+    RT_STORE(&rt->sleeping, 1);
+    RT_FENCE();
+    if (!cmd_peek(rt) && !RT_LOAD(&rt->stopping)) {
+        WaitForSingleObject(rt->wake_event, timeout_ms);
+    }
+    RT_STORE(&rt->sleeping, 0);
+#else
+    pthread_mutex_lock(&rt->wake_lock);
+    RT_STORE(&rt->sleeping, 1);
+    RT_FENCE();
+    if (!cmd_peek(rt) && !RT_LOAD(&rt->stopping)) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += timeout_ms / 1000;
+        ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&rt->wake_cond, &rt->wake_lock, &ts);
+    }
+    RT_STORE(&rt->sleeping, 0);
+    pthread_mutex_unlock(&rt->wake_lock);
+#endif
+}
+
+#ifdef _WIN32
+static DWORD WINAPI runtime_thread_main(LPVOID arg)
+#else
+static void* runtime_thread_main(void *arg)
+#endif
+{
+    cyxchat_runtime_t *rt = (cyxchat_runtime_t*)arg;
+
+    while (RT_LOAD(&rt->running)) {
+        uint64_t now_ms = cyxchat_timestamp_ms();
+        int count = runtime_cycle(rt, now_ms, RT_WAIT_FOREVER);
+
+        /* Without a transport to block in, wait on the command queue */
+        if (count == 0 && !rt->conn) {
+            runtime_idle(rt, time_until_deadline(rt, now_ms, RT_WAIT_FOREVER));
+        }
+    }
+
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* ============================================================
+ * Lifecycle
+ * ============================================================ */
+
+/* Create and wire every module context */
+static cyxchat_error_t create_modules(
+    cyxchat_runtime_t *rt,
+    const char *bootstrap,
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+) {
+    cyxchat_error_t err = net ? cyxchat_conn_create_loopback(&rt->conn, net, local_id) :
+                                cyxchat_conn_create_with_config(&rt->conn, bootstrap, local_id, config);
+    if (err != CYXCHAT_OK) return err;
+    if (net) {
+        err = cyxchat_conn_set_max_peers(rt->conn, config->max_peers);
+        if (err != CYXCHAT_OK) return err;
+    }
+    if (signing_key) {
+        err = cyxchat_conn_set_signing_key(rt->conn, signing_key);
+        if (err != CYXCHAT_OK) return err;
+    }
+
+    err = cyxchat_create_with_config(&rt->chat, cyxchat_conn_get_onion(rt->conn), local_id, config);
+    if (err != CYXCHAT_OK) return err;
+
+    /* cyxchat_conn_poll already polls the onion context */
+    cyxchat_set_onion_polling(rt->chat, 0);
+
+    err = cyxchat_file_ctx_create(&rt->file, rt->chat);
+    if (err != CYXCHAT_OK) return err;
+    cyxchat_set_file_ctx(rt->chat, rt->file);
+    cyxchat_file_set_conn(rt->file, rt->conn);
+
+    err = cyxchat_dns_create_with_config(&rt->dns, NULL, local_id, signing_key, config);
+    if (err != CYXCHAT_OK) return err;
+    cyxchat_dns_set_transport(rt->dns, cyxchat_conn_get_transport(rt->conn),
+                              cyxchat_conn_get_peer_table(rt->conn));
+
+    err = cyxchat_mail_ctx_create_with_config(&rt->mail, rt->chat, config);
+    if (err != CYXCHAT_OK) return err;
+
+    err = cyxchat_presence_ctx_create(&rt->presence, rt->chat);
+    if (err != CYXCHAT_OK) return err;
+
+    err = cyxchat_group_ctx_create_with_config(&rt->group, rt->chat, config);
+    if (err != CYXCHAT_OK) return err;
+
+    err = cyxchat_contact_list_create_with_config(&rt->contacts, config);
+    if (err != CYXCHAT_OK) return err;
+
+    err = cyxchat_offline_create(&rt->offline, local_id, signing_key, config);
+    if (err != CYXCHAT_OK) return err;
+    err = cyxchat_conn_register_handler(rt->conn, CYXCHAT_MSG_OFFLINE_PUT,
+                                        CYXCHAT_MSG_OFFLINE_DELETE, on_offline_frame, rt);
+    if (err != CYXCHAT_OK) return err;
+    cyxchat_offline_set_transport(rt->offline, offline_send, offline_closest, rt);
+    cyxchat_offline_set_key_lookup(rt->offline, offline_key, rt);
+    cyxchat_set_offline_ctx(rt->chat, rt->offline);
+
+    /* One wheel, advanced by cyxchat_conn_poll */
+    cyxchat_timer_wheel_t *wheel = cyxchat_conn_get_timer_wheel(rt->conn);
+    cyxchat_dns_set_timer_wheel(rt->dns, wheel);
+    cyxchat_presence_set_timer_wheel(rt->presence, wheel);
+
+    cyxchat_conn_set_on_state_change(rt->conn, on_conn_state, rt);
+    cyxchat_conn_set_on_data(rt->conn, on_conn_data, rt);
+    cyxchat_conn_set_on_network_change(rt->conn, on_conn_network, rt);
+
+    return CYXCHAT_OK;
+}
+
+/* Destroy in reverse dependency order; safe on a partial create */
+static void destroy_modules(cyxchat_runtime_t *rt)
+{
+    /* DNS and presence release their shared-wheel timers on destroy */
+    if (rt->conn) {
+        cyxchat_conn_set_on_state_change(rt->conn, NULL, NULL);
+        cyxchat_conn_set_on_data(rt->conn, NULL, NULL);
+        cyxchat_conn_set_on_network_change(rt->conn, NULL, NULL);
+    }
+    if (rt->conn && rt->offline) {
+        cyxchat_conn_unregister_handler(rt->conn, CYXCHAT_MSG_OFFLINE_PUT,
+                                        CYXCHAT_MSG_OFFLINE_DELETE);
+    }
+    if (rt->chat) {
+        cyxchat_set_file_ctx(rt->chat, NULL);
+        cyxchat_set_offline_ctx(rt->chat, NULL);
+    }
+
+    cyxchat_offline_destroy(rt->offline);
+    cyxchat_contact_list_destroy(rt->contacts);
+    cyxchat_group_ctx_destroy(rt->group);
+    cyxchat_presence_ctx_destroy(rt->presence);
+    cyxchat_mail_ctx_destroy(rt->mail);
+    cyxchat_dns_destroy(rt->dns);
+    cyxchat_file_ctx_destroy(rt->file);
+    cyxchat_destroy(rt->chat);
+    cyxchat_conn_destroy(rt->conn);
+
+    rt->offline = NULL;
+    rt->contacts = NULL;
+    rt->group = NULL;
+    rt->presence = NULL;
+    rt->mail = NULL;
+    rt->dns = NULL;
+    rt->file = NULL;
+    rt->chat = NULL;
+    rt->conn = NULL;
+}
+
+static cyxchat_error_t runtime_create(
+    cyxchat_runtime_t **rt,
+    const char *bootstrap,
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+) {
+    if (!rt) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    /* Every module sizes its tables from one validated config */
+    cyxchat_config_t cfg;
+    if (config) {
+        if (cyxchat_config_validate(config) != CYXCHAT_OK) {
+            return CYXCHAT_ERR_INVALID;
+        }
+        cfg = *config;
+    } else {
+        cyxchat_config_default(&cfg);
+    }
+
+    cyxchat_runtime_t *r = calloc(1, sizeof(cyxchat_runtime_t));
+    if (!r) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+#ifdef _WIN32
+    r->wake_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (!r->wake_event) {
+        free(r);
+        return CYXCHAT_ERR_MEMORY;
+    }
+#else
+    if (pthread_mutex_init(&r->wake_lock, NULL) != 0) {
+        free(r);
+        return CYXCHAT_ERR_MEMORY;
+    }
+    if (pthread_cond_init(&r->wake_cond, NULL) != 0) {
+        pthread_mutex_destroy(&r->wake_lock);
+        free(r);
+        return CYXCHAT_ERR_MEMORY;
+    }
+#endif
+
+    for (uint32_t i = 0; i < CYXCHAT_RUNTIME_CMD_SLOTS; i++) {
+        r->cmds[i].seq = i;
+    }
+
+    if (local_id) {
+        cyxchat_error_t err = create_modules(r, bootstrap, net, local_id, signing_key, &cfg);
+        if (err != CYXCHAT_OK) {
+            cyxchat_runtime_destroy(r);
+            return err;
+        }
+    }
+
+    *rt = r;
+    return CYXCHAT_OK;
+}
+
+cyxchat_error_t cyxchat_runtime_create(
+    cyxchat_runtime_t **rt,
+    const char *bootstrap,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key
+) {
+    return runtime_create(rt, bootstrap, NULL, local_id, signing_key, NULL);
+}
+
+cyxchat_error_t cyxchat_runtime_create_with_config(
+    cyxchat_runtime_t **rt,
+    const char *bootstrap,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key,
+    const cyxchat_config_t *config
+) {
+    return runtime_create(rt, bootstrap, NULL, local_id, signing_key, config);
+}
+
+cyxchat_error_t cyxchat_runtime_create_loopback(
+    cyxchat_runtime_t **rt,
+    cyxchat_loopnet_t *net,
+    const cyxwiz_node_id_t *local_id,
+    const uint8_t *signing_key
+) {
+    if (!net || !local_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+    return runtime_create(rt, NULL, net, local_id, signing_key, NULL);
+}
+
+void cyxchat_runtime_destroy(cyxchat_runtime_t *rt)
+{
+    if (!rt) return;
+
+    cyxchat_runtime_stop_thread(rt);
+    destroy_modules(rt);
+
+#ifdef _WIN32
+    CloseHandle(rt->wake_event);
+#else
+    pthread_cond_destroy(&rt->wake_cond);
+    pthread_mutex_destroy(&rt->wake_lock);
+#endif
+
+    cyxwiz_secure_zero(rt, sizeof(cyxchat_runtime_t));
+    free(rt);
+}
+
+int cyxchat_runtime_poll(cyxchat_runtime_t *rt, uint64_t now_ms)
+{
+    if (!rt || rt->threaded) return 0;
+
+    return runtime_cycle(rt, now_ms, 0);
+}
+
+int cyxchat_runtime_wait(cyxchat_runtime_t *rt, uint32_t max_wait_ms)
+{
+    if (!rt || rt->threaded) return 0;
+
+    uint64_t now_ms = cyxchat_timestamp_ms();
+
+    if (!rt->conn) {
+        runtime_idle(rt, time_until_deadline(rt, now_ms, max_wait_ms));
+        now_ms = cyxchat_timestamp_ms();
+    }
+
+    return runtime_cycle(rt, now_ms, max_wait_ms);
+}
+
+uint64_t cyxchat_runtime_next_deadline(cyxchat_runtime_t *rt)
+{
+    return rt ? next_deadline(rt) : CYXCHAT_TIMER_NONE;
+}
+
+/* ============================================================
+ * Network Thread
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_runtime_start_thread(cyxchat_runtime_t *rt)
+{
+    if (!rt) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (rt->threaded) {
+        return CYXCHAT_ERR_EXISTS;
+    }
+
+    RT_STORE(&rt->running, 1);
+
+#ifdef _WIN32
+    rt->thread = CreateThread(NULL, 0, runtime_thread_main, rt, 0, NULL);
+    if (!rt->thread) {
+        RT_STORE(&rt->running, 0);
+        return CYXCHAT_ERR_MEMORY;
+    }
+#else
+    if (pthread_create(&rt->thread, NULL, runtime_thread_main, rt) != 0) {
+        RT_STORE(&rt->running, 0);
+        return CYXCHAT_ERR_MEMORY;
+    }
+#endif
+
+    rt->threaded = 1;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_runtime_stop_thread(cyxchat_runtime_t *rt)
+{
+    if (!rt || !rt->threaded) return;
+
+    RT_STORE(&rt->running, 0);
+    RT_STORE(&rt->stopping, 1);
+    runtime_signal(rt);
+
+#ifdef _WIN32
+    WaitForSingleObject(rt->thread, INFINITE);
+    CloseHandle(rt->thread);
+    rt->thread = NULL;
+#else
+    pthread_join(rt->thread, NULL);
+#endif
+
+    RT_STORE(&rt->stopping, 0);
+    rt->threaded = 0;
+}
+
+int cyxchat_runtime_is_threaded(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->threaded : 0;
+}
+
+/* ============================================================
+ * Commands
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_runtime_send_text(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const char *text,
+    size_t text_len,
+    const cyxchat_msg_id_t *reply_to,
+    uint64_t tag
+) {
+    if (!rt || !to || !text) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_SEND_TEXT, to, (const uint8_t*)text, text_len,
+                  reply_to, NULL, NULL, tag);
+}
+
+cyxchat_error_t cyxchat_runtime_send_raw(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t tag
+) {
+    if (!rt || !to || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_SEND_RAW, to, data, len, NULL, NULL, NULL, tag);
+}
+
+cyxchat_error_t cyxchat_runtime_conn_send(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *to,
+    const uint8_t *data,
+    size_t len,
+    uint64_t tag
+) {
+    if (!rt || !to || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_CONN_SEND, to, data, len, NULL, NULL, NULL, tag);
+}
+
+cyxchat_error_t cyxchat_runtime_connect(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *peer_id,
+    uint64_t tag
+) {
+    if (!rt || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_CONNECT, peer_id, NULL, 0, NULL, NULL, NULL, tag);
+}
+
+cyxchat_error_t cyxchat_runtime_disconnect(
+    cyxchat_runtime_t *rt,
+    const cyxwiz_node_id_t *peer_id,
+    uint64_t tag
+) {
+    if (!rt || !peer_id) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_DISCONNECT, peer_id, NULL, 0, NULL, NULL, NULL, tag);
+}
+
+cyxchat_error_t cyxchat_runtime_call(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_fn_t fn,
+    void *user_data,
+    uint64_t tag
+) {
+    if (!rt || !fn) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    return submit(rt, RT_CMD_CALL, NULL, NULL, 0, NULL, fn, user_data, tag);
+}
+
+/* ============================================================
+ * Events
+ * ============================================================ */
+
+int cyxchat_runtime_next_event(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_event_t *event_out
+) {
+    if (!rt || !event_out) return 0;
+
+    uint32_t tail = rt->ev_tail;
+    if (RT_LOAD(&rt->ev_head) == tail) {
+        return 0;
+    }
+
+    const cyxchat_runtime_event_t *ev = &rt->events[tail & RT_EVENT_MASK];
+    memcpy(event_out, ev, offsetof(cyxchat_runtime_event_t, data) + ev->data_len);
+
+    RT_STORE(&rt->ev_tail, tail + 1);
+    return 1;
+}
+
+/* ============================================================
+ * Accessors
+ * ============================================================ */
+
+void cyxchat_runtime_get_stats(
+    cyxchat_runtime_t *rt,
+    cyxchat_runtime_stats_t *stats_out
+) {
+    if (!rt || !stats_out) return;
+
+    stats_out->commands = RT_LOAD64(&rt->stats.commands);
+    stats_out->commands_rejected = RT_LOAD(&rt->cmds_rejected);
+    stats_out->events = RT_LOAD64(&rt->stats.events);
+    stats_out->events_dropped = RT_LOAD64(&rt->stats.events_dropped);
+    stats_out->loops = RT_LOAD64(&rt->stats.loops);
+}
+
+cyxchat_conn_ctx_t* cyxchat_runtime_get_conn(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->conn : NULL;
+}
+
+cyxchat_ctx_t* cyxchat_runtime_get_chat(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->chat : NULL;
+}
+
+cyxchat_file_ctx_t* cyxchat_runtime_get_file(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->file : NULL;
+}
+
+cyxchat_dns_ctx_t* cyxchat_runtime_get_dns(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->dns : NULL;
+}
+
+cyxchat_mail_ctx_t* cyxchat_runtime_get_mail(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->mail : NULL;
+}
+
+cyxchat_presence_ctx_t* cyxchat_runtime_get_presence(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->presence : NULL;
+}
+
+cyxchat_group_ctx_t* cyxchat_runtime_get_group(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->group : NULL;
+}
+
+cyxchat_offline_ctx_t* cyxchat_runtime_get_offline(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->offline : NULL;
+}
+
+cyxchat_contact_list_t* cyxchat_runtime_get_contacts(cyxchat_runtime_t *rt)
+{
+    return rt ? rt->contacts : NULL;
+}
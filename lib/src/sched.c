@@ -0,0 +1,310 @@
+/**
+ * CyxChat Outbound Scheduler Implementation
+ *
+ * Frames live in one fixed pool threaded onto per-peer, per-class FIFOs
+ * by index, so queueing never allocates. A flush walks the classes in
+ * priority order and, inside a class, visits peers round robin from
+ * where the last flush of that class stopped, one frame per visit. A
+ * peer's slot is released as soon as its last frame leaves.
+ */
+
+#include <cyxchat/sched.h>
+#include <cyxchat/metrics.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+#define SCHED_NONE  (-1)
+
+typedef struct {
+    int16_t next;                       /* Next frame in queue or free list */
+    uint16_t len;
+    uint8_t data[CYXCHAT_SCHED_FRAME_MAX];
+} cyxchat_sched_frame_t;
+
+typedef struct {
+    int16_t head;
+    int16_t tail;
+    uint32_t bytes;
+} cyxchat_sched_queue_t;
+
+typedef struct {
+    cyxwiz_node_id_t peer_id;
+    cyxchat_sched_queue_t queues[CYXCHAT_PRIO_COUNT];
+    uint32_t frames;                    /* Across all classes */
+    int active;
+} cyxchat_sched_peer_t;
+
+struct cyxchat_sched_ctx {
+    cyxchat_sched_frame_t frames[CYXCHAT_SCHED_SLOTS];
+    int16_t free_head;
+    uint32_t free_count;
+    cyxchat_sched_peer_t peers[CYXCHAT_SCHED_MAX_PEERS];
+    uint8_t next_peer[CYXCHAT_PRIO_COUNT];      /* Round-robin position */
+    cyxchat_sched_stats_t stats;
+};
+
+static const uint32_t class_cap[CYXCHAT_PRIO_COUNT] = {
+    CYXCHAT_SCHED_CAP_CONTROL,
+    CYXCHAT_SCHED_CAP_INTERACTIVE,
+    CYXCHAT_SCHED_CAP_BACKGROUND,
+    CYXCHAT_SCHED_CAP_BULK
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static void peer_reset(cyxchat_sched_peer_t *peer)
+{
+    memset(peer, 0, sizeof(*peer));
+    for (int c = 0; c < CYXCHAT_PRIO_COUNT; c++) {
+        peer->queues[c].head = SCHED_NONE;
+        peer->queues[c].tail = SCHED_NONE;
+    }
+}
+
+static cyxchat_sched_peer_t* find_peer(cyxchat_sched_ctx_t *ctx, const cyxwiz_node_id_t *id)
+{
+    for (int i = 0; i < CYXCHAT_SCHED_MAX_PEERS; i++) {
+        if (ctx->peers[i].active &&
+            memcmp(&ctx->peers[i].peer_id, id, sizeof(cyxwiz_node_id_t)) == 0) {
+            return &ctx->peers[i];
+        }
+    }
+    return NULL;
+}
+
+static cyxchat_sched_peer_t* alloc_peer(cyxchat_sched_ctx_t *ctx, const cyxwiz_node_id_t *id)
+{
+    for (int i = 0; i < CYXCHAT_SCHED_MAX_PEERS; i++) {
+        if (!ctx->peers[i].active) {
+            peer_reset(&ctx->peers[i]);
+            memcpy(&ctx->peers[i].peer_id, id, sizeof(cyxwiz_node_id_t));
+            ctx->peers[i].active = 1;
+            return &ctx->peers[i];
+        }
+    }
+    return NULL;
+}
+
+static void free_frame(cyxchat_sched_ctx_t *ctx, int16_t idx)
+{
+    ctx->frames[idx].next = ctx->free_head;
+    ctx->free_head = idx;
+    ctx->free_count++;
+    CYXCHAT_GAUGE_ADD(CYXCHAT_METRIC_SCHED_QUEUED, -1);
+}
+
+/* Unlink the head frame of a class queue */
+static int16_t pop_frame(cyxchat_sched_ctx_t *ctx, cyxchat_sched_peer_t *peer, int c)
+{
+    cyxchat_sched_queue_t *q = &peer->queues[c];
+    int16_t idx = q->head;
+
+    q->head = ctx->frames[idx].next;
+    if (q->head == SCHED_NONE) {
+        q->tail = SCHED_NONE;
+    }
+    q->bytes -= ctx->frames[idx].len;
+    return idx;
+}
+
+/* ============================================================
+ * Scheduler
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_sched_create(cyxchat_sched_ctx_t **ctx)
+{
+    if (!ctx) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_sched_ctx_t *s = calloc(1, sizeof(cyxchat_sched_ctx_t));
+    if (!s) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    for (int i = 0; i < CYXCHAT_SCHED_SLOTS; i++) {
+        s->frames[i].next = (int16_t)(i + 1 < CYXCHAT_SCHED_SLOTS ? i + 1 : SCHED_NONE);
+    }
+    s->free_head = 0;
+    s->free_count = CYXCHAT_SCHED_SLOTS;
+
+    for (int i = 0; i < CYXCHAT_SCHED_MAX_PEERS; i++) {
+        peer_reset(&s->peers[i]);
+    }
+
+    *ctx = s;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_sched_destroy(cyxchat_sched_ctx_t *ctx)
+{
+    if (ctx) {
+        CYXCHAT_GAUGE_ADD(CYXCHAT_METRIC_SCHED_QUEUED,
+                          -(int64_t)(CYXCHAT_SCHED_SLOTS - ctx->free_count));
+
+        /* Queued frames are message plaintext headers and file data */
+        cyxwiz_secure_zero(ctx, sizeof(cyxchat_sched_ctx_t));
+        free(ctx);
+    }
+}
+
+cyxchat_error_t cyxchat_sched_enqueue(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    cyxchat_prio_t prio,
+    const uint8_t *data,
+    size_t len
+) {
+    if (!ctx || !to || !data) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if ((unsigned)prio >= CYXCHAT_PRIO_COUNT || len == 0 || len > CYXCHAT_SCHED_FRAME_MAX) {
+        return CYXCHAT_ERR_INVALID;
+    }
+
+    /* Low classes leave headroom for the ones that must not wait */
+    uint32_t floor = prio >= CYXCHAT_PRIO_BACKGROUND ? CYXCHAT_SCHED_RESERVED : 0;
+    if (ctx->free_count <= floor) {
+        ctx->stats.rejected[prio]++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_SCHED_DROP, 1);
+        return CYXCHAT_ERR_FULL;
+    }
+
+    cyxchat_sched_peer_t *peer = find_peer(ctx, to);
+    if (peer && peer->queues[prio].bytes + len > class_cap[prio]) {
+        ctx->stats.rejected[prio]++;
+        CYXCHAT_COUNT(CYXCHAT_METRIC_SCHED_DROP, 1);
+        return CYXCHAT_ERR_FULL;
+    }
+    if (!peer) {
+        peer = alloc_peer(ctx, to);
+        if (!peer) {
+            ctx->stats.rejected[prio]++;
+            CYXCHAT_COUNT(CYXCHAT_METRIC_SCHED_DROP, 1);
+            return CYXCHAT_ERR_FULL;
+        }
+    }
+
+    int16_t idx = ctx->free_head;
+    cyxchat_sched_frame_t *frame = &ctx->frames[idx];
+    ctx->free_head = frame->next;
+    ctx->free_count--;
+
+    memcpy(frame->data, data, len);
+    frame->len = (uint16_t)len;
+    frame->next = SCHED_NONE;
+
+    cyxchat_sched_queue_t *q = &peer->queues[prio];
+    if (q->tail == SCHED_NONE) {
+        q->head = idx;
+    } else {
+        ctx->frames[q->tail].next = idx;
+    }
+    q->tail = idx;
+    q->bytes += (uint32_t)len;
+    peer->frames++;
+
+    ctx->stats.queued[prio]++;
+    CYXCHAT_GAUGE_ADD(CYXCHAT_METRIC_SCHED_QUEUED, 1);
+    return CYXCHAT_OK;
+}
+
+size_t cyxchat_sched_flush(
+    cyxchat_sched_ctx_t *ctx,
+    cyxchat_sched_send_fn send,
+    void *user_data,
+    size_t budget_bytes
+) {
+    if (!ctx || !send) return 0;
+
+    size_t sent = 0;
+    size_t bytes = 0;
+
+    for (int c = 0; c < CYXCHAT_PRIO_COUNT; c++) {
+        for (;;) {
+            /* Next peer in turn with something in this class */
+            cyxchat_sched_peer_t *peer = NULL;
+            for (int k = 0; k < CYXCHAT_SCHED_MAX_PEERS; k++) {
+                int i = (ctx->next_peer[c] + k) % CYXCHAT_SCHED_MAX_PEERS;
+                if (ctx->peers[i].active && ctx->peers[i].queues[c].head != SCHED_NONE) {
+                    peer = &ctx->peers[i];
+                    ctx->next_peer[c] = (uint8_t)((i + 1) % CYXCHAT_SCHED_MAX_PEERS);
+                    break;
+                }
+            }
+            if (!peer) break;
+
+            int16_t idx = pop_frame(ctx, peer, c);
+            cyxchat_sched_frame_t *frame = &ctx->frames[idx];
+            cyxwiz_node_id_t to = peer->peer_id;
+            if (--peer->frames == 0) {
+                peer->active = 0;
+            }
+
+            /* Frame stays out of the free list until sent: send may enqueue */
+            if (send(user_data, &to, frame->data, frame->len) == CYXCHAT_OK) {
+                ctx->stats.sent[c]++;
+            } else {
+                ctx->stats.failed[c]++;
+            }
+            bytes += frame->len;
+            sent++;
+            free_frame(ctx, idx);
+
+            if (budget_bytes && bytes >= budget_bytes) {
+                return sent;
+            }
+        }
+    }
+
+    return sent;
+}
+
+size_t cyxchat_sched_queued_bytes(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to,
+    cyxchat_prio_t prio
+) {
+    if (!ctx || !to || (unsigned)prio >= CYXCHAT_PRIO_COUNT) return 0;
+
+    cyxchat_sched_peer_t *peer = find_peer(ctx, to);
+    return peer ? peer->queues[prio].bytes : 0;
+}
+
+void cyxchat_sched_drop_peer(
+    cyxchat_sched_ctx_t *ctx,
+    const cyxwiz_node_id_t *to
+) {
+    if (!ctx || !to) return;
+
+    cyxchat_sched_peer_t *peer = find_peer(ctx, to);
+    if (!peer) return;
+
+    for (int c = 0; c < CYXCHAT_PRIO_COUNT; c++) {
+        while (peer->queues[c].head != SCHED_NONE) {
+            free_frame(ctx, pop_frame(ctx, peer, c));
+        }
+    }
+    peer_reset(peer);
+}
+
+void cyxchat_sched_get_stats(
+    cyxchat_sched_ctx_t *ctx,
+    cyxchat_sched_stats_t *stats_out
+) {
+    if (!stats_out) return;
+
+    if (!ctx) {
+        memset(stats_out, 0, sizeof(cyxchat_sched_stats_t));
+        return;
+    }
+
+    *stats_out = ctx->stats;
+}
@@ -0,0 +1,334 @@
+/**
+ * CyxChat Timer Wheel Implementation
+ *
+ * Five levels of 64 slots at 1 ms resolution. A timer due in d ms sits
+ * on the lowest level whose span covers d, in the slot for its expiry
+ * time at that level's granularity. Advancing visits only the slots
+ * whose time range was crossed; timers found there either fire or drop
+ * to a finer level. A per-level occupancy bitmap lets next_deadline
+ * skip empty slots without walking them.
+ */
+
+#include <cyxchat/timer.h>
+#include <cyxwiz/memory.h>
+#include <string.h>
+#include <stdlib.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#define TIMER_SLOT_MASK     (CYXCHAT_TIMER_SLOTS - 1)
+#define TIMER_LEVEL_LIST    0xFF    /* On the expired or todo list */
+
+/* ============================================================
+ * Internal Structures
+ * ============================================================ */
+
+struct cyxchat_timer_wheel {
+    uint64_t now;
+    cyxchat_timer_t *slots[CYXCHAT_TIMER_LEVELS][CYXCHAT_TIMER_SLOTS];
+    uint64_t occupied[CYXCHAT_TIMER_LEVELS];    /* Bit per non-empty slot */
+    cyxchat_timer_t *expired;                   /* Due before placement */
+    cyxchat_timer_t *todo;                      /* Collected during advance */
+    size_t count;
+};
+
+/* ============================================================
+ * Helper Functions
+ * ============================================================ */
+
+static int ctz64(uint64_t v)
+{
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long idx;
+    _BitScanForward64(&idx, v);
+    return (int)idx;
+#elif defined(_MSC_VER)
+    int n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        n++;
+    }
+    return n;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+static uint64_t rotr64(uint64_t v, unsigned int n)
+{
+    n &= 63;
+    return n ? (v >> n) | (v << (64 - n)) : v;
+}
+
+static void list_push(cyxchat_timer_t **head, cyxchat_timer_t *timer)
+{
+    timer->next = *head;
+    if (*head) {
+        (*head)->pprev = &timer->next;
+    }
+    *head = timer;
+    timer->pprev = head;
+}
+
+static void list_unlink(cyxchat_timer_t *timer)
+{
+    *timer->pprev = timer->next;
+    if (timer->next) {
+        timer->next->pprev = timer->pprev;
+    }
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/* Link timer into the slot matching its expiry (wheel->now < expires) */
+static void place(cyxchat_timer_wheel_t *wheel, cyxchat_timer_t *timer)
+{
+    uint64_t delta = timer->expires - wheel->now;
+    uint64_t at = timer->expires;
+
+    if (delta > CYXCHAT_TIMER_MAX_DELAY) {
+        /* Park at the far edge; re-placed when that slot is reached */
+        delta = CYXCHAT_TIMER_MAX_DELAY;
+        at = wheel->now + delta;
+    }
+
+    int level = 0;
+    while (level < CYXCHAT_TIMER_LEVELS - 1 &&
+           (delta >> (CYXCHAT_TIMER_SLOT_BITS * (level + 1))) != 0) {
+        level++;
+    }
+
+    int slot = (int)((at >> (CYXCHAT_TIMER_SLOT_BITS * level)) & TIMER_SLOT_MASK);
+
+    timer->level = (uint8_t)level;
+    timer->slot = (uint8_t)slot;
+    list_push(&wheel->slots[level][slot], timer);
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+static void unlink_timer(cyxchat_timer_wheel_t *wheel, cyxchat_timer_t *timer)
+{
+    uint8_t level = timer->level;
+    uint8_t slot = timer->slot;
+
+    list_unlink(timer);
+
+    if (level != TIMER_LEVEL_LIST && !wheel->slots[level][slot]) {
+        wheel->occupied[level] &= ~(1ULL << slot);
+    }
+}
+
+/* Move every timer in a slot onto the todo list */
+static void collect_slot(cyxchat_timer_wheel_t *wheel, int level, int slot)
+{
+    cyxchat_timer_t *t;
+    while ((t = wheel->slots[level][slot]) != NULL) {
+        list_unlink(t);
+        t->level = TIMER_LEVEL_LIST;
+        list_push(&wheel->todo, t);
+    }
+    wheel->occupied[level] &= ~(1ULL << slot);
+}
+
+/* ============================================================
+ * Wheel Lifecycle
+ * ============================================================ */
+
+cyxchat_error_t cyxchat_timer_wheel_create(
+    cyxchat_timer_wheel_t **wheel,
+    uint64_t now_ms
+) {
+    if (!wheel) {
+        return CYXCHAT_ERR_NULL;
+    }
+
+    cyxchat_timer_wheel_t *w = calloc(1, sizeof(cyxchat_timer_wheel_t));
+    if (!w) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+
+    w->now = now_ms;
+
+    *wheel = w;
+    return CYXCHAT_OK;
+}
+
+void cyxchat_timer_wheel_destroy(cyxchat_timer_wheel_t *wheel)
+{
+    if (wheel) {
+        cyxwiz_secure_zero(wheel, sizeof(cyxchat_timer_wheel_t));
+        free(wheel);
+    }
+}
+
+/* ============================================================
+ * Scheduling
+ * ============================================================ */
+
+void cyxchat_timer_schedule(
+    cyxchat_timer_wheel_t *wheel,
+    cyxchat_timer_t *timer,
+    uint64_t expires_ms,
+    cyxchat_timer_cb_t callback,
+    void *user_data
+) {
+    if (!wheel || !timer) return;
+
+    if (timer->pprev) {
+        unlink_timer(wheel, timer);
+    } else {
+        wheel->count++;
+    }
+
+    timer->expires = expires_ms;
+    timer->callback = callback;
+    timer->user_data = user_data;
+
+    if (expires_ms <= wheel->now) {
+        timer->level = TIMER_LEVEL_LIST;
+        list_push(&wheel->expired, timer);
+    } else {
+        place(wheel, timer);
+    }
+}
+
+void cyxchat_timer_cancel(
+    cyxchat_timer_wheel_t *wheel,
+    cyxchat_timer_t *timer
+) {
+    if (!wheel || !timer || !timer->pprev) return;
+
+    unlink_timer(wheel, timer);
+    if (wheel->count > 0) {
+        wheel->count--;
+    }
+}
+
+void cyxchat_timer_move(
+    cyxchat_timer_wheel_t *from,
+    cyxchat_timer_wheel_t *to,
+    cyxchat_timer_t *timer
+) {
+    if (!from || !to || !timer || !timer->pprev || from == to) return;
+
+    uint64_t remaining = timer->expires > from->now ? timer->expires - from->now : 0;
+
+    cyxchat_timer_cancel(from, timer);
+    cyxchat_timer_schedule(to, timer, to->now + remaining,
+                           timer->callback, timer->user_data);
+}
+
+int cyxchat_timer_pending(const cyxchat_timer_t *timer)
+{
+    return timer && timer->pprev != NULL;
+}
+
+/* ============================================================
+ * Advancing
+ * ============================================================ */
+
+int cyxchat_timer_advance(cyxchat_timer_wheel_t *wheel, uint64_t now_ms)
+{
+    if (!wheel) return 0;
+
+    /* Timers scheduled already-due since the last advance */
+    cyxchat_timer_t *t;
+    while ((t = wheel->expired) != NULL) {
+        list_unlink(t);
+        list_push(&wheel->todo, t);
+    }
+
+    if (now_ms > wheel->now) {
+        for (int level = 0; level < CYXCHAT_TIMER_LEVELS; level++) {
+            if (!wheel->occupied[level]) continue;
+
+            int shift = CYXCHAT_TIMER_SLOT_BITS * level;
+            uint64_t from = wheel->now >> shift;
+            uint64_t to = now_ms >> shift;
+
+            if (to == from) continue;
+
+            if (to - from >= CYXCHAT_TIMER_SLOTS) {
+                /* Whole level passed */
+                uint64_t bits = wheel->occupied[level];
+                while (bits) {
+                    int slot = ctz64(bits);
+                    bits &= bits - 1;
+                    collect_slot(wheel, level, slot);
+                }
+            } else {
+                for (uint64_t v = from + 1; v <= to; v++) {
+                    int slot = (int)(v & TIMER_SLOT_MASK);
+                    if (wheel->occupied[level] & (1ULL << slot)) {
+                        collect_slot(wheel, level, slot);
+                    }
+                }
+            }
+        }
+
+        wheel->now = now_ms;
+    }
+
+    /*
+     * Fire due timers and cascade the rest. Anything a callback
+     * schedules at or before now lands on the expired list and fires
+     * on the next advance, so a self-rearming timer cannot spin here.
+     */
+    int fired = 0;
+    while ((t = wheel->todo) != NULL) {
+        list_unlink(t);
+
+        if (t->expires <= wheel->now) {
+            if (wheel->count > 0) {
+                wheel->count--;
+            }
+            if (t->callback) {
+                t->callback(t, t->user_data, wheel->now);
+            }
+            fired++;
+        } else {
+            place(wheel, t);
+        }
+    }
+
+    return fired;
+}
+
+uint64_t cyxchat_timer_next_deadline(cyxchat_timer_wheel_t *wheel)
+{
+    if (!wheel || wheel->count == 0) return CYXCHAT_TIMER_NONE;
+    if (wheel->expired || wheel->todo) return wheel->now;
+
+    uint64_t best = CYXCHAT_TIMER_NONE;
+
+    for (int level = 0; level < CYXCHAT_TIMER_LEVELS; level++) {
+        uint64_t bits = wheel->occupied[level];
+        if (!bits) continue;
+
+        int shift = CYXCHAT_TIMER_SLOT_BITS * level;
+        uint64_t pos = wheel->now >> shift;
+
+        /* Distance (1..64) to the next occupied slot after the current one */
+        uint64_t ahead = rotr64(bits, (unsigned int)((pos + 1) & TIMER_SLOT_MASK));
+        uint64_t dist = (uint64_t)ctz64(ahead) + 1;
+
+        uint64_t start = (pos + dist) << shift;
+        if (start < best) {
+            best = start;
+        }
+    }
+
+    return best;
+}
+
+uint64_t cyxchat_timer_now(cyxchat_timer_wheel_t *wheel)
+{
+    return wheel ? wheel->now : 0;
+}
+
+size_t cyxchat_timer_count(cyxchat_timer_wheel_t *wheel)
+{
+    return wheel ? wheel->count : 0;
+}
@@ -0,0 +1,421 @@
+/**
+ * CyxChat Trace Implementation
+ *
+ * The trace ring is a fixed array of binary records. Writers claim a
+ * sequence number with an atomic increment, fill the slot and publish it
+ * by storing seq + 1 into the slot's commit word. Readers copy a slot
+ * only if its commit word matches before and after the copy, so a dump
+ * never blocks writers and never returns a torn record. Fences after the
+ * writer's invalidate and before the reader's re-check keep the record
+ * accesses between the two commit-word accesses.
+ *
+ * Message tracing reuses the ring: stage events carry a trace ID, and
+ * two thread-locals bridge the layers that cannot see the message ID
+ * (a send's ID travels down to the transport, a datagram's arrival
+ * time travels up to the chat layer).
+ */
+
+#include <cyxchat/trace.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TRACE_FETCH_ADD(p, v) \
+    ((uint32_t)_InterlockedExchangeAdd((volatile long *)(p), (long)(v)))
+/* volatile alone is not acquire/release on ARM (/volatile:iso) */
+static __forceinline uint32_t trace_load_acquire(const uint32_t *p)
+{
+    uint32_t v = *(const volatile uint32_t *)p;
+    MemoryBarrier();
+    return v;
+}
+#define TRACE_LOAD(p)       trace_load_acquire(p)
+#define TRACE_STORE(p, v)   do { MemoryBarrier(); *(volatile uint32_t *)(p) = (v); } while (0)
+#define TRACE_FENCE_RELEASE() MemoryBarrier()
+#define TRACE_FENCE_ACQUIRE() MemoryBarrier()
+#else
+#define TRACE_FETCH_ADD(p, v) __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define TRACE_LOAD(p)       __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define TRACE_STORE(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define TRACE_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define TRACE_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+#ifdef _MSC_VER
+#define TRACE_TLS __declspec(thread)
+#else
+#define TRACE_TLS _Thread_local
+#endif
+
+#define TRACE_RING_MASK (CYXCHAT_TRACE_RING_SIZE - 1)
+
+/* ============================================================
+ * State
+ * ============================================================ */
+
+static volatile int g_log_level = CYXCHAT_LOG_LEVEL;
+static volatile int g_trace_enabled = 1;
+
+static uint32_t g_trace_head;
+static uint32_t g_trace_commit[CYXCHAT_TRACE_RING_SIZE];
+static cyxchat_trace_event_t g_trace_ring[CYXCHAT_TRACE_RING_SIZE];
+
+static volatile uint32_t g_sample_rate;             /* 0 = message tracing off */
+static TRACE_TLS uint32_t t_current_trace;          /* Send in progress */
+static TRACE_TLS uint16_t t_rx_event;               /* Unclaimed arrival */
+static TRACE_TLS uint32_t t_rx_size;
+static TRACE_TLS uint64_t t_rx_us;
+
+static const char *event_names[] = {
+    "none",
+    "msg_recv",
+    "msg_dup",
+    "frag_recv",
+    "frag_done",
+    "msg_send",
+    "frag_send",
+    "send_fail",
+    "announce_sent",
+    "announce_fail",
+    "key_exchange",
+    "send_begin",
+    "onion_tx",
+    "transport_tx",
+    "relay_tx",
+    "transport_rx",
+    "relay_rx",
+    "recv_queued",
+    "recv_polled",
+    "callback"
+};
+
+static uint64_t get_time_us(void)
+{
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) {
+        QueryPerformanceFrequency(&freq);
+    }
+    QueryPerformanceCounter(&now);
+    uint64_t sec = (uint64_t)(now.QuadPart / freq.QuadPart);
+    uint64_t rem = (uint64_t)(now.QuadPart % freq.QuadPart);
+    return sec * 1000000 + rem * 1000000 / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+#endif
+}
+
+/* ============================================================
+ * Log Level
+ * ============================================================ */
+
+void cyxchat_log_set_level(int level)
+{
+    if (level < CYXCHAT_LOG_LEVEL_DEBUG) level = CYXCHAT_LOG_LEVEL_DEBUG;
+    if (level > CYXCHAT_LOG_LEVEL_NONE) level = CYXCHAT_LOG_LEVEL_NONE;
+    g_log_level = level;
+}
+
+int cyxchat_log_get_level(void)
+{
+    return g_log_level;
+}
+
+void cyxchat_log_peer_prefix(const cyxwiz_node_id_t *id, char *hex_out)
+{
+    static const char hex_chars[] = "0123456789abcdef";
+
+    if (!hex_out) return;
+    if (!id) {
+        hex_out[0] = '\0';
+        return;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        hex_out[i * 2] = hex_chars[(id->bytes[i] >> 4) & 0x0F];
+        hex_out[i * 2 + 1] = hex_chars[id->bytes[i] & 0x0F];
+    }
+    hex_out[16] = '\0';
+}
+
+/* ============================================================
+ * Trace Ring
+ * ============================================================ */
+
+void cyxchat_trace_set_enabled(int enabled)
+{
+    g_trace_enabled = enabled ? 1 : 0;
+}
+
+static void trace_record_at(
+    uint16_t event,
+    uint32_t trace_id,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size,
+    uint64_t timestamp_us
+) {
+    uint32_t seq = TRACE_FETCH_ADD(&g_trace_head, 1);
+    uint32_t slot = seq & TRACE_RING_MASK;
+
+    /* Invalidate while writing; the fence keeps the record writes below it */
+    TRACE_STORE(&g_trace_commit[slot], 0);
+    TRACE_FENCE_RELEASE();
+
+    cyxchat_trace_event_t *e = &g_trace_ring[slot];
+    e->timestamp_us = timestamp_us;
+    e->seq = seq;
+    e->event = event;
+    if (peer) {
+        memcpy(e->peer, peer->bytes, CYXCHAT_TRACE_PEER_PREFIX);
+    } else {
+        memset(e->peer, 0, CYXCHAT_TRACE_PEER_PREFIX);
+    }
+    e->size = size;
+    e->trace_id = trace_id;
+
+    TRACE_STORE(&g_trace_commit[slot], seq + 1);
+}
+
+void cyxchat_trace_record(
+    uint16_t event,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+) {
+    if (!g_trace_enabled) return;
+    trace_record_at(event, 0, peer, size, get_time_us());
+}
+
+void cyxchat_trace_record_msg(
+    uint16_t event,
+    uint32_t trace_id,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+) {
+    if (!g_trace_enabled) return;
+    trace_record_at(event, trace_id, peer, size, get_time_us());
+}
+
+/* ============================================================
+ * Message Tracing
+ * ============================================================ */
+
+void cyxchat_trace_set_sample_rate(uint32_t one_in)
+{
+    g_sample_rate = one_in;
+}
+
+uint32_t cyxchat_trace_sample(const cyxchat_msg_id_t *msg_id)
+{
+    uint32_t rate = g_sample_rate;
+    if (!msg_id || rate == 0 || !g_trace_enabled) return 0;
+
+    /* Message IDs are random, so their low bytes sample evenly */
+    uint32_t id = (uint32_t)msg_id->bytes[0] |
+                  ((uint32_t)msg_id->bytes[1] << 8) |
+                  ((uint32_t)msg_id->bytes[2] << 16) |
+                  ((uint32_t)msg_id->bytes[3] << 24);
+    if (id == 0 || id % rate != 0) return 0;
+    return id;
+}
+
+void cyxchat_trace_set_current(uint32_t trace_id)
+{
+    t_current_trace = trace_id;
+}
+
+uint32_t cyxchat_trace_current(void)
+{
+    return t_current_trace;
+}
+
+void cyxchat_trace_record_current(
+    uint16_t event,
+    const cyxwiz_node_id_t *peer,
+    uint32_t size
+) {
+    uint32_t trace_id = t_current_trace;
+    if (trace_id == 0 || !g_trace_enabled) return;
+    trace_record_at(event, trace_id, peer, size, get_time_us());
+}
+
+void cyxchat_trace_mark_rx(uint16_t event, uint32_t size)
+{
+    if (g_sample_rate == 0 || !g_trace_enabled) return;
+
+    t_rx_event = event;
+    t_rx_size = size;
+    t_rx_us = get_time_us();
+}
+
+void cyxchat_trace_claim_rx(uint32_t trace_id, const cyxwiz_node_id_t *peer)
+{
+    if (t_rx_us == 0) return;
+
+    if (trace_id != 0) {
+        trace_record_at(t_rx_event, trace_id, peer, t_rx_size, t_rx_us);
+    }
+    t_rx_us = 0;
+}
+
+size_t cyxchat_trace_dump(
+    cyxchat_trace_event_t *events_out,
+    size_t max_events
+) {
+    if (!events_out || max_events == 0) return 0;
+
+    uint32_t head = TRACE_LOAD(&g_trace_head);
+    uint32_t count = head < CYXCHAT_TRACE_RING_SIZE ? head : CYXCHAT_TRACE_RING_SIZE;
+    if (count > max_events) {
+        count = (uint32_t)max_events;
+    }
+
+    size_t copied = 0;
+    for (uint32_t seq = head - count; seq != head; seq++) {
+        uint32_t slot = seq & TRACE_RING_MASK;
+
+        uint32_t before = TRACE_LOAD(&g_trace_commit[slot]);
+        if (before != seq + 1) continue;
+
+        cyxchat_trace_event_t e = g_trace_ring[slot];
+
+        /* The copy must complete before the commit word is re-read */
+        TRACE_FENCE_ACQUIRE();
+        if (TRACE_LOAD(&g_trace_commit[slot]) != before) continue;
+
+        events_out[copied++] = e;
+    }
+
+    return copied;
+}
+
+/* ============================================================
+ * Chrome Trace Export
+ * ============================================================ */
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;
+    int full;
+} chrome_writer_t;
+
+static void chrome_put(chrome_writer_t *w, const char *fmt, ...)
+{
+    if (w->full) return;
+
+    size_t room = w->size - w->len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(w->buf + w->len, room, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t)n >= room) {
+        w->full = 1;
+        return;
+    }
+    w->len += (size_t)n;
+}
+
+/* Latest earlier stage of the same message, or NULL */
+static const cyxchat_trace_event_t* previous_stage(const cyxchat_trace_event_t *events,
+                                                   size_t count, size_t index)
+{
+    const cyxchat_trace_event_t *e = &events[index];
+    const cyxchat_trace_event_t *best = NULL;
+
+    for (size_t i = 0; i < count; i++) {
+        const cyxchat_trace_event_t *p = &events[i];
+        if (i == index || p->trace_id != e->trace_id) continue;
+
+        /* Arrival stamps are recorded late, so order by time, then sequence */
+        if (p->timestamp_us > e->timestamp_us ||
+            (p->timestamp_us == e->timestamp_us && p->seq >= e->seq)) {
+            continue;
+        }
+        if (!best || p->timestamp_us > best->timestamp_us ||
+            (p->timestamp_us == best->timestamp_us && p->seq > best->seq)) {
+            best = p;
+        }
+    }
+    return best;
+}
+
+cyxchat_error_t cyxchat_trace_export_chrome(
+    char *buf,
+    size_t buf_size,
+    size_t *len_out
+) {
+    if (!buf || !len_out) {
+        return CYXCHAT_ERR_NULL;
+    }
+    if (buf_size == 0) {
+        return CYXCHAT_ERR_FULL;
+    }
+
+    cyxchat_trace_event_t *events = malloc(CYXCHAT_TRACE_RING_SIZE * sizeof(cyxchat_trace_event_t));
+    if (!events) {
+        return CYXCHAT_ERR_MEMORY;
+    }
+    size_t count = cyxchat_trace_dump(events, CYXCHAT_TRACE_RING_SIZE);
+
+    chrome_writer_t w = { buf, buf_size, 0, 0 };
+    chrome_put(&w, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+
+    for (size_t i = 0; i < count; i++) {
+        const cyxchat_trace_event_t *e = &events[i];
+        const cyxchat_trace_event_t *prev = e->trace_id ? previous_stage(events, count, i) : NULL;
+
+        chrome_put(&w, "%s\n  {\"name\": \"%s\", \"cat\": \"%s\", \"pid\": 1, \"tid\": %u",
+                   i ? "," : "", cyxchat_trace_event_name(e->event),
+                   e->trace_id ? "msg" : "event", (unsigned)e->trace_id);
+        if (prev) {
+            chrome_put(&w, ", \"ph\": \"X\", \"ts\": %llu, \"dur\": %llu",
+                       (unsigned long long)prev->timestamp_us,
+                       (unsigned long long)(e->timestamp_us - prev->timestamp_us));
+        } else {
+            chrome_put(&w, ", \"ph\": \"i\", \"s\": \"t\", \"ts\": %llu",
+                       (unsigned long long)e->timestamp_us);
+        }
+        chrome_put(&w, ", \"args\": {\"peer\": \"%02x%02x%02x%02x\", \"size\": %u",
+                   e->peer[0], e->peer[1], e->peer[2], e->peer[3], (unsigned)e->size);
+        if (prev) {
+            chrome_put(&w, ", \"from\": \"%s\"", cyxchat_trace_event_name(prev->event));
+        }
+        chrome_put(&w, "}}");
+    }
+
+    chrome_put(&w, "\n]}\n");
+    free(events);
+
+    buf[w.len] = '\0';
+    *len_out = w.len;
+    return w.full ? CYXCHAT_ERR_FULL : CYXCHAT_OK;
+}
+
+void cyxchat_trace_clear(void)
+{
+    for (size_t i = 0; i < CYXCHAT_TRACE_RING_SIZE; i++) {
+        TRACE_STORE(&g_trace_commit[i], 0);
+    }
+}
+
+const char* cyxchat_trace_event_name(uint16_t event)
+{
+    if (event < CYXCHAT_TRACE_EVENT_COUNT) {
+        return event_names[event];
+    }
+    return "unknown";
+}
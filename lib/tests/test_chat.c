@@ -65,6 +65,107 @@ int test_chat(void) {
         TEST_ASSERT(cyxchat_msg_id_is_zero(&zero_id), "Zero ID should be detected");
     }
 
+    /* Test buffered random pool */
+    {
+        cyxchat_rng_t *rng = NULL;
+        TEST_ASSERT(cyxchat_rng_create(&rng) == CYXCHAT_OK, "RNG create should succeed");
+
+        uint8_t a[CYXCHAT_MSG_ID_SIZE], b[CYXCHAT_MSG_ID_SIZE];
+        cyxchat_rng_bytes(rng, a, sizeof(a));
+        cyxchat_rng_bytes(rng, b, sizeof(b));
+        TEST_ASSERT(memcmp(a, b, sizeof(a)) != 0, "Pool IDs should be unique");
+
+        /* Spanning a refill boundary must still produce fresh bytes */
+        uint8_t big[CYXCHAT_RNG_BLOCK_SIZE + 64];
+        cyxchat_rng_bytes(rng, big, sizeof(big));
+        TEST_ASSERT(memcmp(big, big + CYXCHAT_RNG_BLOCK_SIZE, 64) != 0,
+                    "Refilled block should differ");
+
+        cyxchat_rng_destroy(rng);
+    }
+
+    /* Test trace ring */
+    {
+        cyxwiz_node_id_t peer;
+        memset(&peer, 0x5A, sizeof(peer));
+
+        cyxchat_trace_clear();
+        cyxchat_trace_record(CYXCHAT_TRACE_MSG_SEND, &peer, 42);
+        cyxchat_trace_record(CYXCHAT_TRACE_MSG_RECV, NULL, 7);
+
+        cyxchat_trace_event_t events[4];
+        size_t n = cyxchat_trace_dump(events, 4);
+        TEST_ASSERT(n == 2, "Trace should hold 2 events");
+        if (n == 2) {
+            TEST_ASSERT(events[0].event == CYXCHAT_TRACE_MSG_SEND, "Oldest event first");
+            TEST_ASSERT(events[0].size == 42, "Event size should be kept");
+            TEST_ASSERT(events[0].peer[0] == 0x5A, "Peer prefix should be kept");
+            TEST_ASSERT(events[1].seq == events[0].seq + 1, "Sequence should increase");
+        }
+
+        char hex[17];
+        cyxchat_log_peer_prefix(&peer, hex);
+        TEST_ASSERT(strcmp(hex, "5a5a5a5a5a5a5a5a") == 0, "Peer prefix hex should match");
+    }
+
+    /* Test message tracing and Chrome export */
+    {
+        cyxwiz_node_id_t peer;
+        cyxchat_msg_id_t msg_id;
+        memset(&peer, 0x5A, sizeof(peer));
+        memset(&msg_id, 0, sizeof(msg_id));
+        msg_id.bytes[0] = 6;
+
+        TEST_ASSERT(cyxchat_trace_sample(&msg_id) == 0, "Sampling should be off by default");
+        cyxchat_trace_set_sample_rate(3);
+        uint32_t trace_id = cyxchat_trace_sample(&msg_id);
+        TEST_ASSERT(trace_id == 6, "ID divisible by rate should be sampled");
+        msg_id.bytes[0] = 7;
+        TEST_ASSERT(cyxchat_trace_sample(&msg_id) == 0, "Other IDs should not be sampled");
+
+        cyxchat_trace_clear();
+        cyxchat_trace_record_msg(CYXCHAT_TRACE_SEND_BEGIN, trace_id, &peer, 5);
+
+        /* Lower layers pick the ID up from the thread */
+        cyxchat_trace_record_current(CYXCHAT_TRACE_TRANSPORT_TX, &peer, 99);
+        cyxchat_trace_set_current(trace_id);
+        cyxchat_trace_record_current(CYXCHAT_TRACE_TRANSPORT_TX, &peer, 120);
+        cyxchat_trace_set_current(0);
+
+        /* Arrival is stamped early, recorded once the message is known */
+        cyxchat_trace_mark_rx(CYXCHAT_TRACE_TRANSPORT_RX, 120);
+        cyxchat_trace_claim_rx(trace_id, &peer);
+        cyxchat_trace_claim_rx(trace_id, &peer);
+        cyxchat_trace_record(CYXCHAT_TRACE_ANNOUNCE_SENT, &peer, 64);
+
+        cyxchat_trace_event_t events[8];
+        size_t n = cyxchat_trace_dump(events, 8);
+        TEST_ASSERT(n == 4, "Untraced send and second claim should not record");
+        if (n == 4) {
+            TEST_ASSERT(events[1].event == CYXCHAT_TRACE_TRANSPORT_TX &&
+                        events[1].trace_id == trace_id, "Transport stage should carry trace ID");
+            TEST_ASSERT(events[2].event == CYXCHAT_TRACE_TRANSPORT_RX &&
+                        events[2].trace_id == trace_id, "Claimed arrival should carry trace ID");
+            TEST_ASSERT(events[3].trace_id == 0, "Plain events should be untraced");
+        }
+
+        static char json[16384];
+        size_t len = 0;
+        TEST_ASSERT(cyxchat_trace_export_chrome(json, sizeof(json), &len) == CYXCHAT_OK,
+                    "Chrome export should succeed");
+        TEST_ASSERT(len == strlen(json), "Export length should match");
+        TEST_ASSERT(strncmp(json, "{\"displayTimeUnit\"", 18) == 0, "Export should be a JSON object");
+        TEST_ASSERT(strstr(json, "\"name\": \"transport_tx\", \"cat\": \"msg\", \"pid\": 1, \"tid\": 6, \"ph\": \"X\"") != NULL,
+                    "Later stage should be a span on the message row");
+        TEST_ASSERT(strstr(json, "\"from\": \"send_begin\"") != NULL, "Span should name its start");
+        TEST_ASSERT(strstr(json, "\"name\": \"announce_sent\", \"cat\": \"event\", \"pid\": 1, \"tid\": 0, \"ph\": \"i\"") != NULL,
+                    "Plain event should be an instant");
+        TEST_ASSERT(cyxchat_trace_export_chrome(json, 32, &len) == CYXCHAT_ERR_FULL,
+                    "Short buffer should report full");
+
+        cyxchat_trace_set_sample_rate(0);
+    }
+
     /* Test timestamp */
     {
         uint64_t ts1 = cyxchat_timestamp_ms();
@@ -0,0 +1,144 @@
+/**
+ * CyxChat Test - Configuration and Arena
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <cyxchat/cyxchat.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+/* Header of two words, then a table of *arg words */
+static void* test_layout(cyxchat_arena_t *arena, const void *arg) {
+    size_t count = *(const size_t*)arg;
+    uint64_t *head = cyxchat_arena_carve(arena, 2, sizeof(uint64_t));
+    uint64_t *table = cyxchat_arena_carve(arena, count, sizeof(uint64_t));
+    if (head && table) {
+        head[0] = count;
+        head[1] = arena->size;
+    }
+    return head;
+}
+
+int test_config(void) {
+    int errors = 0;
+
+    /* Test defaults and validation */
+    {
+        cyxchat_config_t cfg;
+        cyxchat_config_default(&cfg);
+        TEST_ASSERT(cfg.recv_queue_size == CYXCHAT_CONFIG_RECV_QUEUE, "Default queue size");
+        TEST_ASSERT(cfg.max_contacts == CYXCHAT_MAX_CONTACTS, "Default contact capacity");
+        TEST_ASSERT(cfg.dns_cache_size == CYXCHAT_DNS_CACHE_SIZE, "Default DNS cache size");
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_OK, "Defaults should validate");
+
+        cfg.recv_queue_size = 1;
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_ERR_INVALID,
+                    "Queue needs a spare slot");
+        cyxchat_config_default(&cfg);
+        cfg.max_groups = 0;
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_ERR_INVALID, "Zero capacity should fail");
+        cyxchat_config_default(&cfg);
+        cfg.mail_max_stored = CYXCHAT_CONFIG_MAX_ENTRIES + 1;
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_ERR_INVALID, "Huge capacity should fail");
+        cyxchat_config_default(&cfg);
+        cfg.label_table_size = 96;
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_ERR_INVALID,
+                    "Label table must be a power of two");
+        cyxchat_config_default(&cfg);
+        cfg.max_peers = 0;
+        TEST_ASSERT(cyxchat_config_validate(&cfg) == CYXCHAT_OK, "Unlimited peers should validate");
+        TEST_ASSERT(cyxchat_config_validate(NULL) == CYXCHAT_ERR_NULL, "NULL config should fail");
+
+        cyxchat_config_t defaults;
+        TEST_ASSERT(cyxchat_config_resolve(NULL, &defaults) == &defaults &&
+                    defaults.max_groups == CYXCHAT_CONFIG_GROUPS, "NULL resolves to the defaults");
+        TEST_ASSERT(cyxchat_config_resolve(&cfg, &defaults) == &cfg, "Valid config kept");
+        cfg.max_contacts = 0;
+        TEST_ASSERT(cyxchat_config_resolve(&cfg, &defaults) == NULL, "Invalid config refused");
+    }
+
+    /* Test measure then carve */
+    {
+        cyxchat_arena_t arena;
+        cyxchat_arena_init(&arena, NULL, 0);
+        TEST_ASSERT(cyxchat_arena_carve(&arena, 1, 3) == NULL, "Measuring carve returns NULL");
+        cyxchat_arena_carve(&arena, 10, sizeof(uint64_t));
+        TEST_ASSERT(arena.used == CYXCHAT_ARENA_ALIGN + 10 * sizeof(uint64_t),
+                    "Measure should include alignment padding");
+
+        uint8_t *block = cyxchat_arena_alloc(&arena);
+        TEST_ASSERT(block != NULL && arena.size == CYXCHAT_ARENA_ALIGN + 10 * sizeof(uint64_t),
+                    "Alloc should size the block from the measure");
+        uint8_t *a = cyxchat_arena_carve(&arena, 1, 3);
+        uint64_t *b = cyxchat_arena_carve(&arena, 10, sizeof(uint64_t));
+        TEST_ASSERT(a == block, "First carve starts the block");
+        TEST_ASSERT((uint8_t*)b == block + CYXCHAT_ARENA_ALIGN, "Second carve should be aligned");
+        TEST_ASSERT(b && b[9] == 0, "Carved memory should be zeroed");
+        TEST_ASSERT(cyxchat_arena_carve(&arena, 1, 1) == NULL && arena.overflow,
+                    "Carving past the block should fail");
+        free(block);
+
+        cyxchat_arena_init(&arena, NULL, 0);
+        cyxchat_arena_carve(&arena, SIZE_MAX / 2, 4);
+        TEST_ASSERT(arena.overflow && cyxchat_arena_alloc(&arena) == NULL,
+                    "Overflowing measure should not allocate");
+    }
+
+    /* Test building a context from its layout */
+    {
+        size_t count = 10;
+        uint64_t *ctx = cyxchat_arena_build(test_layout, &count);
+        TEST_ASSERT(ctx != NULL && ctx[0] == count, "Build carves the struct first");
+        TEST_ASSERT(ctx && ctx[1] == CYXCHAT_ARENA_ALIGN + count * sizeof(uint64_t),
+                    "Build allocates what the measure asked for");
+        free(ctx);
+
+        count = SIZE_MAX / 4;
+        TEST_ASSERT(cyxchat_arena_build(test_layout, &count) == NULL,
+                    "Overflowing layout should not build");
+    }
+
+    /* Test configured contact capacity */
+    {
+        cyxchat_config_t cfg;
+        cyxchat_config_default(&cfg);
+        cfg.max_contacts = 2;
+
+        cyxchat_contact_list_t *list = NULL;
+        TEST_ASSERT(cyxchat_contact_list_create_with_config(&list, &cfg) == CYXCHAT_OK,
+                    "Configured list creation should succeed");
+
+        cyxwiz_node_id_t id;
+        uint8_t key[32];
+        memset(key, 0xAA, sizeof(key));
+        for (uint8_t i = 1; i <= 2; i++) {
+            memset(&id, i, sizeof(id));
+            TEST_ASSERT(cyxchat_contact_add(list, &id, key, "Peer") == CYXCHAT_OK,
+                        "Adding within capacity should succeed");
+        }
+        memset(&id, 3, sizeof(id));
+        TEST_ASSERT(cyxchat_contact_add(list, &id, key, "Peer") == CYXCHAT_ERR_FULL,
+                    "Adding past capacity should report full");
+
+        memset(&id, 1, sizeof(id));
+        TEST_ASSERT(cyxchat_contact_remove(list, &id) == CYXCHAT_OK, "Remove should succeed");
+        memset(&id, 3, sizeof(id));
+        TEST_ASSERT(cyxchat_contact_add(list, &id, key, "Peer") == CYXCHAT_OK,
+                    "Freed slot should be reusable");
+        cyxchat_contact_list_destroy(list);
+
+        cfg.max_contacts = 0;
+        list = NULL;
+        TEST_ASSERT(cyxchat_contact_list_create_with_config(&list, &cfg) == CYXCHAT_ERR_INVALID &&
+                    list == NULL, "Invalid config should not create");
+    }
+
+    return errors;
+}
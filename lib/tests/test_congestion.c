@@ -0,0 +1,92 @@
+/**
+ * CyxChat Test - Delay-Based Congestion Control
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/congestion.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+int test_congestion(void) {
+    int errors = 0;
+    cyxchat_congestion_t cc;
+
+    /* Test idle pacing before any sample */
+    {
+        cyxchat_congestion_init(&cc);
+        TEST_ASSERT(cyxchat_congestion_interval_us(&cc) == CYXCHAT_CC_IDLE_INTERVAL_US,
+                    "Idle interval without samples");
+        TEST_ASSERT(cc.slow_start, "Starts in slow start");
+    }
+
+    /* Test slow start doubles until the queue builds */
+    {
+        cyxchat_congestion_init(&cc);
+        cyxchat_congestion_on_rtt(&cc, 40, 40);
+        uint32_t first = cyxchat_congestion_interval_us(&cc);
+        TEST_ASSERT(first == 40000 / (CYXCHAT_CC_INIT_CWND * 2), "Window paced over RTT");
+
+        cyxchat_congestion_on_rtt(&cc, 40, 40);
+        TEST_ASSERT(cyxchat_congestion_interval_us(&cc) == first / 2, "Window doubles");
+
+        /* Queue at the target: leave slow start */
+        cyxchat_congestion_on_rtt(&cc, 40 + CYXCHAT_CC_TARGET_MS, 40);
+        cyxchat_congestion_on_rtt(&cc, 40 + CYXCHAT_CC_TARGET_MS, 40);
+        TEST_ASSERT(!cc.slow_start, "Slow start ends near target");
+        TEST_ASSERT(cc.qdelay_ms == CYXCHAT_CC_TARGET_MS, "Queueing delay measured");
+    }
+
+    /* Test excess delay shrinks the window, spare room grows it */
+    {
+        cyxchat_congestion_init(&cc);
+        cc.slow_start = 0;
+        cc.cwnd = 64 * 256;
+
+        cyxchat_congestion_on_rtt(&cc, 20 + 2 * CYXCHAT_CC_TARGET_MS, 20);
+        cyxchat_congestion_on_rtt(&cc, 20 + 2 * CYXCHAT_CC_TARGET_MS, 20);
+        TEST_ASSERT(cc.cwnd < 64 * 256 && cc.cwnd >= 16 * 256, "Decrease bounded by half");
+
+        uint32_t shrunk = cc.cwnd;
+        cyxchat_congestion_on_rtt(&cc, 20, 20);
+        cyxchat_congestion_on_rtt(&cc, 20, 20);
+        TEST_ASSERT(cc.cwnd > shrunk, "Empty queue grows the window");
+        TEST_ASSERT(cc.cwnd <= shrunk + 2 * 256, "Growth at most one packet per sample");
+    }
+
+    /* Test a single delayed reply is filtered out */
+    {
+        cyxchat_congestion_init(&cc);
+        cc.slow_start = 0;
+        cc.cwnd = 32 * 256;
+        cyxchat_congestion_on_rtt(&cc, 30, 30);
+        cyxchat_congestion_on_rtt(&cc, 30 + 4 * CYXCHAT_CC_TARGET_MS, 30);
+        TEST_ASSERT(cc.qdelay_ms == 0 && cc.cwnd >= 32 * 256, "Spike ignored");
+    }
+
+    /* Test loss halves once per RTT */
+    {
+        cyxchat_congestion_init(&cc);
+        cyxchat_congestion_on_rtt(&cc, 100, 100);
+        cc.cwnd = 40 * 256;
+
+        cyxchat_congestion_on_loss(&cc, 1000);
+        TEST_ASSERT(cc.cwnd == 20 * 256 && !cc.slow_start, "Loss halves the window");
+        cyxchat_congestion_on_loss(&cc, 1050);
+        TEST_ASSERT(cc.cwnd == 20 * 256, "Same RTT, same event");
+        cyxchat_congestion_on_loss(&cc, 1100);
+        TEST_ASSERT(cc.cwnd == 10 * 256, "Next RTT halves again");
+
+        for (int i = 0; i < 20; i++) cyxchat_congestion_on_loss(&cc, 2000 + (uint64_t)i * 200);
+        TEST_ASSERT(cc.cwnd == CYXCHAT_CC_MIN_CWND * 256, "Window floor");
+        TEST_ASSERT(cyxchat_congestion_interval_us(&cc) == 100000, "One packet per RTT");
+    }
+
+    return errors;
+}
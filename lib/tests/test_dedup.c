@@ -0,0 +1,152 @@
+/**
+ * CyxChat Test - Duplicate Suppression
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/dedup.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+static void make_id(cyxchat_msg_id_t *id, uint32_t n) {
+    memset(id, 0, sizeof(*id));
+    id->bytes[0] = (uint8_t)(n & 0xFF);
+    id->bytes[1] = (uint8_t)((n >> 8) & 0xFF);
+    id->bytes[2] = (uint8_t)((n >> 16) & 0xFF);
+    id->bytes[3] = (uint8_t)((n >> 24) & 0xFF);
+}
+
+int test_dedup(void) {
+    int errors = 0;
+
+    cyxchat_dedup_ctx_t *ctx = NULL;
+    cyxchat_error_t err = cyxchat_dedup_create(&ctx);
+    TEST_ASSERT(err == CYXCHAT_OK, "Create should succeed");
+    TEST_ASSERT(ctx != NULL, "Context should not be NULL");
+    if (!ctx) return errors;
+
+    cyxwiz_node_id_t alice, bob;
+    memset(&alice, 0xAA, sizeof(alice));
+    memset(&bob, 0xBB, sizeof(bob));
+
+    /* Test first sighting vs duplicate */
+    {
+        cyxchat_msg_id_t id;
+        make_id(&id, 1);
+
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &alice, &id, 0) == 0, "First ID should be new");
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &alice, &id, 0) == 1, "Repeated ID should be duplicate");
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &bob, &id, 0) == 0, "Same ID from other peer should be new");
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &alice, &id, 1) == 0, "Different sub-key should be new");
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &alice, &id, 1) == 1, "Repeated sub-key should be duplicate");
+    }
+
+    /* Test no false drops across the full window */
+    {
+        cyxchat_msg_id_t id;
+        int false_drops = 0;
+        for (uint32_t n = 100; n < 100 + 10 * CYXCHAT_DEDUP_WINDOW; n++) {
+            make_id(&id, n);
+            if (cyxchat_dedup_check(ctx, &alice, &id, 0)) {
+                false_drops++;
+            }
+        }
+        TEST_ASSERT(false_drops == 0, "Distinct IDs should never be dropped");
+
+        /* Most recent generation is still remembered */
+        make_id(&id, 100 + 10 * CYXCHAT_DEDUP_WINDOW - 1);
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &alice, &id, 0) == 1, "Recent ID should be duplicate");
+    }
+
+    /* Test forget peer */
+    {
+        cyxchat_msg_id_t id;
+        make_id(&id, 7);
+        cyxchat_dedup_check(ctx, &bob, &id, 0);
+        cyxchat_dedup_forget_peer(ctx, &bob);
+        TEST_ASSERT(cyxchat_dedup_check(ctx, &bob, &id, 0) == 0, "Forgotten peer should start clean");
+    }
+
+    /* Test stats */
+    {
+        cyxchat_dedup_stats_t stats;
+        cyxchat_dedup_get_stats(ctx, &stats);
+        TEST_ASSERT(stats.duplicates == 3, "Should count 3 duplicates");
+        TEST_ASSERT(stats.checked > stats.duplicates, "Checked should exceed duplicates");
+    }
+
+    /* Test NULL handling */
+    {
+        cyxchat_msg_id_t id;
+        make_id(&id, 1);
+        TEST_ASSERT(cyxchat_dedup_check(NULL, &alice, &id, 0) == 0, "NULL ctx should not drop");
+        TEST_ASSERT(cyxchat_dedup_create(NULL) == CYXCHAT_ERR_NULL, "NULL output should fail");
+    }
+
+    cyxchat_dedup_destroy(ctx);
+
+    /* Test sequence window: in order, reordered, duplicates */
+    {
+        cyxchat_dedup_seq_t w;
+        memset(&w, 0, sizeof(w));
+        uint32_t base = 0xFFFFFFF0u;    /* Wraps part way */
+
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base) == 0, "First number should start the window");
+        int fresh = 0;
+        for (uint32_t i = 1; i <= 20; i++) {
+            fresh += cyxchat_dedup_seq_check(&w, base + i) == 0;
+        }
+        TEST_ASSERT(fresh == 20, "In-order numbers should be new across the wrap");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 20) == 1, "Top should be a duplicate");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 5) == 1, "Older copy should be a duplicate");
+
+        /* The direct path overtakes the relay by up to the window */
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 30) == 0, "Skip ahead should be new");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 25) == 0, "Late number should be new");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 25) == 1, "Late number only once");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, base + 1) == 1,
+                    "Numbers before the skip should be remembered");
+    }
+
+    /* Test sequence window: behind the window, jumps, restart */
+    {
+        cyxchat_dedup_seq_t w;
+        memset(&w, 0, sizeof(w));
+
+        cyxchat_dedup_seq_check(&w, 1000);
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 1000 - CYXCHAT_DEDUP_SEQ_WINDOW) == 1,
+                    "Number behind the window should be dropped");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 1000 - CYXCHAT_DEDUP_SEQ_WINDOW + 1) == 0,
+                    "Number just inside the window should be new");
+
+        /* A jump of a whole window clears it */
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 1000 + CYXCHAT_DEDUP_SEQ_WINDOW) == 0,
+                    "Jump of a window should be new");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 1000 + 1) == 0,
+                    "Skipped number should be new after a jump");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 1000 + CYXCHAT_DEDUP_SEQ_WINDOW) == 1,
+                    "Jump target should be recorded");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, 5000) == 0 &&
+                    cyxchat_dedup_seq_check(&w, 5000 - CYXCHAT_DEDUP_SEQ_WINDOW + 1) == 0,
+                    "Long jump should leave nothing in the window");
+
+        /* Far behind: the sender restarted from a new random start */
+        uint32_t restart = 5000 - CYXCHAT_DEDUP_SEQ_RESYNC;
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, restart + 1) == 1,
+                    "Short of the resync distance should be dropped");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, restart) == 0, "Restart should be new");
+        TEST_ASSERT(w.top == restart, "Restart should move the window");
+        TEST_ASSERT(cyxchat_dedup_seq_check(&w, restart + 1) == 0 &&
+                    cyxchat_dedup_seq_check(&w, restart) == 1,
+                    "Window should run from the restart");
+        TEST_ASSERT(cyxchat_dedup_seq_check(NULL, 1) == 0, "NULL window should not drop");
+    }
+
+    return errors;
+}
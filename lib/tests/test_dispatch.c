@@ -0,0 +1,178 @@
+/**
+ * CyxChat Test - Message Type Dispatch
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/dispatch.h>
+#include <cyxchat/relay.h>
+#include <cyxchat/connection.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+static int g_calls;
+static uint8_t g_last_type;
+
+static void count_handler(void *user_data, const cyxwiz_node_id_t *from,
+                          const uint8_t *data, size_t len, int via_relay) {
+    (void)from;
+    (void)len;
+    (void)via_relay;
+    (*(int*)user_data)++;
+    g_calls++;
+    g_last_type = data[0];
+}
+
+static void other_handler(void *user_data, const cyxwiz_node_id_t *from,
+                          const uint8_t *data, size_t len, int via_relay) {
+    count_handler(user_data, from, data, len, via_relay);
+}
+
+static int g_data_calls;
+static uint8_t g_data_first, g_data_type;
+
+static void on_data(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                    const uint8_t *data, size_t len, void *user_data) {
+    (void)ctx;
+    (void)from;
+    (void)user_data;
+    g_data_calls++;
+    g_data_first = data[0];
+    g_data_type = len > 1 ? data[1] : 0;
+}
+
+/* Route one message the way the connection layer does */
+static void deliver(const cyxchat_dispatch_t *d, uint8_t type) {
+    const cyxchat_dispatch_entry_t *h = &d->entries[type];
+    if (h->fn) {
+        h->fn(h->user_data, NULL, &type, 1, 0);
+    }
+}
+
+int test_dispatch(void) {
+    int errors = 0;
+    cyxchat_dispatch_t d;
+    int mine = 0, theirs = 0;
+
+    /* Test registration and routing */
+    {
+        cyxchat_dispatch_init(&d);
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x10, 0x1F, 0, count_handler, &mine) == CYXCHAT_OK,
+                    "Register range");
+        TEST_ASSERT(d.entries[0x10].fn && d.entries[0x1F].fn && !d.entries[0x20].fn,
+                    "Range is inclusive");
+
+        g_calls = 0;
+        deliver(&d, 0x15);
+        deliver(&d, 0x20);
+        TEST_ASSERT(g_calls == 1 && mine == 1 && g_last_type == 0x15, "Only claimed types routed");
+    }
+
+    /* Test overlapping ranges are refused whole */
+    {
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x1F, 0x2F, 0, other_handler, &theirs) ==
+                    CYXCHAT_ERR_EXISTS, "Overlap refused");
+        TEST_ASSERT(!d.entries[0x20].fn, "Refused range left unclaimed");
+        TEST_ASSERT(d.entries[0x1F].fn == count_handler, "Owner kept");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x20, 0x2F, 0, other_handler, &theirs) == CYXCHAT_OK,
+                    "Adjacent range accepted");
+
+        deliver(&d, 0x1F);
+        deliver(&d, 0x20);
+        TEST_ASSERT(mine == 2 && theirs == 1, "Each type reaches one owner");
+    }
+
+    /* Test argument checks */
+    {
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x40, 0x30, 0, count_handler, NULL) ==
+                    CYXCHAT_ERR_INVALID, "Reversed range");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x30, 0x30, 0, NULL, NULL) == CYXCHAT_ERR_NULL,
+                    "NULL handler");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0xFF, 0xFF, CYXCHAT_DISPATCH_LINK,
+                                              count_handler, NULL) == CYXCHAT_OK, "Last type");
+        TEST_ASSERT(d.entries[0xFF].flags == CYXCHAT_DISPATCH_LINK, "Flags stored");
+    }
+
+    /* Test unregister frees the range for a new owner */
+    {
+        cyxchat_dispatch_unregister(&d, 0x10, 0x1F);
+        TEST_ASSERT(!d.entries[0x10].fn && !d.entries[0x1F].fn, "Range released");
+        TEST_ASSERT(d.entries[0x20].fn == other_handler, "Neighbour untouched");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, 0x10, 0x1F, 0, other_handler, &theirs) == CYXCHAT_OK,
+                    "Re-register");
+    }
+
+    /* Test protocol namespaces the connection layer claims are disjoint */
+    {
+        cyxchat_dispatch_init(&d);
+        TEST_ASSERT(cyxchat_dispatch_register(&d, CYXCHAT_MSG_MAIL_SEND, CYXCHAT_MSG_MAIL_BOUNCE, 0,
+                                              count_handler, &mine) == CYXCHAT_OK, "Mail range");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, CYXCHAT_RELAY_CONNECT, CYXCHAT_RELAY_ERROR,
+                                              CYXCHAT_DISPATCH_LINK, count_handler, &mine) ==
+                    CYXCHAT_OK, "Relay clear of mail");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, CYXCHAT_MSG_CONN_CANDIDATES,
+                                              CYXCHAT_MSG_CONN_CHECK_ACK, 0,
+                                              count_handler, &mine) == CYXCHAT_OK,
+                    "Connection control clear of relay");
+        TEST_ASSERT(cyxchat_dispatch_register(&d, CYXCHAT_MSG_DNS_REGISTER, CYXCHAT_MSG_DNS_ANNOUNCE, 0,
+                                              count_handler, &mine) == CYXCHAT_OK, "DNS range");
+        TEST_ASSERT(!cyxchat_relay_is_relay_message(CYXCHAT_MSG_MAIL_SEND) &&
+                    !cyxchat_relay_is_relay_message(CYXCHAT_MSG_MAIL_FETCH_RESP),
+                    "Mail is not relay traffic");
+        TEST_ASSERT(CYXCHAT_PROTOCOL_VERSION >= CYXCHAT_MSG_FRAMED &&
+                    CYXCHAT_PROTOCOL_VERSION <= CYXCHAT_MSG_FRAMED_LAST,
+                    "Header version byte in its own range");
+    }
+
+    /* Test a header-framed mail frame reaches the data callback */
+    {
+        cyxchat_loopnet_t *net = NULL;
+        cyxchat_conn_ctx_t *a = NULL, *b = NULL;
+        cyxwiz_node_id_t id_a, id_b;
+        memset(&id_a, 0xA1, sizeof(id_a));
+        memset(&id_b, 0xB2, sizeof(id_b));
+
+        TEST_ASSERT(cyxchat_loopnet_create(&net, 1) == CYXCHAT_OK, "Create network");
+        TEST_ASSERT(cyxchat_conn_create_loopback(&a, net, &id_a) == CYXCHAT_OK &&
+                    cyxchat_conn_create_loopback(&b, net, &id_b) == CYXCHAT_OK,
+                    "Create nodes");
+
+        if (a && b) {
+            cyxchat_conn_set_poll_timeout(b, 0);
+            cyxchat_conn_set_on_data(b, on_data, NULL);
+
+            uint8_t mail[sizeof(cyxchat_msg_header_t) + 8];
+            cyxchat_msg_header_t hdr;
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.version = CYXCHAT_PROTOCOL_VERSION;
+            hdr.type = CYXCHAT_MSG_MAIL_SEND;
+            memset(mail, 0x33, sizeof(mail));
+            memcpy(mail, &hdr, sizeof(hdr));
+
+            cyxwiz_transport_t *t = cyxchat_conn_get_transport(a);
+            t->ops->send(t, &id_b, mail, sizeof(mail));
+
+            uint64_t now = cyxchat_loopnet_now_ms(net) + 1000;
+            cyxchat_loopnet_set_time(net, now);
+            g_data_calls = 0;
+            cyxchat_conn_poll(b, now);
+
+            TEST_ASSERT(g_data_calls == 1, "Mail frame delivered once");
+            TEST_ASSERT(g_data_first == CYXCHAT_PROTOCOL_VERSION &&
+                        g_data_type == CYXCHAT_MSG_MAIL_SEND,
+                        "Mail frame intact, type second");
+        }
+
+        if (a) cyxchat_conn_destroy(a);
+        if (b) cyxchat_conn_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    return errors;
+}
@@ -0,0 +1,145 @@
+/**
+ * CyxChat Test - ICE-lite Candidates and Path Selection
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/ice.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#else
+#include <arpa/inet.h>
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+static cyxchat_ice_candidate_t make_cand(uint8_t type, uint32_t ip, uint16_t port) {
+    cyxchat_ice_candidate_t c;
+    c.type = type;
+    c.ip = htonl(ip);
+    c.port = htons(port);
+    return c;
+}
+
+int test_ice(void) {
+    int errors = 0;
+
+    cyxchat_ice_checklist_t cl;
+    cyxchat_ice_candidate_t lan = make_cand(CYXCHAT_ICE_HOST, 0xC0A80105u, 40000);
+    cyxchat_ice_candidate_t wan = make_cand(CYXCHAT_ICE_SRFLX, 0xCB007105u, 51000);
+    cyxchat_ice_candidate_t relay = make_cand(CYXCHAT_ICE_RELAY, 0xC6336407u, 7000);
+
+    /* Test priorities follow candidate type */
+    {
+        TEST_ASSERT(cyxchat_ice_priority(&lan) > cyxchat_ice_priority(&wan),
+                    "Host outranks server reflexive");
+        TEST_ASSERT(cyxchat_ice_priority(&wan) > cyxchat_ice_priority(&relay),
+                    "Server reflexive outranks relay");
+    }
+
+    /* Test add, dedupe and check order */
+    {
+        cyxchat_ice_init(&cl);
+        TEST_ASSERT(cl.selected == -1 && cl.checking == -1, "Fresh list is idle");
+
+        TEST_ASSERT(cyxchat_ice_add(&cl, &wan) == 0, "First candidate at 0");
+        TEST_ASSERT(cyxchat_ice_add(&cl, &relay) == 1, "Relay candidate at 1");
+        TEST_ASSERT(cyxchat_ice_add(&cl, &lan) == 2, "LAN candidate at 2");
+        TEST_ASSERT(cyxchat_ice_add(&cl, &wan) == 0 && cl.count == 3, "Duplicate not added");
+
+        cyxchat_ice_candidate_t zero = make_cand(CYXCHAT_ICE_HOST, 0, 1);
+        TEST_ASSERT(cyxchat_ice_add(&cl, &zero) == -1, "Unspecified address rejected");
+
+        TEST_ASSERT(cyxchat_ice_next_check(&cl, -1) == 0, "Round starts at 0");
+        TEST_ASSERT(cyxchat_ice_next_check(&cl, 0) == 2, "Relay candidate skipped");
+        TEST_ASSERT(cyxchat_ice_next_check(&cl, 2) == -1, "Round ends");
+    }
+
+    /* Test lowest RTT wins, with hysteresis on later rounds */
+    {
+        cyxchat_ice_record(&cl, 0, 40);
+        cyxchat_ice_record(&cl, 2, 2);
+        TEST_ASSERT(cyxchat_ice_select(&cl) == 2, "LAN path selected");
+
+        /* WAN now slightly faster: not enough to move */
+        cyxchat_ice_record(&cl, 0, 1);
+        cyxchat_ice_record(&cl, 2, 3);
+        TEST_ASSERT(cyxchat_ice_select(&cl) == 2, "Small gain keeps the path");
+
+        /* LAN path stops answering */
+        cyxchat_ice_record(&cl, 2, CYXCHAT_ICE_RTT_NONE);
+        TEST_ASSERT(cyxchat_ice_select(&cl) == 0, "Failed path replaced");
+
+        cyxchat_ice_record(&cl, 0, CYXCHAT_ICE_RTT_NONE);
+        TEST_ASSERT(cyxchat_ice_select(&cl) == -1, "Nothing works");
+    }
+
+    /* Test a lost punch (inherits the previous RTT) never wins */
+    {
+        cyxchat_ice_init(&cl);
+        cyxchat_ice_add(&cl, &wan);
+        cyxchat_ice_add(&cl, &lan);
+        cyxchat_ice_record(&cl, 0, 30);
+        cyxchat_ice_record(&cl, 1, 29);     /* Same path, jitter */
+        TEST_ASSERT(cyxchat_ice_select(&cl) == 0, "Inherited RTT does not win");
+
+        cyxchat_ice_record(&cl, 1, 20);
+        TEST_ASSERT(cyxchat_ice_select(&cl) == 1, "Clear gain migrates");
+    }
+
+    /* Test eviction when full */
+    {
+        cyxchat_ice_init(&cl);
+        for (int i = 0; i < CYXCHAT_ICE_MAX_CANDIDATES; i++) {
+            cyxchat_ice_candidate_t r = make_cand(CYXCHAT_ICE_RELAY, 0x0A000001u + (uint32_t)i, 7000);
+            cyxchat_ice_add(&cl, &r);
+        }
+        TEST_ASSERT(cl.count == CYXCHAT_ICE_MAX_CANDIDATES, "List full");
+        cyxchat_ice_candidate_t r = make_cand(CYXCHAT_ICE_RELAY, 0x0A0000FFu, 7000);
+        TEST_ASSERT(cyxchat_ice_add(&cl, &r) == -1, "Equal priority not evicted");
+        int idx = cyxchat_ice_add(&cl, &lan);
+        TEST_ASSERT(idx >= 0 && cl.cand[idx].ip == lan.ip, "Host evicts a relay candidate");
+    }
+
+    /* Test wire round trip */
+    {
+        cyxchat_ice_candidate_t in[3] = { lan, wan, relay };
+        cyxchat_ice_candidate_t out[3];
+        uint8_t buf[64];
+
+        size_t len = cyxchat_ice_encode(in, 3, buf, sizeof(buf));
+        TEST_ASSERT(len == 1 + 3 * CYXCHAT_ICE_WIRE_SIZE, "Encoded size");
+        TEST_ASSERT(cyxchat_ice_decode(buf, len, out, 3) == 3, "Decoded count");
+        TEST_ASSERT(memcmp(&out[0].ip, &lan.ip, 4) == 0 && out[0].port == lan.port &&
+                    out[2].type == CYXCHAT_ICE_RELAY, "Decoded candidates match");
+
+        TEST_ASSERT(cyxchat_ice_decode(buf, len - 1, out, 3) == -1, "Truncated rejected");
+        TEST_ASSERT(cyxchat_ice_decode(buf, len, out, 1) == 1, "Output capacity honoured");
+        TEST_ASSERT(cyxchat_ice_encode(in, 3, buf, 10) == 0, "Small buffer rejected");
+    }
+
+    /* Test host gathering skips loopback */
+    {
+        cyxchat_ice_candidate_t hosts[CYXCHAT_ICE_MAX_CANDIDATES];
+        size_t n = cyxchat_ice_gather_host(hosts, CYXCHAT_ICE_MAX_CANDIDATES, htons(40000));
+        int loopback = 0;
+        for (size_t i = 0; i < n; i++) {
+            if ((ntohl(hosts[i].ip) >> 24) == 127) loopback = 1;
+            TEST_ASSERT(hosts[i].type == CYXCHAT_ICE_HOST && hosts[i].port == htons(40000),
+                        "Host candidate carries the port");
+        }
+        TEST_ASSERT(!loopback, "Loopback not gathered");
+        TEST_ASSERT(cyxchat_ice_gather_host(hosts, CYXCHAT_ICE_MAX_CANDIDATES, 0) == 0,
+                    "No port, no candidates");
+    }
+
+    return errors;
+}
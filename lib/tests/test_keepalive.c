@@ -0,0 +1,103 @@
+/**
+ * CyxChat Test - NAT Binding Lifetime Search
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/keepalive.h>
+#include <cyxchat/connection.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+/* Run the search against a NAT that drops bindings after lifetime_ms */
+static void run_search(cyxchat_keepalive_t *ka, uint32_t lifetime_ms) {
+    cyxchat_keepalive_init(ka);
+    for (int i = 0; i < 32 && ka->trial_ms; i++) {
+        cyxchat_keepalive_on_trial(ka, ka->trial_ms <= lifetime_ms);
+    }
+}
+
+int test_keepalive(void) {
+    int errors = 0;
+    cyxchat_keepalive_t ka;
+
+    /* Test defaults before any trial */
+    {
+        cyxchat_keepalive_init(&ka);
+        TEST_ASSERT(ka.interval_ms == CYXCHAT_KEEPALIVE_INTERVAL_MS, "Default interval");
+        TEST_ASSERT(ka.trial_ms == CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS, "First trial queued");
+    }
+
+    /* Test doubling, then bisection down to the resolution */
+    {
+        cyxchat_keepalive_init(&ka);
+        cyxchat_keepalive_on_trial(&ka, 1);
+        TEST_ASSERT(ka.trial_ms == 2 * CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS, "Trial doubles");
+        TEST_ASSERT(ka.interval_ms == CYXCHAT_KEEPALIVE_INTERVAL_MS,
+                    "Short survival does not lower the interval");
+
+        cyxchat_keepalive_on_trial(&ka, 0);
+        TEST_ASSERT(ka.trial_ms == 30000, "Bisects survived and lost idle");
+
+        run_search(&ka, 47000);
+        TEST_ASSERT(ka.trial_ms == 0, "Search ends");
+        TEST_ASSERT(ka.dead_ms - ka.alive_ms <= CYXCHAT_KEEPALIVE_RESOLUTION_MS &&
+                    ka.alive_ms <= 47000 && ka.dead_ms > 47000, "Lifetime bracketed");
+        TEST_ASSERT(ka.interval_ms == ka.alive_ms * CYXCHAT_KEEPALIVE_MARGIN_PCT / 100,
+                    "Interval under the lifetime");
+        TEST_ASSERT(ka.trials <= 6, "Few trials");
+    }
+
+    /* Test short-lived bindings pull the interval down at once */
+    {
+        cyxchat_keepalive_init(&ka);
+        cyxchat_keepalive_on_trial(&ka, 0);
+        TEST_ASSERT(ka.interval_ms ==
+                    CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS * CYXCHAT_KEEPALIVE_MARGIN_PCT / 100,
+                    "Lost binding lowers interval");
+
+        run_search(&ka, 3000);
+        TEST_ASSERT(ka.trial_ms == 0 && ka.alive_ms == 0, "Nothing survives");
+        TEST_ASSERT(ka.interval_ms == CYXCHAT_KEEPALIVE_MIN_MS, "Interval floor");
+    }
+
+    /* Test long-lived bindings stop at the longest interval */
+    {
+        run_search(&ka, 3600000);
+        TEST_ASSERT(ka.dead_ms == 0, "Never lost");
+        TEST_ASSERT(ka.interval_ms == CYXCHAT_KEEPALIVE_MAX_MS, "Interval cap");
+        TEST_ASSERT(ka.interval_ms < CYXCHAT_CONNECTION_TIMEOUT_MS, "Within peer timeout");
+    }
+
+    /* Test an unsupported server keeps the default */
+    {
+        cyxchat_keepalive_init(&ka);
+        cyxchat_keepalive_unsupported(&ka);
+        TEST_ASSERT(ka.unsupported && ka.trial_ms == 0, "Search stopped");
+        cyxchat_keepalive_on_trial(&ka, 1);
+        TEST_ASSERT(ka.trials == 0 && ka.interval_ms == CYXCHAT_KEEPALIVE_INTERVAL_MS,
+                    "Late result ignored");
+    }
+
+    /* Test window jitter stays under the interval */
+    {
+        cyxchat_keepalive_init(&ka);
+        uint32_t lowest = ka.interval_ms;
+        for (uint32_t r = 0; r < 10000; r += 7) {
+            uint32_t w = cyxchat_keepalive_window_ms(&ka, r * 2654435761u);
+            if (w < lowest) lowest = w;
+            TEST_ASSERT(w <= ka.interval_ms, "Window never exceeds interval");
+        }
+        TEST_ASSERT(lowest >= ka.interval_ms - ka.interval_ms * CYXCHAT_KEEPALIVE_JITTER_PCT / 100,
+                    "Jitter bounded");
+        TEST_ASSERT(lowest < ka.interval_ms, "Jitter applied");
+    }
+
+    return errors;
+}
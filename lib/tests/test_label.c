@@ -0,0 +1,333 @@
+/**
+ * CyxChat Test - Label Switching
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/label.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+typedef struct {
+    cyxwiz_node_id_t id;
+    uint8_t sk[64];
+    uint8_t secret[CYXCHAT_LABEL_KEY_SIZE];
+} test_hop_t;
+
+static void make_hop(test_hop_t *h, uint8_t fill) {
+    memset(h, fill, sizeof(*h));
+#ifdef CYXWIZ_HAS_CRYPTO
+    crypto_sign_keypair(h->id.bytes, h->sk);
+#endif
+    cyxchat_label_identity(h->secret, h->sk);
+}
+
+/* Add a hop to an ingress's circuit the way a request and its mapping do */
+static int add_hop(cyxchat_label_entry_t *ing, cyxchat_label_entry_t *hop,
+                   const test_hop_t *who, const cyxwiz_node_id_t *prev, uint32_t req_id) {
+    cyxchat_label_circuit_t *c = ing->circuit;
+    cyxchat_label_mapping_t map;
+    uint8_t pub[CYXCHAT_LABEL_KEY_SIZE];
+
+    cyxchat_label_keypair(pub, c->eph_secret);
+    if (cyxchat_label_accept(hop->key_in, map.eph_public, map.auth, who->secret, &who->id,
+                             pub, req_id) != CYXCHAT_OK ||
+        cyxchat_label_complete(c->keys[c->hop_count], c->eph_secret, &who->id,
+                               map.eph_public, map.auth, req_id) != CYXCHAT_OK) {
+        return 0;
+    }
+
+    c->route[c->hop_count++] = who->id;
+    hop->prev_hop = *prev;
+    hop->state = CYXCHAT_LABEL_ACTIVE;
+    return 1;
+}
+
+int test_label(void) {
+    int errors = 0;
+
+    /* Test allocation, lookup and rest before reuse */
+    {
+        cyxchat_label_table_t *t = NULL;
+        TEST_ASSERT(cyxchat_label_table_create(&t, 3) == CYXCHAT_ERR_INVALID,
+                    "Capacity must be a power of two");
+        TEST_ASSERT(cyxchat_label_table_create(&t, 4) == CYXCHAT_OK && t != NULL,
+                    "Table creation should succeed");
+
+        cyxchat_label_entry_t *e[4];
+        for (int i = 0; i < 4; i++) {
+            e[i] = cyxchat_label_alloc(t, 1000);
+            TEST_ASSERT(e[i] != NULL && e[i]->state == CYXCHAT_LABEL_RESERVED,
+                        "Allocation should reserve");
+            TEST_ASSERT(e[i] && e[i]->label_in != 0, "Label should not be zero");
+        }
+        TEST_ASSERT(cyxchat_label_alloc(t, 1000) == NULL, "Full table should refuse");
+        TEST_ASSERT(cyxchat_label_count(t) == 4, "Count should track allocations");
+        TEST_ASSERT(cyxchat_label_lookup(t, e[2]->label_in) == e[2], "Lookup should find label");
+        TEST_ASSERT(cyxchat_label_lookup(t, (uint16_t)(e[2]->label_in ^ 0x100)) == NULL,
+                    "Same slot with other random bits should miss");
+
+        cyxchat_label_circuit_t *c = cyxchat_label_circuit_alloc(t, e[1]);
+        TEST_ASSERT(c != NULL && e[1]->circuit == c && c->in_use, "Circuit should attach");
+
+        uint16_t old = e[1]->label_in;
+        cyxchat_label_free(t, e[1], 1000);
+        TEST_ASSERT(cyxchat_label_lookup(t, old) == NULL, "Freed label should miss");
+        TEST_ASSERT(c && !c->in_use, "Free should release the circuit");
+        TEST_ASSERT(cyxchat_label_alloc(t, 1000) == NULL, "Freed slot should rest");
+
+        cyxchat_label_entry_t *again = cyxchat_label_alloc(
+            t, 1000 + CYXCHAT_LABEL_REUSE_MS + CYXCHAT_LABEL_REUSE_JITTER);
+        TEST_ASSERT(again == e[1], "Rested slot should be reused");
+        TEST_ASSERT(again && again->label_in != old, "Reused slot should get a new label");
+        TEST_ASSERT(again && (again->label_in & 3) == (old & 3), "Low bits should be the slot");
+        cyxchat_label_table_destroy(t);
+    }
+
+    /* Test setup message encoding */
+    {
+        cyxchat_label_request_t req, req2;
+        req.req_id = 0x01020304;
+        memset(req.eph_public, 0x5A, sizeof(req.eph_public));
+
+        uint8_t buf[128];
+        size_t len = cyxchat_label_encode_request(&req, buf, sizeof(buf));
+        TEST_ASSERT(len == CYXCHAT_LABEL_REQUEST_SIZE, "Request length");
+        TEST_ASSERT(buf[0] == CYXCHAT_MSG_LABEL_REQUEST && buf[1] == 0x04,
+                    "Request should be typed and little-endian");
+        TEST_ASSERT(cyxchat_label_decode_request(buf, len, &req2) == CYXCHAT_OK &&
+                    req2.req_id == req.req_id &&
+                    memcmp(req2.eph_public, req.eph_public, sizeof(req.eph_public)) == 0,
+                    "Request should round-trip");
+        TEST_ASSERT(cyxchat_label_decode_request(buf, len - 1, &req2) == CYXCHAT_ERR_INVALID,
+                    "Truncated request should fail");
+
+        cyxchat_label_mapping_t map, map2;
+        memset(&map, 0, sizeof(map));
+        map.req_id = 77;
+        map.label = 0xBEEF;
+        memset(map.auth, 0x3C, sizeof(map.auth));
+        len = cyxchat_label_encode_mapping(&map, buf, sizeof(buf));
+        TEST_ASSERT(len == CYXCHAT_LABEL_MAPPING_SIZE, "Mapping length");
+        TEST_ASSERT(cyxchat_label_decode_mapping(buf, len, &map2) == CYXCHAT_OK &&
+                    map2.req_id == 77 && map2.label == 0xBEEF &&
+                    memcmp(map2.auth, map.auth, sizeof(map.auth)) == 0,
+                    "Mapping should round-trip");
+
+        cyxchat_label_extend_t ext, ext2;
+        memset(&ext.next_hop, 0x22, sizeof(ext.next_hop));
+        ext.req_id = 9;
+        memset(ext.eph_public, 0x6B, sizeof(ext.eph_public));
+        len = cyxchat_label_encode_extend(&ext, buf, sizeof(buf));
+        TEST_ASSERT(len == CYXCHAT_LABEL_EXTEND_SIZE && buf[0] == CYXCHAT_LABEL_CMD_EXTEND,
+                    "Extend should lead with its command");
+        TEST_ASSERT(cyxchat_label_decode_extend(buf, len, &ext2) == CYXCHAT_OK &&
+                    ext2.req_id == 9 &&
+                    memcmp(&ext2.next_hop, &ext.next_hop, sizeof(ext.next_hop)) == 0,
+                    "Extend should round-trip");
+
+        len = cyxchat_label_encode_extended(&map, buf, sizeof(buf));
+        TEST_ASSERT(len == CYXCHAT_LABEL_EXTENDED_SIZE, "Extended length");
+        TEST_ASSERT(cyxchat_label_decode_extended(buf, len, &map2) == CYXCHAT_OK &&
+                    map2.req_id == 77 && map2.label == 0,
+                    "Extended should round-trip without the label");
+        TEST_ASSERT(cyxchat_label_decode_extend(buf, len, &ext2) == CYXCHAT_ERR_INVALID,
+                    "Extended should not decode as extend");
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    /* Test the handshake is bound to the hop's node ID */
+    {
+        test_hop_t hop, other;
+        make_hop(&hop, 0xB2);
+        make_hop(&other, 0xD4);
+
+        uint8_t pub[32], sec[32], key_in[32], key_out[32];
+        cyxchat_label_mapping_t map;
+        cyxchat_label_keypair(pub, sec);
+        TEST_ASSERT(cyxchat_label_accept(key_in, map.eph_public, map.auth, hop.secret, &hop.id,
+                                         pub, 5) == CYXCHAT_OK, "Accept should succeed");
+        TEST_ASSERT(cyxchat_label_complete(key_out, sec, &hop.id, map.eph_public, map.auth,
+                                           5) == CYXCHAT_OK &&
+                    memcmp(key_in, key_out, sizeof(key_in)) == 0,
+                    "Both sides should agree on the key");
+        TEST_ASSERT(cyxchat_label_complete(key_out, sec, &other.id, map.eph_public, map.auth,
+                                           5) == CYXCHAT_ERR_CRYPTO,
+                    "Answer from another node should fail");
+        TEST_ASSERT(cyxchat_label_complete(key_out, sec, &hop.id, map.eph_public, map.auth,
+                                           6) == CYXCHAT_ERR_CRYPTO,
+                    "Answer to another request should fail");
+
+        /* A node in between swapping in its own key half cannot confirm */
+        uint8_t mitm_pub[32], mitm_sec[32];
+        cyxchat_label_keypair(mitm_pub, mitm_sec);
+        TEST_ASSERT(cyxchat_label_complete(key_out, sec, &hop.id, mitm_pub, map.auth,
+                                           5) == CYXCHAT_ERR_CRYPTO,
+                    "Substituted key half should fail");
+    }
+#endif
+
+    /* Test ingress -> transit -> egress, one layer per hop */
+    {
+        cyxchat_label_table_t *ta = NULL, *tb = NULL, *tc = NULL;
+        cyxchat_label_table_create(&ta, 8);
+        cyxchat_label_table_create(&tb, 8);
+        cyxchat_label_table_create(&tc, 8);
+
+        test_hop_t a, b, c;
+        make_hop(&a, 0xA1);
+        make_hop(&b, 0xB2);
+        make_hop(&c, 0xC3);
+
+        cyxchat_label_entry_t *ing = cyxchat_label_alloc(ta, 0);
+        cyxchat_label_entry_t *tra = cyxchat_label_alloc(tb, 0);
+        cyxchat_label_entry_t *egr = cyxchat_label_alloc(tc, 0);
+        cyxchat_label_circuit_alloc(ta, ing);
+        ing->role = CYXCHAT_LABEL_INGRESS;
+        tra->role = CYXCHAT_LABEL_TRANSIT;
+        egr->role = CYXCHAT_LABEL_EGRESS;
+        ing->label_out = tra->label_in;
+        tra->label_out = egr->label_in;
+        TEST_ASSERT(add_hop(ing, tra, &b, &a.id, 1) && add_hop(ing, egr, &c, &b.id, 2),
+                    "Handshakes should succeed");
+
+        const uint8_t payload[] = "label switched";
+        uint8_t pkt[64], first[64];
+        size_t len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, payload, sizeof(payload),
+                                        pkt, sizeof(pkt));
+        TEST_ASSERT(len == sizeof(payload) + CYXCHAT_LABEL_OVERHEAD(2),
+                    "Overhead should be one layer per hop");
+        memcpy(first, pkt, len);
+
+        cyxchat_label_entry_t *got = NULL;
+        TEST_ASSERT(cyxchat_label_open(tb, &c.id, pkt, len, 10, &got) == CYXCHAT_ERR_NOT_FOUND,
+                    "Wrong neighbour should be refused");
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, pkt, len, 10, &got) == CYXCHAT_OK && got == tra,
+                    "Transit should accept");
+
+        uint8_t replay[64];
+        memcpy(replay, first, len);
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, replay, len, 10, &got) == CYXCHAT_ERR_CRYPTO,
+                    "Replay should be refused");
+
+        size_t len2 = cyxchat_label_swap(tra, pkt, len);
+        TEST_ASSERT(len2 == len - CYXCHAT_LABEL_LAYER_SIZE, "Swap should drop our layer");
+        TEST_ASSERT(pkt[1] == (uint8_t)(egr->label_in & 0xFF), "Swap should rewrite the label");
+#ifdef CYXWIZ_HAS_CRYPTO
+        TEST_ASSERT(memcmp(first + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE,
+                           pkt + CYXCHAT_LABEL_HEADER_SIZE,
+                           len2 - CYXCHAT_LABEL_HEADER_SIZE) != 0,
+                    "Packet should look different on each link");
+#endif
+
+        TEST_ASSERT(cyxchat_label_open(tc, &b.id, pkt, len2, 20, &got) == CYXCHAT_OK && got == egr,
+                    "Egress should accept the swapped packet");
+        const uint8_t *inner = pkt + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_SEQ_SIZE;
+        TEST_ASSERT(inner[0] == CYXCHAT_LABEL_CMD_DATA &&
+                    memcmp(inner + 1, payload, sizeof(payload)) == 0,
+                    "Egress should find the command and payload");
+        TEST_ASSERT(egr->last_used == 20, "Accept should mark the label used");
+
+#ifdef CYXWIZ_HAS_CRYPTO
+        len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, payload, sizeof(payload),
+                                 pkt, sizeof(pkt));
+        pkt[len - 1] ^= 1;
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, pkt, len, 30, &got) == CYXCHAT_ERR_CRYPTO,
+                    "Tampered packet should fail the MAC");
+        pkt[len - 1] ^= 1;
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, pkt, len, 30, &got) == CYXCHAT_OK,
+                    "Forgery should not consume the sequence number");
+#endif
+
+        /* Answers come back with a layer from every hop on the way */
+        uint8_t back[64], back2[64];
+        const uint8_t answer[] = { CYXCHAT_LABEL_CMD_EXTENDED, 1, 2, 3 };
+        size_t blen = cyxchat_label_seal_back(egr, answer, sizeof(answer), back, sizeof(back));
+        TEST_ASSERT(blen == sizeof(answer) + CYXCHAT_LABEL_HEADER_SIZE + CYXCHAT_LABEL_LAYER_SIZE &&
+                    back[0] == CYXCHAT_MSG_LABEL_BACK && back[1] == (uint8_t)(egr->label_in & 0xFF),
+                    "Back packet should carry the sender's label");
+        size_t blen2 = cyxchat_label_seal_back(tra, back + CYXCHAT_LABEL_HEADER_SIZE,
+                                               blen - CYXCHAT_LABEL_HEADER_SIZE,
+                                               back2, sizeof(back2));
+        TEST_ASSERT(blen2 == blen + CYXCHAT_LABEL_LAYER_SIZE, "Transit should add a layer");
+
+        const uint8_t *got_inner = NULL;
+        size_t got_len = 0;
+        TEST_ASSERT(cyxchat_label_open_back(ing, back2, blen2, &got_inner, &got_len) ==
+                    CYXCHAT_OK && got_len == sizeof(answer) &&
+                    memcmp(got_inner, answer, sizeof(answer)) == 0,
+                    "Ingress should peel every layer");
+#ifdef CYXWIZ_HAS_CRYPTO
+        blen2 = cyxchat_label_seal_back(tra, back + CYXCHAT_LABEL_HEADER_SIZE,
+                                        blen - CYXCHAT_LABEL_HEADER_SIZE, back2, sizeof(back2));
+        back2[blen2 - 1] ^= 1;
+        TEST_ASSERT(cyxchat_label_open_back(ing, back2, blen2, &got_inner, &got_len) ==
+                    CYXCHAT_ERR_CRYPTO, "Tampered answer should fail");
+#endif
+
+        /* Late packets on a torn-down label drop */
+        len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, payload, sizeof(payload),
+                                 pkt, sizeof(pkt));
+        tra->state = CYXCHAT_LABEL_EXPIRING;
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, pkt, len, 40, &got) == CYXCHAT_ERR_NOT_FOUND,
+                    "Expiring label should drop data");
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, pkt, 4, 40, &got) == CYXCHAT_ERR_INVALID,
+                    "Short packet should be invalid");
+
+        cyxchat_label_table_destroy(ta);
+        cyxchat_label_table_destroy(tb);
+        cyxchat_label_table_destroy(tc);
+    }
+
+    /* Test replay window across the 16-bit wrap */
+    {
+        cyxchat_label_table_t *ta = NULL, *tb = NULL;
+        cyxchat_label_table_create(&ta, 2);
+        cyxchat_label_table_create(&tb, 2);
+
+        test_hop_t a, b;
+        make_hop(&a, 0xA1);
+        make_hop(&b, 0xB2);
+
+        cyxchat_label_entry_t *ing = cyxchat_label_alloc(ta, 0);
+        cyxchat_label_entry_t *egr = cyxchat_label_alloc(tb, 0);
+        cyxchat_label_circuit_alloc(ta, ing);
+        ing->role = CYXCHAT_LABEL_INGRESS;
+        egr->role = CYXCHAT_LABEL_EGRESS;
+        ing->label_out = egr->label_in;
+        add_hop(ing, egr, &b, &a.id, 3);
+
+        uint8_t old_pkt[32], pkt[32];
+        cyxchat_label_entry_t *got = NULL;
+        ing->circuit->send_seq[0] = 0xFFF0;
+        size_t old_len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, NULL, 0,
+                                            old_pkt, sizeof(old_pkt));
+        int ok = 1;
+        for (int i = 0; i < 40; i++) {
+            size_t len = cyxchat_label_seal(ing, CYXCHAT_LABEL_CMD_DATA, NULL, 0,
+                                            pkt, sizeof(pkt));
+            ok &= cyxchat_label_open(tb, &a.id, pkt, len, 0, &got) == CYXCHAT_OK;
+        }
+        TEST_ASSERT(ok, "Sequence should carry across the wrap");
+        TEST_ASSERT(egr->recv_seq == 0x10018, "Receiver should track the full sequence");
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, old_pkt, old_len, 0, &got) == CYXCHAT_OK,
+                    "Late packet inside the window should be accepted once");
+        TEST_ASSERT(cyxchat_label_open(tb, &a.id, old_pkt, old_len, 0, &got) != CYXCHAT_OK,
+                    "Late packet should not be accepted twice");
+
+        cyxchat_label_table_destroy(ta);
+        cyxchat_label_table_destroy(tb);
+    }
+
+    return errors;
+}
@@ -0,0 +1,117 @@
+/**
+ * CyxChat Test - Link Statistics
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/linkstats.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+int test_linkstats(void) {
+    int errors = 0;
+    cyxchat_linkstats_t ls;
+
+    /* Test RTT smoothing and RTO bounds */
+    {
+        cyxchat_linkstats_init(&ls);
+        TEST_ASSERT(ls.rto_ms == CYXCHAT_LINK_RTO_INITIAL_MS, "Initial RTO");
+        TEST_ASSERT(cyxchat_linkstats_queue_delay(&ls) == 0, "No delay without samples");
+
+        cyxchat_linkstats_on_rtt(&ls, 100);
+        TEST_ASSERT(ls.srtt_ms == 100 && ls.rttvar_ms == 50, "First sample seeds SRTT");
+        TEST_ASSERT(ls.rto_ms == 300, "RTO = SRTT + 4 * RTTVAR");
+
+        cyxchat_linkstats_on_rtt(&ls, 180);
+        TEST_ASSERT(ls.srtt_ms == 110, "SRTT moves by 1/8");
+        TEST_ASSERT(ls.rttvar_ms == 57, "RTTVAR moves by 1/4");
+        TEST_ASSERT(ls.min_rtt_ms == 100 && ls.latest_rtt_ms == 180, "Min and latest kept");
+        TEST_ASSERT(cyxchat_linkstats_queue_delay(&ls) == 10, "Queue delay above min");
+
+        for (int i = 0; i < 50; i++) cyxchat_linkstats_on_rtt(&ls, 1);
+        TEST_ASSERT(ls.rto_ms == CYXCHAT_LINK_RTO_MIN_MS, "RTO floor");
+    }
+
+    /* Test sequence gaps and late arrivals */
+    {
+        cyxchat_linkstats_init(&ls);
+        cyxchat_linkstats_on_seq(&ls, 10);
+        cyxchat_linkstats_on_seq(&ls, 11);
+        TEST_ASSERT(ls.packets_lost == 0 && ls.loss_ppm == 0, "In order, no loss");
+
+        cyxchat_linkstats_on_seq(&ls, 14);
+        TEST_ASSERT(ls.packets_lost == 2 && ls.loss_ppm > 0, "Gap counted lost");
+
+        uint32_t loss = ls.loss_ppm;
+        cyxchat_linkstats_on_seq(&ls, 12);
+        TEST_ASSERT(ls.packets_lost == 1 && ls.loss_ppm < loss, "Late arrival takes loss back");
+
+        cyxchat_linkstats_on_seq(&ls, 12);
+        TEST_ASSERT(ls.packets_lost == 1, "Duplicate ignored");
+
+        /* Wraparound is not a gap */
+        cyxchat_linkstats_init(&ls);
+        cyxchat_linkstats_on_seq(&ls, 0xFFFFFFFFu);
+        cyxchat_linkstats_on_seq(&ls, 0);
+        TEST_ASSERT(ls.packets_lost == 0 && ls.seq_highest == 0, "Sequence wraps");
+
+        /* A peer's tag half the space behind is just stale */
+        cyxchat_linkstats_on_seq(&ls, 0x80000000u);
+        TEST_ASSERT(ls.packets_lost == 0 && ls.seq_highest == 0, "Far-behind tag ignored");
+    }
+
+    /* Test probe outcomes */
+    {
+        cyxchat_linkstats_init(&ls);
+        cyxchat_linkstats_on_probe(&ls, 0);
+        cyxchat_linkstats_on_probe(&ls, 0);
+        TEST_ASSERT(ls.probes_missed == 2 && ls.packets_lost == 2, "Misses counted");
+        TEST_ASSERT(ls.loss_ppm > 100000, "Loss rises on misses");
+
+        cyxchat_linkstats_on_probe(&ls, 1);
+        TEST_ASSERT(ls.probes_missed == 0, "Reply clears the run");
+    }
+
+    /* Test counters and rates */
+    {
+        cyxchat_linkstats_init(&ls);
+        cyxchat_linkstats_on_send(&ls, 500, 1000);
+        cyxchat_linkstats_on_send(&ls, 500, 1500);
+        cyxchat_linkstats_on_recv(&ls, 200, 1200);
+        TEST_ASSERT(ls.bytes_sent == 1000 && ls.packets_sent == 2, "Send totals");
+        TEST_ASSERT(ls.bytes_received == 200 && ls.packets_received == 1, "Receive totals");
+
+        cyxchat_linkstats_update(&ls, 2000);
+        TEST_ASSERT(ls.tx_rate == 1000, "Send rate from first window");
+
+        cyxchat_linkstats_on_send(&ls, 3000, 2500);
+        cyxchat_linkstats_update(&ls, 3000);
+        TEST_ASSERT(ls.tx_rate == 1250, "Send rate smoothed by 1/8");
+
+        /* Counters pass 32 bits */
+        ls.bytes_sent = 0xFFFFFFF0u;
+        cyxchat_linkstats_on_send(&ls, 100, 3100);
+        TEST_ASSERT(ls.bytes_sent == 0x100000054ull, "64-bit byte counter");
+    }
+
+    /* Test path reset keeps totals */
+    {
+        cyxchat_linkstats_init(&ls);
+        cyxchat_linkstats_on_send(&ls, 100, 10);
+        cyxchat_linkstats_on_rtt(&ls, 40);
+        cyxchat_linkstats_on_probe(&ls, 0);
+        cyxchat_linkstats_reset_path(&ls);
+        TEST_ASSERT(ls.srtt_ms == 0 && ls.rtt_samples == 0 && ls.loss_ppm == 0,
+                    "Path estimates cleared");
+        TEST_ASSERT(ls.rto_ms == CYXCHAT_LINK_RTO_INITIAL_MS, "RTO back to initial");
+        TEST_ASSERT(ls.bytes_sent == 100 && ls.packets_lost == 1, "Totals kept");
+    }
+
+    return errors;
+}
@@ -0,0 +1,816 @@
+/**
+ * CyxChat Test - Loopback Network
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/loopback.h>
+#include <cyxchat/relay.h>
+#include <cyxchat/connection.h>
+#include <cyxchat/label.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+typedef struct {
+    int count;
+    uint8_t order[64];
+    cyxwiz_node_id_t from;
+    int peers;
+} loop_rx_t;
+
+static void on_rx(cyxwiz_transport_t *t, const cyxwiz_node_id_t *from,
+                  const uint8_t *data, size_t len, void *user_data) {
+    (void)t;
+    (void)len;
+    loop_rx_t *rx = (loop_rx_t*)user_data;
+    if (rx->count < (int)sizeof(rx->order)) {
+        rx->order[rx->count] = data[0];
+    }
+    rx->count++;
+    memcpy(&rx->from, from, sizeof(rx->from));
+}
+
+static void on_peer(cyxwiz_transport_t *t, const cyxwiz_peer_info_t *info, void *user_data) {
+    (void)t;
+    (void)info;
+    ((loop_rx_t*)user_data)->peers++;
+}
+
+static cyxwiz_transport_t* make_node(cyxchat_loopnet_t *net, uint8_t id_byte, loop_rx_t *rx) {
+    cyxwiz_transport_t *t = NULL;
+    cyxwiz_node_id_t id;
+    memset(&id, id_byte, sizeof(id));
+    if (cyxchat_loopnet_transport_create(net, &t) != CYXCHAT_OK) return NULL;
+    cyxwiz_transport_set_local_id(t, &id);
+    cyxwiz_transport_set_recv_callback(t, on_rx, rx);
+    cyxwiz_transport_set_peer_callback(t, on_peer, rx);
+    return t;
+}
+
+static int g_conn_data;
+static uint8_t g_conn_first;
+
+static void on_conn_data(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                         const uint8_t *data, size_t len, void *user_data) {
+    (void)ctx;
+    (void)from;
+    (void)len;
+    (void)user_data;
+    g_conn_data++;
+    g_conn_first = data[0];
+}
+
+static int g_connect_calls;
+static cyxchat_conn_state_t g_connect_state;
+static cyxchat_error_t g_connect_result;
+
+static void on_connect(cyxchat_conn_ctx_t *ctx, const cyxwiz_node_id_t *peer_id,
+                       cyxchat_conn_state_t state, cyxchat_error_t result, void *user_data) {
+    (void)ctx;
+    (void)peer_id;
+    (void)user_data;
+    g_connect_calls++;
+    g_connect_state = state;
+    g_connect_result = result;
+}
+
+/* Step both connections and the network clock together */
+static void conn_run(cyxchat_loopnet_t *net, cyxchat_conn_ctx_t *a, cyxchat_conn_ctx_t *b,
+                     uint64_t *now, uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += 5) {
+        *now += 5;
+        cyxchat_loopnet_set_time(net, *now);
+        cyxchat_conn_poll(a, *now);
+        cyxchat_conn_poll(b, *now);
+    }
+}
+
+static int g_label_result;
+static int g_label_data;
+static size_t g_label_len;
+static uint8_t g_label_first;
+
+static void on_label_path(uint16_t handle, cyxchat_error_t result, void *user_data) {
+    (void)handle;
+    (void)user_data;
+    g_label_result = result;
+}
+
+static void on_label_data(cyxchat_conn_ctx_t *ctx, uint16_t label, const cyxwiz_node_id_t *prev_hop,
+                          const uint8_t *data, size_t len, void *user_data) {
+    (void)ctx;
+    (void)label;
+    (void)prev_hop;
+    (void)user_data;
+    g_label_data++;
+    g_label_len = len;
+    g_label_first = len > 0 ? data[0] : 0;
+}
+
+/* Step a chain of connections and the network clock together */
+static void chain_run(cyxchat_loopnet_t *net, cyxchat_conn_ctx_t **nodes, int count,
+                      uint64_t *now, uint32_t ms) {
+    for (uint32_t t = 0; t < ms; t += 5) {
+        *now += 5;
+        cyxchat_loopnet_set_time(net, *now);
+        for (int i = 0; i < count; i++) {
+            cyxchat_conn_poll(nodes[i], *now);
+        }
+    }
+}
+
+static void send_byte(cyxwiz_transport_t *t, uint8_t to_byte, uint8_t value) {
+    cyxwiz_node_id_t to;
+    uint8_t msg[100];
+    memset(&to, to_byte, sizeof(to));
+    memset(msg, value, sizeof(msg));
+    t->ops->send(t, &to, msg, sizeof(msg));
+}
+
+/* Send 64 packets over a lossy, jittery link; return the arrival order hash */
+static uint32_t lossy_run(uint64_t seed, int *received) {
+    cyxchat_loopnet_t *net = NULL;
+    loop_rx_t ra, rb;
+    memset(&ra, 0, sizeof(ra));
+    memset(&rb, 0, sizeof(rb));
+    cyxchat_loopnet_create(&net, seed);
+    cyxchat_loopnet_set_time(net, 1);
+
+    cyxchat_loop_link_t link;
+    memset(&link, 0, sizeof(link));
+    link.latency_ms = 20;
+    link.jitter_ms = 10;
+    link.loss_ppm = 100000;
+    link.reorder_ppm = 50000;
+    cyxchat_loopnet_set_default_link(net, &link);
+
+    cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+    cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+    for (int i = 0; i < 64; i++) {
+        send_byte(a, 0xB2, (uint8_t)i);
+    }
+    cyxchat_loopnet_set_time(net, 1000);
+    b->ops->poll(b, 0);
+
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < rb.count; i++) {
+        h = (h ^ rb.order[i]) * 16777619u;
+    }
+    *received = rb.count;
+
+    cyxchat_loopnet_transport_destroy(a);
+    cyxchat_loopnet_transport_destroy(b);
+    cyxchat_loopnet_destroy(net);
+    return h;
+}
+
+/* Both sides register, then each sends three times; count what gets through */
+static void punch_pair(cyxchat_loop_nat_type_t nat_a, cyxchat_loop_nat_type_t nat_b,
+                       int *got_a, int *got_b) {
+    cyxchat_loopnet_t *net = NULL;
+    loop_rx_t ra, rb;
+    memset(&ra, 0, sizeof(ra));
+    memset(&rb, 0, sizeof(rb));
+    cyxchat_loopnet_create(&net, 1);
+    cyxchat_loopnet_set_time(net, 1);
+
+    cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+    cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+    cyxchat_loop_nat_t nat;
+    memset(&nat, 0, sizeof(nat));
+    nat.type = nat_a;
+    cyxchat_loopnet_set_nat(a, &nat);
+    nat.type = nat_b;
+    cyxchat_loopnet_set_nat(b, &nat);
+    a->ops->discover(a);
+    b->ops->discover(b);
+
+    for (int i = 0; i < 3; i++) {
+        send_byte(a, 0xB2, 1);
+        send_byte(b, 0xA1, 2);
+        b->ops->poll(b, 0);
+        a->ops->poll(a, 0);
+    }
+    *got_a = ra.count;
+    *got_b = rb.count;
+
+    cyxchat_loopnet_transport_destroy(a);
+    cyxchat_loopnet_transport_destroy(b);
+    cyxchat_loopnet_destroy(net);
+}
+
+int test_loopback(void) {
+    int errors = 0;
+    cyxchat_loopnet_t *net = NULL;
+    loop_rx_t ra, rb;
+    cyxchat_loop_link_t link;
+
+    /* Test delivery after the link latency */
+    {
+        memset(&ra, 0, sizeof(ra));
+        memset(&rb, 0, sizeof(rb));
+        TEST_ASSERT(cyxchat_loopnet_create(&net, 1) == CYXCHAT_OK, "Create network");
+        cyxchat_loopnet_set_time(net, 1000);
+
+        cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+        cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+        TEST_ASSERT(a && b, "Create transports");
+        TEST_ASSERT(cyxchat_loopnet_is_loopback(a), "Loopback transport recognised");
+
+        a->ops->discover(a);
+        b->ops->discover(b);
+        TEST_ASSERT(ra.peers == 2 && rb.peers == 1, "Discovery reported both ways");
+
+        cyxwiz_node_id_t ida, idb;
+        memset(&ida, 0xA1, sizeof(ida));
+        memset(&idb, 0xB2, sizeof(idb));
+        memset(&link, 0, sizeof(link));
+        link.latency_ms = 50;
+        TEST_ASSERT(cyxchat_loopnet_set_link(net, &ida, &idb, &link) == CYXCHAT_OK, "Set link");
+
+        send_byte(a, 0xB2, 7);
+        send_byte(b, 0xA1, 8);
+        TEST_ASSERT(cyxchat_loopnet_next_delivery(net) == 1000, "Reverse link is perfect");
+        a->ops->poll(a, 0);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(ra.count == 1 && rb.count == 0, "Only the undelayed packet arrived");
+        TEST_ASSERT(cyxchat_loopnet_next_delivery(net) == 1050, "Next delivery at latency");
+
+        cyxchat_loopnet_set_time(net, 1049);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 0, "Not before latency");
+        cyxchat_loopnet_set_time(net, 1050);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 1 && rb.order[0] == 7, "Delivered at latency");
+        TEST_ASSERT(memcmp(&rb.from, &ida, sizeof(ida)) == 0, "Sender ID carried");
+        TEST_ASSERT(cyxchat_loopnet_next_delivery(net) == UINT64_MAX, "Nothing in flight");
+
+        /* Unknown destination and oversize datagrams */
+        uint8_t big[CYXCHAT_LOOP_MTU + 1];
+        memset(big, 0, sizeof(big));
+        send_byte(a, 0xC3, 1);
+        TEST_ASSERT(a->ops->send(a, &idb, big, sizeof(big)) != CYXWIZ_OK, "Oversize refused");
+        TEST_ASSERT(a->ops->max_packet_size(a) == CYXCHAT_LOOP_MTU, "MTU reported");
+
+        cyxchat_loop_stats_t stats;
+        cyxchat_loopnet_get_stats(net, &stats);
+        TEST_ASSERT(stats.delivered == 2 && stats.unroutable == 1, "Stats counted");
+
+        cyxchat_loopnet_transport_destroy(a);
+        cyxchat_loopnet_transport_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test a vectored send is one call for the whole batch */
+    {
+        memset(&ra, 0, sizeof(ra));
+        memset(&rb, 0, sizeof(rb));
+        cyxchat_loopnet_create(&net, 1);
+        cyxchat_loopnet_set_time(net, 1000);
+        cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+        cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+        a->ops->discover(a);
+        b->ops->discover(b);
+
+        cyxwiz_node_id_t idb;
+        memset(&idb, 0xB2, sizeof(idb));
+        uint8_t msgs[4][8], big[CYXCHAT_LOOP_MTU + 1];
+        cyxchat_datagram_t dgrams[5];
+        for (int i = 0; i < 4; i++) {
+            memset(msgs[i], i + 1, sizeof(msgs[i]));
+            dgrams[i].to = &idb;
+            dgrams[i].data = msgs[i];
+            dgrams[i].len = sizeof(msgs[i]);
+        }
+        dgrams[2].data = big;
+        dgrams[2].len = sizeof(big);
+
+        cyxchat_loop_stats_t before, after;
+        cyxchat_loopnet_get_stats(net, &before);
+        TEST_ASSERT(cyxchat_loopnet_send_batch(a, dgrams, 4) == 2,
+                    "Oversize datagram stops the batch");
+        dgrams[2].data = msgs[2];
+        dgrams[2].len = sizeof(msgs[2]);
+        TEST_ASSERT(cyxchat_loopnet_send_batch(a, dgrams + 2, 2) == 2, "Rest of the batch sent");
+        cyxchat_loopnet_get_stats(net, &after);
+        TEST_ASSERT(after.send_calls - before.send_calls == 2, "One call per batch");
+
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 4 && rb.order[0] == 1 && rb.order[3] == 4,
+                    "Batch delivered in order");
+
+        cyxchat_loopnet_transport_destroy(a);
+        cyxchat_loopnet_transport_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test bandwidth serialisation and drop-tail buffer */
+    {
+        memset(&ra, 0, sizeof(ra));
+        memset(&rb, 0, sizeof(rb));
+        cyxchat_loopnet_create(&net, 1);
+        cyxchat_loopnet_set_time(net, 1000);
+
+        memset(&link, 0, sizeof(link));
+        link.bandwidth_bps = 80000;         /* 100-byte packet = 10 ms */
+        link.queue_bytes = 300;
+        cyxchat_loopnet_set_default_link(net, &link);
+
+        cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+        cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+        for (int i = 0; i < 5; i++) {
+            send_byte(a, 0xB2, (uint8_t)i);
+        }
+
+        cyxchat_loop_stats_t stats;
+        cyxchat_loopnet_get_stats(net, &stats);
+        TEST_ASSERT(stats.queue_drops == 2, "Buffer overflow dropped");
+
+        cyxchat_loopnet_set_time(net, 1020);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 2, "Two serialised in 20 ms");
+        cyxchat_loopnet_set_time(net, 1030);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 3 && rb.order[2] == 2, "Third after 30 ms, in order");
+
+        cyxchat_loopnet_transport_destroy(a);
+        cyxchat_loopnet_transport_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test jitter keeps order unless reordering is asked for */
+    {
+        memset(&ra, 0, sizeof(ra));
+        memset(&rb, 0, sizeof(rb));
+        cyxchat_loopnet_create(&net, 42);
+        cyxchat_loopnet_set_time(net, 1000);
+
+        memset(&link, 0, sizeof(link));
+        link.latency_ms = 10;
+        link.jitter_ms = 30;
+        cyxchat_loopnet_set_default_link(net, &link);
+
+        cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+        cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+        for (int i = 0; i < 32; i++) {
+            send_byte(a, 0xB2, (uint8_t)i);
+        }
+        cyxchat_loopnet_set_time(net, 2000);
+        b->ops->poll(b, 0);
+
+        int in_order = rb.count == 32;
+        for (int i = 1; i < rb.count; i++) {
+            if (rb.order[i] < rb.order[i - 1]) in_order = 0;
+        }
+        TEST_ASSERT(in_order, "Jitter preserves order");
+
+        cyxchat_loopnet_transport_destroy(a);
+        cyxchat_loopnet_transport_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test the same seed reproduces the same run */
+    {
+        int n1 = 0, n2 = 0, n3 = 0;
+        uint32_t h1 = lossy_run(7, &n1);
+        uint32_t h2 = lossy_run(7, &n2);
+        uint32_t h3 = lossy_run(8, &n3);
+        TEST_ASSERT(h1 == h2 && n1 == n2, "Same seed, same run");
+        TEST_ASSERT(n1 > 40 && n1 < 64, "Loss applied");
+        TEST_ASSERT(h1 != h3 || n1 != n3, "Different seed, different run");
+    }
+
+    /* Test NAT mapping and filtering across a simultaneous open */
+    {
+        int got_a, got_b;
+        punch_pair(CYXCHAT_LOOP_NAT_PORT_RESTRICTED, CYXCHAT_LOOP_NAT_PORT_RESTRICTED,
+                   &got_a, &got_b);
+        TEST_ASSERT(got_a == 3 && got_b == 3, "Cone pair punches through");
+
+        punch_pair(CYXCHAT_LOOP_NAT_SYMMETRIC, CYXCHAT_LOOP_NAT_FULL_CONE, &got_a, &got_b);
+        TEST_ASSERT(got_a == 2 && got_b == 3, "Symmetric behind full cone works after one reply");
+
+        punch_pair(CYXCHAT_LOOP_NAT_SYMMETRIC, CYXCHAT_LOOP_NAT_RESTRICTED, &got_a, &got_b);
+        TEST_ASSERT(got_a > 0 && got_b > 0, "Symmetric against address-restricted works");
+
+        punch_pair(CYXCHAT_LOOP_NAT_SYMMETRIC, CYXCHAT_LOOP_NAT_PORT_RESTRICTED,
+                   &got_a, &got_b);
+        TEST_ASSERT(got_a == 0 && got_b == 0, "Symmetric against port-restricted fails");
+
+        punch_pair(CYXCHAT_LOOP_NAT_SYMMETRIC, CYXCHAT_LOOP_NAT_SYMMETRIC, &got_a, &got_b);
+        TEST_ASSERT(got_a == 0 && got_b == 0, "Symmetric pair fails");
+    }
+
+    /* Test idle bindings expire, and a relay bridges what punching cannot */
+    {
+        memset(&ra, 0, sizeof(ra));
+        memset(&rb, 0, sizeof(rb));
+        cyxchat_loopnet_create(&net, 1);
+        cyxchat_loopnet_set_time(net, 1000);
+        TEST_ASSERT(cyxchat_loopnet_add_relay(net, "198.51.100.7:7000") == CYXCHAT_OK, "Add relay");
+        TEST_ASSERT(cyxchat_loopnet_add_relay(net, "198.51.100.7:7001") == CYXCHAT_ERR_EXISTS,
+                    "Relay address taken");
+        TEST_ASSERT(cyxchat_loopnet_add_relay(net, "relay:7000") == CYXCHAT_ERR_INVALID,
+                    "Relay address parsed");
+
+        cyxwiz_transport_t *a = make_node(net, 0xA1, &ra);
+        cyxwiz_transport_t *b = make_node(net, 0xB2, &rb);
+        cyxchat_loop_nat_t nat;
+        memset(&nat, 0, sizeof(nat));
+        nat.type = CYXCHAT_LOOP_NAT_PORT_RESTRICTED;
+        nat.binding_timeout_ms = 5000;
+        cyxchat_loopnet_set_nat(a, &nat);
+        nat.type = CYXCHAT_LOOP_NAT_SYMMETRIC;
+        cyxchat_loopnet_set_nat(b, &nat);
+        a->ops->discover(a);
+        b->ops->discover(b);
+
+        uint32_t ip;
+        uint16_t port;
+        TEST_ASSERT(cyxchat_loopnet_get_mapped(a, &ip, &port) == CYXCHAT_OK, "Mapped after discover");
+        TEST_ASSERT(cyxchat_loopnet_punch(b, ip, port) == CYXCHAT_OK, "Punch sent");
+        a->ops->poll(a, 0);
+
+        /* Relay pseudo-ID as relay.c builds it */
+        cyxwiz_node_id_t relay_id, ida, idb;
+        const uint8_t relay_addr[7] = { 198, 51, 100, 7, 0x1B, 0x58, 0xFF };
+        memset(&relay_id, 0, sizeof(relay_id));
+        memcpy(relay_id.bytes, relay_addr, sizeof(relay_addr));
+        memset(&ida, 0xA1, sizeof(ida));
+        memset(&idb, 0xB2, sizeof(idb));
+
+        uint8_t msg[1 + 32 + 32 + 2 + 1];
+        memset(msg, 0, sizeof(msg));
+        msg[0] = CYXCHAT_RELAY_CONNECT;
+        memcpy(msg + 1, &idb, 32);
+        memcpy(msg + 33, &ida, 32);
+        b->ops->send(b, &relay_id, msg, 65);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 1 && rb.order[0] == CYXCHAT_RELAY_CONNECT_ACK, "Relay acknowledges");
+
+        msg[0] = CYXCHAT_RELAY_DATA;
+        memcpy(msg + 1, &ida, 32);
+        memcpy(msg + 33, &idb, 32);
+        msg[66] = 1;
+        a->ops->send(a, &relay_id, msg, sizeof(msg));
+        a->ops->poll(a, 0);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 2 && rb.order[1] == CYXCHAT_RELAY_DATA, "Relay forwards data");
+        TEST_ASSERT(memcmp(&rb.from, &relay_id, sizeof(relay_id)) == 0, "Forwarded from the relay");
+
+        /* Direct path: symmetric B's fresh mapping is filtered by A */
+        send_byte(b, 0xA1, 9);
+        a->ops->poll(a, 0);
+        cyxchat_loop_stats_t stats;
+        cyxchat_loopnet_get_stats(net, &stats);
+        TEST_ASSERT(ra.count == 0 && stats.nat_drops >= 1, "Direct packet filtered");
+
+        /* Relay binding in B's NAT lapses after the timeout */
+        cyxchat_loopnet_set_time(net, 7000);
+        a->ops->send(a, &relay_id, msg, sizeof(msg));
+        a->ops->poll(a, 0);
+        b->ops->poll(b, 0);
+        TEST_ASSERT(rb.count == 2, "Expired binding filters relay traffic");
+        TEST_ASSERT(stats.relayed == 1, "One forward counted");
+
+        cyxchat_loopnet_transport_destroy(a);
+        cyxchat_loopnet_transport_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test multipath: sent on relay and direct mid-punch, delivered once */
+    {
+        const char *relay_addr = "198.51.100.7:3479";
+        cyxchat_conn_ctx_t *a = NULL, *b = NULL;
+        cyxwiz_node_id_t ida, idb;
+        memset(&ida, 0xA1, sizeof(ida));
+        memset(&idb, 0xB2, sizeof(idb));
+
+        /*
+         * Nothing B sends reaches A directly, so A's punch stays open, and
+         * A's punch is slow enough that both sides take the relay first
+         */
+        cyxchat_loopnet_create(&net, 1);
+        cyxchat_loopnet_add_relay(net, relay_addr);
+        memset(&link, 0, sizeof(link));
+        link.loss_ppm = 1000000;
+        cyxchat_loopnet_set_link(net, &idb, &ida, &link);
+        memset(&link, 0, sizeof(link));
+        link.latency_ms = 20;
+        cyxchat_loopnet_set_link(net, &ida, &idb, &link);
+        TEST_ASSERT(cyxchat_conn_create_loopback(&a, net, &ida) == CYXCHAT_OK &&
+                    cyxchat_conn_create_loopback(&b, net, &idb) == CYXCHAT_OK,
+                    "Connections on the network");
+
+        if (a && b) {
+            cyxchat_conn_set_poll_timeout(a, 0);
+            cyxchat_conn_set_poll_timeout(b, 0);
+            cyxchat_conn_add_relay(a, relay_addr);
+            cyxchat_conn_add_relay(b, relay_addr);
+            cyxchat_conn_set_relay_stagger(a, 0);
+            cyxchat_conn_set_relay_stagger(b, 0);
+            cyxchat_conn_set_multipath(a, 1);
+            cyxchat_conn_set_on_data(b, on_conn_data, NULL);
+
+            uint64_t now = cyxchat_loopnet_now_ms(net) + 1;
+            cyxchat_loopnet_set_time(net, now);
+            cyxchat_conn_connect(b, &ida, NULL, NULL);
+            cyxchat_conn_connect(a, &idb, NULL, NULL);
+            conn_run(net, a, b, &now, 10);
+
+            cyxchat_network_status_t status;
+            cyxchat_conn_get_status(a, &status);
+            TEST_ASSERT(cyxchat_conn_get_state(a, &idb) == CYXCHAT_CONN_RELAYING &&
+                        status.repunching == 1, "A should be relayed and still punching");
+            TEST_ASSERT(cyxchat_conn_get_state(b, &ida) == CYXCHAT_CONN_RELAYING,
+                        "B should be on the relay too");
+
+            g_conn_data = 0;
+            uint8_t payload[32];
+            memset(payload, 0x20, sizeof(payload));
+            TEST_ASSERT(cyxchat_conn_send(a, &idb, payload, sizeof(payload)) == CYXCHAT_OK,
+                        "Multipath send");
+            conn_run(net, a, b, &now, 100);
+
+            cyxchat_conn_io_stats_t io_a, io_b;
+            cyxchat_conn_get_io_stats(a, &io_a);
+            cyxchat_conn_get_io_stats(b, &io_b);
+            TEST_ASSERT(io_a.multipath_sent == 1, "Sent on both paths");
+            TEST_ASSERT(io_b.multipath_dup == 1, "Second copy dropped");
+            TEST_ASSERT(g_conn_data == 1 && g_conn_first == 0x20,
+                        "Exactly one unwrapped copy delivered");
+            TEST_ASSERT(cyxchat_conn_get_state(b, &ida) == CYXCHAT_CONN_CONNECTED,
+                        "B should have A's direct punch");
+        }
+
+        if (a) cyxchat_conn_destroy(a);
+        if (b) cyxchat_conn_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test a relay that never answers is not reported as the winner */
+    {
+        const char *relay_addr = "198.51.100.7:3479";
+        cyxchat_conn_ctx_t *a = NULL, *b = NULL;
+        cyxwiz_node_id_t ida, idb, relay_id;
+        memset(&ida, 0xA1, sizeof(ida));
+        memset(&idb, 0xB2, sizeof(idb));
+        memset(&relay_id, 0, sizeof(relay_id));
+        const uint8_t relay_ep[7] = { 198, 51, 100, 7, 0x0D, 0x97, 0xFF };
+        memcpy(relay_id.bytes, relay_ep, sizeof(relay_ep));
+
+        /* Neither the punch nor the relay request gets anywhere */
+        cyxchat_loopnet_create(&net, 1);
+        cyxchat_loopnet_add_relay(net, relay_addr);
+        memset(&link, 0, sizeof(link));
+        link.loss_ppm = 1000000;
+        cyxchat_loopnet_set_link(net, &ida, &idb, &link);
+        cyxchat_loopnet_set_link(net, &idb, &ida, &link);
+        cyxchat_loopnet_set_link(net, &ida, &relay_id, &link);
+        TEST_ASSERT(cyxchat_conn_create_loopback(&a, net, &ida) == CYXCHAT_OK &&
+                    cyxchat_conn_create_loopback(&b, net, &idb) == CYXCHAT_OK,
+                    "Connections on the network");
+
+        if (a && b) {
+            cyxchat_conn_set_poll_timeout(a, 0);
+            cyxchat_conn_set_poll_timeout(b, 0);
+            cyxchat_conn_add_relay(a, relay_addr);
+
+            uint64_t now = cyxchat_loopnet_now_ms(net) + 1;
+            cyxchat_loopnet_set_time(net, now);
+            g_connect_calls = 0;
+            cyxchat_conn_connect(a, &idb, on_connect, NULL);
+            conn_run(net, a, b, &now, CYXCHAT_RELAY_STAGGER_MS + 100);
+            TEST_ASSERT(cyxchat_conn_get_state(a, &idb) == CYXCHAT_CONN_CONNECTING &&
+                        g_connect_calls == 0, "Unanswered relay request is no path");
+
+            conn_run(net, a, b, &now, CYXCHAT_HOLE_PUNCH_TIMEOUT_MS);
+            TEST_ASSERT(g_connect_calls == 1 && g_connect_state == CYXCHAT_CONN_DISCONNECTED &&
+                        g_connect_result == CYXCHAT_ERR_TIMEOUT, "Connect should time out");
+            TEST_ASSERT(!cyxchat_conn_is_relayed(a, &idb), "Relay request withdrawn");
+        }
+
+        if (a) cyxchat_conn_destroy(a);
+        if (b) cyxchat_conn_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test batched sends: queued until the poll, then one call */
+    {
+        cyxchat_conn_ctx_t *a = NULL, *b = NULL;
+        cyxwiz_node_id_t ida, idb;
+        memset(&ida, 0xA1, sizeof(ida));
+        memset(&idb, 0xB2, sizeof(idb));
+
+        cyxchat_loopnet_create(&net, 1);
+        TEST_ASSERT(cyxchat_conn_create_loopback(&a, net, &ida) == CYXCHAT_OK &&
+                    cyxchat_conn_create_loopback(&b, net, &idb) == CYXCHAT_OK,
+                    "Connections on the network");
+
+        if (a && b) {
+            cyxchat_conn_set_poll_timeout(a, 0);
+            cyxchat_conn_set_poll_timeout(b, 0);
+            cyxchat_conn_set_on_data(b, on_conn_data, NULL);
+
+            uint64_t now = cyxchat_loopnet_now_ms(net) + 1;
+            cyxchat_loopnet_set_time(net, now);
+            cyxchat_conn_connect(a, &idb, NULL, NULL);
+            cyxchat_conn_connect(b, &ida, NULL, NULL);
+            conn_run(net, a, b, &now, 100);
+            TEST_ASSERT(cyxchat_conn_get_state(a, &idb) == CYXCHAT_CONN_CONNECTED,
+                        "A should be connected");
+
+            TEST_ASSERT(cyxchat_conn_set_batch_io(a, 1) == CYXCHAT_OK, "Batching on loopback");
+
+            cyxchat_loop_stats_t before, queued, flushed;
+            uint8_t payload[32];
+            memset(payload, 0x31, sizeof(payload));
+            g_conn_data = 0;
+            cyxchat_loopnet_get_stats(net, &before);
+            for (int i = 0; i < 5; i++) {
+                TEST_ASSERT(cyxchat_conn_send(a, &idb, payload, sizeof(payload)) == CYXCHAT_OK,
+                            "Queued send");
+            }
+            cyxchat_loopnet_get_stats(net, &queued);
+            TEST_ASSERT(queued.send_calls == before.send_calls, "Sends wait for the poll");
+
+            cyxchat_conn_poll(a, now);
+            cyxchat_loopnet_get_stats(net, &flushed);
+            TEST_ASSERT(flushed.send_calls - before.send_calls == 1, "Queue goes out in one call");
+
+            cyxchat_conn_io_stats_t io;
+            cyxchat_conn_get_io_stats(a, &io);
+            TEST_ASSERT(io.tx_batches == 1 && io.tx_packets == 5 && io.tx_errors == 0,
+                        "One batch of five");
+
+            conn_run(net, a, b, &now, 20);
+            TEST_ASSERT(g_conn_data == 5 && g_conn_first == 0x31, "Every queued send delivered");
+            TEST_ASSERT(cyxchat_conn_set_batch_io(a, 0) == CYXCHAT_OK, "Batching off");
+        }
+
+        if (a) cyxchat_conn_destroy(a);
+        if (b) cyxchat_conn_destroy(b);
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test the peer tables: growth, deletes, recycling and the limit */
+    {
+        cyxchat_conn_ctx_t *c = NULL;
+        cyxwiz_node_id_t self, ids[100];
+        memset(&self, 0xEE, sizeof(self));
+        for (int i = 0; i < 100; i++) {
+            memset(&ids[i], 0, sizeof(ids[i]));
+            ids[i].bytes[0] = (uint8_t)i;
+            ids[i].bytes[31] = (uint8_t)(i * 7);
+        }
+
+        cyxchat_loopnet_create(&net, 1);
+        TEST_ASSERT(cyxchat_conn_create_loopback(&c, net, &self) == CYXCHAT_OK, "Connection");
+
+        if (c) {
+            /* Well past the initial 32 entries: the index must grow */
+            int ok = 1;
+            for (int i = 0; i < 100; i++) {
+                ok &= cyxchat_conn_connect(c, &ids[i], NULL, NULL) == CYXCHAT_OK;
+            }
+            TEST_ASSERT(ok && cyxchat_conn_peer_count(c) == 100, "Tables should grow");
+            ok = 1;
+            for (int i = 0; i < 100; i++) {
+                ok &= cyxchat_conn_get_state(c, &ids[i]) == CYXCHAT_CONN_CONNECTING;
+                ok &= cyxchat_conn_connect(c, &ids[i], NULL, NULL) == CYXCHAT_ERR_EXISTS;
+            }
+            TEST_ASSERT(ok, "Every peer and pending connect should be found after growth");
+
+            /* Deletes shift later entries back; each must still be found */
+            for (int i = 0; i < 100; i += 3) {
+                cyxchat_conn_disconnect(c, &ids[i]);
+            }
+            ok = 1;
+            for (int i = 0; i < 100; i++) {
+                cyxchat_error_t want = i % 3 == 0 ? CYXCHAT_OK : CYXCHAT_ERR_EXISTS;
+                ok &= cyxchat_conn_connect(c, &ids[i], NULL, NULL) == want;
+            }
+            TEST_ASSERT(ok, "Deleted connects should go, displaced ones should stay");
+            cyxchat_conn_destroy(c);
+            c = NULL;
+        }
+
+        TEST_ASSERT(cyxchat_conn_create_loopback(&c, net, &self) == CYXCHAT_OK, "Connection");
+        if (c) {
+            int ok = 1;
+            TEST_ASSERT(cyxchat_conn_set_max_peers(c, 40) == CYXCHAT_OK, "Limit");
+            for (int i = 0; i < 40; i++) {
+                ok &= cyxchat_conn_connect(c, &ids[i], NULL, NULL) == CYXCHAT_OK;
+            }
+            TEST_ASSERT(ok, "Connects up to the limit");
+            TEST_ASSERT(cyxchat_conn_connect(c, &ids[40], NULL, NULL) == CYXCHAT_ERR_FULL,
+                        "Nothing idle to recycle at the limit");
+            TEST_ASSERT(cyxchat_conn_set_max_peers(c, 39) == CYXCHAT_ERR_INVALID,
+                        "Limit below the peers in use");
+
+            /* Disconnected peers make room for new ones */
+            for (int i = 0; i < 40; i += 2) {
+                cyxchat_conn_disconnect(c, &ids[i]);
+            }
+            ok = 1;
+            for (int i = 40; i < 60; i++) {
+                ok &= cyxchat_conn_connect(c, &ids[i], NULL, NULL) == CYXCHAT_OK;
+            }
+            TEST_ASSERT(ok && cyxchat_conn_peer_count(c) == 40, "Idle peers should be recycled");
+            ok = 1;
+            for (int i = 0; i < 60; i++) {
+                cyxchat_conn_state_t want = i < 40 && i % 2 == 0 ?
+                    CYXCHAT_CONN_DISCONNECTED : CYXCHAT_CONN_CONNECTING;
+                ok &= cyxchat_conn_get_state(c, &ids[i]) == want;
+            }
+            TEST_ASSERT(ok, "Survivors and newcomers should all be found");
+            TEST_ASSERT(cyxchat_conn_connect(c, &ids[60], NULL, NULL) == CYXCHAT_ERR_FULL,
+                        "Full again once the idle peers are used up");
+            cyxchat_conn_destroy(c);
+        }
+        cyxchat_loopnet_destroy(net);
+    }
+
+    /* Test a label path built hop by hop: A -> B -> C */
+    {
+        cyxchat_conn_ctx_t *n[3] = { NULL, NULL, NULL };
+        cyxwiz_node_id_t ids[3];
+        uint8_t keys[3][64];
+
+        cyxchat_loopnet_create(&net, 1);
+        for (int i = 0; i < 3; i++) {
+            memset(&ids[i], 0xA1 + 0x11 * i, sizeof(ids[i]));
+            memset(keys[i], 0x30 + i, sizeof(keys[i]));
+#ifdef CYXWIZ_HAS_CRYPTO
+            crypto_sign_keypair(ids[i].bytes, keys[i]);
+#endif
+            TEST_ASSERT(cyxchat_conn_create_loopback(&n[i], net, &ids[i]) == CYXCHAT_OK,
+                        "Connection on the network");
+        }
+
+        if (n[0] && n[1] && n[2]) {
+            for (int i = 0; i < 3; i++) {
+                cyxchat_conn_set_poll_timeout(n[i], 0);
+            }
+            cyxchat_conn_set_signing_key(n[1], keys[1]);
+            cyxchat_conn_set_on_label_data(n[2], on_label_data, NULL);
+
+            uint64_t now = cyxchat_loopnet_now_ms(net) + 1;
+            cyxchat_loopnet_set_time(net, now);
+            cyxchat_conn_connect(n[0], &ids[1], NULL, NULL);
+            cyxchat_conn_connect(n[1], &ids[0], NULL, NULL);
+            cyxchat_conn_connect(n[1], &ids[2], NULL, NULL);
+            cyxchat_conn_connect(n[2], &ids[1], NULL, NULL);
+            chain_run(net, n, 3, &now, 200);
+            TEST_ASSERT(cyxchat_conn_get_state(n[0], &ids[1]) == CYXCHAT_CONN_CONNECTED &&
+                        cyxchat_conn_get_state(n[2], &ids[1]) == CYXCHAT_CONN_CONNECTED,
+                        "Chain should be connected");
+
+            /* C has no signing key yet, so it cannot prove who it is */
+            uint16_t handle = 0;
+            g_label_result = -1;
+            TEST_ASSERT(cyxchat_conn_label_path(n[0], &ids[1], 2, on_label_path, NULL,
+                                                &handle) == CYXCHAT_OK, "Path request");
+            chain_run(net, n, 3, &now, 100);
+            TEST_ASSERT(g_label_result == CYXCHAT_ERR_NETWORK, "Unkeyed hop should refuse");
+            TEST_ASSERT(cyxchat_conn_label_count(n[0]) == 0, "Refused path should be freed");
+
+            cyxchat_conn_set_signing_key(n[2], keys[2]);
+            g_label_result = -1;
+            TEST_ASSERT(cyxchat_conn_label_path(n[0], &ids[1], 2, on_label_path, NULL,
+                                                &handle) == CYXCHAT_OK, "Path request");
+            chain_run(net, n, 3, &now, 100);
+            TEST_ASSERT(g_label_result == CYXCHAT_OK, "Path should come up one hop at a time");
+
+            uint8_t payload[16];
+            memset(payload, 0x48, sizeof(payload));
+            g_label_data = 0;
+            TEST_ASSERT(cyxchat_conn_label_send(n[0], handle, payload, sizeof(payload)) ==
+                        CYXCHAT_OK, "Label send");
+            chain_run(net, n, 3, &now, 50);
+            TEST_ASSERT(g_label_data == 1 && g_label_len == sizeof(payload) &&
+                        g_label_first == 0x48, "End of the path should get the payload");
+
+            TEST_ASSERT(cyxchat_conn_label_release(n[0], handle) == CYXCHAT_OK &&
+                        cyxchat_conn_label_send(n[0], handle, payload, 1) == CYXCHAT_ERR_NOT_FOUND,
+                        "Released path should be gone");
+        }
+
+        for (int i = 0; i < 3; i++) {
+            if (n[i]) cyxchat_conn_destroy(n[i]);
+        }
+        cyxchat_loopnet_destroy(net);
+    }
+
+    return errors;
+}
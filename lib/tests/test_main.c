@@ -11,6 +11,21 @@ int test_chat(void);
 int test_contact(void);
 int test_group(void);
 int test_dns(void);
+int test_dedup(void);
+int test_timer(void);
+int test_netmon(void);
+int test_keepalive(void);
+int test_dispatch(void);
+int test_loopback(void);
+int test_ice(void);
+int test_linkstats(void);
+int test_congestion(void);
+int test_sched(void);
+int test_runtime(void);
+int test_metrics(void);
+int test_config(void);
+int test_label(void);
+int test_offline(void);
 
 /* Test runner */
 typedef struct {
@@ -23,6 +38,21 @@ static test_case_t tests[] = {
     { "contact", test_contact },
     { "group",   test_group },
     { "dns",     test_dns },
+    { "dedup",   test_dedup },
+    { "timer",   test_timer },
+    { "netmon",  test_netmon },
+    { "keepalive", test_keepalive },
+    { "dispatch", test_dispatch },
+    { "loopback", test_loopback },
+    { "ice",     test_ice },
+    { "linkstats", test_linkstats },
+    { "congestion", test_congestion },
+    { "sched",   test_sched },
+    { "runtime", test_runtime },
+    { "metrics", test_metrics },
+    { "config",  test_config },
+    { "label",   test_label },
+    { "offline", test_offline },
     { NULL, NULL }
 };
 
@@ -0,0 +1,173 @@
+/**
+ * CyxChat Test - Metrics Registry
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/metrics.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+static size_t read_varint(const uint8_t *buf, size_t len, size_t *pos, uint64_t *out) {
+    uint64_t v = 0;
+    for (int shift = 0; *pos < len && shift < 64; shift += 7) {
+        uint8_t b = buf[(*pos)++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *out = v;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int test_metrics(void) {
+    int errors = 0;
+
+    cyxchat_metrics_reset();
+
+    /* Test bucket bounds */
+    {
+        TEST_ASSERT(cyxchat_metrics_bucket_upper(0) == 0, "Bucket 0 should hold 0");
+        TEST_ASSERT(cyxchat_metrics_bucket_upper(7) == 7, "Small values get a bucket each");
+        TEST_ASSERT(cyxchat_metrics_bucket_upper(8) == 8, "First log bucket should hold 8");
+        TEST_ASSERT(cyxchat_metrics_bucket_upper(16) == 17, "Second octave is 2 wide");
+        TEST_ASSERT(cyxchat_metrics_bucket_upper(CYXCHAT_METRICS_BUCKETS - 1) == 0xFFFFFFFFull,
+                    "Last bucket should end at 2^32-1");
+
+        /* Upper bounds must strictly increase */
+        int ordered = 1;
+        for (unsigned i = 1; i < CYXCHAT_METRICS_BUCKETS; i++) {
+            if (cyxchat_metrics_bucket_upper(i) <= cyxchat_metrics_bucket_upper(i - 1)) {
+                ordered = 0;
+            }
+        }
+        TEST_ASSERT(ordered, "Bucket bounds should increase");
+    }
+
+    /* Test counters and gauges */
+    {
+        cyxchat_metrics_count(CYXCHAT_METRIC_MSG_SENT, 3);
+        cyxchat_metrics_count(CYXCHAT_METRIC_MSG_SENT, 2);
+        cyxchat_metrics_count(CYXCHAT_METRIC_COUNTER_COUNT, 9);
+        TEST_ASSERT(cyxchat_metrics_counter(CYXCHAT_METRIC_MSG_SENT) == 5, "Counter should sum");
+        TEST_ASSERT(cyxchat_metrics_counter(-1) == 0, "Unknown counter should read 0");
+
+        int64_t before = cyxchat_metrics_gauge(CYXCHAT_METRIC_PEERS_UP);
+        cyxchat_metrics_gauge_add(CYXCHAT_METRIC_PEERS_UP, 2);
+        cyxchat_metrics_gauge_add(CYXCHAT_METRIC_PEERS_UP, -3);
+        TEST_ASSERT(cyxchat_metrics_gauge(CYXCHAT_METRIC_PEERS_UP) == before - 1,
+                    "Gauge should move both ways");
+        cyxchat_metrics_gauge_add(CYXCHAT_METRIC_PEERS_UP, 1);
+    }
+
+    /* Test histogram and percentiles */
+    {
+        cyxchat_metrics_hist_t hist;
+        for (uint64_t us = 1; us <= 1000; us++) {
+            cyxchat_metrics_observe(CYXCHAT_METRIC_SEND_ACK, us);
+        }
+
+        TEST_ASSERT(cyxchat_metrics_get_hist(CYXCHAT_METRIC_SEND_ACK, &hist) == CYXCHAT_OK,
+                    "Get hist should succeed");
+        TEST_ASSERT(hist.count == 1000, "Hist should count every observation");
+        TEST_ASSERT(hist.sum_us == 500500, "Hist should sum observations");
+
+        uint64_t p50 = cyxchat_metrics_percentile(&hist, 0.50);
+        uint64_t p99 = cyxchat_metrics_percentile(&hist, 0.99);
+        TEST_ASSERT(p50 >= 500 && p50 <= 500 + 500 / 8, "p50 should be within one bucket");
+        TEST_ASSERT(p99 >= 990 && p99 <= 990 + 990 / 8, "p99 should be within one bucket");
+        TEST_ASSERT(cyxchat_metrics_percentile(&hist, 1.0) >= 1000, "p100 should cover the max");
+
+        cyxchat_metrics_observe(CYXCHAT_METRIC_HOLE_PUNCH, (uint64_t)1 << 40);
+        cyxchat_metrics_get_hist(CYXCHAT_METRIC_HOLE_PUNCH, &hist);
+        TEST_ASSERT(hist.buckets[CYXCHAT_METRICS_BUCKETS - 1] == 1, "Huge values clamp to last bucket");
+
+        TEST_ASSERT(cyxchat_metrics_get_hist(CYXCHAT_METRIC_TIMING_COUNT, &hist) == CYXCHAT_ERR_INVALID,
+                    "Unknown hist should fail");
+    }
+
+    /* Test binary snapshot */
+    {
+        uint8_t buf[2048];
+        size_t len = 0;
+        TEST_ASSERT(cyxchat_metrics_snapshot(CYXCHAT_METRICS_BINARY, buf, sizeof(buf), &len) == CYXCHAT_OK,
+                    "Binary snapshot should succeed");
+        TEST_ASSERT(len > 7 && memcmp(buf, CYXCHAT_METRICS_MAGIC, 3) == 0, "Snapshot should start with magic");
+        TEST_ASSERT(buf[3] == CYXCHAT_METRICS_VERSION, "Snapshot should carry version");
+        TEST_ASSERT(buf[4] == CYXCHAT_METRIC_COUNTER_COUNT, "Snapshot should carry counter count");
+
+        size_t pos = 7;
+        uint64_t sent = 0;
+        read_varint(buf, len, &pos, &sent);
+        TEST_ASSERT(sent == 5, "First counter should be msg_sent");
+
+        /* Skip remaining counters and gauges, then read the send_ack histogram */
+        uint64_t v = 0;
+        for (int i = 1; i < CYXCHAT_METRIC_COUNTER_COUNT + CYXCHAT_METRIC_GAUGE_COUNT; i++) {
+            read_varint(buf, len, &pos, &v);
+        }
+        uint64_t count = 0, sum = 0;
+        read_varint(buf, len, &pos, &count);
+        read_varint(buf, len, &pos, &sum);
+        TEST_ASSERT(count == 1000 && sum == 500500, "Histogram header should round-trip");
+
+        size_t small = 0;
+        TEST_ASSERT(cyxchat_metrics_snapshot(CYXCHAT_METRICS_BINARY, buf, 16, &small) == CYXCHAT_ERR_FULL,
+                    "Short buffer should report full");
+    }
+
+    /* Test Prometheus snapshot */
+    {
+        static uint8_t text[32768];
+        size_t len = 0;
+        TEST_ASSERT(cyxchat_metrics_snapshot(CYXCHAT_METRICS_PROMETHEUS, text, sizeof(text), &len) == CYXCHAT_OK,
+                    "Text snapshot should succeed");
+        TEST_ASSERT(text[len] == '\0', "Text snapshot should be NUL-terminated");
+        TEST_ASSERT(strstr((char*)text, "cyxchat_msg_sent_total 5\n") != NULL, "Text should list counters");
+        TEST_ASSERT(strstr((char*)text, "cyxchat_send_ack_seconds_count 1000\n") != NULL,
+                    "Text should list histogram count");
+        TEST_ASSERT(strstr((char*)text, "cyxchat_send_ack_seconds_bucket{le=\"+Inf\"} 1000\n") != NULL,
+                    "Text should end buckets with +Inf");
+        TEST_ASSERT(strstr((char*)text, "cyxchat_send_ack_seconds_bucket{le=\"0.001023\"} 1000\n") != NULL,
+                    "Bounds should be powers of two, cumulative");
+
+        /* Same bounds for every histogram, empty or not */
+        int bounds = 0;
+        for (const char *p = (char*)text; (p = strstr(p, "cyxchat_file_transfer_seconds_bucket{")); p++) {
+            bounds++;
+        }
+        TEST_ASSERT(bounds == CYXCHAT_METRICS_BUCKETS / 8 + 1, "Every octave should be a bound");
+
+        TEST_ASSERT(cyxchat_metrics_snapshot(CYXCHAT_METRICS_PROMETHEUS, text, 64, &len) == CYXCHAT_ERR_FULL,
+                    "Short text buffer should report full");
+        TEST_ASSERT(cyxchat_metrics_snapshot(CYXCHAT_METRICS_BINARY, NULL, 0, &len) == CYXCHAT_ERR_NULL,
+                    "NULL buffer should fail");
+    }
+
+    /* Test names and reset */
+    {
+        TEST_ASSERT(strcmp(cyxchat_metrics_name(CYXCHAT_METRIC_KIND_TIMING, CYXCHAT_METRIC_DNS_LOOKUP),
+                           "dns_lookup") == 0, "Timing name should resolve");
+        TEST_ASSERT(strcmp(cyxchat_metrics_name(CYXCHAT_METRIC_KIND_COUNTER, 999), "unknown") == 0,
+                    "Unknown name should be unknown");
+
+        int64_t peers = cyxchat_metrics_gauge(CYXCHAT_METRIC_PEERS_UP);
+        cyxchat_metrics_reset();
+
+        cyxchat_metrics_hist_t hist;
+        cyxchat_metrics_get_hist(CYXCHAT_METRIC_SEND_ACK, &hist);
+        TEST_ASSERT(cyxchat_metrics_counter(CYXCHAT_METRIC_MSG_SENT) == 0, "Reset should zero counters");
+        TEST_ASSERT(hist.count == 0 && cyxchat_metrics_percentile(&hist, 0.5) == 0,
+                    "Reset should empty histograms");
+        TEST_ASSERT(cyxchat_metrics_gauge(CYXCHAT_METRIC_PEERS_UP) == peers, "Reset should keep gauges");
+    }
+
+    return errors;
+}
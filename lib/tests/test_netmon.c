@@ -0,0 +1,300 @@
+/**
+ * CyxChat Test - Network Monitor (STUN refresh against a loopback server)
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/netmon.h>
+#include <cyxchat/connection.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+typedef SOCKET test_sock_t;
+#define test_close_sock closesocket
+#else
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <unistd.h>
+typedef int test_sock_t;
+#define test_close_sock close
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+typedef struct {
+    int calls;
+    int had_old;
+    cyxchat_netmon_addr_t last;
+} change_probe_t;
+
+static void on_change(cyxchat_netmon_t *nm, const cyxchat_netmon_addr_t *old_addr,
+                      const cyxchat_netmon_addr_t *new_addr, void *user_data) {
+    (void)nm;
+    change_probe_t *probe = (change_probe_t*)user_data;
+    probe->calls++;
+    probe->had_old = old_addr != NULL;
+    probe->last = *new_addr;
+}
+
+/* Wait up to timeout_ms for a request; returns its length */
+static int server_recv(test_sock_t s, uint8_t *buf, size_t cap,
+                       struct sockaddr_in *from, int timeout_ms) {
+    fd_set fds;
+    struct timeval tv;
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    FD_ZERO(&fds);
+    FD_SET(s, &fds);
+    if (select((int)s + 1, &fds, NULL, NULL, &tv) <= 0) return 0;
+
+    socklen_t from_len = sizeof(*from);
+    return (int)recvfrom(s, (char*)buf, (int)cap, 0, (struct sockaddr*)from, &from_len);
+}
+
+/* Binding success with XOR-MAPPED-ADDRESS ip:port (host order) */
+static void server_reply(test_sock_t s, const uint8_t *request,
+                         const struct sockaddr_in *to, uint32_t ip, uint16_t port,
+                         int corrupt_txid) {
+    uint8_t msg[32];
+    memset(msg, 0, sizeof(msg));
+    msg[0] = 0x01;
+    msg[1] = 0x01;
+    msg[3] = 12;
+    memcpy(msg + 4, request + 4, 16);           /* Cookie and transaction ID */
+    if (corrupt_txid) msg[8] ^= 0xFF;
+
+    msg[21] = 0x20;                             /* XOR-MAPPED-ADDRESS */
+    msg[23] = 8;
+    msg[25] = 0x01;
+    uint16_t xport = (uint16_t)(port ^ 0x2112);
+    uint32_t xip = ip ^ 0x2112A442u;
+    msg[26] = (uint8_t)(xport >> 8);
+    msg[27] = (uint8_t)xport;
+    msg[28] = (uint8_t)(xip >> 24);
+    msg[29] = (uint8_t)(xip >> 16);
+    msg[30] = (uint8_t)(xip >> 8);
+    msg[31] = (uint8_t)xip;
+
+    sendto(s, (const char*)msg, sizeof(msg), 0, (const struct sockaddr*)to, sizeof(*to));
+}
+
+int test_netmon(void) {
+    int errors = 0;
+
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+
+    test_sock_t server = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    bind(server, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(server, (struct sockaddr*)&addr, &addr_len);
+
+    char server_str[32];
+    snprintf(server_str, sizeof(server_str), "127.0.0.1:%u", ntohs(addr.sin_port));
+
+    cyxchat_timer_wheel_t *wheel = NULL;
+    cyxchat_timer_wheel_create(&wheel, 1000);
+
+    cyxchat_netmon_t *nm = NULL;
+    cyxchat_error_t err = cyxchat_netmon_create(&nm, wheel, server_str);
+    TEST_ASSERT(err == CYXCHAT_OK, "Create should succeed");
+    TEST_ASSERT(nm != NULL, "Monitor should not be NULL");
+    if (!nm) {
+        cyxchat_timer_wheel_destroy(wheel);
+        test_close_sock(server);
+        return errors;
+    }
+
+    change_probe_t probe;
+    memset(&probe, 0, sizeof(probe));
+    cyxchat_netmon_set_on_change(nm, on_change, &probe);
+
+    uint8_t req[128];
+    struct sockaddr_in from;
+    cyxchat_netmon_addr_t got;
+
+    /* Test first probe reports the mapped address */
+    {
+        TEST_ASSERT(cyxchat_netmon_get_addr(nm, &got) == CYXCHAT_ERR_NETWORK,
+                    "No address before first response");
+
+        cyxchat_timer_advance(wheel, cyxchat_timer_now(wheel));
+        int n = server_recv(server, req, sizeof(req), &from, 1000);
+        TEST_ASSERT(n == 20, "Binding request is a bare header");
+        TEST_ASSERT(n == 20 && req[0] == 0x00 && req[1] == 0x01 &&
+                    req[4] == 0x21 && req[5] == 0x12 && req[6] == 0xA4 && req[7] == 0x42,
+                    "Request type and magic cookie");
+
+        server_reply(server, req, &from, 0xCB007105u, 40000, 0);
+        TEST_ASSERT(cyxchat_netmon_poll(nm) == 1, "Poll reports the first address");
+        TEST_ASSERT(probe.calls == 1 && !probe.had_old, "First address has no old value");
+        TEST_ASSERT(probe.last.public_ip == htonl(0xCB007105u) &&
+                    probe.last.public_port == htons(40000), "XOR-mapped address decoded");
+        TEST_ASSERT(probe.last.local_ip == htonl(INADDR_LOOPBACK), "Local route address");
+        TEST_ASSERT(cyxchat_netmon_get_addr(nm, &got) == CYXCHAT_OK &&
+                    got.public_ip == probe.last.public_ip, "Address stored");
+    }
+
+    /* Test unchanged address and mismatched transaction ID */
+    {
+        TEST_ASSERT(cyxchat_netmon_refresh(nm) == CYXCHAT_OK, "Refresh sends a request");
+        int n = server_recv(server, req, sizeof(req), &from, 1000);
+        TEST_ASSERT(n == 20, "Refresh request received");
+
+        server_reply(server, req, &from, 0xC6336407u, 1, 1);
+        TEST_ASSERT(cyxchat_netmon_poll(nm) == 0, "Foreign transaction ignored");
+
+        server_reply(server, req, &from, 0xCB007105u, 40001, 0);
+        TEST_ASSERT(cyxchat_netmon_poll(nm) == 0, "Same public IP is not a change");
+        TEST_ASSERT(probe.calls == 1, "No callback for unchanged address");
+    }
+
+    /* Test public address change */
+    {
+        cyxchat_netmon_refresh(nm);
+        int n = server_recv(server, req, sizeof(req), &from, 1000);
+        TEST_ASSERT(n == 20, "Second refresh request received");
+
+        server_reply(server, req, &from, 0xC6336407u, 50000, 0);
+        TEST_ASSERT(cyxchat_netmon_poll(nm) == 1, "New public IP reported");
+        TEST_ASSERT(probe.calls == 2 && probe.had_old, "Change carries the old address");
+        TEST_ASSERT(probe.last.public_ip == htonl(0xC6336407u), "New address delivered");
+    }
+
+    /* Test retransmit with backoff, then timeout */
+    {
+        cyxchat_netmon_refresh(nm);
+
+        /* 10 s of wheel time: retransmits at 0.5, 1.5, 3.5 s, give up at 7.5 s */
+        int requests = 0;
+        uint64_t t = cyxchat_timer_now(wheel);
+        for (int i = 0; i < 200; i++) {
+            while (server_recv(server, req, sizeof(req), &from, 0) == 20) {
+                requests++;
+            }
+            t += 50;
+            cyxchat_timer_advance(wheel, t);
+        }
+
+        cyxchat_netmon_stats_t stats;
+        cyxchat_netmon_get_stats(nm, &stats);
+        TEST_ASSERT(requests == CYXCHAT_NETMON_MAX_TRIES, "Request retransmitted until limit");
+        TEST_ASSERT(stats.timeouts >= 1, "Unanswered probe times out");
+        TEST_ASSERT(stats.responses == 3, "Three valid responses");
+        TEST_ASSERT(stats.changes == 2, "Two changes reported");
+        TEST_ASSERT(probe.calls == 2, "Timeout does not report a change");
+    }
+
+    /* Test binding lifetime trials (RFC 5780 RESPONSE-PORT) */
+    {
+        cyxchat_keepalive_t ka;
+        struct sockaddr_in bound;
+        int n;
+
+        cyxchat_netmon_set_lifetime_probe(nm, 1);
+        n = server_recv(server, req, sizeof(req), &bound, 1000);
+        TEST_ASSERT(n == 20, "Binding opened for the first trial");
+        server_reply(server, req, &bound, 0x7F000001u, ntohs(bound.sin_port), 0);
+        cyxchat_netmon_poll(nm);
+
+        /* Idle through the trial; the test request comes from another port */
+        n = 0;
+        uint64_t t = cyxchat_timer_now(wheel);
+        for (int i = 0; i < 30 && n != 28; i++) {
+            t += 1000;
+            cyxchat_timer_advance(wheel, t);
+            while ((n = server_recv(server, req, sizeof(req), &from, 0)) > 0 && n != 28) {
+            }
+        }
+        TEST_ASSERT(n == 28 && from.sin_port != bound.sin_port, "Test request from a second port");
+        TEST_ASSERT(n == 28 && req[20] == 0x00 && req[21] == 0x27 &&
+                    memcmp(req + 24, &bound.sin_port, 2) == 0,
+                    "RESPONSE-PORT names the idle binding");
+
+        /* Answer on the idle binding: it survived */
+        server_reply(server, req, &bound, 0x7F000001u, ntohs(bound.sin_port), 0);
+        cyxchat_netmon_poll(nm);
+        cyxchat_netmon_get_keepalive(nm, &ka);
+        TEST_ASSERT(ka.trials == 1 && ka.alive_ms == CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS,
+                    "Survived trial recorded");
+        TEST_ASSERT(ka.trial_ms == 2 * CYXCHAT_KEEPALIVE_FIRST_TRIAL_MS, "Next trial longer");
+
+        /* Refresh for the next trial, then answer on the asking port */
+        do {
+            n = server_recv(server, req, sizeof(req), &from, 1000);
+        } while (n > 0 && from.sin_port != bound.sin_port);
+        TEST_ASSERT(n == 20, "Binding refreshed");
+        server_reply(server, req, &from, 0x7F000001u, ntohs(from.sin_port), 0);
+        cyxchat_netmon_poll(nm);
+
+        n = 0;
+        t = cyxchat_timer_now(wheel);
+        for (int i = 0; i < 50 && n != 28; i++) {
+            t += 1000;
+            cyxchat_timer_advance(wheel, t);
+            while ((n = server_recv(server, req, sizeof(req), &from, 0)) > 0 && n != 28) {
+            }
+        }
+        TEST_ASSERT(n == 28, "Second test request");
+        server_reply(server, req, &from, 0x7F000001u, ntohs(from.sin_port), 0);
+        cyxchat_netmon_poll(nm);
+
+        cyxchat_netmon_get_keepalive(nm, &ka);
+        TEST_ASSERT(ka.unsupported && ka.trial_ms == 0, "Reply on asking port ends search");
+        TEST_ASSERT(ka.interval_ms == CYXCHAT_KEEPALIVE_INTERVAL_MS, "Default interval kept");
+
+        cyxchat_netmon_stats_t stats;
+        cyxchat_netmon_get_stats(nm, &stats);
+        TEST_ASSERT(stats.lifetime_trials == 1, "One trial finished");
+    }
+
+    /* Test a server name is looked up without blocking the probe timer */
+    {
+        char name_str[32];
+        snprintf(name_str, sizeof(name_str), "localhost:%u", ntohs(addr.sin_port));
+        TEST_ASSERT(cyxchat_netmon_set_server(nm, name_str) == CYXCHAT_OK, "Named server set");
+        TEST_ASSERT(cyxchat_netmon_refresh(nm) == CYXCHAT_OK, "Refresh starts the lookup");
+
+        int n = 0;
+        uint64_t t = cyxchat_timer_now(wheel);
+        for (int i = 0; i < 200 && n == 0; i++) {
+            t += CYXCHAT_NETMON_CHECK_MS;
+            cyxchat_timer_advance(wheel, t);
+            n = server_recv(server, req, sizeof(req), &from, 10);
+        }
+        TEST_ASSERT(n == 20, "Request sent once the name resolves");
+    }
+
+    /* Test bad arguments */
+    {
+        TEST_ASSERT(cyxchat_netmon_set_server(nm, "no-port") == CYXCHAT_ERR_INVALID,
+                    "Server without port rejected");
+        TEST_ASSERT(cyxchat_netmon_set_server(nm, "host:70000") == CYXCHAT_ERR_INVALID,
+                    "Out of range port rejected");
+        TEST_ASSERT(cyxchat_netmon_create(NULL, wheel, NULL) == CYXCHAT_ERR_NULL,
+                    "NULL output should fail");
+        TEST_ASSERT(cyxchat_netmon_poll(NULL) == 0, "NULL poll is no-op");
+    }
+
+    cyxchat_netmon_destroy(nm);
+    cyxchat_timer_wheel_destroy(wheel);
+    test_close_sock(server);
+
+    return errors;
+}
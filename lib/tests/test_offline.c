@@ -0,0 +1,392 @@
+/**
+ * CyxChat Test - Offline Delivery
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/offline.h>
+#include <cyxwiz/crypto.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+/* In-process network: frames queue until pumped */
+#define NET_NODES   4
+#define NET_FRAMES  64
+
+typedef struct {
+    cyxwiz_node_id_t id;                /* Ed25519 public key with crypto */
+    uint8_t sk[64];
+    cyxchat_offline_ctx_t *ctx;
+    int drop;                           /* Lose everything this node sends */
+} net_node_t;
+
+typedef struct {
+    int from;
+    int to;
+    size_t len;
+    uint8_t data[CYXCHAT_OFFLINE_FRAME_MAX];
+} net_frame_t;
+
+static net_node_t g_nodes[NET_NODES];
+static net_frame_t g_frames[NET_FRAMES];
+static size_t g_frame_count;
+static size_t g_sent_type[256];
+
+static int node_index(const cyxwiz_node_id_t *id)
+{
+    for (int i = 0; i < NET_NODES; i++) {
+        if (memcmp(&g_nodes[i].id, id, sizeof(*id)) == 0) return i;
+    }
+    return -1;
+}
+
+static cyxchat_error_t net_send(void *user_data, const cyxwiz_node_id_t *to,
+                                const uint8_t *data, size_t len)
+{
+    net_node_t *from = (net_node_t*)user_data;
+    int dest = node_index(to);
+    if (dest < 0 || len > CYXCHAT_OFFLINE_FRAME_MAX || g_frame_count == NET_FRAMES) {
+        return CYXCHAT_ERR_NETWORK;
+    }
+
+    g_sent_type[data[0]]++;
+    if (from->drop) return CYXCHAT_OK;
+
+    net_frame_t *f = &g_frames[g_frame_count++];
+    f->from = (int)(from - g_nodes);
+    f->to = dest;
+    f->len = len;
+    memcpy(f->data, data, len);
+    return CYXCHAT_OK;
+}
+
+/* Nodes 1 and 2 store for everybody */
+static size_t net_closest(void *user_data, const cyxwiz_node_id_t *key,
+                          cyxwiz_node_id_t *out_nodes, size_t max_nodes)
+{
+    (void)user_data;
+    (void)key;
+    size_t n = 0;
+    for (int i = 1; i <= 2 && n < max_nodes; i++) {
+        out_nodes[n++] = g_nodes[i].id;
+    }
+    return n;
+}
+
+static void net_pump(void)
+{
+    for (size_t i = 0; i < g_frame_count; i++) {
+        net_frame_t f = g_frames[i];
+        cyxchat_offline_handle_message(g_nodes[f.to].ctx, &g_nodes[f.from].id, f.data, f.len);
+    }
+    g_frame_count = 0;
+}
+
+static void net_pump_all(void)
+{
+    while (g_frame_count > 0) {
+        net_pump();
+    }
+}
+
+/* Recorded callbacks */
+static int g_delivered;
+static size_t g_delivered_bytes;
+static cyxwiz_node_id_t g_last_from;
+static int g_stored_ok;
+static int g_stored_fail;
+
+static void on_message(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *from,
+                       const uint8_t *data, size_t len, void *user_data)
+{
+    (void)ctx;
+    (void)data;
+    (void)user_data;
+    g_delivered++;
+    g_delivered_bytes += len;
+    g_last_from = *from;
+}
+
+static void on_stored(cyxchat_offline_ctx_t *ctx, const cyxwiz_node_id_t *to,
+                      uint64_t item_id, cyxchat_error_t result, void *user_data)
+{
+    (void)ctx;
+    (void)to;
+    (void)item_id;
+    (void)user_data;
+    if (result == CYXCHAT_OK) g_stored_ok++;
+    else g_stored_fail++;
+}
+
+static int net_setup(void)
+{
+    memset(g_nodes, 0, sizeof(g_nodes));
+    memset(g_sent_type, 0, sizeof(g_sent_type));
+    g_frame_count = 0;
+    g_delivered = 0;
+    g_delivered_bytes = 0;
+    g_stored_ok = 0;
+    g_stored_fail = 0;
+
+    cyxchat_config_t cfg;
+    cyxchat_config_default(&cfg);
+    cfg.offline_store_size = 32;
+
+    for (int i = 0; i < NET_NODES; i++) {
+        const uint8_t *sk = NULL;
+#ifdef CYXWIZ_HAS_CRYPTO
+        crypto_sign_keypair(g_nodes[i].id.bytes, g_nodes[i].sk);
+        sk = g_nodes[i].sk;
+#else
+        memset(&g_nodes[i].id, 0x10 * (i + 1), sizeof(cyxwiz_node_id_t));
+#endif
+        if (cyxchat_offline_create(&g_nodes[i].ctx, &g_nodes[i].id, sk, &cfg) != CYXCHAT_OK) {
+            return 0;
+        }
+        cyxchat_offline_set_transport(g_nodes[i].ctx, net_send, net_closest, &g_nodes[i]);
+        cyxchat_offline_set_on_message(g_nodes[i].ctx, on_message, NULL);
+        cyxchat_offline_set_on_stored(g_nodes[i].ctx, on_stored, NULL);
+    }
+    return 1;
+}
+
+static void net_teardown(void)
+{
+    for (int i = 0; i < NET_NODES; i++) {
+        cyxchat_offline_destroy(g_nodes[i].ctx);
+        g_nodes[i].ctx = NULL;
+    }
+}
+
+static size_t held(int node)
+{
+    cyxchat_offline_stats_t st;
+    cyxchat_offline_get_stats(g_nodes[node].ctx, &st);
+    return st.held;
+}
+
+/* PUT of one item with an unsealed blob, straight to a storage node */
+static size_t build_put(uint8_t *buf, const uint8_t *key, uint32_t ttl, uint64_t item_id,
+                        const uint8_t *token, size_t blob_len)
+{
+    uint8_t hash[CYXCHAT_OFFLINE_TOKEN_SIZE];
+    cyxwiz_crypto_hash(token, CYXCHAT_OFFLINE_TOKEN_SIZE, hash, sizeof(hash));
+
+    buf[0] = CYXCHAT_MSG_OFFLINE_PUT;
+    memcpy(buf + 1, key, 32);
+    for (int i = 0; i < 4; i++) buf[33 + i] = (uint8_t)(ttl >> (8 * i));
+    buf[37] = 1;
+    for (int i = 0; i < 8; i++) buf[38 + i] = (uint8_t)(item_id >> (8 * i));
+    memcpy(buf + 46, hash, sizeof(hash));
+    buf[62] = (uint8_t)(blob_len & 0xFF);
+    buf[63] = (uint8_t)(blob_len >> 8);
+    memset(buf + 64, 0xAB, blob_len);
+    return 64 + blob_len;
+}
+
+int test_offline(void) {
+    int errors = 0;
+
+    /* Test mailbox keys */
+    {
+        cyxwiz_node_id_t a, b;
+        memset(&a, 0x11, sizeof(a));
+        memset(&b, 0x22, sizeof(b));
+
+        uint8_t k0[32], k0b[32], k1[32], kb[32];
+        cyxchat_offline_mailbox_key(&a, 0, k0);
+        cyxchat_offline_mailbox_key(&a, 0, k0b);
+        cyxchat_offline_mailbox_key(&a, 1, k1);
+        cyxchat_offline_mailbox_key(&b, 0, kb);
+        TEST_ASSERT(memcmp(k0, k0b, 32) == 0, "Key should be deterministic");
+        TEST_ASSERT(memcmp(k0, k1, 32) != 0, "Slots should have distinct keys");
+        TEST_ASSERT(memcmp(k0, kb, 32) != 0, "Recipients should have distinct keys");
+    }
+
+    /* Test storage: duplicate PUT, delete token, per-key TTL expiry */
+    {
+        TEST_ASSERT(net_setup(), "Contexts should be created");
+        uint8_t key[32], frame[CYXCHAT_OFFLINE_FRAME_MAX];
+        uint8_t token[CYXCHAT_OFFLINE_TOKEN_SIZE], wrong[CYXCHAT_OFFLINE_TOKEN_SIZE];
+        memset(token, 0x77, sizeof(token));
+        memset(wrong, 0x78, sizeof(wrong));
+        cyxchat_offline_mailbox_key(&g_nodes[3].id, 0, key);
+
+        cyxchat_offline_poll(g_nodes[1].ctx, 1000);
+        size_t len = build_put(frame, key, 10, 42, token, 100);
+        TEST_ASSERT(cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[0].id, frame, len)
+                    == CYXCHAT_OK, "PUT should be accepted");
+        cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[0].id, frame, len);
+        TEST_ASSERT(held(1) == 1, "Resent PUT should not store twice");
+        TEST_ASSERT(g_sent_type[CYXCHAT_MSG_OFFLINE_PUT_ACK] == 2, "Both PUTs should be ACKed");
+        TEST_ASSERT(cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[0].id, frame, len - 1)
+                    == CYXCHAT_ERR_INVALID, "Truncated PUT should be refused");
+
+        uint8_t del[34 + 24];
+        del[0] = CYXCHAT_MSG_OFFLINE_DELETE;
+        memcpy(del + 1, key, 32);
+        del[33] = 1;
+        for (int i = 0; i < 8; i++) del[34 + i] = (uint8_t)((uint64_t)42 >> (8 * i));
+        memcpy(del + 42, wrong, sizeof(wrong));
+        cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[2].id, del, sizeof(del));
+        TEST_ASSERT(held(1) == 1, "Wrong token should not delete");
+        memcpy(del + 42, token, sizeof(token));
+        cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[2].id, del, sizeof(del));
+        TEST_ASSERT(held(1) == 0, "Token should delete");
+
+        len = build_put(frame, key, 10, 43, token, 100);
+        cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[0].id, frame, len);
+        cyxchat_offline_poll(g_nodes[1].ctx, 1000 + 9999);
+        TEST_ASSERT(held(1) == 1, "Item should live for its TTL");
+        cyxchat_offline_poll(g_nodes[1].ctx, 1000 + 10000);
+        TEST_ASSERT(held(1) == 0, "Item should expire after its TTL");
+
+        /* A full store refuses rather than evicting live items */
+        for (uint64_t id = 1; id <= 40; id++) {
+            len = build_put(frame, key, 60, id, token, 10);
+            cyxchat_offline_handle_message(g_nodes[1].ctx, &g_nodes[0].id, frame, len);
+        }
+        cyxchat_offline_stats_t st;
+        cyxchat_offline_get_stats(g_nodes[1].ctx, &st);
+        TEST_ASSERT(st.held == 32 && st.items_refused == 8, "Store should cap at its size");
+        net_teardown();
+    }
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    /* Test send, batch, ACK, drain across replicas and delete */
+    {
+        TEST_ASSERT(net_setup(), "Contexts should be created");
+        cyxchat_offline_ctx_t *alice = g_nodes[0].ctx;
+        cyxchat_offline_ctx_t *bob = g_nodes[3].ctx;
+        uint8_t bob_pub[32];
+        cyxchat_offline_get_public_key(bob, bob_pub);
+
+        cyxchat_offline_poll(alice, 0);
+        cyxchat_offline_poll(bob, 0);
+        net_pump_all();
+        g_nodes[3].drop = 1;                /* Bob is offline */
+
+        uint8_t msg[200];
+        memset(msg, 0x5A, sizeof(msg));
+        for (int i = 0; i < 8; i++) {
+            TEST_ASSERT(cyxchat_offline_send(alice, &g_nodes[3].id, bob_pub, msg, sizeof(msg), NULL)
+                        == CYXCHAT_OK, "Send should queue");
+        }
+        TEST_ASSERT(cyxchat_offline_send(alice, &g_nodes[3].id, bob_pub, msg,
+                                         CYXCHAT_OFFLINE_MAX_PAYLOAD + 1, NULL)
+                    == CYXCHAT_ERR_INVALID, "Oversized message should be refused");
+
+        cyxchat_offline_poll(alice, 50);
+        size_t puts = g_sent_type[CYXCHAT_MSG_OFFLINE_PUT];
+        TEST_ASSERT(puts > 0 && puts < 16, "A full batch should go before the timer, in few frames");
+        cyxchat_offline_poll(alice, CYXCHAT_OFFLINE_BATCH_MS);
+        net_pump_all();
+        TEST_ASSERT(g_stored_ok == 8 && g_stored_fail == 0, "Every item should be ACKed");
+        TEST_ASSERT(held(1) == 8 && held(2) == 8, "Both replicas should hold every item");
+
+        /* Alice leaves; nothing she sent depends on her any more */
+        cyxchat_offline_poll(alice, CYXCHAT_OFFLINE_RETRY_MS * 4);
+        TEST_ASSERT(g_stored_fail == 0, "ACKed items should not be retried");
+
+        g_nodes[3].drop = 0;
+        TEST_ASSERT(cyxchat_offline_drain(bob) == 2 * CYXCHAT_OFFLINE_SLOTS,
+                    "Drain should GET every slot from every replica");
+        net_pump_all();
+        TEST_ASSERT(g_delivered == 8 && g_delivered_bytes == 8 * sizeof(msg),
+                    "Every item should be delivered once across replicas and pages");
+        TEST_ASSERT(memcmp(&g_last_from, &g_nodes[0].id, sizeof(g_last_from)) == 0,
+                    "Sender should be recovered from the seal");
+        TEST_ASSERT(held(1) == 0 && held(2) == 0, "Drained items should be deleted everywhere");
+
+        cyxchat_offline_stats_t st;
+        cyxchat_offline_get_stats(bob, &st);
+        TEST_ASSERT(st.gets_pending == 0 && st.items_delivered == 8, "Drain should finish");
+        net_teardown();
+    }
+
+    /* Test retry then failure when no replica answers */
+    {
+        TEST_ASSERT(net_setup(), "Contexts should be created");
+        cyxchat_offline_ctx_t *alice = g_nodes[0].ctx;
+        uint8_t bob_pub[32];
+        cyxchat_offline_get_public_key(g_nodes[3].ctx, bob_pub);
+        g_nodes[0].drop = 1;
+
+        uint64_t item_id = 0;
+        cyxchat_offline_poll(alice, 0);
+        cyxchat_offline_send(alice, &g_nodes[3].id, bob_pub, (const uint8_t*)"hi", 2, &item_id);
+        TEST_ASSERT(item_id != 0, "Item ID should be returned");
+
+        uint64_t now = CYXCHAT_OFFLINE_BATCH_MS;
+        for (int i = 0; i < CYXCHAT_OFFLINE_ATTEMPTS; i++) {
+            cyxchat_offline_poll(alice, now);
+            now += CYXCHAT_OFFLINE_RETRY_MS;
+        }
+        TEST_ASSERT(g_sent_type[CYXCHAT_MSG_OFFLINE_PUT] == 2 * CYXCHAT_OFFLINE_ATTEMPTS,
+                    "Each attempt should reach both replicas");
+        TEST_ASSERT(g_stored_fail == 0, "Item should not fail before its last retry");
+        cyxchat_offline_poll(alice, now);
+        TEST_ASSERT(g_stored_fail == 1, "Item should fail after its attempts");
+        net_teardown();
+    }
+
+    /* Test an item claiming another sender is dropped and deleted */
+    {
+        TEST_ASSERT(net_setup(), "Contexts should be created");
+        cyxchat_offline_ctx_t *bob = g_nodes[3].ctx;
+        uint8_t bob_pub[32];
+        cyxchat_offline_get_public_key(bob, bob_pub);
+
+        /* Claims to be node 0, signs with node 2's key */
+        cyxchat_offline_ctx_t *forger = NULL;
+        TEST_ASSERT(cyxchat_offline_create(&forger, &g_nodes[0].id, g_nodes[2].sk, NULL)
+                    == CYXCHAT_OK, "Forger should be created");
+        cyxchat_offline_set_transport(forger, net_send, net_closest, &g_nodes[0]);
+
+        cyxchat_offline_poll(forger, 0);
+        cyxchat_offline_send(forger, &g_nodes[3].id, bob_pub, (const uint8_t*)"hi", 2, NULL);
+        cyxchat_offline_poll(forger, CYXCHAT_OFFLINE_BATCH_MS);
+        net_pump_all();
+        TEST_ASSERT(held(1) == 1 && held(2) == 1, "Storage cannot tell a forgery");
+
+        cyxchat_offline_drain(bob);
+        net_pump_all();
+        cyxchat_offline_stats_t st;
+        cyxchat_offline_get_stats(bob, &st);
+        TEST_ASSERT(g_delivered == 0 && st.items_rejected == 1,
+                    "Forged sender should not be delivered");
+        TEST_ASSERT(held(1) == 0 && held(2) == 0, "Forgery should still be deleted");
+
+        cyxchat_offline_ctx_t *anon = NULL;
+        cyxchat_offline_create(&anon, &g_nodes[0].id, NULL, NULL);
+        TEST_ASSERT(cyxchat_offline_send(anon, &g_nodes[3].id, bob_pub, (const uint8_t*)"hi", 2, NULL)
+                    == CYXCHAT_ERR_CRYPTO, "Send without a signing key should fail");
+
+        cyxchat_offline_destroy(anon);
+        cyxchat_offline_destroy(forger);
+        net_teardown();
+    }
+#else
+    /* Test sending needs crypto */
+    {
+        TEST_ASSERT(net_setup(), "Contexts should be created");
+        uint8_t pub[32] = {0};
+        TEST_ASSERT(cyxchat_offline_send(g_nodes[0].ctx, &g_nodes[3].id, pub,
+                                         (const uint8_t*)"hi", 2, NULL) == CYXCHAT_ERR_CRYPTO,
+                    "Send without crypto should fail");
+        net_teardown();
+    }
+#endif
+
+    return errors;
+}
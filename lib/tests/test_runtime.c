@@ -0,0 +1,475 @@
+/**
+ * CyxChat Test - Runtime Command Queue and Event Ring
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/runtime.h>
+
+#ifdef CYXWIZ_HAS_CRYPTO
+#include <sodium.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+#define PRODUCERS           3
+#define CALLS_PER_PRODUCER  500
+#define MAILBOX_WAIT_MS     10000
+#define WAKE_DELAY_MS       50
+
+typedef struct {
+    cyxchat_runtime_t *rt;
+    int base;                           /* First tag for this producer */
+} producer_arg_t;
+
+static int g_counter;                   /* Only touched on the runtime thread */
+
+static cyxchat_error_t count_call(cyxchat_runtime_t *rt, void *user_data) {
+    (void)rt;
+    (void)user_data;
+    g_counter++;
+    return CYXCHAT_OK;
+}
+
+static cyxchat_error_t fail_call(cyxchat_runtime_t *rt, void *user_data) {
+    (void)rt;
+    (void)user_data;
+    return CYXCHAT_ERR_INVALID;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI producer_main(LPVOID arg)
+#else
+static void* producer_main(void *arg)
+#endif
+{
+    producer_arg_t *p = (producer_arg_t*)arg;
+    for (int i = 0; i < CALLS_PER_PRODUCER; i++) {
+        /* Retry while the network thread catches up */
+        while (cyxchat_runtime_call(p->rt, count_call, NULL,
+                                    (uint64_t)(p->base + i)) == CYXCHAT_ERR_FULL) {
+        }
+    }
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+/* Submits one call after a pause, while the owner is blocked */
+#ifdef _WIN32
+static DWORD WINAPI late_producer_main(LPVOID arg)
+#else
+static void* late_producer_main(void *arg)
+#endif
+{
+#ifdef _WIN32
+    Sleep(WAKE_DELAY_MS);
+#else
+    struct timespec ts = { 0, WAKE_DELAY_MS * 1000000L };
+    nanosleep(&ts, NULL);
+#endif
+    cyxchat_runtime_call((cyxchat_runtime_t*)arg, count_call, NULL, 9);
+#ifdef _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+#ifdef CYXWIZ_HAS_CRYPTO
+/* One cycle on each runtime; counts MESSAGE events from `from` on the last */
+static int pump_nodes(cyxchat_runtime_t **rts, int n, const cyxwiz_node_id_t *from)
+{
+    uint64_t now = cyxchat_timestamp_ms();
+    cyxchat_runtime_event_t ev;
+    int messages = 0;
+
+    for (int i = 0; i < n; i++) {
+        cyxchat_runtime_poll(rts[i], now);
+        while (cyxchat_runtime_next_event(rts[i], &ev)) {
+            if (i == n - 1 && ev.type == CYXCHAT_RUNTIME_EVENT_MESSAGE &&
+                memcmp(&ev.peer, from, sizeof(*from)) == 0) {
+                messages++;
+            }
+        }
+    }
+    return messages;
+}
+
+static int is_connected(cyxchat_runtime_t *rt, const cyxwiz_node_id_t *peer)
+{
+    return cyxchat_conn_get_state(cyxchat_runtime_get_conn(rt), peer) == CYXCHAT_CONN_CONNECTED;
+}
+
+/* Alice and Bob never meet: chat to Bob goes through Carol's store */
+static int test_runtime_mailbox(void)
+{
+    int errors = 0;
+    cyxchat_loopnet_t *net = NULL;
+    cyxchat_runtime_t *rts[3] = { NULL, NULL, NULL };
+    cyxwiz_node_id_t ids[3];
+    uint8_t keys[3][64];
+    enum { ALICE, CAROL, BOB };
+
+    TEST_ASSERT(cyxchat_loopnet_create(&net, 7) == CYXCHAT_OK, "Network should be created");
+    if (!net) return errors;
+    for (int i = 0; i < 3; i++) {
+        crypto_sign_keypair(ids[i].bytes, keys[i]);
+        TEST_ASSERT(cyxchat_runtime_create_loopback(&rts[i], net, &ids[i], keys[i]) == CYXCHAT_OK,
+                    "Loopback runtime should be created");
+    }
+    if (!rts[ALICE] || !rts[CAROL] || !rts[BOB]) goto out;
+
+    /* Carol is the only storage node either of them knows */
+    cyxchat_runtime_connect(rts[ALICE], &ids[CAROL], 0);
+    cyxchat_runtime_connect(rts[BOB], &ids[CAROL], 0);
+    uint64_t deadline = cyxchat_timestamp_ms() + MAILBOX_WAIT_MS;
+    while (!(is_connected(rts[ALICE], &ids[CAROL]) && is_connected(rts[BOB], &ids[CAROL])) &&
+           cyxchat_timestamp_ms() < deadline) {
+        pump_nodes(rts, 3, &ids[ALICE]);
+    }
+    TEST_ASSERT(is_connected(rts[ALICE], &ids[CAROL]) && is_connected(rts[BOB], &ids[CAROL]),
+                "Both ends should reach the storage node");
+    cyxchat_conn_dht_add_node(cyxchat_runtime_get_conn(rts[ALICE]), &ids[CAROL]);
+    cyxchat_conn_dht_add_node(cyxchat_runtime_get_conn(rts[BOB]), &ids[CAROL]);
+
+    /* Without Bob's key Alice has nowhere to put it */
+    TEST_ASSERT(cyxchat_offline_send_to(cyxchat_runtime_get_offline(rts[ALICE]), &ids[BOB],
+                                        (const uint8_t*)"hi", 2, NULL) == CYXCHAT_ERR_NOT_FOUND,
+                "Unknown recipient has no mailbox key");
+
+    uint8_t bob_pub[32];
+    cyxchat_offline_get_public_key(cyxchat_runtime_get_offline(rts[BOB]), bob_pub);
+    TEST_ASSERT(cyxchat_contact_add(cyxchat_runtime_get_contacts(rts[ALICE]), &ids[BOB], bob_pub,
+                                    "bob") == CYXCHAT_OK, "Contact should be added");
+
+    static cyxchat_runtime_event_t ev;
+    int completed = 0;
+    cyxchat_runtime_send_text(rts[ALICE], &ids[BOB], "hello bob", 9, NULL, 1);
+    cyxchat_runtime_poll(rts[ALICE], cyxchat_timestamp_ms());
+    while (cyxchat_runtime_next_event(rts[ALICE], &ev)) {
+        if (ev.type == CYXCHAT_RUNTIME_EVENT_COMPLETE && ev.tag == 1) {
+            completed = ev.result == CYXCHAT_OK;
+        }
+    }
+    TEST_ASSERT(completed, "Send should fall back to the mailbox");
+
+    cyxchat_offline_stats_t st;
+    deadline = cyxchat_timestamp_ms() + MAILBOX_WAIT_MS;
+    do {
+        pump_nodes(rts, 3, &ids[ALICE]);
+        cyxchat_offline_get_stats(cyxchat_runtime_get_offline(rts[ALICE]), &st);
+    } while (st.items_stored == 0 && cyxchat_timestamp_ms() < deadline);
+    TEST_ASSERT(st.items_stored == 1, "Storage node should ACK the item");
+
+    int received = 0;
+    cyxchat_offline_drain(cyxchat_runtime_get_offline(rts[BOB]));
+    deadline = cyxchat_timestamp_ms() + MAILBOX_WAIT_MS;
+    while (received == 0 && cyxchat_timestamp_ms() < deadline) {
+        received += pump_nodes(rts, 3, &ids[ALICE]);
+    }
+    TEST_ASSERT(received == 1, "Bob should drain Alice's message");
+
+    do {
+        received += pump_nodes(rts, 3, &ids[ALICE]);
+        cyxchat_offline_get_stats(cyxchat_runtime_get_offline(rts[CAROL]), &st);
+    } while (st.held > 0 && cyxchat_timestamp_ms() < deadline);
+    TEST_ASSERT(st.held == 0, "Drained item should be deleted from the store");
+    TEST_ASSERT(received == 1, "Message should be delivered once");
+
+out:
+    for (int i = 0; i < 3; i++) {
+        cyxchat_runtime_destroy(rts[i]);
+    }
+    cyxchat_loopnet_destroy(net);
+    return errors;
+}
+
+/* With a connection the owner blocks in the transport, not on the queue */
+static int test_runtime_wake(void)
+{
+    int errors = 0;
+    cyxchat_loopnet_t *net = NULL;
+    cyxchat_runtime_t *rt = NULL;
+    cyxwiz_node_id_t id;
+    uint8_t key[64];
+    static cyxchat_runtime_event_t ev;
+
+    TEST_ASSERT(cyxchat_loopnet_create(&net, 11) == CYXCHAT_OK, "Network should be created");
+    if (!net) return errors;
+    crypto_sign_keypair(id.bytes, key);
+    TEST_ASSERT(cyxchat_runtime_create_loopback(&rt, net, &id, key) == CYXCHAT_OK,
+                "Loopback runtime should be created");
+    if (!rt) goto out;
+
+    /* A command queued during the wait ends it */
+    {
+        g_counter = 0;
+        cyxchat_runtime_wait(rt, 0);
+        while (cyxchat_runtime_next_event(rt, &ev)) {
+        }
+
+        uint64_t start = cyxchat_timestamp_ms();
+#ifdef _WIN32
+        HANDLE late = CreateThread(NULL, 0, late_producer_main, rt, 0, NULL);
+#else
+        pthread_t late;
+        pthread_create(&late, NULL, late_producer_main, rt);
+#endif
+        while (g_counter == 0 && cyxchat_timestamp_ms() - start < 5000) {
+            cyxchat_runtime_wait(rt, 5000);
+        }
+        uint64_t took = cyxchat_timestamp_ms() - start;
+#ifdef _WIN32
+        WaitForSingleObject(late, INFINITE);
+        CloseHandle(late);
+#else
+        pthread_join(late, NULL);
+#endif
+        TEST_ASSERT(g_counter == 1, "Late command should run");
+        TEST_ASSERT(took < 1000, "Late command should cut the transport wait short");
+    }
+
+    /* The network thread sleeps until its next deadline */
+    {
+        cyxchat_runtime_stats_t before, after;
+        TEST_ASSERT(cyxchat_runtime_start_thread(rt) == CYXCHAT_OK, "Thread should start");
+        cyxchat_runtime_get_stats(rt, &before);
+#ifdef _WIN32
+        Sleep(300);
+#else
+        struct timespec ts = { 0, 300 * 1000000L };
+        nanosleep(&ts, NULL);
+#endif
+        cyxchat_runtime_get_stats(rt, &after);
+        TEST_ASSERT(after.loops - before.loops < 15, "Idle thread should not spin");
+
+        uint64_t start = cyxchat_timestamp_ms();
+        int done = 0;
+        cyxchat_runtime_call(rt, count_call, NULL, 10);
+        while (!done && cyxchat_timestamp_ms() - start < 5000) {
+            while (cyxchat_runtime_next_event(rt, &ev)) {
+                done |= ev.type == CYXCHAT_RUNTIME_EVENT_COMPLETE && ev.tag == 10;
+            }
+        }
+        TEST_ASSERT(done && cyxchat_timestamp_ms() - start < 1000,
+                    "Submit should wake the idle thread");
+
+        cyxchat_runtime_stop_thread(rt);
+        TEST_ASSERT(!cyxchat_runtime_is_threaded(rt), "Blocked thread should stop");
+    }
+
+out:
+    cyxchat_runtime_destroy(rt);
+    cyxchat_loopnet_destroy(net);
+    return errors;
+}
+#endif
+
+int test_runtime(void) {
+    int errors = 0;
+    static cyxchat_runtime_event_t ev;
+
+    cyxchat_runtime_t *rt = NULL;
+    cyxchat_error_t err = cyxchat_runtime_create(&rt, NULL, NULL, NULL);
+    TEST_ASSERT(err == CYXCHAT_OK, "Create should succeed");
+    TEST_ASSERT(rt != NULL, "Runtime should not be NULL");
+    if (!rt) return errors;
+
+    /* Test inline mode runs commands in order */
+    {
+        g_counter = 0;
+        cyxchat_runtime_call(rt, count_call, NULL, 1);
+        cyxchat_runtime_call(rt, fail_call, NULL, 2);
+        cyxchat_runtime_call(rt, count_call, NULL, 0);
+
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 0, "No events before poll");
+
+        int handled = cyxchat_runtime_poll(rt, 1000);
+        TEST_ASSERT(handled == 3, "Poll should run three commands");
+        TEST_ASSERT(g_counter == 2, "Both count calls should run");
+
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 1, "First completion");
+        TEST_ASSERT(ev.type == CYXCHAT_RUNTIME_EVENT_COMPLETE && ev.tag == 1 &&
+                    ev.result == CYXCHAT_OK, "First completion matches");
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 1, "Second completion");
+        TEST_ASSERT(ev.tag == 2 && ev.result == CYXCHAT_ERR_INVALID,
+                    "Second completion carries the error");
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 0,
+                    "Untagged command has no completion");
+    }
+
+    /* Test deadline-driven wait */
+    {
+        TEST_ASSERT(cyxchat_runtime_get_conn(rt) == NULL && cyxchat_runtime_get_dns(rt) == NULL,
+                    "Runtime without local ID owns no contexts");
+        TEST_ASSERT(cyxchat_runtime_next_deadline(rt) == CYXCHAT_TIMER_NONE,
+                    "Idle runtime has no deadline");
+
+        cyxchat_runtime_call(rt, count_call, NULL, 3);
+        TEST_ASSERT(cyxchat_runtime_next_deadline(rt) == 0, "Queued command is due now");
+
+        uint64_t start = cyxchat_timestamp_ms();
+        TEST_ASSERT(cyxchat_runtime_wait(rt, 1000) == 1, "Wait runs the queued command");
+        TEST_ASSERT(cyxchat_timestamp_ms() - start < 500, "Queued command cuts the wait short");
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 1 && ev.tag == 3,
+                    "Completion after wait");
+
+        TEST_ASSERT(cyxchat_runtime_wait(rt, 5) == 0, "Idle wait times out");
+    }
+
+    /* Test commands for missing contexts and bad arguments */
+    {
+        cyxwiz_node_id_t peer;
+        static uint8_t big[CYXCHAT_RUNTIME_MAX_PAYLOAD + 1];
+        memset(&peer, 0x42, sizeof(peer));
+
+        TEST_ASSERT(cyxchat_runtime_send_text(rt, &peer, "hi", 2, NULL, 7) == CYXCHAT_OK,
+                    "Send text should queue");
+        TEST_ASSERT(cyxchat_runtime_conn_send(rt, &peer, big, sizeof(big), 8) ==
+                    CYXCHAT_ERR_INVALID, "Oversized payload rejected");
+        TEST_ASSERT(cyxchat_runtime_call(rt, NULL, NULL, 9) == CYXCHAT_ERR_NULL,
+                    "NULL function rejected");
+
+        cyxchat_runtime_poll(rt, 1000);
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 1, "Completion for send text");
+        TEST_ASSERT(ev.tag == 7 && ev.result == CYXCHAT_ERR_NULL,
+                    "Send without chat context fails");
+        TEST_ASSERT(memcmp(&ev.peer, &peer, sizeof(peer)) == 0, "Completion names the peer");
+        TEST_ASSERT(cyxchat_runtime_next_event(rt, &ev) == 0, "Nothing else queued");
+    }
+
+    /* Test full queue and event ring backpressure */
+    {
+        int rejected = 0;
+        for (int i = 0; i < CYXCHAT_RUNTIME_CMD_SLOTS + 1; i++) {
+            if (cyxchat_runtime_call(rt, count_call, NULL, 100 + (uint64_t)i) ==
+                CYXCHAT_ERR_FULL) {
+                rejected++;
+            }
+        }
+        TEST_ASSERT(rejected == 1, "Only the overflow command is rejected");
+
+        /* Fill the event ring without reading it */
+        int ran = cyxchat_runtime_poll(rt, 1000);
+        for (int i = 0; i < CYXCHAT_RUNTIME_CMD_SLOTS; i++) {
+            cyxchat_runtime_call(rt, count_call, NULL, 1);
+        }
+        ran += cyxchat_runtime_poll(rt, 1000);
+        TEST_ASSERT(ran == CYXCHAT_RUNTIME_EVENT_SLOTS, "Commands run until ring is full");
+
+        cyxchat_runtime_call(rt, count_call, NULL, 1);
+        TEST_ASSERT(cyxchat_runtime_poll(rt, 1000) == 0,
+                    "Tagged command waits for ring space");
+
+        int drained = 0;
+        while (cyxchat_runtime_next_event(rt, &ev)) drained++;
+        TEST_ASSERT(drained == CYXCHAT_RUNTIME_EVENT_SLOTS, "Ring held every completion");
+
+        TEST_ASSERT(cyxchat_runtime_poll(rt, 1000) == 1, "Waiting command runs");
+        while (cyxchat_runtime_next_event(rt, &ev)) {}
+
+        cyxchat_runtime_stats_t stats;
+        cyxchat_runtime_get_stats(rt, &stats);
+        TEST_ASSERT(stats.commands_rejected == 1, "Rejected submit counted");
+        TEST_ASSERT(stats.events_dropped == 0, "No events dropped");
+    }
+
+    /* Test network thread with several producers */
+    {
+        g_counter = 0;
+        err = cyxchat_runtime_start_thread(rt);
+        TEST_ASSERT(err == CYXCHAT_OK, "Thread should start");
+        TEST_ASSERT(cyxchat_runtime_is_threaded(rt), "Runtime is threaded");
+        TEST_ASSERT(cyxchat_runtime_start_thread(rt) == CYXCHAT_ERR_EXISTS,
+                    "Second start rejected");
+        TEST_ASSERT(cyxchat_runtime_poll(rt, 1000) == 0, "Inline poll disabled");
+
+        producer_arg_t args[PRODUCERS];
+#ifdef _WIN32
+        HANDLE threads[PRODUCERS];
+#else
+        pthread_t threads[PRODUCERS];
+#endif
+        for (int p = 0; p < PRODUCERS; p++) {
+            args[p].rt = rt;
+            args[p].base = 1 + p * CALLS_PER_PRODUCER;
+#ifdef _WIN32
+            threads[p] = CreateThread(NULL, 0, producer_main, &args[p], 0, NULL);
+#else
+            pthread_create(&threads[p], NULL, producer_main, &args[p]);
+#endif
+        }
+
+        /* Per-producer tags must arrive in submit order */
+        int next[PRODUCERS];
+        for (int p = 0; p < PRODUCERS; p++) next[p] = args[p].base;
+
+        int received = 0;
+        int out_of_order = 0;
+        uint64_t deadline = cyxchat_timestamp_ms() + 10000;
+        while (received < PRODUCERS * CALLS_PER_PRODUCER &&
+               cyxchat_timestamp_ms() < deadline) {
+            if (!cyxchat_runtime_next_event(rt, &ev)) continue;
+            int p = (int)((ev.tag - 1) / CALLS_PER_PRODUCER);
+            if (p < 0 || p >= PRODUCERS || (int)ev.tag != next[p]) {
+                out_of_order++;
+            } else {
+                next[p]++;
+            }
+            received++;
+        }
+
+        for (int p = 0; p < PRODUCERS; p++) {
+#ifdef _WIN32
+            WaitForSingleObject(threads[p], INFINITE);
+            CloseHandle(threads[p]);
+#else
+            pthread_join(threads[p], NULL);
+#endif
+        }
+
+        cyxchat_runtime_stop_thread(rt);
+        TEST_ASSERT(!cyxchat_runtime_is_threaded(rt), "Thread stopped");
+        TEST_ASSERT(received == PRODUCERS * CALLS_PER_PRODUCER, "Every completion received");
+        TEST_ASSERT(out_of_order == 0, "Per-producer order preserved");
+        TEST_ASSERT(g_counter == PRODUCERS * CALLS_PER_PRODUCER, "Every call ran once");
+    }
+
+    /* Test NULL handling */
+    {
+        TEST_ASSERT(cyxchat_runtime_create(NULL, NULL, NULL, NULL) == CYXCHAT_ERR_NULL,
+                    "NULL output should fail");
+        TEST_ASSERT(cyxchat_runtime_next_event(NULL, &ev) == 0, "NULL runtime has no events");
+        TEST_ASSERT(cyxchat_runtime_start_thread(NULL) == CYXCHAT_ERR_NULL,
+                    "NULL runtime cannot start");
+    }
+
+    cyxchat_runtime_destroy(rt);
+
+#ifdef CYXWIZ_HAS_CRYPTO
+    /* Test undeliverable chat is stored in and drained from a mailbox */
+    errors += test_runtime_mailbox();
+
+    /* Test a blocked transport wait is woken by submits */
+    errors += test_runtime_wake();
+#endif
+
+    return errors;
+}
@@ -0,0 +1,163 @@
+/**
+ * CyxChat Test - Outbound Scheduler
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/sched.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+/* Records the first byte of each frame and its destination's first byte */
+typedef struct {
+    uint8_t tags[512];
+    uint8_t peers[512];
+    size_t count;
+    int fail;
+} sched_log_t;
+
+static cyxchat_error_t log_send(void *user_data, const cyxwiz_node_id_t *to,
+                                const uint8_t *data, size_t len) {
+    sched_log_t *log = (sched_log_t*)user_data;
+    (void)len;
+    if (log->count < sizeof(log->tags)) {
+        log->tags[log->count] = data[0];
+        log->peers[log->count] = to->bytes[0];
+        log->count++;
+    }
+    return log->fail ? CYXCHAT_ERR_NETWORK : CYXCHAT_OK;
+}
+
+static void make_peer(cyxwiz_node_id_t *id, uint8_t tag) {
+    memset(id, 0, sizeof(*id));
+    id->bytes[0] = tag;
+}
+
+int test_sched(void) {
+    int errors = 0;
+    cyxchat_sched_ctx_t *ctx = NULL;
+    cyxwiz_node_id_t a, b;
+    uint8_t frame[CYXCHAT_SCHED_FRAME_MAX];
+    sched_log_t log;
+
+    make_peer(&a, 0xA0);
+    make_peer(&b, 0xB0);
+    memset(frame, 0, sizeof(frame));
+
+    TEST_ASSERT(cyxchat_sched_create(&ctx) == CYXCHAT_OK, "Create scheduler");
+    if (!ctx) return errors;
+
+    /* Test strict priority regardless of queue order */
+    {
+        memset(&log, 0, sizeof(log));
+        frame[0] = 3; cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame, 100);
+        frame[0] = 2; cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BACKGROUND, frame, 10);
+        frame[0] = 1; cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_INTERACTIVE, frame, 40);
+        frame[0] = 0; cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_CONTROL, frame, 20);
+
+        TEST_ASSERT(cyxchat_sched_queued_bytes(ctx, &a, CYXCHAT_PRIO_BULK) == 100,
+                    "Bulk bytes queued");
+        TEST_ASSERT(cyxchat_sched_flush(ctx, log_send, &log, 0) == 4, "All flushed");
+        TEST_ASSERT(log.tags[0] == 0 && log.tags[1] == 1 && log.tags[2] == 2 && log.tags[3] == 3,
+                    "Control, interactive, background, bulk");
+        TEST_ASSERT(cyxchat_sched_queued_bytes(ctx, &a, CYXCHAT_PRIO_BULK) == 0, "Queue empty");
+    }
+
+    /* Test FIFO within a class and round robin across peers */
+    {
+        memset(&log, 0, sizeof(log));
+        for (uint8_t i = 0; i < 3; i++) {
+            frame[0] = i;
+            cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame, 50);
+            cyxchat_sched_enqueue(ctx, &b, CYXCHAT_PRIO_BULK, frame, 50);
+        }
+        cyxchat_sched_flush(ctx, log_send, &log, 0);
+        TEST_ASSERT(log.count == 6, "Both peers drained");
+        TEST_ASSERT(log.peers[0] != log.peers[1] && log.peers[2] != log.peers[3],
+                    "Peers alternate");
+        int in_order = 1;
+        uint8_t next_a = 0, next_b = 0;
+        for (size_t i = 0; i < log.count; i++) {
+            uint8_t *next = log.peers[i] == 0xA0 ? &next_a : &next_b;
+            if (log.tags[i] != (*next)++) in_order = 0;
+        }
+        TEST_ASSERT(in_order, "FIFO per peer");
+    }
+
+    /* Test the flush budget and a late interactive frame going first */
+    {
+        memset(&log, 0, sizeof(log));
+        frame[0] = 3;
+        for (int i = 0; i < 10; i++) {
+            cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame, 200);
+        }
+        TEST_ASSERT(cyxchat_sched_flush(ctx, log_send, &log, 500) == 3, "Budget stops flush");
+
+        frame[0] = 1;
+        cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_INTERACTIVE, frame, 30);
+        cyxchat_sched_flush(ctx, log_send, &log, 1);
+        TEST_ASSERT(log.tags[3] == 1, "Interactive overtakes queued bulk");
+
+        cyxchat_sched_drop_peer(ctx, &a);
+        TEST_ASSERT(cyxchat_sched_queued_bytes(ctx, &a, CYXCHAT_PRIO_BULK) == 0, "Peer dropped");
+    }
+
+    /* Test class caps and reserved slots */
+    {
+        frame[0] = 3;
+        int accepted = 0;
+        while (cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame, 200) == CYXCHAT_OK) {
+            accepted++;
+        }
+        TEST_ASSERT(accepted == CYXCHAT_SCHED_CAP_BULK / 200, "Bulk capped per peer");
+        TEST_ASSERT(cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_INTERACTIVE, frame, 200) == CYXCHAT_OK,
+                    "Other classes unaffected by bulk cap");
+
+        /* Fill the pool with bulk from many peers */
+        cyxwiz_node_id_t p;
+        int full = 0;
+        for (int i = 1; i < CYXCHAT_SCHED_MAX_PEERS && !full; i++) {
+            make_peer(&p, (uint8_t)i);
+            while (!full) {
+                cyxchat_error_t err = cyxchat_sched_enqueue(ctx, &p, CYXCHAT_PRIO_BULK, frame, 10);
+                if (err != CYXCHAT_OK) {
+                    full = cyxchat_sched_queued_bytes(ctx, &p, CYXCHAT_PRIO_BULK) <
+                           CYXCHAT_SCHED_CAP_BULK;
+                    break;
+                }
+            }
+        }
+        TEST_ASSERT(full, "Pool exhausted for bulk");
+        TEST_ASSERT(cyxchat_sched_enqueue(ctx, &b, CYXCHAT_PRIO_CONTROL, frame, 10) == CYXCHAT_OK,
+                    "Reserved slots still take control");
+
+        TEST_ASSERT(cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame, 0) == CYXCHAT_ERR_INVALID,
+                    "Empty frame rejected");
+        TEST_ASSERT(cyxchat_sched_enqueue(ctx, &a, CYXCHAT_PRIO_BULK, frame,
+                                          CYXCHAT_SCHED_FRAME_MAX + 1) == CYXCHAT_ERR_INVALID,
+                    "Oversized frame rejected");
+    }
+
+    /* Test failed sends are dropped and counted */
+    {
+        memset(&log, 0, sizeof(log));
+        log.fail = 1;
+        size_t n = cyxchat_sched_flush(ctx, log_send, &log, 0);
+
+        cyxchat_sched_stats_t stats;
+        cyxchat_sched_get_stats(ctx, &stats);
+        TEST_ASSERT(n > 0 && stats.failed[CYXCHAT_PRIO_BULK] > 0, "Failures counted");
+        TEST_ASSERT(stats.rejected[CYXCHAT_PRIO_BULK] >= 2, "Rejections counted");
+        TEST_ASSERT(cyxchat_sched_queued_bytes(ctx, &b, CYXCHAT_PRIO_CONTROL) == 0,
+                    "Failed frames not requeued");
+    }
+
+    cyxchat_sched_destroy(ctx);
+    return errors;
+}
@@ -0,0 +1,167 @@
+/**
+ * CyxChat Test - Timer Wheel
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <cyxchat/cyxchat.h>
+#include <cyxchat/timer.h>
+
+#define TEST_ASSERT(cond, msg) do { \
+    if (!(cond)) { \
+        printf("    ASSERT FAILED: %s\n", msg); \
+        errors++; \
+    } \
+} while(0)
+
+typedef struct {
+    int fired;
+    uint64_t fired_at;
+    cyxchat_timer_wheel_t *wheel;
+    uint64_t rearm_ms;              /* Re-schedule this far ahead (0 = no) */
+} timer_probe_t;
+
+static void on_probe(cyxchat_timer_t *timer, void *user_data, uint64_t now_ms) {
+    timer_probe_t *probe = (timer_probe_t*)user_data;
+    probe->fired++;
+    probe->fired_at = now_ms;
+    if (probe->rearm_ms) {
+        cyxchat_timer_schedule(probe->wheel, timer, now_ms + probe->rearm_ms,
+                               on_probe, probe);
+    }
+}
+
+int test_timer(void) {
+    int errors = 0;
+
+    cyxchat_timer_wheel_t *wheel = NULL;
+    cyxchat_error_t err = cyxchat_timer_wheel_create(&wheel, 1000);
+    TEST_ASSERT(err == CYXCHAT_OK, "Create should succeed");
+    TEST_ASSERT(wheel != NULL, "Wheel should not be NULL");
+    if (!wheel) return errors;
+
+    TEST_ASSERT(cyxchat_timer_next_deadline(wheel) == CYXCHAT_TIMER_NONE,
+                "Empty wheel has no deadline");
+
+    /* Test deadlines fire on time at every level */
+    {
+        static const uint64_t delays[] = { 1, 63, 64, 100, 4095, 4096, 300000, 90000000 };
+        const size_t n = sizeof(delays) / sizeof(delays[0]);
+        cyxchat_timer_t timers[8];
+        timer_probe_t probes[8];
+        memset(timers, 0, sizeof(timers));
+        memset(probes, 0, sizeof(probes));
+
+        uint64_t start = cyxchat_timer_now(wheel);
+        for (size_t i = 0; i < n; i++) {
+            cyxchat_timer_schedule(wheel, &timers[i], start + delays[i], on_probe, &probes[i]);
+        }
+        TEST_ASSERT(cyxchat_timer_count(wheel) == n, "All timers scheduled");
+        TEST_ASSERT(cyxchat_timer_next_deadline(wheel) == start + 1,
+                    "Next deadline should be the 1 ms timer");
+
+        /* Sleep exactly until each reported deadline */
+        int early = 0;
+        int steps = 0;
+        uint64_t deadline;
+        while ((deadline = cyxchat_timer_next_deadline(wheel)) != CYXCHAT_TIMER_NONE &&
+               steps < 10000) {
+            cyxchat_timer_advance(wheel, deadline);
+            for (size_t i = 0; i < n; i++) {
+                if (probes[i].fired && probes[i].fired_at < start + delays[i]) early++;
+            }
+            steps++;
+        }
+
+        int late = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (probes[i].fired != 1 || probes[i].fired_at != start + delays[i]) late++;
+        }
+        TEST_ASSERT(early == 0, "No timer should fire early");
+        TEST_ASSERT(late == 0, "Every timer should fire once at its deadline");
+        TEST_ASSERT(steps < 200, "Deadline stepping should skip empty slots");
+        TEST_ASSERT(cyxchat_timer_count(wheel) == 0, "Wheel should be empty");
+    }
+
+    /* Test cancel and reschedule */
+    {
+        cyxchat_timer_t a, b;
+        timer_probe_t pa, pb;
+        memset(&a, 0, sizeof(a));
+        memset(&b, 0, sizeof(b));
+        memset(&pa, 0, sizeof(pa));
+        memset(&pb, 0, sizeof(pb));
+
+        uint64_t now = cyxchat_timer_now(wheel);
+        cyxchat_timer_schedule(wheel, &a, now + 50, on_probe, &pa);
+        cyxchat_timer_schedule(wheel, &b, now + 50, on_probe, &pb);
+        TEST_ASSERT(cyxchat_timer_pending(&a), "Timer should be pending");
+
+        cyxchat_timer_cancel(wheel, &a);
+        TEST_ASSERT(!cyxchat_timer_pending(&a), "Cancelled timer not pending");
+        cyxchat_timer_cancel(wheel, &a);
+
+        cyxchat_timer_schedule(wheel, &b, now + 5000, on_probe, &pb);
+        TEST_ASSERT(cyxchat_timer_count(wheel) == 1, "Reschedule keeps one timer");
+
+        cyxchat_timer_advance(wheel, now + 4999);
+        TEST_ASSERT(pa.fired == 0, "Cancelled timer should not fire");
+        TEST_ASSERT(pb.fired == 0, "Rescheduled timer should not fire early");
+
+        cyxchat_timer_advance(wheel, now + 5000);
+        TEST_ASSERT(pb.fired == 1, "Rescheduled timer should fire");
+    }
+
+    /* Test self-rearming timer fires once per advance */
+    {
+        cyxchat_timer_t t;
+        timer_probe_t probe;
+        memset(&t, 0, sizeof(t));
+        memset(&probe, 0, sizeof(probe));
+        probe.wheel = wheel;
+        probe.rearm_ms = 10;
+
+        uint64_t now = cyxchat_timer_now(wheel);
+        cyxchat_timer_schedule(wheel, &t, now + 10, on_probe, &probe);
+
+        int fired = cyxchat_timer_advance(wheel, now + 1000);
+        TEST_ASSERT(fired == 1, "Large jump should fire the timer once");
+        TEST_ASSERT(cyxchat_timer_pending(&t), "Timer should be re-armed");
+
+        cyxchat_timer_cancel(wheel, &t);
+    }
+
+    /* Test moving timers between wheels */
+    {
+        cyxchat_timer_wheel_t *other = NULL;
+        cyxchat_timer_wheel_create(&other, 50000);
+
+        cyxchat_timer_t t;
+        timer_probe_t probe;
+        memset(&t, 0, sizeof(t));
+        memset(&probe, 0, sizeof(probe));
+
+        cyxchat_timer_schedule(wheel, &t, cyxchat_timer_now(wheel) + 300, on_probe, &probe);
+        cyxchat_timer_move(wheel, other, &t);
+        TEST_ASSERT(cyxchat_timer_count(wheel) == 0, "Source wheel should be empty");
+        TEST_ASSERT(cyxchat_timer_count(other) == 1, "Destination wheel holds timer");
+
+        cyxchat_timer_advance(other, 50299);
+        TEST_ASSERT(probe.fired == 0, "Moved timer keeps remaining delay");
+        cyxchat_timer_advance(other, 50300);
+        TEST_ASSERT(probe.fired == 1, "Moved timer should fire");
+
+        cyxchat_timer_wheel_destroy(other);
+    }
+
+    /* Test NULL handling */
+    {
+        TEST_ASSERT(cyxchat_timer_wheel_create(NULL, 0) == CYXCHAT_ERR_NULL, "NULL output should fail");
+        TEST_ASSERT(cyxchat_timer_advance(NULL, 0) == 0, "NULL advance is no-op");
+        TEST_ASSERT(cyxchat_timer_next_deadline(NULL) == CYXCHAT_TIMER_NONE, "NULL has no deadline");
+    }
+
+    cyxchat_timer_wheel_destroy(wheel);
+
+    return errors;
+}